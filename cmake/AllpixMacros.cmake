@@ -26,10 +26,25 @@ MACRO(_allpix_module_define_common name)
     # Prepend with the allpix module prefix to create the name of the module
     SET(${name} "AllpixModule${_allpix_module_dir}")
 
-    # Save the module library for prelinking in the executable (NOTE: see exec folder)
-    SET(_ALLPIX_MODULE_LIBRARIES
-        ${_ALLPIX_MODULE_LIBRARIES} ${${name}}
-        CACHE INTERNAL "Module libraries")
+    # Check if the module should be linked statically into the executable
+    SET(_allpix_module_static OFF)
+    IF(NOT ${ALLPIX_MODULE_EXTERNAL})
+        LIST(FIND STATIC_MODULES ${_allpix_module_dir} _allpix_module_static_index)
+        IF(${_allpix_module_static_index} GREATER -1)
+            SET(_allpix_module_static ON)
+        ENDIF()
+    ENDIF()
+
+    # Save the module library for prelinking or static linking in the executable (NOTE: see exec folder)
+    IF(_allpix_module_static)
+        SET(_ALLPIX_STATIC_MODULE_LIBRARIES
+            ${_ALLPIX_STATIC_MODULE_LIBRARIES} ${${name}}
+            CACHE INTERNAL "Static module libraries")
+    ELSE()
+        SET(_ALLPIX_MODULE_LIBRARIES
+            ${_ALLPIX_MODULE_LIBRARIES} ${${name}}
+            CACHE INTERNAL "Module libraries")
+    ENDIF()
 
     # Set default module class name
     SET(_allpix_module_class "${_allpix_module_dir}Module")
@@ -49,7 +64,16 @@ Create the header or provide the alternative class name as first argument")
     ENDIF()
 
     # Define the library
-    ADD_LIBRARY(${${name}} SHARED "")
+    IF(_allpix_module_static)
+        ADD_LIBRARY(${${name}} STATIC "")
+        SET_TARGET_PROPERTIES(${${name}} PROPERTIES POSITION_INDEPENDENT_CODE ON)
+
+        # Register the module in the static module registry under the name of its configuration section
+        TARGET_COMPILE_DEFINITIONS(${${name}} PRIVATE ALLPIX_MODULE_STATIC=1)
+        TARGET_COMPILE_DEFINITIONS(${${name}} PRIVATE ALLPIX_MODULE_SECTION="${_allpix_module_dir}")
+    ELSE()
+        ADD_LIBRARY(${${name}} SHARED "")
+    ENDIF()
 
     # Add the current directory as include directory
     TARGET_INCLUDE_DIRECTORIES(${${name}} PRIVATE ${CMAKE_CURRENT_SOURCE_DIR})
@@ -193,12 +217,22 @@ FUNCTION(add_allpix_test test name)
         LIST(APPEND before_script ${opt})
     ENDFOREACH()
 
+    # Parse possible commands to be run after, e.g. to compare the output with the one of another test
+    FILE(STRINGS ${test} OPTS REGEX "#AFTER_SCRIPT ")
+    FOREACH(opt ${OPTS})
+        STRING(REPLACE "#AFTER_SCRIPT " "" opt "${opt}")
+        IF(NOT after_script)
+            LIST(APPEND after_script "--")
+        ENDIF()
+        LIST(APPEND after_script ${opt})
+    ENDFOREACH()
+
     ADD_TEST(
         NAME "${name}"
         WORKING_DIRECTORY ${PROJECT_SOURCE_DIR}/etc/unittests
         COMMAND ${PROJECT_SOURCE_DIR}/etc/unittests/run_directory.sh "output/${name}"
                 "${CMAKE_INSTALL_PREFIX}/bin/allpix -c ${CMAKE_CURRENT_SOURCE_DIR}/${test} ${clioptions}"
-                ${before_script})
+                ${before_script} ${after_script})
 
     # Parse configuration file for pass/fail conditions:
     FILE(STRINGS ${test} PASS_LST_ REGEX "#PASS ")
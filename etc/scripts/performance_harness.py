@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+"""
+Throughput regression harness for the performance test configurations of Allpix Squared.
+
+Every configuration is run with profiling enabled, optionally for a list of worker counts to measure the scaling. The
+throughput in events and charge carriers per second of event loop, the peak resident memory of the process and the time
+spent in every module are reported and optionally compared against the results of an earlier run stored as baseline.
+"""
+
+import argparse
+import csv
+import json
+import os
+import subprocess
+import sys
+import time
+
+
+def run_test(allpix, config, workers, output_directory, verbose):
+    """Run a single configuration and return its measured performance"""
+    command = [allpix, "-c", config,
+               "-o", "output_directory=\"{}\"".format(output_directory),
+               "-o", "profiling=true",
+               "-o", "profiling_format=\"csv\"",
+               "-o", "profiling_file=\"profile\""]
+    if workers is not None:
+        command += ["-j", str(workers)]
+
+    start = time.monotonic()
+    with open(os.path.join(output_directory, "allpix.log"), "w") as log:
+        process = subprocess.Popen(command, stdout=log, stderr=subprocess.STDOUT)
+        _, status, usage = os.wait4(process.pid, 0)
+    wall_time = time.monotonic() - start
+    if status != 0:
+        raise RuntimeError("{} failed, see {}".format(" ".join(command), os.path.join(output_directory, "allpix.log")))
+
+    # Collect the quantities of all threads combined from the profile
+    events = 0
+    loop_time = 0.
+    carriers = 0
+    modules = {}
+    with open(os.path.join(output_directory, "profile.csv")) as profile:
+        for row in csv.DictReader(profile):
+            if row["thread"] != "all":
+                continue
+            if row["module"] == "event":
+                if row["quantity"] == "events":
+                    events = int(row["value"])
+                elif row["quantity"] == "loop_time":
+                    loop_time = float(row["value"])
+            elif row["quantity"] == "wall_time":
+                modules[row["module"]] = float(row["value"])
+            elif row["quantity"] == "counter:propagated_charges":
+                carriers += int(row["value"])
+
+    # The maximum resident set size is given in kilobytes on Linux and in bytes on macOS
+    peak_rss = usage.ru_maxrss / 1024. if sys.platform != "darwin" else usage.ru_maxrss / 1024. / 1024.
+    result = {
+        "events": events,
+        "wall_time": wall_time,
+        "loop_time": loop_time,
+        "events_per_second": events / loop_time if loop_time > 0 else 0.,
+        "carriers_per_second": carriers / loop_time if loop_time > 0 else 0.,
+        "peak_rss_mb": peak_rss,
+        "module_time": modules,
+    }
+    if verbose:
+        for module, module_time in sorted(modules.items(), key=lambda item: -item[1]):
+            print("    {:<50} {:10.3f} s".format(module, module_time))
+    return result
+
+
+def compare(name, result, baseline, tolerance):
+    """Compare a result against its baseline and return the list of regressions"""
+    regressions = []
+    for quantity in ["events_per_second", "carriers_per_second"]:
+        if baseline.get(quantity, 0) > 0 and result[quantity] < baseline[quantity] * (1 - tolerance):
+            regressions.append("{}: {} dropped from {:.4g} to {:.4g}".format(
+                name, quantity, baseline[quantity], result[quantity]))
+    if baseline.get("peak_rss_mb", 0) > 0 and result["peak_rss_mb"] > baseline["peak_rss_mb"] * (1 + tolerance):
+        regressions.append("{}: peak_rss_mb increased from {:.4g} to {:.4g}".format(
+            name, baseline["peak_rss_mb"], result["peak_rss_mb"]))
+    return regressions
+
+
+def main():
+    source_directory = os.path.abspath(os.path.join(os.path.dirname(__file__), "..", ".."))
+    parser = argparse.ArgumentParser(description="Measure the throughput of the Allpix Squared performance tests")
+    parser.add_argument("tests", nargs="*",
+                        help="configuration files to run, defaults to all files of the performance tests")
+    parser.add_argument("--allpix", default=os.path.join(source_directory, "bin", "allpix"),
+                        help="path of the allpix executable (default: %(default)s)")
+    parser.add_argument("--workers", type=int, nargs="+",
+                        help="run every test with each of the given numbers of worker threads to measure the scaling")
+    parser.add_argument("--output-directory", default="performance_harness",
+                        help="directory for the outputs of the runs (default: %(default)s)")
+    parser.add_argument("--results", help="file to store the results in as JSON, which can be used as a baseline")
+    parser.add_argument("--baseline", help="JSON file with the results of an earlier run to compare against")
+    parser.add_argument("--tolerance", type=float, default=0.1,
+                        help="relative loss of throughput or increase of memory accepted (default: %(default)s)")
+    parser.add_argument("-v", "--verbose", action="store_true", help="print the time spent in every module")
+    args = parser.parse_args()
+
+    tests = args.tests
+    if not tests:
+        test_directory = os.path.join(source_directory, "etc", "unittests", "test_performance")
+        tests = sorted(os.path.join(test_directory, name) for name in os.listdir(test_directory)
+                       if name.startswith("test_") and name.endswith(".conf"))
+
+    baseline = {}
+    if args.baseline:
+        with open(args.baseline) as baseline_file:
+            baseline = json.load(baseline_file)
+
+    results = {}
+    regressions = []
+    for test in tests:
+        test_name = os.path.splitext(os.path.basename(test))[0]
+        for workers in (args.workers or [None]):
+            name = test_name if workers is None else "{}:j{}".format(test_name, workers)
+            output_directory = os.path.abspath(os.path.join(args.output_directory, name.replace(":", "_")))
+            os.makedirs(output_directory, exist_ok=True)
+
+            print("Running {}".format(name), flush=True)
+            result = run_test(args.allpix, os.path.abspath(test), workers, output_directory, args.verbose)
+            results[name] = result
+            print("  {:.4g} events/s, {:.4g} carriers/s, peak RSS {:.1f} MB, {:.1f} s in total".format(
+                result["events_per_second"], result["carriers_per_second"], result["peak_rss_mb"], result["wall_time"]))
+            if name in baseline:
+                regressions += compare(name, result, baseline[name], args.tolerance)
+
+        # Report the speedup relative to the smallest number of workers
+        if args.workers and len(args.workers) > 1:
+            reference = results["{}:j{}".format(test_name, args.workers[0])]["events_per_second"]
+            print("  Scaling relative to {} workers:".format(args.workers[0]))
+            for workers in args.workers:
+                throughput = results["{}:j{}".format(test_name, workers)]["events_per_second"]
+                speedup = throughput / reference if reference > 0 else 0.
+                print("    {:3d} workers: {:6.2f}x speedup, {:5.1f}% efficiency".format(
+                    workers, speedup, 100. * speedup * args.workers[0] / workers))
+
+    if args.results:
+        with open(args.results, "w") as results_file:
+            json.dump(results, results_file, indent=2, sort_keys=True)
+
+    if regressions:
+        print("Performance regressions with respect to the baseline:")
+        for regression in regressions:
+            print("  " + regression)
+        return 1
+    if baseline:
+        print("No performance regressions with respect to the baseline")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+"""
+Tuning of the precision parameters of the propagation modules of Allpix Squared against an accuracy target.
+
+A small sample of events is simulated at the reference precision given on the command line. Every precision parameter is
+then coarsened step by step, one parameter after the other, while keeping the already accepted values of the others. A
+setting is accepted as long as the mean cluster size and the mean fraction of the signal in the seed pixel agree with the
+reference within the tolerance. The cheapest accepted setting is printed as module options and can be applied to a copy of
+the configuration file.
+
+The simulation is run in the same process through the pyallpix bindings. The configuration has to contain an EventCallback
+section after the digitization, through which the pixel hits of every event are received.
+"""
+
+import argparse
+import math
+import re
+import sys
+import time
+
+import pyallpix
+
+
+class Observables:
+    """Cluster size and seed signal fraction collected from the pixel hits of every event and detector"""
+
+    def __init__(self):
+        self.cluster_sizes = []
+        self.seed_fractions = []
+
+    def __call__(self, event, detector, object_type, records):
+        if object_type != "PixelHit" or len(records) == 0:
+            return
+        signals = records["signal"]
+        total = signals.sum()
+        self.cluster_sizes.append(float(len(records)))
+        if total > 0:
+            self.seed_fractions.append(float(signals.max() / total))
+
+    def summary(self):
+        return {"cluster_size": mean_and_error(self.cluster_sizes),
+                "seed_fraction": mean_and_error(self.seed_fractions)}
+
+
+def mean_and_error(values):
+    """Mean of the values and its standard error"""
+    if len(values) < 2:
+        raise RuntimeError("not enough pixel hits recorded, check the EventCallback section of the configuration")
+    mean = sum(values) / len(values)
+    variance = sum((value - mean) ** 2 for value in values) / (len(values) - 1)
+    return mean, math.sqrt(variance / len(values))
+
+
+def split_value(value):
+    """Split a parameter value such as 0.5ps into its number and unit"""
+    match = re.fullmatch(r"\s*([-+0-9.eE]+)\s*([A-Za-z]*)\s*", value)
+    if match is None:
+        raise ValueError("cannot scale parameter value '{}'".format(value))
+    return float(match.group(1)), match.group(2)
+
+
+def format_value(number, unit):
+    return "{:g}{}".format(number, unit)
+
+
+def simulate(config, options, parameters, callback):
+    """Simulate the events of the configuration with the given parameters and return the observables and the run time"""
+    observables = Observables()
+    pyallpix.register_callback(callback, observables)
+    apx = pyallpix.Allpix(config, options + ["EventCallback.callback=" + callback] +
+                          ["{}={}".format(key, value) for key, value in parameters.items()])
+    apx.load()
+    apx.initialize()
+    start = time.monotonic()
+    apx.run()
+    run_time = time.monotonic() - start
+    apx.finalize()
+    pyallpix.remove_callback(callback)
+    return observables.summary(), run_time
+
+
+def compatible(reference, candidate, tolerance, significance):
+    """Check if all observables of the candidate agree with the reference within the tolerance and return the deviations"""
+    accepted = True
+    deviations = []
+    for name, (ref_mean, ref_error) in reference.items():
+        mean, error = candidate[name]
+        difference = abs(mean - ref_mean)
+        sigma = math.sqrt(ref_error ** 2 + error ** 2)
+        # The deviation beyond the tolerance needs to be statistically significant to reject the setting
+        if difference - tolerance * abs(ref_mean) > significance * sigma:
+            accepted = False
+        deviations.append("{} {:.4g} ({:+.2%})".format(name, mean, (mean - ref_mean) / ref_mean if ref_mean != 0 else 0.))
+    return accepted, ", ".join(deviations)
+
+
+def apply_parameters(config, output, parameters):
+    """Write a copy of the configuration with the parameters set in their module sections"""
+    pending = {}
+    for key, value in parameters.items():
+        section, name = key.split(".", 1)
+        pending.setdefault(section, {})[name] = value
+
+    lines = []
+    section = None
+
+    def flush():
+        # Append the parameters not yet present to the end of the section
+        for name, value in pending.pop(section, {}).items():
+            lines.append("{} = {}\n".format(name, value))
+
+    with open(config) as config_file:
+        for line in config_file:
+            header = re.match(r"\s*\[([^\]]+)\]", line)
+            if header is not None:
+                flush()
+                section = header.group(1).strip()
+            else:
+                key = re.match(r"\s*([A-Za-z0-9_]+)\s*=", line)
+                if key is not None and key.group(1) in pending.get(section, {}):
+                    line = "{} = {}\n".format(key.group(1), pending[section].pop(key.group(1)))
+            lines.append(line)
+    flush()
+    if pending:
+        raise RuntimeError("sections {} not found in {}".format(", ".join(sorted(pending)), config))
+
+    with open(output, "w") as output_file:
+        output_file.writelines(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Find the cheapest propagation precision meeting an accuracy target")
+    parser.add_argument("config", help="configuration file containing an EventCallback section")
+    parser.add_argument("parameters", nargs="+",
+                        help="reference precision as module options to coarsen, e.g. GenericPropagation.timestep_max=0.1ns")
+    parser.add_argument("-o", "--option", action="append", default=[], dest="options",
+                        help="additional module option for all runs, e.g. number_of_events=500")
+    parser.add_argument("--factors", type=float, nargs="+", default=[2., 4., 8., 16.],
+                        help="factors by which every parameter is coarsened in turn (default: %(default)s)")
+    parser.add_argument("--tolerance", type=float, default=0.02,
+                        help="accepted relative deviation of the observables from the reference (default: %(default)s)")
+    parser.add_argument("--significance", type=float, default=2.,
+                        help="standard deviations beyond the tolerance required to reject a setting (default: %(default)s)")
+    parser.add_argument("--apply", metavar="OUTPUT", help="write a copy of the configuration with the tuned parameters")
+    args = parser.parse_args()
+
+    reference_parameters = dict(parameter.split("=", 1) for parameter in args.parameters)
+    values = {key: split_value(value) for key, value in reference_parameters.items()}
+
+    print("Simulating the reference precision", flush=True)
+    reference, reference_time = simulate(args.config, args.options, reference_parameters, "tune_precision_reference")
+    print("  {:.1f} s, cluster size {:.4g} +- {:.2g}, seed fraction {:.4g} +- {:.2g}".format(
+        reference_time, reference["cluster_size"][0], reference["cluster_size"][1], reference["seed_fraction"][0],
+        reference["seed_fraction"][1]))
+
+    # Coarsen one parameter after the other, keeping the factors accepted for the previous ones
+    accepted = dict(reference_parameters)
+    accepted_time = reference_time
+    for key, (number, unit) in values.items():
+        for factor in args.factors:
+            candidate = dict(accepted)
+            candidate[key] = format_value(number * factor, unit)
+            print("Simulating {}={}".format(key, candidate[key]), flush=True)
+            observables, run_time = simulate(args.config, args.options, candidate, "tune_precision")
+            ok, deviations = compatible(reference, observables, args.tolerance, args.significance)
+            print("  {:.1f} s, {}: {}".format(run_time, deviations, "accepted" if ok else "rejected"))
+            if not ok:
+                break
+            # Only keep coarser settings which actually save time
+            if run_time < accepted_time:
+                accepted = candidate
+                accepted_time = run_time
+
+    print("Cheapest setting meeting the tolerance, {:.2f}x faster than the reference:".format(
+        reference_time / accepted_time if accepted_time > 0 else 1.))
+    for key, value in accepted.items():
+        print("  -o {}={}".format(key, value))
+
+    if args.apply:
+        apply_parameters(args.config, args.apply, accepted)
+        print("Written tuned configuration to {}".format(args.apply))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -14,10 +14,23 @@ mkdir -p $1
 cd $1
 pwd
 
-# Run all additional arguments as script commands before the test
-if [ "$#" -gt 2 ]; then
+# Split the additional arguments into script commands run before and after the test, separated by "--"
+before_script=()
+after_script=()
+for cmd in "${@:3}"; do
+    if [ "${cmd}" == "--" ]; then
+        after=1
+    elif [ -n "${after}" ]; then
+        after_script+=("${cmd}")
+    else
+        before_script+=("${cmd}")
+    fi
+done
+
+# Run the script commands before the test
+if [ "${#before_script[@]}" -gt 0 ]; then
     echo "Running BEFORE_SCRIPT"
-    for cmd in "${@:3}"; do
+    for cmd in "${before_script[@]}"; do
         echo "${cmd}"
         ${cmd}
     done
@@ -26,4 +39,16 @@ fi
 # Run the second argument in the directory created from the first argument
 echo "Running TEST"
 echo "$2"
-exec $2
+if [ "${#after_script[@]}" -eq 0 ]; then
+    exec $2
+fi
+
+# Run the script commands after the test, keeping the exit code of the test
+$2
+status=$?
+echo "Running AFTER_SCRIPT"
+for cmd in "${after_script[@]}"; do
+    echo "${cmd}"
+    ${cmd}
+done
+exit ${status}
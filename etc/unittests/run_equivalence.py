@@ -0,0 +1,223 @@
+#!/usr/bin/env python3
+"""
+Statistical equivalence test of a fast or approximate simulation mode against the reference simulation.
+
+The configuration is simulated twice with the same random seed, once as given and once with the module options of the
+fast mode applied. For every event and detector with pixel hits the cluster size, the collected charge, the digitized
+signal (the ADC or ToT value if the digitizer is configured accordingly) and, if the pixel pitch is known, the residuals of
+the signal-weighted cluster position to the centre of the deposited charge are computed. All pixel hits of a detector in
+one event are treated as a single cluster, the test configurations should therefore simulate a single particle per event.
+
+The distributions of both runs are compared with the two-sample Kolmogorov-Smirnov test and a two-sample chi-square test
+of their histograms. An observable fails if either test rejects the equivalence at the given significance level and the
+Kolmogorov-Smirnov distance, i.e. the largest difference of the cumulative distributions, exceeds the tolerance. Requiring
+both avoids failing on negligible but statistically significant differences of large samples.
+
+The options can be given on the command line or as tags in the configuration file, as done for the unit tests:
+    #FAST_OPTION <module option applied to the fast run only>
+    #OPTION <module option applied to both runs>
+    #PITCH <pixel pitch in x and y, e.g. 55um 55um>
+    #TOLERANCE <largest accepted Kolmogorov-Smirnov distance>
+    #SIGNIFICANCE <significance level of the tests>
+
+The simulation is run in the same process through the pyallpix bindings. The configuration has to contain an EventCallback
+section after the digitization, through which the pixel hits, pixel charges and deposited charges of every event are
+received.
+"""
+
+import argparse
+import math
+import re
+import sys
+
+import numpy
+import pyallpix
+
+UNITS = {"nm": 1e-6, "um": 1e-3, "mm": 1., "cm": 10., "m": 1000.}
+
+
+class Observables:
+    """Observables of every event and detector, computed from the objects received by the event callback"""
+
+    def __init__(self):
+        self.clusters = {}
+
+    def __call__(self, event, detector, object_type, records):
+        if len(records) == 0:
+            return
+        entry = self.clusters.setdefault((event, detector), {})
+        if object_type == "PixelHit":
+            signals = records["signal"]
+            entry["cluster_size"] = float(len(records))
+            entry["signal"] = float(signals.sum())
+            weights = signals if signals.sum() > 0 else numpy.ones(len(records))
+            entry["column"] = float(numpy.average(records["column"], weights=weights))
+            entry["row"] = float(numpy.average(records["row"], weights=weights))
+        elif object_type == "PixelCharge":
+            entry["charge"] = float(records["charge"].sum())
+        elif object_type == "DepositedCharge":
+            electrons = records[records["type"] < 0]
+            if len(electrons) > 0 and electrons["charge"].sum() > 0:
+                entry["deposit_x"] = float(numpy.average(electrons["local_x"], weights=electrons["charge"]))
+                entry["deposit_y"] = float(numpy.average(electrons["local_y"], weights=electrons["charge"]))
+
+    def distributions(self, pitch):
+        """Distributions of the observables over all events and detectors with pixel hits"""
+        result = {"cluster_size": [], "charge": [], "signal": []}
+        if pitch is not None:
+            result["residual_x"] = []
+            result["residual_y"] = []
+        for entry in self.clusters.values():
+            if "cluster_size" not in entry:
+                continue
+            result["cluster_size"].append(entry["cluster_size"])
+            result["signal"].append(entry["signal"])
+            if "charge" in entry:
+                result["charge"].append(entry["charge"])
+            # Pixel centres are located at multiples of the pitch in local coordinates
+            if pitch is not None and "deposit_x" in entry:
+                result["residual_x"].append(entry["column"] * pitch[0] - entry["deposit_x"])
+                result["residual_y"].append(entry["row"] * pitch[1] - entry["deposit_y"])
+        return {name: numpy.sort(numpy.array(values)) for name, values in result.items()}
+
+
+def kolmogorov_smirnov(reference, candidate):
+    """Two-sample Kolmogorov-Smirnov distance and its asymptotic p-value"""
+    values = numpy.concatenate([reference, candidate])
+    cdf_reference = numpy.searchsorted(reference, values, side="right") / len(reference)
+    cdf_candidate = numpy.searchsorted(candidate, values, side="right") / len(candidate)
+    distance = float(numpy.max(numpy.abs(cdf_reference - cdf_candidate)))
+
+    effective = math.sqrt(len(reference) * len(candidate) / (len(reference) + len(candidate)))
+    scale = (effective + 0.12 + 0.11 / effective) * distance
+    if scale < 0.2:
+        return distance, 1.
+    p_value = 2. * sum((-1) ** (j - 1) * math.exp(-2. * j * j * scale * scale) for j in range(1, 101))
+    return distance, min(max(p_value, 0.), 1.)
+
+
+def chi_square(reference, candidate, bins):
+    """Two-sample chi-square test of the histograms of both samples, with their normalization as free parameter"""
+    # Discrete observables are histogrammed per value, continuous ones in quantiles of the reference sample
+    # The outer bins are extended to contain the values of the candidate outside of the range of the reference
+    lowest, highest = min(reference[0], candidate[0]), max(reference[-1], candidate[-1])
+    unique = numpy.unique(reference)
+    if len(unique) <= bins:
+        edges = numpy.append(unique, highest + 1.)
+    else:
+        edges = numpy.unique(numpy.quantile(reference, numpy.linspace(0., 1., bins + 1)))
+        edges[-1] = highest
+    edges[0] = lowest
+    if len(edges) < 3:
+        return 0., 1.
+    counts_reference = numpy.histogram(reference, edges)[0].astype(float)
+    counts_candidate = numpy.histogram(candidate, edges)[0].astype(float)
+
+    filled = (counts_reference + counts_candidate) > 0
+    counts_reference, counts_candidate = counts_reference[filled], counts_candidate[filled]
+    ratio = math.sqrt(len(candidate) / len(reference))
+    chi2 = float(numpy.sum((ratio * counts_reference - counts_candidate / ratio) ** 2 /
+                           (counts_reference + counts_candidate)))
+    ndf = len(counts_reference) - 1
+    if ndf < 1:
+        return chi2, 1.
+
+    # Upper tail of the chi-square distribution from the Wilson-Hilferty transformation to a normal distribution
+    variance = 2. / (9. * ndf)
+    normal = ((chi2 / ndf) ** (1. / 3.) - (1. - variance)) / math.sqrt(variance)
+    return chi2 / ndf, 0.5 * math.erfc(normal / math.sqrt(2.))
+
+
+def simulate(config, options, callback):
+    """Simulate the events of the configuration with the given options and return the observables"""
+    observables = Observables()
+    pyallpix.register_callback(callback, observables)
+    apx = pyallpix.Allpix(config, options + ["EventCallback.callback=" + callback])
+    apx.load()
+    apx.initialize()
+    apx.run()
+    apx.finalize()
+    pyallpix.remove_callback(callback)
+    return observables
+
+
+def parse_length(value):
+    match = re.fullmatch(r"\s*([-+0-9.eE]+)\s*([a-z]*)\s*", value)
+    if match is None or match.group(2) not in UNITS:
+        raise ValueError("cannot interpret length '{}'".format(value))
+    return float(match.group(1)) * UNITS[match.group(2)]
+
+
+def read_tags(config):
+    """Read the tags of the unit test configuration files from the configuration"""
+    tags = {}
+    with open(config) as config_file:
+        for line in config_file:
+            match = re.match(r"#([A-Z_]+) (.*)", line)
+            if match is not None:
+                tags.setdefault(match.group(1), []).append(match.group(2).strip())
+    return tags
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare the distributions of a fast simulation mode to the reference")
+    parser.add_argument("config", help="configuration file of the reference simulation")
+    parser.add_argument("-f", "--fast", action="append", default=[], metavar="OPTION",
+                        help="module option enabling the fast mode, e.g. GenericPropagation.mobility_table=true")
+    parser.add_argument("-o", "--option", action="append", default=[], dest="options",
+                        help="additional module option for both runs, e.g. number_of_events=500")
+    parser.add_argument("--pitch", nargs=2, metavar=("X", "Y"),
+                        help="pixel pitch of the detectors to compute residuals, e.g. 55um 55um")
+    parser.add_argument("--tolerance", type=float,
+                        help="largest accepted Kolmogorov-Smirnov distance of the distributions (default: 0.05)")
+    parser.add_argument("--significance", type=float,
+                        help="significance level of the Kolmogorov-Smirnov and chi-square tests (default: 0.01)")
+    parser.add_argument("--bins", type=int, default=20,
+                        help="maximum number of bins of the chi-square test (default: %(default)s)")
+    args = parser.parse_args()
+
+    # Command line arguments take precedence over the tags of the configuration file
+    tags = read_tags(args.config)
+    fast = tags.get("FAST_OPTION", []) + args.fast
+    options = tags.get("OPTION", []) + args.options
+    pitch = args.pitch if args.pitch is not None else (tags["PITCH"][-1].split() if "PITCH" in tags else None)
+    pitch = [parse_length(value) for value in pitch] if pitch is not None else None
+    tolerance = args.tolerance if args.tolerance is not None else float(tags.get("TOLERANCE", [0.05])[-1])
+    significance = args.significance if args.significance is not None else float(tags.get("SIGNIFICANCE", [0.01])[-1])
+    if not fast:
+        parser.error("no option enabling the fast mode given")
+
+    with open(args.config) as config_file:
+        if not any(re.match(r"\s*\[EventCallback\]", line) for line in config_file):
+            raise RuntimeError("configuration {} has no EventCallback section".format(args.config))
+
+    print("Simulating the reference", flush=True)
+    reference = simulate(args.config, options, "equivalence_reference").distributions(pitch)
+    print("Simulating the fast mode with {}".format(", ".join(fast)), flush=True)
+    candidate = simulate(args.config, options + fast, "equivalence_fast").distributions(pitch)
+
+    failed = []
+    print("{:<14}{:>10}{:>12}{:>12}{:>10}{:>10}{:>12}{:>10}".format(
+        "observable", "entries", "ref. mean", "fast mean", "KS dist.", "KS p", "chi2/ndf", "chi2 p"))
+    for name, reference_values in reference.items():
+        candidate_values = candidate[name]
+        if len(reference_values) < 2 or len(candidate_values) < 2:
+            print("{:<14} not enough entries".format(name))
+            failed.append(name)
+            continue
+        distance, ks_p = kolmogorov_smirnov(reference_values, candidate_values)
+        chi2, chi2_p = chi_square(reference_values, candidate_values, args.bins)
+        print("{:<14}{:>10}{:>12.5g}{:>12.5g}{:>10.4f}{:>10.3g}{:>12.3f}{:>10.3g}".format(
+            name, len(reference_values), reference_values.mean(), candidate_values.mean(), distance, ks_p, chi2, chi2_p))
+        if min(ks_p, chi2_p) < significance and distance > tolerance:
+            failed.append(name)
+
+    if failed:
+        print("Fast mode not equivalent to the reference in {}".format(", ".join(failed)))
+        return 1
+    print("Fast mode equivalent to the reference within tolerance {:g}".format(tolerance))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -22,6 +22,7 @@
 #include <TStyle.h>
 #include <TSystem.h>
 
+#include "core/config/ConfigReader.hpp"
 #include "core/config/exceptions.h"
 #include "core/utils/log.h"
 #include "core/utils/unit.h"
@@ -114,6 +115,26 @@ void Allpix::load() {
     LOG(STATUS) << "Welcome to Allpix^2 " << ALLPIX_PROJECT_VERSION;
     global_config.set<std::string>("version", ALLPIX_PROJECT_VERSION, true);
 
+    // Continue with the seeds of the run which wrote the checkpoint, such that the resumed events are identical
+    if(global_config.has("resume_checkpoint")) {
+        auto checkpoint_file_name = global_config.getPath("resume_checkpoint", true);
+        std::ifstream checkpoint_file(checkpoint_file_name);
+        auto checkpoint = ConfigReader(checkpoint_file, checkpoint_file_name).getHeaderConfiguration();
+        for(const auto& key : {"random_seed", "random_seed_core"}) {
+            auto checkpoint_seed = checkpoint.get<uint64_t>(key);
+            if(global_config.has(key) && global_config.get<uint64_t>(key) != checkpoint_seed) {
+                throw InvalidValueError(
+                    global_config, key, "seed differs from the seed of the run stored in the checkpoint");
+            }
+            global_config.set<uint64_t>(key, checkpoint_seed);
+        }
+    }
+
+    // All partitions of a run have to start from the same seed to derive the event seeds of a single run
+    if(global_config.get<uint64_t>("partitions", 1) > 1 && !global_config.has("random_seed")) {
+        throw InvalidValueError(global_config, "partitions", "processing partitions of a run requires a fixed random_seed");
+    }
+
     uint64_t seed = 0;
     if(global_config.has("random_seed")) {
         // Use provided random seed
@@ -211,12 +232,18 @@ void Allpix::initialize() {
     }
 }
 /**
- * Runs every modules Module::run() method linearly for the number of events
+ * Runs every modules Module::run() method linearly for the number of events. For parameter scans the events are run for
+ * every scan point, each point starting from the same seed such that all points simulate the same events.
  */
 void Allpix::run() {
     if(!terminate_) {
         LOG(TRACE) << "Running Allpix";
         mod_mgr_->run(seeder_modules_);
+        for(size_t point = 1; point < mod_mgr_->getScanPoints() && !terminate_; ++point) {
+            seeder_modules_.seed(conf_mgr_->getGlobalConfiguration().get<uint64_t>("random_seed"));
+            mod_mgr_->startScanPoint(point);
+            mod_mgr_->run(seeder_modules_);
+        }
 
         // Set that we have run and want to finalize as well
         has_run_ = true;
@@ -227,6 +254,20 @@ void Allpix::run() {
 /**
  * Runs all modules Module::finalize() method linearly for every module
  */
+uint64_t Allpix::runEvents(uint64_t number_of_events) {
+    if(terminate_) {
+        LOG(INFO) << "Skip running events because termination is requested";
+        return 0;
+    }
+
+    LOG(TRACE) << "Running " << number_of_events << " events on demand";
+    auto finished_events = mod_mgr_->runEvents(seeder_modules_, number_of_events);
+
+    // Set that we have run and want to finalize as well
+    has_run_ = true;
+    return finished_events;
+}
+
 void Allpix::finalize() {
     if(has_run_) {
         LOG(TRACE) << "Finalizing Allpix";
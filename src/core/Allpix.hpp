@@ -62,6 +62,18 @@ namespace allpix {
          */
         void run();
 
+        /**
+         * @brief Run all modules for the next events on demand, keeping the worker threads and modules for further calls
+         * @param number_of_events Number of events to process
+         * @return Number of events processed, smaller than requested if termination has been requested
+         * @warning Should be called after the \ref Allpix::initialize "init function" instead of the \ref Allpix::run
+         * "run function", and followed by the \ref Allpix::finalize "finalize function" once all events are processed
+         *
+         * Every call returns after all of its events have been processed completely. The data of the events can be passed
+         * to the application with the EventCallback module.
+         */
+        uint64_t runEvents(uint64_t number_of_events);
+
         /**
          * @brief Finalize all modules (post-run)
          * @warning Should be called after the \ref Allpix::run "run function"
@@ -11,7 +11,9 @@
 
 #include <cassert>
 #include <filesystem>
+#include <mutex>
 #include <ostream>
+#include <set>
 #include <stdexcept>
 #include <string>
 
@@ -20,6 +22,11 @@
 
 using namespace allpix;
 
+namespace {
+    // Flag if parsing values on the current thread should issue a warning
+    thread_local bool warn_access = false;
+} // namespace
+
 Configuration::AccessMarker::AccessMarker(const Configuration::AccessMarker& rhs) {
     for(const auto& [key, value] : rhs.markers_) {
         registerMarker(key);
@@ -70,7 +77,7 @@ std::string Configuration::getText(const std::string& key) const {
     try {
         // NOTE: returning literally including ""
         used_keys_.markUsed(key);
-        return config_.at(key);
+        return *config_.at(key);
     } catch(std::out_of_range& e) {
         throw MissingKeyError(key, getName());
     }
@@ -152,8 +159,12 @@ std::string Configuration::path_to_absolute(std::string path, bool canonicalize_
     return path;
 }
 
+/**
+ * A new value is always stored separately, such that copies of this configuration sharing the previous value are unchanged.
+ */
 void Configuration::setText(const std::string& key, const std::string& val) {
-    config_[key] = val;
+    config_[key] = std::make_shared<const std::string>(val);
+    invalidate_parse_tree(key);
     used_keys_.registerMarker(key);
 }
 
@@ -166,6 +177,7 @@ void Configuration::setAlias(const std::string& new_key, const std::string& old_
     }
     try {
         config_[new_key] = config_.at(old_key);
+        invalidate_parse_tree(new_key);
         used_keys_.registerMarker(new_key);
         used_keys_.markUsed(old_key);
     } catch(std::out_of_range& e) {
@@ -182,13 +194,16 @@ unsigned int Configuration::countSettings() const {
 }
 
 /**
- * All keys that are already defined earlier in this configuration are not changed.
+ * All keys that are already defined earlier in this configuration are not changed. The merged values are shared with the
+ * other configuration.
  */
 void Configuration::merge(const Configuration& other) {
     for(const auto& [key, value] : other.config_) {
         // Only merge values that do not yet exist
         if(!has(key)) {
-            setText(key, value);
+            config_[key] = value;
+            invalidate_parse_tree(key);
+            used_keys_.registerMarker(key);
         }
     }
 }
@@ -203,6 +218,21 @@ std::vector<std::pair<std::string, std::string>> Configuration::getAll() const {
             continue;
         }
 
+        result.emplace_back(key_value.first, *key_value.second);
+    }
+
+    return result;
+}
+
+std::vector<std::pair<std::string, std::shared_ptr<const std::string>>> Configuration::getAllShared() const {
+    std::vector<std::pair<std::string, std::shared_ptr<const std::string>>> result;
+
+    // Loop over all configuration keys, skipping internal keys starting with an underscore
+    for(const auto& key_value : config_) {
+        if(!key_value.first.empty() && key_value.first.front() == '_') {
+            continue;
+        }
+
         result.emplace_back(key_value);
     }
 
@@ -223,6 +253,25 @@ std::vector<std::string> Configuration::getUnusedKeys() const {
     return result;
 }
 
+void Configuration::setAccessWarnings(bool warn) {
+    warn_access = warn;
+}
+
+void Configuration::check_access(const std::string& key) const {
+    if(!warn_access) {
+        return;
+    }
+
+    // Only report every key of every configuration section once for all threads
+    static std::mutex reported_mutex;
+    static std::set<std::pair<std::string, std::string>> reported;
+    std::lock_guard<std::mutex> lock{reported_mutex};
+    if(reported.emplace(getName(), key).second) {
+        LOG(WARNING) << "Parameter \"" << key << "\" of section \"" << getName()
+                     << "\" is parsed during the event loop, it should be bound before the event loop starts";
+    }
+}
+
 /**
  * String is recursively parsed for all pair of [ and ] brackets. All parts between single or double quotation marks are
  * skipped.
@@ -305,3 +354,37 @@ std::unique_ptr<Configuration::parse_node> Configuration::parse_value(std::strin
 
     return node;
 }
+
+/**
+ * Values are parsed outside of the lock, such that parsing different keys does not serialize. A value parsed concurrently
+ * by several threads is stored once, all trees are identical. Values are immutable once stored, a tree therefore belongs to
+ * the value it has been parsed from if the stored value is the same object.
+ */
+std::shared_ptr<const Configuration::parse_node> Configuration::get_parse_tree(const std::string& key) const {
+    const auto& value = config_.at(key);
+    if(!parse_cache_) {
+        return parse_value(*value);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{parse_cache_->mutex};
+        auto tree = parse_cache_->trees.find(key);
+        if(tree != parse_cache_->trees.end() && tree->second.first == value) {
+            return tree->second.second;
+        }
+    }
+
+    std::shared_ptr<const parse_node> node = parse_value(*value);
+    std::lock_guard<std::mutex> lock{parse_cache_->mutex};
+    parse_cache_->trees[key] = std::make_pair(value, node);
+    return node;
+}
+
+void Configuration::invalidate_parse_tree(const std::string& key) {
+    if(!parse_cache_) {
+        parse_cache_ = std::make_shared<ParseCache>();
+        return;
+    }
+    std::lock_guard<std::mutex> lock{parse_cache_->mutex};
+    parse_cache_->trees.erase(key);
+}
@@ -13,9 +13,11 @@
 #include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "core/config/exceptions.h"
@@ -25,6 +27,47 @@ namespace allpix {
 
     template <typename T> using Matrix = std::vector<std::vector<T>>;
 
+    /**
+     * @brief Configuration value bound to a key and parsed only once
+     *
+     * The value is parsed from the configuration when the parameter is bound by \ref Configuration::bind and is stored in
+     * the requested type afterwards. Accessing the value is therefore cheap and, since the parameter cannot be changed after
+     * binding, thread-safe. Parameters should be bound during construction or initialization of a module and used in the
+     * event loop instead of calling \ref Configuration::get repeatedly.
+     */
+    template <typename T> class ConfigParameter {
+        friend class Configuration;
+
+    public:
+        /**
+         * @brief Construct an unbound parameter holding a default constructed value
+         */
+        ConfigParameter() = default;
+
+        /**
+         * @brief Get the key the parameter is bound to
+         * @return Key of the parameter or an empty string if it is not bound
+         */
+        const std::string& key() const { return key_; }
+
+        /// @{
+        /**
+         * @brief Access the parsed value
+         * @return Reference to the value
+         */
+        const T& get() const { return value_; }
+        const T& operator*() const { return value_; }
+        const T* operator->() const { return &value_; }
+        operator const T&() const { return value_; } // NOLINT
+        /// @}
+
+    private:
+        ConfigParameter(std::string key, T value) : key_(std::move(key)), value_(std::move(value)) {}
+
+        std::string key_;
+        T value_{};
+    };
+
     /**
      * @brief Generic configuration object storing keys
      *
@@ -171,6 +214,26 @@ namespace allpix {
          */
         template <typename T> Matrix<T> getMatrix(const std::string& key, const Matrix<T> def) const;
 
+        /**
+         * @brief Bind a key to a parameter, parsing its value in the requested type once
+         * @param key Key to bind
+         * @return Parameter holding the value of the key
+         */
+        template <typename T> ConfigParameter<T> bind(const std::string& key) const;
+        /**
+         * @brief Bind a key to a parameter, using a default value if it does not exists
+         * @param key Key to bind
+         * @param def Default value to use if key is not defined
+         * @return Parameter holding the value of the key or the default value if the key does not exists
+         */
+        template <typename T> ConfigParameter<T> bind(const std::string& key, const T& def) const;
+        /**
+         * @brief Bind a key containing an array to a parameter, parsing its values in the requested type once
+         * @param key Key to bind
+         * @return Parameter holding the list of values of the key
+         */
+        template <typename T> ConfigParameter<std::vector<T>> bindArray(const std::string& key) const;
+
         /**
          * @brief Get literal value of a key as string
          * @param key Key to get values of
@@ -308,6 +371,12 @@ namespace allpix {
         // FIXME Better name for this function
         std::vector<std::pair<std::string, std::string>> getAll() const;
 
+        /**
+         * @brief Get all key value pairs without copying the values
+         * @return List of all keys together with the values shared with this configuration
+         */
+        std::vector<std::pair<std::string, std::shared_ptr<const std::string>>> getAllShared() const;
+
         /**
          * @brief Obtain all keys which have not been accessed yet
          *
@@ -316,7 +385,22 @@ namespace allpix {
          */
         std::vector<std::string> getUnusedKeys() const;
 
+        /**
+         * @brief Enable or disable warnings for values parsed from any configuration on the calling thread
+         * @param warn If parsing a value should issue a warning
+         *
+         * Used to detect values which are parsed repeatedly during the event loop and should be bound to a \ref
+         * ConfigParameter instead. Every key of a configuration is only reported once.
+         */
+        static void setAccessWarnings(bool warn);
+
     private:
+        /**
+         * @brief Issue a warning for parsing the given key if enabled for the calling thread
+         * @param key Key being parsed
+         */
+        void check_access(const std::string& key) const;
+
         /**
          * @brief Make relative paths absolute from this configuration file
          * @param path Path to make absolute (if it is not already absolute)
@@ -339,12 +423,39 @@ namespace allpix {
          */
         static std::unique_ptr<parse_node> parse_value(std::string str, int depth = 0);
 
+        /**
+         * @brief Get the parse tree of the value of a key, parsing the value only if it has not been parsed before
+         * @param key Key to get the parse tree of
+         * @return Root node of the parsed tree
+         * @throws std::out_of_range If the key is not defined
+         */
+        std::shared_ptr<const parse_node> get_parse_tree(const std::string& key) const;
+
+        /**
+         * @brief Remove the cached parse tree of a key after its value has been changed
+         * @param key Key to remove the parse tree of
+         */
+        void invalidate_parse_tree(const std::string& key);
+
+        /**
+         * @brief Cache of the parse trees of all values parsed so far
+         *
+         * Every tree is stored together with the value it has been parsed from. The cache is shared between copies of the
+         * configuration, a tree is therefore only used if the key still holds the same value object.
+         */
+        struct ParseCache {
+            std::mutex mutex;
+            std::map<std::string, std::pair<std::shared_ptr<const std::string>, std::shared_ptr<const parse_node>>> trees;
+        };
+
         std::string name_;
         std::string path_;
 
-        using ConfigMap = std::map<std::string, std::string>;
+        // Values are immutable and shared between copies of the configuration, setting a key replaces its value
+        using ConfigMap = std::map<std::string, std::shared_ptr<const std::string>>;
         ConfigMap config_;
         mutable AccessMarker used_keys_;
+        std::shared_ptr<ParseCache> parse_cache_{std::make_shared<ParseCache>()};
     };
 } // namespace allpix
 
@@ -14,8 +14,9 @@ namespace allpix {
      * @throws InvalidKeyError If an overflow happened while converting the key
      */
     template <typename T> T Configuration::get(const std::string& key) const {
+        check_access(key);
         try {
-            auto node = parse_value(config_.at(key));
+            auto node = get_parse_tree(key);
             used_keys_.markUsed(key);
             try {
                 return allpix::from_string<T>(node->value);
@@ -25,9 +26,9 @@ namespace allpix {
         } catch(std::out_of_range& e) {
             throw MissingKeyError(key, getName());
         } catch(std::invalid_argument& e) {
-            throw InvalidKeyError(key, getName(), config_.at(key), typeid(T), e.what());
+            throw InvalidKeyError(key, getName(), *config_.at(key), typeid(T), e.what());
         } catch(std::overflow_error& e) {
-            throw InvalidKeyError(key, getName(), config_.at(key), typeid(T), e.what());
+            throw InvalidKeyError(key, getName(), *config_.at(key), typeid(T), e.what());
         }
     }
     /**
@@ -47,12 +48,12 @@ namespace allpix {
      * @throws InvalidKeyError If an overflow happened while converting the key
      */
     template <typename T> std::vector<T> Configuration::getArray(const std::string& key) const {
+        check_access(key);
         try {
-            std::string str = config_.at(key);
+            auto node = get_parse_tree(key);
             used_keys_.markUsed(key);
 
             std::vector<T> array;
-            auto node = parse_value(str);
             for(auto& child : node->children) {
                 try {
                     array.push_back(allpix::from_string<T>(child->value));
@@ -64,9 +65,9 @@ namespace allpix {
         } catch(std::out_of_range& e) {
             throw MissingKeyError(key, getName());
         } catch(std::invalid_argument& e) {
-            throw InvalidKeyError(key, getName(), config_.at(key), typeid(T), e.what());
+            throw InvalidKeyError(key, getName(), *config_.at(key), typeid(T), e.what());
         } catch(std::overflow_error& e) {
-            throw InvalidKeyError(key, getName(), config_.at(key), typeid(T), e.what());
+            throw InvalidKeyError(key, getName(), *config_.at(key), typeid(T), e.what());
         }
     }
     /**
@@ -86,12 +87,12 @@ namespace allpix {
      * @throws InvalidKeyError If an overflow happened while converting the key
      */
     template <typename T> Matrix<T> Configuration::getMatrix(const std::string& key) const {
+        check_access(key);
         try {
-            std::string str = config_.at(key);
+            auto node = get_parse_tree(key);
             used_keys_.markUsed(key);
 
             Matrix<T> matrix;
-            auto node = parse_value(str);
             for(auto& child : node->children) {
                 if(child->children.empty()) {
                     throw std::invalid_argument("matrix has less than two dimensions, enclosing brackets might be missing");
@@ -112,9 +113,9 @@ namespace allpix {
         } catch(std::out_of_range& e) {
             throw MissingKeyError(key, getName());
         } catch(std::invalid_argument& e) {
-            throw InvalidKeyError(key, getName(), config_.at(key), typeid(T), e.what());
+            throw InvalidKeyError(key, getName(), *config_.at(key), typeid(T), e.what());
         } catch(std::overflow_error& e) {
-            throw InvalidKeyError(key, getName(), config_.at(key), typeid(T), e.what());
+            throw InvalidKeyError(key, getName(), *config_.at(key), typeid(T), e.what());
         }
     }
 
@@ -129,9 +130,29 @@ namespace allpix {
         return def;
     }
 
+    /**
+     * @throws MissingKeyError If the requested key is not defined
+     * @throws InvalidKeyError If the conversion to the requested type did not succeed
+     */
+    template <typename T> ConfigParameter<T> Configuration::bind(const std::string& key) const {
+        return ConfigParameter<T>(key, get<T>(key));
+    }
+    /**
+     * @throws InvalidKeyError If the conversion to the requested type did not succeed
+     */
+    template <typename T> ConfigParameter<T> Configuration::bind(const std::string& key, const T& def) const {
+        return ConfigParameter<T>(key, get<T>(key, def));
+    }
+    /**
+     * @throws MissingKeyError If the requested key is not defined
+     * @throws InvalidKeyError If the conversion to the requested type did not succeed
+     */
+    template <typename T> ConfigParameter<std::vector<T>> Configuration::bindArray(const std::string& key) const {
+        return ConfigParameter<std::vector<T>>(key, getArray<T>(key));
+    }
+
     template <typename T> void Configuration::set(const std::string& key, const T& val, bool mark_used) {
-        config_[key] = allpix::to_string(val);
-        used_keys_.registerMarker(key);
+        setText(key, allpix::to_string(val));
         if(mark_used) {
             used_keys_.markUsed(key);
         }
@@ -147,8 +168,7 @@ namespace allpix {
             ret_str += ",";
         }
         ret_str.pop_back();
-        config_[key] = ret_str;
-        used_keys_.registerMarker(key);
+        setText(key, ret_str);
     }
 
     template <typename T> void Configuration::setArray(const std::string& key, const std::vector<T>& val, bool mark_used) {
@@ -159,8 +179,7 @@ namespace allpix {
             str += ",";
         }
         str.pop_back();
-        config_[key] = str;
-        used_keys_.registerMarker(key);
+        setText(key, str);
         if(mark_used) {
             used_keys_.markUsed(key);
         }
@@ -184,8 +203,7 @@ namespace allpix {
         }
         str.pop_back();
         str += "]";
-        config_[key] = str;
-        used_keys_.registerMarker(key);
+        setText(key, str);
     }
 
     template <typename T> void Configuration::setDefault(const std::string& key, const T& val) {
@@ -8,6 +8,7 @@
  * Intergovernmental Organization or submit itself to any jurisdiction.
  */
 
+#include <algorithm>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -72,7 +73,10 @@ void Detector::build_transform() {
     ROOT::Math::Translation3D translation_local(static_cast<ROOT::Math::XYZVector>(model_->getCenter()));
     ROOT::Math::Transform3D transform_local(translation_local);
     // Compute total transform local to global by first transforming local to locally centered and then to global coordinates
-    transform_ = transform_center * transform_local.Inverse();
+    auto transform = transform_center * transform_local.Inverse();
+    // Store both directions as plain matrices, conversions are requested for every step of every particle
+    transform.GetComponents(global_matrix_.begin());
+    transform.Inverse().GetComponents(local_matrix_.begin());
 }
 
 std::string Detector::getName() const {
@@ -93,18 +97,6 @@ ROOT::Math::Rotation3D Detector::getOrientation() const {
     return orientation_;
 }
 
-/**
- * @warning The local coordinate position does normally not have its origin at the center of rotation
- *
- * The origin of the local frame is at the center of the first pixel in the middle of the sensor.
- */
-ROOT::Math::XYZPoint Detector::getLocalPosition(const ROOT::Math::XYZPoint& global_pos) const {
-    return transform_.Inverse()(global_pos);
-}
-ROOT::Math::XYZPoint Detector::getGlobalPosition(const ROOT::Math::XYZPoint& local_pos) const {
-    return transform_(local_pos);
-}
-
 /**
  * The pixel has internal information about the size and location specific for this detector
  */
@@ -141,6 +133,14 @@ ROOT::Math::XYZVector Detector::getElectricField(const ROOT::Math::XYZPoint& pos
     return electric_field_.get(pos);
 }
 
+void Detector::getElectricField(const ROOT::Math::XYZPoint* pos, ROOT::Math::XYZVector* fields, size_t count) const {
+    electric_field_.get(pos, fields, count);
+}
+
+ROOT::Math::XYZVector Detector::getElectricField(const ROOT::Math::XYZPoint& pos, FieldCursor& cursor) const {
+    return electric_field_.get(pos, cursor);
+}
+
 /**
  * The type of the electric field is set depending on the function used to apply it.
  */
@@ -151,12 +151,26 @@ FieldType Detector::getElectricFieldType() const {
 /**
  * @throws std::invalid_argument If the electric field dimensions are incorrect or the thickness domain is outside the sensor
  */
-void Detector::setElectricFieldGrid(const std::shared_ptr<std::vector<double>>& field,
+void Detector::setElectricFieldGrid(const std::shared_ptr<const double>& field,
+                                    size_t entries,
                                     std::array<size_t, 3> dimensions,
                                     std::array<double, 2> scales,
                                     std::array<double, 2> offset,
-                                    std::pair<double, double> thickness_domain) {
-    electric_field_.setGrid(field, dimensions, scales, offset, thickness_domain);
+                                    std::pair<double, double> thickness_domain,
+                                    FieldInterpolation interpolation,
+                                    FieldPrecision precision,
+                                    FieldSymmetry symmetry,
+                                    std::vector<double> z_edges) {
+    electric_field_.setGrid(field,
+                            entries,
+                            dimensions,
+                            scales,
+                            offset,
+                            thickness_domain,
+                            interpolation,
+                            precision,
+                            symmetry,
+                            std::move(z_edges));
 }
 
 void Detector::setElectricFieldFunction(FieldFunction<ROOT::Math::XYZVector> function,
@@ -165,6 +179,11 @@ void Detector::setElectricFieldFunction(FieldFunction<ROOT::Math::XYZVector> fun
     electric_field_.setFunction(std::move(function), thickness_domain, type);
 }
 
+DetectorField<ROOT::Math::XYZVector> Detector::deriveElectricFieldGrid(
+    const std::function<ROOT::Math::XYZVector(const ROOT::Math::XYZPoint&, const ROOT::Math::XYZVector&)>& function) const {
+    return electric_field_.deriveGrid(function);
+}
+
 bool Detector::hasWeightingPotential() const {
     return weighting_potential_.isValid();
 }
@@ -181,6 +200,33 @@ double Detector::getWeightingPotential(const ROOT::Math::XYZPoint& local_pos, co
     return weighting_potential_.getRelativeTo(local_pos, ref, true);
 }
 
+void Detector::getWeightingPotential(const ROOT::Math::XYZPoint* local_pos,
+                                     const Pixel::Index& reference,
+                                     double* potentials,
+                                     size_t count) const {
+    auto ref = static_cast<ROOT::Math::XYPoint>(model_->getPixelCenter(reference.x(), reference.y()));
+    weighting_potential_.getRelativeTo(local_pos, ref, potentials, count, true);
+}
+
+/**
+ * The pixel centers are processed in chunks, such that the potential of a full neighborhood of pixels is evaluated without
+ * allocating memory.
+ */
+void Detector::getWeightingPotential(const ROOT::Math::XYZPoint& local_pos,
+                                     const Pixel::Index* references,
+                                     double* potentials,
+                                     size_t count) const {
+    std::array<ROOT::Math::XYPoint, 64> refs;
+    for(size_t offset = 0; offset < count; offset += refs.size()) {
+        auto chunk = std::min(refs.size(), count - offset);
+        for(size_t i = 0; i < chunk; ++i) {
+            const auto& reference = references[offset + i];
+            refs[i] = static_cast<ROOT::Math::XYPoint>(model_->getPixelCenter(reference.x(), reference.y()));
+        }
+        weighting_potential_.getRelativeTo(local_pos, refs.data(), potentials + offset, chunk, true);
+    }
+}
+
 /**
  * The type of the weighting potential is set depending on the function used to apply it.
  */
@@ -192,12 +238,25 @@ FieldType Detector::getWeightingPotentialType() const {
  * @throws std::invalid_argument If the weighting potential dimensions are incorrect or the thickness domain is outside the
  * sensor
  */
-void Detector::setWeightingPotentialGrid(const std::shared_ptr<std::vector<double>>& potential,
+void Detector::setWeightingPotentialGrid(const std::shared_ptr<const double>& potential,
+                                         size_t entries,
                                          std::array<size_t, 3> dimensions,
                                          std::array<double, 2> scales,
                                          std::array<double, 2> offset,
-                                         std::pair<double, double> thickness_domain) {
-    weighting_potential_.setGrid(potential, dimensions, scales, offset, thickness_domain);
+                                         std::pair<double, double> thickness_domain,
+                                         FieldInterpolation interpolation,
+                                         FieldPrecision precision,
+                                         std::vector<double> z_edges) {
+    weighting_potential_.setGrid(potential,
+                                 entries,
+                                 dimensions,
+                                 scales,
+                                 offset,
+                                 thickness_domain,
+                                 interpolation,
+                                 precision,
+                                 FieldSymmetry::NONE,
+                                 std::move(z_edges));
 }
 
 void Detector::setWeightingPotentialFunction(FieldFunction<double> function,
@@ -210,20 +269,36 @@ bool Detector::hasMagneticField() const {
     return magnetic_field_on_;
 }
 
-// TODO Currently the magnetic field in the detector is fixed to the field vector at it's center position. Change in case a
-// field gradient is needed inside the sensor.
 void Detector::setMagneticField(ROOT::Math::XYZVector b_field) {
     magnetic_field_on_ = true;
     magnetic_field_ = std::move(b_field);
+    magnetic_field_function_ = nullptr;
+}
+
+void Detector::setMagneticFieldFunction(ROOT::Math::XYZVector b_field, FieldFunction<ROOT::Math::XYZVector> function) {
+    magnetic_field_on_ = true;
+    magnetic_field_ = std::move(b_field);
+    magnetic_field_function_ = std::move(function);
+}
+
+bool Detector::hasUniformMagneticField() const {
+    return !magnetic_field_function_;
 }
 
-/**
- * The magnetic field is evaluated for any sensor position.
- */
 ROOT::Math::XYZVector Detector::getMagneticField() const {
     return magnetic_field_;
 }
 
+/**
+ * A uniform magnetic field is returned directly, otherwise the field function is evaluated for the sensor position.
+ */
+ROOT::Math::XYZVector Detector::getMagneticField(const ROOT::Math::XYZPoint& pos) const {
+    if(!magnetic_field_function_) {
+        return magnetic_field_;
+    }
+    return magnetic_field_function_(pos);
+}
+
 /**
  * The doping profile is replicated for all pixels and uses flipping at each boundary (side effects are not modeled in this
  * stage). Outside of the sensor the doping profile is strictly zero by definition.
@@ -241,6 +316,14 @@ double Detector::getDopingConcentration(const ROOT::Math::XYZPoint& pos) const {
     return doping_profile_.get(pos, true);
 }
 
+void Detector::getDopingConcentration(const ROOT::Math::XYZPoint* pos, double* concentrations, size_t count) const {
+    doping_profile_.get(pos, concentrations, count, true);
+}
+
+double Detector::getDopingConcentration(const ROOT::Math::XYZPoint& pos, FieldCursor& cursor) const {
+    return doping_profile_.get(pos, cursor, true);
+}
+
 /**
  * The type of the doping profile is set depending on the function used to apply it.
  */
@@ -254,12 +337,25 @@ FieldType Detector::getDopingProfileType() const {
  * The doping profile is stored as a large flat array. If the sizes are denoted as respectively X_SIZE, Y_ SIZE and Z_SIZE,
  * each position (x, y, z) has one index, calculated as x*Y_SIZE*Z_SIZE+y*Z_SIZE+z
  */
-void Detector::setDopingProfileGrid(std::shared_ptr<std::vector<double>> field,
+void Detector::setDopingProfileGrid(std::shared_ptr<const double> field,
+                                    size_t entries,
                                     std::array<size_t, 3> dimensions,
                                     std::array<double, 2> scales,
                                     std::array<double, 2> offset,
-                                    std::pair<double, double> thickness_domain) {
-    doping_profile_.setGrid(std::move(field), dimensions, scales, offset, thickness_domain);
+                                    std::pair<double, double> thickness_domain,
+                                    FieldPrecision precision,
+                                    FieldSymmetry symmetry,
+                                    std::vector<double> z_edges) {
+    doping_profile_.setGrid(std::move(field),
+                            entries,
+                            dimensions,
+                            scales,
+                            offset,
+                            thickness_domain,
+                            FieldInterpolation::NEAREST,
+                            precision,
+                            symmetry,
+                            std::move(z_edges));
 }
 
 void Detector::setDopingProfileFunction(FieldFunction<double> function, FieldType type) {
@@ -268,3 +364,17 @@ void Detector::setDopingProfileFunction(FieldFunction<double> function, FieldTyp
                                  model_->getSensorCenter().z() + model_->getSensorSize().z() / 2},
                                 type);
 }
+
+/**
+ * @throws std::invalid_argument If the table is empty or its boundaries are not in ascending order
+ *
+ * The depth is measured from the sensor surface at half the sensor thickness in local coordinates.
+ */
+void Detector::setDopingProfileTable(std::vector<double> depths, std::vector<double> concentrations, FieldType type) {
+    doping_profile_.setDepthTable(std::move(depths),
+                                  std::move(concentrations),
+                                  model_->getSensorSize().z() / 2,
+                                  {model_->getSensorCenter().z() - model_->getSensorSize().z() / 2,
+                                   model_->getSensorCenter().z() + model_->getSensorSize().z() / 2},
+                                  type);
+}
@@ -81,14 +81,38 @@ namespace allpix {
          * @brief Convert a global position to a position in the detector frame
          * @param global_pos Position in the global frame
          * @return Position in the local frame
+         * @warning The local coordinate position does normally not have its origin at the center of rotation
+         *
+         * The origin of the local frame is at the center of the first pixel in the middle of the sensor.
          */
-        ROOT::Math::XYZPoint getLocalPosition(const ROOT::Math::XYZPoint& global_pos) const;
+        ROOT::Math::XYZPoint getLocalPosition(const ROOT::Math::XYZPoint& global_pos) const {
+            return apply_transform(local_matrix_, global_pos);
+        }
         /**
          * @brief Convert a position in the detector frame to a global position
          * @param local_pos Position in the local frame
          * @return Position in the global frame
          */
-        ROOT::Math::XYZPoint getGlobalPosition(const ROOT::Math::XYZPoint& local_pos) const;
+        ROOT::Math::XYZPoint getGlobalPosition(const ROOT::Math::XYZPoint& local_pos) const {
+            return apply_transform(global_matrix_, local_pos);
+        }
+
+        /**
+         * @brief Convert a set of global positions to positions in the detector frame
+         * @param global_pos Positions in the global frame
+         * @return Positions in the local frame
+         */
+        std::vector<ROOT::Math::XYZPoint> getLocalPositions(const std::vector<ROOT::Math::XYZPoint>& global_pos) const {
+            return apply_transform(local_matrix_, global_pos);
+        }
+        /**
+         * @brief Convert a set of positions in the detector frame to global positions
+         * @param local_pos Positions in the local frame
+         * @return Positions in the global frame
+         */
+        std::vector<ROOT::Math::XYZPoint> getGlobalPositions(const std::vector<ROOT::Math::XYZPoint>& local_pos) const {
+            return apply_transform(global_matrix_, local_pos);
+        }
 
         /**
          * @brief Return a pixel object from the x- and y-index values
@@ -118,20 +142,44 @@ namespace allpix {
          * @return Vector of the field at the queried point
          */
         ROOT::Math::XYZVector getElectricField(const ROOT::Math::XYZPoint& local_pos) const;
+        /**
+         * @brief Get the electric field in the sensor at a set of local positions
+         * @param local_pos Pointer to the first of the positions in the local frame
+         * @param fields Pointer to the first of the field vectors to be filled, requires space for count vectors
+         * @param count Number of positions to evaluate the field at
+         */
+        void getElectricField(const ROOT::Math::XYZPoint* local_pos, ROOT::Math::XYZVector* fields, size_t count) const;
+        /**
+         * @brief Get the electric field in the sensor at a local position close to the position of the previous lookup
+         * @param local_pos Position in the local frame
+         * @param cursor State of the previous lookups of the electric field, updated for this lookup
+         * @return Vector of the field at the queried point
+         */
+        ROOT::Math::XYZVector getElectricField(const ROOT::Math::XYZPoint& local_pos, FieldCursor& cursor) const;
 
         /**
          * @brief Set the electric field in a single pixel in the detector using a grid
          * @param field Flat array of the field vectors (see detailed description)
+         * @param entries Number of entries of the flat field array
          * @param dimensions The dimensions of the flat electric field array
          * @param scales Scaling factors for the field size, given in fractions of a pixel unit cell in x and y
          * @param offset Offset of the field from the pixel border
          * @param thickness_domain Domain in local coordinates in the thickness direction where the field holds
+         * @param interpolation Method used to look up values from the grid
+         * @param precision Precision of the values stored for the lookup
+         * @param symmetry Axes along which the grid only holds the positive half of the field, mirrored for the lookup
+         * @param z_edges Edges of the bins in z for grids with non-uniform binning, empty for uniform binning
          */
-        void setElectricFieldGrid(const std::shared_ptr<std::vector<double>>& field,
+        void setElectricFieldGrid(const std::shared_ptr<const double>& field,
+                                  size_t entries,
                                   std::array<size_t, 3> dimensions,
                                   std::array<double, 2> scales,
                                   std::array<double, 2> offset,
-                                  std::pair<double, double> thickness_domain);
+                                  std::pair<double, double> thickness_domain,
+                                  FieldInterpolation interpolation = FieldInterpolation::NEAREST,
+                                  FieldPrecision precision = FieldPrecision::DOUBLE,
+                                  FieldSymmetry symmetry = FieldSymmetry::NONE,
+                                  std::vector<double> z_edges = {});
         /**
          * @brief Set the electric field in a single pixel using a function
          * @param function Function used to retrieve the electric field
@@ -141,6 +189,15 @@ namespace allpix {
         void setElectricFieldFunction(FieldFunction<ROOT::Math::XYZVector> function,
                                       std::pair<double, double> thickness_domain,
                                       FieldType type = FieldType::CUSTOM);
+        /**
+         * @brief Create a vector field on the grid of the electric field, e.g. the drift velocity of charge carriers
+         * @param function Function returning the value of the new field from a local position and the electric field there
+         * @return Field with the binning of the electric field
+         * @throws std::invalid_argument If the electric field is not given by a grid
+         */
+        DetectorField<ROOT::Math::XYZVector> deriveElectricFieldGrid(
+            const std::function<ROOT::Math::XYZVector(const ROOT::Math::XYZPoint&, const ROOT::Math::XYZVector&)>& function)
+            const;
 
         /**
          * @brief Returns if the detector has a doping profile in the sensor
@@ -158,26 +215,57 @@ namespace allpix {
          * @return Value of the field at the queried point
          */
         double getDopingConcentration(const ROOT::Math::XYZPoint& local_pos) const;
+        /**
+         * @brief Get the doping profile in the sensor at a set of local positions
+         * @param local_pos Pointer to the first of the positions in the local frame
+         * @param concentrations Pointer to the first of the values to be filled, requires space for count values
+         * @param count Number of positions to evaluate the doping profile at
+         */
+        void getDopingConcentration(const ROOT::Math::XYZPoint* local_pos, double* concentrations, size_t count) const;
+        /**
+         * @brief Get the doping profile in the sensor at a local position close to the position of the previous lookup
+         * @param local_pos Position in the local frame
+         * @param cursor State of the previous lookups of the doping profile, updated for this lookup
+         * @return Value of the field at the queried point
+         */
+        double getDopingConcentration(const ROOT::Math::XYZPoint& local_pos, FieldCursor& cursor) const;
 
         /**
          * @brief Set the doping profile in a single pixel in the detector using a grid
          * @param field Flat array of the field (see detailed description)
+         * @param entries Number of entries of the flat field array
          * @param dimensions The dimensions of the flat doping profile array
          * @param scales Scaling factors for the field size, given in fractions of a pixel unit cell in x and y
          * @param offset Offset of the field from the pixel border
          * @param thickness_domain Domain in local coordinates in the thickness direction where the profile holds
+         * @param precision Precision of the values stored for the lookup
+         * @param symmetry Axes along which the grid only holds the positive half of the field, mirrored for the lookup
+         * @param z_edges Edges of the bins in z for grids with non-uniform binning, empty for uniform binning
          */
-        void setDopingProfileGrid(std::shared_ptr<std::vector<double>> field,
+        void setDopingProfileGrid(std::shared_ptr<const double> field,
+                                  size_t entries,
                                   std::array<size_t, 3> dimensions,
                                   std::array<double, 2> scales,
                                   std::array<double, 2> offset,
-                                  std::pair<double, double> thickness_domain);
+                                  std::pair<double, double> thickness_domain,
+                                  FieldPrecision precision = FieldPrecision::DOUBLE,
+                                  FieldSymmetry symmetry = FieldSymmetry::NONE,
+                                  std::vector<double> z_edges = {});
         /**
          * @brief Set the doping profile in a single pixel using a function
          * @param function Function used to retrieve the doping profile
          * @param type Type of the doping profile function used
          */
         void setDopingProfileFunction(FieldFunction<double> function, FieldType type = FieldType::CUSTOM);
+        /**
+         * @brief Set a doping profile only depending on the depth in the sensor using a table of regions
+         * @param depths Lower boundaries of the regions as depth below the sensor surface, in ascending order
+         * @param concentrations Doping concentration in each of the regions
+         * @param type Type of the doping profile represented by the table
+         */
+        void setDopingProfileTable(std::vector<double> depths,
+                                   std::vector<double> concentrations,
+                                   FieldType type = FieldType::CUSTOM);
 
         /**
          * @brief Returns if the detector has a weighting potential in the sensor
@@ -197,20 +285,50 @@ namespace allpix {
          * @return Value of the potential at the queried point
          */
         double getWeightingPotential(const ROOT::Math::XYZPoint& local_pos, const Pixel::Index& reference) const;
+        /**
+         * @brief Get the weighting potential in the sensor at a set of local positions
+         * @param local_pos Pointer to the first of the positions in the local frame
+         * @param reference Index of the pixel for which we want the weighting potential
+         * @param potentials Pointer to the first of the values to be filled, requires space for count values
+         * @param count Number of positions to evaluate the potential at
+         */
+        void getWeightingPotential(const ROOT::Math::XYZPoint* local_pos,
+                                   const Pixel::Index& reference,
+                                   double* potentials,
+                                   size_t count) const;
+        /**
+         * @brief Get the weighting potential of a set of pixels at a single local position in the sensor
+         * @param local_pos Position in the local frame
+         * @param references Pointer to the first of the pixel indices for which we want the weighting potential
+         * @param potentials Pointer to the first of the values to be filled, requires space for count values
+         * @param count Number of pixels to evaluate the potential for
+         */
+        void getWeightingPotential(const ROOT::Math::XYZPoint& local_pos,
+                                   const Pixel::Index* references,
+                                   double* potentials,
+                                   size_t count) const;
 
         /**
          * @brief Set the weighting potential in a single pixel in the detector using a grid
          * @param potential Flat array of the potential vectors (see detailed description)
+         * @param entries Number of entries of the flat potential array
          * @param dimensions The dimensions of the flat weighting potential array
          * @param scales Scaling factors for the field size, given in fractions of a pixel unit cell in x and y
          * @param offset Offset of the field from the pixel border
          * @param thickness_domain Domain in local coordinates in the thickness direction where the potential holds
+         * @param interpolation Method used to look up values from the grid
+         * @param precision Precision of the values stored for the lookup
+         * @param z_edges Edges of the bins in z for grids with non-uniform binning, empty for uniform binning
          */
-        void setWeightingPotentialGrid(const std::shared_ptr<std::vector<double>>& potential,
+        void setWeightingPotentialGrid(const std::shared_ptr<const double>& potential,
+                                       size_t entries,
                                        std::array<size_t, 3> dimensions,
                                        std::array<double, 2> scales,
                                        std::array<double, 2> offset,
-                                       std::pair<double, double> thickness_domain);
+                                       std::pair<double, double> thickness_domain,
+                                       FieldInterpolation interpolation = FieldInterpolation::NEAREST,
+                                       FieldPrecision precision = FieldPrecision::DOUBLE,
+                                       std::vector<double> z_edges = {});
         /**
          * @brief Set the weighting potential in a single pixel using a function
          * @param function Function used to retrieve the weighting potential
@@ -227,17 +345,34 @@ namespace allpix {
          */
         void setMagneticField(ROOT::Math::XYZVector b_field);
 
+        /**
+         * @brief Set a magnetic field varying inside the detector using a function
+         * @param b_field Vector of the magnetic field at the center of the detector in the local frame
+         * @param function Function returning the magnetic field in the local frame at a local position
+         */
+        void setMagneticFieldFunction(ROOT::Math::XYZVector b_field, FieldFunction<ROOT::Math::XYZVector> function);
+
         /**
          * @brief Returns if the detector has a magnetic field in the sensor
          * @return True if the detector has an magnetic field, false otherwise
          */
         bool hasMagneticField() const;
+        /**
+         * @brief Returns if the magnetic field is the same everywhere in the sensor
+         * @return True if the magnetic field is uniform, false if it has to be evaluated at every position
+         */
+        bool hasUniformMagneticField() const;
+        /**
+         * @brief Get the magnetic field at the center of the sensor
+         * @return Vector of the field in the local frame
+         */
+        ROOT::Math::XYZVector getMagneticField() const;
         /**
          * @brief Get the magnetic field in the sensor at a local position
          * @param pos Position in the local frame
          * @return Vector of the field at the queried point
          */
-        ROOT::Math::XYZVector getMagneticField() const;
+        ROOT::Math::XYZVector getMagneticField(const ROOT::Math::XYZPoint& pos) const;
 
         /**
          * @brief Get the model of this detector
@@ -265,14 +400,42 @@ namespace allpix {
          */
         void build_transform();
 
+        // Affine transformation as rows of a 3x4 matrix, with the translation in the last column
+        using TransformMatrix = std::array<double, 12>;
+
+        /**
+         * @brief Apply an affine transformation to a point
+         * @param matrix Transformation matrix
+         * @param point Point to transform
+         * @return Transformed point
+         *
+         * The matrix is applied directly instead of through ROOT::Math::Transform3D, such that the conversion is inlined
+         * into the callers and vectorized by the compiler.
+         */
+        static ROOT::Math::XYZPoint apply_transform(const TransformMatrix& matrix, const ROOT::Math::XYZPoint& point) {
+            return ROOT::Math::XYZPoint(matrix[0] * point.x() + matrix[1] * point.y() + matrix[2] * point.z() + matrix[3],
+                                        matrix[4] * point.x() + matrix[5] * point.y() + matrix[6] * point.z() + matrix[7],
+                                        matrix[8] * point.x() + matrix[9] * point.y() + matrix[10] * point.z() + matrix[11]);
+        }
+        static std::vector<ROOT::Math::XYZPoint> apply_transform(const TransformMatrix& matrix,
+                                                                 const std::vector<ROOT::Math::XYZPoint>& points) {
+            std::vector<ROOT::Math::XYZPoint> result;
+            result.reserve(points.size());
+            for(const auto& point : points) {
+                result.push_back(apply_transform(matrix, point));
+            }
+            return result;
+        }
+
         std::string name_;
         std::shared_ptr<DetectorModel> model_;
 
         ROOT::Math::XYZPoint position_;
         ROOT::Math::Rotation3D orientation_;
 
-        // Transform matrix from global to local coordinates
-        ROOT::Math::Transform3D transform_;
+        // Transform matrices from local to global coordinates and back, initialized to the identity
+        TransformMatrix global_matrix_{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0}};
+        TransformMatrix local_matrix_{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0}};
 
         // Electric field
         DetectorField<ROOT::Math::XYZVector, 3> electric_field_;
@@ -282,6 +445,7 @@ namespace allpix {
 
         // Magnetic field properties
         ROOT::Math::XYZVector magnetic_field_;
+        FieldFunction<ROOT::Math::XYZVector> magnetic_field_function_;
         bool magnetic_field_on_;
 
         // Doping profile properties
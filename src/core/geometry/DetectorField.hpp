@@ -11,8 +11,12 @@
 #ifndef ALLPIX_DETECTOR_FIELD_H
 #define ALLPIX_DETECTOR_FIELD_H
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <functional>
+#include <limits>
+#include <memory>
 #include <vector>
 
 #include <Math/Point2D.h>
@@ -20,6 +24,8 @@
 #include <Math/Vector2D.h>
 #include <Math/Vector3D.h>
 
+#include "FieldStore.hpp"
+#include "core/utils/numa.h"
 #include "objects/Pixel.hpp"
 #include "tools/ROOT.h"
 
@@ -36,6 +42,35 @@ namespace allpix {
         CUSTOM,   ///< Custom field function
     };
 
+    /**
+     * @brief Interpolation methods used to look up values from field grids
+     */
+    enum class FieldInterpolation {
+        NEAREST = 0, ///< Value of the nearest grid bin is used
+        LINEAR,      ///< Trilinear interpolation between the centers of the neighboring grid bins
+    };
+
+    /**
+     * @brief Precision of the values stored for field grids
+     */
+    enum class FieldPrecision {
+        DOUBLE = 0, ///< Values are stored in double precision
+        SINGLE,     ///< Values are stored in single precision, field lookups still return double precision values
+    };
+
+    /**
+     * @brief Mirror symmetries of field grids within the field cell
+     *
+     * A mirrored field only stores the half of the grid with positive coordinates along the mirrored axes, measured from the
+     * center of the field. The other half is obtained by mirroring, inverting the vector component along the mirrored axis.
+     */
+    enum class FieldSymmetry {
+        NONE = 0,  ///< The grid covers the full field
+        MIRROR_X,  ///< The field is mirror symmetric in x, the grid covers the half with positive x
+        MIRROR_Y,  ///< The field is mirror symmetric in y, the grid covers the half with positive y
+        MIRROR_XY, ///< The field is mirror symmetric in x and y, the grid covers the quadrant with positive x and y
+    };
+
     /**
      * @brief Functor returning the field at a given position
      * @param pos Position in local coordinates at which the field should be evaluated
@@ -50,6 +85,31 @@ namespace allpix {
      */
     template <typename T> void flip_vector_components(T& field, bool x, bool y);
 
+    /**
+     * @brief State of consecutive lookups of a grid field along the path of a charge carrier
+     *
+     * Remembers the field replica and the grid cell of the previous lookup. As long as the following positions stay within
+     * them, neither the replica nor the indices of the grid bins are computed again. A cursor belongs to a single field and
+     * is reset when used with another one.
+     */
+    struct FieldCursor {
+        // Field the state belongs to
+        const void* field{};
+
+        // Replica of the previous lookup and its extent along x and y, in local coordinates shifted by the field offset
+        int replica_x{};
+        int replica_y{};
+        std::array<double, 4> replica_bounds{};
+
+        // Lower edge of the grid cell of the previous lookup in grid coordinates, and the indices of its bins
+        bool cell_valid{};
+        std::array<double, 3> cell_base{};
+        std::array<size_t, 8> cell_bins{};
+
+        // Grid coordinates of the previous lookup, providing the direction of motion
+        std::array<double, 3> last_coordinates{};
+    };
+
     /**
      * @brief Field instance of a detector
      *
@@ -69,7 +129,9 @@ namespace allpix {
          * @brief Check if the field is valid and either a field grid or a field function is configured
          * @return Boolean indicating field validity
          */
-        bool isValid() const { return function_ || (dimensions_[0] != 0 && dimensions_[1] != 0 && dimensions_[2] != 0); };
+        bool isValid() const {
+            return function_ || !table_values_.empty() || (dimensions_[0] != 0 && dimensions_[1] != 0 && dimensions_[2] != 0);
+        };
 
         /**
          * @brief Return the type of field
@@ -85,6 +147,24 @@ namespace allpix {
          */
         T get(const ROOT::Math::XYZPoint& local_pos, const bool extrapolate_z = false) const;
 
+        /**
+         * @brief Get the field values in the sensor at a set of positions provided in local coordinates
+         * @param local_pos Pointer to the first of the positions in the local frame
+         * @param values Pointer to the first of the values to be filled, requires space for count values
+         * @param count Number of positions to evaluate the field at
+         * @param extrapolate_z Extrapolate the field along z when outside the defined region
+         */
+        void get(const ROOT::Math::XYZPoint* local_pos, T* values, size_t count, const bool extrapolate_z = false) const;
+
+        /**
+         * @brief Get the field value in the sensor at a position close to the position of the previous lookup
+         * @param local_pos Position in the local frame
+         * @param cursor State of the previous lookups, updated for this lookup
+         * @param extrapolate_z Extrapolate the field along z when outside the defined region
+         * @return Value(s) of the field at the queried point
+         */
+        T get(const ROOT::Math::XYZPoint& local_pos, FieldCursor& cursor, const bool extrapolate_z = false) const;
+
         /**
          * @brief Get the value of the field at a position provided in local coordinates with respect to the reference
          * @param local_pos Position in the local frame
@@ -96,19 +176,59 @@ namespace allpix {
                         const ROOT::Math::XYPoint& reference,
                         const bool extrapolate_z = false) const;
 
+        /**
+         * @brief Get the values of the field at a set of positions in local coordinates with respect to the reference
+         * @param local_pos Pointer to the first of the positions in the local frame
+         * @param reference Reference position to calculate the field for, x and y coordinate only
+         * @param values Pointer to the first of the values to be filled, requires space for count values
+         * @param count Number of positions to evaluate the field at
+         * @param extrapolate_z Extrapolate the field along z when outside the defined region
+         */
+        void getRelativeTo(const ROOT::Math::XYZPoint* local_pos,
+                           const ROOT::Math::XYPoint& reference,
+                           T* values,
+                           size_t count,
+                           const bool extrapolate_z = false) const;
+
+        /**
+         * @brief Get the values of the field at a single position in local coordinates with respect to a set of references
+         * @param local_pos Position in the local frame
+         * @param references Pointer to the first of the reference positions, x and y coordinate only
+         * @param values Pointer to the first of the values to be filled, requires space for count values
+         * @param count Number of reference positions to evaluate the field for
+         * @param extrapolate_z Extrapolate the field along z when outside the defined region
+         */
+        void getRelativeTo(const ROOT::Math::XYZPoint& local_pos,
+                           const ROOT::Math::XYPoint* references,
+                           T* values,
+                           size_t count,
+                           const bool extrapolate_z = false) const;
+
         /**
          * @brief Set the field in the detector using a grid
          * @param field Flat array of the field
+         * @param entries Number of entries of the flat field array
          * @param dimensions The dimensions of the flat field array
          * @param scales The actual physical extent of the field in each direction in x and y
          * @param offset Offset of the field in x and y, given in physical units
          * @param thickness_domain Domain in local coordinates in the thickness direction where the field holds
+         * @param interpolation Method used to look up field values from the grid
+         * @param precision Precision of the values stored for the lookup
+         * @param symmetry Mirror symmetry of the field, the grid only covers the part with positive coordinates along the
+         * mirrored axes
+         * @param z_edges Edges of the bins in z for grids with non-uniform binning, stretched to the thickness domain. Empty
+         * for uniform binning
          */
-        void setGrid(std::shared_ptr<std::vector<double>> field,
+        void setGrid(std::shared_ptr<const double> field,
+                     size_t entries,
                      std::array<size_t, 3> dimensions,
                      std::array<double, 2> scales,
                      std::array<double, 2> offset,
-                     std::pair<double, double> thickness_domain);
+                     std::pair<double, double> thickness_domain,
+                     FieldInterpolation interpolation = FieldInterpolation::NEAREST,
+                     FieldPrecision precision = FieldPrecision::DOUBLE,
+                     FieldSymmetry symmetry = FieldSymmetry::NONE,
+                     std::vector<double> z_edges = {});
         /**
          * @brief Set the field in the detector using a function
          * @param function Function used to calculate the field
@@ -118,6 +238,33 @@ namespace allpix {
         void setFunction(FieldFunction<T> function,
                          std::pair<double, double> thickness_domain,
                          FieldType type = FieldType::CUSTOM);
+        /**
+         * @brief Set a field which only depends on the depth in the sensor using a table of regions
+         * @param depths Lower boundaries of the regions as depth below the reference position, in ascending order
+         * @param values Field value(s) in each of the regions
+         * @param reference Position in local coordinates in the thickness direction from which the depth is measured
+         * @param thickness_domain Domain in local coordinates in the thickness direction where the field holds
+         * @param type Type of the field represented by the table
+         *
+         * Positions deeper than the last region boundary take the value of the last region. The field is identical in all
+         * field replicas and is not flipped at their boundaries.
+         */
+        void setDepthTable(std::vector<double> depths,
+                           std::vector<T> values,
+                           double reference,
+                           std::pair<double, double> thickness_domain,
+                           FieldType type = FieldType::CUSTOM);
+
+        /**
+         * @brief Create a field on the grid of this field, with values derived from the values of this field
+         * @param function Function returning the derived value from the position of a bin center in local coordinates and
+         * the value of this field in that bin
+         * @return Field with the binning, symmetry, interpolation and precision of this field
+         *
+         * The bin centers are given within the field replica at the origin of the local coordinate system. Along mirrored
+         * axes, the derived values have to be mirror symmetric as well.
+         */
+        DetectorField<T, N> deriveGrid(const std::function<T(const ROOT::Math::XYZPoint&, const T&)>& function) const;
 
     private:
         /**
@@ -142,6 +289,130 @@ namespace allpix {
          */
         template <std::size_t... I> auto get_impl(size_t offset, std::index_sequence<I...>) const;
 
+        /**
+         * @brief Helper function to construct the return type from a set of interpolated field components
+         * @param values The field components
+         */
+        template <std::size_t... I>
+        static auto get_impl(const std::array<double, N>& values, std::index_sequence<I...>);
+
+        /**
+         * @brief Helper function to calculate the position of a grid bin in the blocked copy of the field
+         * @param x Bin index in x
+         * @param y Bin index in y
+         * @param z Bin index in z
+         * @return Index of the first field component of the bin in the blocked field vector
+         */
+        size_t get_blocked_index(size_t x, size_t y, size_t z) const;
+
+        /**
+         * @brief Helper function to calculate the coordinate of a distance from the field center in units of grid bins
+         * @param axis Axis of the distance, 0 for x and 1 for y
+         * @param dist Distance from the center of the field, non-negative along mirrored axes
+         * @return Coordinate in units of bins of the stored grid, the bin N extends from N to N+1
+         */
+        double get_bin_coordinate(size_t axis, double dist) const;
+
+        /**
+         * @brief Helper function to calculate the coordinate of a position along z in units of grid bins
+         * @param z Position in local coordinates along z
+         * @param centered Map the position linearly between the bin centers instead of between the bin edges, as required
+         * for the interpolation between neighboring bins
+         * @return Coordinate in units of bins, the bin N extends from N to N+1 and has its center at N+0.5
+         */
+        double get_z_bin_coordinate(double z, bool centered) const;
+
+        /**
+         * @brief Helper function to calculate the positions of the eight bins surrounding a point in the blocked field
+         * @param lower Lower neighboring bin along each axis
+         * @param upper Upper neighboring bin along each axis
+         * @return Index of the first field component of every bin, the bit d of the position selects the upper bin along d
+         */
+        std::array<size_t, 8> get_cell_bins(const std::array<size_t, 3>& lower, const std::array<size_t, 3>& upper) const;
+
+        /**
+         * @brief Helper function to interpolate the field trilinearly between the eight bins surrounding a point
+         * @param bins Index of the first field component of every bin in the blocked field
+         * @param fraction Fractional distance of the point to the lower bins along each axis
+         * @return Interpolated value(s) of the field
+         */
+        T interpolate_cell(const std::array<size_t, 8>& bins, const std::array<double, 3>& fraction) const;
+
+        /**
+         * @brief Helper function to request a bin of the grid used for the lookup to be loaded into the cache
+         * @param index Index of the first field component of the bin
+         */
+        void prefetch_bin(size_t index) const;
+
+        /**
+         * @brief Helper function to select the values of the grid used for the lookup on the node of the calling thread
+         * @param grid Grid used for the lookup
+         * @return Pointer to the copy on the node of the calling thread if the grid is replicated, to the grid otherwise
+         */
+        template <typename V> const V* local_grid(const std::shared_ptr<const V>& grid) const {
+            return replicas_.empty() ? grid.get() : static_cast<const V*>(replicas_[numa::current_node()].get());
+        }
+
+        /**
+         * @brief Helper function to interpolate the field trilinearly between the centers of the neighboring grid bins
+         * @param dist Distance from the center of the field to obtain the values for, given in local coordinates
+         * @param extrapolate_z Switch to either extrapolate the field along z when outside the grid or return zero
+         * @return Interpolated value(s) of the field at the queried point
+         */
+        T get_interpolated_field_from_grid(const ROOT::Math::XYZPoint& dist, const bool extrapolate_z = false) const;
+
+        /**
+         * @brief Helper function to map a position onto the field replica it is located in
+         * @param local_pos Position in the local frame
+         * @param replica_x Index of the field replica in x
+         * @param replica_y Index of the field replica in y
+         * @return Position relative to the center of the field replica, flipped for odd replicas
+         */
+        ROOT::Math::XYZPoint
+        get_replica_position(const ROOT::Math::XYZPoint& local_pos, int& replica_x, int& replica_y) const;
+
+        /**
+         * @brief Helper function to evaluate the field function within the thickness domain
+         * @param pos Position to evaluate the function at
+         * @param extrapolate_z Switch to either extrapolate the field along z when outside the domain or return zero
+         * @return Value(s) of the field at the queried point
+         */
+        T get_field_from_function(const ROOT::Math::XYZPoint& pos, const bool extrapolate_z = false) const;
+
+        /**
+         * @brief Helper function to look up the field from the depth table within the thickness domain
+         * @param z Position in local coordinates in the thickness direction
+         * @param extrapolate_z Switch to either extrapolate the field along z when outside the domain or return zero
+         * @return Value(s) of the field at the queried depth
+         */
+        T get_field_from_table(double z, const bool extrapolate_z = false) const;
+
+        /**
+         * @brief Helper function to evaluate the field for a set of positions, dispatching on the field type only once
+         * @param local_pos Pointer to the first of the positions
+         * @param values Pointer to the first of the values to be filled
+         * @param count Number of positions
+         * @param extrapolate_z Extrapolate the field along z when outside the defined region
+         * @param mapping Function mapping a position onto the field frame and providing the replica indices for flipping
+         */
+        template <typename Mapping>
+        void get_dispatch(const ROOT::Math::XYZPoint* local_pos,
+                          T* values,
+                          size_t count,
+                          const bool extrapolate_z,
+                          Mapping mapping) const;
+
+        /**
+         * @brief Helper function to evaluate the field for a set of positions using the given lookup function
+         * @param local_pos Pointer to the first of the positions
+         * @param values Pointer to the first of the values to be filled
+         * @param count Number of positions
+         * @param mapping Function mapping a position onto the field frame and providing the replica indices for flipping
+         * @param lookup Function returning the field for a position in the field frame
+         */
+        template <typename Mapping, typename Lookup>
+        void get_batch(const ROOT::Math::XYZPoint* local_pos, T* values, size_t count, Mapping mapping, Lookup lookup) const;
+
         /**
          * @brief Helper function to calculate the field index based on the distance from its center and to return the values
          * @param dist Distance from the center of the field to obtain the values for, given in local coordinates
@@ -150,6 +421,14 @@ namespace allpix {
          */
         T get_field_from_grid(const ROOT::Math::XYZPoint& dist, const bool extrapolate_z = false) const;
 
+        /**
+         * @brief Helper function to return the value of the grid bin nearest to the given distance from the field center
+         * @param dist Distance from the center of the field to obtain the values for, given in local coordinates
+         * @param extrapolate_z Switch to either extrapolate the field along z when outside the grid or return zero
+         * @return Value(s) of the field at the queried point
+         */
+        T get_nearest_field_from_grid(const ROOT::Math::XYZPoint& dist, const bool extrapolate_z = false) const;
+
         /**
          * Field properties
          * * Dimensions of the field map (bins in x, y, z)
@@ -157,10 +436,12 @@ namespace allpix {
          *   of the pixel pitch.
          * * Offset of the field from the pixel edge, e.g. when using fields centered at a pixel corner instead of the center
          *   Values provided as absolute shifts in um.
+         * * Mirrored axes in x and y, along which the grid only covers the half of the field with positive coordinates
          */
         std::array<size_t, 3> dimensions_{};
         std::array<double_t, 2> scales_{{1., 1.}};
         std::array<double_t, 2> offset_{{0., 0.}};
+        std::array<bool, 2> mirrored_{};
 
         /**
          * Field definition
@@ -173,12 +454,52 @@ namespace allpix {
          * component in the flat field vector can be calculated as:
          *
          *   field_i(x, y, z) =  x * Y_SIZE* Z_SIZE * N + y * Z_SIZE * + z * N + i
+         *
+         * The flat array is only referenced and never modified, it might be shared with other fields or be mapped directly
+         * from a field file. Grids are registered with the \ref FieldStore, such that fields with identical grids share
+         * the same memory, also if they have been read from different files.
+         *
+         * When interpolating, the eight neighboring bins are required for every lookup. A copy of the grid is therefore
+         * stored in cubic tiles of tile_size_ bins per dimension, such that neighboring bins mostly share a cache line.
+         * Along mirrored axes, the blocked copy starts with the mirror image of the first bin.
+         *
+         * With single precision, only a single precision copy of the grid used for the lookup is kept, either in the
+         * original or in the blocked layout, and the double precision grid is released.
+         *
+         * If replication is enabled, the grid used for the lookup is additionally copied to every NUMA node, and the lookup
+         * reads from the copy on the node of the calling thread instead.
          */
-        std::shared_ptr<std::vector<double>> field_;
+        std::shared_ptr<const double> field_;
+        FieldInterpolation interpolation_{FieldInterpolation::NEAREST};
+        static constexpr size_t tile_size_{4};
+        std::array<size_t, 3> tiles_{};
+        std::array<size_t, 3> blocked_dimensions_{};
+        std::shared_ptr<const double> blocked_field_;
+        std::shared_ptr<const float> single_field_;
+        std::shared_ptr<const float> single_blocked_field_;
+        std::vector<std::shared_ptr<const void>> replicas_;
         std::pair<double, double> thickness_domain_{};
+
+        /*
+         * Non-uniform binning along z
+         * The bin edges are stored as fractions of the thickness domain, empty for uniform binning. The thickness domain is
+         * divided into uniform cells, usually no wider than the narrowest bin, and the table holds the bin at the start of
+         * every cell, such that the bin of a position is found with only few further comparisons.
+         */
+        std::vector<double> z_edges_;
+        std::vector<size_t> z_lookup_;
         FieldType type_{FieldType::NONE};
         FieldFunction<T> function_;
 
+        /*
+         * Depth table of fields only depending on the thickness direction, e.g. constant fields or regions of constant values
+         * along the depth. The region boundaries are held in a flat vector which is searched directly without calling the
+         * field function.
+         */
+        std::vector<double> table_depths_;
+        std::vector<T> table_values_;
+        double table_reference_{};
+
         /*
          * Relevant parameters from the detector model for this field
          */
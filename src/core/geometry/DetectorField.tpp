@@ -22,44 +22,93 @@ namespace allpix {
             return {};
         }
 
+        if(!table_values_.empty()) {
+            return get_field_from_table(pos.z(), extrapolate_z);
+        }
+
         // Calculate the coordinates relative to the reference point:
-        auto x = pos.x() - ref.x();
-        auto y = pos.y() - ref.y();
-        auto z = pos.z();
+        auto dist = ROOT::Math::XYZPoint(pos.x() - ref.x(), pos.y() - ref.y(), pos.z());
 
-        T ret_val;
         if(type_ == FieldType::GRID) {
-            ret_val = get_field_from_grid(ROOT::Math::XYZPoint(x, y, z), extrapolate_z);
+            return get_field_from_grid(dist, extrapolate_z);
+        }
+        return get_field_from_function(dist, extrapolate_z);
+    }
+
+    /**
+     * The positions are shifted relative to the reference point, no replication or flipping is applied.
+     */
+    template <typename T, size_t N>
+    void DetectorField<T, N>::getRelativeTo(const ROOT::Math::XYZPoint* pos,
+                                            const ROOT::Math::XYPoint& ref,
+                                            T* values,
+                                            size_t count,
+                                            const bool extrapolate_z) const {
+        get_dispatch(pos, values, count, extrapolate_z, [&ref](const ROOT::Math::XYZPoint& p, int&, int&) {
+            return ROOT::Math::XYZPoint(p.x() - ref.x(), p.y() - ref.y(), p.z());
+        });
+    }
+
+    /**
+     * The type of the field and its interpolation are only resolved once for all references. This is used to evaluate the
+     * field of a full neighborhood of pixels at the same position.
+     */
+    template <typename T, size_t N>
+    void DetectorField<T, N>::getRelativeTo(const ROOT::Math::XYZPoint& pos,
+                                            const ROOT::Math::XYPoint* refs,
+                                            T* values,
+                                            size_t count,
+                                            const bool extrapolate_z) const {
+        auto relative = [&](size_t i) {
+            return ROOT::Math::XYZPoint(pos.x() - refs[i].x(), pos.y() - refs[i].y(), pos.z());
+        };
+        if(type_ == FieldType::NONE) {
+            std::fill(values, values + count, T{});
+        } else if(!table_values_.empty()) {
+            std::fill(values, values + count, get_field_from_table(pos.z(), extrapolate_z));
+        } else if(type_ != FieldType::GRID) {
+            for(size_t i = 0; i < count; ++i) {
+                values[i] = get_field_from_function(relative(i), extrapolate_z);
+            }
+        } else if(interpolation_ == FieldInterpolation::LINEAR) {
+            for(size_t i = 0; i < count; ++i) {
+                values[i] = get_interpolated_field_from_grid(relative(i), extrapolate_z);
+            }
         } else {
-            // Check if we need to extrapolate along the z axis or if is inside thickness domain:
-            if(extrapolate_z) {
-                z = std::clamp(z, thickness_domain_.first, thickness_domain_.second);
-            } else if(z < thickness_domain_.first || thickness_domain_.second < z) {
-                return {};
+            for(size_t i = 0; i < count; ++i) {
+                values[i] = get_nearest_field_from_grid(relative(i), extrapolate_z);
             }
-
-            // Calculate the field from the configured function:
-            ret_val = function_(ROOT::Math::XYZPoint(x, y, z));
         }
-
-        return ret_val;
     }
 
     // Maps the field indices onto the range of -d/2 < x < d/2, where d is the scale of the field in coordinate x.
     // This means, {x,y,z} = (0,0,0) is in the center of the field.
     template <typename T, size_t N>
     T DetectorField<T, N>::get_field_from_grid(const ROOT::Math::XYZPoint& dist, const bool extrapolate_z) const {
+        if(interpolation_ == FieldInterpolation::LINEAR) {
+            return get_interpolated_field_from_grid(dist, extrapolate_z);
+        }
+        return get_nearest_field_from_grid(dist, extrapolate_z);
+    }
+
+    template <typename T, size_t N>
+    T DetectorField<T, N>::get_nearest_field_from_grid(const ROOT::Math::XYZPoint& dist, const bool extrapolate_z) const {
+        // Look up positions on the mirrored side of a symmetric field on the stored side, and mirror the field
+        auto mirror_x = (mirrored_[0] && dist.x() < 0);
+        auto mirror_y = (mirrored_[1] && dist.y() < 0);
+        if(mirror_x || mirror_y) {
+            auto value = get_nearest_field_from_grid(
+                {mirror_x ? -dist.x() : dist.x(), mirror_y ? -dist.y() : dist.y(), dist.z()}, extrapolate_z);
+            flip_vector_components(value, mirror_x, mirror_y);
+            return value;
+        }
+
         // Compute indices
         // If the number of bins in x or y is 1, the field is assumed to be 2-dimensional and the respective index
         // is forced to zero. This circumvents that the field size in the respective dimension would otherwise be zero
-        auto x_ind = (dimensions_[0] == 1 ? 0
-                                          : static_cast<int>(std::floor(static_cast<double>(dimensions_[0]) *
-                                                                        (dist.x() / (scales_[0] * pixel_size_.x()) + 0.5))));
-        auto y_ind = (dimensions_[1] == 1 ? 0
-                                          : static_cast<int>(std::floor(static_cast<double>(dimensions_[1]) *
-                                                                        (dist.y() / (scales_[1] * pixel_size_.y()) + 0.5))));
-        auto z_ind = static_cast<int>(std::floor(static_cast<double>(dimensions_[2]) * (dist.z() - thickness_domain_.first) /
-                                                 (thickness_domain_.second - thickness_domain_.first)));
+        auto x_ind = (dimensions_[0] == 1 ? 0 : static_cast<int>(std::floor(get_bin_coordinate(0, dist.x()))));
+        auto y_ind = (dimensions_[1] == 1 ? 0 : static_cast<int>(std::floor(get_bin_coordinate(1, dist.y()))));
+        auto z_ind = static_cast<int>(std::floor(get_z_bin_coordinate(dist.z(), false)));
 
         // Check for indices within the field map
         if(x_ind < 0 || x_ind >= static_cast<int>(dimensions_[0]) || y_ind < 0 ||
@@ -81,6 +130,187 @@ namespace allpix {
         return get_impl(tot_ind, std::make_index_sequence<N>{});
     }
 
+    /**
+     * The bin values are assumed to be located at the bin centers. The field is interpolated between the eight bins
+     * surrounding the queried point, while between the outermost bin centers and the field edges the value of the outermost
+     * bin is kept. The field is defined in the same region as for the nearest-bin lookup. Along mirrored axes, the blocked
+     * copy starts with the mirror image of the first bin, such that the field is interpolated across the mirror plane.
+     */
+    template <typename T, size_t N>
+    T DetectorField<T, N>::get_interpolated_field_from_grid(const ROOT::Math::XYZPoint& dist,
+                                                            const bool extrapolate_z) const {
+        // Look up positions on the mirrored side of a symmetric field on the stored side, and mirror the field
+        auto mirror_x = (mirrored_[0] && dist.x() < 0);
+        auto mirror_y = (mirrored_[1] && dist.y() < 0);
+        if(mirror_x || mirror_y) {
+            auto value = get_interpolated_field_from_grid(
+                {mirror_x ? -dist.x() : dist.x(), mirror_y ? -dist.y() : dist.y(), dist.z()}, extrapolate_z);
+            flip_vector_components(value, mirror_x, mirror_y);
+            return value;
+        }
+
+        // Calculate the lower neighboring bin and the fractional distance to it along one axis from the coordinate in units
+        // of bins, or return false if the coordinate is outside the field
+        auto axis = [](double bin_coord, size_t bins, bool extrapolate, size_t& lower, size_t& upper, double& fraction) {
+            auto last = static_cast<double>(bins) - 1.;
+            // Map to the bin center coordinates, the bin N extends from N-0.5 to N+0.5
+            auto coord = bin_coord - 0.5;
+            if(extrapolate) {
+                coord = std::clamp(coord, 0., last);
+            } else if(coord < -0.5 || coord >= last + 0.5) {
+                return false;
+            }
+            coord = std::clamp(coord, 0., last);
+            auto base = std::floor(coord);
+            lower = static_cast<size_t>(base);
+            upper = std::min(lower + 1, bins - 1);
+            fraction = coord - base;
+            return true;
+        };
+
+        // If the number of bins in x or y is 1, the field is assumed to be 2-dimensional and constant along that axis
+        std::array<size_t, 3> lower{};
+        std::array<size_t, 3> upper{};
+        std::array<double, 3> fraction{};
+        if(!axis(get_bin_coordinate(0, dist.x()) + (mirrored_[0] ? 1. : 0.),
+                 blocked_dimensions_[0],
+                 dimensions_[0] == 1,
+                 lower[0],
+                 upper[0],
+                 fraction[0]) ||
+           !axis(get_bin_coordinate(1, dist.y()) + (mirrored_[1] ? 1. : 0.),
+                 blocked_dimensions_[1],
+                 dimensions_[1] == 1,
+                 lower[1],
+                 upper[1],
+                 fraction[1]) ||
+           !axis(get_z_bin_coordinate(dist.z(), true),
+                 blocked_dimensions_[2],
+                 extrapolate_z,
+                 lower[2],
+                 upper[2],
+                 fraction[2])) {
+            return {};
+        }
+
+        return interpolate_cell(get_cell_bins(lower, upper), fraction);
+    }
+
+    /**
+     * The stored grid of a mirrored axis starts at the center of the field and covers half of its extent.
+     */
+    template <typename T, size_t N> double DetectorField<T, N>::get_bin_coordinate(size_t axis, double dist) const {
+        auto width = scales_[axis] * (axis == 0 ? pixel_size_.x() : pixel_size_.y());
+        auto bins = static_cast<double>(dimensions_[axis]);
+        return (mirrored_[axis] ? bins * dist / (0.5 * width) : bins * (dist / width + 0.5));
+    }
+
+    /**
+     * With non-uniform binning, the coordinate between the bin edges is linear within every bin. Neighboring bin centers
+     * are however separated by half of each of the two bins, the coordinate for the interpolation is therefore linear
+     * between neighboring bin centers instead, and between the outermost bin centers and the field edges.
+     */
+    template <typename T, size_t N> double DetectorField<T, N>::get_z_bin_coordinate(double z, bool centered) const {
+        auto position = (z - thickness_domain_.first) / (thickness_domain_.second - thickness_domain_.first);
+        if(z_edges_.empty()) {
+            return static_cast<double>(dimensions_[2]) * position;
+        }
+
+        // Find the bin from the lookup table, positions outside of the grid are assigned to the outermost bins
+        auto cells = z_lookup_.size();
+        auto cell = std::min(static_cast<size_t>(std::max(position, 0.) * static_cast<double>(cells)), cells - 1);
+        auto bin = z_lookup_[cell];
+        while(bin + 1 < dimensions_[2] && z_edges_[bin + 1] <= position) {
+            ++bin;
+        }
+
+        auto lower = z_edges_[bin];
+        auto upper = z_edges_[bin + 1];
+        auto coordinate = static_cast<double>(bin);
+        if(!centered) {
+            return coordinate + (position - lower) / (upper - lower);
+        }
+        auto center = 0.5 * (lower + upper);
+        if(position < center) {
+            if(bin == 0) {
+                return 0.5 * (position - lower) / (center - lower);
+            }
+            auto previous = 0.5 * (z_edges_[bin - 1] + lower);
+            return coordinate - 0.5 + (position - previous) / (center - previous);
+        }
+        if(bin + 1 == dimensions_[2]) {
+            return coordinate + 0.5 + 0.5 * (position - center) / (upper - center);
+        }
+        auto next = 0.5 * (upper + z_edges_[bin + 2]);
+        return coordinate + 0.5 + (position - center) / (next - center);
+    }
+
+    template <typename T, size_t N>
+    std::array<size_t, 8> DetectorField<T, N>::get_cell_bins(const std::array<size_t, 3>& lower,
+                                                             const std::array<size_t, 3>& upper) const {
+        std::array<size_t, 8> bins{};
+        for(size_t corner = 0; corner < 8; ++corner) {
+            auto bin = [&](size_t d) { return (((corner >> d) & 1u) != 0 ? upper[d] : lower[d]); };
+            bins[corner] = get_blocked_index(bin(0), bin(1), bin(2));
+        }
+        return bins;
+    }
+
+    template <typename T, size_t N>
+    T DetectorField<T, N>::interpolate_cell(const std::array<size_t, 8>& bins, const std::array<double, 3>& fraction) const {
+        // Accumulate the weighted values of the eight neighboring bins
+        std::array<double, N> values{};
+        for(size_t corner = 0; corner < 8; ++corner) {
+            double weight = 1.;
+            for(size_t d = 0; d < 3; ++d) {
+                weight *= (((corner >> d) & 1u) != 0 ? fraction[d] : 1. - fraction[d]);
+            }
+            if(weight == 0.) {
+                continue;
+            }
+
+            if(single_blocked_field_) {
+                const auto* blocked = local_grid(single_blocked_field_) + bins[corner];
+                for(size_t i = 0; i < N; ++i) {
+                    values[i] += weight * static_cast<double>(blocked[i]);
+                }
+            } else {
+                const auto* blocked = local_grid(blocked_field_) + bins[corner];
+                for(size_t i = 0; i < N; ++i) {
+                    values[i] += weight * blocked[i];
+                }
+            }
+        }
+
+        return get_impl(values, std::make_index_sequence<N>{});
+    }
+
+    template <typename T, size_t N> void DetectorField<T, N>::prefetch_bin(size_t index) const {
+#if defined(__GNUC__) || defined(__clang__)
+        if(single_blocked_field_) {
+            __builtin_prefetch(local_grid(single_blocked_field_) + index);
+        } else if(blocked_field_) {
+            __builtin_prefetch(local_grid(blocked_field_) + index);
+        } else if(single_field_) {
+            __builtin_prefetch(local_grid(single_field_) + index);
+        } else if(field_) {
+            __builtin_prefetch(local_grid(field_) + index);
+        }
+#else
+        (void)index;
+#endif
+    }
+
+    /**
+     * The blocked field consists of tiles holding tile_size_^3 bins each, both the tiles and the bins within a tile are
+     * stored in x-major order.
+     */
+    template <typename T, size_t N> size_t DetectorField<T, N>::get_blocked_index(size_t x, size_t y, size_t z) const {
+        auto tile = ((x / tile_size_) * tiles_[1] + y / tile_size_) * tiles_[2] + z / tile_size_;
+        auto bin = ((x % tile_size_) * tile_size_ + y % tile_size_) * tile_size_ + z % tile_size_;
+        return (tile * tile_size_ * tile_size_ * tile_size_ + bin) * N;
+    }
+
     /**
      * The field is replicated for all pixels and uses flipping at each boundary (edge effects are currently not modeled.
      * Outside of the sensor the field is strictly zero by definition.
@@ -93,15 +323,216 @@ namespace allpix {
             return {};
         }
 
+        // Fields given by a depth table do not depend on the position within the replica
+        if(!table_values_.empty()) {
+            return get_field_from_table(pos.z(), extrapolate_z);
+        }
+
+        int replica_x = 0, replica_y = 0;
+        auto dist = get_replica_position(pos, replica_x, replica_y);
+
+        // Compute using the grid or a function depending on the setting
+        T ret_val;
+        if(type_ == FieldType::GRID) {
+            ret_val = get_field_from_grid(dist, extrapolate_z);
+        } else {
+            ret_val = get_field_from_function(dist, extrapolate_z);
+        }
+
+        // Flip vector if necessary
+        flip_vector_components(ret_val, replica_x % 2, replica_y % 2);
+        return ret_val;
+    }
+
+    /**
+     * The field type and lookup method are only checked once for the full set of positions, the values are identical to
+     * calling the single-position lookup for every one of them.
+     */
+    template <typename T, size_t N>
+    void DetectorField<T, N>::get(const ROOT::Math::XYZPoint* pos, T* values, size_t count, const bool extrapolate_z) const {
+        get_dispatch(pos, values, count, extrapolate_z, [this](const ROOT::Math::XYZPoint& p, int& rx, int& ry) {
+            return get_replica_position(p, rx, ry);
+        });
+    }
+
+    /**
+     * Only grid fields are looked up through the cursor, all other fields are evaluated directly. The grid coordinates of a
+     * position are continuous bin numbers, which are shifted by half a bin for the interpolation such that the cell between
+     * the bin centers N and N+1 extends from N to N+1. Cells at the edges of the grid, where the interpolation is clamped or
+     * extrapolated, are not remembered. When entering a new cell, the bins next to it in the direction of the motion since
+     * the previous lookup are prefetched, as they are likely required by one of the following lookups.
+     */
+    template <typename T, size_t N>
+    T DetectorField<T, N>::get(const ROOT::Math::XYZPoint& pos, FieldCursor& cursor, const bool extrapolate_z) const {
+        if(type_ != FieldType::GRID || !table_values_.empty()) {
+            return get(pos, extrapolate_z);
+        }
+        if(cursor.field != this) {
+            cursor = FieldCursor();
+            cursor.field = this;
+            cursor.last_coordinates.fill(std::numeric_limits<double>::quiet_NaN());
+        }
+
+        // Find the replica again only when leaving the replica of the previous lookup
+        auto x = pos.x() + offset_[0];
+        auto y = pos.y() + offset_[1];
+        auto& bounds = cursor.replica_bounds;
+        if(x < bounds[0] || x >= bounds[1] || y < bounds[2] || y >= bounds[3]) {
+            get_replica_position(pos, cursor.replica_x, cursor.replica_y);
+            auto width_x = scales_[0] * pixel_size_.x();
+            auto width_y = scales_[1] * pixel_size_.y();
+            bounds[0] = cursor.replica_x * width_x - 0.5 * pixel_size_.x();
+            bounds[1] = bounds[0] + width_x;
+            bounds[2] = cursor.replica_y * width_y - 0.5 * pixel_size_.y();
+            bounds[3] = bounds[2] + width_y;
+        }
+        x -= ((cursor.replica_x + 0.5) * scales_[0] - 0.5) * pixel_size_.x();
+        y -= ((cursor.replica_y + 0.5) * scales_[1] - 0.5) * pixel_size_.y();
+        if((cursor.replica_x % 2) == 1) {
+            x *= -1;
+        }
+        if((cursor.replica_y % 2) == 1) {
+            y *= -1;
+        }
+        ROOT::Math::XYZPoint dist(x, y, pos.z());
+
+        // Move positions on the mirrored side of a symmetric field to the stored side
+        auto mirror_x = (mirrored_[0] && x < 0);
+        auto mirror_y = (mirrored_[1] && y < 0);
+        if(mirror_x || mirror_y) {
+            dist = ROOT::Math::XYZPoint(mirror_x ? -x : x, mirror_y ? -y : y, pos.z());
+        }
+
+        // Compute the grid coordinates, fields with a single bin along x or y are constant along that axis
+        auto linear = (interpolation_ == FieldInterpolation::LINEAR);
+        const auto& bins = (linear ? blocked_dimensions_ : dimensions_);
+        std::array<double, 3> coordinates{
+            get_bin_coordinate(0, dist.x()),
+            get_bin_coordinate(1, dist.y()),
+            get_z_bin_coordinate(pos.z(), linear)};
+        for(size_t d = 0; d < 3; ++d) {
+            if(d < 2 && dimensions_[d] == 1) {
+                coordinates[d] = 0.;
+            } else if(linear) {
+                coordinates[d] += (d < 2 && mirrored_[d] ? 0.5 : -0.5);
+            }
+        }
+
+        auto inside = [&](size_t d) {
+            return coordinates[d] >= cursor.cell_base[d] && coordinates[d] < cursor.cell_base[d] + 1.;
+        };
+        T value;
+        if(!cursor.cell_valid || !inside(0) || !inside(1) || !inside(2)) {
+            // Find the cell of the position, falling back to the regular lookup outside of the interior cells
+            std::array<size_t, 3> lower{};
+            std::array<size_t, 3> upper{};
+            cursor.cell_valid = true;
+            for(size_t d = 0; d < 3; ++d) {
+                // The interpolation requires the upper bin of the cell to exist, except along constant axes
+                auto last_base = static_cast<double>(bins[d]) - (linear ? 2. : 1.);
+                auto constant = (d < 2 && dimensions_[d] == 1);
+                cursor.cell_base[d] = std::floor(coordinates[d]);
+                if(!constant && (coordinates[d] < 0. || cursor.cell_base[d] > last_base)) {
+                    cursor.cell_valid = false;
+                    break;
+                }
+                lower[d] = static_cast<size_t>(cursor.cell_base[d]);
+                upper[d] = std::min(lower[d] + 1, bins[d] - 1);
+            }
+            if(!cursor.cell_valid) {
+                value = get_field_from_grid(dist, extrapolate_z);
+                flip_vector_components(value, mirror_x, mirror_y);
+                flip_vector_components(value, cursor.replica_x % 2, cursor.replica_y % 2);
+                cursor.last_coordinates = coordinates;
+                return value;
+            }
+
+            if(linear) {
+                cursor.cell_bins = get_cell_bins(lower, upper);
+            } else {
+                cursor.cell_bins[0] = (lower[0] * dimensions_[1] + lower[1]) * dimensions_[2] * N + lower[2] * N;
+            }
+
+            // Prefetch the bins of the neighboring cell along the axis with the largest motion since the previous lookup
+            size_t axis = 3;
+            double motion = 0.;
+            for(size_t d = 0; d < 3; ++d) {
+                auto delta = std::fabs(coordinates[d] - cursor.last_coordinates[d]);
+                if(delta > motion) {
+                    axis = d;
+                    motion = delta;
+                }
+            }
+            if(axis < 3) {
+                auto next = lower;
+                auto forward = (coordinates[axis] > cursor.last_coordinates[axis]);
+                if(forward ? upper[axis] + 1 < bins[axis] : lower[axis] > 0) {
+                    next[axis] = (forward ? upper[axis] + 1 : lower[axis] - 1);
+                    prefetch_bin(linear ? get_blocked_index(next[0], next[1], next[2])
+                                        : (next[0] * dimensions_[1] + next[1]) * dimensions_[2] * N + next[2] * N);
+                }
+            }
+        }
+        cursor.last_coordinates = coordinates;
+
+        if(linear) {
+            value = interpolate_cell(cursor.cell_bins,
+                                     {coordinates[0] - cursor.cell_base[0],
+                                      coordinates[1] - cursor.cell_base[1],
+                                      coordinates[2] - cursor.cell_base[2]});
+        } else {
+            value = get_impl(cursor.cell_bins[0], std::make_index_sequence<N>{});
+        }
+        flip_vector_components(value, mirror_x, mirror_y);
+        flip_vector_components(value, cursor.replica_x % 2, cursor.replica_y % 2);
+        return value;
+    }
+
+    template <typename T, size_t N>
+    template <typename Mapping>
+    void DetectorField<T, N>::get_dispatch(
+        const ROOT::Math::XYZPoint* pos, T* values, size_t count, const bool extrapolate_z, Mapping mapping) const {
+        if(type_ == FieldType::NONE) {
+            std::fill(values, values + count, T{});
+        } else if(!table_values_.empty()) {
+            for(size_t i = 0; i < count; ++i) {
+                values[i] = get_field_from_table(pos[i].z(), extrapolate_z);
+            }
+        } else if(type_ != FieldType::GRID) {
+            get_batch(
+                pos, values, count, mapping, [&](const auto& p) { return get_field_from_function(p, extrapolate_z); });
+        } else if(interpolation_ == FieldInterpolation::LINEAR) {
+            get_batch(pos, values, count, mapping, [&](const auto& p) {
+                return get_interpolated_field_from_grid(p, extrapolate_z);
+            });
+        } else {
+            get_batch(
+                pos, values, count, mapping, [&](const auto& p) { return get_nearest_field_from_grid(p, extrapolate_z); });
+        }
+    }
+
+    template <typename T, size_t N>
+    template <typename Mapping, typename Lookup>
+    void DetectorField<T, N>::get_batch(
+        const ROOT::Math::XYZPoint* pos, T* values, size_t count, Mapping mapping, Lookup lookup) const {
+        for(size_t i = 0; i < count; ++i) {
+            int replica_x = 0, replica_y = 0;
+            values[i] = lookup(mapping(pos[i], replica_x, replica_y));
+            flip_vector_components(values[i], replica_x % 2, replica_y % 2);
+        }
+    }
+
+    template <typename T, size_t N>
+    ROOT::Math::XYZPoint
+    DetectorField<T, N>::get_replica_position(const ROOT::Math::XYZPoint& pos, int& replica_x, int& replica_y) const {
         // Shift the coordinates by the offset configured for the field:
         auto x = pos.x() + offset_[0];
         auto y = pos.y() + offset_[1];
-        auto z = pos.z();
 
         // Compute corresponding field replica coordinates:
         // WARNING This relies on the origin of the local coordinate system
-        auto replica_x = static_cast<int>(std::floor((x + 0.5 * pixel_size_.x()) / (scales_[0] * pixel_size_.x())));
-        auto replica_y = static_cast<int>(std::floor((y + 0.5 * pixel_size_.y()) / (scales_[1] * pixel_size_.y())));
+        replica_x = static_cast<int>(std::floor((x + 0.5 * pixel_size_.x()) / (scales_[0] * pixel_size_.x())));
+        replica_y = static_cast<int>(std::floor((y + 0.5 * pixel_size_.y()) / (scales_[1] * pixel_size_.y())));
 
         // Convert to the replica frame:
         x -= ((replica_x + 0.5) * scales_[0] - 0.5) * pixel_size_.x();
@@ -115,25 +546,46 @@ namespace allpix {
             y *= -1;
         }
 
-        // Compute using the grid or a function depending on the setting
-        T ret_val;
-        if(type_ == FieldType::GRID) {
-            ret_val = get_field_from_grid(ROOT::Math::XYZPoint(x, y, z), extrapolate_z);
-        } else {
-            // Check if we need to extrapolate along the z axis or if is inside thickness domain:
-            if(extrapolate_z) {
-                z = std::clamp(z, thickness_domain_.first, thickness_domain_.second);
-            } else if(z < thickness_domain_.first || thickness_domain_.second < z) {
-                return {};
-            }
+        return {x, y, pos.z()};
+    }
+
+    template <typename T, size_t N>
+    T DetectorField<T, N>::get_field_from_function(const ROOT::Math::XYZPoint& pos, const bool extrapolate_z) const {
+        auto z = pos.z();
 
-            // Calculate the field from the configured function:
-            ret_val = function_(ROOT::Math::XYZPoint(x, y, z));
+        // Check if we need to extrapolate along the z axis or if is inside thickness domain:
+        if(extrapolate_z) {
+            z = std::clamp(z, thickness_domain_.first, thickness_domain_.second);
+        } else if(z < thickness_domain_.first || thickness_domain_.second < z) {
+            return {};
         }
 
-        // Flip vector if necessary
-        flip_vector_components(ret_val, replica_x % 2, replica_y % 2);
-        return ret_val;
+        // Calculate the field from the configured function:
+        return function_(ROOT::Math::XYZPoint(pos.x(), pos.y(), z));
+    }
+
+    /**
+     * The region boundaries are searched with a binary search on the flat vector, a single region is returned directly.
+     */
+    template <typename T, size_t N>
+    T DetectorField<T, N>::get_field_from_table(double z, const bool extrapolate_z) const {
+        // Check if we need to extrapolate along the z axis or if is inside thickness domain:
+        if(extrapolate_z) {
+            z = std::clamp(z, thickness_domain_.first, thickness_domain_.second);
+        } else if(z < thickness_domain_.first || thickness_domain_.second < z) {
+            return {};
+        }
+
+        if(table_values_.size() == 1) {
+            return table_values_.front();
+        }
+
+        // The first region with a boundary not less than the depth contains the position
+        auto region = std::lower_bound(table_depths_.begin(), table_depths_.end(), table_reference_ - z);
+        if(region == table_depths_.end()) {
+            return table_values_.back();
+        }
+        return table_values_[static_cast<size_t>(region - table_depths_.begin())];
     }
 
     /**
@@ -144,7 +596,16 @@ namespace allpix {
     template <typename T, size_t N>
     template <std::size_t... I>
     auto DetectorField<T, N>::get_impl(size_t offset, std::index_sequence<I...>) const {
-        return T{(*field_)[offset + I]...};
+        if(single_field_) {
+            return T{static_cast<double>(local_grid(single_field_)[offset + I])...};
+        }
+        return T{local_grid(field_)[offset + I]...};
+    }
+
+    template <typename T, size_t N>
+    template <std::size_t... I>
+    auto DetectorField<T, N>::get_impl(const std::array<double, N>& values, std::index_sequence<I...>) {
+        return T{values[I]...};
     }
 
     /**
@@ -153,18 +614,24 @@ namespace allpix {
     template <typename T, size_t N> FieldType DetectorField<T, N>::getType() const { return type_; }
 
     /**
-     * @throws std::invalid_argument If the field dimensions are incorrect or the thickness domain is outside the sensor
+     * @throws std::invalid_argument If the field dimensions or bin edges are incorrect or the thickness domain is outside
+     * the sensor
      */
     template <typename T, size_t N>
-    void DetectorField<T, N>::setGrid(std::shared_ptr<std::vector<double>> field, // NOLINT
+    void DetectorField<T, N>::setGrid(std::shared_ptr<const double> field, // NOLINT
+                                      size_t entries,
                                       std::array<size_t, 3> dimensions,
                                       std::array<double, 2> scales,
                                       std::array<double, 2> offset,
-                                      std::pair<double, double> thickness_domain) {
+                                      std::pair<double, double> thickness_domain,
+                                      FieldInterpolation interpolation,
+                                      FieldPrecision precision,
+                                      FieldSymmetry symmetry,
+                                      std::vector<double> z_edges) {
         if(!model_initialized_) {
             throw std::invalid_argument("field not initialized with detector model parameters");
         }
-        if(dimensions[0] * dimensions[1] * dimensions[2] * N != field->size()) {
+        if(!field || dimensions[0] * dimensions[1] * dimensions[2] * N != entries) {
             throw std::invalid_argument("field does not match the given dimensions");
         }
         if(thickness_domain.first + 1e-9 < sensor_center_.z() - sensor_size_.z() / 2.0 ||
@@ -174,14 +641,126 @@ namespace allpix {
         if(thickness_domain.first >= thickness_domain.second) {
             throw std::invalid_argument("end of thickness domain is before begin");
         }
+        std::array<bool, 2> mirrored{symmetry == FieldSymmetry::MIRROR_X || symmetry == FieldSymmetry::MIRROR_XY,
+                                     symmetry == FieldSymmetry::MIRROR_Y || symmetry == FieldSymmetry::MIRROR_XY};
+        if((mirrored[0] && dimensions[0] == 1) || (mirrored[1] && dimensions[1] == 1)) {
+            throw std::invalid_argument("field with a single bin cannot be mirrored along that axis");
+        }
+        if(!z_edges.empty()) {
+            if(z_edges.size() != dimensions[2] + 1) {
+                throw std::invalid_argument("number of bin edges in z does not match the field dimensions");
+            }
+            for(size_t i = 0; i + 1 < z_edges.size(); ++i) {
+                if(!(z_edges[i] < z_edges[i + 1])) {
+                    throw std::invalid_argument("bin edges in z are not in ascending order");
+                }
+            }
+        }
 
-        field_ = std::move(field);
+        // Share the grid with all other fields using identical values
+        field_ = FieldStore::share(std::move(field), entries);
         dimensions_ = dimensions;
         scales_ = scales;
         offset_ = offset;
+        mirrored_ = mirrored;
 
         thickness_domain_ = std::move(thickness_domain);
+        table_depths_.clear();
+        table_values_.clear();
         type_ = FieldType::GRID;
+
+        // Store the bin edges in z as fractions of the thickness domain, uniform edges are looked up without the table
+        z_edges_.clear();
+        z_lookup_.clear();
+        if(!z_edges.empty()) {
+            auto first = z_edges.front();
+            auto range = z_edges.back() - first;
+            auto narrowest = range;
+            auto widest = 0.;
+            for(size_t i = 0; i + 1 < z_edges.size(); ++i) {
+                narrowest = std::min(narrowest, z_edges[i + 1] - z_edges[i]);
+                widest = std::max(widest, z_edges[i + 1] - z_edges[i]);
+            }
+            if(widest - narrowest > 1e-9 * range) {
+                for(auto edge : z_edges) {
+                    z_edges_.push_back((edge - first) / range);
+                }
+                z_edges_.back() = 1.;
+
+                // Cells no wider than the narrowest bin contain at most one bin edge, the table size is limited
+                auto cells = static_cast<size_t>(std::ceil(std::min(range / narrowest, 65536.)));
+                z_lookup_.resize(std::max(cells, dimensions_[2]));
+                size_t bin = 0;
+                for(size_t cell = 0; cell < z_lookup_.size(); ++cell) {
+                    auto start = static_cast<double>(cell) / static_cast<double>(z_lookup_.size());
+                    while(bin + 1 < dimensions_[2] && z_edges_[bin + 1] <= start) {
+                        ++bin;
+                    }
+                    z_lookup_[cell] = bin;
+                }
+            }
+        }
+
+        // Store a blocked copy of the field for the interpolation, the original layout is kept since it might be shared
+        interpolation_ = interpolation;
+        blocked_field_.reset();
+        single_field_.reset();
+        single_blocked_field_.reset();
+        // Along mirrored axes, the blocked copy starts with the mirror image of the first bin
+        blocked_dimensions_ = {
+            dimensions_[0] + (mirrored_[0] ? 1 : 0), dimensions_[1] + (mirrored_[1] ? 1 : 0), dimensions_[2]};
+        if(interpolation_ == FieldInterpolation::LINEAR) {
+            for(size_t d = 0; d < 3; ++d) {
+                tiles_[d] = (blocked_dimensions_[d] + tile_size_ - 1) / tile_size_;
+            }
+            std::vector<double> blocked_field(tiles_[0] * tiles_[1] * tiles_[2] * tile_size_ * tile_size_ * tile_size_ * N);
+            for(size_t x = 0; x < blocked_dimensions_[0]; ++x) {
+                auto mirror_x = (mirrored_[0] && x == 0);
+                auto source_x = (mirrored_[0] && x > 0 ? x - 1 : x);
+                for(size_t y = 0; y < blocked_dimensions_[1]; ++y) {
+                    auto mirror_y = (mirrored_[1] && y == 0);
+                    auto source_y = (mirrored_[1] && y > 0 ? y - 1 : y);
+                    for(size_t z = 0; z < blocked_dimensions_[2]; ++z) {
+                        auto blocked_index = get_blocked_index(x, y, z);
+                        auto index = ((source_x * dimensions_[1] + source_y) * dimensions_[2] + z) * N;
+                        for(size_t i = 0; i < N; ++i) {
+                            // The component of a vector field along the mirrored axis changes its sign
+                            auto flip = (N == 3 && ((mirror_x && i == 0) || (mirror_y && i == 1)));
+                            blocked_field[blocked_index + i] = (flip ? -1. : 1.) * field_.get()[index + i];
+                        }
+                    }
+                }
+            }
+
+            // The blocked copy is shared as well, such that identical grids are only blocked once in memory
+            if(precision == FieldPrecision::SINGLE) {
+                single_blocked_field_ = FieldStore::share(std::vector<float>(blocked_field.begin(), blocked_field.end()));
+            } else {
+                blocked_field_ = FieldStore::share(std::move(blocked_field));
+            }
+        } else if(precision == FieldPrecision::SINGLE) {
+            single_field_ = FieldStore::share(std::vector<float>(field_.get(), field_.get() + entries));
+        }
+
+        // Only keep the grid used for the lookup in single precision
+        if(precision == FieldPrecision::SINGLE) {
+            field_.reset();
+        }
+
+        // Place a copy of the grid used for the lookup on every NUMA node, such that pinned workers only read local memory
+        replicas_.clear();
+        if(numa::replication_enabled()) {
+            auto blocked_entries = tiles_[0] * tiles_[1] * tiles_[2] * tile_size_ * tile_size_ * tile_size_ * N;
+            if(single_blocked_field_) {
+                replicas_ = FieldStore::replicate(single_blocked_field_, blocked_entries);
+            } else if(blocked_field_) {
+                replicas_ = FieldStore::replicate(blocked_field_, blocked_entries);
+            } else if(single_field_) {
+                replicas_ = FieldStore::replicate(single_field_, entries);
+            } else {
+                replicas_ = FieldStore::replicate(field_, entries);
+            }
+        }
     }
 
     template <typename T, size_t N>
@@ -189,6 +768,102 @@ namespace allpix {
     DetectorField<T, N>::setFunction(FieldFunction<T> function, std::pair<double, double> thickness_domain, FieldType type) {
         thickness_domain_ = std::move(thickness_domain);
         function_ = std::move(function);
+        table_depths_.clear();
+        table_values_.clear();
+        type_ = type;
+    }
+
+    /**
+     * @throws std::invalid_argument If the table is empty, the number of boundaries and values differs or the boundaries
+     * are not in ascending order
+     */
+    template <typename T, size_t N>
+    void DetectorField<T, N>::setDepthTable(std::vector<double> depths,
+                                            std::vector<T> values,
+                                            double reference,
+                                            std::pair<double, double> thickness_domain,
+                                            FieldType type) {
+        if(values.empty() || depths.size() != values.size()) {
+            throw std::invalid_argument("depth table requires one boundary for every region");
+        }
+        if(!std::is_sorted(depths.begin(), depths.end())) {
+            throw std::invalid_argument("region boundaries of depth table are not in ascending order");
+        }
+
+        thickness_domain_ = std::move(thickness_domain);
+        table_depths_ = std::move(depths);
+        table_values_ = std::move(values);
+        table_reference_ = reference;
+        function_ = nullptr;
         type_ = type;
     }
+
+    /**
+     * The values of this field are looked up at the bin centers, which yields the stored bin values for both interpolation
+     * methods. The derived grid is registered with the \ref FieldStore and replicated like any other grid.
+     *
+     * @throws std::invalid_argument If this field is not given by a grid
+     */
+    template <typename T, size_t N>
+    DetectorField<T, N>
+    DetectorField<T, N>::deriveGrid(const std::function<T(const ROOT::Math::XYZPoint&, const T&)>& function) const {
+        if(type_ != FieldType::GRID) {
+            throw std::invalid_argument("only fields given by a grid can be derived");
+        }
+
+        // Position of a bin center within the stored part of the grid along x or y, measured from the field center
+        auto bin_center = [&](size_t axis, size_t bin) {
+            auto width = scales_[axis] * (axis == 0 ? pixel_size_.x() : pixel_size_.y());
+            auto bins = static_cast<double>(dimensions_[axis]);
+            auto position = (static_cast<double>(bin) + 0.5) / bins;
+            return (mirrored_[axis] ? 0.5 * width * position : width * (position - 0.5));
+        };
+        auto thickness = thickness_domain_.second - thickness_domain_.first;
+
+        auto entries = dimensions_[0] * dimensions_[1] * dimensions_[2] * N;
+        auto values = std::make_shared<std::vector<double>>(entries);
+        for(size_t x = 0; x < dimensions_[0]; ++x) {
+            auto dist_x = bin_center(0, x);
+            for(size_t y = 0; y < dimensions_[1]; ++y) {
+                auto dist_y = bin_center(1, y);
+                for(size_t z = 0; z < dimensions_[2]; ++z) {
+                    auto fraction = (z_edges_.empty() ? (static_cast<double>(z) + 0.5) / static_cast<double>(dimensions_[2])
+                                                      : 0.5 * (z_edges_[z] + z_edges_[z + 1]));
+                    ROOT::Math::XYZPoint dist(dist_x, dist_y, thickness_domain_.first + fraction * thickness);
+
+                    // Convert from the replica at the origin to local coordinates
+                    ROOT::Math::XYZPoint local_pos(dist.x() + (0.5 * scales_[0] - 0.5) * pixel_size_.x() - offset_[0],
+                                                   dist.y() + (0.5 * scales_[1] - 0.5) * pixel_size_.y() - offset_[1],
+                                                   dist.z());
+                    auto value = function(local_pos, get_field_from_grid(dist, true));
+
+                    auto index = ((x * dimensions_[1] + y) * dimensions_[2] + z) * N;
+                    if constexpr(N == 1) {
+                        (*values)[index] = value;
+                    } else {
+                        (*values)[index] = value.x();
+                        (*values)[index + 1] = value.y();
+                        (*values)[index + 2] = value.z();
+                    }
+                }
+            }
+        }
+
+        DetectorField<T, N> derived;
+        derived.set_model_parameters(sensor_center_, sensor_size_, pixel_size_);
+        auto symmetry = (mirrored_[0] ? (mirrored_[1] ? FieldSymmetry::MIRROR_XY : FieldSymmetry::MIRROR_X)
+                                      : (mirrored_[1] ? FieldSymmetry::MIRROR_Y : FieldSymmetry::NONE));
+        auto precision = (single_field_ || single_blocked_field_ ? FieldPrecision::SINGLE : FieldPrecision::DOUBLE);
+        derived.setGrid(std::shared_ptr<const double>(values, values->data()),
+                        entries,
+                        dimensions_,
+                        scales_,
+                        offset_,
+                        thickness_domain_,
+                        interpolation_,
+                        precision,
+                        symmetry,
+                        z_edges_);
+        return derived;
+    }
 } // namespace allpix
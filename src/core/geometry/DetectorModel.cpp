@@ -205,10 +205,11 @@ bool DetectorModel::isWithinPixelGrid(const Pixel::Index& pixel_index) const {
 }
 
 /**
- * The definition of the pixel grid size is determined by the detector model
+ * The definition of the pixel grid size is determined by the detector model. Negative coordinates wrap around to values
+ * larger than any grid size when converted to unsigned integers, such that each coordinate only requires one comparison.
  */
 bool DetectorModel::isWithinPixelGrid(const int x, const int y) const {
-    return !(x < 0 || x >= static_cast<int>(number_of_pixels_.x()) || y < 0 || y >= static_cast<int>(number_of_pixels_.y()));
+    return static_cast<unsigned int>(x) < number_of_pixels_.x() && static_cast<unsigned int>(y) < number_of_pixels_.y();
 }
 
 ROOT::Math::XYZPoint DetectorModel::getPixelCenter(unsigned int x, unsigned int y) const {
@@ -220,6 +221,11 @@ ROOT::Math::XYZPoint DetectorModel::getPixelCenter(unsigned int x, unsigned int
     return {local_x, local_y, local_z};
 }
 
+/**
+ * The pixel centers are located at multiples of the pitch, the index is found by rounding the position in units of the pitch
+ * to the nearest integer. Positions exactly at the edge between two pixels are assigned to the pixel further away from the
+ * origin of the grid, as defined by std::round.
+ */
 std::pair<int, int> DetectorModel::getPixelIndex(const ROOT::Math::XYZPoint& position) const {
     auto pixel_x = static_cast<int>(std::round(position.x() / pixel_size_.x()));
     auto pixel_y = static_cast<int>(std::round(position.y() / pixel_size_.y()));
@@ -0,0 +1,228 @@
+/**
+ * @file
+ * @brief Implementation of the store sharing identical field grids
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "FieldStore.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include "core/utils/log.h"
+#include "core/utils/numa.h"
+
+using namespace allpix;
+
+namespace {
+    // Size of transparent huge pages, grids smaller than this are not placed on huge pages
+    constexpr size_t huge_page_size = size_t(2) << 20;
+
+    size_t round_up(size_t value, size_t multiple) { return (value + multiple - 1) / multiple * multiple; }
+
+#ifdef __linux__
+    /**
+     * @brief Size of the explicit huge pages of the default pool as given in /proc/meminfo
+     */
+    size_t explicit_huge_page_size() {
+        std::ifstream file("/proc/meminfo");
+        std::string line;
+        while(std::getline(file, line)) {
+            if(line.rfind("Hugepagesize:", 0) == 0) {
+                try {
+                    return std::stoul(line.substr(line.find(':') + 1)) << 10;
+                } catch(std::logic_error&) {
+                    break;
+                }
+            }
+        }
+        return huge_page_size;
+    }
+
+    /**
+     * @brief Check if transparent huge pages can be requested, i.e. if they are not disabled in the kernel
+     */
+    bool transparent_huge_pages_available() {
+        std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+        std::string modes;
+        std::getline(file, modes);
+        return file.good() && modes.find("[never]") == std::string::npos;
+    }
+#endif
+} // namespace
+
+FieldStore& FieldStore::get_instance() {
+    static FieldStore instance;
+    return instance;
+}
+
+/**
+ * Hashing the raw bytes is sufficient to find candidates, which are compared byte by byte before being shared. Grids which
+ * are not used anymore are removed from the store when a grid with the same hash is registered.
+ */
+std::shared_ptr<const void>
+FieldStore::share_grid(const std::shared_ptr<const void>& grid, size_t bytes, size_t value_size) {
+    auto hash = std::hash<std::string_view>()(std::string_view(static_cast<const char*>(grid.get()), bytes));
+    auto key = std::make_pair(hash, value_size);
+
+    std::lock_guard<std::mutex> lock{mutex_};
+    auto range = grids_.equal_range(key);
+    for(auto iter = range.first; iter != range.second;) {
+        auto known = iter->second.first.lock();
+        if(known == nullptr) {
+            iter = grids_.erase(iter);
+            continue;
+        }
+        if(known == grid) {
+            return grid;
+        }
+        if(iter->second.second == bytes && std::memcmp(known.get(), grid.get(), bytes) == 0) {
+            saved_bytes_ += bytes;
+            LOG(INFO) << "Sharing identical field grid of " << (bytes >> 20) << " MB, saved " << (saved_bytes_ >> 20)
+                      << " MB of " << ((registered_bytes_ + saved_bytes_) >> 20) << " MB of field grids in total";
+            return known;
+        }
+        ++iter;
+    }
+
+    // Copy the grid to huge pages if requested, the memory it has been registered with is released by the caller
+    auto registered = grid;
+    if(huge_pages_ != HugePages::NONE) {
+        auto obtained = huge_pages_;
+        auto memory = allocate_grid(bytes, obtained);
+        if(obtained != HugePages::NONE) {
+            std::memcpy(memory.get(), grid.get(), bytes);
+            registered = memory;
+            LOG(INFO) << "Placed field grid of " << (bytes >> 20) << " MB on "
+                      << (obtained == HugePages::EXPLICIT ? "explicit" : "transparent") << " huge pages";
+        } else if(bytes >= huge_page_size) {
+            LOG(WARNING) << "Cannot place field grid of " << (bytes >> 20) << " MB on huge pages, using regular pages";
+        }
+    }
+
+    grids_.emplace(key, std::make_pair(std::weak_ptr<const void>(registered), bytes));
+    registered_bytes_ += bytes;
+    LOG(DEBUG) << "Registered field grid of " << (bytes >> 20) << " MB, " << (registered_bytes_ >> 20)
+               << " MB of field grids registered in total";
+    return registered;
+}
+
+/**
+ * The copies are only referenced weakly as well, they are created again if any of them has been released in the meantime.
+ * The copies are keyed by the address of the grid, which is only reused once the grid itself has been released. Every copy
+ * is allocated and written by a thread bound to its node, such that its pages are placed on that node.
+ */
+std::vector<std::shared_ptr<const void>> FieldStore::replicate_grid(const std::shared_ptr<const void>& grid, size_t bytes) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    for(auto stale = replicas_.begin(); stale != replicas_.end();) {
+        stale = (stale->second.first.expired() ? replicas_.erase(stale) : std::next(stale));
+    }
+
+    auto iter = replicas_.find(grid.get());
+    if(iter != replicas_.end() && iter->second.first.lock() == grid) {
+        std::vector<std::shared_ptr<const void>> replicas;
+        for(const auto& weak_replica : iter->second.second) {
+            auto replica = weak_replica.lock();
+            if(replica == nullptr) {
+                break;
+            }
+            replicas.push_back(std::move(replica));
+        }
+        if(replicas.size() == iter->second.second.size()) {
+            return replicas;
+        }
+    }
+
+    std::vector<std::shared_ptr<const void>> replicas(numa::node_count());
+    for(size_t node = 0; node < replicas.size(); ++node) {
+        numa::run_on_node(node, [&]() {
+            auto obtained = huge_pages_;
+            auto memory = allocate_grid(bytes, obtained);
+            if(obtained == HugePages::NONE) {
+                memory = std::shared_ptr<char>(new char[bytes], std::default_delete<char[]>());
+            }
+            std::memcpy(memory.get(), grid.get(), bytes);
+            replicas[node] = memory;
+        });
+    }
+    replicas_[grid.get()] = std::make_pair(std::weak_ptr<const void>(grid),
+                                           std::vector<std::weak_ptr<const void>>(replicas.begin(), replicas.end()));
+    LOG(DEBUG) << "Placed copies of field grid on " << replicas.size() << " NUMA nodes";
+    return replicas;
+}
+
+void FieldStore::setHugePages(HugePages huge_pages) {
+    auto& store = get_instance();
+    std::lock_guard<std::mutex> lock{store.mutex_};
+    store.huge_pages_ = huge_pages;
+}
+
+/**
+ * Explicit huge pages are reserved from the pool configured by the administrator, the allocation fails if the pool does
+ * not hold enough free pages. Transparent huge pages are requested by aligning the memory to the huge page size and
+ * advising the kernel to back it with huge pages, which is only refused if they are disabled entirely. Grids smaller than
+ * a single huge page are kept on regular pages.
+ */
+std::shared_ptr<void> FieldStore::allocate_grid(size_t bytes, HugePages& obtained) const {
+    auto requested = obtained;
+    obtained = HugePages::NONE;
+#ifdef __linux__
+    if(requested == HugePages::NONE || bytes < huge_page_size) {
+        return nullptr;
+    }
+
+    if(requested == HugePages::EXPLICIT) {
+        auto length = round_up(bytes, explicit_huge_page_size());
+        void* memory = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if(memory != MAP_FAILED) {
+            obtained = HugePages::EXPLICIT;
+            return {memory, [length](void* ptr) { ::munmap(ptr, length); }};
+        }
+        LOG(DEBUG) << "Cannot reserve " << (length >> 20) << " MB of explicit huge pages, trying transparent huge pages";
+    }
+
+    if(!transparent_huge_pages_available()) {
+        return nullptr;
+    }
+
+    // Over-allocate to align the memory to the huge page size, and release the unaligned parts again
+    auto length = round_up(bytes, huge_page_size);
+    void* mapping = ::mmap(nullptr, length + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(mapping == MAP_FAILED) {
+        return nullptr;
+    }
+    auto* begin = static_cast<char*>(mapping);
+    auto* aligned = begin + (round_up(reinterpret_cast<std::uintptr_t>(begin), huge_page_size) - // NOLINT
+                             reinterpret_cast<std::uintptr_t>(begin));                           // NOLINT
+    if(aligned != begin) {
+        ::munmap(begin, static_cast<size_t>(aligned - begin));
+    }
+    if(aligned + length != begin + length + huge_page_size) {
+        ::munmap(aligned + length, static_cast<size_t>(begin + huge_page_size - aligned));
+    }
+    if(::madvise(aligned, length, MADV_HUGEPAGE) != 0) {
+        ::munmap(aligned, length);
+        return nullptr;
+    }
+    obtained = HugePages::TRANSPARENT;
+    return {aligned, [length](void* ptr) { ::munmap(ptr, length); }};
+#else
+    (void)bytes;
+    (void)requested;
+    return nullptr;
+#endif
+}
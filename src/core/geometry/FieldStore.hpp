@@ -0,0 +1,108 @@
+/**
+ * @file
+ * @brief Definition of the store sharing identical field grids
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_FIELD_STORE_H
+#define ALLPIX_FIELD_STORE_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace allpix {
+
+    /**
+     * @brief Store of all field grids in use, sharing grids with identical content between fields
+     *
+     * Grids are identified by a hash of their content and compared value by value, such that identical fields read from
+     * different files or by different module instantiations are held in memory only once. The store only references the
+     * grids weakly, a grid is released as soon as no field uses it anymore.
+     *
+     * Since large grids are accessed at random positions, translating their addresses is costly with regular pages. Newly
+     * registered grids can optionally be copied to memory backed by huge pages, such that far fewer translations are
+     * required.
+     */
+    class FieldStore {
+    public:
+        /**
+         * @brief Type of memory pages to back large grids with
+         */
+        enum class HugePages {
+            NONE,        ///< Keep grids in the memory they have been registered with
+            TRANSPARENT, ///< Copy grids to memory advised to be backed by transparent huge pages
+            EXPLICIT,    ///< Copy grids to memory reserved from the explicit huge page pool
+        };
+
+        /**
+         * @brief Register a grid, returning an identical grid already in use if available
+         * @param grid Pointer to the values of the grid
+         * @param entries Number of values in the grid
+         * @return Pointer to the identical grid in use, or the given grid if no identical grid is known
+         */
+        template <typename T> static std::shared_ptr<const T> share(std::shared_ptr<const T> grid, size_t entries) {
+            return std::static_pointer_cast<const T>(get_instance().share_grid(grid, entries * sizeof(T), sizeof(T)));
+        }
+
+        /**
+         * @brief Register a grid held in a vector, returning an identical grid already in use if available
+         * @param grid Values of the grid
+         * @return Pointer to the identical grid in use, or to the given values if no identical grid is known
+         */
+        template <typename T> static std::shared_ptr<const T> share(std::vector<T> grid) {
+            auto entries = grid.size();
+            auto vector = std::make_shared<const std::vector<T>>(std::move(grid));
+            return share(std::shared_ptr<const T>(vector, vector->data()), entries);
+        }
+
+        /**
+         * @brief Get a copy of a grid placed on every NUMA node, the copies are only created once per grid
+         * @param grid Pointer to the values of the grid
+         * @param entries Number of values in the grid
+         * @return Pointer to the copy of the grid on every node, indexed by the node
+         */
+        template <typename T>
+        static std::vector<std::shared_ptr<const void>> replicate(const std::shared_ptr<const T>& grid, size_t entries) {
+            return get_instance().replicate_grid(grid, entries * sizeof(T));
+        }
+
+        /**
+         * @brief Set the pages grids registered afterwards are placed on
+         * @param huge_pages Type of pages to back grids of at least one huge page with
+         */
+        static void setHugePages(HugePages huge_pages);
+
+    private:
+        static FieldStore& get_instance();
+
+        std::shared_ptr<const void> share_grid(const std::shared_ptr<const void>& grid, size_t bytes, size_t value_size);
+
+        std::vector<std::shared_ptr<const void>> replicate_grid(const std::shared_ptr<const void>& grid, size_t bytes);
+
+        std::shared_ptr<void> allocate_grid(size_t bytes, HugePages& obtained) const;
+
+        std::mutex mutex_;
+
+        // Grids in use together with their size in bytes, indexed by the hash of their content and the size of their values
+        std::multimap<std::pair<size_t, size_t>, std::pair<std::weak_ptr<const void>, size_t>> grids_;
+
+        // Copies of grids on every NUMA node, indexed by the grid they are copied from
+        std::map<const void*, std::pair<std::weak_ptr<const void>, std::vector<std::weak_ptr<const void>>>> replicas_;
+
+        HugePages huge_pages_{HugePages::NONE};
+
+        // Total memory of the grids registered and of the identical copies replaced by a shared grid
+        size_t registered_bytes_{};
+        size_t saved_bytes_{};
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_FIELD_STORE_H */
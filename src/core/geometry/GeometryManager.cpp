@@ -8,8 +8,10 @@
  * Intergovernmental Organization or submit itself to any jurisdiction.
  */
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
+#include <limits>
 #include <memory>
 #include <string>
 #include <utility>
@@ -154,37 +156,22 @@ ROOT::Math::XYZPoint GeometryManager::getMinimumCoordinate() {
         close_geometry();
     }
 
-    ROOT::Math::XYZPoint min_point(0, 0, 0);
-    // Loop through all detector
-    for(auto& detector : detectors_) {
-        // Get the model of the detector
-        auto model = detector->getModel();
-
-        std::array<int, 8> offset_x = {{1, 1, 1, 1, -1, -1, -1, -1}};
-        std::array<int, 8> offset_y = {{1, 1, -1, -1, 1, 1, -1, -1}};
-        std::array<int, 8> offset_z = {{1, -1, 1, -1, 1, -1, 1, -1}};
-
-        for(size_t i = 0; i < 8; ++i) {
-            auto point = model->getGeometricalCenter();
-            point.SetX(point.x() + offset_x.at(i) * model->getSize().x() / 2.0);
-            point.SetY(point.y() + offset_y.at(i) * model->getSize().y() / 2.0);
-            point.SetZ(point.z() + offset_z.at(i) * model->getSize().z() / 2.0);
-            point = detector->getGlobalPosition(point);
-
-            min_point.SetX(std::min(min_point.x(), point.x()));
-            min_point.SetY(std::min(min_point.y(), point.y()));
-            min_point.SetZ(std::min(min_point.z(), point.z()));
+    // Loop through the bounding boxes of all detectors
+    std::array<double, 3> min_point{};
+    for(auto& box : detector_boxes_) {
+        for(size_t i = 0; i < 3; ++i) {
+            min_point[i] = std::min(min_point[i], box.min[i]);
         }
     }
 
     // Loop through all separate points
     for(auto& point : points_) {
-        min_point.SetX(std::min(min_point.x(), point.x()));
-        min_point.SetY(std::min(min_point.y(), point.y()));
-        min_point.SetZ(std::min(min_point.z(), point.z()));
+        min_point[0] = std::min(min_point[0], point.x());
+        min_point[1] = std::min(min_point[1], point.y());
+        min_point[2] = std::min(min_point[2], point.z());
     }
 
-    return min_point;
+    return XYZPoint(min_point[0], min_point[1], min_point[2]);
 }
 
 /**
@@ -196,36 +183,22 @@ ROOT::Math::XYZPoint GeometryManager::getMaximumCoordinate() {
         close_geometry();
     }
 
-    ROOT::Math::XYZPoint max_point(0, 0, 0);
-    // Loop through all detector
-    for(auto& detector : detectors_) {
-        // Get the model of the detector
-        auto model = detector->getModel();
-
-        std::array<int, 8> offset_x = {{1, 1, 1, 1, -1, -1, -1, -1}};
-        std::array<int, 8> offset_y = {{1, 1, -1, -1, 1, 1, -1, -1}};
-        std::array<int, 8> offset_z = {{1, -1, 1, -1, 1, -1, 1, -1}};
-
-        for(size_t i = 0; i < 8; ++i) {
-            auto point = model->getGeometricalCenter();
-            point.SetX(point.x() + offset_x.at(i) * model->getSize().x() / 2.0);
-            point.SetY(point.y() + offset_y.at(i) * model->getSize().y() / 2.0);
-            point.SetZ(point.z() + offset_z.at(i) * model->getSize().z() / 2.0);
-            point = detector->getGlobalPosition(point);
-            max_point.SetX(std::max(max_point.x(), point.x()));
-            max_point.SetY(std::max(max_point.y(), point.y()));
-            max_point.SetZ(std::max(max_point.z(), point.z()));
+    // Loop through the bounding boxes of all detectors
+    std::array<double, 3> max_point{};
+    for(auto& box : detector_boxes_) {
+        for(size_t i = 0; i < 3; ++i) {
+            max_point[i] = std::max(max_point[i], box.max[i]);
         }
     }
 
     // Loop through all separate points
     for(auto& point : points_) {
-        max_point.SetX(std::max(max_point.x(), point.x()));
-        max_point.SetY(std::max(max_point.y(), point.y()));
-        max_point.SetZ(std::max(max_point.z(), point.z()));
+        max_point[0] = std::max(max_point[0], point.x());
+        max_point[1] = std::max(max_point[1], point.y());
+        max_point[2] = std::max(max_point[2], point.z());
     }
 
-    return max_point;
+    return XYZPoint(max_point[0], max_point[1], max_point[2]);
 }
 
 /**
@@ -306,16 +279,14 @@ void GeometryManager::addDetector(std::shared_ptr<Detector> detector) {
         throw DetectorInvalidNameError(detector->getName());
     }
 
-    if(detector_names_.find(detector->getName()) != detector_names_.end()) {
+    if(!detectors_by_name_.emplace(detector->getName(), detector).second) {
         throw DetectorExistsError(detector->getName());
     }
-
-    detector_names_.insert(detector->getName());
     detectors_.push_back(std::move(detector));
 }
 
 bool GeometryManager::hasDetector(const std::string& name) const {
-    return detector_names_.find(name) != detector_names_.end();
+    return detectors_by_name_.find(name) != detectors_by_name_.end();
 }
 
 std::vector<std::shared_ptr<Detector>> GeometryManager::getDetectors() {
@@ -333,13 +304,11 @@ std::shared_ptr<Detector> GeometryManager::getDetector(const std::string& name)
         close_geometry();
     }
 
-    // FIXME: this is not a very nice way to implement this
-    for(auto& detector : detectors_) {
-        if(detector->getName() == name) {
-            return detector;
-        }
+    auto iter = detectors_by_name_.find(name);
+    if(iter == detectors_by_name_.end()) {
+        throw allpix::InvalidDetectorError(name);
     }
-    throw allpix::InvalidDetectorError(name);
+    return iter->second;
 }
 
 /**
@@ -350,17 +319,56 @@ std::vector<std::shared_ptr<Detector>> GeometryManager::getDetectorsByType(const
         close_geometry();
     }
 
-    std::vector<std::shared_ptr<Detector>> result;
-    for(auto& detector : detectors_) {
-        if(detector->getType() == type) {
-            result.push_back(detector);
-        }
-    }
-    if(result.empty()) {
+    auto iter = detectors_by_type_.find(type);
+    if(iter == detectors_by_type_.end()) {
         throw allpix::InvalidDetectorModelError(type);
     }
+    return iter->second;
+}
+
+std::shared_ptr<Detector> GeometryManager::getDetectorAt(const XYZPoint& global_point) {
+    if(!closed_) {
+        close_geometry();
+    }
+
+    std::array<double, 3> point = {{global_point.x(), global_point.y(), global_point.z()}};
+    auto contains = [&point](const BoundingBox& box) {
+        for(size_t i = 0; i < 3; ++i) {
+            if(point[i] < box.min[i] || point[i] > box.max[i]) {
+                return false;
+            }
+        }
+        return true;
+    };
 
-    return result;
+    // Traverse all nodes containing the point and keep the first detector with the point inside its sensor
+    auto found = detectors_.size();
+    std::vector<size_t> nodes;
+    if(!hierarchy_.empty()) {
+        nodes.push_back(0);
+    }
+    while(!nodes.empty()) {
+        auto index = nodes.back();
+        nodes.pop_back();
+        const auto& node = hierarchy_[index];
+        if(!contains(node.box)) {
+            continue;
+        }
+        if(node.count == 0) {
+            nodes.push_back(node.second_child);
+            nodes.push_back(index + 1);
+            continue;
+        }
+        for(size_t i = node.first; i < node.first + node.count; ++i) {
+            auto detector_index = hierarchy_detectors_[i];
+            const auto& detector = detectors_[detector_index];
+            if(detector_index < found &&
+               detector->getModel()->isWithinSensor(detector->getLocalPosition(global_point))) {
+                found = detector_index;
+            }
+        }
+    }
+    return (found < detectors_.size() ? detectors_[found] : nullptr);
 }
 
 std::list<Configuration>& GeometryManager::getPassiveElements() {
@@ -498,9 +506,104 @@ void GeometryManager::close_geometry() {
         }
     }
 
+    // Index the detectors by type and build the bounding boxes for the detector lookup once all models are known
+    detectors_by_type_.clear();
+    for(const auto& detector : detectors_) {
+        detectors_by_type_[detector->getType()].push_back(detector);
+    }
+    build_hierarchy();
+
     closed_ = true;
     LOG(TRACE) << "Closed geometry";
 }
+
+GeometryManager::BoundingBox
+GeometryManager::global_bounding_box(const Detector& detector, const XYZPoint& center, const XYZVector& size) {
+    BoundingBox box;
+    box.min.fill(std::numeric_limits<double>::max());
+    box.max.fill(std::numeric_limits<double>::lowest());
+
+    // Transform all corners of the box to the global frame
+    for(size_t corner = 0; corner < 8; ++corner) {
+        auto point = detector.getGlobalPosition(XYZPoint(center.x() + ((corner & 1) != 0 ? 1 : -1) * size.x() / 2.0,
+                                                         center.y() + ((corner & 2) != 0 ? 1 : -1) * size.y() / 2.0,
+                                                         center.z() + ((corner & 4) != 0 ? 1 : -1) * size.z() / 2.0));
+        std::array<double, 3> coordinates = {{point.x(), point.y(), point.z()}};
+        for(size_t i = 0; i < 3; ++i) {
+            box.min[i] = std::min(box.min[i], coordinates[i]);
+            box.max[i] = std::max(box.max[i], coordinates[i]);
+        }
+    }
+    return box;
+}
+
+void GeometryManager::build_hierarchy() {
+    detector_boxes_.clear();
+    hierarchy_.clear();
+    hierarchy_detectors_.clear();
+
+    std::vector<BoundingBox> sensor_boxes;
+    for(size_t i = 0; i < detectors_.size(); ++i) {
+        auto model = detectors_[i]->getModel();
+        detector_boxes_.push_back(global_bounding_box(*detectors_[i], model->getGeometricalCenter(), model->getSize()));
+        sensor_boxes.push_back(global_bounding_box(*detectors_[i], model->getSensorCenter(), model->getSensorSize()));
+        hierarchy_detectors_.push_back(i);
+    }
+
+    if(!detectors_.empty()) {
+        build_hierarchy_node(0, detectors_.size(), sensor_boxes);
+    }
+    LOG(TRACE) << "Built bounding volume hierarchy with " << hierarchy_.size() << " nodes for " << detectors_.size()
+               << " detectors";
+}
+
+void GeometryManager::build_hierarchy_node(size_t first, size_t last, const std::vector<BoundingBox>& sensor_boxes) {
+    // Bounding box of all sensors in the range and of their centers
+    HierarchyNode node;
+    node.box.min.fill(std::numeric_limits<double>::max());
+    node.box.max.fill(std::numeric_limits<double>::lowest());
+    BoundingBox centers = node.box;
+    auto center = [&sensor_boxes](size_t detector, size_t axis) {
+        return (sensor_boxes[detector].min[axis] + sensor_boxes[detector].max[axis]) / 2.0;
+    };
+    for(size_t i = first; i < last; ++i) {
+        const auto& box = sensor_boxes[hierarchy_detectors_[i]];
+        for(size_t axis = 0; axis < 3; ++axis) {
+            node.box.min[axis] = std::min(node.box.min[axis], box.min[axis]);
+            node.box.max[axis] = std::max(node.box.max[axis], box.max[axis]);
+            centers.min[axis] = std::min(centers.min[axis], center(hierarchy_detectors_[i], axis));
+            centers.max[axis] = std::max(centers.max[axis], center(hierarchy_detectors_[i], axis));
+        }
+    }
+
+    auto index = hierarchy_.size();
+    hierarchy_.push_back(node);
+
+    // Small ranges are stored as leaves, the detectors are tested one by one
+    constexpr size_t max_leaf_size = 2;
+    if(last - first <= max_leaf_size) {
+        hierarchy_[index].first = first;
+        hierarchy_[index].count = last - first;
+        return;
+    }
+
+    // Split at the median of the sensor centers along the axis with the largest extent
+    size_t axis = 0;
+    for(size_t i = 1; i < 3; ++i) {
+        if(centers.max[i] - centers.min[i] > centers.max[axis] - centers.min[axis]) {
+            axis = i;
+        }
+    }
+    auto middle = first + (last - first) / 2;
+    std::nth_element(hierarchy_detectors_.begin() + static_cast<std::ptrdiff_t>(first),
+                     hierarchy_detectors_.begin() + static_cast<std::ptrdiff_t>(middle),
+                     hierarchy_detectors_.begin() + static_cast<std::ptrdiff_t>(last),
+                     [&](size_t lhs, size_t rhs) { return center(lhs, axis) < center(rhs, axis); });
+
+    build_hierarchy_node(first, middle, sensor_boxes);
+    hierarchy_[index].second_child = hierarchy_.size();
+    build_hierarchy_node(middle, last, sensor_boxes);
+}
 /*
  * Calculates the position and orientation of the object from the provided configuration file
  */
@@ -10,6 +10,8 @@
 #ifndef ALLPIX_GEOMETRY_MANAGER_H
 #define ALLPIX_GEOMETRY_MANAGER_H
 
+#include <array>
+#include <map>
 #include <memory>
 #include <random>
 #include <set>
@@ -190,6 +192,18 @@ namespace allpix {
          */
         std::vector<std::shared_ptr<Detector>> getDetectorsByType(const std::string& type);
 
+        /**
+         * @brief Get the detector with the sensor containing a point
+         * @param global_point Point in global coordinates
+         * @return Detector with the point inside its sensor, a null pointer if the point is outside all sensors
+         * @note Closes the geometry if it has not been closed yet
+         *
+         * The detectors are looked up in a bounding volume hierarchy of their sensors built when closing the geometry, such
+         * that only the detectors with a bounding box containing the point are tested. If sensors overlap, the detector
+         * defined first is returned.
+         */
+        std::shared_ptr<Detector> getDetectorAt(const ROOT::Math::XYZPoint& global_point);
+
         /**
          * @brief Set the magnetic field in the volume
          * @param function Function used to retrieve the magnetic field
@@ -269,6 +283,54 @@ namespace allpix {
         void close_geometry();
         std::atomic_bool closed_;
 
+        /**
+         * @brief Box aligned to the global axes
+         */
+        struct BoundingBox {
+            std::array<double, 3> min{};
+            std::array<double, 3> max{};
+        };
+        /**
+         * @brief Node of the bounding volume hierarchy over the detector sensors
+         *
+         * The first child of an inner node directly follows the node, the second child is stored at the given index. Leaves
+         * hold a range of the sorted detector indices.
+         */
+        struct HierarchyNode {
+            BoundingBox box;
+            size_t second_child{};
+            size_t first{};
+            size_t count{};
+        };
+
+        /**
+         * @brief Get the global bounding box of a box in the local frame of a detector
+         * @param detector Detector defining the local frame
+         * @param center Center of the box in local coordinates
+         * @param size Size of the box
+         * @return Bounding box in global coordinates
+         */
+        static BoundingBox
+        global_bounding_box(const Detector& detector, const ROOT::Math::XYZPoint& center, const ROOT::Math::XYZVector& size);
+
+        /**
+         * @brief Build the bounding boxes of the detectors and the hierarchy of their sensors
+         */
+        void build_hierarchy();
+
+        /**
+         * @brief Add the nodes of the hierarchy for a range of the sorted detector indices
+         * @param first First position of the range
+         * @param last Position after the last element of the range
+         * @param sensor_boxes Bounding boxes of the sensors of all detectors
+         */
+        void build_hierarchy_node(size_t first, size_t last, const std::vector<BoundingBox>& sensor_boxes);
+
+        // Bounding boxes of the full detectors and the hierarchy of their sensors, built when closing the geometry
+        std::vector<BoundingBox> detector_boxes_;
+        std::vector<HierarchyNode> hierarchy_;
+        std::vector<size_t> hierarchy_detectors_;
+
         RandomNumberGenerator random_generator_;
 
         std::vector<ROOT::Math::XYZPoint> points_;
@@ -279,7 +341,10 @@ namespace allpix {
 
         std::map<std::string, std::vector<std::pair<Configuration, Detector*>>> nonresolved_models_;
         std::vector<std::shared_ptr<Detector>> detectors_;
-        std::set<std::string> detector_names_;
+
+        // Lookup of the detectors by name, and by type once the models are resolved when closing the geometry
+        std::map<std::string, std::shared_ptr<Detector>> detectors_by_name_;
+        std::map<std::string, std::vector<std::shared_ptr<Detector>>> detectors_by_type_;
 
         std::list<Configuration> passive_elements_;
         std::map<std::string, std::pair<ROOT::Math::XYZPoint, ROOT::Math::Rotation3D>> passive_orientations_;
@@ -31,6 +31,30 @@ std::shared_ptr<const Detector> BaseMessage::getDetector() const {
  * The override method should return the exact same data but then casted to objects or throw the default exception if this is
  * not possible.
  */
+ObjectArray BaseMessage::getObjects() {
+    throw MessageWithoutObjectException(typeid(*this));
+}
+
 std::vector<std::reference_wrapper<Object>> BaseMessage::getObjectArray() {
+    auto objects = getObjects();
+    return {objects.begin(), objects.end()};
+}
+
+size_t BaseMessage::getSizeHint() const {
+    return 0;
+}
+
+bool BaseMessage::isEmpty() const {
+    return false;
+}
+
+bool BaseMessage::isStreamable() const {
+    return false;
+}
+
+/**
+ * @throws MessageWithoutObjectException If this method is not overridden
+ */
+void BaseMessage::streamObjects(TBuffer&) {
     throw MessageWithoutObjectException(typeid(*this));
 }
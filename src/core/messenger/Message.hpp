@@ -11,12 +11,94 @@
 #ifndef ALLPIX_MESSAGE_H
 #define ALLPIX_MESSAGE_H
 
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
 #include <vector>
 
+#include <TBuffer.h>
+
 #include "core/geometry/Detector.hpp"
 #include "objects/Object.hpp"
 
 namespace allpix {
+    /**
+     * @brief Non-allocating view of the data of a message as base objects
+     *
+     * The view refers to the data of the message directly and is only valid for as long as the message exists. The objects
+     * are accessed through a function selected by their type, such that no array of references has to be built.
+     */
+    class ObjectArray {
+    public:
+        /**
+         * @brief Iterator over the objects of the view
+         */
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Object;
+            using difference_type = std::ptrdiff_t;
+            using pointer = Object*;
+            using reference = Object&;
+
+            iterator() = default;
+            iterator(void* data, size_t index, Object& (*access)(void*, size_t))
+                : data_(data), index_(index), access_(access) {}
+
+            reference operator*() const { return access_(data_, index_); }
+            pointer operator->() const { return &access_(data_, index_); }
+            iterator& operator++() {
+                ++index_;
+                return *this;
+            }
+            iterator operator++(int) {
+                auto previous = *this;
+                ++index_;
+                return previous;
+            }
+            bool operator==(const iterator& other) const { return data_ == other.data_ && index_ == other.index_; }
+            bool operator!=(const iterator& other) const { return !(*this == other); }
+
+        private:
+            void* data_{};
+            size_t index_{};
+            Object& (*access_)(void*, size_t){};
+        };
+
+        /**
+         * @brief Construct an empty view
+         */
+        ObjectArray() = default;
+
+        /**
+         * @brief Construct a view of a vector of objects
+         * @param data Vector of objects derived from \ref Object
+         */
+        template <typename T>
+        explicit ObjectArray(std::vector<T>& data) : data_(data.data()), size_(data.size()), access_(&access<T>) {}
+
+        /**
+         * @brief Get an object of the view
+         * @param index Index of the object
+         * @return Reference to the object
+         */
+        Object& operator[](size_t index) const { return access_(data_, index); }
+
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        iterator begin() const { return {data_, 0, access_}; }
+        iterator end() const { return {data_, size_, access_}; }
+
+    private:
+        template <typename T> static Object& access(void* data, size_t index) { return static_cast<T*>(data)[index]; }
+
+        void* data_{};
+        size_t size_{};
+        Object& (*access_)(void*, size_t){};
+    };
+
     /**
      * @brief Type-erased base class for all messages
      *
@@ -47,11 +129,42 @@ namespace allpix {
          */
         std::shared_ptr<const Detector> getDetector() const;
 
+        /**
+         * @brief Get a view of the objects stored in this message if possible
+         * @return View of the data as base objects, without copying or allocating
+         */
+        virtual ObjectArray getObjects();
+
         /**
          * @brief Get list of objects stored in this message if possible
          * @return Array of base objects
+         * @note Allocates a new array on every call, \ref getObjects should be preferred
+         */
+        std::vector<std::reference_wrapper<Object>> getObjectArray();
+
+        /**
+         * @brief Get an estimate of the memory held by the contents of this message
+         * @return Approximate size in bytes of the memory allocated for the contents, excluding the message itself
+         */
+        virtual size_t getSizeHint() const;
+
+        /**
+         * @brief Check if this message does not contain any objects
+         * @return True if the message is known to be empty, false otherwise
          */
-        virtual std::vector<std::reference_wrapper<Object>> getObjectArray();
+        virtual bool isEmpty() const;
+
+        /**
+         * @brief Check if the objects of this message can be streamed with \ref streamObjects
+         * @return True if the message contains objects with a ROOT dictionary, false otherwise
+         */
+        virtual bool isStreamable() const;
+
+        /**
+         * @brief Write the objects to a buffer and release their memory, or restore them from a buffer
+         * @param buffer ROOT buffer the objects are written to or read from, depending on its mode
+         */
+        virtual void streamObjects(TBuffer& buffer);
 
     protected:
         /**
@@ -68,6 +181,13 @@ namespace allpix {
         std::shared_ptr<const Detector> detector_;
     };
 
+    /**
+     * @brief Check if a type provides an estimate of the memory it allocates through a getSizeHint() method
+     */
+    template <typename T, typename = void> struct has_size_hint : std::false_type {};
+    template <typename T>
+    struct has_size_hint<T, std::void_t<decltype(std::declval<const T&>().getSizeHint())>> : std::true_type {};
+
     /**
      * @brief Generic class for all messages
      *
@@ -98,25 +218,50 @@ namespace allpix {
         const std::vector<T>& getData() const;
 
         /**
-         * @brief Get data as list of objects if the contents can be converted
-         * @return Data as list of object references (throws if not possible)
+         * @brief Get a view of the data as objects if the contents can be converted
+         * @return View of the data as base objects (throws if not possible)
+         */
+        ObjectArray getObjects() override;
+
+        /**
+         * @brief Get an estimate of the memory held by the data of this message
+         * @return Size in bytes of the storage allocated for the data objects
+         *
+         * Memory allocated by the objects themselves, such as the pulses of charges, is included for all object types which
+         * provide an estimate of it with a getSizeHint() method.
+         */
+        size_t getSizeHint() const override;
+
+        /**
+         * @brief Check if the data of this message is empty
+         * @return True if the message does not contain any data objects
+         */
+        bool isEmpty() const override;
+
+        /**
+         * @brief Check if the objects of this message can be streamed
+         * @return True if the message contains objects derived from \ref allpix::Object
+         */
+        bool isStreamable() const override;
+
+        /**
+         * @brief Write the objects to a buffer and release their memory, or restore them from a buffer
+         * @param buffer ROOT buffer the objects are written to or read from, depending on its mode
          */
-        std::vector<std::reference_wrapper<Object>> getObjectArray() override;
+        void streamObjects(TBuffer& buffer) override;
 
     private:
         /**
-         * @brief Returns object array for messages containing objects
+         * @brief Returns a view of the objects for messages containing objects
          */
         template <typename U = T>
-        std::vector<std::reference_wrapper<Object>>
-        get_object_array(typename std::enable_if<std::is_base_of<Object, U>::value>::type* = nullptr);
+        ObjectArray get_objects(typename std::enable_if<std::is_base_of<Object, U>::value>::type* = nullptr);
 
         /**
          * @brief Throws error if message does not contain object
          */
         template <typename U = T>
-        std::vector<std::reference_wrapper<Object>>
-        get_object_array(typename std::enable_if<!std::is_base_of<Object, U>::value>::type* = nullptr);
+        ObjectArray get_objects(typename std::enable_if<!std::is_base_of<Object, U>::value>::type* = nullptr);
 
         /**
          * @brief Set kMustCleanup bit in all Objects to false, to prevent cleanup by ROOT
@@ -21,23 +21,64 @@ namespace allpix {
     template <typename T> const std::vector<T>& Message<T>::getData() const { return data_; }
 
     /**
-     * Chooses between internal \ref get_object_array implementations dependent on the type of the object (if it drives from
-     * \ref allpix::Object).
+     * The memory allocated by the objects is summed over all objects, which is only done for types providing an estimate
+     */
+    template <typename T> size_t Message<T>::getSizeHint() const {
+        auto size = data_.capacity() * sizeof(T);
+        if constexpr(has_size_hint<T>::value) {
+            for(const auto& object : data_) {
+                size += object.getSizeHint();
+            }
+        }
+        return size;
+    }
+
+    template <typename T> bool Message<T>::isEmpty() const { return data_.empty(); }
+
+    template <typename T> bool Message<T>::isStreamable() const { return std::is_base_of<Object, T>::value; }
+
+    /**
+     * The objects are streamed with their ROOT dictionary, preceded by their number. References between objects are only
+     * kept if the history of the objects has been petrified before writing them.
+     *
+     * @throws MessageWithoutObjectException If the message does not contain types derived from \ref allpix::Object
      */
-    template <typename T> std::vector<std::reference_wrapper<Object>> Message<T>::getObjectArray() {
-        return get_object_array();
+    template <typename T> void Message<T>::streamObjects(TBuffer& buffer) {
+        if constexpr(std::is_base_of<Object, T>::value) {
+            if(buffer.IsWriting()) {
+                buffer << static_cast<ULong64_t>(data_.size());
+                for(auto& object : data_) {
+                    buffer.StreamObject(&object, T::Class());
+                }
+                skip_object_cleanup();
+                std::vector<T>().swap(data_);
+            } else {
+                ULong64_t size = 0;
+                buffer >> size;
+                data_.resize(size);
+                for(auto& object : data_) {
+                    buffer.StreamObject(&object, T::Class());
+                }
+            }
+        } else {
+            throw MessageWithoutObjectException(typeid(*this));
+        }
     }
+
+    /**
+     * Chooses between internal \ref get_objects implementations dependent on the type of the object (if it drives from
+     * \ref allpix::Object).
+     */
+    template <typename T> ObjectArray Message<T>::getObjects() { return get_objects(); }
     /**
-     * Pass the data as a copy of the internal vector referencing the same data as the internal vector
+     * Pass a view referencing the data of the message without copying it
      *
      * @warning Data through this method can only be accessed for as long as this message exists
      */
     template <typename T>
     template <typename U>
-    std::vector<std::reference_wrapper<Object>>
-    Message<T>::get_object_array(typename std::enable_if<std::is_base_of<Object, U>::value>::type*) {
-        std::vector<std::reference_wrapper<Object>> data(data_.begin(), data_.end());
-        return data;
+    ObjectArray Message<T>::get_objects(typename std::enable_if<std::is_base_of<Object, U>::value>::type*) {
+        return ObjectArray(data_);
     }
     /**
      * @throws MessageWithoutObjectException Always (but this method is only used if this message does not contain types
@@ -45,25 +86,18 @@ namespace allpix {
      */
     template <typename T>
     template <typename U>
-    std::vector<std::reference_wrapper<Object>>
-    Message<T>::get_object_array(typename std::enable_if<!std::is_base_of<Object, U>::value>::type*) {
+    ObjectArray Message<T>::get_objects(typename std::enable_if<!std::is_base_of<Object, U>::value>::type*) {
         throw MessageWithoutObjectException(typeid(*this));
     }
 
-    /**
-     * Pass the data as a copy of the internal vector referencing the same data as the internal vector
-     *
-     * @warning Data through this method can only be accessed for as long as this message exists
-     */
     template <typename T>
     template <typename U>
     void Message<T>::skip_object_cleanup(typename std::enable_if<std::is_base_of<Object, U>::value>::type*) {
-        auto objects = get_object_array();
-        for(auto& object : objects) {
+        for(auto& object : data_) {
             // We handle cleanup of objects ourselves, we therefore can deactivate the RecursiveRemove functionality of
             // the TObject we are referencing. Otherwise this calls locks in ROOT to clean up the hash table - and stalls
             // our threads.
-            object.get().ResetBit(kMustCleanup);
+            object.ResetBit(kMustCleanup);
         }
     }
 
@@ -0,0 +1,133 @@
+/**
+ * @file
+ * @brief Lightweight views on the messages received by a module
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_MESSAGE_VIEW_H
+#define ALLPIX_MESSAGE_VIEW_H
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Message.hpp"
+
+namespace allpix {
+    /**
+     * @brief Message dispatched in an event together with its name
+     */
+    using DispatchedMessage = std::pair<std::shared_ptr<BaseMessage>, std::string>;
+    using DispatchedMessageList = std::vector<DispatchedMessage>;
+    using MessageIndexList = std::vector<size_t>;
+
+    /**
+     * @brief View on a selection of the messages dispatched in an event
+     *
+     * The view refers to the list of dispatched messages of the event and the indices of the selected messages, nothing is
+     * copied on construction. It stays valid as long as the event exists, also if further messages are dispatched.
+     *
+     * @tparam Element Type the view provides its elements as
+     * @tparam Resolve Function object converting a dispatched message to an element
+     */
+    template <typename Element, typename Resolve> class BasicMessageView {
+    public:
+        /**
+         * @brief Forward iterator over the selected messages
+         */
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::remove_cv_t<std::remove_reference_t<Element>>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const value_type*;
+            using reference = Element;
+
+            iterator(const DispatchedMessageList* messages, const MessageIndexList* indices, size_t position)
+                : messages_(messages), indices_(indices), position_(position) {}
+
+            reference operator*() const { return Resolve()((*messages_)[(*indices_)[position_]]); }
+            iterator& operator++() {
+                ++position_;
+                return *this;
+            }
+            iterator operator++(int) {
+                auto copy = *this;
+                ++position_;
+                return copy;
+            }
+            bool operator==(const iterator& other) const { return position_ == other.position_; }
+            bool operator!=(const iterator& other) const { return position_ != other.position_; }
+
+        private:
+            const DispatchedMessageList* messages_;
+            const MessageIndexList* indices_;
+            size_t position_;
+        };
+
+        /**
+         * @brief Construct an empty view
+         */
+        BasicMessageView() = default;
+
+        /**
+         * @brief Construct a view on the selected messages
+         * @param messages List of all messages dispatched in the event
+         * @param indices Indices of the selected messages
+         */
+        BasicMessageView(const DispatchedMessageList* messages, const MessageIndexList* indices)
+            : messages_(messages), indices_(indices) {}
+
+        iterator begin() const { return {messages_, indices_, 0}; }
+        iterator end() const { return {messages_, indices_, size()}; }
+
+        size_t size() const { return indices_ == nullptr ? 0 : indices_->size(); }
+        bool empty() const { return size() == 0; }
+
+        /**
+         * @brief Access a selected message
+         * @param position Position of the message in the view
+         * @return Element for the message
+         */
+        Element operator[](size_t position) const { return *iterator(messages_, indices_, position); }
+
+    private:
+        const DispatchedMessageList* messages_{nullptr};
+        const MessageIndexList* indices_{nullptr};
+    };
+
+    /**
+     * @brief Conversion of a dispatched message to a shared pointer of the message type
+     */
+    template <typename T> struct ResolveMessage {
+        std::shared_ptr<T> operator()(const DispatchedMessage& message) const {
+            return std::static_pointer_cast<T>(message.first);
+        }
+    };
+    /**
+     * @brief Conversion of a dispatched message to a reference to the message with its name
+     */
+    struct ResolveDispatchedMessage {
+        const DispatchedMessage& operator()(const DispatchedMessage& message) const { return message; }
+    };
+
+    /**
+     * @brief View on multiple messages of the same type, providing shared pointers to the messages
+     */
+    template <typename T> using MessageView = BasicMessageView<std::shared_ptr<T>, ResolveMessage<T>>;
+
+    /**
+     * @brief View on filtered messages, providing references to pairs of the message and its name
+     */
+    using FilteredMessageView = BasicMessageView<const DispatchedMessage&, ResolveDispatchedMessage>;
+} // namespace allpix
+
+#endif /* ALLPIX_MESSAGE_VIEW_H */
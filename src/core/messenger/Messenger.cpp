@@ -10,16 +10,27 @@
 
 #include "Messenger.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <map>
 #include <memory>
+#include <set>
 #include <stdexcept>
 #include <string>
 #include <typeindex>
+#include <vector>
+
+#include <TBufferFile.h>
 
 #include "Message.hpp"
 #include "core/module/Module.hpp"
 #include "core/utils/log.h"
+#include "core/utils/profiling.h"
 #include "core/utils/type.h"
 #include "delegates.h"
+#include "tools/ROOT.h"
 
 using namespace allpix;
 
@@ -45,14 +56,16 @@ static bool check_send(BaseMessage* message, BaseDelegate* delegate) {
  * Messages should be bound during construction, so this function only gives useful information outside the constructor
  */
 bool Messenger::hasReceiver(Module* source, const std::shared_ptr<BaseMessage>& message) {
+    // Get the name of the output message
+    return hasReceiver(source, message, source->get_configuration().get<std::string>("output"));
+}
+
+bool Messenger::hasReceiver(Module*, const std::shared_ptr<BaseMessage>& message, const std::string& name) {
     std::lock_guard<std::mutex> lock(mutex_);
 
     const BaseMessage* inst = message.get();
     std::type_index type_idx = typeid(*inst);
 
-    // Get the name of the output message
-    auto name = source->get_configuration().get<std::string>("output");
-
     // Check if a normal specific listener exists
     for(auto& delegate : delegates_[type_idx][name]) {
         if(check_send(message.get(), delegate.get())) {
@@ -86,6 +99,11 @@ bool Messenger::isSatisfied(BaseDelegate* delegate, Event* event) const {
     return local_messenger->isSatisfied(delegate);
 }
 
+bool Messenger::isSatisfied(const Module* module, Event* event) const {
+    auto* local_messenger = event->get_local_messenger();
+    return local_messenger->isSatisfied(module);
+}
+
 void Messenger::add_delegate(const std::type_info& message_type,
                              Module* module,
                              const std::shared_ptr<BaseDelegate>& delegate) {
@@ -103,7 +121,8 @@ void Messenger::add_delegate(const std::type_info& message_type,
     delegates_[std::type_index(message_type)][message_name].push_back(delegate);
     auto delegate_iter = --delegates_[std::type_index(message_type)][message_name].end();
     delegate_to_iterator_.emplace(delegate_iter->get(),
-                                  std::make_tuple(std::type_index(message_type), message_name, delegate_iter));
+                                  std::make_tuple(std::type_index(message_type), message_name, delegate_iter, module));
+    routes_.reset();
 
     // Add delegate to the module itself
     module->add_delegate(this, delegate_iter->get());
@@ -121,121 +140,472 @@ void Messenger::remove_delegate(BaseDelegate* delegate) {
     }
     delegates_[std::get<0>(iter->second)][std::get<1>(iter->second)].erase(std::get<2>(iter->second));
     delegate_to_iterator_.erase(iter);
+    routes_.reset();
 }
 
-std::vector<std::pair<std::shared_ptr<BaseMessage>, std::string>> Messenger::fetchFilteredMessages(Module* module,
-                                                                                                   Event* event) {
+void Messenger::compileRoutes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    compile_routes();
+}
+
+std::shared_ptr<const Messenger::RoutingTable> Messenger::get_routes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(routes_ == nullptr) {
+        compile_routes();
+    }
+    return routes_;
+}
+
+/**
+ * Every receiving module is assigned one destination per message type it listens to. For every message type and every
+ * message name with specific receivers, the routes are ordered as specific receivers of the type, specific receivers of all
+ * messages, generic receivers of the type and generic receivers of all messages. Messages of types without any specific
+ * receivers are routed through the table of the base message. The routes of every combination are then grouped by the
+ * detector of the receiver, such that dispatching a message only visits the receivers of its own detector.
+ */
+void Messenger::compile_routes() {
+    auto table = std::make_shared<RoutingTable>();
+
+    // Assign the destinations of all delegates
+    std::map<std::pair<const Module*, std::type_index>, size_t> destinations;
+    for(const auto& delegate : delegate_to_iterator_) {
+        auto key = std::make_pair(std::get<3>(delegate.second), std::get<0>(delegate.second));
+        auto iter = destinations.emplace(key, destinations.size()).first;
+        table->delegate_destinations.emplace(delegate.first, iter->second);
+    }
+    for(const auto& destination : destinations) {
+        table->module_destinations[destination.first.first].emplace_back(destination.first.second, destination.second);
+    }
+    table->destinations = destinations.size();
+
+    // Collect the destinations of the required delegates of every module in one bit mask per module
+    table->mask_words = (table->destinations + 63) / 64;
+    for(const auto& delegate : delegate_to_iterator_) {
+        if(!delegate.first->isRequired()) {
+            continue;
+        }
+        auto mask = table->module_requirements.emplace(std::get<3>(delegate.second), table->requirement_masks.size());
+        if(mask.second) {
+            table->requirement_masks.resize(table->requirement_masks.size() + table->mask_words);
+        }
+        auto destination = table->delegate_destinations.at(delegate.first);
+        table->requirement_masks[mask.first->second + destination / 64] |= (uint64_t(1) << (destination % 64));
+    }
+
+    // Collect the names with specific receivers
+    auto names_for = [&](std::type_index type_idx) {
+        std::set<std::string> names;
+        auto iter = delegates_.find(type_idx);
+        if(iter != delegates_.end()) {
+            for(const auto& name : iter->second) {
+                if(name.first != "*" && !name.second.empty()) {
+                    names.insert(name.first);
+                }
+            }
+        }
+        return names;
+    };
+    // Group the routes of a range by detector, keeping the order of the routes to the same destination
+    auto group = [&](RouteRange& range) {
+        auto first = table->routes.begin() + static_cast<std::ptrdiff_t>(range.begin);
+        auto last = table->routes.begin() + static_cast<std::ptrdiff_t>(range.end);
+        std::stable_sort(first, last, [](const Route& lhs, const Route& rhs) {
+            if(lhs.detector == nullptr || rhs.detector == nullptr) {
+                return lhs.detector == nullptr && rhs.detector != nullptr;
+            }
+            return lhs.detector->getName() < rhs.detector->getName();
+        });
+        range.detector_begin = range.end;
+        for(auto i = range.begin; i < range.end; ++i) {
+            const auto& detector = table->routes[i].detector;
+            if(detector == nullptr) {
+                continue;
+            }
+            range.detector_begin = std::min(range.detector_begin, i);
+            auto& detector_range = range.detectors.emplace(detector->getName(), std::make_pair(i, i)).first->second;
+            detector_range.second = i + 1;
+        }
+    };
+    auto append = [&](std::type_index type_idx, const std::string& name) {
+        auto type_iter = delegates_.find(type_idx);
+        if(type_iter == delegates_.end()) {
+            return;
+        }
+        auto name_iter = type_iter->second.find(name);
+        if(name_iter == type_iter->second.end()) {
+            return;
+        }
+        for(const auto& delegate : name_iter->second) {
+            auto destination = table->delegate_destinations.at(delegate.get());
+            table->routes.push_back({delegate.get(), delegate->getDetector(), destination});
+        }
+    };
+    auto build = [&](std::type_index type_idx) {
+        const std::type_index base_idx = typeid(BaseMessage);
+        TypeRoutes type_routes;
+
+        auto names = names_for(base_idx);
+        if(type_idx != base_idx) {
+            names.merge(names_for(type_idx));
+        }
+        for(const auto& name : names) {
+            RouteRange range;
+            range.begin = table->routes.size();
+            if(type_idx != base_idx) {
+                append(type_idx, name);
+            }
+            append(base_idx, name);
+            if(type_idx != base_idx) {
+                append(type_idx, "*");
+            }
+            append(base_idx, "*");
+            range.end = table->routes.size();
+            group(range);
+            type_routes.named.emplace(name, std::move(range));
+        }
+
+        type_routes.generic.begin = table->routes.size();
+        if(type_idx != base_idx) {
+            append(type_idx, "*");
+        }
+        append(base_idx, "*");
+        type_routes.generic.end = table->routes.size();
+        group(type_routes.generic);
+        return type_routes;
+    };
+
+    for(const auto& type : delegates_) {
+        if(type.first != typeid(BaseMessage)) {
+            table->types.emplace(type.first, build(type.first));
+        }
+    }
+    table->base = build(typeid(BaseMessage));
+
+    LOG(TRACE) << "Compiled message routing table with " << table->routes.size() << " routes to "
+               << table->destinations << " destinations";
+    routes_ = std::move(table);
+}
+
+const Messenger::RouteRange& Messenger::RoutingTable::find(std::type_index type_idx, const std::string& name) const {
+    auto type_iter = types.find(type_idx);
+    const auto& type_routes = (type_iter != types.end() ? type_iter->second : base);
+    auto name_iter = type_routes.named.find(name);
+    return (name_iter != type_routes.named.end() ? name_iter->second : type_routes.generic);
+}
+
+size_t Messenger::RoutingTable::destination(const Module* module, std::type_index type_idx) const {
+    for(const auto& destination : module_destinations.at(module)) {
+        if(destination.first == type_idx) {
+            return destination.second;
+        }
+    }
+    throw std::out_of_range("module does not receive messages of the requested type");
+}
+
+FilteredMessageView Messenger::fetchFilteredMessages(Module* module, Event* event) {
     try {
         auto* local_messenger = event->get_local_messenger();
         return local_messenger->fetchFilteredMessages(module);
     } catch(const std::out_of_range& e) {
-        // No messages available after filtering, return empty vector:
+        // No messages available after filtering, return empty view:
         return {};
     }
 }
 
-LocalMessenger::LocalMessenger(Messenger& global_messenger) : global_messenger_(global_messenger) {}
+LocalMessenger::LocalMessenger(Messenger& global_messenger) {
+    reset(global_messenger);
+}
+
+/**
+ * The routing table is taken again from the global messenger, as the modules might have changed since the last event
+ */
+void LocalMessenger::reset(Messenger& global_messenger) {
+    clear();
+    routes_ = global_messenger.get_routes();
+    release_messages_ = global_messenger.release_messages_;
+    skip_empty_messages_ = global_messenger.skip_empty_messages_;
+    destinations_.resize(routes_->destinations);
+    received_.resize(routes_->mask_words);
+}
+
+void LocalMessenger::clear() {
+    for(auto& destination : destinations_) {
+        destination.received = false;
+        destination.single = DelegateTypes::none;
+        destination.multi.clear();
+        destination.filter_multi.clear();
+    }
+    std::fill(received_.begin(), received_.end(), 0);
+    sent_messages_.clear();
+    pending_receivers_.clear();
+    message_sizes_.clear();
+    message_memory_ = 0;
+    spilled_memory_ = 0;
+}
 
+/**
+ * The message is stored once in the list of dispatched messages, its receivers only store its index in this list
+ */
 void LocalMessenger::dispatchMessage(Module* source, std::shared_ptr<BaseMessage> message, std::string name) { // NOLINT
+    ALLPIX_PROFILE_ZONE("Messenger::dispatchMessage");
+
     // Get the name of the output message
     if(name == "-") {
         name = source->get_configuration().get<std::string>("output");
     }
 
-    bool send = false;
+    // Create type identifier from the typeid
+    const BaseMessage* inst = message.get();
+    std::type_index type_idx = typeid(*inst);
+    assert(typeid(BaseMessage) != typeid(*inst));
+
+    // Drop empty messages, skipping all modules requiring them
+    if(skip_empty_messages_ && message->isEmpty()) {
+        LOG(TRACE) << "Dropping empty message " << allpix::demangle(type_idx.name()) << " from " << source->getUniqueName();
+        return;
+    }
 
-    // Send messages to specific listeners
-    send = dispatchMessage(source, message, name, name) || send;
+    // Save the message in the list of dispatched messages
+    auto index = sent_messages_.size();
+    auto size = message->getSizeHint();
+    message_memory_ += size;
+    message_sizes_.emplace_back(source, size);
+    sent_messages_.emplace_back(std::move(message), std::move(name));
+    pending_receivers_.push_back(0);
+    const auto& sent_message = sent_messages_.back();
 
-    // Send to generic listeners
-    send = dispatchMessage(source, message, name, "*") || send;
+    // Send the message to all receivers bound to no detector at all and to the ones bound to the same detector
+    bool send = false;
+    auto deliver = [&](size_t first, size_t last) {
+        for(auto i = first; i < last; ++i) {
+            const auto& route = routes_->routes[i];
+
+            LOG(TRACE) << "Sending message " << allpix::demangle(type_idx.name()) << " from " << source->getUniqueName()
+                       << " to " << route.delegate->getUniqueName();
+            auto& dest = destinations_[route.destination];
+            dest.received = true;
+            received_[route.destination / 64] |= (uint64_t(1) << (route.destination % 64));
+            route.delegate->process(sent_message.first, index, sent_message.second, dest);
+            send = true;
+
+            // Count the receivers which stored the message and are going to fetch it
+            if(dest.single == index || (!dest.multi.empty() && dest.multi.back() == index) ||
+               (!dest.filter_multi.empty() && dest.filter_multi.back() == index)) {
+                ++pending_receivers_[index];
+            }
+        }
+    };
+    const auto& range = routes_->find(type_idx, sent_message.second);
+    deliver(range.begin, range.detector_begin);
+    auto detector = sent_message.first->getDetector();
+    if(detector != nullptr) {
+        auto detector_iter = range.detectors.find(detector->getName());
+        if(detector_iter != range.detectors.end()) {
+            deliver(detector_iter->second.first, detector_iter->second.second);
+        }
+    }
 
     // Display a TRACE log message if the message is send to no receiver
     if(!send) {
-        const BaseMessage* inst = message.get();
-        LOG(TRACE) << "Dispatched message " << allpix::demangle(typeid(*inst).name()) << " from " << source->getUniqueName()
+        LOG(TRACE) << "Dispatched message " << allpix::demangle(type_idx.name()) << " from " << source->getUniqueName()
                    << " has no receivers!";
     }
+}
+
+/**
+ * Messages without receivers, such as the Monte Carlo particles only referenced by the history of other objects, and
+ * messages overwritten in the destination of a receiver are not counted down and are kept until the end of the event.
+ */
+void LocalMessenger::releaseMessages(const Module* module) {
+    if(!release_messages_) {
+        return;
+    }
+    auto iter = routes_->module_destinations.find(module);
+    if(iter == routes_->module_destinations.end()) {
+        return;
+    }
 
-    // Save a copy of the sent message
-    sent_messages_.emplace_back(message);
+    auto release = [&](size_t index) {
+        if(--pending_receivers_[index] == 0) {
+            message_memory_ -= message_sizes_[index].second;
+            sent_messages_[index].first.reset();
+        }
+    };
+    for(const auto& destination : iter->second) {
+        auto& dest = destinations_[destination.second];
+        if(!dest.received) {
+            continue;
+        }
+        if(dest.single != DelegateTypes::none) {
+            release(dest.single);
+        }
+        std::for_each(dest.multi.begin(), dest.multi.end(), release);
+        std::for_each(dest.filter_multi.begin(), dest.filter_multi.end(), release);
+
+        // The module does not fetch the messages anymore, forget them
+        dest.received = false;
+        received_[destination.second / 64] &= ~(uint64_t(1) << (destination.second % 64));
+        dest.single = DelegateTypes::none;
+        dest.multi.clear();
+        dest.filter_multi.clear();
+    }
 }
 
-bool LocalMessenger::dispatchMessage(Module* source,
-                                     const std::shared_ptr<BaseMessage>& message,
-                                     const std::string& name,
-                                     const std::string& id) {
-    bool send = false;
+std::vector<std::pair<const Module*, size_t>> LocalMessenger::getDispatchedMemory() const {
+    std::vector<std::pair<const Module*, size_t>> module_memory;
+    for(const auto& [module, size] : message_sizes_) {
+        auto iter = std::find_if(module_memory.begin(), module_memory.end(), [module = module](const auto& entry) {
+            return entry.first == module;
+        });
+        if(iter == module_memory.end()) {
+            module_memory.emplace_back(module, size);
+        } else {
+            iter->second += size;
+        }
+    }
+    return module_memory;
+}
 
-    // Create type identifier from the typeid
-    const BaseMessage* inst = message.get();
-    std::type_index type_idx = typeid(*inst);
+/**
+ * All objects are marked for storage and their history is petrified before streaming them, such that the references between
+ * the objects of different messages are restored from their ROOT references once the messages have been read back. The mark
+ * is removed again before streaming from the objects which have not been marked before, such that modules storing objects
+ * only write references to objects they store themselves. The ROOT process lock is held while the references are created
+ * and streamed, as the ROOTObjectWriter and ROOTObjectReader modules handle references of other events concurrently. Events
+ * containing messages without ROOT dictionary are never written.
+ */
+bool LocalMessenger::spillMessages(const std::string& file_name) {
+    if(!std::all_of(sent_messages_.begin(), sent_messages_.end(), [](const auto& message) {
+           return message.first == nullptr || message.first->isStreamable();
+       })) {
+        return false;
+    }
 
-    // Retrieve listeners for the given message type and name
-    const auto msg_type_iterator = global_messenger_.delegates_.find(type_idx);
-    if(msg_type_iterator != global_messenger_.delegates_.end()) {
-        const auto msg_name_iterator = msg_type_iterator->second.find(id);
-        if(msg_name_iterator != msg_type_iterator->second.end()) {
-            // Send messages only to their specific listeners
-            for(const auto& delegate : msg_name_iterator->second) {
-                if(check_send(message.get(), delegate.get())) {
-                    LOG(TRACE) << "Sending message " << allpix::demangle(type_idx.name()) << " from "
-                               << source->getUniqueName() << " to " << delegate->getUniqueName();
-                    // Construct BaseMessage where message should be stored
-                    auto& dest = messages_[delegate->getUniqueName()][type_idx];
-
-                    delegate->process(message, name, dest);
-                    send = true;
+    auto root_lock = root_process_lock();
+    std::vector<Object*> unmarked_objects;
+    for(auto& [message, name] : sent_messages_) {
+        if(message != nullptr) {
+            for(auto& object : message->getObjects()) {
+                if(!object.isMarkedForStorage()) {
+                    unmarked_objects.push_back(&object);
+                    object.markForStorage();
                 }
             }
         }
     }
-
-    // Dispatch to base message listeners
-    assert(typeid(BaseMessage) != typeid(*inst));
-    const auto base_msg_type_iterator = global_messenger_.delegates_.find(typeid(BaseMessage));
-    if(base_msg_type_iterator != global_messenger_.delegates_.end()) {
-        const auto msg_name_iterator = base_msg_type_iterator->second.find(id);
-        if(msg_name_iterator != base_msg_type_iterator->second.end()) {
-            for(const auto& delegate : msg_name_iterator->second) {
-                if(check_send(message.get(), delegate.get())) {
-                    LOG(TRACE) << "Sending message " << allpix::demangle(type_idx.name()) << " from "
-                               << source->getUniqueName() << " to generic listener " << delegate->getUniqueName();
-                    auto& dest = messages_[delegate->getUniqueName()][typeid(BaseMessage)];
-                    delegate->process(message, name, dest);
-                    send = true;
-                }
+    for(auto& [message, name] : sent_messages_) {
+        if(message != nullptr) {
+            for(auto& object : message->getObjects()) {
+                object.petrifyHistory();
             }
         }
     }
+    for(auto* object : unmarked_objects) {
+        object->unmarkForStorage();
+    }
 
-    return send;
+    TBufferFile buffer(TBuffer::kWrite);
+    for(auto& [message, name] : sent_messages_) {
+        if(message != nullptr) {
+            message->streamObjects(buffer);
+        }
+    }
+    spilled_memory_ = message_memory_;
+    message_memory_ = 0;
+
+    // Restore the objects directly from the buffer if the file cannot be written
+    std::ofstream file(file_name, std::ios::binary);
+    file.write(buffer.Buffer(), buffer.Length());
+    if(!file) {
+        LOG(WARNING) << "Cannot write messages to file " << file_name << ", keeping them in memory";
+        file.close();
+        std::filesystem::remove(file_name);
+        buffer.SetReadMode();
+        buffer.SetBufferOffset(0);
+        read_messages(buffer);
+        message_memory_ = spilled_memory_;
+        return false;
+    }
+    return true;
 }
 
-std::vector<std::pair<std::shared_ptr<BaseMessage>, std::string>> LocalMessenger::fetchFilteredMessages(Module* module) {
-    const std::type_index type_idx = typeid(BaseMessage);
-    return messages_.at(module->getUniqueName()).at(type_idx).filter_multi;
+void LocalMessenger::restoreMessages(const std::string& file_name) {
+    std::ifstream file(file_name, std::ios::binary | std::ios::ate);
+    if(!file) {
+        throw RuntimeError("Cannot read spilled messages from file " + file_name);
+    }
+    std::vector<char> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(data.data(), static_cast<std::streamsize>(data.size()));
+    if(!file) {
+        throw RuntimeError("Cannot read spilled messages from file " + file_name);
+    }
+    file.close();
+    std::filesystem::remove(file_name);
+
+    TBufferFile buffer(TBuffer::kRead, static_cast<Int_t>(data.size()), data.data(), kFALSE);
+    auto root_lock = root_process_lock();
+    read_messages(buffer);
+    message_memory_ = spilled_memory_;
 }
 
-bool LocalMessenger::isSatisfied(BaseDelegate* delegate) const {
-    // check our records for messages for this module
-    const std::string name = delegate->getUniqueName();
-    auto messages_iter = messages_.find(name);
-    if(messages_iter == messages_.end()) {
-        return false;
+/**
+ * The history of the objects is resolved as in the ROOTObjectReader module, which requires the ROOT process lock to be held
+ * since the objects have been read from the buffer
+ */
+void LocalMessenger::read_messages(TBuffer& buffer) {
+    for(auto& [message, name] : sent_messages_) {
+        if(message != nullptr) {
+            message->streamObjects(buffer);
+        }
+    }
+    for(auto& [message, name] : sent_messages_) {
+        if(message != nullptr) {
+            for(auto& object : message->getObjects()) {
+                object.loadHistory();
+            }
+        }
+    }
+}
+
+const DelegateTypes& LocalMessenger::get_destination(const Module* module, std::type_index type_idx) const {
+    const auto& dest = destinations_[routes_->destination(module, type_idx)];
+    if(!dest.received) {
+        throw std::out_of_range("no messages received");
     }
+    return dest;
+}
+
+FilteredMessageView LocalMessenger::fetchFilteredMessages(Module* module) {
+    const auto& dest = get_destination(module, typeid(BaseMessage));
+    return {&sent_messages_, &dest.filter_multi};
+}
 
+bool LocalMessenger::isSatisfied(BaseDelegate* delegate) const {
     // check if this delegate is in our records
-    auto delegate_iter = global_messenger_.delegate_to_iterator_.find(delegate);
-    if(delegate_iter == global_messenger_.delegate_to_iterator_.end()) {
+    auto iter = routes_->delegate_destinations.find(delegate);
+    if(iter == routes_->delegate_destinations.end()) {
         throw std::out_of_range("delegate not found in listeners");
     }
 
     // check our records for messages for this delegate
-    auto iter = messages_iter->second.find(std::get<0>(delegate_iter->second));
-    if(iter == messages_iter->second.end()) {
-        return false;
+    return destinations_[iter->second].received;
+}
+
+/**
+ * Modules without required delegates have no mask in the routing table and are always satisfied
+ */
+bool LocalMessenger::isSatisfied(const Module* module) const {
+    auto iter = routes_->module_requirements.find(module);
+    if(iter == routes_->module_requirements.end()) {
+        return true;
     }
 
+    const auto* mask = routes_->requirement_masks.data() + iter->second;
+    for(size_t word = 0; word < routes_->mask_words; ++word) {
+        if((mask[word] & ~received_[word]) != 0) {
+            return false;
+        }
+    }
     return true;
 }
@@ -11,13 +11,17 @@
 #ifndef ALLPIX_MESSENGER_H
 #define ALLPIX_MESSENGER_H
 
+#include <cstdint>
 #include <list>
 #include <memory>
+#include <string>
 #include <typeindex>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "Message.hpp"
+#include "MessageView.hpp"
 #include "core/module/Event.hpp"
 #include "core/module/Module.hpp"
 #include "core/module/exceptions.h"
@@ -127,18 +131,17 @@ namespace allpix {
          * @brief Fetches multiple messages of specified type meant for the calling module
          * @param module Module to fetch the messages for
          * @param event Event to fetch the messages from
-         * @return Vector of shared pointers to messages
+         * @return View providing shared pointers to the messages, valid as long as the event exists
          */
-        template <typename T> std::vector<std::shared_ptr<T>> fetchMultiMessage(Module* module, Event* event);
+        template <typename T> MessageView<T> fetchMultiMessage(Module* module, Event* event);
 
         /**
          * @brief Fetches filtered messages meant for the calling module
          * @param module Module to fetch the messages for
          * @param event Event to fetch the messages from
-         * @return Vector of pairs containing shared pointer to and name of message
+         * @return View providing pairs of shared pointer to and name of message, valid as long as the event exists
          */
-        std::vector<std::pair<std::shared_ptr<BaseMessage>, std::string>> fetchFilteredMessages(Module* module,
-                                                                                                Event* event);
+        FilteredMessageView fetchFilteredMessages(Module* module, Event* event);
 
         /**
          * @brief Check if a specific message has a receiver
@@ -148,6 +151,15 @@ namespace allpix {
          */
         bool hasReceiver(Module* source, const std::shared_ptr<BaseMessage>& message);
 
+        /**
+         * @brief Check if a specific message has a receiver when dispatched with a name
+         * @param source Module that will send the message
+         * @param message Instantiation of the message to check
+         * @param name Name the message will be dispatched with
+         * @return True if the message has at least one receiver, false otherwise
+         */
+        bool hasReceiver(Module* source, const std::shared_ptr<BaseMessage>& message, const std::string& name);
+
         /**
          * @brief Check if a delegate has received its message
          * @param delegate Delegate to check if it was satisfied
@@ -156,7 +168,120 @@ namespace allpix {
          */
         bool isSatisfied(BaseDelegate* delegate, Event* event) const;
 
+        /**
+         * @brief Check if all required delegates of a module have received their messages
+         * @param module Module to check the messages for
+         * @param event Event to check the messages for this module
+         * @return True if satisfied, false otherwise
+         */
+        bool isSatisfied(const Module* module, Event* event) const;
+
+        /**
+         * @brief Compile the routing table of messages from all registered delegates
+         *
+         * The table is compiled automatically when the first event is created. Registering or removing delegates
+         * invalidates the table, such that it is recompiled for the next event. Events keep the table they were created
+         * with.
+         */
+        void compileRoutes();
+
+        /**
+         * @brief Enable releasing messages of an event as soon as all their receivers have been executed
+         * @param enable True if messages should be released early, false to keep them until the end of the event
+         *
+         * Only applies to events created afterwards. Objects in released messages cannot be accessed anymore, also not
+         * through the history of other objects.
+         */
+        void setReleaseMessages(bool enable) { release_messages_ = enable; }
+
+        /**
+         * @brief Enable dropping messages without any objects instead of delivering them
+         * @param enable True if empty messages should be dropped, false to deliver them like all other messages
+         *
+         * Only applies to events created afterwards. Modules requiring a dropped message are skipped for the event.
+         */
+        void setSkipEmptyMessages(bool enable) { skip_empty_messages_ = enable; }
+
     private:
+        /**
+         * @brief Receiver of a message together with the destination to store the message in
+         */
+        struct Route {
+            BaseDelegate* delegate;
+            std::shared_ptr<const Detector> detector;
+            size_t destination;
+        };
+
+        /**
+         * @brief Range of routes in the routing table
+         *
+         * The routes to receivers without detector come first, followed by the routes to the receivers of every detector.
+         * This allows to deliver a message of a detector without checking the receivers of all other detectors.
+         */
+        struct RouteRange {
+            size_t begin{};
+            size_t end{};
+            size_t detector_begin{};
+            std::unordered_map<std::string, std::pair<size_t, size_t>> detectors;
+        };
+
+        /**
+         * @brief Routes of a message type, for all message names with specific receivers and for all other names
+         */
+        struct TypeRoutes {
+            std::unordered_map<std::string, RouteRange> named;
+            RouteRange generic;
+        };
+
+        /**
+         * @brief Flat routing table of all messages
+         *
+         * The routes for every combination of message type and name are stored consecutively, in the order messages are
+         * distributed to their receivers. Every pair of receiving module and message type is assigned the index of the
+         * destination storing its messages in every event.
+         */
+        struct RoutingTable {
+            std::vector<Route> routes;
+            std::unordered_map<std::type_index, TypeRoutes> types;
+            TypeRoutes base;
+            std::unordered_map<const BaseDelegate*, size_t> delegate_destinations;
+            std::unordered_map<const Module*, std::vector<std::pair<std::type_index, size_t>>> module_destinations;
+            size_t destinations{};
+
+            // Bit masks of the destinations required by every module, stored consecutively with one mask per module
+            std::unordered_map<const Module*, size_t> module_requirements;
+            std::vector<uint64_t> requirement_masks;
+            size_t mask_words{};
+
+            /**
+             * @brief Find the routes of a message
+             * @param type_idx Type of the message
+             * @param name Name of the message
+             * @return Range of routes for the message
+             */
+            const RouteRange& find(std::type_index type_idx, const std::string& name) const;
+
+            /**
+             * @brief Find the destination of messages of a certain type for a module
+             * @param module Receiving module
+             * @param type_idx Type of the messages
+             * @return Index of the destination
+             * @throws std::out_of_range If the module does not receive messages of this type
+             */
+            size_t destination(const Module* module, std::type_index type_idx) const;
+        };
+
+        /**
+         * @brief Get the routing table, compiling it first if required
+         * @return Shared pointer to the routing table
+         */
+        std::shared_ptr<const RoutingTable> get_routes();
+
+        /**
+         * @brief Compile the routing table, should be called with the mutex locked
+         */
+        void compile_routes();
+
         /**
          * @brief Add a delegate to the listeners
          * @param message_type Type the delegate listens to
@@ -175,11 +300,19 @@ namespace allpix {
         using DelegateMap = std::map<std::type_index, std::map<std::string, std::list<std::shared_ptr<BaseDelegate>>>>;
         using DelegateIteratorMap =
             std::map<BaseDelegate*,
-                     std::tuple<std::type_index, std::string, std::list<std::shared_ptr<BaseDelegate>>::iterator>>;
+                     std::tuple<std::type_index,
+                                std::string,
+                                std::list<std::shared_ptr<BaseDelegate>>::iterator,
+                                const Module*>>;
 
         DelegateMap delegates_;
         DelegateIteratorMap delegate_to_iterator_;
 
+        std::shared_ptr<const RoutingTable> routes_;
+
+        bool release_messages_{false};
+        bool skip_empty_messages_{false};
+
         mutable std::mutex mutex_;
     };
 
@@ -187,17 +320,29 @@ namespace allpix {
      * @brief Responsible for the actual handling of messages between Modules.
      *
      * The local messenger is an internal object that is allocated for each thread separately. It handles dispatching
-     * and fetching messages between Modules.
+     * and fetching messages between Modules. It is cleared after every event and reused for later events on the same thread,
+     * such that its bookkeeping of the dispatched messages keeps its capacity.
      */
     class LocalMessenger {
     public:
+        /**
+         * @brief Construct the local messenger
+         * @param global_messenger Messenger holding the delegates of all modules
+         */
         explicit LocalMessenger(Messenger& global_messenger);
 
+        /**
+         * @brief Prepare the local messenger for a new event
+         * @param global_messenger Messenger holding the delegates of all modules
+         */
+        void reset(Messenger& global_messenger);
+
+        /**
+         * @brief Release all messages of the event while keeping the capacity of the bookkeeping
+         */
+        void clear();
+
         void dispatchMessage(Module* source, std::shared_ptr<BaseMessage> message, std::string name);
-        bool dispatchMessage(Module* source,
-                             const std::shared_ptr<BaseMessage>& message,
-                             const std::string& name,
-                             const std::string& id);
 
         /**
          * @brief Check if a delegate has received its message
@@ -205,6 +350,13 @@ namespace allpix {
          */
         bool isSatisfied(BaseDelegate* delegate) const;
 
+        /**
+         * @brief Check if all required delegates of a module have received their messages
+         * @param module Module to check the messages for
+         * @return True if satisfied, false otherwise
+         */
+        bool isSatisfied(const Module* module) const;
+
         /**
          * @brief Fetches a single message of specified type meant for the calling module
          * @return Shared pointer to message
@@ -213,22 +365,89 @@ namespace allpix {
 
         /**
          * @brief Fetches multiple messages of specified type meant for the calling module
-         * @return Vector of shared pointers to messages
+         * @return View providing shared pointers to the messages
          */
-        template <typename T> std::vector<std::shared_ptr<T>> fetchMultiMessage(Module* module);
+        template <typename T> MessageView<T> fetchMultiMessage(Module* module);
 
         /**
          * @brief Fetches filtered messages meant for the calling module
-         * @return Vector of pairs containing shared pointer to and name of message
+         * @return View providing pairs of shared pointer to and name of message
+         */
+        FilteredMessageView fetchFilteredMessages(Module* module);
+
+        /**
+         * @brief Release the messages received by a module which are not awaited by any other receiver anymore
+         * @param module Module which has been executed or skipped for this event
+         *
+         * Only has an effect if releasing messages is enabled in the global messenger.
+         */
+        void releaseMessages(const Module* module);
+
+        /**
+         * @brief Get an estimate of the memory held by the contents of the messages of this event which are still alive
+         * @return Sum of the size hints of the dispatched messages which have not been released, in bytes
+         */
+        size_t getMessageMemory() const { return message_memory_; }
+
+        /**
+         * @brief Get an estimate of the memory of the messages dispatched by every module for this event
+         * @return Sum of the size hints of the messages dispatched by every module, including released messages, in bytes
+         */
+        std::vector<std::pair<const Module*, size_t>> getDispatchedMemory() const;
+
+        /**
+         * @brief Write the objects of all messages to a file and release their memory, e.g. while the event is buffered
+         * @param file_name Path of the file
+         * @return True if the objects have been written, false if a message cannot be streamed or the file not written
          */
-        std::vector<std::pair<std::shared_ptr<BaseMessage>, std::string>> fetchFilteredMessages(Module* module);
+        bool spillMessages(const std::string& file_name);
+
+        /**
+         * @brief Restore the objects of all messages from the file written by \ref spillMessages and remove the file
+         * @param file_name Path of the file
+         * @throws RuntimeError If the file cannot be read
+         */
+        void restoreMessages(const std::string& file_name);
 
     private:
-        // The global messenger which contains the shared delegate information
-        const Messenger& global_messenger_;
+        /**
+         * @brief Get the destination of messages of the given type for a receiving module
+         * @param module Receiving module
+         * @param type_idx Type of the message
+         * @return Destination storing the messages
+         * @throws std::out_of_range If no message has been received for this module and type
+         */
+        const DelegateTypes& get_destination(const Module* module, std::type_index type_idx) const;
+
+        /**
+         * @brief Read the objects of all messages from a buffer and resolve their history
+         * @param buffer ROOT buffer in read mode holding the objects written by \ref spillMessages
+         */
+        void read_messages(TBuffer& buffer);
+
+        // Routing table of the global messenger
+        std::shared_ptr<const Messenger::RoutingTable> routes_;
+
+        // Destinations of the messages for all receivers, indexed by the routing table
+        std::vector<DelegateTypes> destinations_;
+
+        // Bit mask of the destinations which hold received messages, compared against the masks of the routing table
+        std::vector<uint64_t> received_;
+        DispatchedMessageList sent_messages_;
+
+        // Release messages after all their receivers have been executed, and the number of receivers not executed yet
+        bool release_messages_{};
+        std::vector<size_t> pending_receivers_;
+
+        // Drop messages without objects, such that their receivers are not satisfied
+        bool skip_empty_messages_{};
+
+        // Memory held by the contents of the messages not released yet, and the source and size hint of every message
+        size_t message_memory_{};
+        std::vector<std::pair<const Module*, size_t>> message_sizes_;
 
-        std::unordered_map<std::string, std::unordered_map<std::type_index, DelegateTypes>> messages_;
-        std::vector<std::shared_ptr<BaseMessage>> sent_messages_;
+        // Memory of the messages before their objects have been written to a file
+        size_t spilled_memory_{};
     };
 } // namespace allpix
 
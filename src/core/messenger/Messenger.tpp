@@ -47,8 +47,7 @@ namespace allpix {
 
     template <typename T>
     void Messenger::dispatchMessage(Module* module, std::shared_ptr<T> message, Event* event, const std::string& name) {
-        auto* local_messenger = event->get_local_messenger();
-        local_messenger->dispatchMessage(module, message, name);
+        event->dispatch_message(module, message, name);
     }
 
     template <typename T> std::shared_ptr<T> Messenger::fetchMessage(Module* module, Event* event) {
@@ -60,7 +59,7 @@ namespace allpix {
         }
     }
 
-    template <typename T> std::vector<std::shared_ptr<T>> Messenger::fetchMultiMessage(Module* module, Event* event) {
+    template <typename T> MessageView<T> Messenger::fetchMultiMessage(Module* module, Event* event) {
         try {
             auto* local_messenger = event->get_local_messenger();
             return local_messenger->fetchMultiMessage<T>(module);
@@ -71,26 +70,17 @@ namespace allpix {
 
     template <typename T> std::shared_ptr<T> LocalMessenger::fetchMessage(Module* module) {
         static_assert(std::is_base_of<BaseMessage, T>::value, "Fetched message should inherit from Message class");
-        std::type_index type_idx = typeid(T);
-        return std::static_pointer_cast<T>(messages_.at(module->getUniqueName()).at(type_idx).single);
+        const auto& dest = get_destination(module, typeid(T));
+        if(dest.single == DelegateTypes::none) {
+            return nullptr;
+        }
+        return std::static_pointer_cast<T>(sent_messages_[dest.single].first);
     }
 
-    template <typename T> std::vector<std::shared_ptr<T>> LocalMessenger::fetchMultiMessage(Module* module) {
+    template <typename T> MessageView<T> LocalMessenger::fetchMultiMessage(Module* module) {
         static_assert(std::is_base_of<BaseMessage, T>::value, "Fetched message should inherit from Message class");
-
-        // TODO: do nothing if T == BaseMessage; there is no need to cast (optimized out)?
-        std::type_index type_idx = typeid(T);
-
-        // Construct an empty vector in case no previous modules created one during dispatch
-        auto base_messages = messages_.at(module->getUniqueName()).at(type_idx).multi;
-
-        std::vector<std::shared_ptr<T>> derived_messages;
-        derived_messages.reserve(base_messages.size());
-        for(auto& message : base_messages) {
-            derived_messages.push_back(std::static_pointer_cast<T>(message));
-        }
-
-        return derived_messages;
+        const auto& dest = get_destination(module, typeid(T));
+        return {&sent_messages_, &dest.multi};
     }
 
 } // namespace allpix
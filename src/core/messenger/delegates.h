@@ -17,9 +17,11 @@
 #define ALLPIX_DELEGATE_H
 
 #include <cassert>
+#include <cstdint>
 #include <memory>
 #include <typeinfo>
 #include <utility>
+#include <vector>
 
 #include "Message.hpp"
 #include "core/geometry/Detector.hpp"
@@ -32,12 +34,16 @@ namespace allpix {
      * @ingroup Delegates
      * @brief Container of the different delegate types
      *
-     * A properly implemented delegate should only touch one of these fields.
+     * A properly implemented delegate should only touch one of these fields. Messages are referred to by their index in the
+     * list of messages dispatched in the event, such that distributing a message to its receivers does not copy it.
      */
     struct DelegateTypes { // NOLINT
-        std::shared_ptr<BaseMessage> single;
-        std::vector<std::shared_ptr<BaseMessage>> multi;
-        std::vector<std::pair<std::shared_ptr<BaseMessage>, std::string>> filter_multi;
+        static constexpr size_t none = SIZE_MAX;
+
+        bool received{false};
+        size_t single{none};
+        std::vector<size_t> multi;
+        std::vector<size_t> filter_multi;
     };
     /**
      * @ingroup Delegates
@@ -137,10 +143,12 @@ namespace allpix {
         /**
          * @brief Process a message and forward it to its final destination
          * @param msg Message to process
+         * @param index Index of the message in the list of messages dispatched in the event
          * @param name Name of the message
          * @param dest Destination of the message
          */
-        virtual void process(std::shared_ptr<BaseMessage> msg, std::string name, DelegateTypes& dest) = 0;
+        virtual void
+        process(const std::shared_ptr<BaseMessage>& msg, size_t index, const std::string& name, DelegateTypes& dest) = 0;
 
     protected:
         MsgFlags flags_;
@@ -196,7 +204,7 @@ namespace allpix {
          * @brief Stores the received message in the delegate until the end of the event
          * @param msg Message to store
          */
-        void process(std::shared_ptr<BaseMessage> msg, std::string, DelegateTypes&) override {
+        void process(const std::shared_ptr<BaseMessage>& msg, size_t, const std::string&, DelegateTypes&) override {
             // Store the message and mark as processed
             messages_.push_back(msg);
         }
@@ -225,11 +233,13 @@ namespace allpix {
         /**
          * @brief Calls the filter function with the supplied message
          * @param msg Message to process
+         * @param index Index of the message in the event
          * @param dest Destination of the message
          * @warning The filter function is called directly from the delegate, no heavy processing should be done in the
          * filter function
          */
-        void process(std::shared_ptr<BaseMessage> msg, std::string, DelegateTypes& dest) override {
+        void
+        process(const std::shared_ptr<BaseMessage>& msg, size_t index, const std::string&, DelegateTypes& dest) override {
 #ifndef NDEBUG
             // The type names should have been correctly resolved earlier
             const BaseMessage* inst = msg.get();
@@ -237,7 +247,7 @@ namespace allpix {
 #endif
             // Filter the message, and store it if it should be kept
             if((this->obj_->*filter_)(std::static_pointer_cast<R>(msg))) {
-                dest.filter_multi.emplace_back(std::static_pointer_cast<R>(msg), "");
+                dest.filter_multi.push_back(index);
             }
         }
 
@@ -265,15 +275,19 @@ namespace allpix {
         /**
          * @brief Calls the filter function with the supplied message
          * @param msg Message to process
+         * @param index Index of the message in the event
          * @param name Name of the message
          * @param dest Destination of the message
          * @warning The filter function is called directly from the delegate, no heavy processing should be done in the
          * filter function
          */
-        void process(std::shared_ptr<BaseMessage> msg, std::string name, DelegateTypes& dest) override {
+        void process(const std::shared_ptr<BaseMessage>& msg,
+                     size_t index,
+                     const std::string& name,
+                     DelegateTypes& dest) override {
             // Filter the message, and store it if it should be kept
-            if((this->obj_->*filter_)(std::static_pointer_cast<BaseMessage>(msg), name)) {
-                dest.filter_multi.emplace_back(std::static_pointer_cast<BaseMessage>(msg), name);
+            if((this->obj_->*filter_)(msg, name)) {
+                dest.filter_multi.push_back(index);
             }
         }
 
@@ -297,25 +311,27 @@ namespace allpix {
         /**
          * @brief Saves the message in the passed destination
          * @param msg Message to process
+         * @param index Index of the message in the event
          * @param dest Destination of the message
          * @throws UnexpectedMessageException If this delegate has already received the message after the previous reset (not
          * thrown if the \ref MsgFlags::ALLOW_OVERWRITE "ALLOW_OVERWRITE" flag is passed)
          *
          * The saved value is overwritten if the \ref MsgFlags::ALLOW_OVERWRITE "ALLOW_OVERWRITE" flag is enabled.
          */
-        void process(std::shared_ptr<BaseMessage> msg, std::string, DelegateTypes& dest) override {
+        void
+        process(const std::shared_ptr<BaseMessage>& msg, size_t index, const std::string&, DelegateTypes& dest) override {
 #ifndef NDEBUG
             // The type names should have been correctly resolved earlier
             const BaseMessage* inst = msg.get();
             assert(typeid(*inst) == typeid(R));
 #endif
             // Raise an error if the message is overwritten (unless it is allowed)
-            if(dest.single != nullptr && (this->getFlags() & MsgFlags::ALLOW_OVERWRITE) == MsgFlags::NONE) {
+            if(dest.single != DelegateTypes::none && (this->getFlags() & MsgFlags::ALLOW_OVERWRITE) == MsgFlags::NONE) {
                 throw UnexpectedMessageException(this->obj_->getUniqueName(), typeid(R));
             }
 
             // Save the message
-            dest.single = std::static_pointer_cast<R>(msg);
+            dest.single = index;
         }
     };
 
@@ -335,16 +351,18 @@ namespace allpix {
         /**
          * @brief Adds the message to the bound vector
          * @param msg Message to process
+         * @param index Index of the message in the event
          * @param dest Destination of the message
          */
-        void process(std::shared_ptr<BaseMessage> msg, std::string, DelegateTypes& dest) override {
+        void
+        process(const std::shared_ptr<BaseMessage>& msg, size_t index, const std::string&, DelegateTypes& dest) override {
 #ifndef NDEBUG
             // The type names should have been correctly resolved earlier
             const BaseMessage* inst = msg.get();
             assert(typeid(*inst) == typeid(R));
 #endif
             // Add the message to the vector
-            dest.multi.push_back(std::static_pointer_cast<R>(msg));
+            dest.multi.push_back(index);
         }
     };
 } // namespace allpix
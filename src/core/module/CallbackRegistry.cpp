@@ -0,0 +1,42 @@
+/**
+ * @file
+ * @brief Implementation of the registry of event data callbacks
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "CallbackRegistry.hpp"
+
+#include <utility>
+
+using namespace allpix;
+
+std::mutex CallbackRegistry::mutex_;
+std::map<std::string, CallbackRegistry::Callback> CallbackRegistry::callbacks_;
+
+void CallbackRegistry::add(const std::string& name, Callback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    callbacks_[name] = std::move(callback);
+}
+
+void CallbackRegistry::remove(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    callbacks_.erase(name);
+}
+
+bool CallbackRegistry::has(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return callbacks_.count(name) != 0;
+}
+
+CallbackRegistry::Callback CallbackRegistry::get(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = callbacks_.find(name);
+    if(iter == callbacks_.end()) {
+        return {};
+    }
+    return iter->second;
+}
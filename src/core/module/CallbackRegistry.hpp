@@ -0,0 +1,82 @@
+/**
+ * @file
+ * @brief Registry of callbacks receiving the data of events from within the framework process
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_MODULE_CALLBACK_REGISTRY_H
+#define ALLPIX_MODULE_CALLBACK_REGISTRY_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace allpix {
+    /**
+     * @brief Contiguous array of flat records holding the objects of one message
+     *
+     * The records are plain data without pointers, such that they can be viewed from other languages without copying. The
+     * memory of the records is owned by the array and released once the last copy of it is destroyed.
+     */
+    struct RecordArray {
+        // Name of the object type of the records, e.g. "PixelHit"
+        std::string type;
+        // Name of the detector of the message, empty for messages without detector
+        std::string detector;
+        std::uint64_t event{};
+        std::shared_ptr<const void> data;
+        size_t count{};
+        size_t record_size{};
+    };
+
+    /**
+     * @brief Callbacks registered by the application embedding the framework, referred to by name from the configuration
+     *
+     * The registry is part of the core library, such that it is shared by the application and all module libraries loaded
+     * at run time.
+     */
+    class CallbackRegistry {
+    public:
+        using Callback = std::function<void(const RecordArray&)>;
+
+        /**
+         * @brief Register a callback, replacing a callback registered before with the same name
+         * @param name Name of the callback
+         * @param callback Function to call for every array of records
+         */
+        static void add(const std::string& name, Callback callback);
+
+        /**
+         * @brief Remove a callback from the registry
+         * @param name Name of the callback
+         */
+        static void remove(const std::string& name);
+
+        /**
+         * @brief Check if a callback is registered
+         * @param name Name of the callback
+         * @return True if a callback with this name exists
+         */
+        static bool has(const std::string& name);
+
+        /**
+         * @brief Return a registered callback
+         * @param name Name of the callback
+         * @return Copy of the callback, empty if no callback with this name exists
+         */
+        static Callback get(const std::string& name);
+
+    private:
+        static std::mutex mutex_;
+        static std::map<std::string, Callback> callbacks_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_MODULE_CALLBACK_REGISTRY_H */
@@ -15,6 +15,7 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "Module.hpp"
 #include "ModuleManager.hpp"
@@ -24,9 +25,45 @@
 using namespace allpix;
 
 std::mutex Event::stats_mutex_;
+thread_local Event::ConcurrentModule* Event::concurrent_module_ = nullptr;
 
-Event::Event(Messenger& messenger, uint64_t event_num, uint64_t seed) : number(event_num), seed_(seed) {
-    local_messenger_ = std::make_unique<LocalMessenger>(messenger);
+namespace {
+    // Number of local messengers kept per thread, covering events finished on the same thread before new ones are started
+    constexpr size_t maximum_pool_size = 64;
+
+    std::vector<std::unique_ptr<LocalMessenger>>& messenger_pool() {
+        static thread_local std::vector<std::unique_ptr<LocalMessenger>> pool;
+        return pool;
+    }
+} // namespace
+
+/**
+ * The local messenger is taken from the pool of the calling thread if available, such that its bookkeeping keeps the
+ * capacity reached in earlier events
+ */
+Event::Event(Messenger& messenger, uint64_t event_num, uint64_t seed)
+    : number(event_num), seed_(seed), arena_(EventArena::acquire()) {
+    auto& pool = messenger_pool();
+    if(pool.empty()) {
+        local_messenger_ = std::make_unique<LocalMessenger>(messenger);
+    } else {
+        local_messenger_ = std::move(pool.back());
+        pool.pop_back();
+        local_messenger_->reset(messenger);
+    }
+}
+
+/**
+ * The messages are released before the arena, such that the memory blocks of the arena return to the pool of the calling
+ * thread
+ */
+Event::~Event() {
+    local_messenger_->clear();
+
+    auto& pool = messenger_pool();
+    if(pool.size() < maximum_pool_size) {
+        pool.push_back(std::move(local_messenger_));
+    }
 }
 
 void Event::set_and_seed_random_engine(RandomNumberGenerator* random_engine) {
@@ -35,6 +72,10 @@ void Event::set_and_seed_random_engine(RandomNumberGenerator* random_engine) {
 }
 
 RandomNumberGenerator& Event::getRandomEngine() {
+    auto* concurrent_module = get_concurrent_module();
+    if(concurrent_module != nullptr) {
+        return concurrent_module->random_engine;
+    }
     if(random_engine_ == nullptr) {
         throw InvalidEventStateException("No PRNG available");
     }
@@ -42,20 +83,43 @@ RandomNumberGenerator& Event::getRandomEngine() {
 }
 
 void Event::store_random_engine_state() {
-    if(random_engine_ != nullptr && state_.rdbuf()->in_avail() == 0) {
+    if(random_engine_ != nullptr && !state_stored_) {
         LOG(PRNG) << "Storing PRNG state in event";
-        state_ << *random_engine_;
+        random_engine_->saveState(state_);
+        state_stored_ = true;
     }
 }
 
 void Event::restore_random_engine_state() {
-    if(random_engine_ != nullptr && state_.rdbuf()->in_avail() != 0) {
+    if(random_engine_ != nullptr && state_stored_) {
         LOG(PRNG) << "Restoring PRNG state from event";
-        state_ >> *random_engine_;
-        state_.clear();
+        random_engine_->restoreState(state_);
+        state_stored_ = false;
     }
 }
 
 LocalMessenger* Event::get_local_messenger() const {
     return local_messenger_.get();
 }
+
+const std::shared_ptr<EventArena>& Event::get_arena() const {
+    auto* concurrent_module = get_concurrent_module();
+    return (concurrent_module != nullptr ? concurrent_module->arena : arena_);
+}
+
+void Event::dispatch_message(Module* source, std::shared_ptr<BaseMessage> message, const std::string& name) {
+    auto* concurrent_module = get_concurrent_module();
+    if(concurrent_module != nullptr) {
+        concurrent_module->messages.emplace_back(source, std::move(message), name);
+    } else {
+        local_messenger_->dispatchMessage(source, std::move(message), name);
+    }
+}
+
+size_t Event::memory_hint() const {
+    auto capacity = arena_->capacity();
+    for(const auto& arena : concurrent_arenas_) {
+        capacity += arena->capacity();
+    }
+    return capacity + local_messenger_->getMessageMemory();
+}
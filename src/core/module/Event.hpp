@@ -11,14 +11,19 @@
 #define ALLPIX_MODULE_EVENT_H
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <list>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <random>
+#include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 
+#include "EventArena.hpp"
 #include "core/utils/prng.h"
 
 namespace allpix {
@@ -44,9 +49,9 @@ namespace allpix {
          */
         explicit Event(Messenger& messenger, uint64_t event_num, uint64_t seed);
         /**
-         * @brief Use default destructor
+         * @brief Release the messages of the event and keep its local messenger for reuse on the calling thread
          */
-        ~Event() = default;
+        ~Event();
 
         /// @{
         /**
@@ -73,7 +78,86 @@ namespace allpix {
          */
         uint64_t getRandomNumber() { return getRandomEngine()(); }
 
+        /**
+         * @brief Get an allocator handing out memory from the arena of this event
+         * @return Allocator for the requested type
+         * @note The allocator should only be used by the module currently processing the event and not by any subtasks
+         */
+        template <typename T> ArenaAllocator<T> getAllocator() const { return ArenaAllocator<T>(get_arena()); }
+
+        /**
+         * @brief Create an object managed by a shared pointer in the memory arena of this event
+         * @param args Arguments passed to the constructor of the object
+         * @return Shared pointer to the object
+         *
+         * Both the object and the control block of the shared pointer are allocated from the arena of this event, which is
+         * kept alive as long as the object is. This is the preferred way to create the messages dispatched for an event.
+         */
+        template <typename T, typename... Args> std::shared_ptr<T> makeShared(Args&&... args) const {
+            return std::allocate_shared<T>(getAllocator<T>(), std::forward<Args>(args)...);
+        }
+
+        /**
+         * @brief Reject this event, skipping all modules after the one currently processing it
+         *
+         * The module rejecting the event still finishes its run. The event is afterwards completed without running the
+         * remaining modules, such that neither later processing modules nor writers see it.
+         */
+        void reject() { rejected_ = true; }
+
+        /**
+         * @brief Check if this event has been rejected by a module
+         * @return True if the event is rejected, false otherwise
+         */
+        bool isRejected() const { return rejected_; }
+
     private:
+        /**
+         * @brief State of a module running concurrently with other modules of the same event
+         *
+         * Every concurrent module allocates from its own arena and uses its own random engine, the messages it dispatches are
+         * held back and dispatched to the local messenger once all concurrent modules of the event have finished.
+         */
+        struct ConcurrentModule {
+            /**
+             * @brief Construct the state of a concurrent module
+             * @param concurrent_event Event the module runs for
+             * @param engine Engine of the random number generator
+             * @param seed Seed of the random number generator, derived from the random engine of the event
+             */
+            ConcurrentModule(const Event* concurrent_event, RandomNumberGenerator::Engine engine, uint64_t seed)
+                : event(concurrent_event), arena(EventArena::acquire()), random_engine(engine) {
+                random_engine.seed(seed);
+            }
+
+            const Event* event;
+            std::shared_ptr<EventArena> arena;
+            RandomNumberGenerator random_engine;
+            std::vector<std::tuple<Module*, std::shared_ptr<BaseMessage>, std::string>> messages;
+        };
+
+        /**
+         * @brief Get the concurrent module of this event running on the calling thread
+         * @return Pointer to the state of the concurrent module, nullptr if no concurrent module of this event is running
+         */
+        ConcurrentModule* get_concurrent_module() const {
+            return (concurrent_module_ != nullptr && concurrent_module_->event == this ? concurrent_module_ : nullptr);
+        }
+
+        /**
+         * @brief Get the arena to allocate the objects of the module running on the calling thread from
+         * @return Arena of the concurrent module if any, otherwise the arena of the event
+         */
+        const std::shared_ptr<EventArena>& get_arena() const;
+
+        /**
+         * @brief Dispatch a message, or hold it back until the end of a concurrent module
+         * @param source Module dispatching the message
+         * @param message Message to dispatch
+         * @param name Name of the message
+         */
+        void dispatch_message(Module* source, std::shared_ptr<BaseMessage> message, const std::string& name);
+
         /**
          * @brief Sets the random engine and seed it to be used by this event
          * @param random_engine Pointer to RNG for this event
@@ -96,17 +180,49 @@ namespace allpix {
         // Seed for random number generator
         uint64_t seed_;
 
-        // State of the random number generator
-        std::stringstream state_;
+        // Binary snapshot of the random number generator while the event is suspended
+        RandomNumberGenerator::State state_;
+        bool state_stored_{false};
 
         /**
          * @brief Returns a pointer to the event local messenger
          */
         LocalMessenger* get_local_messenger() const;
 
+        /**
+         * @brief Get an estimate of the memory currently held by this event
+         * @return Size in bytes of the memory arena and the contents of the messages which are still alive
+         */
+        size_t memory_hint() const;
+
+        // Memory arena for the objects of this event, released after all of them have been destroyed
+        std::shared_ptr<EventArena> arena_;
+
         // Local messenger used to dispatch messages in this event
         std::unique_ptr<LocalMessenger> local_messenger_;
 
+        // Arenas of the concurrent modules, kept alive together with the event
+        std::vector<std::shared_ptr<EventArena>> concurrent_arenas_;
+
+        // Concurrent module running on the current thread
+        static thread_local ConcurrentModule* concurrent_module_;
+
+        // Creation of the event and the last time it was suspended, used for profiling
+        std::chrono::steady_clock::time_point start_time_;
+        std::chrono::steady_clock::time_point suspend_time_;
+
+        // Memory accounted to the buffer while this event is suspended
+        size_t buffered_memory_{};
+
+        // File holding the objects of the messages while this event is suspended, empty if they are kept in memory
+        std::string spill_file_;
+
+        // Flag set by a module to skip the remaining modules for this event
+        std::atomic<bool> rejected_{false};
+
+        // Execution time of every module run for this event in seconds, only recorded to report slow events
+        std::vector<std::pair<const Module*, long double>> module_times_;
+
         // Mutex for execution time
         static std::mutex stats_mutex_;
     };
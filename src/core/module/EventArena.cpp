@@ -0,0 +1,96 @@
+/**
+ * @file
+ * @brief Implementation of the event memory arena
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "EventArena.hpp"
+
+#include <algorithm>
+
+using namespace allpix;
+
+namespace {
+    // Blocks are allocated with at least this size and the first block does not grow beyond the maximum size
+    constexpr size_t minimum_block_size = size_t(64) << 10;
+    constexpr size_t maximum_block_size = size_t(64) << 20;
+    // Number of blocks kept per thread, covering events buffered on the same thread
+    constexpr size_t maximum_pool_size = 16;
+
+    /**
+     * @brief Blocks kept by a thread to be reused, together with the preferred size of the first block of an arena
+     */
+    struct BlockPool {
+        std::vector<std::pair<std::unique_ptr<std::byte[]>, size_t>> blocks;
+        size_t preferred_size{minimum_block_size};
+    };
+    BlockPool& thread_pool() {
+        static thread_local BlockPool pool;
+        return pool;
+    }
+} // namespace
+
+/**
+ * Blocks of the pool which are smaller than the currently preferred size are discarded, such that the arenas of a thread
+ * quickly converge to a single block covering a full event.
+ */
+std::shared_ptr<EventArena> EventArena::acquire() {
+    auto& pool = thread_pool();
+    while(!pool.blocks.empty()) {
+        auto block = std::move(pool.blocks.back());
+        pool.blocks.pop_back();
+        if(block.second >= pool.preferred_size) {
+            return std::shared_ptr<EventArena>(new EventArena({std::move(block.first), block.second}));
+        }
+    }
+    return std::shared_ptr<EventArena>(
+        new EventArena({std::unique_ptr<std::byte[]>(new std::byte[pool.preferred_size]), pool.preferred_size}));
+}
+
+EventArena::EventArena(Block block) : current_(block.data.get()), remaining_(block.size) {
+    blocks_.push_back(std::move(block));
+}
+
+/**
+ * If the event needed more than the first block, the preferred size of the first block is increased to the total capacity
+ * used and all blocks are released. Otherwise the first block is returned to the pool for reuse.
+ */
+EventArena::~EventArena() {
+    auto& pool = thread_pool();
+    if(blocks_.size() > 1) {
+        pool.preferred_size = std::clamp(capacity(), pool.preferred_size, maximum_block_size);
+        return;
+    }
+    if(pool.blocks.size() < maximum_pool_size) {
+        pool.blocks.emplace_back(std::move(blocks_.front().data), blocks_.front().size);
+    }
+}
+
+size_t EventArena::capacity() const {
+    size_t capacity = 0;
+    for(const auto& block : blocks_) {
+        capacity += block.size;
+    }
+    return capacity;
+}
+
+/**
+ * Blocks grow geometrically with the capacity of the arena. Large allocations receive a dedicated block, such that the
+ * remainder of the current block can still be used for subsequent small allocations.
+ */
+void* EventArena::allocate_block(size_t bytes, size_t alignment) {
+    auto size = std::max(std::min(capacity(), maximum_block_size), bytes + alignment);
+    blocks_.push_back({std::unique_ptr<std::byte[]>(new std::byte[size]), size});
+    auto* data = blocks_.back().data.get();
+
+    auto offset = (alignment - reinterpret_cast<uintptr_t>(data) % alignment) % alignment;
+    if(size - offset - bytes >= remaining_) {
+        current_ = data + offset + bytes;
+        remaining_ = size - offset - bytes;
+    }
+    return data + offset;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file
+ * @brief Memory arena for objects living as long as a single event
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_MODULE_EVENT_ARENA_H
+#define ALLPIX_MODULE_EVENT_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace allpix {
+    /**
+     * @brief Memory arena handing out memory for the objects of a single event
+     *
+     * Memory is handed out sequentially from large blocks and is only released as a whole when the arena is destroyed, which
+     * turns the many small allocations of an event into a few large ones. The blocks of destroyed arenas are kept in a pool
+     * local to the destroying thread and reused by the next arena acquired on that thread. The size of the first block
+     * adapts to the total memory used by earlier events, such that an event usually fits into a single block.
+     *
+     * @warning Allocating from an arena is not thread-safe, an arena should only be used by the thread processing its event
+     */
+    class EventArena {
+    public:
+        /**
+         * @brief Acquire an arena, reusing a memory block from the pool of the calling thread if available
+         * @return Shared pointer to the arena
+         */
+        static std::shared_ptr<EventArena> acquire();
+
+        /**
+         * @brief Return the first memory block to the pool of the calling thread and release all other blocks
+         */
+        ~EventArena();
+
+        /// @{
+        /**
+         * @brief Copying or moving the arena is not allowed
+         */
+        EventArena(const EventArena&) = delete;
+        EventArena& operator=(const EventArena&) = delete;
+        EventArena(EventArena&&) = delete;
+        EventArena& operator=(EventArena&&) = delete;
+        /// @}
+
+        /**
+         * @brief Allocate memory from the arena
+         * @param bytes Number of bytes required
+         * @param alignment Alignment of the memory, should be a power of two
+         * @return Pointer to the memory
+         */
+        void* allocate(size_t bytes, size_t alignment) {
+            auto offset = (alignment - reinterpret_cast<uintptr_t>(current_) % alignment) % alignment;
+            if(offset + bytes > remaining_) {
+                return allocate_block(bytes, alignment);
+            }
+            auto* ptr = current_ + offset;
+            current_ = ptr + bytes;
+            remaining_ -= offset + bytes;
+            return ptr;
+        }
+
+        /**
+         * @brief Get the total size of the memory blocks held by the arena
+         * @return Size in bytes
+         */
+        size_t capacity() const;
+
+    private:
+        /**
+         * @brief Memory block used by the arena
+         */
+        struct Block {
+            std::unique_ptr<std::byte[]> data;
+            size_t size;
+        };
+
+        explicit EventArena(Block block);
+
+        /**
+         * @brief Allocate memory from a new block if the current block is exhausted
+         */
+        void* allocate_block(size_t bytes, size_t alignment);
+
+        std::vector<Block> blocks_;
+        std::byte* current_;
+        size_t remaining_;
+    };
+
+    /**
+     * @brief Allocator to use an \ref EventArena with standard containers and shared pointers
+     *
+     * Every allocator keeps the arena alive, such that objects can safely outlive the event that created them. Deallocation
+     * does not release any memory, which is only released together with the arena.
+     */
+    template <typename T> class ArenaAllocator {
+    public:
+        using value_type = T;
+
+        /**
+         * @brief Construct allocator
+         * @param arena Arena to allocate from
+         */
+        explicit ArenaAllocator(std::shared_ptr<EventArena> arena) noexcept : arena_(std::move(arena)) {}
+
+        /**
+         * @brief Construct allocator for a different type from the same arena
+         */
+        template <typename U> ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena_) {} // NOLINT
+
+        T* allocate(size_t n) { return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T))); }
+        void deallocate(T*, size_t) noexcept {}
+
+        template <typename U> bool operator==(const ArenaAllocator<U>& other) const noexcept {
+            return arena_ == other.arena_;
+        }
+        template <typename U> bool operator!=(const ArenaAllocator<U>& other) const noexcept { return !(*this == other); }
+
+    private:
+        template <typename U> friend class ArenaAllocator;
+        std::shared_ptr<EventArena> arena_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_MODULE_EVENT_ARENA_H */
@@ -0,0 +1,86 @@
+/**
+ * @file
+ * @brief Implementation of the lazily created ROOT directory of a module
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "LazyDirectory.hpp"
+
+#include <utility>
+#include <vector>
+
+#include <TClass.h>
+#include <TList.h>
+#include <TROOT.h>
+
+using namespace allpix;
+
+LazyDirectory::LazyDirectory(const std::string& name, std::function<TDirectory*()> creator)
+    : TDirectory(name.c_str(), name.c_str(), "", gROOT), creator_(std::move(creator)) {}
+
+/**
+ * Objects attached to the placeholder are moved to the created directory, using the same mechanism as ROOT uses to attach
+ * new objects to the current directory.
+ */
+TDirectory* LazyDirectory::get() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    used_ = true;
+    if(directory_ == nullptr) {
+        directory_ = creator_();
+    }
+
+    std::vector<TObject*> objects;
+    for(auto* object : *GetList()) {
+        objects.push_back(object);
+    }
+    for(auto* object : objects) {
+        auto auto_add = object->IsA()->GetDirectoryAutoAdd();
+        if(auto_add != nullptr) {
+            auto_add(object, directory_);
+        } else {
+            GetList()->Remove(object);
+            directory_->Append(object);
+        }
+    }
+    return directory_;
+}
+
+TDirectory* LazyDirectory::current() {
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        if(directory_ == nullptr) {
+            return this;
+        }
+    }
+    return get();
+}
+
+bool LazyDirectory::used() const {
+    return used_;
+}
+
+void LazyDirectory::Append(TObject* obj, Bool_t replace) {
+    used_ = true;
+    TDirectory::Append(obj, replace);
+}
+
+Int_t LazyDirectory::WriteTObject(const TObject* obj, const char* name, Option_t* option, Int_t bufsize) {
+    return get()->WriteTObject(obj, name, option, bufsize);
+}
+
+Int_t LazyDirectory::WriteObjectAny(
+    const void* obj, const char* classname, const char* name, Option_t* option, Int_t bufsize) {
+    return get()->WriteObjectAny(obj, classname, name, option, bufsize);
+}
+
+Int_t LazyDirectory::WriteObjectAny(const void* obj, const TClass* cl, const char* name, Option_t* option, Int_t bufsize) {
+    return get()->WriteObjectAny(obj, cl, name, option, bufsize);
+}
+
+Int_t LazyDirectory::Write(const char* name, Int_t opt, Int_t bufsize) {
+    return get()->Write(name, opt, bufsize);
+}
@@ -0,0 +1,85 @@
+/**
+ * @file
+ * @brief ROOT directory of a module which is only created in the main ROOT file when it is used
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_MODULE_LAZY_DIRECTORY_H
+#define ALLPIX_MODULE_LAZY_DIRECTORY_H
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+
+#include <TDirectory.h>
+
+namespace allpix {
+    /**
+     * @brief In-memory placeholder for the ROOT directory of a module, creating the actual directory on its first use
+     *
+     * The placeholder is set as current directory for the module, such that objects created by the module are attached to
+     * it like to a directory of a file. Only when an object is written to the placeholder or the directory is requested
+     * explicitly, the directory is created by the given function and all attached objects are moved there. Modules which
+     * never write any ROOT object thus do not require the main ROOT file to be created.
+     */
+    class LazyDirectory : public TDirectory {
+    public:
+        /**
+         * @brief Construct the placeholder of a directory
+         * @param name Name of the directory
+         * @param creator Function creating the actual directory
+         */
+        LazyDirectory(const std::string& name, std::function<TDirectory*()> creator);
+
+        /**
+         * @brief Get the actual directory, creating it on the first call
+         * @return Directory in the main ROOT file
+         *
+         * Objects attached to the placeholder since the last call are moved to the actual directory.
+         */
+        TDirectory* get();
+
+        /**
+         * @brief Get the directory to change to before executing the module
+         * @return Actual directory if it has been created already, this placeholder otherwise
+         */
+        TDirectory* current();
+
+        /**
+         * @brief Check whether the module used the directory
+         * @return True if any object has been attached to the placeholder or the actual directory has been requested
+         */
+        bool used() const;
+
+        /**
+         * @brief Mark the placeholder as used and attach the object to it
+         */
+        void Append(TObject* obj, Bool_t replace = kFALSE) override;
+
+        /// @{
+        /**
+         * @brief Create the actual directory and forward the object to be written
+         */
+        Int_t
+        WriteTObject(const TObject* obj, const char* name = nullptr, Option_t* option = "", Int_t bufsize = 0) override;
+        Int_t WriteObjectAny(
+            const void* obj, const char* classname, const char* name, Option_t* option = "", Int_t bufsize = 0) override;
+        Int_t WriteObjectAny(
+            const void* obj, const TClass* cl, const char* name, Option_t* option = "", Int_t bufsize = 0) override;
+        Int_t Write(const char* name = nullptr, Int_t opt = 0, Int_t bufsize = 0) override;
+        /// @}
+
+    private:
+        std::function<TDirectory*()> creator_;
+        TDirectory* directory_{};
+        std::atomic<bool> used_{false};
+        mutable std::mutex mutex_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_MODULE_LAZY_DIRECTORY_H */
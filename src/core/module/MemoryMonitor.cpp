@@ -0,0 +1,71 @@
+/**
+ * @file
+ * @brief Implementation of the monitor of the memory of messages
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "MemoryMonitor.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#include "Module.hpp"
+#include "core/utils/log.h"
+
+using namespace allpix;
+
+namespace {
+    // Display a size in bytes with the largest binary prefix keeping the value above one
+    std::string display_bytes(long double bytes) {
+        static const char* prefixes[] = {"B", "kB", "MB", "GB", "TB"};
+        size_t prefix = 0;
+        while(bytes >= 1024 && prefix < 4) {
+            bytes /= 1024;
+            ++prefix;
+        }
+        std::stringstream display;
+        display << std::fixed << std::setprecision(prefix == 0 ? 0 : 1) << static_cast<double>(bytes) << prefixes[prefix];
+        return display.str();
+    }
+} // namespace
+
+void MemoryMonitor::recordEvent(const std::vector<std::pair<const Module*, size_t>>& module_memory) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    for(const auto& [module, memory] : module_memory) {
+        auto& entry = modules_[module->getUniqueName()];
+        entry.total += memory;
+        entry.peak = std::max(entry.peak, memory);
+    }
+    ++events_;
+}
+
+void MemoryMonitor::recordBufferedMemory(size_t memory) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    peak_buffered_memory_ = std::max(peak_buffered_memory_, memory);
+}
+
+void MemoryMonitor::report() const {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if(events_ == 0) {
+        return;
+    }
+
+    std::vector<std::pair<std::string, ModuleMemory>> sorted_modules(modules_.begin(), modules_.end());
+    std::stable_sort(sorted_modules.begin(), sorted_modules.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.second.total > rhs.second.total;
+    });
+
+    LOG(STATUS) << "Memory of the messages dispatched per event, peak memory held by buffered events "
+                << display_bytes(static_cast<long double>(peak_buffered_memory_)) << ":";
+    for(const auto& [name, memory] : sorted_modules) {
+        LOG(STATUS) << " Module " << name << " dispatched "
+                    << display_bytes(static_cast<long double>(memory.total) / static_cast<long double>(events_))
+                    << " on average, at most " << display_bytes(static_cast<long double>(memory.peak));
+    }
+}
@@ -0,0 +1,68 @@
+/**
+ * @file
+ * @brief Accounting of the memory of the messages dispatched by every module and held by buffered events
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_MODULE_MEMORY_MONITOR_H
+#define ALLPIX_MODULE_MEMORY_MONITOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace allpix {
+    class Module;
+
+    /**
+     * @brief Monitor of the memory of the messages dispatched by every module
+     *
+     * The memory of a message is estimated from the size hint of its contents, which includes the memory allocated by the
+     * objects themselves for all object types providing an estimate of it. For every module, the average and the largest
+     * memory of the messages dispatched per event are reported, together with the peak memory held by events waiting in the
+     * buffer of the thread pool. This allows to identify the modules dominating the memory of buffered events.
+     */
+    class MemoryMonitor {
+    public:
+        /**
+         * @brief Record the memory of the messages dispatched by every module for a finished event
+         * @param module_memory Memory in bytes of the messages dispatched by every module during the event
+         * @note This method can be called concurrently from all workers
+         */
+        void recordEvent(const std::vector<std::pair<const Module*, size_t>>& module_memory);
+
+        /**
+         * @brief Record the memory held by buffered events, only the largest value is kept
+         * @param memory Memory in bytes
+         */
+        void recordBufferedMemory(size_t memory);
+
+        /**
+         * @brief Log the memory of the messages of every module, ordered by their total memory
+         */
+        void report() const;
+
+    private:
+        struct ModuleMemory {
+            size_t total{};
+            size_t peak{};
+        };
+
+        // Modules are identified by their unique name, since instantiations can be replaced between runs of a scan
+        std::map<std::string, ModuleMemory> modules_;
+        uint64_t events_{};
+        size_t peak_buffered_memory_{};
+
+        mutable std::mutex mutex_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_MODULE_MEMORY_MONITOR_H */
@@ -0,0 +1,201 @@
+/**
+ * @file
+ * @brief Implementation of the exporter of the event loop metrics
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "MetricsExporter.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <utility>
+
+#include "Module.hpp"
+#include "ThreadPool.hpp"
+#include "core/utils/log.h"
+
+using namespace allpix;
+
+MetricsExporter::MetricsExporter(std::string path, Format format, Clock::duration interval)
+    : path_(std::move(path)), format_(format), interval_(interval) {}
+
+MetricsExporter::~MetricsExporter() {
+    if(thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            running_ = false;
+        }
+        stop_condition_.notify_all();
+        thread_.join();
+    }
+}
+
+void MetricsExporter::registerModule(const Module* module) {
+    module_indices_.emplace(module, modules_.size());
+    modules_.push_back(module);
+}
+
+void MetricsExporter::start(const ThreadPool* thread_pool,
+                            const std::atomic<uint64_t>* finished_events,
+                            uint64_t total_events) {
+    counters_ = std::make_unique<ModuleCounters[]>(modules_.size());
+    last_modules_.assign(modules_.size(), {0, 0, 0, 0});
+    thread_pool_ = thread_pool;
+    finished_events_ = finished_events;
+    total_events_ = total_events;
+    start_time_ = Clock::now();
+    last_time_ = start_time_;
+    last_finished_ = 0;
+
+    running_ = true;
+    thread_ = std::thread(&MetricsExporter::loop, this);
+    LOG(STATUS) << "Writing metrics of the event loop to file " << path_;
+}
+
+void MetricsExporter::stop() {
+    if(!thread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        running_ = false;
+    }
+    stop_condition_.notify_all();
+    thread_.join();
+
+    // Final snapshot with the state at the end of the event loop
+    write_snapshot();
+}
+
+void MetricsExporter::recordExecution(const Module* module, Clock::duration duration) {
+    auto& counters = counters_[module_indices_.at(module)];
+    counters.executions.fetch_add(1, std::memory_order_relaxed);
+    auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    counters.duration.fetch_add(static_cast<uint64_t>(nanoseconds), std::memory_order_relaxed);
+}
+
+void MetricsExporter::recordSuspend(const Module* module) {
+    counters_[module_indices_.at(module)].waiting.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MetricsExporter::recordResume(const Module* module) {
+    counters_[module_indices_.at(module)].waiting.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void MetricsExporter::loop() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    while(running_) {
+        if(stop_condition_.wait_for(lock, interval_, [this] { return !running_; })) {
+            break;
+        }
+        lock.unlock();
+        write_snapshot();
+        lock.lock();
+    }
+}
+
+/**
+ * The event rate and the mean execution time of the modules are computed from the difference to the previous snapshot, such
+ * that they reflect the current state of the run rather than the average since its start. Failures to write the file are
+ * reported as warning and do not interrupt the run.
+ */
+void MetricsExporter::write_snapshot() {
+    auto now = Clock::now();
+    auto elapsed = std::chrono::duration<double>(now - last_time_).count();
+    auto finished = finished_events_->load();
+    auto rate = (elapsed > 0 ? static_cast<double>(finished - last_finished_) / elapsed : 0.);
+
+    std::vector<ModuleSnapshot> modules;
+    for(size_t i = 0; i < modules_.size(); ++i) {
+        ModuleSnapshot module{counters_[i].executions.load(std::memory_order_relaxed),
+                              counters_[i].duration.load(std::memory_order_relaxed),
+                              counters_[i].waiting.load(std::memory_order_relaxed),
+                              last_modules_[i].latency};
+        const auto& last = last_modules_[i];
+        if(module.executions > last.executions) {
+            module.latency = 1e-9 * static_cast<double>(module.duration - last.duration) /
+                             static_cast<double>(module.executions - last.executions);
+        }
+        modules.push_back(module);
+    }
+    last_time_ = now;
+    last_finished_ = finished;
+
+    auto temporary_path = path_ + ".tmp";
+    {
+        std::ofstream file(temporary_path);
+        file << std::setprecision(6);
+        if(format_ == Format::PROMETHEUS) {
+            write_prometheus(file, rate, modules);
+        } else {
+            write_json(file, rate, modules);
+        }
+        if(!file.good()) {
+            LOG_ONCE(WARNING) << "Cannot write metrics to file " << temporary_path;
+            last_modules_ = std::move(modules);
+            return;
+        }
+    }
+    last_modules_ = std::move(modules);
+    if(std::rename(temporary_path.c_str(), path_.c_str()) != 0) {
+        LOG_ONCE(WARNING) << "Cannot move metrics to file " << path_;
+    }
+}
+
+void MetricsExporter::write_json(std::ostream& out, double rate, const std::vector<ModuleSnapshot>& modules) const {
+    out << "{" << std::endl
+        << "  \"time\": " << std::chrono::duration<double>(last_time_ - start_time_).count() << "," << std::endl;
+    out << "  \"finished_events\": " << last_finished_ << "," << std::endl
+        << "  \"total_events\": " << total_events_ << "," << std::endl
+        << "  \"events_per_second\": " << rate << "," << std::endl
+        << "  \"buffered_events\": " << thread_pool_->bufferedQueueSize() << "," << std::endl
+        << "  \"buffered_memory\": " << thread_pool_->bufferedMemory() << "," << std::endl
+        << "  \"queued_jobs\": " << thread_pool_->queueSize() << "," << std::endl
+        << "  \"modules\": {";
+    for(size_t i = 0; i < modules_.size(); ++i) {
+        out << (i == 0 ? "" : ",") << std::endl
+            << "    \"" << modules_[i]->getUniqueName() << "\": {\"executions\": " << modules[i].executions
+            << ", \"latency\": " << modules[i].latency << ", \"waiting_events\": " << modules[i].waiting << "}";
+    }
+    out << std::endl << "  }" << std::endl << "}" << std::endl;
+}
+
+void MetricsExporter::write_prometheus(std::ostream& out, double rate, const std::vector<ModuleSnapshot>& modules) const {
+    auto metric = [&out](const std::string& name, const std::string& type, const std::string& help) {
+        out << "# HELP allpix_" << name << " " << help << std::endl << "# TYPE allpix_" << name << " " << type << std::endl;
+    };
+
+    metric("finished_events", "counter", "Number of finished events");
+    out << "allpix_finished_events " << last_finished_ << std::endl;
+    metric("total_events", "gauge", "Number of events to process in this run");
+    out << "allpix_total_events " << total_events_ << std::endl;
+    metric("events_per_second", "gauge", "Events finished per second during the last interval");
+    out << "allpix_events_per_second " << rate << std::endl;
+    metric("buffered_events", "gauge", "Number of events waiting in the buffer");
+    out << "allpix_buffered_events " << thread_pool_->bufferedQueueSize() << std::endl;
+    metric("buffered_memory_bytes", "gauge", "Estimated memory held by the events in the buffer");
+    out << "allpix_buffered_memory_bytes " << thread_pool_->bufferedMemory() << std::endl;
+    metric("queued_jobs", "gauge", "Number of jobs waiting in the queue of the thread pool");
+    out << "allpix_queued_jobs " << thread_pool_->queueSize() << std::endl;
+
+    metric("module_executions", "counter", "Number of executions of the module");
+    for(size_t i = 0; i < modules_.size(); ++i) {
+        out << "allpix_module_executions{module=\"" << modules_[i]->getUniqueName() << "\"} " << modules[i].executions
+            << std::endl;
+    }
+    metric("module_latency_seconds", "gauge", "Mean execution time of the module during the last interval");
+    for(size_t i = 0; i < modules_.size(); ++i) {
+        out << "allpix_module_latency_seconds{module=\"" << modules_[i]->getUniqueName() << "\"} " << modules[i].latency
+            << std::endl;
+    }
+    metric("module_waiting_events", "gauge", "Number of events waiting in the buffer for the module");
+    for(size_t i = 0; i < modules_.size(); ++i) {
+        out << "allpix_module_waiting_events{module=\"" << modules_[i]->getUniqueName() << "\"} " << modules[i].waiting
+            << std::endl;
+    }
+}
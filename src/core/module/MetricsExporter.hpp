@@ -0,0 +1,171 @@
+/**
+ * @file
+ * @brief Periodic export of the progress and throughput of the event loop for monitoring
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_MODULE_METRICS_EXPORTER_H
+#define ALLPIX_MODULE_METRICS_EXPORTER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace allpix {
+    class Module;
+    class ThreadPool;
+
+    /**
+     * @brief Exporter writing a snapshot of the state of the event loop to a file at a fixed interval
+     *
+     * The snapshot contains the number of finished events, the event rate, the fill level of the event buffer and of the
+     * queue of the thread pool, and for every module instantiation the number of executions, the mean execution time over
+     * the last interval and the number of events waiting in the buffer for it. The snapshot is written to a temporary file
+     * which is renamed afterwards, such that readers never see a partially written file. Recording only increments atomic
+     * counters, the snapshot is assembled by a separate background thread.
+     */
+    class MetricsExporter {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        /**
+         * @brief Formats of the written snapshot
+         */
+        enum class Format {
+            JSON = 0,   ///< Single JSON object
+            PROMETHEUS, ///< Prometheus text exposition format, e.g. for the textfile collector of the node exporter
+        };
+
+        /**
+         * @brief Construct the exporter
+         * @param path Path of the file to write the snapshots to
+         * @param format Format of the snapshots
+         * @param interval Interval between two snapshots
+         */
+        MetricsExporter(std::string path, Format format, Clock::duration interval);
+
+        /**
+         * @brief Stop the background thread if it is still running
+         */
+        ~MetricsExporter();
+
+        /// @{
+        /**
+         * @brief Copying or moving the exporter is not allowed
+         */
+        MetricsExporter(const MetricsExporter&) = delete;
+        MetricsExporter& operator=(const MetricsExporter&) = delete;
+        MetricsExporter(MetricsExporter&&) = delete;
+        MetricsExporter& operator=(MetricsExporter&&) = delete;
+        /// @}
+
+        /**
+         * @brief Register a module instantiation to export the metrics of
+         * @param module Pointer to the module
+         * @warning All modules should be registered before the exporter is started
+         */
+        void registerModule(const Module* module);
+
+        /**
+         * @brief Start writing snapshots in the background
+         * @param thread_pool Thread pool processing the events
+         * @param finished_events Counter of the finished events
+         * @param total_events Number of events to process in this run
+         */
+        void start(const ThreadPool* thread_pool, const std::atomic<uint64_t>* finished_events, uint64_t total_events);
+
+        /**
+         * @brief Stop the background thread and write a final snapshot
+         */
+        void stop();
+
+        /**
+         * @brief Record a single execution of a module
+         * @param module Pointer to the executed module
+         * @param duration Duration of the execution
+         */
+        void recordExecution(const Module* module, Clock::duration duration);
+
+        /**
+         * @brief Record that an event was put into the buffer to wait for a module
+         * @param module Pointer to the module the event is waiting for
+         */
+        void recordSuspend(const Module* module);
+
+        /**
+         * @brief Record that an event waiting in the buffer for a module continued
+         * @param module Pointer to the module the event was waiting for
+         */
+        void recordResume(const Module* module);
+
+    private:
+        /**
+         * @brief Counters of a single module, aligned to separate cache lines to avoid false sharing between modules
+         */
+        struct alignas(64) ModuleCounters {
+            std::atomic<uint64_t> executions{};
+            std::atomic<uint64_t> duration{};
+            std::atomic<int64_t> waiting{};
+        };
+
+        /**
+         * @brief Values of a module in a single snapshot
+         */
+        struct ModuleSnapshot {
+            uint64_t executions;
+            uint64_t duration;
+            int64_t waiting;
+            double latency;
+        };
+
+        /**
+         * @brief Main function of the background thread
+         */
+        void loop();
+
+        /**
+         * @brief Collect and write a single snapshot
+         */
+        void write_snapshot();
+
+        void write_json(std::ostream& out, double rate, const std::vector<ModuleSnapshot>& modules) const;
+        void write_prometheus(std::ostream& out, double rate, const std::vector<ModuleSnapshot>& modules) const;
+
+        std::string path_;
+        Format format_;
+        Clock::duration interval_;
+
+        std::vector<const Module*> modules_;
+        std::map<const Module*, size_t> module_indices_;
+        std::unique_ptr<ModuleCounters[]> counters_;
+
+        const ThreadPool* thread_pool_{};
+        const std::atomic<uint64_t>* finished_events_{};
+        uint64_t total_events_{};
+
+        // State of the previous snapshot to compute the rates over the last interval
+        Clock::time_point start_time_;
+        Clock::time_point last_time_;
+        uint64_t last_finished_{};
+        std::vector<ModuleSnapshot> last_modules_;
+
+        std::thread thread_;
+        std::mutex mutex_;
+        std::condition_variable stop_condition_;
+        bool running_{};
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_MODULE_METRICS_EXPORTER_H */
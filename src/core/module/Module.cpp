@@ -17,6 +17,8 @@
 #include <utility>
 
 #include "core/messenger/Messenger.hpp"
+#include "core/module/LazyDirectory.hpp"
+#include "core/module/Profiler.hpp"
 #include "core/module/exceptions.h"
 #include "core/utils/log.h"
 
@@ -119,6 +121,7 @@ std::string Module::createOutputFile(const std::string& path, const std::string&
     if(delete_file) {
         std::filesystem::remove(file);
     }
+    output_files_created_ = true;
     return file;
 }
 
@@ -134,9 +137,27 @@ TDirectory* Module::getROOTDirectory() const {
         throw InvalidModuleActionException("Cannot access ROOT directory in constructor or destructor");
     }
 
-    return directory_;
+    // The directory is only created in the main ROOT file when it is used for the first time
+    return directory_->get();
 }
-void Module::set_ROOT_directory(TDirectory* directory) {
+
+void Module::run(const std::vector<Event*>& events) {
+    for(auto* event : events) {
+        run(event);
+    }
+}
+
+/**
+ * @throws ModuleError If the module writes output which would only contain the events after the checkpoint
+ */
+void Module::restoreCheckpoint(const Configuration&) {
+    if(output_files_created_ || (directory_ != nullptr && directory_->used())) {
+        throw ModuleError("Cannot resume from a checkpoint, the output of this module does not support checkpoints and "
+                          "would only contain the events after the checkpoint");
+    }
+}
+
+void Module::set_ROOT_directory(LazyDirectory* directory) {
     directory_ = directory;
 }
 
@@ -154,12 +175,27 @@ void Module::set_config_manager(ConfigManager* conf_manager) {
     conf_manager_ = conf_manager;
 }
 
+void Module::increment_counter(const std::string& name, uint64_t value) {
+    if(profiler_ != nullptr) {
+        profiler_->count(this, name, value);
+    }
+}
+void Module::set_profiler(Profiler* profiler) {
+    profiler_ = profiler;
+}
+
 bool Module::multithreadingEnabled() const {
     return multithreading_;
 }
 void Module::allow_multithreading() {
     multithreading_ = true;
 }
+bool Module::parallelInitializationEnabled() const {
+    return parallel_initialization_;
+}
+void Module::allow_parallel_initialization() {
+    parallel_initialization_ = true;
+}
 void Module::set_multithreading(bool multithreading) {
     multithreading_ = multithreading;
 }
@@ -179,10 +215,8 @@ void Module::add_delegate(Messenger* messenger, BaseDelegate* delegate) {
     delegates_.emplace_back(messenger, delegate);
 }
 bool Module::check_delegates(Messenger* messenger, Event* event) {
-    // Return false if any delegate is not satisfied
-    return std::all_of(delegates_.cbegin(), delegates_.cend(), [messenger, event](auto& delegate) {
-        return !delegate.second->isRequired() || messenger->isSatisfied(delegate.second, event);
-    });
+    // Return false if any required delegate is not satisfied, compared at once using the masks of the routing table
+    return messenger->isSatisfied(this, event);
 }
 
 void SequentialModule::waive_sequence_requirement() {
@@ -15,6 +15,7 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <random>
 #include <string>
 #include <vector>
@@ -27,11 +28,14 @@
 #include "core/geometry/Detector.hpp"
 #include "core/messenger/delegates.h"
 #include "core/module/exceptions.h"
+#include "core/utils/log.h"
 #include "core/utils/prng.h"
 
 namespace allpix {
     class Messenger;
     class Event;
+    class Profiler;
+    class LazyDirectory;
     /**
      * @defgroup Modules Modules
      * @brief Collection of modules included in the framework
@@ -135,6 +139,12 @@ namespace allpix {
          */
         bool multithreadingEnabled() const;
 
+        /**
+         * @brief Returns if the module can be initialized concurrently with other modules
+         * @return True if parallel initialization is allowed, false otherwise (the default)
+         */
+        bool parallelInitializationEnabled() const;
+
         /**
          * @brief Initialize the module for each thread after the global initialization
          * @note Useful to prepare thread local objects
@@ -158,6 +168,15 @@ namespace allpix {
          */
         virtual void run(Event* event) { (void)event; }
 
+        /**
+         * @brief Execute the function of the module for a batch of events
+         * @param events Events of the batch which fulfill the requirements of the module, ordered by their event number
+         *
+         * Only called if the events are processed in batches. By default, the events are passed to \ref run(Event*) one by
+         * one. Modules can overload this method to share work between the events of a batch.
+         */
+        virtual void run(const std::vector<Event*>& events);
+
         /**
          * @brief Finalize the module after the event sequence for each thread
          * @note Useful to cleanup thread local objects
@@ -174,12 +193,39 @@ namespace allpix {
          */
         virtual void finalize() {}
 
+        /**
+         * @brief Store the state of the module required to resume the run from a checkpoint
+         * @param state Configuration to store the state of the module in
+         *
+         * Called from the main thread while no event is processed, after all events up to the checkpoint have been
+         * processed by all modules and before any later event is started. Does nothing if not overloaded.
+         */
+        virtual void storeCheckpoint(Configuration& state) { (void)state; }
+
+        /**
+         * @brief Restore the state of the module when resuming the run from a checkpoint
+         * @param state Configuration with the state of the module as stored by \ref storeCheckpoint
+         *
+         * Called after the initialization and before the first event, only if the run is resumed from a checkpoint. If not
+         * overloaded, resuming is refused for modules which created output files or attached objects to their ROOT
+         * directory, since their output would only cover the events after the checkpoint.
+         */
+        virtual void restoreCheckpoint(const Configuration& state);
+
     protected:
         /**
          * @brief Enable multithreading for this module
          */
         void allow_multithreading();
 
+        /**
+         * @brief Allow the \ref initialize function of this module to run concurrently with other modules allowing it
+         *
+         * Only modules which do not depend on the initialization of each other, do not write to the output file and do
+         * not access shared state without synchronization during initialization should allow this.
+         */
+        void allow_parallel_initialization();
+
         /**
          * @brief Get the module configuration for internal use
          * @return Configuration of the module
@@ -187,6 +233,15 @@ namespace allpix {
         Configuration& get_configuration();
         Configuration& config_;
 
+        /**
+         * @brief Increment a counter of this module reported by the profiler
+         * @param name Name of the counter
+         * @param value Value to add to the counter
+         * @note Does nothing if profiling is disabled. Counters are kept per thread and can thus be incremented from the
+         * run method of modules processing events concurrently
+         */
+        void increment_counter(const std::string& name, uint64_t value = 1);
+
     private:
         /**
          * @brief Set the module identifier for internal use
@@ -202,10 +257,13 @@ namespace allpix {
 
         /**
          * @brief Set the output ROOT directory for this module
-         * @param directory ROOT directory for storage
+         * @param directory Placeholder of the ROOT directory, created on first use
          */
-        void set_ROOT_directory(TDirectory* directory);
-        TDirectory* directory_{nullptr};
+        void set_ROOT_directory(LazyDirectory* directory);
+        LazyDirectory* directory_{nullptr};
+
+        // Whether the module created output files, such that it is recreated for every point of a parameter scan
+        std::atomic<bool> output_files_created_{false};
 
         /**
          * @brief Set the link to the config manager
@@ -214,6 +272,13 @@ namespace allpix {
         void set_config_manager(ConfigManager* config);
         ConfigManager* conf_manager_{nullptr};
 
+        /**
+         * @brief Set the link to the profiler
+         * @param profiler Pointer to the profiler or a null pointer if profiling is disabled
+         */
+        void set_profiler(Profiler* profiler);
+        Profiler* profiler_{nullptr};
+
         /**
          * @brief Add a messenger delegate to this instantiation
          * @param messenger Pointer to the messenger responsible for the delegate
@@ -242,6 +307,17 @@ namespace allpix {
          */
         void set_multithreading(bool multithreading);
         bool multithreading_{false};
+        bool parallel_initialization_{false};
+
+        /**
+         * @brief Module specific logging settings, resolved from the configuration once by the module manager
+         */
+        struct LogSettings {
+            std::optional<LogLevel> level;
+            std::optional<LogFormat> format;
+            std::string run_section;
+        };
+        LogSettings log_settings_;
 
         /**
          * @brief Checks if object is instance of SequentialModule class
@@ -10,30 +10,51 @@
 
 #include "ModuleManager.hpp"
 #include "Event.hpp"
+#include "MetricsExporter.hpp"
 
 #include <dlfcn.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iterator>
 #include <limits>
+#include <mutex>
+#include <numeric>
 #include <random>
 #include <set>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <tuple>
+#include <vector>
 
 #include <TROOT.h>
 #include <TSystem.h>
 
 #include "core/config/ConfigManager.hpp"
+#include "core/config/ConfigReader.hpp"
 #include "core/config/Configuration.hpp"
 #include "core/config/exceptions.h"
+#include "core/geometry/FieldStore.hpp"
 #include "core/geometry/GeometryManager.hpp"
 #include "core/messenger/Messenger.hpp"
+#include "core/module/LazyDirectory.hpp"
+#include "core/module/StaticModuleRegistry.hpp"
 #include "core/utils/log.h"
+#include "core/utils/numa.h"
+#include "core/utils/profiling.h"
+#include "core/utils/unit.h"
 
 // Common prefix for all modules
 // TODO [doc] Should be provided by the build system
@@ -45,6 +66,28 @@
 
 using namespace allpix;
 
+static std::string seconds_to_time(long double seconds) {
+    auto duration = std::chrono::duration<long long>(static_cast<long long>(std::round(seconds)));
+
+    std::string time_str;
+    auto hours = std::chrono::duration_cast<std::chrono::hours>(duration);
+    duration -= hours;
+    if(hours.count() > 0) {
+        time_str += std::to_string(hours.count());
+        time_str += " hours ";
+    }
+    auto minutes = std::chrono::duration_cast<std::chrono::minutes>(duration);
+    duration -= minutes;
+    if(minutes.count() > 0) {
+        time_str += std::to_string(minutes.count());
+        time_str += " minutes ";
+    }
+    time_str += std::to_string(duration.count());
+    time_str += " seconds";
+
+    return time_str;
+}
+
 ModuleManager::ModuleManager() : terminate_(false) {}
 
 /**
@@ -52,6 +95,8 @@ ModuleManager::ModuleManager() : terminate_(false) {}
  * automatically. After that the required modules are created from the configuration.
  */
 void ModuleManager::load(Messenger* messenger, ConfigManager* conf_manager, GeometryManager* geo_manager) {
+    auto start_time = std::chrono::steady_clock::now();
+
     // Store config manager and get configurations
     conf_manager_ = conf_manager;
     auto& configs = conf_manager_->getModuleConfigurations();
@@ -64,25 +109,115 @@ void ModuleManager::load(Messenger* messenger, ConfigManager* conf_manager, Geom
     // Set default for performance plot creation:
     global_config.setDefault("performance_plots", false);
 
-    // Store the messenger
+    // Set default for profiling of the event loop
+    global_config.setDefault("profiling", false);
+    if(global_config.get<bool>("profiling")) {
+        global_config.setDefault("profiling_format", Profiler::Format::CSV);
+        global_config.setDefault("profiling_hardware_counters", false);
+        auto trace = (global_config.get<Profiler::Format>("profiling_format") == Profiler::Format::TRACE);
+        profiler_ = std::make_unique<Profiler>(trace, global_config.get<bool>("profiling_hardware_counters"));
+    }
+
+    // Set default for the engine used to generate the random numbers of the events
+    global_config.setDefault("random_engine", RandomNumberGenerator::Engine::MERSENNE_TWISTER);
+
+    // Set default for writing the log messages from a background thread during the event loop
+    global_config.setDefault("log_asynchronous", true);
+
+    // Set default for warnings about configuration values parsed during the event loop
+    global_config.setDefault("warn_config_access", false);
+
+    // Set default for releasing messages before the end of the event
+    global_config.setDefault("release_messages", false);
+
+    // Set default for dropping messages without objects
+    global_config.setDefault("skip_empty_messages", false);
+
+    // Set default for running the instances of detector modules concurrently within an event
+    global_config.setDefault("parallel_detector_modules", false);
+
+    // Set default for pinning the workers to cores
+    global_config.setDefault("pin_threads", false);
+
+    // Set the pages to place the field grids on, the grids are registered during initialization
+    global_config.setDefault("field_huge_pages", FieldStore::HugePages::NONE);
+    FieldStore::setHugePages(global_config.get<FieldStore::HugePages>("field_huge_pages"));
+
+    // Store the messenger and the geometry manager
     messenger_ = messenger;
+    geo_manager_ = geo_manager;
 
-    // (Re)create the main ROOT file
+    // Remove a previous main ROOT file, the file itself is only created once a module writes to it. A resumed run keeps the
+    // file of the interrupted run
     auto path = std::string(gSystem->pwd()) + "/" + global_config.get<std::string>("root_file", "modules");
-    path = std::filesystem::path(path).replace_extension("root");
+    modules_file_path_ = std::filesystem::path(path).replace_extension("root");
 
-    if(std::filesystem::is_regular_file(path)) {
+    if(std::filesystem::is_regular_file(modules_file_path_) && !global_config.has("resume_checkpoint")) {
         if(global_config.get<bool>("deny_overwrite", false)) {
-            throw RuntimeError("Overwriting of existing main ROOT file " + path + " denied");
+            throw RuntimeError("Overwriting of existing main ROOT file " + modules_file_path_ + " denied");
+        }
+        LOG(WARNING) << "Main ROOT file " << modules_file_path_ << " exists and will be overwritten.";
+        std::filesystem::remove(modules_file_path_);
+    }
+
+    if(global_config.has("resume_checkpoint") && global_config.get<bool>("performance_plots")) {
+        throw InvalidCombinationError(global_config,
+                                      {"performance_plots", "resume_checkpoint"},
+                                      "performance plots would only contain the events after the checkpoint");
+    }
+
+    // Apply the options of the first point of a parameter scan before the modules are constructed
+    std::string global_dir = gSystem->pwd();
+    if(global_config.has("scan_file")) {
+        if(global_config.has("resume_checkpoint")) {
+            throw InvalidCombinationError(
+                global_config, {"scan_file", "resume_checkpoint"}, "runs of parameter scans cannot be resumed");
+        }
+        if(profiler_ != nullptr) {
+            throw InvalidCombinationError(
+                global_config, {"scan_file", "profiling"}, "profiling is not supported for parameter scans");
         }
-        LOG(WARNING) << "Main ROOT file " << path << " exists and will be overwritten.";
-        std::filesystem::remove(path);
+        read_scan_points(global_config.getPath("scan_file", true));
+        LOG(STATUS) << "Running parameter scan with " << scan_points_.size() << " points, starting with point "
+                    << scan_points_.front().name;
+        conf_manager_->loadModuleOptions(scan_points_.front().options);
+
+        // Every point writes its output to a subdirectory, also in the main ROOT file
+        scan_directory_ = global_dir;
+        global_dir += "/" + scan_points_.front().name;
+        root_directory_name_ = scan_points_.front().name;
     }
-    modules_file_ = std::make_unique<TFile>(path.c_str(), "RECREATE");
-    if(modules_file_->IsZombie()) {
-        throw RuntimeError("Cannot create main ROOT file " + path);
+
+    // Replace the leading modules by their cached output, or store their output in the cache
+    if(global_config.has("stage_cache_directory")) {
+        if(global_config.has("scan_file")) {
+            throw InvalidCombinationError(global_config,
+                                          {"stage_cache_directory", "scan_file"},
+                                          "the output of modules cannot be cached for parameter scans");
+        }
+        if(global_config.has("resume_checkpoint")) {
+            throw InvalidCombinationError(global_config,
+                                          {"stage_cache_directory", "resume_checkpoint"},
+                                          "the output of modules cannot be cached for resumed runs");
+        }
+        apply_stage_cache(configs);
+    }
+
+    // Index the module libraries in the configured directories once, earlier directories take precedence
+    std::map<std::string, std::string> library_paths;
+    if(global_config.has("library_directories")) {
+        LOG(TRACE) << "Indexing module libraries in configured paths";
+        for(auto& lib_dir : global_config.getPathArray("library_directories", true)) {
+            LOG(TRACE) << "Searching in path \"" << lib_dir << "\"";
+            std::error_code error;
+            for(const auto& entry : std::filesystem::directory_iterator(lib_dir, error)) {
+                auto file_name = entry.path().filename().string();
+                if(file_name.compare(0, std::strlen(ALLPIX_MODULE_PREFIX), ALLPIX_MODULE_PREFIX) == 0) {
+                    library_paths.emplace(file_name, entry.path().string());
+                }
+            }
+        }
     }
-    modules_file_->cd();
 
     // Loop through all non-global configurations
     for(auto& config : configs) {
@@ -90,116 +225,119 @@ void ModuleManager::load(Messenger* messenger, ConfigManager* conf_manager, Geom
         std::string lib_name = std::string(ALLPIX_MODULE_PREFIX).append(config.getName()).append(SHARED_LIBRARY_SUFFIX);
         LOG_PROGRESS(STATUS, "LOAD_LOOP") << "Loading module " << config.getName();
 
-        void* lib = nullptr;
-        bool load_error = false;
-        dlerror();
-        if(loaded_libraries_.count(lib_name) == 0) {
-            // If library is not loaded then try to load it first from the config directories
-            if(global_config.has("library_directories")) {
-                LOG(TRACE) << "Attempting to load library from configured paths";
-                std::vector<std::string> lib_paths = global_config.getPathArray("library_directories", true);
-                for(auto& lib_path : lib_paths) {
-                    std::string full_lib_path = lib_path;
-                    full_lib_path += "/";
-                    full_lib_path += lib_name;
-                    LOG(TRACE) << "Searching in path \"" << full_lib_path << "\"";
-
-                    // Check if the absolute file exists and try to load if it exists
-                    std::ifstream check_file(full_lib_path);
-                    if(check_file.good()) {
-                        lib = dlopen(full_lib_path.c_str(), RTLD_NOW);
-                        if(lib != nullptr) {
-                            LOG(DEBUG) << "Found library in configuration specified directory at " << full_lib_path;
-                        } else {
-                            load_error = true;
-                        }
-                        break;
+        bool unique = true;
+        void* generator = nullptr;
+        auto static_module = static_modules().find(config.getName());
+        if(static_module != static_modules().end()) {
+            // Use the module linked statically into the executable
+            LOG(DEBUG) << "Found module linked statically into the executable";
+            unique = static_module->second.unique;
+            generator = static_module->second.generator;
+        } else {
+            void* lib = nullptr;
+            bool load_error = false;
+            dlerror();
+            if(loaded_libraries_.count(lib_name) == 0) {
+                // If library is not loaded then try to load it first from the config directories
+                auto lib_path = library_paths.find(lib_name);
+                if(lib_path != library_paths.end()) {
+                    lib = dlopen(lib_path->second.c_str(), RTLD_NOW);
+                    if(lib != nullptr) {
+                        LOG(DEBUG) << "Found library in configuration specified directory at " << lib_path->second;
+                    } else {
+                        load_error = true;
                     }
                 }
-            }
 
-            // Otherwise try to load from the standard paths if not found already
-            if(!load_error && lib == nullptr) {
-                lib = dlopen(lib_name.c_str(), RTLD_NOW);
+                // Otherwise try to load from the standard paths if not found already
+                if(!load_error && lib == nullptr) {
+                    lib = dlopen(lib_name.c_str(), RTLD_NOW);
 
-                if(lib != nullptr) {
-                    Dl_info dl_info;
-                    dl_info.dli_fname = "";
+                    if(lib != nullptr) {
+                        Dl_info dl_info;
+                        dl_info.dli_fname = "";
 
-                    // workaround to get the location of the library
-                    int ret = dladdr(dlsym(lib, ALLPIX_UNIQUE_FUNCTION), &dl_info);
-                    if(ret != 0) {
-                        LOG(DEBUG) << "Found library during global search in runtime paths at " << dl_info.dli_fname;
+                        // workaround to get the location of the library
+                        int ret = dladdr(dlsym(lib, ALLPIX_UNIQUE_FUNCTION), &dl_info);
+                        if(ret != 0) {
+                            LOG(DEBUG) << "Found library during global search in runtime paths at " << dl_info.dli_fname;
+                        } else {
+                            LOG(WARNING)
+                                << "Found library during global search but could not deduce location, likely broken library";
+                        }
                     } else {
-                        LOG(WARNING)
-                            << "Found library during global search but could not deduce location, likely broken library";
+                        load_error = true;
                     }
-                } else {
-                    load_error = true;
                 }
-            }
-        } else {
-            // Otherwise just fetch it from the cache
-            lib = loaded_libraries_[lib_name];
-        }
-
-        // If library did not load then throw exception
-        if(load_error) {
-            const char* lib_error = dlerror();
-
-            // Find the name of the loaded library if it exists
-            std::string lib_error_str = lib_error;
-            size_t end_pos = lib_error_str.find(':');
-            std::string problem_lib;
-            if(end_pos != std::string::npos) {
-                problem_lib = lib_error_str.substr(0, end_pos);
-            }
-
-            // FIXME is checking the error in this way portable?
-            if(lib_error != nullptr && std::strstr(lib_error, "cannot allocate memory in static TLS block") != nullptr) {
-                LOG(ERROR) << "Library could not be loaded: not enough thread local storage available" << std::endl
-                           << "Try one of below workarounds:" << std::endl
-                           << "- Rerun library with the environmental variable LD_PRELOAD='" << problem_lib << "'"
-                           << std::endl
-                           << "- Recompile the library " << problem_lib << " with tls-model=global-dynamic";
-            } else if(lib_error != nullptr && std::strstr(lib_error, "cannot open shared object file") != nullptr &&
-                      problem_lib.find(ALLPIX_MODULE_PREFIX) == std::string::npos) {
-                LOG(ERROR) << "Library could not be loaded: one of its dependencies is missing" << std::endl
-                           << "The name of the missing library is " << problem_lib << std::endl
-                           << "Please make sure the library is properly initialized and try again";
-            } else if(lib_error != nullptr && std::strstr(lib_error, "undefined symbol") != nullptr) {
-                LOG(ERROR) << "Library could not be loaded: library version does not match framework (undefined symbols)"
-                           << std::endl
-                           << "The name of the problematic library is " << problem_lib << std::endl
-                           << "Please make sure the library is compiled against the correct framework version";
             } else {
-                LOG(ERROR) << "Library could not be loaded: it is not available" << std::endl
-                           << " - Did you enable the library during building? " << std::endl
-                           << " - Did you spell the library name correctly (case-sensitive)? ";
-                if(lib_error != nullptr) {
-                    LOG(DEBUG) << "Detailed error: " << lib_error;
+                // Otherwise just fetch it from the cache
+                lib = loaded_libraries_[lib_name];
+            }
+
+            // If library did not load then throw exception
+            if(load_error) {
+                const char* lib_error = dlerror();
+
+                // Find the name of the loaded library if it exists
+                std::string lib_error_str = lib_error;
+                size_t end_pos = lib_error_str.find(':');
+                std::string problem_lib;
+                if(end_pos != std::string::npos) {
+                    problem_lib = lib_error_str.substr(0, end_pos);
+                }
+
+                // FIXME is checking the error in this way portable?
+                if(lib_error != nullptr && std::strstr(lib_error, "cannot allocate memory in static TLS block") != nullptr) {
+                    LOG(ERROR) << "Library could not be loaded: not enough thread local storage available" << std::endl
+                               << "Try one of below workarounds:" << std::endl
+                               << "- Rerun library with the environmental variable LD_PRELOAD='" << problem_lib << "'"
+                               << std::endl
+                               << "- Recompile the library " << problem_lib << " with tls-model=global-dynamic";
+                } else if(lib_error != nullptr && std::strstr(lib_error, "cannot open shared object file") != nullptr &&
+                          problem_lib.find(ALLPIX_MODULE_PREFIX) == std::string::npos) {
+                    LOG(ERROR) << "Library could not be loaded: one of its dependencies is missing" << std::endl
+                               << "The name of the missing library is " << problem_lib << std::endl
+                               << "Please make sure the library is properly initialized and try again";
+                } else if(lib_error != nullptr && std::strstr(lib_error, "undefined symbol") != nullptr) {
+                    LOG(ERROR) << "Library could not be loaded: library version does not match framework (undefined symbols)"
+                               << std::endl
+                               << "The name of the problematic library is " << problem_lib << std::endl
+                               << "Please make sure the library is compiled against the correct framework version";
+                } else {
+                    LOG(ERROR) << "Library could not be loaded: it is not available" << std::endl
+                               << " - Did you enable the library during building? " << std::endl
+                               << " - Did you spell the library name correctly (case-sensitive)? ";
+                    if(lib_error != nullptr) {
+                        LOG(DEBUG) << "Detailed error: " << lib_error;
+                    }
                 }
+
+                throw allpix::DynamicLibraryError(config.getName());
             }
+            // Remember that this library was loaded
+            loaded_libraries_[lib_name] = lib;
 
-            throw allpix::DynamicLibraryError(config.getName());
-        }
-        // Remember that this library was loaded
-        loaded_libraries_[lib_name] = lib;
+            // Check if this module is produced once, or once per detector
+            void* uniqueFunction = dlsym(lib, ALLPIX_UNIQUE_FUNCTION);
 
-        // Check if this module is produced once, or once per detector
-        bool unique = true;
-        void* uniqueFunction = dlsym(loaded_libraries_[lib_name], ALLPIX_UNIQUE_FUNCTION);
+            // If the unique function was not found, throw an error
+            if(uniqueFunction == nullptr) {
+                LOG(ERROR) << "Module library is invalid or outdated: required interface function not found!";
+                throw allpix::DynamicLibraryError(config.getName());
+            } else {
+                unique = reinterpret_cast<bool (*)()>(uniqueFunction)(); // NOLINT
+            }
 
-        // If the unique function was not found, throw an error
-        if(uniqueFunction == nullptr) {
-            LOG(ERROR) << "Module library is invalid or outdated: required interface function not found!";
-            throw allpix::DynamicLibraryError(config.getName());
-        } else {
-            unique = reinterpret_cast<bool (*)()>(uniqueFunction)(); // NOLINT
+            // Get the generator function for this module
+            generator = dlsym(lib, ALLPIX_GENERATOR_FUNCTION);
+            // If the generator function was not found, throw an error
+            if(generator == nullptr) {
+                LOG(ERROR) << "Module library is invalid or outdated: required interface function not found!";
+                throw allpix::DynamicLibraryError(config.getName());
+            }
         }
 
         // Add the global internal parameters to the configuration
-        std::string global_dir = gSystem->pwd();
         config.set<std::string>("_global_dir", global_dir);
 
         // Set default input and output name
@@ -209,9 +347,9 @@ void ModuleManager::load(Messenger* messenger, ConfigManager* conf_manager, Geom
         // Create the modules from the library depending on the module type
         std::vector<std::pair<ModuleIdentifier, Module*>> mod_list;
         if(unique) {
-            mod_list.emplace_back(create_unique_modules(loaded_libraries_[lib_name], config, messenger, geo_manager));
+            mod_list.emplace_back(create_unique_modules(generator, config, messenger, geo_manager));
         } else {
-            mod_list = create_detector_modules(loaded_libraries_[lib_name], config, messenger, geo_manager);
+            mod_list = create_detector_modules(generator, config, messenger, geo_manager);
         }
 
         // Loop through all created instantiations
@@ -251,6 +389,7 @@ void ModuleManager::load(Messenger* messenger, ConfigManager* conf_manager, Geom
             // Add the new module to the run list
             modules_.emplace_back(std::move(mod));
             id_to_module_[identifier] = --modules_.end();
+            module_sources_[identifier.getUniqueName()] = {&config, generator};
         }
     }
 
@@ -260,13 +399,48 @@ void ModuleManager::load(Messenger* messenger, ConfigManager* conf_manager, Geom
             module->set_multithreading(false);
         }
     }
-    LOG_PROGRESS(STATUS, "LOAD_LOOP") << "Loaded " << configs.size() << " modules";
+    auto end_time = std::chrono::steady_clock::now();
+    auto load_time = static_cast<std::chrono::duration<long double>>(end_time - start_time).count();
+    LOG_PROGRESS(STATUS, "LOAD_LOOP") << "Loaded " << configs.size() << " modules in " << seconds_to_time(load_time);
+    total_time_ += load_time;
+}
+
+/**
+ * The main ROOT file is only created on the first request, such that simulations without any ROOT output neither create the
+ * file nor initialize the ROOT I/O. For parameter scans, the directory of the given scan point is created in the file. A
+ * resumed run adds to the file of the interrupted run.
+ */
+TDirectory* ModuleManager::get_root_directory(const std::string& scan_point) {
+    if(modules_file_ == nullptr) {
+        auto start_time = std::chrono::steady_clock::now();
+        TDirectory::TContext context{};
+        auto resume = conf_manager_->getGlobalConfiguration().has("resume_checkpoint");
+        modules_file_ = std::make_unique<TFile>(modules_file_path_.c_str(), resume ? "UPDATE" : "RECREATE");
+        if(modules_file_->IsZombie()) {
+            throw RuntimeError("Cannot create main ROOT file " + modules_file_path_);
+        }
+        auto end_time = std::chrono::steady_clock::now();
+        LOG(DEBUG) << "Created main ROOT file " << modules_file_path_ << " on first use in "
+                   << seconds_to_time(static_cast<std::chrono::duration<long double>>(end_time - start_time).count());
+    }
+    if(scan_point.empty()) {
+        return modules_file_.get();
+    }
+
+    auto* directory = modules_file_->GetDirectory(scan_point.c_str());
+    if(directory == nullptr) {
+        directory = modules_file_->mkdir(scan_point.c_str());
+        if(directory == nullptr) {
+            throw RuntimeError("Cannot create ROOT directory for scan point " + scan_point);
+        }
+    }
+    return directory;
 }
 
 /**
  * For unique modules a single instance is created per section
  */
-std::pair<ModuleIdentifier, Module*> ModuleManager::create_unique_modules(void* library,
+std::pair<ModuleIdentifier, Module*> ModuleManager::create_unique_modules(void* generator,
                                                                           Configuration& config,
                                                                           Messenger* messenger,
                                                                           GeometryManager* geo_manager) {
@@ -294,44 +468,11 @@ std::pair<ModuleIdentifier, Module*> ModuleManager::create_unique_modules(void*
     }
     ModuleIdentifier identifier(module_name, identifier_str, 0);
 
-    // Get the generator function for this module
-    void* generator = dlsym(library, ALLPIX_GENERATOR_FUNCTION);
-    // If the generator function was not found, throw an error
-    if(generator == nullptr) {
-        LOG(ERROR) << "Module library is invalid or outdated: required interface function not found!";
-        throw allpix::DynamicLibraryError(module_name);
-    }
-
     // Create and add module instance config
     Configuration& instance_config = conf_manager_->addInstanceConfiguration(identifier, config);
 
-    // Specialize instance configuration
-    std::string output_dir;
-    output_dir = instance_config.get<std::string>("_global_dir");
-    output_dir += "/";
-    std::string path_mod_name = identifier.getUniqueName();
-    std::replace(path_mod_name.begin(), path_mod_name.end(), ':', '_');
-    output_dir += path_mod_name;
-
-    // Convert to correct generator function
-    auto module_generator = reinterpret_cast<Module* (*)(Configuration&, Messenger*, GeometryManager*)>(generator); // NOLINT
-
     LOG(DEBUG) << "Creating unique instantiation " << identifier.getUniqueName();
-
-    // Get current time
-    auto start = std::chrono::steady_clock::now();
-    // Set module specific log settings
-    auto old_settings = set_module_before(identifier.getUniqueName(), instance_config, "C:");
-    // Build module
-    Module* module = module_generator(instance_config, messenger, geo_manager);
-    // Reset log
-    set_module_after(old_settings);
-    // Update execution time
-    auto end = std::chrono::steady_clock::now();
-    module_execution_time_[module] += static_cast<std::chrono::duration<long double>>(end - start).count();
-
-    // Set the module directory afterwards to catch invalid access in constructor
-    module->get_configuration().set<std::string>("_output_dir", output_dir);
+    Module* module = construct_module(generator, identifier, instance_config, messenger, geo_manager, nullptr);
 
     // Store the module and return it to the Module Manager
     return std::make_pair(identifier, module);
@@ -343,7 +484,7 @@ std::pair<ModuleIdentifier, Module*> ModuleManager::create_unique_modules(void*
  * For detector modules multiple instantiations may be created per section. An instantiation is created for every detector if
  * no selection parameters are provided. Otherwise instantiations are created for every linked detector name and type.
  */
-std::vector<std::pair<ModuleIdentifier, Module*>> ModuleManager::create_detector_modules(void* library,
+std::vector<std::pair<ModuleIdentifier, Module*>> ModuleManager::create_detector_modules(void* generator,
                                                                                          Configuration& config,
                                                                                          Messenger* messenger,
                                                                                          GeometryManager* geo_manager) {
@@ -361,17 +502,6 @@ std::vector<std::pair<ModuleIdentifier, Module*>> ModuleManager::create_detector
         identifier += config.get<std::string>("output");
     }
 
-    // Open the library and get the module generator function
-    void* generator = dlsym(library, ALLPIX_GENERATOR_FUNCTION);
-    // If the generator function was not found, throw an error
-    if(generator == nullptr) {
-        LOG(ERROR) << "Module library is invalid or outdated: required interface function not found!";
-        throw allpix::DynamicLibraryError(module_name);
-    }
-    // Convert to correct generator function
-    auto module_generator =
-        reinterpret_cast<Module* (*)(Configuration&, Messenger*, std::shared_ptr<Detector>)>(generator); // NOLINT
-
     // Handle empty type and name arrays:
     bool instances_created = false;
     std::vector<std::pair<std::shared_ptr<Detector>, ModuleIdentifier>> instantiations;
@@ -421,39 +551,13 @@ std::vector<std::pair<ModuleIdentifier, Module*>> ModuleManager::create_detector
     std::vector<std::pair<ModuleIdentifier, Module*>> module_list;
     for(auto& instance : instantiations) {
         LOG(DEBUG) << "Creating detector instantiation " << instance.second.getUniqueName();
-        // Get current time
-        auto start = std::chrono::steady_clock::now();
 
         // Create and add module instance config
         Configuration& instance_config = conf_manager_->addInstanceConfiguration(instance.second, config);
 
-        // Add internal module config
-        std::string output_dir;
-        output_dir = instance_config.get<std::string>("_global_dir");
-        output_dir += "/";
-        std::string path_mod_name = instance.second.getUniqueName();
-        std::replace(path_mod_name.begin(), path_mod_name.end(), ':', '/');
-        output_dir += path_mod_name;
-
-        // Set module specific log settings
-        auto old_settings = set_module_before(instance.second.getUniqueName(), instance_config, "C:");
         // Build module
-        Module* module = module_generator(instance_config, messenger, instance.first);
-        // Reset logging
-        set_module_after(old_settings);
-        // Update execution time
-        auto end = std::chrono::steady_clock::now();
-        module_execution_time_[module] += static_cast<std::chrono::duration<long double>>(end - start).count();
-
-        // Set the module directory afterwards to catch invalid access in constructor
-        module->get_configuration().set<std::string>("_output_dir", output_dir);
-
-        // Check if the module called the correct base class constructor
-        if(module->getDetector().get() != instance.first.get()) {
-            throw InvalidModuleStateException(
-                "Module " + module_name +
-                " does not call the correct base Module constructor: the provided detector should be forwarded");
-        }
+        Module* module =
+            construct_module(generator, instance.second, instance_config, messenger, geo_manager, instance.first);
 
         // Store the module
         module_list.emplace_back(instance.second, module);
@@ -462,52 +566,122 @@ std::vector<std::pair<ModuleIdentifier, Module*>> ModuleManager::create_detector
     return module_list;
 }
 
+/**
+ * @throws InvalidModuleStateException If a detector module fails to forward the detector to the base class
+ *
+ * Unique modules are constructed if no detector is given. The output directory of the instantiation is only set after its
+ * construction, to catch invalid access in the constructor.
+ */
+Module* ModuleManager::construct_module(void* generator,
+                                        const ModuleIdentifier& identifier,
+                                        Configuration& instance_config,
+                                        Messenger* messenger,
+                                        GeometryManager* geo_manager,
+                                        const std::shared_ptr<Detector>& detector) {
+    // Add internal module config
+    std::string output_dir;
+    output_dir = instance_config.get<std::string>("_global_dir");
+    output_dir += "/";
+    std::string path_mod_name = identifier.getUniqueName();
+    std::replace(path_mod_name.begin(), path_mod_name.end(), ':', detector == nullptr ? '_' : '/');
+    output_dir += path_mod_name;
+
+    // Get current time
+    auto start = std::chrono::steady_clock::now();
+    // Set module specific log settings
+    auto old_settings = set_module_before(identifier.getUniqueName(), instance_config, "C:");
+    // Build module with the correct generator function
+    Module* module = nullptr;
+    if(detector == nullptr) {
+        auto module_generator =
+            reinterpret_cast<Module* (*)(Configuration&, Messenger*, GeometryManager*)>(generator); // NOLINT
+        module = module_generator(instance_config, messenger, geo_manager);
+    } else {
+        auto module_generator =
+            reinterpret_cast<Module* (*)(Configuration&, Messenger*, std::shared_ptr<Detector>)>(generator); // NOLINT
+        module = module_generator(instance_config, messenger, detector);
+    }
+    // Reset logging
+    set_module_after(old_settings);
+    // Update execution time
+    auto end = std::chrono::steady_clock::now();
+    module_execution_time_[module] += static_cast<std::chrono::duration<long double>>(end - start).count();
+
+    // Set the module directory afterwards to catch invalid access in constructor
+    module->get_configuration().set<std::string>("_output_dir", output_dir);
+
+    // Check if the module called the correct base class constructor
+    if(detector != nullptr && module->getDetector().get() != detector.get()) {
+        throw InvalidModuleStateException(
+            "Module " + identifier.getName() +
+            " does not call the correct base Module constructor: the provided detector should be forwarded");
+    }
+    return module;
+}
+
 // Helper functions to set the module specific log settings if necessary
-std::tuple<LogLevel, LogFormat, std::string, uint64_t> ModuleManager::set_module_before(const std::string& name,
-                                                                                        const Configuration& config,
-                                                                                        const std::string& prefix,
-                                                                                        const uint64_t event) {
-    // Set new log level if necessary
-    LogLevel prev_level = Log::getReportingLevel();
+Module::LogSettings ModuleManager::resolve_log_settings(const Configuration& config) {
+    Module::LogSettings settings;
     if(config.has("log_level")) {
         auto log_level_string = config.get<std::string>("log_level");
         std::transform(log_level_string.begin(), log_level_string.end(), log_level_string.begin(), ::toupper);
         try {
-            LogLevel log_level = Log::getLevelFromString(log_level_string);
-            if(log_level != prev_level) {
-                LOG(TRACE) << "Local log level is set to " << log_level_string;
-                Log::setReportingLevel(log_level);
-            }
+            settings.level = Log::getLevelFromString(log_level_string);
         } catch(std::invalid_argument& e) {
             throw InvalidValueError(config, "log_level", e.what());
         }
     }
 
-    // Set new log format if necessary
-    LogFormat prev_format = Log::getFormat();
     if(config.has("log_format")) {
         auto log_format_string = config.get<std::string>("log_format");
         std::transform(log_format_string.begin(), log_format_string.end(), log_format_string.begin(), ::toupper);
         try {
-            LogFormat log_format = Log::getFormatFromString(log_format_string);
-            if(log_format != prev_format) {
-                LOG(TRACE) << "Local log format is set to " << log_format_string;
-                Log::setFormat(log_format);
-            }
+            settings.format = Log::getFormatFromString(log_format_string);
         } catch(std::invalid_argument& e) {
             throw InvalidValueError(config, "log_format", e.what());
         }
     }
 
+    return settings;
+}
+
+std::tuple<LogLevel, LogFormat, std::string, uint64_t> ModuleManager::set_module_before(const std::string& name,
+                                                                                        const Configuration& config,
+                                                                                        const std::string& prefix,
+                                                                                        const uint64_t event) {
+    return apply_log_settings(resolve_log_settings(config), prefix + name, event);
+}
+
+std::tuple<LogLevel, LogFormat, std::string, uint64_t> ModuleManager::set_module_before(const Module* module,
+                                                                                        const uint64_t event) {
+    return apply_log_settings(module->log_settings_, module->log_settings_.run_section, event);
+}
+
+std::tuple<LogLevel, LogFormat, std::string, uint64_t>
+ModuleManager::apply_log_settings(const Module::LogSettings& settings, const std::string& section, const uint64_t event) {
+    // Set new log level if necessary
+    LogLevel prev_level = Log::getReportingLevel();
+    if(settings.level.has_value() && settings.level.value() != prev_level) {
+        LOG(TRACE) << "Local log level is set to " << Log::getStringFromLevel(settings.level.value());
+        Log::setReportingLevel(settings.level.value());
+    }
+
+    // Set new log format if necessary
+    LogFormat prev_format = Log::getFormat();
+    if(settings.format.has_value() && settings.format.value() != prev_format) {
+        LOG(TRACE) << "Local log format is set to " << Log::getStringFromFormat(settings.format.value());
+        Log::setFormat(settings.format.value());
+    }
+
     // Set new section name
     auto prev_section = Log::getSection();
-    Log::setSection(prefix + name);
+    Log::setSection(section);
 
     // Set new event number:
     auto prev_event = Log::getEventNum();
     Log::setEventNum(event);
 
-    return std::make_tuple(prev_level, prev_format, prev_section, prev_event);
+    return std::make_tuple(prev_level, prev_format, std::move(prev_section), prev_event);
 }
 
 void ModuleManager::set_module_after(std::tuple<LogLevel, LogFormat, std::string, uint64_t> prev) {
@@ -534,6 +708,200 @@ void ModuleManager::set_module_after(std::tuple<LogLevel, LogFormat, std::string
     Log::setEventNum(std::get<3>(prev));
 }
 
+/**
+ * The ROOT directory of the module is created in the directory of its class, which is part of the directory of the current
+ * scan point for parameter scans. The module only receives a placeholder, the directory is created once the module uses it.
+ */
+void ModuleManager::prepare_module(Module* module) {
+    LOG(TRACE) << "Preparing initialization of " << module->get_identifier().getUniqueName();
+
+    // Pass the config manager to this instance
+    module->set_config_manager(conf_manager_);
+
+    // Resolve the logging settings once, switching to them for every event only requires a few thread-local stores
+    module->log_settings_ = resolve_log_settings(module->get_configuration());
+    module->log_settings_.run_section = "R:" + module->get_identifier().getUniqueName();
+
+    // Register the instance with the profiler if profiling is enabled
+    module->set_profiler(profiler_.get());
+    if(profiler_ != nullptr) {
+        profiler_->registerModule(module);
+    }
+
+    // Create the ROOT directory of this instance in the directory of the module class when it is first used
+    LOG(TRACE) << "Creating placeholder of ROOT directory";
+    auto creator = [this,
+                     scan_point = root_directory_name_,
+                     module_name = module->get_configuration().getName(),
+                     identifier = module->get_identifier().getIdentifier(),
+                     unique_name = module->getUniqueName()]() -> TDirectory* {
+        // Modules may be initialized concurrently, all directories are created one after the other
+        std::lock_guard<std::mutex> lock{modules_file_mutex_};
+        TDirectory::TContext context{};
+        auto* root_directory = get_root_directory(scan_point);
+        auto* directory = root_directory->GetDirectory(module_name.c_str());
+        if(directory == nullptr) {
+            directory = root_directory->mkdir(module_name.c_str());
+            if(directory == nullptr) {
+                throw RuntimeError("Cannot create or access overall ROOT directory for module " + module_name);
+            }
+        }
+
+        // Create local directory for this instance
+        if(identifier.empty()) {
+            return directory;
+        }
+        auto* local_directory = directory->mkdir(identifier.c_str());
+        if(local_directory == nullptr) {
+            throw RuntimeError("Cannot create or access local ROOT directory for module " + unique_name);
+        }
+        return local_directory;
+    };
+    lazy_directories_.push_back(std::make_unique<LazyDirectory>(module->getUniqueName(), std::move(creator)));
+
+    // Change to the directory and save it in the module
+    lazy_directories_.back()->cd();
+    module->set_ROOT_directory(lazy_directories_.back().get());
+}
+
+long double ModuleManager::initialize_module(Module* module) {
+    LOG_PROGRESS(TRACE, "INIT_LOOP") << "Initializing " << module->get_identifier().getUniqueName();
+
+    // Get current time
+    auto start = std::chrono::steady_clock::now();
+    // Set module specific settings
+    auto old_settings = set_module_before(module->get_identifier().getUniqueName(), module->get_configuration(), "I:");
+    // Change to our ROOT directory, which is only created if the module writes to it
+    module->directory_->current()->cd();
+    // Init module
+    module->initialize();
+    // Reset logging
+    set_module_after(old_settings);
+    // Return execution time
+    auto end = std::chrono::steady_clock::now();
+    return static_cast<std::chrono::duration<long double>>(end - start).count();
+}
+
+/**
+ * The key of the cache is a hash of the sections of all modules up to the given one, the detector setup, the seeds and
+ * events of the run and the framework version, including the contents of the detector model files and of all files the
+ * hashed sections refer to. If the output for this key is cached, these modules are replaced by a
+ * ROOTObjectReader of the cached objects. Otherwise, a ROOTObjectWriter storing all objects dispatched by these modules is
+ * added after them. Its file is only moved to the name of the key once the run has been completed, such that interrupted
+ * runs never leave an incomplete file in the cache.
+ */
+void ModuleManager::apply_stage_cache(std::list<Configuration>& configs) {
+    Configuration& global_config = conf_manager_->getGlobalConfiguration();
+    auto last_module = global_config.get<std::string>("stage_cache_until");
+    auto last_config = std::find_if(
+        configs.rbegin(), configs.rend(), [&last_module](const auto& config) { return config.getName() == last_module; });
+    if(last_config == configs.rend()) {
+        throw InvalidValueError(global_config, "stage_cache_until", "module " + last_module + " is not configured");
+    }
+    auto cached_end = last_config.base();
+
+    // Collect everything the output of the cached modules depends on, the logging settings do not change it
+    std::stringstream setup;
+    setup << "version " << ALLPIX_PROJECT_VERSION << std::endl;
+    for(const auto* key :
+        {"random_seed", "random_seed_core", "random_engine", "number_of_events", "skip_events", "partitions", "partition"}) {
+        setup << key << " " << global_config.get<std::string>(key, "") << std::endl;
+    }
+
+    // FNV-1a hash, stable across platforms and runs
+    auto fnv_hash = [](std::uint64_t hash, const char* data, std::size_t size) {
+        for(std::size_t i = 0; i < size; ++i) {
+            hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+        }
+        return hash;
+    };
+    const std::uint64_t fnv_offset = 14695981039346656037ULL;
+
+    // Files such as field maps can change without changing their path, their contents are part of the key
+    auto add_file = [&](const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        std::array<char, 65536> data{};
+        auto hash = fnv_offset;
+        while(file.read(data.data(), static_cast<std::streamsize>(data.size())) || file.gcount() > 0) {
+            hash = fnv_hash(hash, data.data(), static_cast<std::size_t>(file.gcount()));
+        }
+        setup << "file " << std::hex << hash << std::dec << std::endl;
+    };
+    auto add_section = [&](const Configuration& config) {
+        setup << "[" << config.getName() << "]" << std::endl;
+        auto values = config.getAll();
+        std::sort(values.begin(), values.end());
+        for(const auto& [key, value] : values) {
+            if(key.front() != '_' && key != "log_level" && key != "log_format") {
+                setup << key << " = " << value << std::endl;
+
+                // Relative paths are interpreted relative to the file of the configuration
+                auto path = std::filesystem::path(value.size() > 1 && value.front() == '"' && value.back() == '"'
+                                                      ? value.substr(1, value.size() - 2)
+                                                      : value);
+                if(path.is_relative()) {
+                    path = std::filesystem::path(config.getFilePath()).parent_path() / path;
+                }
+                std::error_code error;
+                if(std::filesystem::is_regular_file(path, error)) {
+                    add_file(path);
+                }
+            }
+        }
+    };
+    for(const auto& config : conf_manager_->getDetectorConfigurations()) {
+        add_section(config);
+
+        // Add the file of the detector model in the same order of the model paths as the geometry manager
+        for(const auto& model_path : geo_manager_->getModelsPath()) {
+            auto model_file = std::filesystem::path(model_path);
+            if(std::filesystem::is_directory(model_file)) {
+                model_file /= config.get<std::string>("type", "") + ALLPIX_MODEL_SUFFIX;
+            } else if(model_file.stem() != config.get<std::string>("type", "")) {
+                continue;
+            }
+            if(std::filesystem::is_regular_file(model_file)) {
+                add_file(model_file);
+                break;
+            }
+        }
+    }
+    for(auto iter = configs.begin(); iter != cached_end; ++iter) {
+        add_section(*iter);
+    }
+
+    auto setup_str = setup.str();
+    auto hash = fnv_hash(fnv_offset, setup_str.data(), setup_str.size());
+    std::stringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << hash;
+
+    std::filesystem::path cache_directory = global_config.getPath("stage_cache_directory");
+    auto cache_file = cache_directory / (key.str() + ".root");
+    LOG(STATUS) << "Caching the output of the modules up to " << last_module << " with key " << key.str();
+    if(std::filesystem::is_regular_file(cache_file)) {
+        LOG(STATUS) << "Replaying the cached output from " << cache_file.string();
+        Configuration reader("ROOTObjectReader", global_config.getFilePath());
+        reader.set<std::string>("file_name", cache_file.string());
+        reader.set<bool>("skip_unused_objects", true);
+        // Avoid clashing with a reader configured by the user, the messages keep the names stored in the file
+        reader.set<std::string>("output", "stage_cache");
+        configs.erase(configs.begin(), cached_end);
+        configs.push_front(std::move(reader));
+    } else {
+        LOG(STATUS) << "Storing the output in the cache at " << cache_file.string();
+        std::filesystem::create_directories(cache_directory);
+        stage_cache_file_ = cache_file.string();
+
+        // The writer creates its file relative to the working directory
+        auto partial_file = std::filesystem::path(cache_file).replace_extension("partial.root");
+        Configuration writer("ROOTObjectWriter", global_config.getFilePath());
+        writer.set<std::string>("file_name", std::filesystem::relative(partial_file, gSystem->pwd()).string());
+        // Avoid clashing with a writer configured by the user, the writer does not dispatch messages
+        writer.set<std::string>("output", "stage_cache");
+        configs.insert(cached_end, std::move(writer));
+    }
+}
+
 /**
  * Sets the section header and logging settings before executing the  \ref Module::initialize() function.
  */
@@ -550,6 +918,24 @@ void ModuleManager::initialize() {
             available_hardware_concurrency -= 1u;
         }
         threads_num = global_config.get<unsigned int>("workers", std::max(available_hardware_concurrency, 1u));
+
+        // Split the modules into stages of a pipeline, each processed by its own number of workers
+        if(global_config.has("pipeline_stages")) {
+            auto stages = global_config.getArray<std::string>("pipeline_stages");
+            pipeline_workers_ = global_config.getArray<unsigned int>("pipeline_workers");
+            if(pipeline_workers_.size() != stages.size() + 1) {
+                throw InvalidCombinationError(global_config,
+                                              {"pipeline_stages", "pipeline_workers"},
+                                              "number of workers required for every stage, including the first one");
+            }
+            if(std::find(pipeline_workers_.begin(), pipeline_workers_.end(), 0u) != pipeline_workers_.end()) {
+                throw InvalidValueError(global_config, "pipeline_workers", "every stage needs at least one worker");
+            }
+            if(global_config.has("workers")) {
+                LOG(WARNING) << "Ignoring the number of workers, using the sum of the workers of all pipeline stages";
+            }
+            threads_num = std::accumulate(pipeline_workers_.begin(), pipeline_workers_.end(), 0u);
+        }
         if(threads_num < 2) {
             throw InvalidValueError(global_config, "workers", "number of workers should be larger than one");
         }
@@ -564,74 +950,179 @@ void ModuleManager::initialize() {
         ThreadPool::registerThreadCount(threads_num);
     }
 
+    // Replicate the field grids set up during initialization on every NUMA node if the workers are pinned to cores
+    if(threads_num > 0 && global_config.get<bool>("pin_threads")) {
+        numa::set_replication(true);
+        LOG(STATUS) << "Pinning workers to cores on " << numa::node_count() << " NUMA node(s)"
+                    << (numa::replication_enabled() ? ", replicating field grids on every node" : "");
+    }
+
     auto start_time = std::chrono::steady_clock::now();
     LOG_PROGRESS(STATUS, "INIT_LOOP") << "Initializing " << modules_.size() << " module instantiations";
     for(auto& module : modules_) {
-        LOG_PROGRESS(TRACE, "INIT_LOOP") << "Initializing " << module->get_identifier().getUniqueName();
+        prepare_module(module.get());
+    }
 
-        // Pass the config manager to this instance
-        module->set_config_manager(conf_manager_);
+    // Initialize a module with its own logging settings and ROOT directory, returning the time it took
+    auto initialize_function = [log_level = Log::getReportingLevel(), log_format = Log::getFormat()](Module* module) {
+        // Use the same log level and format as the main thread, also if running on another thread
+        Log::setReportingLevel(log_level);
+        Log::setFormat(log_format);
+        return initialize_module(module);
+    };
 
-        // Create main ROOT directory for this module class if it does not exists yet
-        LOG(TRACE) << "Creating and accessing ROOT directory";
-        std::string module_name = module->get_configuration().getName();
-        auto* directory = modules_file_->GetDirectory(module_name.c_str());
-        if(directory == nullptr) {
-            directory = modules_file_->mkdir(module_name.c_str());
-            if(directory == nullptr) {
-                throw RuntimeError("Cannot create or access overall ROOT directory for module " + module_name);
-            }
+    // Consecutive modules allowing parallel initialization do not depend on each other and are initialized concurrently
+    std::vector<long double> initialization_times;
+    for(auto iter = modules_.begin(); iter != modules_.end();) {
+        auto group_end = iter;
+        while(threads_num > 1 && group_end != modules_.end() && (*group_end)->parallelInitializationEnabled()) {
+            ++group_end;
+        }
+        if(std::distance(iter, group_end) < 2) {
+            initialization_times.push_back(initialize_function(iter->get()));
+            ++iter;
+            continue;
         }
-        directory->cd();
 
-        // Create local directory for this instance
-        TDirectory* local_directory = nullptr;
-        if(module->get_identifier().getIdentifier().empty()) {
-            local_directory = directory;
-        } else {
-            local_directory = directory->mkdir(module->get_identifier().getIdentifier().c_str());
-            if(local_directory == nullptr) {
-                throw RuntimeError("Cannot create or access local ROOT directory for module " + module->getUniqueName());
+        std::vector<Module*> group;
+        std::transform(iter, group_end, std::back_inserter(group), [](const auto& module) { return module.get(); });
+        LOG(DEBUG) << "Initializing " << group.size() << " module instantiations concurrently";
+
+        // Every thread initializes the next module not claimed yet, all threads are joined before rethrowing any exception
+        std::vector<long double> group_times(group.size());
+        std::atomic<size_t> next{0};
+        auto initialize_group = [&]() {
+            try {
+                for(size_t i = next++; i < group.size(); i = next++) {
+                    group_times[i] = initialize_function(group[i]);
+                }
+            } catch(...) {
+                // Stop initializing further modules of the group
+                next = group.size();
+                throw;
+            }
+        };
+        std::vector<std::future<void>> futures;
+        for(size_t i = 0; i < std::min<size_t>(threads_num, group.size()); ++i) {
+            futures.push_back(std::async(std::launch::async, initialize_group));
+        }
+        std::exception_ptr exception;
+        for(auto& future : futures) {
+            try {
+                future.get();
+            } catch(...) {
+                if(!exception) {
+                    exception = std::current_exception();
+                }
             }
         }
+        if(exception) {
+            std::rethrow_exception(exception);
+        }
 
-        // Change to the directory and save it in the module
-        local_directory->cd();
-        module->set_ROOT_directory(local_directory);
+        initialization_times.insert(initialization_times.end(), group_times.begin(), group_times.end());
+        iter = group_end;
+    }
 
-        // Get current time
-        auto start = std::chrono::steady_clock::now();
-        // Set module specific settings
-        auto old_settings = set_module_before(module->get_identifier().getUniqueName(), module->get_configuration(), "I:");
-        // Change to our ROOT directory
-        module->getROOTDirectory()->cd();
-        // Init module
-        module->initialize();
-        // Reset logging
-        set_module_after(old_settings);
-        // Update execution time
-        auto end = std::chrono::steady_clock::now();
-        module_execution_time_[module.get()] += static_cast<std::chrono::duration<long double>>(end - start).count();
+    // Report the time spent initializing every module and add it to its execution time
+    auto time_iter = initialization_times.begin();
+    for(auto& module : modules_) {
+        LOG(INFO) << "Initialization of " << module->getUniqueName() << " took " << *time_iter << " seconds";
+        module_execution_time_[module.get()] += *time_iter++;
     }
-    LOG_PROGRESS(STATUS, "INIT_LOOP") << "Initialized " << modules_.size() << " module instantiations";
+
     auto end_time = std::chrono::steady_clock::now();
-    total_time_ += static_cast<std::chrono::duration<long double>>(end_time - start_time).count();
+    auto init_time = static_cast<std::chrono::duration<long double>>(end_time - start_time).count();
+    LOG_PROGRESS(STATUS, "INIT_LOOP") << "Initialized " << modules_.size() << " module instantiations in "
+                                      << seconds_to_time(init_time);
+    total_time_ += init_time;
 }
 
 /**
  * Initializes the thread pool and executes each event in parallel.
  */
 void ModuleManager::run(RandomNumberGenerator& seeder) {
-    using namespace std::chrono_literals;
-
     Configuration& global_config = conf_manager_->getGlobalConfiguration();
-    auto plot = global_config.get<bool>("performance_plots");
+    run_count_++;
 
-    // Default to no additional thread without multithreading
-    auto threads_num = global_config.get<unsigned int>("workers");
-    size_t max_buffer_size = 1;
+    global_config.setDefault<uint64_t>("number_of_events", 1u);
+    auto number_of_events = global_config.get<uint64_t>("number_of_events");
 
-    // See if we can run in parallel with how many workers
+    // Skip first N events and discard their event seed from the seeder engine:
+    auto skip_events = global_config.get<uint64_t>("skip_events", 0);
+
+    // Only process a contiguous part of the events when the run is split into partitions processed separately
+    auto partitions = global_config.get<uint64_t>("partitions", 1);
+    if(partitions > 1) {
+        auto partition = global_config.get<uint64_t>("partition");
+        if(partition >= partitions) {
+            throw InvalidValueError(
+                global_config, "partition", "partition index has to be smaller than the number of partitions");
+        }
+        auto first_event = partition * (number_of_events / partitions) + std::min(partition, number_of_events % partitions);
+        number_of_events = number_of_events / partitions + (partition < number_of_events % partitions ? 1 : 0);
+        skip_events += first_event;
+        LOG(STATUS) << "Processing partition " << partition << " of " << partitions << " with events " << skip_events + 1
+                    << " to " << skip_events + number_of_events;
+    }
+
+    // Continue after the last event of a checkpoint written by an earlier run of the same simulation
+    if(global_config.has("resume_checkpoint")) {
+        auto last_event = restore_checkpoint(global_config.getPath("resume_checkpoint", true));
+        if(last_event < skip_events || last_event >= skip_events + number_of_events) {
+            throw InvalidValueError(global_config,
+                                    "resume_checkpoint",
+                                    "checkpoint after event " + std::to_string(last_event) +
+                                        " does not lie within the events of this run");
+        }
+        LOG(STATUS) << "Resuming run from checkpoint after event " << last_event;
+        number_of_events -= last_event - skip_events;
+        skip_events = last_event;
+    }
+    seeder.discard(skip_events);
+
+    run_events(seeder, skip_events, number_of_events);
+
+    LOG(TRACE) << "Destroying thread pool";
+    destroy_thread_pools();
+}
+
+/**
+ * The first call starts after the skipped events of the configuration. Later calls continue with the following events and
+ * seeds, such that processing the events in several calls yields the same events as a single run. The worker threads and
+ * their per-thread module state are kept until the modules are finalized.
+ */
+uint64_t ModuleManager::runEvents(RandomNumberGenerator& seeder, uint64_t number_of_events) {
+    Configuration& global_config = conf_manager_->getGlobalConfiguration();
+    auto skip_events = global_config.get<uint64_t>("skip_events", 0);
+    if(!events_on_demand_) {
+        if(scan_points_.size() > 1) {
+            throw InvalidValueError(
+                global_config, "scan_file", "parameter scans cannot be combined with processing events on demand");
+        }
+        LOG(STATUS) << "Processing events on demand";
+        events_on_demand_ = true;
+        last_event_ = skip_events;
+        seeder.discard(skip_events);
+    }
+
+    auto finished_events = run_events(seeder, last_event_, number_of_events);
+    last_event_ += finished_events;
+
+    // Report the total number of events processed when finalizing
+    global_config.set<uint64_t>("number_of_events", last_event_ - skip_events);
+    return finished_events;
+}
+
+void ModuleManager::create_thread_pool(uint64_t skip_events) {
+    Configuration& global_config = conf_manager_->getGlobalConfiguration();
+
+    // Default to no additional thread without multithreading
+    auto threads_num = global_config.get<unsigned int>("workers");
+    size_t max_buffer_size = 1;
+    size_t max_buffer_memory = 0;
+
+    // See if we can run in parallel with how many workers
     if(multithreading_flag_ && can_parallelize_) {
         LOG(STATUS) << "Multithreading enabled, processing events in parallel on " << threads_num << " worker threads";
 
@@ -641,6 +1132,13 @@ void ModuleManager::run(RandomNumberGenerator& seeder) {
             throw InvalidValueError(global_config, "buffer_per_worker", "buffer per worker should be larger than one");
         }
         LOG(STATUS) << "Allocating a total of " << max_buffer_size << " event slots for buffered modules";
+
+        // Optionally limit the memory held by the buffered events, given in megabytes
+        auto buffer_memory = global_config.get<size_t>("buffer_memory", 0);
+        if(buffer_memory > 0) {
+            LOG(STATUS) << "Limiting the memory held by buffered events to approximately " << buffer_memory << " MB";
+        }
+        max_buffer_memory = buffer_memory * 1024 * 1024;
     } else {
         // Issue a warning in case MT was requested but we can't actually run in MT
         if(multithreading_flag_ && !can_parallelize_) {
@@ -651,8 +1149,8 @@ void ModuleManager::run(RandomNumberGenerator& seeder) {
         }
     }
 
-    // Book performance histograms
-    if(global_config.get<bool>("performance_plots")) {
+    // Book performance histograms, once for all points of a parameter scan
+    if(global_config.get<bool>("performance_plots") && event_time_ == nullptr) {
         buffer_fill_level_ = CreateHistogram<TH1D>("buffer_fill_level",
                                                    "Buffer fill level;# buffered events;# events",
                                                    static_cast<int>(max_buffer_size),
@@ -668,14 +1166,20 @@ void ModuleManager::run(RandomNumberGenerator& seeder) {
         }
     }
 
-    // Creates the thread pool
-    LOG(TRACE) << "Initializing thread pool with " << threads_num << " threads";
-    auto initialize_function =
-        [log_level = Log::getReportingLevel(), log_format = Log::getFormat(), modules_list = modules_]() {
+    // Initialize the modules processed by the workers of a thread pool for each thread
+    auto initialize_function = [log_level = Log::getReportingLevel(),
+                                log_format = Log::getFormat(),
+                                pin_threads = global_config.get<bool>("pin_threads")](ModuleList modules_list) {
+        return [log_level, log_format, pin_threads, modules_list = std::move(modules_list)]() {
             // Initialize the threads to the same log level and format as the master setting
             Log::setReportingLevel(log_level);
             Log::setFormat(log_format);
 
+            // Pin the worker before any module allocates thread-local memory, such that it is placed on the local node
+            if(pin_threads && !numa::pin_thread(ThreadPool::threadNum() - 1)) {
+                LOG(WARNING) << "Cannot pin worker " << ThreadPool::threadNum() << " to a core";
+            }
+
             // Call per-thread initialization of each module
             for(const auto& module : modules_list) {
                 // Set module specific log settings
@@ -689,45 +1193,660 @@ void ModuleManager::run(RandomNumberGenerator& seeder) {
                 ModuleManager::set_module_after(old_settings);
             }
         };
+    };
 
     // Finalize modules for each thread
-    auto finalize_function = [modules_list = modules_]() {
-        for(const auto& module : modules_list) {
-            // Set module specific log settings
-            auto old_settings = ModuleManager::set_module_before(
-                module->get_identifier().getUniqueName(), module->get_configuration(), "T:");
+    auto finalize_function = [](ModuleList modules_list) {
+        return [modules_list = std::move(modules_list)]() {
+            for(const auto& module : modules_list) {
+                // Set module specific log settings
+                auto old_settings = ModuleManager::set_module_before(
+                    module->get_identifier().getUniqueName(), module->get_configuration(), "T:");
 
-            LOG(TRACE) << "Finalizing thread " << std::this_thread::get_id();
-            module->finalizeThread();
+                LOG(TRACE) << "Finalizing thread " << std::this_thread::get_id();
+                module->finalizeThread();
 
-            // Reset logging
-            ModuleManager::set_module_after(old_settings);
-        }
+                // Reset logging
+                ModuleManager::set_module_after(old_settings);
+            }
+        };
     };
 
+    // Split the modules into the stages of the pipeline, every listed module starts a new stage
+    destroy_thread_pools();
+    if(multithreading_flag_ && can_parallelize_ && !pipeline_workers_.empty()) {
+        auto begin = modules_.begin();
+        for(const auto& name : global_config.getArray<std::string>("pipeline_stages")) {
+            auto end = std::find_if(begin, modules_.end(), [&name](const auto& module) {
+                return module->get_configuration().getName() == name;
+            });
+            if(end == begin || end == modules_.end()) {
+                throw InvalidValueError(
+                    global_config, "pipeline_stages", "module " + name + " does not follow the previous stage");
+            }
+            pipeline_stages_.push_back({begin, end, nullptr});
+            begin = end;
+        }
+        pipeline_stages_.push_back({begin, modules_.end(), nullptr});
+        for(size_t stage = 0; stage < pipeline_stages_.size(); ++stage) {
+            for(auto iter = pipeline_stages_[stage].begin; iter != pipeline_stages_[stage].end; ++iter) {
+                pipeline_stage_index_.emplace(iter->get(), stage);
+            }
+            LOG(STATUS) << "Pipeline stage " << stage + 1 << " starting with "
+                        << (*pipeline_stages_[stage].begin)->get_identifier().getUniqueName() << " processed by "
+                        << pipeline_workers_[stage] << " workers";
+        }
+    }
+
+    // Creates the thread pool, of the first stage only if the modules are split into a pipeline
+    auto pool_threads = (pipeline_stages_.empty() ? threads_num : pipeline_workers_.front());
+    auto pool_modules = (pipeline_stages_.empty() ? modules_ : ModuleList(modules_.begin(), pipeline_stages_.front().end));
+    auto pool_buffer_size = (pipeline_stages_.empty() ? max_buffer_size : max_buffer_size * pool_threads / threads_num);
+    LOG(TRACE) << "Initializing thread pool with " << pool_threads << " threads";
+
     // Push 128 events for each worker to maintain enough work
-    auto max_queue_size = threads_num * 128;
-    std::unique_ptr<ThreadPool> thread_pool =
-        std::make_unique<ThreadPool>(threads_num, max_queue_size, max_buffer_size, initialize_function, finalize_function);
+    auto max_queue_size = pool_threads * 128;
+    thread_pool_ = std::make_unique<ThreadPool>(pool_threads,
+                                                max_queue_size,
+                                                pool_buffer_size,
+                                                initialize_function(pool_modules),
+                                                finalize_function(pool_modules));
+    thread_pool_->setMaxBufferedMemory(max_buffer_memory);
+
+    // The queues between the stages only hold a few events per worker, to limit the memory of the events in flight
+    auto queue_per_worker = global_config.get<unsigned int>("pipeline_queue_per_worker", 4);
+    if(!pipeline_stages_.empty() && queue_per_worker == 0) {
+        throw InvalidValueError(global_config, "pipeline_queue_per_worker", "queue needs to hold at least one event");
+    }
+    for(size_t stage = 1; stage < pipeline_stages_.size(); ++stage) {
+        auto& pipeline_stage = pipeline_stages_[stage];
+        ModuleList stage_modules(pipeline_stage.begin, pipeline_stage.end);
+        LOG(TRACE) << "Initializing thread pool of pipeline stage " << stage + 1 << " with " << pipeline_workers_[stage]
+                   << " threads";
+        pipeline_stage.thread_pool = std::make_unique<ThreadPool>(pipeline_workers_[stage],
+                                                                  queue_per_worker * pipeline_workers_[stage],
+                                                                  max_buffer_size * pipeline_workers_[stage] / threads_num,
+                                                                  initialize_function(stage_modules),
+                                                                  finalize_function(stage_modules));
+        pipeline_stage.thread_pool->setMaxBufferedMemory(max_buffer_memory);
+    }
+
+    // Mark the first N events as completed for the thread pools. Since events start at one, always mark zero identifier as
+    // completed
+    for(auto* pool : thread_pools()) {
+        for(size_t n = 0; n <= skip_events; n++) {
+            pool->markComplete(n);
+        }
+    }
+}
+
+ThreadPool* ModuleManager::stage_thread_pool(const Module* module) const {
+    auto stage = pipeline_stage_index_.find(module);
+    if(stage == pipeline_stage_index_.end() || stage->second == 0) {
+        return thread_pool_.get();
+    }
+    return pipeline_stages_[stage->second].thread_pool.get();
+}
+
+std::vector<ThreadPool*> ModuleManager::thread_pools() const {
+    std::vector<ThreadPool*> pools{thread_pool_.get()};
+    for(const auto& stage : pipeline_stages_) {
+        if(stage.thread_pool != nullptr) {
+            pools.push_back(stage.thread_pool.get());
+        }
+    }
+    return pools;
+}
+
+/**
+ * The pools are destroyed starting from the last stage, such that workers waiting to hand an event over to the next stage
+ * are released by the invalidated queue instead of blocking the shutdown
+ */
+void ModuleManager::destroy_thread_pools() {
+    for(auto stage = pipeline_stages_.rbegin(); stage != pipeline_stages_.rend(); ++stage) {
+        stage->thread_pool.reset();
+    }
+    thread_pool_.reset();
+    pipeline_stages_.clear();
+    pipeline_stage_index_.clear();
+}
+
+uint64_t ModuleManager::run_events(RandomNumberGenerator& seeder, uint64_t skip_events, uint64_t number_of_events) {
+    using namespace std::chrono_literals;
+
+    Configuration& global_config = conf_manager_->getGlobalConfiguration();
+    auto plot = global_config.get<bool>("performance_plots");
+    auto warn_config_access = global_config.get<bool>("warn_config_access");
+    auto random_engine_type = global_config.get<RandomNumberGenerator::Engine>("random_engine");
+
+    // Write the log messages from a background thread during the event loop, it is stopped again before leaving this scope
+    struct AsynchronousLogging {
+        explicit AsynchronousLogging(bool enable) : enabled(enable) { Log::setAsynchronous(enabled); }
+        ~AsynchronousLogging() {
+            if(enabled) {
+                Log::setAsynchronous(false);
+            }
+        }
+        AsynchronousLogging(const AsynchronousLogging&) = delete;
+        AsynchronousLogging& operator=(const AsynchronousLogging&) = delete;
+        bool enabled;
+    } asynchronous_logging(global_config.get<bool>("log_asynchronous"));
+
+    // Create the thread pool, unless it has been kept from an earlier call processing events on demand
+    auto pools = thread_pools();
+    if(thread_pool_ == nullptr ||
+       std::any_of(pools.begin(), pools.end(), [](ThreadPool* pool) { return !pool->valid(); })) {
+        create_thread_pool(skip_events);
+        pools = thread_pools();
+    }
+    auto& thread_pool = thread_pool_;
+
+    // Wait for the workers of all stages in their order. Later stages are not awaited once a stage is terminated, since they
+    // might wait for events which never arrive. The exception of the latest stage is propagated first, since earlier stages
+    // fail as consequence when they cannot hand over their events anymore.
+    auto wait_thread_pools = [&pools]() {
+        for(auto* pool : pools) {
+            pool->wait();
+            if(!pool->valid()) {
+                break;
+            }
+        }
+    };
+    auto check_thread_pools = [&pools]() {
+        for(auto pool = pools.rbegin(); pool != pools.rend(); ++pool) {
+            (*pool)->checkException();
+        }
+    };
 
     // Record the run stage total time
     auto start_time = std::chrono::steady_clock::now();
+    if(profiler_ != nullptr) {
+        profiler_->start();
+    }
 
     // Push all events to the thread pool
     std::atomic<uint64_t> finished_events{0};
-    global_config.setDefault<uint64_t>("number_of_events", 1u);
-    auto number_of_events = global_config.get<uint64_t>("number_of_events");
 
-    // Skip first N events and discard their event seed from the seeder engine:
-    auto skip_events = global_config.get<uint64_t>("skip_events", 0);
-    seeder.discard(skip_events);
+    // Optionally write a checkpoint every N events, to allow resuming the run after a failure
+    auto checkpoint_interval = global_config.get<uint64_t>("checkpoint_interval", 0);
+    auto checkpoint_file = global_config.get<std::string>("checkpoint_file", "checkpoint.conf");
+    if(checkpoint_interval > 0) {
+        LOG(STATUS) << "Writing a checkpoint every " << checkpoint_interval << " events";
+    }
 
-    // Mark the first N events as completed for the thread pool. Since events start at one, always mark zero identifier as
-    // completed
-    for(size_t n = 0; n <= skip_events; n++) {
-        thread_pool->markComplete(n);
+    // Release messages early to limit the memory held by buffered events
+    if(global_config.get<bool>("release_messages")) {
+        LOG(STATUS) << "Releasing messages as soon as all their receivers have been executed";
+        messenger_->setReleaseMessages(true);
     }
 
+    // Drop empty messages to skip all modules depending on them in events without data for a detector
+    if(global_config.get<bool>("skip_empty_messages")) {
+        LOG(STATUS) << "Dropping empty messages, modules requiring them are skipped";
+        messenger_->setSkipEmptyMessages(true);
+    }
+
+    // Compile the routing table of the messages once before processing the events
+    messenger_->compileRoutes();
+
+    // Find the groups of consecutive instances of detector modules from the same section, to run them concurrently
+    std::map<const Module*, ModuleList::iterator> concurrent_groups;
+    if(global_config.get<bool>("parallel_detector_modules")) {
+        auto concurrent = [](const std::shared_ptr<Module>& first, const std::shared_ptr<Module>& module) {
+            return module->getDetector() != nullptr && !module->require_sequence() &&
+                   module->get_identifier().getName() == first->get_identifier().getName() &&
+                   module->get_configuration().get<std::string>("input") ==
+                       first->get_configuration().get<std::string>("input") &&
+                   module->get_configuration().get<std::string>("output") ==
+                       first->get_configuration().get<std::string>("output");
+        };
+        for(auto iter = modules_.begin(); iter != modules_.end();) {
+            auto group_end = std::next(iter);
+            if(concurrent(*iter, *iter)) {
+                while(group_end != modules_.end() && concurrent(*iter, *group_end)) {
+                    ++group_end;
+                }
+            }
+            auto group_size = std::distance(iter, group_end);
+            if(group_size > 1) {
+                LOG(STATUS) << "Running " << group_size << " instances of " << (*iter)->get_identifier().getName()
+                            << " concurrently within each event";
+                concurrent_groups.emplace(iter->get(), group_end);
+            }
+            iter = group_end;
+        }
+    }
+
+    // Run the leading modules of a window of events first and order the remaining modules of these events by their cost
+    auto event_lookahead = global_config.get<uint64_t>("event_lookahead", 0);
+    auto head_end = modules_.end();
+    if(event_lookahead > 0) {
+        if(checkpoint_interval > 0) {
+            throw InvalidCombinationError(global_config,
+                                          {"event_lookahead", "checkpoint_interval"},
+                                          "checkpoints cannot be written while events are held back for scheduling");
+        }
+
+        // The leading modules do not receive any messages, such as the generators of the deposited charges
+        head_end = std::find_if(modules_.begin(), modules_.end(), [&concurrent_groups](const auto& module) {
+            return !module->delegates_.empty() || concurrent_groups.count(module.get()) != 0;
+        });
+        auto sequential = std::any_of(modules_.begin(), head_end, [](const auto& module) {
+            return module->require_sequence();
+        });
+        if(head_end == modules_.begin() || head_end == modules_.end() || sequential) {
+            LOG(WARNING) << "Cannot split the modules into event generators and the remaining chain, ignoring event look-ahead";
+            event_lookahead = 0;
+            head_end = modules_.end();
+        } else {
+            LOG(STATUS) << "Scheduling events in windows of " << event_lookahead << " events by the memory used after "
+                        << (*std::prev(head_end))->get_identifier().getUniqueName();
+        }
+    }
+
+    // Optionally process consecutive events together, running every module for all events of a batch at once
+    auto event_batch_size = global_config.get<uint64_t>("event_batch_size", 1);
+    if(event_batch_size == 0) {
+        throw InvalidValueError(global_config, "event_batch_size", "batches need to contain at least one event");
+    }
+    if(event_batch_size > 1) {
+        if(event_lookahead > 0) {
+            throw InvalidCombinationError(global_config,
+                                          {"event_batch_size", "event_lookahead"},
+                                          "events processed in batches cannot be scheduled individually");
+        }
+        if(checkpoint_interval % event_batch_size != 0) {
+            throw InvalidCombinationError(global_config,
+                                          {"event_batch_size", "checkpoint_interval"},
+                                          "checkpoint interval has to be a multiple of the batch size");
+        }
+        LOG(STATUS) << "Processing events in batches of " << event_batch_size << " events";
+    }
+
+    // Start every event with the modules of the first stage of the pipeline, which hand it over to the next stage
+    if(!pipeline_stages_.empty()) {
+        if(event_lookahead > 0) {
+            throw InvalidCombinationError(global_config,
+                                          {"pipeline_stages", "event_lookahead"},
+                                          "events cannot be held back for scheduling between the stages of a pipeline");
+        }
+        if(event_batch_size > 1) {
+            throw InvalidCombinationError(global_config,
+                                          {"pipeline_stages", "event_batch_size"},
+                                          "batches of events cannot be handed over between the stages of a pipeline");
+        }
+        head_end = pipeline_stages_.front().end;
+    }
+
+    // Limit the number of unfinished events in the pipeline, such that the buffer of every stage can hold all of them
+    // while waiting for the oldest event. Otherwise, the queues between the stages could fill up with events which cannot
+    // be processed before the oldest one, while the oldest one cannot be handed over.
+    std::mutex pipeline_mutex;
+    std::condition_variable pipeline_condition;
+    uint64_t pipeline_window = 0;
+    if(!pipeline_stages_.empty()) {
+        auto buffer_per_worker = global_config.get<uint64_t>("buffer_per_worker", 512);
+        auto min_workers = *std::min_element(pipeline_workers_.begin(), pipeline_workers_.end());
+        pipeline_window = (buffer_per_worker - 1) * min_workers + 1;
+    }
+
+    // Events which finished their leading modules, with the estimated cost and the continuation of the event
+    std::mutex lookahead_mutex;
+    std::condition_variable lookahead_condition;
+    std::vector<std::tuple<size_t, uint64_t, std::function<void()>>> lookahead_events;
+
+    // Optionally export the progress of the event loop periodically for monitoring
+    std::unique_ptr<MetricsExporter> metrics;
+    if(global_config.has("metrics_file")) {
+        std::filesystem::path metrics_path = global_config.get<std::string>("metrics_file");
+        if(metrics_path.is_relative()) {
+            metrics_path = std::filesystem::path(gSystem->pwd()) / metrics_path;
+        }
+        global_config.setDefault("metrics_format", MetricsExporter::Format::JSON);
+        global_config.setDefault("metrics_interval", Units::get(10.0, "s"));
+        auto interval = std::chrono::duration<double, std::nano>(global_config.get<double>("metrics_interval"));
+        if(interval.count() <= 0) {
+            throw InvalidValueError(global_config, "metrics_interval", "interval has to be positive");
+        }
+        metrics = std::make_unique<MetricsExporter>(metrics_path.string(),
+                                                    global_config.get<MetricsExporter::Format>("metrics_format"),
+                                                    std::chrono::duration_cast<MetricsExporter::Clock::duration>(interval));
+        for(auto& module : modules_) {
+            metrics->registerModule(module.get());
+        }
+        metrics->start(thread_pool.get(), &finished_events, number_of_events);
+    }
+
+    // Optionally report events taking much longer than the earlier ones and log the processing time of every event
+    if(slow_events_ == nullptr && (global_config.has("slow_event_percentile") || global_config.has("event_cost_file"))) {
+        auto percentile = global_config.get<double>("slow_event_percentile", 0);
+        if(percentile < 0 || percentile >= 100) {
+            throw InvalidValueError(global_config, "slow_event_percentile", "percentile has to be between 0 and 100");
+        }
+        auto factor = global_config.get<double>("slow_event_factor", 10);
+        if(factor <= 0) {
+            throw InvalidValueError(global_config, "slow_event_factor", "factor has to be positive");
+        }
+        slow_events_ = std::make_unique<SlowEventMonitor>(
+            percentile, factor, global_config.get<uint64_t>("slow_event_minimum_events", 100));
+        if(percentile > 0) {
+            LOG(STATUS) << "Reporting events taking more than " << factor << " times the " << percentile
+                        << "th percentile of the processing time of earlier events";
+        }
+
+        auto output_path = [&global_config](const std::string& key) {
+            std::filesystem::path path = global_config.get<std::string>(key);
+            return (path.is_relative() ? std::filesystem::path(gSystem->pwd()) / path : path).string();
+        };
+        if(global_config.has("event_cost_file")) {
+            std::vector<std::string> names;
+            for(auto& module : modules_) {
+                names.push_back(module->get_identifier().getUniqueName());
+            }
+            slow_events_->setCostFile(output_path("event_cost_file"), names);
+        }
+
+        // Events are reproduced individually from the random seeds of the run and their event number
+        if(global_config.has("slow_event_replay_file")) {
+            slow_events_->setReplayFile(output_path("slow_event_replay_file"),
+                                        "allpix -c " + global_config.getFilePath() +
+                                            " -o random_seed=" + global_config.get<std::string>("random_seed") +
+                                            " -o random_seed_core=" + global_config.get<std::string>("random_seed_core") +
+                                            " -o partitions=1");
+        }
+    }
+
+    // Optionally write the messages of events entering the buffer to disk while the buffered events hold too much memory
+    auto spill_memory = static_cast<size_t>(global_config.get<double>("spill_memory", 0) * 1024 * 1024);
+    std::filesystem::path spill_directory;
+    std::atomic<uint64_t> spilled_events{0};
+
+    // Events rejected by a module skip all later modules and only count as finished
+    std::atomic<uint64_t> rejected_events{0};
+    if(spill_memory > 0) {
+        std::filesystem::path base_directory =
+            global_config.has("spill_directory") ? global_config.getPath("spill_directory")
+                                                 : std::filesystem::temp_directory_path().string();
+        spill_directory = base_directory / ("allpix_spill_" + std::to_string(getpid()));
+        std::filesystem::create_directories(spill_directory);
+        LOG(STATUS) << "Writing the messages of buffered events to " << spill_directory.string()
+                    << " while the buffered events hold more than " << static_cast<double>(spill_memory) / 1024 / 1024
+                    << " MB";
+    }
+
+    // Optionally account the memory of the messages dispatched by every module
+    if(memory_monitor_ == nullptr && global_config.get<bool>("memory_report", false)) {
+        memory_monitor_ = std::make_unique<MemoryMonitor>();
+        LOG(STATUS) << "Accounting the memory of the messages dispatched by every module";
+    }
+
+    // Submit the remaining modules of all events up to the given one, most expensive first, once their leading modules
+    // finished. The reorder buffer of the thread pool keeps the order of events for modules requiring the sequence.
+    uint64_t scheduled_events = skip_events;
+    auto submit_lookahead_events = [&](uint64_t last_event) {
+        std::vector<std::tuple<size_t, uint64_t, std::function<void()>>> window;
+        {
+            std::unique_lock<std::mutex> lock{lookahead_mutex};
+            auto in_window = [last_event](const auto& entry) { return std::get<1>(entry) <= last_event; };
+            auto expected = static_cast<std::ptrdiff_t>(last_event - scheduled_events);
+            while(std::count_if(lookahead_events.begin(), lookahead_events.end(), in_window) < expected) {
+                if(!thread_pool->valid()) {
+                    return;
+                }
+                lookahead_condition.wait_for(lock, std::chrono::milliseconds(100));
+                lock.unlock();
+                thread_pool->checkException();
+                lock.lock();
+            }
+            auto split = std::stable_partition(lookahead_events.begin(), lookahead_events.end(), in_window);
+            window.assign(std::make_move_iterator(lookahead_events.begin()), std::make_move_iterator(split));
+            lookahead_events.erase(lookahead_events.begin(), split);
+        }
+        scheduled_events = last_event;
+
+        std::stable_sort(window.begin(), window.end(), [](const auto& lhs, const auto& rhs) {
+            return std::get<0>(lhs) > std::get<0>(rhs);
+        });
+        for(auto& entry : window) {
+            [[maybe_unused]] auto queued = thread_pool->post(std::move(std::get<2>(entry)));
+            assert(queued || !thread_pool->valid());
+        }
+    };
+
+    // Events of a batch, each with its own random engine such that the events do not depend on each other
+    struct EventBatch {
+        uint64_t first_event{};
+        std::vector<uint64_t> seeds;
+        std::vector<std::shared_ptr<Event>> events;
+        std::deque<RandomNumberGenerator> random_engines;
+        std::vector<long double> event_times;
+    };
+
+    // Run all modules for the events of a batch, suspending the whole batch if a module requires earlier events first
+    auto batch_function_with_module =
+        [this,
+         plot,
+         warn_config_access,
+         random_engine_type,
+         profiler = profiler_.get(),
+         metrics = metrics.get(),
+         slow_events = slow_events_.get(),
+         memory_monitor = memory_monitor_.get(),
+         number_of_events,
+         &finished_events,
+         &rejected_events,
+         &concurrent_groups,
+         &thread_pool](
+            std::shared_ptr<EventBatch> batch, ModuleList::iterator module_iter, auto&& self_func) mutable -> void {
+        if(batch->events.empty()) {
+            auto start_time = std::chrono::steady_clock::now();
+            for(size_t n = 0; n < batch->seeds.size(); ++n) {
+                auto event_num = batch->first_event + n;
+                auto event = std::make_shared<Event>(*this->messenger_, event_num, batch->seeds[n]);
+                batch->random_engines.emplace_back(random_engine_type);
+                event->set_and_seed_random_engine(&batch->random_engines.back());
+                event->start_time_ = start_time;
+                LOG(INFO) << "Starting event " << event_num << " with seed " << batch->seeds[n];
+                batch->events.push_back(std::move(event));
+            }
+            batch->event_times.resize(batch->events.size());
+        } else {
+            LOG(TRACE) << "Continue with earlier batch of events";
+            for(auto& event : batch->events) {
+                thread_pool->removeBufferedMemory(event->buffered_memory_);
+                event->buffered_memory_ = 0;
+                if(metrics != nullptr) {
+                    metrics->recordResume(module_iter->get());
+                }
+            }
+            if(profiler != nullptr) {
+                auto wait_time = std::chrono::steady_clock::now() - batch->events.front()->suspend_time_;
+                profiler->recordWait(module_iter->get(), std::chrono::duration<double>(wait_time).count());
+            }
+        }
+
+        std::vector<Event*> events;
+        std::vector<size_t> event_indices;
+        while(module_iter != modules_.end()) {
+            auto module = *module_iter;
+
+            // Run a group of detector module instances concurrently for every event
+            auto group = concurrent_groups.find(module.get());
+            if(group != concurrent_groups.end()) {
+                for(size_t n = 0; n < batch->events.size(); ++n) {
+                    if(batch->events[n]->rejected_) {
+                        continue;
+                    }
+                    batch->event_times[n] += this->run_concurrent_modules(batch->events[n].get(),
+                                                                          module_iter,
+                                                                          group->second,
+                                                                          warn_config_access,
+                                                                          plot,
+                                                                          profiler,
+                                                                          metrics,
+                                                                          slow_events);
+                }
+                module_iter = group->second;
+                continue;
+            }
+
+            // Select the events not rejected yet for which the module is satisfied to run
+            events.clear();
+            event_indices.clear();
+            for(size_t n = 0; n < batch->events.size(); ++n) {
+                auto* event = batch->events[n].get();
+                if(event->rejected_) {
+                    continue;
+                }
+                if(module->check_delegates(this->messenger_, event)) {
+                    events.push_back(event);
+                    event_indices.push_back(n);
+                } else {
+                    LOG(TRACE) << "Not all required messages are received for "
+                               << module->get_identifier().getUniqueName() << " in event " << event->number
+                               << ", skipping module!";
+                    event->get_local_messenger()->releaseMessages(module.get());
+                }
+            }
+            if(events.empty()) {
+                ++module_iter;
+                continue;
+            }
+
+            LOG_PROGRESS(TRACE, "EVENT_LOOP") << "Running events " << events.front()->number << " to "
+                                              << events.back()->number << " ["
+                                              << module->get_identifier().getUniqueName() << "]";
+
+            auto start = std::chrono::steady_clock::now();
+            auto start_cpu = (profiler != nullptr ? Profiler::threadTime() : 0.);
+            auto start_counts = (profiler != nullptr ? profiler->readHardwareCounters() : Profiler::HardwareCounts());
+
+            // Set module specific logging settings once for the whole batch
+            ALLPIX_PROFILE_ZONE_NAMED("Module::run", module->get_identifier().getUniqueName());
+            auto old_settings = ModuleManager::set_module_before(module.get(), events.front()->number);
+
+            // Run module, a module requiring the sequence needs all events before the batch to be completed
+            bool stop = false;
+            bool executed = false;
+            try {
+                if(module->require_sequence() && batch->first_event != thread_pool->minimumUncompleted()) {
+                    stop = true;
+                } else {
+                    executed = true;
+                    Configuration::setAccessWarnings(warn_config_access);
+                    module->run(events);
+                }
+            } catch(const MissingDependenciesException& e) {
+                stop = true;
+            } catch(const EndOfRunException& e) {
+                // Terminate if the module threw the EndOfRun request exception:
+                LOG(WARNING) << "Request to terminate:" << std::endl << e.what();
+                this->terminate_ = true;
+            }
+            Configuration::setAccessWarnings(false);
+
+            // Reset logging
+            ModuleManager::set_module_after(old_settings);
+
+            // Update execution time, shared equally by the events of the batch
+            auto end = std::chrono::steady_clock::now();
+            if(profiler != nullptr && executed) {
+                profiler->recordExecution(
+                    module.get(), events.front()->number, start, end, Profiler::threadTime() - start_cpu, start_counts);
+            }
+            if(metrics != nullptr && executed) {
+                metrics->recordExecution(module.get(), end - start);
+            }
+            {
+                std::lock_guard<std::mutex> stat_lock{Event::stats_mutex_};
+
+                auto duration = static_cast<std::chrono::duration<long double>>(end - start).count();
+                this->module_execution_time_[module.get()] += duration;
+                auto event_duration = duration / static_cast<long double>(events.size());
+                for(auto n : event_indices) {
+                    batch->event_times[n] += event_duration;
+                    if(slow_events != nullptr && executed) {
+                        batch->events[n]->module_times_.emplace_back(module.get(), event_duration);
+                    }
+                    if(plot) {
+                        this->module_event_time_[module.get()]->Fill(static_cast<double>(event_duration));
+                    }
+                }
+            }
+
+            if(stop) {
+                LOG(TRACE) << "Batch of events starting at " << batch->first_event
+                           << " was interrupted because of missing dependencies, rescheduling...";
+                // Account the memory of the events while they wait in the buffer
+                auto suspend_time = std::chrono::steady_clock::now();
+                for(auto& event : batch->events) {
+                    event->suspend_time_ = suspend_time;
+                    event->buffered_memory_ = event->memory_hint();
+                    thread_pool->addBufferedMemory(event->buffered_memory_);
+                    if(metrics != nullptr) {
+                        metrics->recordSuspend(module.get());
+                    }
+                }
+                // Reschedule the batch:
+                auto batch_function = std::bind(self_func, batch, module_iter, self_func);
+                [[maybe_unused]] auto queued = thread_pool->post(batch->first_event, batch_function, false);
+                assert(queued || !thread_pool->valid());
+                auto buffered_events = thread_pool->bufferedQueueSize();
+                LOG_PROGRESS(STATUS, "EVENT_LOOP") << "Buffered " << buffered_events << ", finished " << finished_events
+                                                   << " of " << number_of_events << " events";
+                return;
+            }
+
+            for(auto* event : events) {
+                event->get_local_messenger()->releaseMessages(module.get());
+            }
+            ++module_iter;
+        }
+
+        // All modules finished, mark all events of the batch as complete
+        for(size_t n = 0; n < batch->events.size(); ++n) {
+            const auto& event = batch->events[n];
+            thread_pool->markComplete(event->number);
+            if(event->rejected_) {
+                rejected_events++;
+            }
+            if(profiler != nullptr) {
+                auto latency = std::chrono::steady_clock::now() - event->start_time_;
+                profiler->recordEvent(std::chrono::duration<double>(latency).count());
+            }
+            if(plot) {
+                event_time_->Fill(static_cast<double>(batch->event_times[n]));
+            }
+            if(slow_events != nullptr) {
+                slow_events->recordEvent(event->number, batch->seeds[n], batch->event_times[n], event->module_times_);
+            }
+            if(memory_monitor != nullptr) {
+                memory_monitor->recordEvent(event->get_local_messenger()->getDispatchedMemory());
+            }
+        }
+
+        auto buffered_events = thread_pool->bufferedQueueSize();
+        if(plot) {
+            this->buffer_fill_level_->Fill(static_cast<double>(buffered_events));
+        }
+
+        finished_events += batch->events.size();
+        LOG_PROGRESS(STATUS, "EVENT_LOOP") << "Buffered " << buffered_events << ", finished " << finished_events << " of "
+                                           << number_of_events << " events";
+    };
+    auto batch = std::make_shared<EventBatch>();
+
+    // Wait until all events up to the given one have been processed and no later one has been started before checkpointing
+    auto write_checkpoint = [&](uint64_t last_event) {
+        if(checkpoint_interval > 0 && (last_event - skip_events) % checkpoint_interval == 0) {
+            wait_thread_pools();
+            check_thread_pools();
+            if(!terminate_) {
+                store_checkpoint(checkpoint_file, last_event);
+            }
+        }
+    };
+
     LOG(STATUS) << "Starting event loop";
     for(uint64_t i = 1 + skip_events; i <= number_of_events + skip_events; i++) {
         // Check if run was aborted and stop pushing extra events to the threadpool
@@ -741,31 +1860,107 @@ void ModuleManager::run(RandomNumberGenerator& seeder) {
         // Get a new seed for the new event
         uint64_t seed = seeder();
 
+        // Collect the events of a batch and submit them together once the batch is complete
+        if(event_batch_size > 1) {
+            if(batch->seeds.empty()) {
+                batch->first_event = i;
+            }
+            batch->seeds.push_back(seed);
+            if(batch->seeds.size() == event_batch_size || i == number_of_events + skip_events) {
+                auto batch_function =
+                    std::bind(batch_function_with_module, std::move(batch), modules_.begin(), batch_function_with_module);
+                [[maybe_unused]] auto queued = thread_pool->post(batch_function);
+                assert(queued || !thread_pool->valid());
+                thread_pool->checkException();
+                batch = std::make_shared<EventBatch>();
+            }
+            write_checkpoint(i);
+            continue;
+        }
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wstrict-overflow"
         auto event_function_with_module =
-            [this, plot, number_of_events, event_num = i, event_seed = seed, &finished_events, &thread_pool](
+            [this,
+             plot,
+             warn_config_access,
+             random_engine_type,
+             profiler = profiler_.get(),
+             metrics = metrics.get(),
+             slow_events = slow_events_.get(),
+             memory_monitor = memory_monitor_.get(),
+             number_of_events,
+             event_num = i,
+             event_seed = seed,
+             &finished_events,
+             &rejected_events,
+             &concurrent_groups,
+             &thread_pool,
+             &lookahead_mutex,
+             &lookahead_condition,
+             &lookahead_events,
+             &pipeline_mutex,
+             &pipeline_condition,
+             spill_memory,
+             &spill_directory,
+             &spilled_events](
                 std::shared_ptr<Event> event,
                 ModuleList::iterator module_iter,
+                ModuleList::iterator module_end,
                 long double event_time,
                 auto&& self_func) mutable -> void {
             // The RNG to be used by all events running on this thread
-            static thread_local RandomNumberGenerator random_engine;
+            static thread_local RandomNumberGenerator random_engine(random_engine_type);
+
+            // Workers of the pipeline stage processing the modules
+            auto* pool = this->stage_thread_pool(module_iter != module_end ? module_iter->get() : nullptr);
 
             // Create the event data
             if(event == nullptr) {
                 event = std::make_shared<Event>(*this->messenger_, event_num, event_seed);
                 event->set_and_seed_random_engine(&random_engine);
+                event->start_time_ = std::chrono::steady_clock::now();
                 LOG(INFO) << "Starting event " << event_num << " with seed " << event_seed;
             } else {
                 LOG(TRACE) << "Continue with earlier event, restoring random seed";
                 event->set_and_seed_random_engine(&random_engine);
                 event->restore_random_engine_state();
+                pool->removeBufferedMemory(event->buffered_memory_);
+                event->buffered_memory_ = 0;
+                if(!event->spill_file_.empty()) {
+                    event->get_local_messenger()->restoreMessages(event->spill_file_);
+                    event->spill_file_.clear();
+                }
+
+                // Attribute the time spent in the buffer to the module the event was waiting for
+                if(profiler != nullptr) {
+                    auto wait_time = std::chrono::steady_clock::now() - event->suspend_time_;
+                    profiler->recordWait(module_iter->get(), std::chrono::duration<double>(wait_time).count());
+                }
+                if(metrics != nullptr) {
+                    metrics->recordResume(module_iter->get());
+                }
             }
 
-            while(module_iter != modules_.end()) {
+            // Stop as soon as a module rejected the event
+            while(module_iter != module_end && !event->rejected_) {
                 auto module = *module_iter;
 
+                // Run a group of detector module instances concurrently
+                auto group = concurrent_groups.find(module.get());
+                if(group != concurrent_groups.end()) {
+                    event_time += this->run_concurrent_modules(event.get(),
+                                                               module_iter,
+                                                               group->second,
+                                                               warn_config_access,
+                                                               plot,
+                                                               profiler,
+                                                               metrics,
+                                                               slow_events);
+                    module_iter = group->second;
+                    continue;
+                }
+
                 LOG_PROGRESS(TRACE, "EVENT_LOOP")
                     << "Running event " << event->number << " [" << module->get_identifier().getUniqueName() << "]";
 
@@ -773,23 +1968,29 @@ void ModuleManager::run(RandomNumberGenerator& seeder) {
                 if(!module->check_delegates(this->messenger_, event.get())) {
                     LOG(TRACE) << "Not all required messages are received for " << module->get_identifier().getUniqueName()
                                << ", skipping module!";
+                    event->get_local_messenger()->releaseMessages(module.get());
                     ++module_iter;
                     continue;
                 }
 
                 // Get current time
                 auto start = std::chrono::steady_clock::now();
+                auto start_cpu = (profiler != nullptr ? Profiler::threadTime() : 0.);
+                auto start_counts = (profiler != nullptr ? profiler->readHardwareCounters() : Profiler::HardwareCounts());
 
                 // Set module specific logging settings
-                auto old_settings = ModuleManager::set_module_before(
-                    module->get_identifier().getUniqueName(), module->get_configuration(), "R:", event->number);
+                ALLPIX_PROFILE_ZONE_NAMED("Module::run", module->get_identifier().getUniqueName());
+                auto old_settings = ModuleManager::set_module_before(module.get(), event->number);
 
                 // Run module
                 bool stop = false;
+                bool executed = false;
                 try {
-                    if(module->require_sequence() && event_num != thread_pool->minimumUncompleted()) {
+                    if(module->require_sequence() && event_num != pool->minimumUncompleted()) {
                         stop = true;
                     } else {
+                        executed = true;
+                        Configuration::setAccessWarnings(warn_config_access);
                         module->run(event.get());
                     }
                 } catch(const MissingDependenciesException& e) {
@@ -799,17 +2000,28 @@ void ModuleManager::run(RandomNumberGenerator& seeder) {
                     LOG(WARNING) << "Request to terminate:" << std::endl << e.what();
                     this->terminate_ = true;
                 }
+                Configuration::setAccessWarnings(false);
 
                 // Reset logging
                 ModuleManager::set_module_after(old_settings);
 
                 // Update execution time
                 auto end = std::chrono::steady_clock::now();
+                if(profiler != nullptr && executed) {
+                    profiler->recordExecution(
+                        module.get(), event->number, start, end, Profiler::threadTime() - start_cpu, start_counts);
+                }
+                if(metrics != nullptr && executed) {
+                    metrics->recordExecution(module.get(), end - start);
+                }
                 std::lock_guard<std::mutex> stat_lock{event->stats_mutex_};
 
                 auto duration = static_cast<std::chrono::duration<long double>>(end - start).count();
                 event_time += duration;
                 this->module_execution_time_[module.get()] += duration;
+                if(slow_events != nullptr && executed) {
+                    event->module_times_.emplace_back(module.get(), duration);
+                }
 
                 if(plot) {
                     this->module_event_time_[module.get()]->Fill(static_cast<double>(duration));
@@ -820,77 +2032,371 @@ void ModuleManager::run(RandomNumberGenerator& seeder) {
                                << " was interrupted because of missing dependencies, rescheduling...";
                     // Store state of PRNG engine:
                     event->store_random_engine_state();
+                    event->suspend_time_ = std::chrono::steady_clock::now();
+                    // Account the memory of the event while it waits in the buffer, writing its messages to disk if the
+                    // buffered events would exceed the memory threshold
+                    event->buffered_memory_ = event->memory_hint();
+                    if(spill_memory > 0 && pool->bufferedMemory() + event->buffered_memory_ > spill_memory) {
+                        auto spill_file = spill_directory / ("event" + std::to_string(event->number) + ".spill");
+                        if(event->get_local_messenger()->spillMessages(spill_file.string())) {
+                            event->spill_file_ = spill_file.string();
+                            event->buffered_memory_ = event->memory_hint();
+                            spilled_events++;
+                        }
+                    }
+                    pool->addBufferedMemory(event->buffered_memory_);
+                    if(metrics != nullptr) {
+                        metrics->recordSuspend(module.get());
+                    }
                     // Reschedule the event:
-                    auto event_function = std::bind(self_func, event, module_iter, event_time, self_func);
-                    auto future = thread_pool->submit(event->number, event_function, false);
-                    assert(future.valid() || !thread_pool->valid());
-                    auto buffered_events = thread_pool->bufferedQueueSize();
+                    auto event_function = std::bind(self_func, event, module_iter, module_end, event_time, self_func);
+                    [[maybe_unused]] auto queued = pool->post(event->number, event_function, false);
+                    assert(queued || !pool->valid());
+                    auto buffered_events = pool->bufferedQueueSize();
                     LOG_PROGRESS(STATUS, "EVENT_LOOP") << "Buffered " << buffered_events << ", finished " << finished_events
                                                        << " of " << number_of_events << " events";
                     return;
                 }
 
+                event->get_local_messenger()->releaseMessages(module.get());
                 ++module_iter;
             }
 #pragma GCC diagnostic pop
 
-            // All modules finished, mark as complete
+            // Complete a rejected event directly, skipping all later stages
+            if(event->rejected_) {
+                LOG(DEBUG) << "Event " << event->number << " rejected before "
+                           << (module_iter != modules_.end() ? (*module_iter)->get_identifier().getUniqueName()
+                                                             : "the end of the run")
+                           << ", skipping remaining modules";
+                module_end = modules_.end();
+                rejected_events++;
+            }
+
+            // Hand the event over to the workers of the next pipeline stage, waiting while their queue is full
+            if(module_end != modules_.end() && !this->pipeline_stages_.empty()) {
+                const auto& stage = this->pipeline_stages_[this->pipeline_stage_index_.at(module_end->get())];
+                event->store_random_engine_state();
+                event->suspend_time_ = std::chrono::steady_clock::now();
+                if(metrics != nullptr) {
+                    metrics->recordSuspend(module_end->get());
+                }
+                auto event_function = std::bind(self_func, event, stage.begin, stage.end, event_time, self_func);
+                if(!stage.thread_pool->post(event_function)) {
+                    throw RuntimeError("Workers of the pipeline stage starting with " +
+                                       (*stage.begin)->get_identifier().getUniqueName() + " have been terminated");
+                }
+                return;
+            }
+
+            // Hand the event back to the event loop after its leading modules, to schedule the remaining ones by cost
+            if(module_end != modules_.end()) {
+                event->store_random_engine_state();
+                event->suspend_time_ = std::chrono::steady_clock::now();
+                event->buffered_memory_ = event->memory_hint();
+                pool->addBufferedMemory(event->buffered_memory_);
+                if(metrics != nullptr) {
+                    metrics->recordSuspend(module_end->get());
+                }
+                std::lock_guard<std::mutex> lock{lookahead_mutex};
+                lookahead_events.emplace_back(event->buffered_memory_,
+                                              event->number,
+                                              std::bind(self_func, event, module_end, modules_.end(), event_time, self_func));
+                lookahead_condition.notify_all();
+                return;
+            }
+
+            // All modules finished, mark as complete for the workers of all stages
             thread_pool->markComplete(event->number);
+            for(auto& stage : this->pipeline_stages_) {
+                if(stage.thread_pool != nullptr) {
+                    stage.thread_pool->markComplete(event->number);
+                }
+            }
+            if(profiler != nullptr) {
+                auto latency = std::chrono::steady_clock::now() - event->start_time_;
+                profiler->recordEvent(std::chrono::duration<double>(latency).count());
+            }
 
-            auto buffered_events = thread_pool->bufferedQueueSize();
+            auto buffered_events = pool->bufferedQueueSize();
             if(plot) {
                 this->buffer_fill_level_->Fill(static_cast<double>(buffered_events));
                 event_time_->Fill(static_cast<double>(event_time));
             }
+            if(slow_events != nullptr) {
+                slow_events->recordEvent(event->number, event->seed_, event_time, event->module_times_);
+            }
+            if(memory_monitor != nullptr) {
+                memory_monitor->recordEvent(event->get_local_messenger()->getDispatchedMemory());
+            }
 
             finished_events++;
+            if(!this->pipeline_stages_.empty()) {
+                std::lock_guard<std::mutex> lock{pipeline_mutex};
+                pipeline_condition.notify_all();
+            }
             LOG_PROGRESS(STATUS, "EVENT_LOOP") << "Buffered " << buffered_events << ", finished " << finished_events
                                                << " of " << number_of_events << " events";
         };
 
         auto event_function =
-            std::bind(event_function_with_module, nullptr, modules_.begin(), 0, event_function_with_module);
+            std::bind(event_function_with_module, nullptr, modules_.begin(), head_end, 0, event_function_with_module);
+
+        // Wait until the oldest events left the pipeline
+        if(pipeline_window > 0) {
+            std::unique_lock<std::mutex> lock{pipeline_mutex};
+            while(i - thread_pool->minimumUncompleted() >= pipeline_window && thread_pool->valid()) {
+                pipeline_condition.wait_for(lock, std::chrono::milliseconds(100));
+                lock.unlock();
+                check_thread_pools();
+                lock.lock();
+            }
+        }
+
+        [[maybe_unused]] auto queued = thread_pool->post(event_function);
+        assert(queued || !thread_pool->valid());
+        check_thread_pools();
+
+        // Schedule the previous window while the leading modules of the current one are processed
+        if(event_lookahead > 0 && (i - skip_events) % event_lookahead == 0 && i - skip_events > event_lookahead) {
+            submit_lookahead_events(i - event_lookahead);
+        }
+
+        write_checkpoint(i);
+    }
 
-        auto future = thread_pool->submit(event_function);
-        assert(future.valid() || !thread_pool->valid());
-        thread_pool->checkException();
+    // Schedule the events still held back
+    if(event_lookahead > 0 && !terminate_) {
+        submit_lookahead_events(skip_events + number_of_events);
     }
 
     LOG(TRACE) << "All events have been initialized. Waiting for thread pool to finish...";
 
     // Wait for workers to finish
-    thread_pool->wait();
+    wait_thread_pools();
 
     // Check exception for last events
-    thread_pool->checkException();
+    check_thread_pools();
 
     LOG_PROGRESS(STATUS, "EVENT_LOOP") << "Finished run of " << finished_events << " events";
+    if(rejected_events > 0) {
+        LOG(STATUS) << "Rejected " << rejected_events << " of " << finished_events << " events";
+    }
+    if(spill_memory > 0) {
+        LOG(STATUS) << "Wrote the messages of " << spilled_events << " buffered events to disk";
+        std::filesystem::remove_all(spill_directory);
+    }
+    if(memory_monitor_ != nullptr) {
+        size_t peak_buffered_memory = 0;
+        for(auto* pool : pools) {
+            peak_buffered_memory += pool->peakBufferedMemory();
+        }
+        memory_monitor_->recordBufferedMemory(peak_buffered_memory);
+    }
+    if(metrics != nullptr) {
+        metrics->stop();
+    }
+    if(profiler_ != nullptr) {
+        profiler_->stop();
+    }
     auto end_time = std::chrono::steady_clock::now();
     total_time_ += static_cast<std::chrono::duration<long double>>(end_time - start_time).count();
 
-    LOG(TRACE) << "Destroying thread pool";
+
+    return finished_events;
 }
 
-static std::string seconds_to_time(long double seconds) {
-    auto duration = std::chrono::duration<long long>(static_cast<long long>(std::round(seconds)));
+/**
+ * The modules of the group which received all their required messages are executed as subtasks of the event. The seeds of
+ * their random engines are drawn from the event in the order of the modules and the messages they dispatch are forwarded in
+ * the same order afterwards, such that the results do not depend on the scheduling of the subtasks.
+ */
+long double ModuleManager::run_concurrent_modules(Event* event,
+                                                  ModuleList::iterator begin,
+                                                  ModuleList::iterator end,
+                                                  bool warn_config_access,
+                                                  bool plot,
+                                                  Profiler* profiler,
+                                                  MetricsExporter* metrics,
+                                                  SlowEventMonitor* slow_events) {
+    auto* local_messenger = event->get_local_messenger();
+    auto engine = event->getRandomEngine().getEngine();
+
+    // Prepare the state of all modules which can run for this event
+    std::vector<std::shared_ptr<Module>> modules;
+    std::vector<std::unique_ptr<Event::ConcurrentModule>> states;
+    for(auto iter = begin; iter != end; ++iter) {
+        const auto& module = *iter;
+        if(!module->check_delegates(this->messenger_, event)) {
+            LOG(TRACE) << "Not all required messages are received for " << module->get_identifier().getUniqueName()
+                       << ", skipping module!";
+            continue;
+        }
+        modules.push_back(module);
+        states.push_back(std::make_unique<Event::ConcurrentModule>(event, engine, event->getRandomNumber()));
+    }
 
-    std::string time_str;
-    auto hours = std::chrono::duration_cast<std::chrono::hours>(duration);
-    duration -= hours;
-    if(hours.count() > 0) {
-        time_str += std::to_string(hours.count());
-        time_str += " hours ";
+    // Select the state of the concurrent module on the executing thread, also when the module throws
+    struct ConcurrentScope {
+        explicit ConcurrentScope(Event::ConcurrentModule* state) : previous(Event::concurrent_module_) {
+            Event::concurrent_module_ = state;
+        }
+        ~ConcurrentScope() {
+            Event::concurrent_module_ = previous;
+            Configuration::setAccessWarnings(false);
+        }
+        ConcurrentScope(const ConcurrentScope&) = delete;
+        ConcurrentScope& operator=(const ConcurrentScope&) = delete;
+        Event::ConcurrentModule* previous;
+    };
+
+    std::vector<long double> durations(modules.size());
+    std::vector<std::function<void()>> tasks;
+    for(size_t idx = 0; idx < modules.size(); ++idx) {
+        tasks.emplace_back([&, idx]() {
+            const auto& module = modules[idx];
+            ConcurrentScope scope(states[idx].get());
+
+            LOG_PROGRESS(TRACE, "EVENT_LOOP")
+                << "Running event " << event->number << " [" << module->get_identifier().getUniqueName() << "]";
+
+            auto start = std::chrono::steady_clock::now();
+            auto start_cpu = (profiler != nullptr ? Profiler::threadTime() : 0.);
+            auto start_counts = (profiler != nullptr ? profiler->readHardwareCounters() : Profiler::HardwareCounts());
+
+            // Set module specific logging settings and run the module
+            auto old_settings = set_module_before(module.get(), event->number);
+            try {
+                Configuration::setAccessWarnings(warn_config_access);
+                module->run(event);
+            } catch(const EndOfRunException& e) {
+                // Terminate if the module threw the EndOfRun request exception:
+                LOG(WARNING) << "Request to terminate:" << std::endl << e.what();
+                this->terminate_ = true;
+            }
+            set_module_after(old_settings);
+
+            auto end_time = std::chrono::steady_clock::now();
+            if(profiler != nullptr) {
+                profiler->recordExecution(
+                    module.get(), event->number, start, end_time, Profiler::threadTime() - start_cpu, start_counts);
+            }
+            if(metrics != nullptr) {
+                metrics->recordExecution(module.get(), end_time - start);
+            }
+            durations[idx] = static_cast<std::chrono::duration<long double>>(end_time - start).count();
+        });
     }
-    auto minutes = std::chrono::duration_cast<std::chrono::minutes>(duration);
-    duration -= minutes;
-    if(minutes.count() > 0) {
-        time_str += std::to_string(minutes.count());
-        time_str += " minutes ";
+    ThreadPool::runSubtasks(tasks);
+
+    // Forward the messages of the modules in their original order and keep their memory alive with the event
+    long double event_time = 0;
+    for(size_t idx = 0; idx < modules.size(); ++idx) {
+        for(auto& [source, message, name] : states[idx]->messages) {
+            local_messenger->dispatchMessage(source, std::move(message), name);
+        }
+        event->concurrent_arenas_.push_back(std::move(states[idx]->arena));
+
+        std::lock_guard<std::mutex> stat_lock{event->stats_mutex_};
+        event_time += durations[idx];
+        this->module_execution_time_[modules[idx].get()] += durations[idx];
+        if(plot) {
+            this->module_event_time_[modules[idx].get()]->Fill(static_cast<double>(durations[idx]));
+        }
+        if(slow_events != nullptr) {
+            event->module_times_.emplace_back(modules[idx].get(), durations[idx]);
+        }
     }
-    time_str += std::to_string(duration.count());
-    time_str += " seconds";
 
-    return time_str;
+    // Release the messages received by all modules of the group, including the skipped ones
+    for(auto iter = begin; iter != end; ++iter) {
+        local_messenger->releaseMessages(iter->get());
+    }
+    return event_time;
+}
+
+/**
+ * The checkpoint is written in the configuration file format. Its header contains the last event and the seeds of the run,
+ * followed by the state of every module with the keys prefixed by the unique name of the module as for command line
+ * options. The file is first written to a temporary file and then renamed, such that a failure while writing does not
+ * destroy the previous checkpoint.
+ */
+void ModuleManager::store_checkpoint(const std::string& file_name, uint64_t last_event) {
+    auto start = std::chrono::steady_clock::now();
+    Configuration& global_config = conf_manager_->getGlobalConfiguration();
+
+    auto temporary_file_name = file_name + ".tmp";
+    std::ofstream file(temporary_file_name);
+    file << "# Checkpoint of Allpix Squared " << ALLPIX_PROJECT_VERSION << ", resume with \"allpix -r <file>\"" << std::endl;
+    file << "last_event = " << last_event << std::endl;
+    file << "random_seed = " << global_config.get<uint64_t>("random_seed") << std::endl;
+    file << "random_seed_core = " << global_config.get<uint64_t>("random_seed_core") << std::endl;
+
+    for(auto& module : modules_) {
+        auto unique_name = module->get_identifier().getUniqueName();
+        auto old_settings = set_module_before(unique_name, module->get_configuration(), "C:");
+        Configuration state(unique_name);
+        module->storeCheckpoint(state);
+        set_module_after(old_settings);
+
+        for(const auto& [key, value] : state.getAll()) {
+            file << unique_name << "." << key << " = " << value << std::endl;
+        }
+    }
+
+    file.close();
+    if(!file) {
+        throw RuntimeError("Could not write checkpoint to file " + temporary_file_name);
+    }
+    std::filesystem::rename(temporary_file_name, file_name);
+
+    auto duration = static_cast<std::chrono::duration<long double>>(std::chrono::steady_clock::now() - start).count();
+    LOG(STATUS) << "Stored checkpoint after event " << last_event << " in " << duration << " seconds";
+}
+
+uint64_t ModuleManager::restore_checkpoint(const std::string& file_name) {
+    std::ifstream file(file_name);
+    auto checkpoint = ConfigReader(file, file_name).getHeaderConfiguration();
+
+    for(auto& module : modules_) {
+        // Collect the state stored with the unique name of the module as key prefix
+        auto unique_name = module->get_identifier().getUniqueName();
+        Configuration state(unique_name, file_name);
+        for(const auto& [key, value] : checkpoint.getAll()) {
+            if(key.size() > unique_name.size() + 1 && key.compare(0, unique_name.size(), unique_name) == 0 &&
+               key[unique_name.size()] == '.') {
+                state.setText(key.substr(unique_name.size() + 1), value);
+            }
+        }
+
+        auto old_settings = set_module_before(unique_name, module->get_configuration(), "C:");
+        module->restoreCheckpoint(state);
+        set_module_after(old_settings);
+    }
+
+    return checkpoint.get<uint64_t>("last_event");
+}
+
+void ModuleManager::finalize_module(Module* module) {
+    LOG_PROGRESS(TRACE, "FINALIZE_LOOP") << "Finalizing " << module->get_identifier().getUniqueName();
+
+    // Get current time
+    auto start = std::chrono::steady_clock::now();
+
+    // Set module specific log settings
+    auto old_settings = set_module_before(module->get_identifier().getUniqueName(), module->get_configuration(), "F:");
+    // Change to our ROOT directory, which is only created if the module writes to it
+    module->directory_->current()->cd();
+    // Finalize module
+    module->finalize();
+    // Remove the pointer to the ROOT directory after finalizing
+    module->set_ROOT_directory(nullptr);
+    // Remove the config manager
+    module->set_config_manager(nullptr);
+    set_module_after(old_settings);
+    // Update execution time
+    auto end = std::chrono::steady_clock::now();
+    module_execution_time_[module] += static_cast<std::chrono::duration<long double>>(end - start).count();
 }
 
 /**
@@ -898,35 +2404,30 @@ static std::string seconds_to_time(long double seconds) {
  * after finalization. No method will be called after finalizing the module (except the destructor).
  */
 void ModuleManager::finalize() {
+    // Finalize the worker threads kept after processing events on demand before the modules themselves
+    if(thread_pool_ != nullptr) {
+        LOG(TRACE) << "Destroying thread pool";
+        destroy_thread_pools();
+    }
+
     auto start_time = std::chrono::steady_clock::now();
     LOG_PROGRESS(TRACE, "FINALIZE_LOOP") << "Finalizing module instantiations";
     for(auto& module : modules_) {
-        LOG_PROGRESS(TRACE, "FINALIZE_LOOP") << "Finalizing " << module->get_identifier().getUniqueName();
-
-        // Get current time
-        auto start = std::chrono::steady_clock::now();
-
-        // Set module specific log settings
-        auto old_settings = set_module_before(module->get_identifier().getUniqueName(), module->get_configuration(), "F:");
-        // Change to our ROOT directory
-        module->getROOTDirectory()->cd();
-        // Finalize module
-        module->finalize();
-        // Remove the pointer to the ROOT directory after finalizing
-        module->set_ROOT_directory(nullptr);
-        // Remove the config manager
-        module->set_config_manager(nullptr);
-        set_module_after(old_settings);
-        // Update execution time
-        auto end = std::chrono::steady_clock::now();
-        module_execution_time_[module.get()] += static_cast<std::chrono::duration<long double>>(end - start).count();
+        finalize_module(module.get());
+    }
+
+    // Publish the output stored in the cache once the run has been completed
+    if(!stage_cache_file_.empty() && !terminate_) {
+        auto partial_file = std::filesystem::path(stage_cache_file_).replace_extension("partial.root");
+        std::filesystem::rename(partial_file, stage_cache_file_);
+        LOG(STATUS) << "Stored the output of the cached modules in " << stage_cache_file_;
     }
 
     // Store performance plots
     Configuration& global_config = conf_manager_->getGlobalConfiguration();
     if(global_config.get<bool>("performance_plots")) {
 
-        auto* perf_dir = modules_file_->mkdir("performance");
+        auto* perf_dir = get_root_directory("")->mkdir("performance");
         if(perf_dir == nullptr) {
             throw RuntimeError("Cannot create or access ROOT directory for performance plots");
         }
@@ -952,8 +2453,27 @@ void ModuleManager::finalize() {
         }
     }
 
-    // Close module ROOT file
-    modules_file_->Close();
+    // Summarize and export the profile of the event loop
+    if(profiler_ != nullptr) {
+        profiler_->summarize();
+
+        auto format = global_config.get<Profiler::Format>("profiling_format");
+        auto path = std::string(gSystem->pwd()) + "/" + global_config.get<std::string>("profiling_file", "profile");
+        path = std::filesystem::path(path).replace_extension(format == Profiler::Format::TRACE ? "json" : "csv");
+        if(std::filesystem::is_regular_file(path) && global_config.get<bool>("deny_overwrite", false)) {
+            throw RuntimeError("Overwriting of existing profile " + path + " denied");
+        }
+        profiler_->write(path, format);
+    }
+
+    // Close module ROOT file if any module wrote to it, objects still attached to unused directories are deleted as well
+    gROOT->cd();
+    if(modules_file_ != nullptr) {
+        modules_file_->Close();
+    } else {
+        LOG(DEBUG) << "No ROOT output written, main ROOT file has not been created";
+    }
+    lazy_directories_.clear();
     LOG_PROGRESS(STATUS, "FINALIZE_LOOP") << "Finalization completed";
     auto end_time = std::chrono::steady_clock::now();
     total_time_ += static_cast<std::chrono::duration<long double>>(end_time - start_time).count();
@@ -1002,15 +2522,24 @@ void ModuleManager::finalize() {
     for(auto& module : modules_) {
         LOG(INFO) << " Module " << module->getUniqueName() << " took " << module_execution_time_[module.get()] << " seconds";
     }
+    if(slow_events_ != nullptr) {
+        LOG(STATUS) << "Reported " << slow_events_->getSlowEvents() << " slow events";
+        slow_events_.reset();
+    }
+    if(memory_monitor_ != nullptr) {
+        memory_monitor_->report();
+        memory_monitor_.reset();
+    }
 
+    // Every point of a parameter scan processes the configured number of events
     long double processing_time = 0;
-    auto total_events = global_config.get<uint64_t>("number_of_events");
+    auto total_events = global_config.get<uint64_t>("number_of_events") * std::max<size_t>(run_count_, 1);
     if(total_events > 0) {
         processing_time = std::round((1000 * total_time_) / total_events);
     }
 
     LOG(STATUS) << "Average processing time is \x1B[1m" << processing_time << " ms/event\x1B[0m, event generation at \x1B[1m"
-                << std::round(global_config.get<double>("number_of_events") / total_time_) << " Hz\x1B[0m";
+                << std::round(static_cast<long double>(total_events) / total_time_) << " Hz\x1B[0m";
 
     if(global_config.get<unsigned int>("workers") > 0) {
         auto event_processing_time = std::round(processing_time * global_config.get<unsigned int>("workers"));
@@ -1025,3 +2554,134 @@ void ModuleManager::finalize() {
 void ModuleManager::terminate() {
     terminate_ = true;
 }
+
+/**
+ * Every section of the scan file defines a point, named after its header. The keys of a point are module options in the
+ * same format as passed to the executable, i.e. the name of the module or instantiation followed by a dot and the key.
+ */
+void ModuleManager::read_scan_points(const std::string& file_name) {
+    Configuration& global_config = conf_manager_->getGlobalConfiguration();
+    std::ifstream file(file_name);
+    ConfigReader reader(file, file_name);
+
+    std::set<std::string> names;
+    for(auto& config : reader.getConfigurations()) {
+        auto options = config.getAll();
+        if(config.getName().empty()) {
+            if(!options.empty()) {
+                throw InvalidValueError(global_config, "scan_file", "all parameters have to be part of a scan point");
+            }
+            continue;
+        }
+        if(!names.insert(config.getName()).second) {
+            throw InvalidValueError(global_config, "scan_file", "scan point " + config.getName() + " is defined twice");
+        }
+
+        ScanPoint point;
+        point.name = config.getName();
+        for(auto& [key, value] : options) {
+            auto dot_pos = key.find('.');
+            if(dot_pos == std::string::npos) {
+                throw InvalidValueError(global_config,
+                                        "scan_file",
+                                        "key " + key + " of scan point " + point.name + " is not a module parameter");
+            }
+            point.options.push_back(key + "=" + value);
+            point.parsed_options.push_back({key.substr(0, dot_pos), key.substr(dot_pos + 1), value});
+        }
+        scan_points_.push_back(std::move(point));
+    }
+
+    if(scan_points_.empty()) {
+        throw InvalidValueError(global_config, "scan_file", "no scan point defined");
+    }
+}
+
+bool ModuleManager::scan_requires_recreation(Module* module, size_t point) const {
+    // Instantiations writing output files are recreated to write the output of every point separately
+    auto& config = module->get_configuration();
+    if(module->output_files_created_ || config.get<bool>("scan_reinitialize", false)) {
+        return true;
+    }
+
+    auto unique_name = module->get_identifier().getUniqueName();
+    for(const auto& option : scan_points_[point].parsed_options) {
+        if(option.identifier != config.getName() && option.identifier != unique_name) {
+            continue;
+        }
+        if(!config.has(option.key) || config.getText(option.key) != option.value) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * The instantiations to recreate are finalized and constructed again from their section after the options of the point have
+ * been applied, with their output directed to the directory of the point. All other instantiations keep their state, such
+ * that the geometry, the physics and the fields of unchanged modules are not set up again. The execution time and the
+ * performance plots of a recreated instantiation are continued by its successor.
+ */
+void ModuleManager::startScanPoint(size_t point) {
+    const auto& scan_point = scan_points_.at(point);
+    LOG(STATUS) << "Starting scan point " << scan_point.name << " (" << (point + 1) << " of " << scan_points_.size() << ")";
+    auto start_time = std::chrono::steady_clock::now();
+
+    // Select the instantiations to recreate before the options of the point are applied
+    std::vector<ModuleList::iterator> recreate;
+    for(auto iter = modules_.begin(); iter != modules_.end(); ++iter) {
+        if(scan_requires_recreation(iter->get(), point)) {
+            recreate.push_back(iter);
+        }
+    }
+    conf_manager_->loadModuleOptions(scan_point.options);
+
+    for(auto& iter : recreate) {
+        finalize_module(iter->get());
+    }
+
+    auto global_dir = scan_directory_ + "/" + scan_point.name;
+    root_directory_name_ = scan_point.name;
+
+    for(auto& iter : recreate) {
+        auto identifier = (*iter)->get_identifier();
+        auto detector = (*iter)->getDetector();
+        auto& source = module_sources_.at(identifier.getUniqueName());
+        source.config->set<std::string>("_global_dir", global_dir);
+
+        // Destroy the previous instantiation before its configuration is replaced
+        auto* previous = iter->get();
+        auto execution_time = module_execution_time_[previous];
+        module_execution_time_.erase(previous);
+        auto event_time = module_event_time_.extract(previous);
+        iter->reset();
+
+        LOG(DEBUG) << "Recreating instantiation " << identifier.getUniqueName();
+        Configuration& instance_config = conf_manager_->addInstanceConfiguration(identifier, *source.config);
+        Module* module =
+            construct_module(source.generator, identifier, instance_config, messenger_, geo_manager_, detector);
+        module->set_identifier(identifier);
+        if(!(multithreading_flag_ && can_parallelize_)) {
+            module->set_multithreading(false);
+        }
+        iter->reset(module);
+
+        module_execution_time_[module] += execution_time;
+        if(!event_time.empty()) {
+            event_time.key() = module;
+            module_event_time_.insert(std::move(event_time));
+        }
+        prepare_module(module);
+    }
+
+    // Initialize the new instantiations in the order of the run list
+    for(auto& iter : recreate) {
+        module_execution_time_[iter->get()] += initialize_module(iter->get());
+    }
+
+    auto end_time = std::chrono::steady_clock::now();
+    auto setup_time = static_cast<std::chrono::duration<long double>>(end_time - start_time).count();
+    LOG(STATUS) << "Recreated " << recreate.size() << " of " << modules_.size() << " module instantiations for scan point "
+                << scan_point.name << " in " << seconds_to_time(setup_time);
+    total_time_ += setup_time;
+}
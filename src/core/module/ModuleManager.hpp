@@ -14,14 +14,21 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <random>
+#include <string>
+#include <vector>
 
 #include <TDirectory.h>
 #include <TFile.h>
 #include <TH1D.h>
 
+#include "LazyDirectory.hpp"
 #include "Module.hpp"
+#include "Profiler.hpp"
+#include "MemoryMonitor.hpp"
+#include "SlowEventMonitor.hpp"
 #include "ThreadPool.hpp"
 #include "core/config/Configuration.hpp"
 #include "core/utils/log.h"
@@ -34,6 +41,7 @@ namespace allpix {
     class ConfigManager;
     class Messenger;
     class GeometryManager;
+    class MetricsExporter;
 
     /**
      * @ingroup Managers
@@ -96,6 +104,16 @@ namespace allpix {
          */
         void run(RandomNumberGenerator& seeder);
 
+        /**
+         * @brief Run all modules for the next events, keeping the worker threads for further calls
+         * @param seeder Reference to the seeder, which continues with the seeds of the events processed by earlier calls
+         * @param number_of_events Number of events to process
+         * @return Number of events processed, smaller than requested if termination has been requested
+         * @warning Should be called after the \ref ModuleManager::initialize "init function" instead of the \ref
+         * ModuleManager::run "run function"
+         */
+        uint64_t runEvents(RandomNumberGenerator& seeder, uint64_t number_of_events);
+
         /**
          * @brief Finalize all modules after the event sequence
          * @warning Should be called after the \ref ModuleManager::initialize "run function"
@@ -108,10 +126,23 @@ namespace allpix {
          */
         void terminate();
 
+        /**
+         * @brief Get the number of points of the parameter scan
+         * @return Number of scan points, zero if no scan is configured
+         */
+        size_t getScanPoints() const { return scan_points_.size(); }
+
+        /**
+         * @brief Apply the options of a scan point and recreate the module instantiations affected by them
+         * @param point Index of the scan point, the first point is applied while loading the modules
+         * @warning Should be called after the \ref ModuleManager::run "run function" of the previous point
+         */
+        void startScanPoint(size_t point);
+
     private:
         /**
          * @brief Create unique modules
-         * @param library Void pointer to the loaded library
+         * @param generator Void pointer to the generator function of the module
          * @param config Configuration of the module
          * @param messenger Pointer to the messenger
          * @param geo_manager Pointer to the geometry manager
@@ -121,7 +152,7 @@ namespace allpix {
 
         /**
          * @brief Create detector modules
-         * @param library Void pointer to the loaded library
+         * @param generator Void pointer to the generator function of the module
          * @param config Configuration of the module
          * @param messenger Pointer to the messenger
          * @param geo_manager Pointer to the geometry manager
@@ -130,6 +161,95 @@ namespace allpix {
         std::vector<std::pair<ModuleIdentifier, Module*>>
         create_detector_modules(void*, Configuration&, Messenger*, GeometryManager*);
 
+        /**
+         * @brief Construct a single module instantiation
+         * @param generator Void pointer to the generator function of the module
+         * @param identifier Identifier of the instantiation
+         * @param instance_config Configuration of the instantiation
+         * @param messenger Pointer to the messenger
+         * @param geo_manager Pointer to the geometry manager
+         * @param detector Detector of the instantiation, nullptr for unique modules
+         * @return Created module
+         */
+        Module* construct_module(void* generator,
+                                 const ModuleIdentifier& identifier,
+                                 Configuration& instance_config,
+                                 Messenger* messenger,
+                                 GeometryManager* geo_manager,
+                                 const std::shared_ptr<Detector>& detector);
+
+        /**
+         * @brief Pass the framework resources to a module and create its ROOT directory before its initialization
+         * @param module Module to prepare
+         */
+        void prepare_module(Module* module);
+
+        /**
+         * @brief Initialize a module with its own logging settings and ROOT directory
+         * @param module Module to initialize
+         * @return Time the initialization took in seconds
+         */
+        static long double initialize_module(Module* module);
+
+        /**
+         * @brief Finalize a module with its own logging settings and ROOT directory
+         * @param module Module to finalize
+         */
+        void finalize_module(Module* module);
+
+        /**
+         * @brief Read the points of a parameter scan from file
+         * @param file_name Path of the scan file
+         */
+        void read_scan_points(const std::string& file_name);
+
+        /**
+         * @brief Check if a module instantiation has to be recreated for a scan point
+         * @param module Module instantiation
+         * @param point Index of the scan point
+         * @return True if the options of the point change its configuration or it writes output for every point
+         */
+        bool scan_requires_recreation(Module* module, size_t point) const;
+
+        /**
+         * @brief Replace the leading modules by a reader of their cached output, or add a writer storing it to the cache
+         * @param configs Configurations of all modules, modified in place
+         */
+        void apply_stage_cache(std::list<Configuration>& configs);
+
+        /**
+         * @brief Create the thread pool running the events and the performance histograms
+         * @param skip_events Number of events before the first event processed by the pool
+         */
+        void create_thread_pool(uint64_t skip_events);
+
+        /**
+         * @brief Get the thread pool processing a module, which differs between the stages of a pipeline
+         * @param module Module to process, the pool of the first stage is returned for a nullptr
+         * @return Pointer to the thread pool
+         */
+        ThreadPool* stage_thread_pool(const Module* module) const;
+
+        /**
+         * @brief Get the thread pools of all stages of the pipeline, a single one if the modules are not split into stages
+         * @return Pointers to the thread pools, ordered by stage
+         */
+        std::vector<ThreadPool*> thread_pools() const;
+
+        /**
+         * @brief Destroy the thread pools of all stages, finalizing their workers in the order of the stages
+         */
+        void destroy_thread_pools();
+
+        /**
+         * @brief Process a contiguous range of events with the thread pool, creating it if not available yet
+         * @param seeder Reference to the seeder, positioned at the seed of the first event
+         * @param skip_events Number of events before the first event of the range
+         * @param number_of_events Number of events to process
+         * @return Number of events finished
+         */
+        uint64_t run_events(RandomNumberGenerator& seeder, uint64_t skip_events, uint64_t number_of_events);
+
         /**
          * @brief Set module specific log setting before running init/run/finalize
          * @param mod_name Unique identifier of the module
@@ -142,12 +262,72 @@ namespace allpix {
                                                                                         const std::string& prefix = "",
                                                                                         const uint64_t event = 0);
 
+        /**
+         * @brief Set the log settings of a module resolved at initialization before running an event
+         * @param module Module to run
+         * @param event  Event number
+         */
+        static std::tuple<LogLevel, LogFormat, std::string, uint64_t> set_module_before(const Module* module,
+                                                                                        const uint64_t event);
+
+        /**
+         * @brief Parse the module specific log level and format from the configuration
+         * @param config Module configuration
+         * @return Log settings of the module
+         */
+        static Module::LogSettings resolve_log_settings(const Configuration& config);
+
+        /**
+         * @brief Switch to the given log settings and section
+         * @param settings Module specific log settings
+         * @param section  Section name to use
+         * @param event    Event number
+         * @return Set of previous settings to be restored by \ref set_module_after
+         */
+        static std::tuple<LogLevel, LogFormat, std::string, uint64_t>
+        apply_log_settings(const Module::LogSettings& settings, const std::string& section, const uint64_t event);
+
         /**
          * @brief Reset global log setting after running init/run/finalize
          * @param prev Set of previous settings generated by \ref set_module_before
          */
         static void set_module_after(std::tuple<LogLevel, LogFormat, std::string, uint64_t> prev);
 
+        /**
+         * @brief Run a group of detector module instances concurrently for an event
+         * @param event Event to run the modules for
+         * @param begin First module of the group
+         * @param end End of the group
+         * @param warn_config_access If warnings about configuration values parsed by the modules should be enabled
+         * @param plot If the processing time of the modules should be filled into the performance plots
+         * @param profiler Pointer to the profiler, nullptr if profiling is disabled
+         * @param metrics Pointer to the metrics exporter, nullptr if no metrics are exported
+         * @param slow_events Pointer to the monitor of slow events, nullptr if the module times are not recorded
+         * @return Summed processing time of the modules in seconds
+         */
+        long double run_concurrent_modules(Event* event,
+                                           ModuleList::iterator begin,
+                                           ModuleList::iterator end,
+                                           bool warn_config_access,
+                                           bool plot,
+                                           Profiler* profiler,
+                                           MetricsExporter* metrics,
+                                           SlowEventMonitor* slow_events);
+
+        /**
+         * @brief Write a checkpoint with the state of all modules after an event
+         * @param file_name Path of the checkpoint file
+         * @param last_event Number of the last event processed, all events up to it have to be finished
+         */
+        void store_checkpoint(const std::string& file_name, uint64_t last_event);
+
+        /**
+         * @brief Restore the state of all modules from a checkpoint
+         * @param file_name Path of the checkpoint file
+         * @return Number of the last event processed before the checkpoint has been written
+         */
+        uint64_t restore_checkpoint(const std::string& file_name);
+
         using IdentifierToModuleMap = std::map<ModuleIdentifier, ModuleList::iterator>;
 
         ModuleList modules_;
@@ -155,7 +335,19 @@ namespace allpix {
 
         ConfigManager* conf_manager_{};
 
+        /**
+         * @brief Get the directory of a scan point in the main ROOT file, creating the file on the first call
+         * @param scan_point Name of the scan point, or empty for the top directory of the file
+         * @return ROOT directory of the scan point
+         * @warning Creating directories is not thread-safe, the mutex of the main ROOT file has to be locked by the caller
+         */
+        TDirectory* get_root_directory(const std::string& scan_point);
+
+        // Main ROOT file, only created once a module writes to it, and the placeholders of the module directories
+        std::string modules_file_path_;
         std::unique_ptr<TFile> modules_file_;
+        std::mutex modules_file_mutex_;
+        std::vector<std::unique_ptr<LazyDirectory>> lazy_directories_;
 
         std::map<Module*, long double> module_execution_time_;
         std::map<Module*, Histogram<TH1D>> module_event_time_;
@@ -164,8 +356,57 @@ namespace allpix {
 
         long double total_time_{};
 
+        std::unique_ptr<Profiler> profiler_;
+        std::unique_ptr<SlowEventMonitor> slow_events_;
+        std::unique_ptr<MemoryMonitor> memory_monitor_;
+
         std::map<std::string, void*> loaded_libraries_;
 
+        // Section and generator every instantiation has been created from, to recreate it for another scan point
+        struct ModuleSource {
+            Configuration* config;
+            void* generator;
+        };
+        std::map<std::string, ModuleSource> module_sources_;
+        GeometryManager* geo_manager_{};
+
+        // Points of the parameter scan with their module options, and the ROOT directory of the current point
+        struct ScanOption {
+            std::string identifier;
+            std::string key;
+            std::string value;
+        };
+        struct ScanPoint {
+            std::string name;
+            std::vector<std::string> options;
+            std::vector<ScanOption> parsed_options;
+        };
+        std::vector<ScanPoint> scan_points_;
+        std::string scan_directory_;
+        std::string root_directory_name_;
+
+        // Number of runs of the event loop, one per scan point
+        size_t run_count_{};
+
+        // Final path of the cache file written during the run, empty if no output is stored in the cache
+        std::string stage_cache_file_;
+
+        // Pool of the worker threads, kept between calls processing events on demand, and the last event processed
+        std::unique_ptr<ThreadPool> thread_pool_;
+        bool events_on_demand_{false};
+
+        // Stages of the pipeline with their own workers, every stage after the first one owns a separate thread pool.
+        // Empty if the modules are not split into stages.
+        struct PipelineStage {
+            ModuleList::iterator begin;
+            ModuleList::iterator end;
+            std::unique_ptr<ThreadPool> thread_pool;
+        };
+        std::vector<PipelineStage> pipeline_stages_;
+        std::map<const Module*, size_t> pipeline_stage_index_;
+        std::vector<unsigned int> pipeline_workers_;
+        uint64_t last_event_{};
+
         std::atomic<bool> terminate_;
 
         Messenger* messenger_{};
@@ -0,0 +1,461 @@
+/**
+ * @file
+ * @brief Implementation of the module profiler
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <set>
+#include <sstream>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "Module.hpp"
+#include "ThreadPool.hpp"
+#include "core/utils/exceptions.h"
+#include "core/utils/log.h"
+
+using namespace allpix;
+
+namespace {
+    // Unique identifier of every profiler to detect stale thread local caches
+    std::atomic<uint64_t> profiler_count{0};
+
+    /**
+     * @brief Escape a string for use in JSON
+     */
+    std::string escape_json(const std::string& str) {
+        std::string escaped;
+        for(auto ch : str) {
+            if(ch == '"' || ch == '\\') {
+                escaped += '\\';
+            }
+            escaped += ch;
+        }
+        return escaped;
+    }
+
+    // Names of the hardware counters in the order of Profiler::HardwareEvent
+    const std::array<std::string, 4> hardware_event_names = {{"cycles", "instructions", "cache_misses", "branch_misses"}};
+} // namespace
+
+void Profiler::Distribution::fill(double value) {
+    auto bin = static_cast<long>(std::floor(std::log2(std::max(value, minimum_value) / minimum_value) * bins_per_octave));
+    bins_[static_cast<size_t>(std::clamp(bin, 0l, static_cast<long>(bins_.size()) - 1))]++;
+    maximum_ = std::max(maximum_, value);
+    entries_++;
+}
+
+void Profiler::Distribution::merge(const Distribution& other) {
+    for(size_t i = 0; i < bins_.size(); ++i) {
+        bins_[i] += other.bins_[i];
+    }
+    entries_ += other.entries_;
+    maximum_ = std::max(maximum_, other.maximum_);
+}
+
+double Profiler::Distribution::quantile(double fraction) const {
+    if(entries_ == 0) {
+        return 0;
+    }
+
+    auto target = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(entries_)));
+    uint64_t sum = 0;
+    for(size_t i = 0; i < bins_.size(); ++i) {
+        sum += bins_[i];
+        if(sum >= std::max(target, uint64_t(1))) {
+            auto center = minimum_value * std::exp2((static_cast<double>(i) + 0.5) / bins_per_octave);
+            return std::min(center, maximum_);
+        }
+    }
+    return maximum_;
+}
+
+void Profiler::ModuleRecord::merge(const ModuleRecord& other) {
+    executions += other.executions;
+    waits += other.waits;
+    wall_time += other.wall_time;
+    cpu_time += other.cpu_time;
+    wait_time += other.wait_time;
+    for(size_t i = 0; i < hardware.size(); ++i) {
+        hardware[i] += other.hardware[i];
+    }
+    executions_time.merge(other.executions_time);
+    for(const auto& counter : other.counters) {
+        counters[counter.first] += counter.second;
+    }
+}
+
+Profiler::Profiler(bool trace, bool hardware_counters)
+    : trace_(trace), hardware_counters_(hardware_counters), start_(Clock::now()), id_(++profiler_count) {}
+
+Profiler::~Profiler() {
+#ifdef __linux__
+    for(auto& thread : records_) {
+        for(auto fd : thread.counter_fds) {
+            if(fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+#endif
+}
+
+void Profiler::registerModule(const Module* module) {
+    module_indices_.emplace(module, modules_.size());
+    modules_.push_back(module);
+}
+
+void Profiler::start() {
+    start_ = Clock::now();
+}
+
+void Profiler::stop() {
+    stop_ = Clock::now();
+}
+
+double Profiler::threadTime() {
+    struct timespec time {};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return static_cast<double>(time.tv_sec) + 1e-9 * static_cast<double>(time.tv_nsec);
+}
+
+/**
+ * All counters are opened as a single group led by the cycle counter, such that they are scheduled onto the processor
+ * together and their values are read with a single system call. Only events in user space of the calling thread are
+ * counted. Counters besides the cycles which are not supported by the processor are skipped and remain zero.
+ */
+void Profiler::open_counters(ThreadRecord& record) {
+    record.counters_opened = true;
+#ifdef __linux__
+    const std::array<uint64_t, 4> configs = {{PERF_COUNT_HW_CPU_CYCLES,
+                                              PERF_COUNT_HW_INSTRUCTIONS,
+                                              PERF_COUNT_HW_CACHE_MISSES,
+                                              PERF_COUNT_HW_BRANCH_MISSES}};
+    for(size_t i = 0; i < configs.size(); ++i) {
+        struct perf_event_attr attr {};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = configs[i];
+        attr.disabled = (i == 0 ? 1 : 0);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID;
+        auto fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, record.counter_fds[0], 0));
+        if(fd < 0 && i == 0) {
+            LOG_ONCE(WARNING) << "Cannot open hardware performance counters, check /proc/sys/kernel/perf_event_paranoid";
+            return;
+        }
+        record.counter_fds[i] = fd;
+        if(fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_ID, &record.counter_ids[i]);
+        }
+    }
+    ioctl(record.counter_fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(record.counter_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#else
+    LOG_ONCE(WARNING) << "Hardware performance counters are only supported on Linux";
+#endif
+}
+
+/**
+ * The values of the group are returned each followed by its identifier. The identifiers are matched to the counters since
+ * unsupported counters are missing from the group.
+ */
+Profiler::HardwareCounts Profiler::readHardwareCounters() {
+    HardwareCounts counts{};
+    if(!hardware_counters_) {
+        return counts;
+    }
+
+    auto& local = local_record();
+    if(!local.counters_opened) {
+        open_counters(local);
+    }
+#ifdef __linux__
+    if(local.counter_fds[0] < 0) {
+        return counts;
+    }
+
+    // Number of counters followed by pairs of value and identifier
+    std::array<uint64_t, 1 + 2 * 4> buffer{};
+    if(read(local.counter_fds[0], buffer.data(), sizeof(buffer)) <= 0) {
+        return counts;
+    }
+    for(size_t i = 0; i < local.counter_fds.size(); ++i) {
+        for(size_t j = 0; local.counter_fds[i] >= 0 && j < std::min<uint64_t>(buffer[0], 4); ++j) {
+            if(buffer[2 + 2 * j] == local.counter_ids[i]) {
+                counts[i] = buffer[1 + 2 * j];
+            }
+        }
+    }
+#endif
+    return counts;
+}
+
+/**
+ * The records of every thread are cached in a thread local pointer, which is tagged with the identifier of the profiler to
+ * prevent a thread from reusing the records of an earlier profiler.
+ */
+Profiler::ThreadRecord& Profiler::local_record() {
+    static thread_local std::pair<uint64_t, ThreadRecord*> cache{0, nullptr};
+    if(cache.first != id_) {
+        std::lock_guard<std::mutex> lock{records_mutex_};
+        records_.push_back({ThreadPool::threadNum(), std::vector<ModuleRecord>(modules_.size()), {}, {}});
+        cache = {id_, &records_.back()};
+    }
+    return *cache.second;
+}
+
+size_t Profiler::module_index(const Module* module) const {
+    auto iter = module_indices_.find(module);
+    if(iter == module_indices_.end()) {
+        throw RuntimeError("Module " + module->getUniqueName() + " is not registered with the profiler");
+    }
+    return iter->second;
+}
+
+void Profiler::recordExecution(const Module* module,
+                               uint64_t event,
+                               Clock::time_point start,
+                               Clock::time_point end,
+                               double cpu_time,
+                               const HardwareCounts& hardware_counts) {
+    // Read the counters first to exclude the bookkeeping of the profiler
+    auto end_counts = readHardwareCounters();
+    auto index = module_index(module);
+    auto& local = local_record();
+
+    auto wall_time = std::chrono::duration<double>(end - start).count();
+    auto& record = local.modules[index];
+    record.executions++;
+    record.wall_time += wall_time;
+    record.cpu_time += cpu_time;
+    record.executions_time.fill(wall_time);
+    if(hardware_counters_) {
+        for(size_t i = 0; i < end_counts.size(); ++i) {
+            record.hardware[i] += end_counts[i] - hardware_counts[i];
+        }
+    }
+
+    if(trace_) {
+        local.trace.push_back({index,
+                               event,
+                               std::chrono::duration_cast<std::chrono::nanoseconds>(start - start_).count(),
+                               std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()});
+    }
+}
+
+void Profiler::recordWait(const Module* module, double wait_time) {
+    auto& record = local_record().modules[module_index(module)];
+    record.waits++;
+    record.wait_time += wait_time;
+}
+
+void Profiler::recordEvent(double latency) {
+    local_record().events.fill(latency);
+}
+
+void Profiler::count(const Module* module, const std::string& name, uint64_t value) {
+    local_record().modules[module_index(module)].counters[name] += value;
+}
+
+Profiler::ModuleRecord Profiler::merged_module(size_t index) const {
+    ModuleRecord merged;
+    for(const auto& thread : records_) {
+        merged.merge(thread.modules[index]);
+    }
+    return merged;
+}
+
+/**
+ * The breakdown lists the modules in order of execution with their share of the total module wall time, the time spent
+ * waiting for them and the percentiles of their execution time. The usage per thread and the counters are listed below
+ * every module.
+ */
+void Profiler::summarize() const {
+    std::lock_guard<std::mutex> lock{records_mutex_};
+
+    std::vector<ModuleRecord> merged;
+    double total_time = 0;
+    for(size_t i = 0; i < modules_.size(); ++i) {
+        merged.push_back(merged_module(i));
+        total_time += merged.back().wall_time;
+    }
+
+    Distribution events;
+    for(const auto& thread : records_) {
+        events.merge(thread.events);
+    }
+
+    std::stringstream summary;
+    summary << std::setprecision(3) << "Profile of " << events.entries() << " events on " << records_.size()
+            << " threads:";
+    for(size_t i = 0; i < modules_.size(); ++i) {
+        const auto& record = merged[i];
+        summary << std::endl
+                << " Module " << modules_[i]->getUniqueName() << ": " << record.wall_time << "s wall time ("
+                << std::round(100 * record.wall_time / std::max(total_time, 1e-9)) << "%), " << record.cpu_time
+                << "s CPU time, " << record.wait_time << "s waiting in " << record.waits << " suspensions, p50/p90/p99 "
+                << record.executions_time.quantile(0.5) << "/" << record.executions_time.quantile(0.9) << "/"
+                << record.executions_time.quantile(0.99) << "s";
+        for(const auto& thread : records_) {
+            const auto& local = thread.modules[i];
+            if(local.executions == 0) {
+                continue;
+            }
+            summary << std::endl
+                    << "  Thread " << thread.thread << ": " << local.executions << " executions, " << local.wall_time
+                    << "s wall time, " << local.cpu_time << "s CPU time";
+        }
+        if(hardware_counters_) {
+            const auto& hardware = record.hardware;
+            auto value = [&](HardwareEvent hardware_event) { return hardware[static_cast<size_t>(hardware_event)]; };
+            auto instructions = static_cast<double>(value(HardwareEvent::INSTRUCTIONS));
+            summary << std::endl
+                    << "  Hardware counters: " << value(HardwareEvent::CYCLES) << " cycles, "
+                    << value(HardwareEvent::INSTRUCTIONS) << " instructions ("
+                    << instructions / std::max(static_cast<double>(value(HardwareEvent::CYCLES)), 1.) << " per cycle), "
+                    << value(HardwareEvent::CACHE_MISSES) << " cache misses ("
+                    << 1e3 * static_cast<double>(value(HardwareEvent::CACHE_MISSES)) / std::max(instructions, 1.)
+                    << " per 1000 instructions), " << value(HardwareEvent::BRANCH_MISSES) << " branch misses ("
+                    << 1e3 * static_cast<double>(value(HardwareEvent::BRANCH_MISSES)) / std::max(instructions, 1.)
+                    << " per 1000 instructions)";
+        }
+        for(const auto& counter : record.counters) {
+            summary << std::endl << "  Counter " << counter.first << ": " << counter.second;
+        }
+    }
+    summary << std::endl
+            << " Event latency p50/p90/p99/max " << events.quantile(0.5) << "/" << events.quantile(0.9) << "/"
+            << events.quantile(0.99) << "/" << events.maximum() << "s";
+    LOG(INFO) << summary.str();
+}
+
+void Profiler::write(const std::string& path, Format format) const {
+    if(format == Format::TRACE && !trace_) {
+        throw RuntimeError("Cannot write trace of module executions which have not been recorded");
+    }
+
+    std::ofstream file(path);
+    if(!file.good()) {
+        throw RuntimeError("Cannot write profile to file " + path);
+    }
+
+    std::lock_guard<std::mutex> lock{records_mutex_};
+    if(format == Format::TRACE) {
+        write_trace(file);
+    } else {
+        write_csv(file);
+    }
+    LOG(STATUS) << "Wrote profile of the event loop to file " << path;
+}
+
+/**
+ * Every row of the table lists a single quantity of the profile, identified by the module, the thread number and the name of
+ * the quantity. Quantities summed over all threads are listed with the thread "all". The event latencies are listed under
+ * the module name "event". Hardware counters are listed with the prefix "hardware:" if they are recorded.
+ */
+void Profiler::write_csv(std::ostream& out) const {
+    out << "module,thread,quantity,value" << std::endl;
+    out << std::setprecision(9);
+
+    auto write_record = [this, &out](const std::string& name, const std::string& thread, const ModuleRecord& record) {
+        out << name << "," << thread << ",executions," << record.executions << std::endl;
+        out << name << "," << thread << ",wall_time," << record.wall_time << std::endl;
+        out << name << "," << thread << ",cpu_time," << record.cpu_time << std::endl;
+        out << name << "," << thread << ",waits," << record.waits << std::endl;
+        out << name << "," << thread << ",wait_time," << record.wait_time << std::endl;
+        for(size_t i = 0; hardware_counters_ && i < record.hardware.size(); ++i) {
+            out << name << "," << thread << ",hardware:" << hardware_event_names[i] << "," << record.hardware[i]
+                << std::endl;
+        }
+        for(const auto& counter : record.counters) {
+            out << name << "," << thread << ",counter:" << counter.first << "," << counter.second << std::endl;
+        }
+    };
+    auto write_distribution = [&out](const std::string& name, const std::string& quantity, const Distribution& dist) {
+        out << name << ",all," << quantity << "_p50," << dist.quantile(0.5) << std::endl;
+        out << name << ",all," << quantity << "_p90," << dist.quantile(0.9) << std::endl;
+        out << name << ",all," << quantity << "_p99," << dist.quantile(0.99) << std::endl;
+        out << name << ",all," << quantity << "_max," << dist.maximum() << std::endl;
+    };
+
+    for(size_t i = 0; i < modules_.size(); ++i) {
+        auto name = modules_[i]->getUniqueName();
+        auto merged = merged_module(i);
+        write_record(name, "all", merged);
+        write_distribution(name, "execution_time", merged.executions_time);
+        for(const auto& thread : records_) {
+            if(thread.modules[i].executions > 0) {
+                write_record(name, std::to_string(thread.thread), thread.modules[i]);
+            }
+        }
+    }
+
+    Distribution events;
+    for(const auto& thread : records_) {
+        events.merge(thread.events);
+    }
+    out << "event,all,events," << events.entries() << std::endl;
+    out << "event,all,loop_time," << std::chrono::duration<double>(stop_ - start_).count() << std::endl;
+    write_distribution("event", "latency", events);
+}
+
+/**
+ * The trace follows the Chrome trace event format, which can be displayed with chrome://tracing or Perfetto. Every module
+ * execution is written as complete event on the thread it was executed on, the counters are attached as metadata.
+ */
+void Profiler::write_trace(std::ostream& out) const {
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    out << std::fixed << std::setprecision(3);
+
+    bool first = true;
+    std::set<unsigned int> threads;
+    for(const auto& thread : records_) {
+        for(const auto& record : thread.trace) {
+            out << (first ? "" : ",") << std::endl
+                << "{\"name\":\"" << escape_json(modules_[record.module]->getUniqueName())
+                << "\",\"cat\":\"module\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread.thread
+                << ",\"ts\":" << static_cast<double>(record.start) / 1e3
+                << ",\"dur\":" << static_cast<double>(record.duration) / 1e3 << ",\"args\":{\"event\":" << record.event
+                << "}}";
+            first = false;
+        }
+        threads.insert(thread.thread);
+    }
+    for(auto thread : threads) {
+        out << (first ? "" : ",") << std::endl
+            << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread << ",\"args\":{\"name\":\""
+            << (thread == 0 ? "main" : "worker " + std::to_string(thread)) << "\"}}";
+        first = false;
+    }
+    out << std::endl << "],\"otherData\":{";
+
+    first = true;
+    for(size_t i = 0; i < modules_.size(); ++i) {
+        for(const auto& counter : merged_module(i).counters) {
+            out << (first ? "" : ",") << std::endl
+                << "\"" << escape_json(modules_[i]->getUniqueName() + ":" + counter.first) << "\":\"" << counter.second
+                << "\"";
+            first = false;
+        }
+    }
+    out << std::endl << "}}" << std::endl;
+}
@@ -0,0 +1,282 @@
+/**
+ * @file
+ * @brief Low-overhead profiler for the module execution during the event loop
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_MODULE_PROFILER_H
+#define ALLPIX_MODULE_PROFILER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace allpix {
+    class Module;
+
+    /**
+     * @brief Profiler collecting the resource usage of all module instantiations during the event loop
+     *
+     * All measurements are accumulated in storage private to the calling thread, such that recording requires no locking
+     * apart from the first access of every thread. For every module instantiation the wall and CPU time of its executions,
+     * the time events spent waiting in the buffer because of it and the counters incremented by the module itself are
+     * recorded. Execution times and event latencies are additionally binned logarithmically to provide percentiles. The
+     * collected data is merged when writing the summary to the log or exporting it to a file.
+     *
+     * Optionally, the hardware performance counters of the processor are read around every module execution using the
+     * perf_event interface of the Linux kernel. The counters are opened per thread and are only available if the kernel
+     * permits access, which is controlled by /proc/sys/kernel/perf_event_paranoid.
+     */
+    class Profiler {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        /**
+         * @brief Export formats of the collected profile
+         */
+        enum class Format {
+            CSV = 0, ///< Summary table with one quantity per row
+            TRACE,   ///< Chrome trace event JSON with every module execution as separate event
+        };
+
+        /**
+         * @brief Hardware events counted by the performance counters of the processor
+         */
+        enum class HardwareEvent {
+            CYCLES = 0,    ///< CPU cycles
+            INSTRUCTIONS,  ///< Retired instructions
+            CACHE_MISSES,  ///< Last level cache misses
+            BRANCH_MISSES, ///< Mispredicted branches
+        };
+        using HardwareCounts = std::array<uint64_t, 4>;
+
+        /**
+         * @brief Construct the profiler
+         * @param trace If every individual module execution should be kept for the trace export
+         * @param hardware_counters If the hardware performance counters should be recorded
+         */
+        explicit Profiler(bool trace, bool hardware_counters = false);
+
+        /**
+         * @brief Close the hardware performance counters of all threads
+         */
+        ~Profiler();
+
+        /// @{
+        /**
+         * @brief Copying or moving the profiler is not allowed
+         */
+        Profiler(const Profiler&) = delete;
+        Profiler& operator=(const Profiler&) = delete;
+        Profiler(Profiler&&) = delete;
+        Profiler& operator=(Profiler&&) = delete;
+        /// @}
+
+        /**
+         * @brief Register a module instantiation to profile
+         * @param module Pointer to the module
+         * @warning All modules should be registered before the event loop starts
+         */
+        void registerModule(const Module* module);
+
+        /**
+         * @brief Mark the start of the event loop used as reference for the trace time stamps
+         */
+        void start();
+
+        /**
+         * @brief Mark the end of the event loop, used to report the time spent in the event loop
+         */
+        void stop();
+
+        /**
+         * @brief Obtain the CPU time consumed by the calling thread
+         * @return CPU time in seconds
+         */
+        static double threadTime();
+
+        /**
+         * @brief Read the hardware performance counters of the calling thread
+         * @return Current values of the counters, or zero if the hardware counters are disabled or unavailable
+         *
+         * The counters are opened on the first call of every thread. If they cannot be opened, a warning is issued once
+         * and the counters of the thread are not recorded.
+         */
+        HardwareCounts readHardwareCounters();
+
+        /**
+         * @brief Record a single execution of a module
+         * @param module Pointer to the executed module
+         * @param event Number of the event processed
+         * @param start Time point the execution started
+         * @param end Time point the execution ended
+         * @param cpu_time CPU time spent by the calling thread during the execution, in seconds
+         * @param hardware_counts Hardware counters at the start of the execution from \ref readHardwareCounters
+         */
+        void recordExecution(const Module* module,
+                             uint64_t event,
+                             Clock::time_point start,
+                             Clock::time_point end,
+                             double cpu_time,
+                             const HardwareCounts& hardware_counts = {});
+
+        /**
+         * @brief Record the time an event spent in the buffer before it could continue with a module
+         * @param module Pointer to the module the event was waiting for
+         * @param wait_time Time waited in seconds
+         */
+        void recordWait(const Module* module, double wait_time);
+
+        /**
+         * @brief Record the latency of an event between its creation and its completion
+         * @param latency Latency in seconds
+         */
+        void recordEvent(double latency);
+
+        /**
+         * @brief Increment a named counter of a module
+         * @param module Pointer to the module owning the counter
+         * @param name Name of the counter
+         * @param value Value to add to the counter
+         */
+        void count(const Module* module, const std::string& name, uint64_t value);
+
+        /**
+         * @brief Write the hierarchical breakdown of the profile to the log
+         */
+        void summarize() const;
+
+        /**
+         * @brief Export the profile to a file
+         * @param path Path of the file to write
+         * @param format Format to export the profile in
+         * @throws RuntimeError If the file cannot be written or the trace was requested without recording it
+         */
+        void write(const std::string& path, Format format) const;
+
+    private:
+        /**
+         * @brief Histogram with logarithmic bins from one hundred nanoseconds up to several minutes
+         */
+        class Distribution {
+        public:
+            /**
+             * @brief Add a value to the distribution
+             * @param value Value in seconds
+             */
+            void fill(double value);
+
+            /**
+             * @brief Add all entries of another distribution
+             * @param other Distribution to merge
+             */
+            void merge(const Distribution& other);
+
+            /**
+             * @brief Estimate a quantile of the distribution from the center of the bin containing it
+             * @param fraction Fraction of entries below the quantile, between zero and one
+             * @return Estimated quantile in seconds or zero if the distribution is empty
+             */
+            double quantile(double fraction) const;
+
+            uint64_t entries() const { return entries_; }
+            double maximum() const { return maximum_; }
+
+        private:
+            // Eight bins per factor of two give a resolution of about five percent
+            static constexpr double minimum_value = 1e-7;
+            static constexpr double bins_per_octave = 8;
+            std::array<uint64_t, 256> bins_{};
+            uint64_t entries_{};
+            double maximum_{};
+        };
+
+        /**
+         * @brief Resource usage of a single module on a single thread
+         */
+        struct ModuleRecord {
+            uint64_t executions{};
+            uint64_t waits{};
+            double wall_time{};
+            double cpu_time{};
+            double wait_time{};
+            HardwareCounts hardware{};
+            Distribution executions_time;
+            std::map<std::string, uint64_t> counters;
+
+            void merge(const ModuleRecord& other);
+        };
+
+        /**
+         * @brief Single module execution kept for the trace export
+         */
+        struct TraceRecord {
+            size_t module;
+            uint64_t event;
+            int64_t start;
+            int64_t duration;
+        };
+
+        /**
+         * @brief All the measurements of a single thread
+         */
+        struct ThreadRecord {
+            unsigned int thread;
+            std::vector<ModuleRecord> modules;
+            Distribution events;
+            std::vector<TraceRecord> trace;
+            // File descriptors of the hardware counters, the first one leads the group and is negative if unavailable
+            std::array<int, 4> counter_fds{{-1, -1, -1, -1}};
+            std::array<uint64_t, 4> counter_ids{};
+            bool counters_opened{};
+        };
+
+        /**
+         * @brief Open the hardware performance counters of the calling thread
+         */
+        static void open_counters(ThreadRecord& record);
+
+        /**
+         * @brief Return the records of the calling thread, creating them on the first access
+         */
+        ThreadRecord& local_record();
+
+        /**
+         * @brief Return the index of a registered module
+         */
+        size_t module_index(const Module* module) const;
+
+        /**
+         * @brief Merge the records of a module over all threads
+         */
+        ModuleRecord merged_module(size_t index) const;
+
+        void write_csv(std::ostream& out) const;
+        void write_trace(std::ostream& out) const;
+
+        bool trace_;
+        bool hardware_counters_;
+        Clock::time_point start_;
+        Clock::time_point stop_;
+
+        std::vector<const Module*> modules_;
+        std::map<const Module*, size_t> module_indices_;
+
+        // List to keep the references handed out to the threads valid
+        mutable std::mutex records_mutex_;
+        std::list<ThreadRecord> records_;
+        uint64_t id_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_MODULE_PROFILER_H */
@@ -0,0 +1,124 @@
+/**
+ * @file
+ * @brief Implementation of the monitor of slow events
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "SlowEventMonitor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include "Module.hpp"
+#include "core/utils/exceptions.h"
+#include "core/utils/log.h"
+
+using namespace allpix;
+
+SlowEventMonitor::SlowEventMonitor(double percentile, double factor, uint64_t minimum_events)
+    : percentile_(percentile), factor_(factor), minimum_events_(std::max<uint64_t>(minimum_events, 1)) {}
+
+void SlowEventMonitor::setCostFile(const std::string& path, const std::vector<std::string>& modules) {
+    cost_file_.open(path);
+    if(!cost_file_.good()) {
+        throw RuntimeError("Cannot open event cost file " + path);
+    }
+    cost_file_ << "event,seed,time";
+    for(const auto& name : modules) {
+        cost_columns_.emplace(name, cost_columns_.size());
+        cost_file_ << "," << name;
+    }
+    cost_file_ << std::endl;
+    LOG(STATUS) << "Writing the processing time of every event to file " << path;
+}
+
+void SlowEventMonitor::setReplayFile(const std::string& path, std::string options) {
+    replay_file_.open(path);
+    if(!replay_file_.good()) {
+        throw RuntimeError("Cannot open slow event replay file " + path);
+    }
+    replay_options_ = std::move(options);
+}
+
+void SlowEventMonitor::recordEvent(uint64_t event,
+                                   uint64_t seed,
+                                   long double time,
+                                   const std::vector<std::pair<const Module*, long double>>& module_times) {
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    // Compare to the earlier events only, before adding this event to the distribution
+    if(percentile_ > 0 && recorded_events_ >= minimum_events_) {
+        auto threshold = percentile_time();
+        if(time > factor_ * threshold) {
+            ++slow_events_;
+
+            auto sorted_times = module_times;
+            std::stable_sort(sorted_times.begin(), sorted_times.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.second > rhs.second;
+            });
+            std::stringstream breakdown;
+            breakdown << "Event " << event << " with seed " << seed << " took " << static_cast<double>(time)
+                      << "s, " << std::round(static_cast<double>(time / threshold)) << " times the " << percentile_
+                      << "th percentile of " << static_cast<double>(threshold) << "s:";
+            for(const auto& [module, module_time] : sorted_times) {
+                breakdown << std::endl << module->getUniqueName() << ": " << static_cast<double>(module_time) << "s";
+            }
+            LOG(WARNING) << breakdown.str();
+
+            if(replay_file_.is_open()) {
+                replay_file_ << "# event " << event << " with seed " << seed << std::endl
+                             << replay_options_ << " -o skip_events=" << (event - 1) << " -o number_of_events=1"
+                             << std::endl;
+            }
+        }
+    }
+    ++histogram_[bin_of(time)];
+    ++recorded_events_;
+
+    if(cost_file_.is_open()) {
+        std::vector<long double> columns(cost_columns_.size());
+        for(const auto& [module, module_time] : module_times) {
+            auto column = cost_columns_.find(module->getUniqueName());
+            if(column != cost_columns_.end()) {
+                columns[column->second] += module_time;
+            }
+        }
+        cost_file_ << event << "," << seed << "," << static_cast<double>(time);
+        for(auto column_time : columns) {
+            cost_file_ << "," << static_cast<double>(column_time);
+        }
+        cost_file_ << '\n';
+    }
+}
+
+uint64_t SlowEventMonitor::getSlowEvents() const {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return slow_events_;
+}
+
+size_t SlowEventMonitor::bin_of(long double time) {
+    if(time <= 1e-6) {
+        return 0;
+    }
+    auto bin = std::floor(std::log2(time / 1e-6) * bins_per_octave);
+    return std::min(static_cast<size_t>(bin), bin_count - 1);
+}
+
+long double SlowEventMonitor::percentile_time() const {
+    auto target = std::max<uint64_t>(
+        static_cast<uint64_t>(std::ceil(percentile_ / 100. * static_cast<double>(recorded_events_))), 1);
+    uint64_t cumulative = 0;
+    size_t bin = 0;
+    for(; bin < bin_count - 1; ++bin) {
+        cumulative += histogram_[bin];
+        if(cumulative >= target) {
+            break;
+        }
+    }
+    return 1e-6 * std::exp2(static_cast<long double>(bin + 1) / bins_per_octave);
+}
@@ -0,0 +1,113 @@
+/**
+ * @file
+ * @brief Detection of events with an exceptionally long processing time and log of the cost of every event
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_MODULE_SLOW_EVENT_MONITOR_H
+#define ALLPIX_MODULE_SLOW_EVENT_MONITOR_H
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace allpix {
+    class Module;
+
+    /**
+     * @brief Monitor comparing the processing time of every finished event to the distribution of the earlier events
+     *
+     * The processing times are collected in a histogram with logarithmic bins, from which the percentile is estimated
+     * without storing the individual times. An event is reported as slow if its processing time exceeds the configured
+     * percentile of all earlier events by the given factor. The report contains the seed of the event and the time spent
+     * in every module. Since the seed of every event only depends on the random seed of the run and the event number, the
+     * replay file lists the options to process the slow events again individually. Optionally, the processing time of
+     * every module is written for all events to a CSV file.
+     */
+    class SlowEventMonitor {
+    public:
+        /**
+         * @brief Construct the monitor
+         * @param percentile Percentile of the earlier processing times to compare to, zero to only log the cost of events
+         * @param factor Factor by which the processing time has to exceed the percentile
+         * @param minimum_events Number of events to collect before events are compared to the percentile
+         */
+        SlowEventMonitor(double percentile, double factor, uint64_t minimum_events);
+
+        /**
+         * @brief Write the processing time of every module to a CSV file for all events
+         * @param path Path of the file
+         * @param modules Unique names of all module instantiations, one column is written for each of them
+         */
+        void setCostFile(const std::string& path, const std::vector<std::string>& modules);
+
+        /**
+         * @brief Write the options to process every slow event again to a file
+         * @param path Path of the file
+         * @param options Options of the run which are required for every replay, such as the random seeds
+         */
+        void setReplayFile(const std::string& path, std::string options);
+
+        /**
+         * @brief Record a finished event and report it if it is slow
+         * @param event Event number
+         * @param seed Seed of the event
+         * @param time Total processing time of the event in seconds
+         * @param module_times Processing time of every module executed for the event in seconds
+         * @note This method can be called concurrently from all workers
+         */
+        void recordEvent(uint64_t event,
+                         uint64_t seed,
+                         long double time,
+                         const std::vector<std::pair<const Module*, long double>>& module_times);
+
+        /**
+         * @brief Get the number of events reported as slow
+         * @return Number of slow events
+         */
+        uint64_t getSlowEvents() const;
+
+    private:
+        /**
+         * @brief Get the histogram bin of a processing time
+         * @param time Processing time in seconds
+         * @return Index of the bin
+         */
+        static size_t bin_of(long double time);
+
+        /**
+         * @brief Estimate the configured percentile of the processing times recorded so far
+         * @return Upper edge of the bin containing the percentile in seconds
+         */
+        long double percentile_time() const;
+
+        double percentile_;
+        double factor_;
+        uint64_t minimum_events_;
+
+        // Logarithmic bins of the processing times from one microsecond to more than a day, eight bins per factor two
+        static constexpr size_t bins_per_octave = 8;
+        static constexpr size_t bin_count = bins_per_octave * 37;
+        std::array<uint64_t, bin_count> histogram_{};
+        uint64_t recorded_events_{};
+        uint64_t slow_events_{};
+
+        std::ofstream cost_file_;
+        std::map<std::string, size_t> cost_columns_;
+        std::ofstream replay_file_;
+        std::string replay_options_;
+
+        mutable std::mutex mutex_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_MODULE_SLOW_EVENT_MONITOR_H */
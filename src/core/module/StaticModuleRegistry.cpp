@@ -0,0 +1,26 @@
+/**
+ * @file
+ * @brief Implementation of the registry of the modules linked statically into the executable
+ * @copyright Copyright (c) 2017-2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "StaticModuleRegistry.hpp"
+
+using namespace allpix;
+
+/**
+ * The registry is a function-local static, such that it is constructed before the first module registers itself during
+ * the static initialization of the executable.
+ */
+std::map<std::string, StaticModule>& allpix::static_modules() {
+    static std::map<std::string, StaticModule> modules;
+    return modules;
+}
+
+bool allpix::register_static_module(const std::string& name, bool unique, void* generator) {
+    static_modules()[name] = StaticModule{unique, generator};
+    return true;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file
+ * @brief Registry of the modules linked statically into the executable
+ * @copyright Copyright (c) 2017-2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_STATIC_MODULE_REGISTRY_H
+#define ALLPIX_STATIC_MODULE_REGISTRY_H
+
+#include <map>
+#include <string>
+
+namespace allpix {
+    /**
+     * @brief Interface of a module linked statically into the executable
+     *
+     * Provides the same interface as the functions looked up in the module libraries loaded at runtime, see
+     * dynamic_module_impl.cpp.
+     */
+    struct StaticModule {
+        bool unique{};             ///< True if the module is unique, false if it is instantiated per detector
+        void* generator{nullptr}; ///< Pointer to the generator function creating instances of the module
+    };
+
+    /**
+     * @brief Get all modules linked statically into the executable
+     * @return Map of the registered modules, indexed by the name of their configuration section
+     */
+    std::map<std::string, StaticModule>& static_modules();
+
+    /**
+     * @brief Register a module linked statically into the executable
+     * @param name Name of the configuration section of the module
+     * @param unique True if the module is unique, false if it is instantiated per detector
+     * @param generator Pointer to the generator function creating instances of the module
+     * @return Always true, to allow the registration during static initialization
+     */
+    bool register_static_module(const std::string& name, bool unique, void* generator);
+} // namespace allpix
+
+#endif /* ALLPIX_STATIC_MODULE_REGISTRY_H */
@@ -11,14 +11,20 @@
 #include "ThreadPool.hpp"
 
 #include <cassert>
+#include <condition_variable>
+#include <memory>
 
-#include "Module.hpp"
+#include "core/utils/exceptions.h"
+#include "core/utils/log.h"
+#include "core/utils/profiling.h"
 
 using namespace allpix;
 
-std::map<std::thread::id, unsigned int> ThreadPool::thread_nums_;
 std::atomic_uint ThreadPool::thread_cnt_{1u};
 std::atomic_uint ThreadPool::thread_total_{1u};
+thread_local ThreadPool* ThreadPool::current_pool_{nullptr};
+thread_local size_t ThreadPool::current_lane_{SIZE_MAX};
+thread_local unsigned int ThreadPool::thread_num_{0};
 
 /**
  * The threads are created in an exception-safe way and all of them will be destroyed when creation of one fails
@@ -36,13 +42,14 @@ ThreadPool::ThreadPool(unsigned int num_threads,
                        unsigned int max_buffered_size,
                        const std::function<void()>& worker_init_function,
                        const std::function<void()>& worker_finalize_function)
-    : queue_(max_queue_size, max_buffered_size) {
+    : queue_(num_threads, max_queue_size, max_buffered_size) {
     assert(max_buffered_size == 0 || max_buffered_size >= num_threads);
     // Create threads
     try {
         for(unsigned int i = 0u; i < num_threads; ++i) {
             threads_.emplace_back(&ThreadPool::worker,
                                   this,
+                                  i,
                                   std::min(num_threads, max_buffered_size),
                                   worker_init_function,
                                   worker_finalize_function);
@@ -60,6 +67,32 @@ ThreadPool::~ThreadPool() {
     destroy();
 }
 
+ThreadPool::Task::Task(Task&& other) noexcept : operations_(other.operations_) {
+    if(operations_ != nullptr) {
+        operations_->move(other.storage(), storage());
+        other.operations_ = nullptr;
+    }
+}
+
+ThreadPool::Task& ThreadPool::Task::operator=(Task&& other) noexcept {
+    if(this != &other) {
+        reset();
+        if(other.operations_ != nullptr) {
+            other.operations_->move(other.storage(), storage());
+            operations_ = other.operations_;
+            other.operations_ = nullptr;
+        }
+    }
+    return *this;
+}
+
+void ThreadPool::Task::reset() noexcept {
+    if(operations_ != nullptr) {
+        operations_->destroy(storage());
+        operations_ = nullptr;
+    }
+}
+
 void ThreadPool::markComplete(uint64_t n) {
     queue_.complete(n);
 }
@@ -75,6 +108,22 @@ size_t ThreadPool::bufferedQueueSize() const {
     return queue_.prioritySize();
 }
 
+void ThreadPool::setMaxBufferedMemory(size_t max_memory) {
+    queue_.setMaxPriorityMemory(max_memory);
+}
+void ThreadPool::addBufferedMemory(size_t memory) {
+    queue_.addPriorityMemory(memory);
+}
+void ThreadPool::removeBufferedMemory(size_t memory) {
+    queue_.removePriorityMemory(memory);
+}
+size_t ThreadPool::bufferedMemory() const {
+    return queue_.priorityMemory();
+}
+size_t ThreadPool::peakBufferedMemory() const {
+    return queue_.peakPriorityMemory();
+}
+
 void ThreadPool::checkException() {
     // If exception has been thrown, destroy pool and propagate it
     if(exception_ptr_) {
@@ -85,6 +134,7 @@ void ThreadPool::checkException() {
 }
 
 void ThreadPool::wait() {
+    ALLPIX_PROFILE_ZONE("ThreadPool::wait");
     std::unique_lock<std::mutex> lock{run_mutex_};
     run_condition_.wait(lock, [this]() { return exception_ptr_ != nullptr || (queue_.empty() && run_cnt_ == 0); });
 }
@@ -92,14 +142,16 @@ void ThreadPool::wait() {
 /**
  * If an exception is thrown by a module, the first exception is saved to propagate in the main thread
  */
-void ThreadPool::worker(size_t min_thread_buffer,
+void ThreadPool::worker(size_t lane,
+                        size_t min_thread_buffer,
                         const std::function<void()>& initialize_function,
                         const std::function<void()>& finalize_function) {
     try {
         // Register the thread
-        unsigned int thread_num = thread_cnt_++;
-        assert(thread_num < thread_total_);
-        thread_nums_[std::this_thread::get_id()] = thread_num;
+        thread_num_ = thread_cnt_++;
+        assert(thread_num_ < thread_total_);
+        current_pool_ = this;
+        current_lane_ = lane;
 
         // Initialize the worker
         if(initialize_function) {
@@ -110,13 +162,11 @@ void ThreadPool::worker(size_t min_thread_buffer,
         auto increase_run_cnt_func = [this]() noexcept { ++run_cnt_; };
 
         while(!done_) {
-            Task task{nullptr};
+            Task task;
 
-            if(queue_.pop(task, increase_run_cnt_func, min_thread_buffer)) {
-                // Execute task
-                (*task)();
-                // Fetch the future to propagate exceptions
-                task->get_future().get();
+            if(queue_.pop(task, lane, increase_run_cnt_func, min_thread_buffer)) {
+                // Execute task, exceptions are propagated through the exception of the pool
+                task();
                 // Update the run count and propagate update
                 --run_cnt_;
                 run_condition_.notify_all();
@@ -140,6 +190,128 @@ void ThreadPool::worker(size_t min_thread_buffer,
     }
 }
 
+bool ThreadPool::push_task(uint64_t n, Task task) {
+    if(n == UINT64_MAX) {
+        return queue_.push(std::move(task), true, submission_lane());
+    }
+    return queue_.push(n, std::move(task), false);
+}
+
+size_t ThreadPool::submission_lane() const {
+    // Jobs submitted by a worker of this pool are kept local to that worker
+    return (current_pool_ == this ? current_lane_ : SIZE_MAX);
+}
+
+void ThreadPool::runSubtasks(const std::vector<std::function<void()>>& tasks) {
+    // Execute directly if not running in a worker of a pool or if there is nothing to distribute
+    if(current_pool_ == nullptr || tasks.size() < 2) {
+        for(const auto& task : tasks) {
+            task();
+        }
+        return;
+    }
+    current_pool_->run_subtasks(tasks);
+}
+
+namespace {
+    /**
+     * @brief Shared state of a set of subtasks, living on the stack of the thread waiting for them
+     */
+    struct SubtaskGroup {
+        std::mutex mutex;
+        std::condition_variable condition;
+        size_t remaining{};
+        bool all_executed{true};
+        std::atomic_flag has_exception{false};
+        std::exception_ptr exception_ptr{nullptr};
+    };
+
+    /**
+     * @brief Marks a subtask as finished on destruction, also when dropped without being executed by an invalidated queue
+     */
+    class SubtaskCompletion {
+    public:
+        explicit SubtaskCompletion(SubtaskGroup* group) : group_(group) {}
+        SubtaskCompletion(const SubtaskCompletion&) = delete;
+        SubtaskCompletion& operator=(const SubtaskCompletion&) = delete;
+        SubtaskCompletion(SubtaskCompletion&&) = delete;
+        SubtaskCompletion& operator=(SubtaskCompletion&&) = delete;
+        ~SubtaskCompletion() {
+            // The group cannot be released anymore by the waiting thread until the mutex is unlocked
+            std::lock_guard<std::mutex> lock{group_->mutex};
+            if(!executed_) {
+                group_->all_executed = false;
+            }
+            if(--group_->remaining == 0) {
+                group_->condition.notify_all();
+            }
+        }
+
+        void executed() { executed_ = true; }
+
+    private:
+        SubtaskGroup* group_;
+        bool executed_{false};
+    };
+} // namespace
+
+/**
+ * Subtasks never throw into the worker executing them, exceptions are stored in the group and rethrown by the waiting thread
+ * instead. The waiting thread only executes subtasks itself, to guarantee it returns as soon as its own subtasks are done.
+ */
+void ThreadPool::run_subtasks(const std::vector<std::function<void()>>& tasks) {
+    SubtaskGroup group;
+    group.remaining = tasks.size();
+
+    // Keep the log section and event number of the job for the subtasks
+    auto section = Log::getSection();
+    auto event_num = Log::getEventNum();
+    for(const auto& task : tasks) {
+        auto completion = std::make_unique<SubtaskCompletion>(&group);
+        auto task_function = [&task, &group, &section, event_num, completion = std::move(completion)]() {
+            auto prev_section = Log::getSection();
+            auto prev_event_num = Log::getEventNum();
+            Log::setSection(section);
+            Log::setEventNum(event_num);
+            try {
+                task();
+            } catch(...) {
+                if(!group.has_exception.test_and_set()) {
+                    group.exception_ptr = std::current_exception();
+                }
+            }
+            completion->executed();
+            Log::setSection(prev_section);
+            Log::setEventNum(prev_event_num);
+        };
+        queue_.pushSubtask(Task(std::move(task_function)));
+    }
+
+    // Help executing subtasks until all subtasks of this group are finished
+    std::unique_lock<std::mutex> lock{group.mutex};
+    while(group.remaining > 0) {
+        lock.unlock();
+        Task task;
+        if(queue_.popSubtask(task)) {
+            task();
+            task = Task();
+            lock.lock();
+            continue;
+        }
+        lock.lock();
+        // All remaining subtasks are being executed by other workers
+        ALLPIX_PROFILE_ZONE("ThreadPool::waitSubtasks");
+        group.condition.wait(lock, [&group]() { return group.remaining == 0; });
+    }
+
+    if(group.exception_ptr) {
+        std::rethrow_exception(group.exception_ptr);
+    }
+    if(!group.all_executed) {
+        throw RuntimeError("thread pool was invalidated before all subtasks were executed");
+    }
+}
+
 void ThreadPool::destroy() {
     done_ = true;
     queue_.invalidate();
@@ -156,11 +328,7 @@ bool ThreadPool::valid() {
 }
 
 unsigned int ThreadPool::threadNum() {
-    auto iter = thread_nums_.find(std::this_thread::get_id());
-    if(iter != thread_nums_.end()) {
-        return iter->second;
-    }
-    return 0;
+    return thread_num_;
 }
 
 unsigned int ThreadPool::threadCount() {
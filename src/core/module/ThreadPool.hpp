@@ -13,15 +13,23 @@
 
 #include <algorithm>
 #include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <exception>
 #include <functional>
 #include <future>
-#include <map>
 #include <memory>
+#include <new>
 #include <queue>
 #include <set>
 #include <thread>
+#include <type_traits>
 #include <utility>
+#include <vector>
+
+#include "core/utils/profiling.h"
 
 namespace allpix {
     /**
@@ -29,24 +37,100 @@ namespace allpix {
      */
     class ThreadPool {
     public:
+        /**
+         * @brief Move-only job executed by the pool
+         *
+         * Callables up to the size of the internal buffer are stored inline, such that submitting a job does not allocate.
+         * Larger callables, or callables which cannot be moved without throwing, are moved to the heap instead. Exceptions
+         * thrown by the callable propagate to the caller of the task.
+         */
+        class Task {
+        public:
+            /**
+             * @brief Construct an empty task
+             */
+            Task() = default;
+
+            /**
+             * @brief Construct a task from a callable taking no arguments
+             * @param func Callable to store in the task
+             */
+            template <typename Func, typename = std::enable_if_t<!std::is_same<std::decay_t<Func>, Task>::value>>
+            explicit Task(Func&& func);
+
+            /// @{
+            /**
+             * @brief Tasks can only be moved, the moved-from task is empty
+             */
+            Task(Task&& other) noexcept;
+            Task& operator=(Task&& other) noexcept;
+            Task(const Task&) = delete;
+            Task& operator=(const Task&) = delete;
+            /// @}
+
+            /**
+             * @brief Destroy the stored callable
+             */
+            ~Task() { reset(); }
+
+            /**
+             * @brief Execute the stored callable
+             */
+            void operator()() { operations_->invoke(storage()); }
+
+            /**
+             * @brief Check if the task holds a callable
+             */
+            explicit operator bool() const { return operations_ != nullptr; }
+
+        private:
+            /**
+             * @brief Type-erased operations on the stored callable
+             */
+            struct Operations {
+                void (*invoke)(void* object);
+                void (*move)(void* from, void* to) noexcept;
+                void (*destroy)(void* object) noexcept;
+            };
+            template <typename Func, bool Inline> static const Operations* operations();
+
+            void* storage() { return static_cast<void*>(&buffer_); }
+            void reset() noexcept;
+
+            // Buffer holding the callable or a pointer to it if stored on the heap, large enough for the event jobs
+            static constexpr size_t buffer_size = 128;
+            std::aligned_storage_t<buffer_size, alignof(std::max_align_t)> buffer_;
+            const Operations* operations_{nullptr};
+        };
+
         /**
          * @brief Internal thread-safe queuing system
          *
-         * It internally consists of two separate queues
-         * - A standard queue pushed in order of jobs to process
-         * - An ordered priority queue for work that need linear processing
+         * It internally consists of three separate queue systems
+         * - A set of standard queues (lanes), one per worker, holding jobs in order of submission
+         * - An ordered reorder window for work that need linear processing
+         * - A queue of subtasks split off from running jobs, which is always popped first
+         *
+         * Every worker pops standard jobs from the front of its own lane and steals from the front of the other lanes once
+         * its own lane is exhausted, such that workers only contend on a lane mutex when they run out of work. The reorder
+         * window is popped if the value for the current identifier can be directly processed. Otherwise work is popped from
+         * the standard lanes unless the number of buffered values is too large. Workers only take the shared sleep mutex
+         * when no work is available at all.
          *
-         * The priority queue is popped if the top of the queue can be directly processed. Otherwise work is popped from the
-         * default queue unless the priority queue size is too large.
+         * The reorder window is a ring buffer indexed by the ordering identifier, with atomic slot states for both the
+         * buffered values and the completed identifiers. Releasing the next identifier in order is therefore lock-free and
+         * constant in time. Identifiers too far ahead of the current identifier to fit in the window are kept in mutex
+         * guarded overflow containers instead.
          */
         template <typename T> class SafeQueue {
         public:
             /**
              * @brief Default constructor, initializes empty queue
-             * @param max_standard_size Max size of the default queue
-             * @param max_priority_size Max size of the priority queue
+             * @param num_lanes Number of standard lanes, typically the number of workers
+             * @param max_standard_size Max size of all standard lanes combined
+             * @param max_priority_size Max number of values buffered in the reorder window
              */
-            SafeQueue(unsigned int max_standard_size, unsigned int max_priority_size);
+            SafeQueue(unsigned int num_lanes, unsigned int max_standard_size, unsigned int max_priority_size);
 
             /**
              * @brief Erases the queue and release waiting threads on destruction
@@ -56,21 +140,23 @@ namespace allpix {
             /**
              * @brief Get the top value from the appropriate queue
              * @param out Reference where the value at the top of the queue will be written to
+             * @param lane Index of the lane owned by the calling worker, other lanes are stolen from if it is empty
              * @param func Optional function to execute before releasing the queue mutex if pop was successful
              * @param buffer_left Optional number of jobs that should be left in priority buffer without stall on push
              * @return True if a task was acquired or false if pop was exited for another reason
              */
-            bool pop(T& out, const std::function<void()>& func = nullptr, size_t buffer_left = 0);
+            bool pop(T& out, size_t lane, const std::function<void()>& func = nullptr, size_t buffer_left = 0);
 
             /**
-             * @brief Push a new value onto the standard queue, will block if queue is full
+             * @brief Push a new value onto a standard lane, will block if all lanes combined are full
              * @param value Value to push to the queue
              * @param wait If the push is allowed to stall if there is no capacity
+             * @param lane Lane to push the value to, or SIZE_MAX to distribute values over all lanes in turns
              * @return If the push was successful
              */
-            bool push(T value, bool wait = true);
+            bool push(T value, bool wait = true, size_t lane = SIZE_MAX);
             /**
-             * @brief Push a new value onto the priority queue
+             * @brief Push a new value onto the reorder window
              * @param n Ordering identifier for the priority
              * @param value Value to push to the queue
              * @param wait If the push is allowed to stall if there is no capacity
@@ -78,6 +164,19 @@ namespace allpix {
              */
             bool push(uint64_t n, T value, bool wait = true);
 
+            /**
+             * @brief Push a subtask of a running job, never blocks
+             * @param value Value to push to the queue
+             */
+            void pushSubtask(T value);
+            /**
+             * @brief Pop a subtask without waiting
+             * @param out Reference where the subtask will be written to
+             * @param func Optional function to execute before releasing the queue mutex if pop was successful
+             * @return True if a subtask was acquired
+             */
+            bool popSubtask(T& out, const std::function<void()>& func = nullptr);
+
             /**
              * @brief Mark an identifier as complete
              * @param n Identifier that is complete
@@ -114,21 +213,164 @@ namespace allpix {
              */
             size_t prioritySize() const;
 
+            /**
+             * @brief Limit the memory held by the values in the reorder window
+             * @param max_memory Maximum memory in bytes, zero to not limit the memory
+             *
+             * Standard values are not popped while the memory is over the limit, such that no further values enter the
+             * reorder window until values for the current identifier have been processed.
+             */
+            void setMaxPriorityMemory(size_t max_memory);
+
+            /**
+             * @brief Account memory held by a value in the reorder window
+             * @param memory Memory in bytes
+             */
+            void addPriorityMemory(size_t memory);
+
+            /**
+             * @brief Remove memory previously accounted with \ref addPriorityMemory
+             * @param memory Memory in bytes
+             */
+            void removePriorityMemory(size_t memory);
+
+            /**
+             * @brief Return the memory held by the values in the reorder window
+             * @return Accounted memory in bytes
+             */
+            size_t priorityMemory() const;
+
+            /**
+             * @brief Return the largest memory held by the values in the reorder window at any time
+             * @return Peak of the accounted memory in bytes
+             */
+            size_t peakPriorityMemory() const;
+
             /**
              * @brief Invalidate the queue
              */
             void invalidate();
 
         private:
+            /**
+             * @brief Standard queue owned by a single worker
+             */
+            struct Lane {
+                std::mutex mutex;
+                std::deque<T> queue;
+            };
+
+            /**
+             * @brief Try to pop the value for the current identifier from the reorder window
+             * @param out Reference where the value will be written to
+             * @param func Optional function to execute before releasing the slot if pop was successful
+             * @return True if a task was acquired
+             */
+            bool try_pop_priority(T& out, const std::function<void()>& func);
+
+            /**
+             * @brief Try to pop a value from the own lane, or steal one from any other lane
+             * @param out Reference where the value will be written to
+             * @param lane Lane owned by the calling worker
+             * @param func Optional function to execute before releasing the lane mutex if pop was successful
+             * @return True if a task was acquired
+             */
+            bool try_pop_standard(T& out, size_t lane, const std::function<void()>& func);
+
+            /**
+             * @brief Check without locking if any work can currently be popped
+             * @param buffer_left Number of jobs that should be left in priority buffer
+             * @return True if a pop attempt might succeed
+             */
+            bool has_work(size_t buffer_left) const;
+
+            /**
+             * @brief Check if standard values can be popped without overfilling the reorder window
+             * @param buffer_left Number of jobs that should be left in priority buffer
+             * @return True if the reorder window has capacity and its memory is below the limit
+             */
+            bool standard_allowed(size_t buffer_left) const;
+
+            /**
+             * @brief Wake up a sleeping worker if there is any
+             */
+            void notify_worker();
+
+            // Special slot states, all other states are the identifier of the value stored in the slot
+            static constexpr uint64_t empty_slot = UINT64_MAX;
+            static constexpr uint64_t busy_slot = UINT64_MAX - 1;
+
+            /**
+             * @brief Slot of the reorder window holding a buffered value
+             */
+            struct Slot {
+                std::atomic<uint64_t> state{empty_slot};
+                T value;
+            };
+
+            /**
+             * @brief Check without locking if the value for the current identifier is buffered
+             * @return True if the value for the current identifier can be popped
+             */
+            bool priority_ready() const;
+
+            /**
+             * @brief Advance the current identifier over all consecutive completed identifiers
+             */
+            void advance();
+
+            /**
+             * @brief Wake up a pusher waiting for capacity in the reorder window if there is any
+             */
+            void notify_priority_pusher();
+
             std::atomic_bool valid_{true};
-            mutable std::mutex mutex_;
-            std::queue<T> queue_;
-            std::set<uint64_t> completed_ids_;
-            uint64_t current_id_{0};
+
+            // Standard lanes and the total number of values stored in them
+            std::vector<Lane> lanes_;
+            std::atomic<size_t> next_lane_{0};
+            std::atomic<size_t> standard_size_{0};
+
+            // Subtasks of running jobs
+            Lane subtasks_;
+            std::atomic<size_t> subtask_size_{0};
+
+            // Reorder window of buffered values and completed identifiers, indexed by identifier modulo the window size
+            std::vector<Slot> window_;
+            std::vector<std::atomic<uint64_t>> completed_;
+            const uint64_t window_mask_;
+            std::atomic<uint64_t> current_id_{0};
+            std::atomic<size_t> priority_size_{0};
+            std::atomic<size_t> priority_memory_{0};
+            std::atomic<size_t> max_priority_memory_{0};
+            std::atomic<size_t> peak_priority_memory_{0};
+
+            // Buffered values and completed identifiers outside of the reorder window
+            std::mutex overflow_mutex_;
             using PQValue = std::pair<uint64_t, T>;
-            std::priority_queue<PQValue, std::vector<PQValue>, std::greater<>> priority_queue_;
-            std::condition_variable push_condition_;
+            struct PQCompare {
+                bool operator()(const PQValue& lhs, const PQValue& rhs) const { return lhs.first > rhs.first; }
+            };
+            std::priority_queue<PQValue, std::vector<PQValue>, PQCompare> overflow_queue_;
+            std::atomic<uint64_t> overflow_top_{empty_slot};
+            std::set<uint64_t> overflow_completed_;
+            std::atomic<size_t> overflow_completed_size_{0};
+
+            // Pushers waiting for free capacity in the reorder window
+            std::mutex priority_push_mutex_;
+            std::condition_variable priority_push_condition_;
+            std::atomic<unsigned int> waiting_priority_pushers_{0};
+
+            // Sleeping workers waiting for new jobs
+            std::mutex sleep_mutex_;
             std::condition_variable pop_condition_;
+            std::atomic<unsigned int> sleeping_workers_{0};
+
+            // Pushers waiting for free capacity in the standard lanes
+            std::mutex push_mutex_;
+            std::condition_variable push_condition_;
+            std::atomic<unsigned int> waiting_pushers_{0};
+
             const size_t max_standard_size_;
             const size_t max_priority_size_;
         };
@@ -187,6 +429,29 @@ namespace allpix {
          */
         template <typename Func, typename... Args> auto submit(uint64_t n, Func&& func, Args&&... args);
 
+        /**
+         * @brief Submit a standard job without a future. In case no workers are registered, the function will be executed
+         * immediately.
+         * @param func Function to execute by the pool
+         * @param args Parameters to pass to the function
+         * @return True if the job was queued, false if the pool has been invalidated
+         *
+         * Submitting small jobs does not allocate. Exceptions thrown by the job terminate the pool and are rethrown by
+         * \ref checkException, like those of jobs submitted with a future.
+         */
+        template <typename Func, typename... Args> bool post(Func&& func, Args&&... args);
+        /**
+         * @brief Submit a priority job without a future. In case no workers are registered, the function will be executed
+         * immediately.
+         * @param n Priority identifier or UINT64_MAX for non-prioritized submission
+         * @param func Function to execute by the pool
+         * @param args Parameters to pass to the function
+         * @return True if the job was queued, false if the pool has been invalidated
+         *
+         * @warning This function can only be called if thread pool was initialized with buffered jobs
+         */
+        template <typename Func, typename... Args> bool post(uint64_t n, Func&& func, Args&&... args);
+
         /**
          * @brief Mark identifier as completed
          * @param n Identifier that is complete
@@ -211,6 +476,36 @@ namespace allpix {
          */
         size_t bufferedQueueSize() const;
 
+        /**
+         * @brief Limit the memory held by buffered jobs, new standard jobs are not started while the limit is exceeded
+         * @param max_memory Maximum memory in bytes, zero to not limit the memory
+         */
+        void setMaxBufferedMemory(size_t max_memory);
+
+        /**
+         * @brief Account memory held by a buffered job, should be called before submitting the job
+         * @param memory Memory in bytes
+         */
+        void addBufferedMemory(size_t memory);
+
+        /**
+         * @brief Remove memory of a buffered job once it is executed
+         * @param memory Memory in bytes previously added with \ref addBufferedMemory
+         */
+        void removeBufferedMemory(size_t memory);
+
+        /**
+         * @brief Return the memory held by buffered jobs
+         * @return Accounted memory in bytes
+         */
+        size_t bufferedMemory() const;
+
+        /**
+         * @brief Return the largest memory held by buffered jobs at any time since the pool was created
+         * @return Peak of the accounted memory in bytes
+         */
+        size_t peakBufferedMemory() const;
+
         /**
          * @brief Check if any worker thread has thrown an exception
          * @throw Exception thrown by worker thread, if any
@@ -255,19 +550,51 @@ namespace allpix {
          */
         static void registerThreadCount(unsigned int cnt);
 
+        /**
+         * @brief Execute a set of independent subtasks of the job running on the calling thread
+         * @param tasks Functions to execute, all of them have finished when this method returns
+         * @throw Exception thrown by any of the subtasks, rethrown after all of them have finished
+         *
+         * The subtasks are offered to the idle workers of the pool the calling thread belongs to, while the calling thread
+         * executes subtasks itself until all of them are finished. If the calling thread is not a worker of a pool, all
+         * subtasks are executed directly in order.
+         */
+        static void runSubtasks(const std::vector<std::function<void()>>& tasks);
+
     private:
         /**
          * @brief Constantly running internal function each thread uses to acquire work items from the queue.
+         * @param lane                Index of the standard lane owned by this worker
          * @param min_thread_buffer   Minimum buffer size to keep available without stall on push
          * @param initialize_function Function to initialize the thread
          * @param finalize_function   Function to finalize the thread
          */
-        void worker(size_t min_thread_buffer,
+        void worker(size_t lane,
+                    size_t min_thread_buffer,
                     const std::function<void()>& initialize_function,
                     const std::function<void()>& finalize_function);
 
-        // The queue holds the task functions to be executed by the workers
-        using Task = std::unique_ptr<std::packaged_task<void()>>;
+        /**
+         * @brief Get the lane standard jobs submitted from the calling thread should be added to
+         * @return Lane of the calling worker if it belongs to this pool, SIZE_MAX to distribute jobs otherwise
+         */
+        size_t submission_lane() const;
+
+        /**
+         * @brief Distribute subtasks over the workers of this pool and help executing them until all are finished
+         * @param tasks Functions to execute
+         */
+        void run_subtasks(const std::vector<std::function<void()>>& tasks);
+
+        /**
+         * @brief Queue a task to be executed by the workers
+         * @param n Priority identifier or UINT64_MAX for non-prioritized submission
+         * @param task Task to queue
+         * @return True if the task was queued
+         */
+        bool push_task(uint64_t n, Task task);
+
+        // The queue holds the tasks to be executed by the workers
         SafeQueue<Task> queue_;
         bool with_buffered_{true};
 
@@ -281,7 +608,12 @@ namespace allpix {
         std::atomic_flag has_exception_{false};
         std::exception_ptr exception_ptr_{nullptr};
 
-        static std::map<std::thread::id, unsigned int> thread_nums_;
+        // Pool and lane of the worker running on the current thread
+        static thread_local ThreadPool* current_pool_;
+        static thread_local size_t current_lane_;
+
+        // Number of the current thread, zero for threads not started by a pool
+        static thread_local unsigned int thread_num_;
         static std::atomic_uint thread_cnt_;
         static std::atomic_uint thread_total_;
     };
@@ -10,170 +10,469 @@
 
 #include <cassert>
 #include <climits>
+#include <cmath>
 
 namespace allpix {
+    /*
+     * The reorder window is sized to the next power of two able to hold all values that can be queued or buffered at the
+     * same time, such that in regular operation no identifier ends up in the overflow containers
+     */
     template <typename T>
-    ThreadPool::SafeQueue<T>::SafeQueue(unsigned int max_standard_size, unsigned max_priority_size)
-        : max_standard_size_(max_standard_size), max_priority_size_(max_priority_size) {}
+    ThreadPool::SafeQueue<T>::SafeQueue(unsigned int num_lanes, unsigned int max_standard_size, unsigned max_priority_size)
+        : lanes_(std::max(num_lanes, 1u)),
+          window_(std::size_t(1) << static_cast<unsigned int>(std::ceil(
+                      std::log2(std::max(static_cast<double>(max_standard_size) + max_priority_size + num_lanes, 2.))))),
+          completed_(window_.size()), window_mask_(window_.size() - 1), max_standard_size_(max_standard_size),
+          max_priority_size_(max_priority_size) {
+        for(auto& completed : completed_) {
+            completed = empty_slot;
+        }
+    }
 
     /*
-     * Block until a value is available if the wait parameter is set to true. The wait exits when the queue is invalidated.
+     * Block until a value is available. The wait exits when the queue is invalidated. The shared sleep mutex is only taken
+     * if no work could be found in any of the queues.
      */
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wstrict-overflow"
-    template <typename T> bool ThreadPool::SafeQueue<T>::pop(T& out, const std::function<void()>& func, size_t buffer_left) {
+    template <typename T>
+    bool ThreadPool::SafeQueue<T>::pop(T& out, size_t lane, const std::function<void()>& func, size_t buffer_left) {
         assert(buffer_left <= max_priority_size_);
-        // Lock the mutex
-        std::unique_lock<std::mutex> lock{mutex_};
-        if(!valid_) {
-            return false;
+        while(valid_) {
+            // Prefer subtasks of running jobs and work that needs linear processing, otherwise take standard work if the
+            // buffer has capacity left
+            if(popSubtask(out, func) || try_pop_priority(out, func)) {
+                return true;
+            }
+            if(standard_allowed(buffer_left) && try_pop_standard(out, lane, func)) {
+                return true;
+            }
+
+            // Wait for new items in the queues
+            ALLPIX_PROFILE_ZONE("ThreadPool::waitForWork");
+            std::unique_lock<std::mutex> lock{sleep_mutex_};
+            ++sleeping_workers_;
+            pop_condition_.wait(lock, [this, buffer_left]() { return !valid_ || has_work(buffer_left); });
+            --sleeping_workers_;
         }
+        return false;
+    }
 
-        // Wait for one of the queues to be available
-        bool pop_priority = !priority_queue_.empty() && priority_queue_.top().first == current_id_;
-        bool pop_standard = !queue_.empty() && priority_queue_.size() + buffer_left <= max_priority_size_;
-        while(!pop_priority && !pop_standard) {
-            // Wait for new item in the queue (unlocks the mutex while waiting)
-            pop_condition_.wait(lock);
-            if(!valid_) {
+    /*
+     * Only the value for the current identifier can be popped. The slot is claimed by a compare-and-swap of its state, such
+     * that exactly one worker acquires the value.
+     */
+    template <typename T> bool ThreadPool::SafeQueue<T>::try_pop_priority(T& out, const std::function<void()>& func) {
+        uint64_t current_id = current_id_;
+        auto& slot = window_[current_id & window_mask_];
+        uint64_t state = current_id;
+        if(slot.state.compare_exchange_strong(state, busy_slot)) {
+            out = std::move(slot.value);
+
+            // Optionally execute the protected function before the value is removed from the total count
+            if(func != nullptr) {
+                func();
+            }
+            --priority_size_;
+            slot.state = empty_slot;
+        } else if(overflow_top_ == current_id) {
+            // Fall back to the values outside of the reorder window
+            std::unique_lock<std::mutex> lock{overflow_mutex_};
+            if(overflow_queue_.empty() || overflow_queue_.top().first != current_id) {
                 return false;
             }
-            pop_priority = !priority_queue_.empty() && priority_queue_.top().first == current_id_;
-            pop_standard = !queue_.empty() && priority_queue_.size() + buffer_left <= max_priority_size_;
-        }
 
-        // Pop the appropriate queue
-        if(pop_priority) {
             // Priority queue is missing a pop returning a non-const reference, so need to apply a const_cast
-            out = std::move(const_cast<PQValue&>(priority_queue_.top())).second; // NOLINT
-            priority_queue_.pop();
-        } else { // pop_standard
-            out = std::move(queue_.front());
-            queue_.pop();
+            out = std::move(const_cast<PQValue&>(overflow_queue_.top())).second; // NOLINT
+            overflow_queue_.pop();
+            overflow_top_ = (overflow_queue_.empty() ? empty_slot : overflow_queue_.top().first);
+
+            // Optionally execute the protected function before the value is removed from the total count
+            if(func != nullptr) {
+                func();
+            }
+            --priority_size_;
+        } else {
+            return false;
         }
 
-        // Optionally execute the mutex protected function
-        if(func != nullptr) {
-            func();
+        // Notify possible pusher waiting to fill the buffer and workers waiting for buffer capacity
+        notify_priority_pusher();
+        notify_worker();
+        return true;
+    }
+
+    template <typename T>
+    bool ThreadPool::SafeQueue<T>::try_pop_standard(T& out, size_t lane, const std::function<void()>& func) {
+        // Start with the own lane and continue stealing from the other lanes in turns
+        for(size_t i = 0; i < lanes_.size(); ++i) {
+            auto& current = lanes_[(lane + i) % lanes_.size()];
+            std::unique_lock<std::mutex> lock{current.mutex};
+            if(current.queue.empty()) {
+                continue;
+            }
+
+            out = std::move(current.queue.front());
+            current.queue.pop_front();
+
+            // Optionally execute the mutex protected function before the value is removed from the total count
+            if(func != nullptr) {
+                func();
+            }
+            --standard_size_;
+            lock.unlock();
+
+            // Notify possible pusher waiting for capacity
+            if(waiting_pushers_ > 0) {
+                { std::lock_guard<std::mutex> push_lock{push_mutex_}; }
+                push_condition_.notify_one();
+            }
+            return true;
         }
+        return false;
+    }
 
-        // Notify possible pusher waiting to fill the queue
-        lock.unlock();
-        if(pop_priority) {
+    template <typename T> bool ThreadPool::SafeQueue<T>::has_work(size_t buffer_left) const {
+        return subtask_size_ > 0 || priority_ready() || (standard_size_ > 0 && standard_allowed(buffer_left));
+    }
+
+    /*
+     * The memory limit only holds back new values, values in the reorder window can always be processed. Since memory is
+     * only accounted while values are in the reorder window, the limit cannot block the queue if the window is empty.
+     */
+    template <typename T> bool ThreadPool::SafeQueue<T>::standard_allowed(size_t buffer_left) const {
+        return priority_size_ + buffer_left <= max_priority_size_ &&
+               (max_priority_memory_ == 0 || priority_memory_ < max_priority_memory_);
+    }
+
+    template <typename T> bool ThreadPool::SafeQueue<T>::priority_ready() const {
+        uint64_t current_id = current_id_;
+        return window_[current_id & window_mask_].state == current_id || overflow_top_ == current_id;
+    }
+
+    /*
+     * The sleep mutex is acquired before notifying to ensure a worker that just found no work is already waiting on the
+     * condition. Workers register as sleeping before checking for work, so either the worker sees the new work or the
+     * pusher sees the sleeping worker.
+     */
+    template <typename T> void ThreadPool::SafeQueue<T>::notify_worker() {
+        if(sleeping_workers_ > 0) {
+            { std::lock_guard<std::mutex> lock{sleep_mutex_}; }
             pop_condition_.notify_one();
         }
-        push_condition_.notify_one();
-        return true;
     }
-#pragma GCC diagnostic pop
 
-    template <typename T> bool ThreadPool::SafeQueue<T>::push(T value, bool wait) {
-        // Lock the mutex
-        std::unique_lock<std::mutex> lock{mutex_};
+    template <typename T> void ThreadPool::SafeQueue<T>::notify_priority_pusher() {
+        if(waiting_priority_pushers_ > 0) {
+            { std::lock_guard<std::mutex> lock{priority_push_mutex_}; }
+            priority_push_condition_.notify_one();
+        }
+    }
+
+    /*
+     * The slot is reserved by a compare-and-swap of the size, such that concurrent pushers never exceed the maximum size
+     * together. The reservation happens before pushing such that the value is never popped before it is counted.
+     */
+    template <typename T> bool ThreadPool::SafeQueue<T>::push(T value, bool wait, size_t lane) {
+        size_t size = standard_size_;
+        while(true) {
+            // Abort the push operation if the queue is not valid anymore
+            if(!valid_) {
+                return false;
+            }
 
-        // Check if the queue reached its full size
-        if(queue_.size() >= max_standard_size_) {
-            // Wait until the queue is below the max size or it was invalidated(shutdown)
+            // Reserve a slot if the lanes did not reach their full size
+            if(size < max_standard_size_) {
+                if(standard_size_.compare_exchange_weak(size, size + 1)) {
+                    break;
+                }
+                continue;
+            }
+
+            // Wait until the lanes are below the max size or the queue was invalidated(shutdown)
             if(!wait) {
                 return false;
             }
-            push_condition_.wait(lock, [this]() { return queue_.size() < max_standard_size_ || !valid_; });
+            ALLPIX_PROFILE_ZONE("ThreadPool::waitForSpace");
+            std::unique_lock<std::mutex> lock{push_mutex_};
+            ++waiting_pushers_;
+            push_condition_.wait(lock, [this]() { return standard_size_ < max_standard_size_ || !valid_; });
+            --waiting_pushers_;
+            size = standard_size_;
+        }
+
+        // Distribute values over all lanes if no specific lane is requested
+        if(lane == SIZE_MAX) {
+            lane = next_lane_++;
+        }
+        {
+            auto& target = lanes_[lane % lanes_.size()];
+            std::lock_guard<std::mutex> lock{target.mutex};
+            target.queue.push_back(std::move(value));
+        }
+
+        // Notify possible consumer
+        notify_worker();
+        return true;
+    }
+
+    template <typename T> void ThreadPool::SafeQueue<T>::pushSubtask(T value) {
+        if(!valid_) {
+            return;
+        }
+        ++subtask_size_;
+        {
+            std::lock_guard<std::mutex> lock{subtasks_.mutex};
+            subtasks_.queue.push_back(std::move(value));
+        }
+
+        // Notify possible consumer
+        notify_worker();
+    }
+
+    template <typename T> bool ThreadPool::SafeQueue<T>::popSubtask(T& out, const std::function<void()>& func) {
+        if(subtask_size_ == 0) {
+            return false;
         }
 
-        // Abort the push operation if conditions not met
-        if(queue_.size() >= max_standard_size_ || !valid_) {
+        std::lock_guard<std::mutex> lock{subtasks_.mutex};
+        if(subtasks_.queue.empty()) {
             return false;
         }
+        out = std::move(subtasks_.queue.front());
+        subtasks_.queue.pop_front();
 
-        // Push a new element to the queue and notify possible consumer
-        queue_.push(std::move(value));
-        lock.unlock();
-        pop_condition_.notify_one();
+        // Optionally execute the mutex protected function before the value is removed from the total count
+        if(func != nullptr) {
+            func();
+        }
+        --subtask_size_;
         return true;
     }
 
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wstrict-overflow"
     template <typename T> bool ThreadPool::SafeQueue<T>::push(uint64_t n, T value, bool wait) {
-        // Lock the mutex
-        std::unique_lock<std::mutex> lock{mutex_};
         assert(n >= current_id_);
 
-        // Check if the queue reached its full size
-        if(priority_queue_.size() >= max_priority_size_) {
-            // Wait until the queue is below the max size or it was invalidated(shutdown)
+        // Reserve a slot in the buffer in the same way as for the lanes
+        size_t size = priority_size_;
+        while(true) {
+            // Abort the push operation if the queue is not valid anymore
+            if(!valid_) {
+                return false;
+            }
+
+            // Reserve a slot if the buffer did not reach its full size
+            if(size < max_priority_size_) {
+                if(priority_size_.compare_exchange_weak(size, size + 1)) {
+                    break;
+                }
+                continue;
+            }
+
+            // Wait until the buffer is below the max size or the queue was invalidated(shutdown)
             if(!wait) {
                 return false;
             }
-            push_condition_.wait(lock, [this]() { return priority_queue_.size() < max_priority_size_ || !valid_; });
+            ALLPIX_PROFILE_ZONE("ThreadPool::waitForSpace");
+            std::unique_lock<std::mutex> lock{priority_push_mutex_};
+            ++waiting_priority_pushers_;
+            priority_push_condition_.wait(lock, [this]() { return priority_size_ < max_priority_size_ || !valid_; });
+            --waiting_priority_pushers_;
+            size = priority_size_;
         }
 
-        // Abort the push operation if conditions not met
-        if(priority_queue_.size() >= max_priority_size_ || !valid_) {
-            return false;
+        if(n - current_id_ <= window_mask_) {
+            // The slot is free unless the value of the previous owner is still being moved out by a worker
+            auto& slot = window_[n & window_mask_];
+            uint64_t state = empty_slot;
+            while(!slot.state.compare_exchange_weak(state, busy_slot)) {
+                state = empty_slot;
+                std::this_thread::yield();
+            }
+            slot.value = std::move(value);
+            slot.state = n;
+        } else {
+            std::lock_guard<std::mutex> lock{overflow_mutex_};
+            overflow_queue_.emplace(n, std::move(value));
+            overflow_top_ = overflow_queue_.top().first;
         }
 
-        // Push a new element to the queue and notify possible consumer
-        priority_queue_.emplace(n, std::move(value));
-        lock.unlock();
-        pop_condition_.notify_one();
+        // Notify possible consumer if the value can be processed directly
+        if(priority_ready()) {
+            notify_worker();
+        }
         return true;
     }
-#pragma GCC diagnostic pop
 
     template <typename T> void ThreadPool::SafeQueue<T>::complete(uint64_t n) {
-        std::unique_lock<std::mutex> lock{mutex_};
-        completed_ids_.insert(n);
-        auto iter = completed_ids_.begin();
-        while(iter != completed_ids_.end()) {
-            if(*iter != current_id_) {
-                return;
-            }
-            iter = completed_ids_.erase(iter);
-            ++current_id_;
-            lock.unlock();
-            pop_condition_.notify_one();
-            lock.lock();
+        assert(n >= current_id_);
+        if(n - current_id_ <= window_mask_) {
+            completed_[n & window_mask_] = n;
+        } else {
+            std::lock_guard<std::mutex> lock{overflow_mutex_};
+            overflow_completed_.insert(n);
+            ++overflow_completed_size_;
         }
+        advance();
     }
 
-    template <typename T> uint64_t ThreadPool::SafeQueue<T>::currentId() const {
-        std::lock_guard<std::mutex> lock{mutex_};
-        return current_id_;
-    }
+    /*
+     * Every thread completing an identifier tries to advance after publishing its completion. Checking the slot after the
+     * publication guarantees that either this thread or the one advancing the current identifier observes the completion.
+     */
+    template <typename T> void ThreadPool::SafeQueue<T>::advance() {
+        bool advanced = false;
+        while(true) {
+            uint64_t current_id = current_id_;
+            if(completed_[current_id & window_mask_] == current_id) {
+                advanced |= current_id_.compare_exchange_weak(current_id, current_id + 1);
+                continue;
+            }
+
+            // Move completed identifiers that entered the window from the overflow
+            if(overflow_completed_size_ == 0) {
+                break;
+            }
+            bool moved = false;
+            std::unique_lock<std::mutex> lock{overflow_mutex_};
+            auto iter = overflow_completed_.begin();
+            while(iter != overflow_completed_.end() && *iter - current_id_ <= window_mask_) {
+                completed_[*iter & window_mask_] = *iter;
+                iter = overflow_completed_.erase(iter);
+                --overflow_completed_size_;
+                moved = true;
+            }
+            lock.unlock();
+            if(!moved) {
+                break;
+            }
+        }
 
-    template <typename T> bool ThreadPool::SafeQueue<T>::valid() const {
-        std::lock_guard<std::mutex> lock{mutex_};
-        return valid_;
+        // Wake up a worker if the next value in line can now be processed
+        if(advanced && priority_ready()) {
+            notify_worker();
+        }
     }
 
+    template <typename T> uint64_t ThreadPool::SafeQueue<T>::currentId() const { return current_id_; }
+
+    template <typename T> bool ThreadPool::SafeQueue<T>::valid() const { return valid_; }
+
     template <typename T> bool ThreadPool::SafeQueue<T>::empty() const {
-        std::lock_guard<std::mutex> lock{mutex_};
-        return !valid_ || (queue_.empty() && priority_queue_.empty());
+        return !valid_ || (standard_size_ == 0 && priority_size_ == 0 && subtask_size_ == 0);
     }
 
     template <typename T> size_t ThreadPool::SafeQueue<T>::size() const {
-        std::lock_guard<std::mutex> lock{mutex_};
-        return queue_.size() + priority_queue_.size();
+        return standard_size_ + priority_size_ + subtask_size_;
+    }
+
+    template <typename T> size_t ThreadPool::SafeQueue<T>::prioritySize() const { return priority_size_; }
+
+    template <typename T> void ThreadPool::SafeQueue<T>::setMaxPriorityMemory(size_t max_memory) {
+        max_priority_memory_ = max_memory;
+    }
+
+    template <typename T> void ThreadPool::SafeQueue<T>::addPriorityMemory(size_t memory) {
+        auto current = (priority_memory_ += memory);
+        auto peak = peak_priority_memory_.load();
+        while(current > peak && !peak_priority_memory_.compare_exchange_weak(peak, current)) {
+        }
     }
 
-    template <typename T> size_t ThreadPool::SafeQueue<T>::prioritySize() const {
-        std::lock_guard<std::mutex> lock{mutex_};
-        return priority_queue_.size();
+    /*
+     * All sleeping workers are woken up when the memory drops below the limit, since standard values might be waiting for
+     * any of them.
+     */
+    template <typename T> void ThreadPool::SafeQueue<T>::removePriorityMemory(size_t memory) {
+        auto previous = priority_memory_.fetch_sub(memory);
+        auto max_memory = max_priority_memory_.load();
+        if(max_memory != 0 && previous >= max_memory && previous - memory < max_memory && sleeping_workers_ > 0) {
+            { std::lock_guard<std::mutex> lock{sleep_mutex_}; }
+            pop_condition_.notify_all();
+        }
     }
 
+    template <typename T> size_t ThreadPool::SafeQueue<T>::priorityMemory() const { return priority_memory_; }
+
+    template <typename T> size_t ThreadPool::SafeQueue<T>::peakPriorityMemory() const { return peak_priority_memory_; }
+
     /*
      * Used to ensure no conditions are being waited for in pop when a thread or the application is trying to exit. The queue
      * is invalid after calling this method and it is an error to continue using a queue after this method has been called.
      */
     template <typename T> void ThreadPool::SafeQueue<T>::invalidate() {
-        std::unique_lock<std::mutex> lock{mutex_};
-        std::priority_queue<PQValue, std::vector<PQValue>, std::greater<>>().swap(priority_queue_);
-        std::queue<T>().swap(queue_);
         valid_ = false;
-        lock.unlock();
-        push_condition_.notify_all();
+
+        // Clear all queues
+        for(auto& lane : lanes_) {
+            std::lock_guard<std::mutex> lock{lane.mutex};
+            standard_size_ -= lane.queue.size();
+            std::deque<T>().swap(lane.queue);
+        }
+        {
+            // Destroy the subtasks outside of the lock, as this marks them as finished
+            std::deque<T> subtasks;
+            {
+                std::lock_guard<std::mutex> lock{subtasks_.mutex};
+                subtask_size_ -= subtasks_.queue.size();
+                subtasks.swap(subtasks_.queue);
+            }
+        }
+        for(auto& slot : window_) {
+            uint64_t state = slot.state;
+            if(state != empty_slot && state != busy_slot && slot.state.compare_exchange_strong(state, busy_slot)) {
+                slot.value = T();
+                --priority_size_;
+                slot.state = empty_slot;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock{overflow_mutex_};
+            priority_size_ -= overflow_queue_.size();
+            std::priority_queue<PQValue, std::vector<PQValue>, PQCompare>().swap(overflow_queue_);
+            overflow_top_ = empty_slot;
+        }
+
+        // Release all waiting threads, taking the corresponding mutexes to not miss any thread about to wait
+        { std::lock_guard<std::mutex> lock{sleep_mutex_}; }
         pop_condition_.notify_all();
+        { std::lock_guard<std::mutex> lock{push_mutex_}; }
+        push_condition_.notify_all();
+        { std::lock_guard<std::mutex> lock{priority_push_mutex_}; }
+        priority_push_condition_.notify_all();
+    }
+
+    /*
+     * Callables which fit into the buffer and can be moved without throwing are constructed in place, all others on the heap
+     * with only their pointer stored in the buffer
+     */
+    template <typename Func, typename> ThreadPool::Task::Task(Func&& func) {
+        using Callable = std::decay_t<Func>;
+        constexpr bool is_inline = sizeof(Callable) <= buffer_size && alignof(Callable) <= alignof(std::max_align_t) &&
+                                   std::is_nothrow_move_constructible<Callable>::value;
+        if constexpr(is_inline) {
+            new(storage()) Callable(std::forward<Func>(func));
+        } else {
+            new(storage()) Callable*(new Callable(std::forward<Func>(func)));
+        }
+        operations_ = operations<Callable, is_inline>();
+    }
+
+    template <typename Func, bool Inline> const ThreadPool::Task::Operations* ThreadPool::Task::operations() {
+        if constexpr(Inline) {
+            static const Operations inline_operations{
+                [](void* object) { (*static_cast<Func*>(object))(); },
+                [](void* from, void* to) noexcept {
+                    new(to) Func(std::move(*static_cast<Func*>(from)));
+                    static_cast<Func*>(from)->~Func();
+                },
+                [](void* object) noexcept { static_cast<Func*>(object)->~Func(); }};
+            return &inline_operations;
+        } else {
+            static const Operations heap_operations{
+                [](void* object) { (**static_cast<Func**>(object))(); },
+                [](void* from, void* to) noexcept { new(to) Func*(*static_cast<Func**>(from)); },
+                [](void* object) noexcept { delete *static_cast<Func**>(object); }};
+            return &heap_operations;
+        }
     }
 
     template <typename Func, typename... Args> auto ThreadPool::submit(Func&& func, Args&&... args) {
@@ -199,11 +498,7 @@ namespace allpix {
         if(threads_.empty()) {
             task_function();
         } else {
-            if(n == UINT64_MAX) {
-                success = queue_.push(std::make_unique<std::packaged_task<void()>>(std::move(task_function)), true);
-            } else {
-                success = queue_.push(n, std::make_unique<std::packaged_task<void()>>(std::move(task_function)), false);
-            }
+            success = push_task(n, Task(std::move(task_function)));
         }
         if(success) {
             return future;
@@ -212,4 +507,19 @@ namespace allpix {
         }
     }
 
+    template <typename Func, typename... Args> bool ThreadPool::post(Func&& func, Args&&... args) {
+        return post(UINT64_MAX, std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+    template <typename Func, typename... Args> bool ThreadPool::post(uint64_t n, Func&& func, Args&&... args) {
+        assert(n == UINT64_MAX || with_buffered_);
+        // Bind the arguments to the task, which is executed directly by the worker without a shared state
+        auto bound_task = std::bind(std::forward<Func>(func), std::forward<Args>(args)...);
+        if(threads_.empty()) {
+            bound_task();
+            return true;
+        }
+        return push_task(n, Task(std::move(bound_task)));
+    }
+
 } // namespace allpix
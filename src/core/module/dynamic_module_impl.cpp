@@ -7,6 +7,10 @@
  * - ALLPIX_MODULE_HEADER: name of the header defining the module
  * - ALLPIX_MODULE_UNIQUE: true if the module is unique, false otherwise
  *
+ * Modules linked statically into the executable additionally need
+ * - ALLPIX_MODULE_STATIC: true to register the module in the static module registry instead of exporting the functions
+ * - ALLPIX_MODULE_SECTION: name of the configuration section of the module
+ *
  * @copyright Copyright (c) 2017-2020 CERN and the Allpix Squared authors.
  * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
  * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
@@ -26,11 +30,20 @@
 
 #include ALLPIX_MODULE_HEADER
 
+#if ALLPIX_MODULE_STATIC
+#include "core/module/StaticModuleRegistry.hpp"
+
+// Give the interface functions internal linkage, such that several modules can be linked into the same executable
+#define ALLPIX_MODULE_LINKAGE namespace
+#else
+#define ALLPIX_MODULE_LINKAGE extern "C"
+#endif
+
 namespace allpix {
     class Messenger;
     class GeometryManager;
 
-    extern "C" {
+    ALLPIX_MODULE_LINKAGE {
     /**
      * @brief Returns the type of the Module it is linked to
      *
@@ -80,5 +93,11 @@ namespace allpix {
     // Returns that is a detector module
     bool allpix_module_is_unique() { return false; }
 #endif
+
+#if ALLPIX_MODULE_STATIC
+    // Register the module in the static module registry during the static initialization of the executable
+    [[maybe_unused]] const bool allpix_module_registered = register_static_module(
+        ALLPIX_MODULE_SECTION, allpix_module_is_unique(), reinterpret_cast<void*>(&allpix_module_generator)); // NOLINT
+#endif
     }
 } // namespace allpix
@@ -10,16 +10,64 @@
 #ifndef ALLPIX_RANDOM_DISTRIBUTIONS_H
 #define ALLPIX_RANDOM_DISTRIBUTIONS_H
 
+#include <boost/random/binomial_distribution.hpp>
+#include <boost/random/exponential_distribution.hpp>
 #include <boost/random/normal_distribution.hpp>
 #include <boost/random/piecewise_linear_distribution.hpp>
 #include <boost/random/poisson_distribution.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
 #include <boost/random/uniform_real_distribution.hpp>
 
+#include <cstddef>
+#include <type_traits>
+
+#include "core/utils/log.h"
+#include "core/utils/prng.h"
+
 namespace allpix {
+    template <typename T> using binomial_distribution = boost::random::binomial_distribution<T>;
+    template <typename T> using exponential_distribution = boost::random::exponential_distribution<T>;
     template <typename T> using normal_distribution = boost::random::normal_distribution<T>;
     template <typename T> using piecewise_linear_distribution = boost::random::piecewise_linear_distribution<T>;
     template <typename T> using poisson_distribution = boost::random::poisson_distribution<T>;
+    template <typename T> using uniform_int_distribution = boost::random::uniform_int_distribution<T>;
     template <typename T> using uniform_real_distribution = boost::random::uniform_real_distribution<T>;
+
+    /**
+     * @brief Fill a buffer with normally distributed values
+     * @param engine Random number engine to draw from
+     * @param values Buffer to fill
+     * @param count Number of values to generate
+     * @param mean Mean of the distribution
+     * @param sigma Standard deviation of the distribution
+     *
+     * The values are generated with the same ziggurat method as \ref normal_distribution and consume the engine in the same
+     * order, such that the result is identical to sampling the distribution once for every value.
+     */
+    template <typename T, typename Engine>
+    void fill_normal(Engine& engine, T* values, size_t count, std::common_type_t<T> mean, std::common_type_t<T> sigma) {
+        boost::random::detail::unit_normal_distribution<T> unit_normal;
+        for(size_t i = 0; i < count; ++i) {
+            values[i] = unit_normal(engine) * sigma + mean;
+        }
+    }
+
+    /**
+     * @brief Fill a buffer with normally distributed values from the framework generator
+     *
+     * Unless the random numbers are logged, the underlying engine is selected once for the whole buffer instead of for every
+     * number drawn. The generated values are identical in both cases.
+     */
+    template <typename T>
+    void fill_normal(
+        RandomNumberGenerator& generator, T* values, size_t count, std::common_type_t<T> mean, std::common_type_t<T> sigma) {
+        IFLOG(PRNG) {
+            fill_normal<T, RandomNumberGenerator>(generator, values, count, mean, sigma);
+        }
+        else {
+            generator.visit([&](auto& engine) { fill_normal<T>(engine, values, count, mean, sigma); });
+        }
+    }
 } // namespace allpix
 
 #endif // ALLPIX_RANDOM_DISTRIBUTIONS_H
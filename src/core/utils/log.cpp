@@ -12,10 +12,12 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <exception>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <ostream>
 #include <regex>
 #include <string>
@@ -24,6 +26,113 @@
 
 using namespace allpix;
 
+namespace {
+    /**
+     * @brief Formatted log message waiting to be written by the background writer
+     */
+    struct Message {
+        uint64_t sequence{};
+        std::string identifier;
+        std::string text;
+    };
+
+    /**
+     * @brief Ring buffer of messages with a single producing and a single consuming thread
+     *
+     * The producer is the thread owning the buffer and the consumer is the background writer, such that no locking is
+     * required to exchange messages.
+     */
+    class MessageRing {
+    public:
+        /**
+         * @brief Add a message to the buffer
+         * @param message Message to move into the buffer if there is space left
+         * @return True if the message was added, false if the buffer is full
+         */
+        bool push(Message& message) {
+            auto head = head_.load(std::memory_order_relaxed);
+            if(head - tail_.load(std::memory_order_acquire) == slots_.size()) {
+                return false;
+            }
+            slots_[head % slots_.size()] = std::move(message);
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Take the oldest message from the buffer
+         * @param message Message to move the oldest message into
+         * @return True if a message was taken, false if the buffer is empty
+         */
+        bool pop(Message& message) {
+            auto tail = tail_.load(std::memory_order_relaxed);
+            if(tail == head_.load(std::memory_order_acquire)) {
+                return false;
+            }
+            message = std::move(slots_[tail % slots_.size()]);
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Set when the owning thread exits, such that the buffer can be removed once it is empty
+        std::atomic<bool> closed{false};
+
+    private:
+        std::array<Message, 1024> slots_;
+        std::atomic<size_t> head_{0};
+        std::atomic<size_t> tail_{0};
+    };
+
+    /**
+     * @brief State of the background writer shared by all threads
+     */
+    struct Writer {
+        std::atomic<bool> active{false};
+        std::atomic<bool> stop{false};
+        // Number of messages handed to and written by the writer, used for ordering and to skip draining
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<uint64_t> written{0};
+        std::thread thread;
+
+        // Buffers of all threads, only locked to register new threads and while draining
+        std::mutex rings_mutex;
+        std::vector<std::shared_ptr<MessageRing>> rings;
+
+        ~Writer() {
+            // Stop the thread if the asynchronous mode has not been disabled before exiting
+            if(thread.joinable()) {
+                stop.store(true);
+                thread.join();
+            }
+        }
+    };
+    Writer& get_writer() {
+        static Writer writer;
+        return writer;
+    }
+
+    /**
+     * @brief Return the message buffer of the calling thread, registering it with the writer on first use
+     */
+    MessageRing& local_ring() {
+        struct LocalRing {
+            std::shared_ptr<MessageRing> ring;
+            ~LocalRing() {
+                if(ring != nullptr) {
+                    ring->closed.store(true, std::memory_order_release);
+                }
+            }
+        };
+        thread_local LocalRing local;
+        if(local.ring == nullptr) {
+            local.ring = std::make_shared<MessageRing>();
+            std::lock_guard<std::mutex> lock(get_writer().rings_mutex);
+            get_writer().rings.push_back(local.ring);
+        }
+        return *local.ring;
+    }
+} // namespace
+
 // Last name used while printing (for identifying process logs)
 std::string DefaultLogger::last_identifier_;
 // Last message send used to check if extra spaces are needed
@@ -64,12 +173,36 @@ DefaultLogger::~DefaultLogger() {
         } while((start_pos = out.find('\n', start_pos)) != std::string::npos);
     }
 
+    // Hand the message to the background writer if enabled, otherwise write it directly
+    if(get_writer().active.load(std::memory_order_acquire)) {
+        Message message{get_writer().sequence.fetch_add(1, std::memory_order_relaxed), identifier_, std::move(out)};
+        auto& ring = local_ring();
+        while(!ring.push(message)) {
+            // Wait for the writer to drain the buffer unless it has been stopped in the meantime
+            if(!get_writer().active.load(std::memory_order_acquire)) {
+                write_message(message.identifier, std::move(message.text));
+                return;
+            }
+            std::this_thread::yield();
+        }
+        return;
+    }
+
+    // Write any messages left by the background writer first to keep the order
+    drain_messages();
+    write_message(identifier_, std::move(out));
+}
+
+/**
+ * Writing is guarded by a mutex, which also protects the state used to overwrite lines of progress messages.
+ */
+void DefaultLogger::write_message(const std::string& identifier, std::string out) {
     // Lock the mutex to guard last identifier usage
     std::unique_lock<std::mutex> lock(write_mutex_);
 
     // Add extra spaces if necessary
     size_t extra_spaces = 0;
-    if(!identifier_.empty() && last_identifier_ == identifier_) {
+    if(!identifier.empty() && last_identifier_ == identifier) {
         // Put carriage return for process logs
         out = '\r' + out;
 
@@ -81,7 +214,7 @@ DefaultLogger::~DefaultLogger() {
         // End process log and continue normal logging
         out = '\n' + out;
     }
-    last_identifier_ = identifier_;
+    last_identifier_ = identifier;
 
     // Save last message
     last_message_ = out;
@@ -93,7 +226,7 @@ DefaultLogger::~DefaultLogger() {
     }
 
     // Add final newline if not a progress log
-    if(identifier_.empty()) {
+    if(identifier.empty()) {
         out += '\n';
     }
 
@@ -127,11 +260,80 @@ DefaultLogger::~DefaultLogger() {
     lock.unlock();
 }
 
+/**
+ * Messages of all threads are collected and written in the order they were handed to the writer. Buffers of threads which
+ * have exited are removed once they are empty.
+ */
+void DefaultLogger::drain_messages() {
+    auto& writer = get_writer();
+    if(writer.written.load(std::memory_order_acquire) == writer.sequence.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    std::vector<Message> messages;
+    {
+        std::lock_guard<std::mutex> lock(writer.rings_mutex);
+        for(auto iter = writer.rings.begin(); iter != writer.rings.end();) {
+            // Check before draining, such that a closed buffer is known to be empty afterwards
+            auto closed = (*iter)->closed.load(std::memory_order_acquire);
+            Message message;
+            while((*iter)->pop(message)) {
+                messages.push_back(std::move(message));
+            }
+            iter = (closed ? writer.rings.erase(iter) : std::next(iter));
+        }
+    }
+
+    std::sort(messages.begin(), messages.end(), [](const Message& lhs, const Message& rhs) {
+        return lhs.sequence < rhs.sequence;
+    });
+    for(auto& message : messages) {
+        write_message(message.identifier, std::move(message.text));
+    }
+    writer.written.fetch_add(messages.size(), std::memory_order_release);
+}
+
+/**
+ * The writer thread regularly drains the message buffers of all threads. Disabling the asynchronous mode stops the writer
+ * and writes all messages still pending before returning.
+ */
+void DefaultLogger::setAsynchronous(bool asynchronous) {
+    auto& writer = get_writer();
+    if(asynchronous == writer.active.load()) {
+        return;
+    }
+
+    if(asynchronous) {
+        writer.stop.store(false);
+        writer.thread = std::thread([&writer]() {
+            while(!writer.stop.load(std::memory_order_acquire)) {
+                auto written = writer.written.load(std::memory_order_relaxed);
+                drain_messages();
+                if(written == writer.written.load(std::memory_order_relaxed)) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+        });
+        writer.active.store(true, std::memory_order_release);
+    } else {
+        writer.active.store(false, std::memory_order_release);
+        writer.stop.store(true, std::memory_order_release);
+        writer.thread.join();
+        drain_messages();
+    }
+}
+bool DefaultLogger::isAsynchronous() {
+    return get_writer().active.load(std::memory_order_acquire);
+}
+
 /**
  * @warning No other log message should be send after this method
  * @note Does not close the streams
  */
 void DefaultLogger::finish() {
+    // Stop the background writer and write all pending messages
+    setAsynchronous(false);
+
     // Lock the mutex to guard output writing
     std::lock_guard<std::mutex> lock(write_mutex_);
 
@@ -374,8 +576,8 @@ std::string& DefaultLogger::get_section() {
     thread_local std::string section;
     return section;
 }
-void DefaultLogger::setSection(std::string section) {
-    get_section() = std::move(section);
+void DefaultLogger::setSection(const std::string& section) {
+    get_section() = section;
 }
 std::string DefaultLogger::getSection() {
     return get_section();
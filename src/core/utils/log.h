@@ -112,6 +112,23 @@ namespace allpix {
          */
         static void finish();
 
+        /**
+         * @brief Enable or disable writing the log messages asynchronously
+         * @param asynchronous If messages should be written by a background thread
+         *
+         * In asynchronous mode every thread formats its messages and hands them to a background writer through a buffer
+         * private to the thread, such that logging does not require any lock. The messages of all threads are written in
+         * the order they were logged. Disabling the asynchronous mode writes all pending messages before returning.
+         *
+         * @warning Streams should not be added or removed while messages are written asynchronously
+         */
+        static void setAsynchronous(bool asynchronous);
+        /**
+         * @brief Check if the log messages are written asynchronously
+         * @return True if a background thread writes the messages, false otherwise
+         */
+        static bool isAsynchronous();
+
         /**
          * @brief Get the reporting level for logging
          * @return The current log level
@@ -178,8 +195,9 @@ namespace allpix {
         /**
          * @brief Set the section header to use from now on
          * @param header Header to use
+         * @note The header is copied into the existing buffer of the thread to avoid reallocating it on every change
          */
-        static void setSection(std::string header);
+        static void setSection(const std::string& header);
         /**
          * @brief Get the current section header
          * @return Header used
@@ -210,6 +228,17 @@ namespace allpix {
          */
         static bool is_terminal(std::ostream& stream);
 
+        /**
+         * @brief Write a formatted message to all streams
+         * @param identifier Identifier of a progress message or empty for a normal message
+         * @param out Formatted message
+         */
+        static void write_message(const std::string& identifier, std::string out);
+        /**
+         * @brief Write all messages pending in the buffers of the asynchronous mode
+         */
+        static void drain_messages();
+
         // Output stream
         std::ostringstream os;
 
@@ -242,18 +271,35 @@ namespace allpix {
 #define __FILE_NAME__ (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILE__)
 #endif
 
+#ifndef ALLPIX_LOG_LEVEL_MAXIMUM
+/**
+ * @brief Most verbose log level compiled into the code, messages of more verbose levels are removed by the compiler
+ */
+#define ALLPIX_LOG_LEVEL_MAXIMUM PRNG
+#endif
+
+/**
+ * @brief Check if messages of a level are compiled in and the reporting level is high enough
+ * @param level The log level to check
+ *
+ * The arguments of a log message are only evaluated if this check passes, such that disabled levels only cost a branch.
+ */
+#define LOG_ENABLED(level)                                                                                                  \
+    (allpix::LogLevel::level <= allpix::LogLevel::ALLPIX_LOG_LEVEL_MAXIMUM &&                                               \
+     allpix::LogLevel::level <= allpix::Log::getReportingLevel() && !allpix::Log::getStreams().empty())
+
 /**
  * @brief Execute a block only if the reporting level is high enough
  * @param level The minimum log level
  */
-#define IFLOG(level) if(allpix::LogLevel::level <= allpix::Log::getReportingLevel() && !allpix::Log::getStreams().empty())
+#define IFLOG(level) if(LOG_ENABLED(level))
 
 /**
  * @brief Create a logging stream if the reporting level is high enough
  * @param level The log level of the stream
  */
 #define LOG(level)                                                                                                          \
-    if(allpix::LogLevel::level <= allpix::Log::getReportingLevel() && !allpix::Log::getStreams().empty())                   \
+    if(LOG_ENABLED(level))                                                                                                  \
     allpix::Log().getStream(                                                                                                \
         allpix::LogLevel::level, __FILE_NAME__, std::string(static_cast<const char*>(__func__)), __LINE__)
 
@@ -263,7 +309,7 @@ namespace allpix {
  * @param identifier Identifier for this stream to determine overwrites
  */
 #define LOG_PROGRESS(level, identifier)                                                                                     \
-    if(allpix::LogLevel::level <= allpix::Log::getReportingLevel() && !allpix::Log::getStreams().empty())                   \
+    if(LOG_ENABLED(level))                                                                                                  \
     allpix::Log().getProcessStream(                                                                                         \
         identifier, allpix::LogLevel::level, __FILE_NAME__, std::string(static_cast<const char*>(__func__)), __LINE__)
 
@@ -290,7 +336,7 @@ namespace allpix {
 #define LOG_N(level, max_log_count)                                                                                         \
     GENERATE_LOG_VAR(max_log_count);                                                                                        \
     if(GET_LOG_VARIABLE(max_log_count) > 0)                                                                                 \
-        if(allpix::LogLevel::level <= allpix::Log::getReportingLevel() && !allpix::Log::getStreams().empty())               \
+        if(LOG_ENABLED(level))                                                                                              \
     allpix::Log().getStream(                                                                                                \
         allpix::LogLevel::level, __FILE_NAME__, std::string(static_cast<const char*>(__func__)), __LINE__)                  \
         << std::string(--GET_LOG_VARIABLE(max_log_count) == 0 ? "[further messages suppressed] " : "")
@@ -0,0 +1,167 @@
+/**
+ * @file
+ * @brief Implementation of thread pinning and NUMA node placement
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "numa.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace allpix;
+
+namespace {
+    // Cores of every node available to this process
+    using Topology = std::vector<std::vector<unsigned int>>;
+
+    thread_local size_t thread_node = 0;
+    std::atomic_bool replication{false};
+
+    /**
+     * @brief Parse a list of cores in the sysfs format, e.g. "0-3,8,10-11"
+     */
+    std::vector<unsigned int> parse_cpu_list(const std::string& list) {
+        std::vector<unsigned int> cpus;
+        std::stringstream stream(list);
+        std::string range;
+        while(std::getline(stream, range, ',')) {
+            auto dash = range.find('-');
+            try {
+                auto first = static_cast<unsigned int>(std::stoul(range.substr(0, dash)));
+                auto last = first;
+                if(dash != std::string::npos) {
+                    last = static_cast<unsigned int>(std::stoul(range.substr(dash + 1)));
+                }
+                for(auto cpu = first; cpu <= last; ++cpu) {
+                    cpus.push_back(cpu);
+                }
+            } catch(std::logic_error&) {
+                continue;
+            }
+        }
+        return cpus;
+    }
+
+    /**
+     * Nodes without cores available to this process, e.g. memory-only nodes or nodes excluded by the affinity mask the
+     * process has been started with, are skipped.
+     */
+    Topology read_topology() {
+        Topology topology;
+#ifdef __linux__
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+            return {{}};
+        }
+        for(size_t node = 0;; ++node) {
+            std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            if(!file.good()) {
+                break;
+            }
+            std::string list;
+            std::getline(file, list);
+            auto cpus = parse_cpu_list(list);
+            cpus.erase(std::remove_if(cpus.begin(),
+                                      cpus.end(),
+                                      [&](auto cpu) { return cpu >= CPU_SETSIZE || CPU_ISSET(cpu, &allowed) == 0; }),
+                       cpus.end());
+            if(!cpus.empty()) {
+                topology.push_back(std::move(cpus));
+            }
+        }
+        if(topology.empty()) {
+            // Treat all available cores as a single node if the topology is not known
+            std::vector<unsigned int> cpus;
+            for(unsigned int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if(CPU_ISSET(cpu, &allowed) != 0) {
+                    cpus.push_back(cpu);
+                }
+            }
+            topology.push_back(std::move(cpus));
+        }
+#else
+        topology.emplace_back();
+#endif
+        return topology;
+    }
+
+    const Topology& get_topology() {
+        static const Topology topology = read_topology();
+        return topology;
+    }
+
+    bool set_affinity(const std::vector<unsigned int>& cpus) {
+#ifdef __linux__
+        if(cpus.empty()) {
+            return false;
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for(auto cpu : cpus) {
+            CPU_SET(cpu, &set);
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)cpus;
+        return false;
+#endif
+    }
+} // namespace
+
+size_t numa::node_count() { return get_topology().size(); }
+
+size_t numa::current_node() { return thread_node; }
+
+bool numa::pin_thread(size_t worker) {
+    const auto& topology = get_topology();
+    auto node = worker % topology.size();
+    const auto& cpus = topology[node];
+    if(cpus.empty() || !set_affinity({cpus[(worker / topology.size()) % cpus.size()]})) {
+        return false;
+    }
+    thread_node = node;
+    return true;
+}
+
+/**
+ * The function is executed on a separate thread, such that the affinity of the calling thread is not changed. Exceptions
+ * thrown by the function are propagated to the caller.
+ */
+void numa::run_on_node(size_t node, const std::function<void()>& function) {
+    std::exception_ptr exception;
+    std::thread thread([&]() {
+        try {
+            if(set_affinity(get_topology().at(node))) {
+                thread_node = node;
+            }
+            function();
+        } catch(...) {
+            exception = std::current_exception();
+        }
+    });
+    thread.join();
+    if(exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+void numa::set_replication(bool enable) { replication = enable; }
+
+bool numa::replication_enabled() { return replication && node_count() > 1; }
@@ -0,0 +1,59 @@
+/**
+ * @file
+ * @brief Pinning of threads to cores and placement of memory on NUMA nodes
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ *
+ * The topology is read from sysfs, such that no additional library is required. On systems without this information all
+ * cores are treated as a single node and pinning is not available.
+ */
+
+#ifndef ALLPIX_NUMA_H
+#define ALLPIX_NUMA_H
+
+#include <cstddef>
+#include <functional>
+
+namespace allpix::numa {
+    /**
+     * @brief Number of NUMA nodes with cores available to this process
+     * @return Number of nodes, at least one
+     */
+    size_t node_count();
+
+    /**
+     * @brief Node of the calling thread
+     * @return Node the thread is pinned to, zero for threads which are not pinned
+     */
+    size_t current_node();
+
+    /**
+     * @brief Pin the calling thread to a single core
+     * @param worker Index of the worker, consecutive workers are distributed alternately over the nodes
+     * @return True if the thread has been pinned
+     */
+    bool pin_thread(size_t worker);
+
+    /**
+     * @brief Execute a function on a thread bound to the cores of a node
+     * @param node Node to execute the function on
+     * @param function Function to execute, memory first written by it is placed on the node
+     */
+    void run_on_node(size_t node, const std::function<void()>& function);
+
+    /**
+     * @brief Enable or disable the replication of large read-only data on every node
+     * @param enable True to replicate data, only effective with more than one node
+     */
+    void set_replication(bool enable);
+
+    /**
+     * @brief Check if large read-only data should be replicated on every node
+     * @return True if replication is enabled and the system has more than one node
+     */
+    bool replication_enabled();
+} // namespace allpix::numa
+
+#endif /* ALLPIX_NUMA_H */
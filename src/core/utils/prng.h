@@ -1,6 +1,6 @@
 /**
  * @file
- * @brief Provides a wrapper around the STL pseudo-random number generator Mersenne Twister
+ * @brief Provides a wrapper around the pseudo-random number engines used in the framework
  * @copyright Copyright (c) 2017-2020 CERN and the Allpix Squared authors.
  * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
  * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
@@ -12,44 +12,313 @@
 
 #include "core/utils/log.h"
 
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <ostream>
 #include <random>
+#include <utility>
+#include <variant>
 
 namespace allpix {
 
     /**
-     * @brief Wrapper around the STL's Mersenne Twister
+     * @brief Counter-based pseudo-random number engine Philox4x32-10
+     *
+     * The engine encrypts a 128-bit counter with a 64-bit key in ten rounds, as described in "Parallel random numbers: as
+     * easy as 1, 2, 3" by J. Salmon et al. The key is given by the seed and the upper half of the counter selects an
+     * independent stream, such that seeding and splitting into substreams is trivial and the state is only a few bytes.
+     * Every encrypted block provides two 64-bit numbers.
      */
-    class RandomNumberGenerator : public std::mt19937_64 {
+    class PhiloxEngine {
     public:
+        using result_type = std::uint_fast64_t;
+
+        /**
+         * @brief Construct the engine
+         * @param seed Seed used as key of the engine
+         * @param stream Index of the stream to generate
+         */
+        explicit PhiloxEngine(std::uint64_t seed = 0, std::uint64_t stream = 0) { this->seed(seed, stream); }
+
+        /**
+         * @brief Seed the engine, restarting at the beginning of a stream
+         * @param seed Seed used as key of the engine
+         * @param stream Index of the stream to generate
+         */
+        void seed(std::uint64_t seed, std::uint64_t stream = 0) {
+            key_ = {static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)};
+            counter_ = {0, 0, static_cast<std::uint32_t>(stream), static_cast<std::uint32_t>(stream >> 32)};
+            index_ = output_.size();
+        }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<std::uint64_t>::max(); }
+
+        /**
+         * @brief Generate the next number of the stream
+         * @return 64-bit pseudo-random number
+         */
+        result_type operator()() {
+            if(index_ == output_.size()) {
+                generate_block();
+            }
+            return output_[index_++];
+        }
+
+        /**
+         * @brief Advance the stream without generating the skipped numbers
+         * @param count Number of values to skip
+         */
+        void discard(unsigned long long count) {
+            for(; count > 0 && index_ < output_.size(); --count) {
+                ++index_;
+            }
+            increment_counter(count / output_.size());
+            if(count % output_.size() != 0) {
+                generate_block();
+                index_ = count % output_.size();
+            }
+        }
+
+        bool operator==(const PhiloxEngine& other) const {
+            return key_ == other.key_ && counter_ == other.counter_ && index_ == other.index_ &&
+                   (index_ == output_.size() || output_ == other.output_);
+        }
+        bool operator!=(const PhiloxEngine& other) const { return !(*this == other); }
+
         /// @{
+        /**
+         * @brief Write or read the state of the engine in text form
+         */
+        friend std::ostream& operator<<(std::ostream& os, const PhiloxEngine& engine) {
+            os << engine.key_[0] << ' ' << engine.key_[1];
+            for(auto word : engine.counter_) {
+                os << ' ' << word;
+            }
+            return os << ' ' << engine.output_[0] << ' ' << engine.output_[1] << ' ' << engine.index_;
+        }
+        friend std::istream& operator>>(std::istream& is, PhiloxEngine& engine) {
+            is >> engine.key_[0] >> engine.key_[1];
+            for(auto& word : engine.counter_) {
+                is >> word;
+            }
+            return is >> engine.output_[0] >> engine.output_[1] >> engine.index_;
+        }
+        /// @}
+
+    private:
+        /**
+         * @brief Encrypt the current counter into the output block and advance the counter
+         */
+        void generate_block() {
+            auto counter = counter_;
+            auto key = key_;
+            for(int round = 0; round < 10; ++round) {
+                if(round > 0) {
+                    key[0] += 0x9E3779B9;
+                    key[1] += 0xBB67AE85;
+                }
+                auto product0 = std::uint64_t(0xD2511F53) * counter[0];
+                auto product1 = std::uint64_t(0xCD9E8D57) * counter[2];
+                counter = {static_cast<std::uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+                           static_cast<std::uint32_t>(product1),
+                           static_cast<std::uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+                           static_cast<std::uint32_t>(product0)};
+            }
+            output_ = {counter[0] | (std::uint64_t(counter[1]) << 32), counter[2] | (std::uint64_t(counter[3]) << 32)};
+            index_ = 0;
+            increment_counter(1);
+        }
+
+        /**
+         * @brief Advance the lower half of the counter, which indexes the blocks within a stream
+         */
+        void increment_counter(std::uint64_t blocks) {
+            auto position = (counter_[0] | (std::uint64_t(counter_[1]) << 32)) + blocks;
+            counter_[0] = static_cast<std::uint32_t>(position);
+            counter_[1] = static_cast<std::uint32_t>(position >> 32);
+        }
+
+        std::array<std::uint32_t, 2> key_{};
+        std::array<std::uint32_t, 4> counter_{};
+        std::array<std::uint64_t, 2> output_{};
+        size_t index_{};
+    };
+
+    /**
+     * @brief Pseudo-random number generator of the framework
+     *
+     * By default the generator uses the STL's Mersenne Twister, such that earlier simulations can be reproduced exactly. The
+     * counter-based \ref PhiloxEngine can be selected instead, which has a state of a few bytes and is seeded at negligible
+     * cost. It also provides independent substreams for the same seed, which are useful to split the work of an event.
+     */
+    class RandomNumberGenerator {
+    public:
+        using result_type = std::uint_fast64_t;
+
+        /**
+         * @brief Engines available to generate the pseudo-random numbers
+         */
+        enum class Engine {
+            MERSENNE_TWISTER = 0, ///< 64-bit Mersenne Twister std::mt19937_64
+            PHILOX,               ///< Counter-based Philox4x32-10 engine
+        };
+
+        /**
+         * @brief Construct a generator
+         * @param engine Engine to generate the numbers with
+         */
+        explicit RandomNumberGenerator(Engine engine = Engine::MERSENNE_TWISTER) {
+            if(engine == Engine::PHILOX) {
+                engine_.emplace<PhiloxEngine>();
+            }
+        }
+
+        /// @{
+        /**
+         * @brief Copying a generator duplicates its state
+         */
+        RandomNumberGenerator(const RandomNumberGenerator&) = default;
+        RandomNumberGenerator(RandomNumberGenerator&&) = default;
+        /// @}
+
+        /**
+         * @brief Binary state of the generator, holding the selected engine by value
+         */
+        using State = std::variant<std::mt19937_64, PhiloxEngine>;
+
         /**
          * @brief Disallow copy-assignment
          */
         RandomNumberGenerator& operator=(const RandomNumberGenerator&) = delete;
 
-        /// @{
         /**
          * @brief Disallow move assignment
          */
         RandomNumberGenerator& operator=(RandomNumberGenerator&&) = delete;
 
         /**
-         * Redefine function operator to retrieve pseudo-random numbers. This allows us to log the number at retrieval.
-         * Technically we are shadowing the base class operator since it is non-virtual and explicitly call it from within.
+         * @brief Get the engine used by the generator
+         * @return Engine of the generator
+         */
+        Engine getEngine() const {
+            return std::holds_alternative<PhiloxEngine>(engine_) ? Engine::PHILOX : Engine::MERSENNE_TWISTER;
+        }
+
+        /**
+         * @brief Seed the generator
+         * @param seed Seed to use
+         */
+        void seed(std::uint64_t seed) {
+            if(auto* philox = std::get_if<PhiloxEngine>(&engine_)) {
+                philox->seed(seed);
+            } else {
+                std::get<std::mt19937_64>(engine_).seed(seed);
+            }
+        }
+
+        /**
+         * @brief Seed the generator to generate one of several independent streams for the same seed
+         * @param seed Seed to use
+         * @param stream Index of the stream
+         *
+         * The Philox engine selects the stream directly from its counter. The Mersenne Twister is seeded with a seed
+         * sequence of both values instead, which requires a full reinitialization of its state.
+         */
+        void seed(std::uint64_t seed, std::uint64_t stream) {
+            if(auto* philox = std::get_if<PhiloxEngine>(&engine_)) {
+                philox->seed(seed, stream);
+            } else {
+                std::seed_seq sequence{static_cast<std::uint32_t>(seed),
+                                       static_cast<std::uint32_t>(seed >> 32),
+                                       static_cast<std::uint32_t>(stream),
+                                       static_cast<std::uint32_t>(stream >> 32)};
+                std::get<std::mt19937_64>(engine_).seed(sequence);
+            }
+        }
+
+        /**
+         * @brief Advance the generator by a number of values
+         * @param count Number of values to skip
+         */
+        void discard(unsigned long long count) {
+            std::visit([count](auto& engine) { engine.discard(count); }, engine_);
+        }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<std::uint64_t>::max(); }
+
+        /**
+         * @brief Call a function with the underlying engine, to generate many numbers without dispatching every single one
+         * @param function Function invoked with a reference to the selected engine
+         * @return Return value of the function
+         * @warning Numbers drawn from the engine directly are not logged, callers should check the PRNG log level first
+         */
+        template <typename Function> decltype(auto) visit(Function&& function) {
+            return std::visit(std::forward<Function>(function), engine_);
+        }
+
+        /**
+         * Function operator to retrieve pseudo-random numbers. This allows us to log the number at retrieval.
          *
          * @return 64-bit pseudo-random number
          */
-        std::uint_fast64_t operator()() {
+        result_type operator()() {
             // Only copy if we want to log it
             IFLOG(PRNG) {
-                auto prn = std::mt19937_64::operator()();
+                auto prn = generate();
                 LOG(PRNG) << "Using random number " << prn;
                 return prn;
             }
             else {
-                return std::mt19937_64::operator()();
+                return generate();
             }
         }
+
+        /// @{
+        /**
+         * @brief Save or restore the engine and its state in binary form
+         *
+         * The state is copied without any formatting or allocation, which makes it cheap to store the state of events
+         * whenever they are suspended. A state object can be reused for any number of snapshots.
+         */
+        void saveState(State& state) const { state = engine_; }
+        void restoreState(const State& state) { engine_ = state; }
+        /// @}
+
+        /// @{
+        /**
+         * @brief Write or read the engine and its state in text form
+         */
+        friend std::ostream& operator<<(std::ostream& os, const RandomNumberGenerator& generator) {
+            os << static_cast<int>(generator.getEngine()) << ' ';
+            std::visit([&os](const auto& engine) { os << engine; }, generator.engine_);
+            return os;
+        }
+        friend std::istream& operator>>(std::istream& is, RandomNumberGenerator& generator) {
+            int type = 0;
+            is >> type;
+            if(static_cast<Engine>(type) == Engine::PHILOX) {
+                generator.engine_.emplace<PhiloxEngine>();
+            } else {
+                generator.engine_.emplace<std::mt19937_64>();
+            }
+            std::visit([&is](auto& engine) { is >> engine; }, generator.engine_);
+            return is;
+        }
+        /// @}
+
+    private:
+        result_type generate() {
+            if(auto* philox = std::get_if<PhiloxEngine>(&engine_)) {
+                return (*philox)();
+            }
+            return std::get<std::mt19937_64>(engine_)();
+        }
+
+        State engine_;
     };
 } // namespace allpix
 
@@ -0,0 +1,105 @@
+/**
+ * @file
+ * @brief Annotation of the execution with zones of an external profiler such as Tracy or Intel VTune
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ *
+ * The profiler is selected at configuration time with the CMake option PROFILER_ZONES. Without a profiler, the zones are
+ * removed by the preprocessor and have no cost at all.
+ */
+
+#ifndef ALLPIX_PROFILING_H
+#define ALLPIX_PROFILING_H
+
+#include <string>
+
+#if defined(ALLPIX_PROFILER_TRACY)
+#include <tracy/Tracy.hpp>
+#elif defined(ALLPIX_PROFILER_ITT)
+#include <ittnotify.h>
+#endif
+
+// Helpers to create a unique variable name for every zone
+#define ALLPIX_PROFILE_CONCAT_IMPL(a, b) a##b
+#define ALLPIX_PROFILE_CONCAT(a, b) ALLPIX_PROFILE_CONCAT_IMPL(a, b)
+
+#if defined(ALLPIX_PROFILER_TRACY)
+
+/**
+ * @brief Annotate the remainder of the current scope as zone with a fixed name
+ * @param name String literal naming the zone
+ */
+#define ALLPIX_PROFILE_ZONE(name) ZoneScopedN(name)
+
+/**
+ * @brief Annotate the remainder of the current scope as zone, named after a string known only at runtime
+ * @param name String literal naming the zone if the profiler does not support runtime names
+ * @param text String with the runtime name of the zone, e.g. the unique name of a module
+ */
+#define ALLPIX_PROFILE_ZONE_NAMED(name, text)                                                                               \
+    ZoneScopedN(name);                                                                                                      \
+    ZoneName((text).c_str(), (text).size())
+
+#elif defined(ALLPIX_PROFILER_ITT)
+
+namespace allpix::profiling {
+    /**
+     * @brief Domain of all tasks of the framework
+     */
+    inline __itt_domain* domain() {
+        static __itt_domain* domain = __itt_domain_create("allpix");
+        return domain;
+    }
+
+    /**
+     * @brief Task of the ITT API spanning the lifetime of this object
+     */
+    class Zone {
+    public:
+        /**
+         * @brief Begin a task
+         * @param handle Handle of the name of the task
+         */
+        explicit Zone(__itt_string_handle* handle) { __itt_task_begin(domain(), __itt_null, __itt_null, handle); }
+
+        /**
+         * @brief Begin a task with a name only known at runtime
+         * @param name Name of the task
+         */
+        explicit Zone(const std::string& name) : Zone(__itt_string_handle_create(name.c_str())) {}
+
+        /**
+         * @brief End the task
+         */
+        ~Zone() { __itt_task_end(domain()); }
+
+        /// @{
+        /**
+         * @brief Copying or moving a zone is not allowed
+         */
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+        Zone(Zone&&) = delete;
+        Zone& operator=(Zone&&) = delete;
+        /// @}
+    };
+} // namespace allpix::profiling
+
+// The handle of a fixed name is only created once per annotated scope
+#define ALLPIX_PROFILE_ZONE(name)                                                                                           \
+    static __itt_string_handle* ALLPIX_PROFILE_CONCAT(allpix_handle_, __LINE__) =                                          \
+        __itt_string_handle_create(name);                                                                                   \
+    allpix::profiling::Zone ALLPIX_PROFILE_CONCAT(allpix_zone_, __LINE__)(ALLPIX_PROFILE_CONCAT(allpix_handle_, __LINE__))
+
+#define ALLPIX_PROFILE_ZONE_NAMED(name, text) allpix::profiling::Zone ALLPIX_PROFILE_CONCAT(allpix_zone_, __LINE__)(text)
+
+#else
+
+#define ALLPIX_PROFILE_ZONE(name)
+#define ALLPIX_PROFILE_ZONE_NAMED(name, text)
+
+#endif
+
+#endif /* ALLPIX_PROFILING_H */
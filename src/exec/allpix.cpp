@@ -11,6 +11,7 @@
 #include <atomic>
 #include <csignal>
 #include <cstdlib>
+#include <filesystem>
 #include <fstream>
 #include <memory>
 #include <string>
@@ -153,6 +154,23 @@ int main(int argc, const char* argv[]) {
             }
         } else if(arg == "-g" && (i + 1 < argc)) {
             detector_options.emplace_back(std::string(argv[++i]));
+        } else if(arg == "-p" && (i + 1 < argc)) {
+            // Split the partition given as index/count into the framework parameters
+            std::string partition = argv[++i];
+            auto separator = partition.find('/');
+            if(separator == std::string::npos) {
+                LOG(ERROR) << "Invalid partition \"" << partition << "\", expected <index>/<count>";
+                print_help = true;
+                return_code = 1;
+            } else {
+                module_options.emplace_back("partition=" + partition.substr(0, separator));
+                module_options.emplace_back("partitions=" + partition.substr(separator + 1));
+            }
+        } else if(arg == "-r" && (i + 1 < argc)) {
+            // Resolve the checkpoint relative to the current directory, since relative paths of options are resolved
+            // relative to the configuration file
+            module_options.emplace_back("resume_checkpoint=\"" +
+                                        std::filesystem::absolute(std::string(argv[++i])).string() + "\"");
         } else {
             LOG(ERROR) << "Unrecognized command line argument \"" << argv[i] << "\"";
             print_help = true;
@@ -175,6 +193,9 @@ int main(int argc, const char* argv[]) {
         std::cout << "  -v <level>   verbosity level, overwriting the global level" << std::endl;
         std::cout << "  -j <workers> number of worker threads, equivalent to" << std::endl;
         std::cout << "               -o multithreading=true -o workers=<workers>" << std::endl;
+        std::cout << "  -r <file>    resume the run from a checkpoint file" << std::endl;
+        std::cout << "  -p <i>/<n>   process only partition i of n of the events, equivalent to" << std::endl;
+        std::cout << "               -o partition=<i> -o partitions=<n>" << std::endl;
         std::cout << "  --version    print version information and quit" << std::endl;
         std::cout << std::endl;
         std::cout << "For more help, please see <https://cern.ch/allpix-squared>" << std::endl;
@@ -9,6 +9,12 @@
 
 #include "CSADigitizerModule.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <functional>
+#include <limits>
+
 #include "core/utils/distributions.h"
 #include "core/utils/unit.h"
 #include "tools/ROOT.h"
@@ -37,8 +43,12 @@ CSADigitizerModule::CSADigitizerModule(Configuration& config, Messenger* messeng
     config_.setDefault<double>("integration_time", Units::get(500, "ns"));
     config_.setDefault<double>("threshold", Units::get(10e-3, "V"));
     config_.setDefault<bool>("ignore_polarity", false);
+    config_.setDefault<bool>("truncate_pulse", false);
 
     config_.setDefault<double>("sigma_noise", Units::get(1e-4, "V"));
+    config_.setDefault<size_t>("noise_library_size", 0);
+    config_.setDefault<double>("noise_corner_frequency", 0.);
+    config_.setDefault<double>("noise_spectrum_exponent", 1.);
 
     config_.setDefault<bool>("output_pulsegraphs", false);
     config_.setDefault<bool>("output_plots", config_.get<bool>("output_pulsegraphs"));
@@ -75,6 +85,12 @@ CSADigitizerModule::CSADigitizerModule(Configuration& config, Messenger* messeng
     }
 
     sigmaNoise_ = config_.get<double>("sigma_noise");
+    noise_library_size_ = config_.get<size_t>("noise_library_size");
+    noise_corner_frequency_ = config_.get<double>("noise_corner_frequency");
+    noise_spectrum_exponent_ = config_.get<double>("noise_spectrum_exponent");
+    if(noise_corner_frequency_ < 0) {
+        throw InvalidValueError(config_, "noise_corner_frequency", "corner frequency of the noise cannot be negative");
+    }
     threshold_ = config_.get<double>("threshold");
     ignore_polarity_ = config.get<bool>("ignore_polarity");
 
@@ -155,6 +171,17 @@ CSADigitizerModule::CSADigitizerModule(Configuration& config, Messenger* messeng
     output_plots_ = config_.get<bool>("output_plots");
     output_pulsegraphs_ = config_.get<bool>("output_pulsegraphs");
 
+    // The truncated pulse is only sufficient for the ToT, not for the pulse integral or the pulse graphs
+    truncate_pulse_ = config_.get<bool>("truncate_pulse");
+    if(truncate_pulse_ && !store_tot_) {
+        throw InvalidCombinationError(
+            config_, {"truncate_pulse", "clock_bin_tot"}, "truncating the pulse requires the ToT to be stored");
+    }
+    if(truncate_pulse_ && output_pulsegraphs_) {
+        throw InvalidCombinationError(
+            config_, {"truncate_pulse", "output_pulsegraphs"}, "pulse graphs cannot be created from truncated pulses");
+    }
+
     // Enable multithreading of this module if multithreading is enabled and no per-event output plots are requested:
     // FIXME: Review if this is really the case or we can still use multithreading
     if(!output_pulsegraphs_) {
@@ -165,6 +192,19 @@ CSADigitizerModule::CSADigitizerModule(Configuration& config, Messenger* messeng
 }
 
 void CSADigitizerModule::initialize() {
+    // Per-pixel calibration of noise, gain and threshold, replacing the values common to all pixels:
+    noise_map_ = load_calibration_map("sigma_noise_map", "V");
+    gain_map_ = load_calibration_map("gain_map", "");
+    threshold_map_ = load_calibration_map("threshold_map", "V");
+
+    // The noise library only depends on the seed of the run and the detector, not on the order in which events are processed
+    if(noise_library_size_ > 0) {
+        auto& global_config = getConfigManager()->getGlobalConfiguration();
+        noise_seed_ = global_config.get<uint64_t>("random_seed") ^ std::hash<std::string>()(getUniqueName());
+        LOG(DEBUG) << "Using library of at least " << noise_library_size_ << " noise samples with corner frequency "
+                   << Units::display(noise_corner_frequency_, "/us") << " and spectral exponent "
+                   << noise_spectrum_exponent_;
+    }
 
     // Check for sensible configuration of threshold:
     if(ignore_polarity_ && threshold_ < 0) {
@@ -208,6 +248,8 @@ void CSADigitizerModule::run(Event* event) {
 
     // Loop through all pixels with charges
     std::vector<PixelHit> hits;
+    std::shared_ptr<const ImpulseResponse> impulse_response;
+    double impulse_response_binning = 0;
     for(const auto& pixel_charge : pixel_message->getData()) {
         auto pixel = pixel_charge.getPixel();
         auto pixel_index = pixel.getIndex();
@@ -221,98 +263,135 @@ void CSADigitizerModule::run(Event* event) {
             throw ModuleError("No pulse information available.");
         }
 
-        auto pulse_vec = pulse.getPulse(); // the vector of the charges
+        const auto& pulse_vec = pulse.getPulse(); // the vector of the charges
         auto timestep = pulse.getBinning();
         LOG(DEBUG) << "Timestep: " << timestep << " integration_time: " << integration_time_;
-        auto ntimepoints = static_cast<size_t>(ceil(integration_time_ / timestep));
-
-        std::call_once(first_event_flag_, [&]() {
-            // initialize impulse response function - assume all time bins are equal
-            impulse_response_function_.reserve(ntimepoints);
-            for(size_t itimepoint = 0; itimepoint < ntimepoints; ++itimepoint) {
-                impulse_response_function_.push_back(
-                    calculate_impulse_response_->Eval(timestep * static_cast<double>(itimepoint)));
-            }
-
-            if(output_plots_) {
-                // Generate x-axis:
-                std::vector<double> time(impulse_response_function_.size());
-                // clang-format off
-                std::generate(time.begin(), time.end(), [n = 0.0, timestep]() mutable {  auto now = n; n += timestep; return now; });
-                // clang-format on
-
-                auto* response_graph = new TGraph(
-                    static_cast<int>(impulse_response_function_.size()), &time[0], &impulse_response_function_[0]);
-                response_graph->GetXaxis()->SetTitle("t [ns]");
-                response_graph->GetYaxis()->SetTitle("amp. response");
-                response_graph->SetTitle("Amplifier response function");
-                getROOTDirectory()->WriteTObject(response_graph, "response_function");
-            }
 
-            LOG(INFO) << "Initialized impulse response with timestep " << Units::display(timestep, {"ps", "ns", "us"})
-                      << " and integration time " << Units::display(integration_time_, {"ns", "us", "ms"})
-                      << ", samples: " << ntimepoints;
-        });
+        // Look up the impulse response for the binning of the pulse, usually identical for all pulses of the event
+        if(impulse_response == nullptr || timestep != impulse_response_binning) {
+            impulse_response = get_impulse_response(timestep);
+            impulse_response_binning = timestep;
+        }
+        const auto& impulse_response_function = impulse_response->samples;
+        auto ntimepoints = impulse_response_function.size();
 
-        std::vector<double> amplified_pulse_vec(ntimepoints);
-        auto input_length = pulse_vec.size();
+        auto input_length = std::min(pulse_vec.size(), ntimepoints);
         LOG(TRACE) << "Preparing pulse for pixel " << pixel_index << ", " << pulse_vec.size() << " bins of "
                    << Units::display(timestep, {"ps", "ns"}) << ", total charge: " << Units::display(pulse.getCharge(), "e");
-        // convolution of the pulse (size input_length) with the impulse response (size ntimepoints)
-        for(size_t k = 0; k < ntimepoints; ++k) {
+
+        // Direct convolution of the pulse (size input_length) with the impulse response (size ntimepoints) for one bin
+        auto convolve_bin = [&](size_t k) {
             double outsum{};
-            // convolution: multiply pulse_vec.at(k - i) * impulse_response_function_.at(i), when (k - i) < input_length
+            // convolution: multiply pulse_vec[k - i] * impulse_response_function[i], when (k - i) < input_length
             // -> no point to start i at 0, start from jmin:
             size_t jmin = (k >= input_length - 1) ? k - (input_length - 1) : 0;
             for(size_t i = jmin; i <= k; ++i) {
                 if((k - i) < input_length) {
-                    outsum += pulse_vec.at(k - i) * impulse_response_function_.at(i);
+                    outsum += pulse_vec[k - i] * impulse_response_function[i];
                 }
             }
-            amplified_pulse_vec.at(k) = outsum;
+            return outsum;
+        };
+
+        // The fast Fourier transform is used for the convolution of long pulses
+        std::vector<double> amplified_pulse_vec;
+        if(impulse_response->convolution.isEfficient(input_length)) {
+            amplified_pulse_vec = impulse_response->convolution.convolve(pulse_vec);
         }
 
-        if(output_pulsegraphs_) {
-            // Fill a graph with the pulse:
-            create_output_pulsegraphs(std::to_string(event->number),
-                                      std::to_string(pixel_index.x()) + "-" + std::to_string(pixel_index.y()),
-                                      "amp_pulse",
-                                      "Amplifier signal without noise",
-                                      timestep,
-                                      amplified_pulse_vec);
+        auto sigma_noise = noise_map_.get(pixel_index, sigmaNoise_);
+        allpix::normal_distribution<double> pulse_smearing(0, sigma_noise);
+
+        // Noise of a bin, either drawn for every bin or read from a window of the noise library starting at a random offset
+        const auto& noise_library = impulse_response->noise;
+        size_t noise_offset = 0;
+        if(!noise_library.empty()) {
+            allpix::uniform_int_distribution<size_t> offset_distribution(0, noise_library.size() - 1);
+            noise_offset = offset_distribution(event->getRandomEngine());
         }
+        auto noise = [&](size_t k) {
+            if(noise_library.empty()) {
+                return pulse_smearing(event->getRandomEngine());
+            }
+            return sigma_noise * noise_library[(noise_offset + k) & (noise_library.size() - 1)];
+        };
+
+        auto threshold = threshold_map_.get(pixel_index, threshold_);
+        PulseEvaluation evaluation(*this, timestep, threshold);
+
+        if(truncate_pulse_) {
+            // Amplify the pulse and add the noise bin by bin, only until the signal is back below the threshold
+            LOG(TRACE) << "Adding electronics noise with sigma = " << Units::display(sigma_noise, {"mV", "V"})
+                       << " until the end of the time-over-threshold";
+            auto gain = gain_map_.get(pixel_index, 1.);
+            auto nbins = (amplified_pulse_vec.empty() ? ntimepoints : amplified_pulse_vec.size());
+            for(size_t k = 0; k < nbins; ++k) {
+                auto bin = (amplified_pulse_vec.empty() ? convolve_bin(k) : amplified_pulse_vec[k]);
+                if(evaluation.add(gain * bin + noise(k))) {
+                    LOG(TRACE) << "Truncated amplified pulse after " << (k + 1) << " of " << nbins << " bins";
+                    break;
+                }
+            }
+        } else {
+            if(amplified_pulse_vec.empty()) {
+                amplified_pulse_vec.resize(ntimepoints);
+                for(size_t k = 0; k < ntimepoints; ++k) {
+                    amplified_pulse_vec[k] = convolve_bin(k);
+                }
+            }
+
+            // Scale the amplified pulse with the gain of the pixel
+            if(!gain_map_.empty()) {
+                auto gain = gain_map_.get(pixel_index);
+                for(auto& bin : amplified_pulse_vec) {
+                    bin *= gain;
+                }
+            }
+
+            if(output_pulsegraphs_) {
+                // Fill a graph with the pulse:
+                create_output_pulsegraphs(std::to_string(event->number),
+                                          std::to_string(pixel_index.x()) + "-" + std::to_string(pixel_index.y()),
+                                          "amp_pulse",
+                                          "Amplifier signal without noise",
+                                          timestep,
+                                          amplified_pulse_vec);
+            }
 
-        // Apply noise to the amplified pulse
-        allpix::normal_distribution<double> pulse_smearing(0, sigmaNoise_);
-        LOG(TRACE) << "Adding electronics noise with sigma = " << Units::display(sigmaNoise_, {"mV", "V"});
-        std::transform(amplified_pulse_vec.begin(),
-                       amplified_pulse_vec.end(),
-                       amplified_pulse_vec.begin(),
-                       [&pulse_smearing, &event](auto& c) { return c + (pulse_smearing(event->getRandomEngine())); });
-
-        // Fill a graphs with the individual pixel pulses:
-        if(output_pulsegraphs_) {
-            create_output_pulsegraphs(std::to_string(event->number),
-                                      std::to_string(pixel_index.x()) + "-" + std::to_string(pixel_index.y()),
-                                      "amp_pulse_noise",
-                                      "Amplifier signal with added noise",
-                                      timestep,
-                                      amplified_pulse_vec);
+            // Apply noise to the amplified pulse
+            LOG(TRACE) << "Adding electronics noise with sigma = " << Units::display(sigma_noise, {"mV", "V"});
+            for(size_t k = 0; k < amplified_pulse_vec.size(); ++k) {
+                amplified_pulse_vec[k] += noise(k);
+            }
+
+            // Fill a graphs with the individual pixel pulses:
+            if(output_pulsegraphs_) {
+                create_output_pulsegraphs(std::to_string(event->number),
+                                          std::to_string(pixel_index.x()) + "-" + std::to_string(pixel_index.y()),
+                                          "amp_pulse_noise",
+                                          "Amplifier signal with added noise",
+                                          timestep,
+                                          amplified_pulse_vec);
+            }
+
+            // Evaluate the full pulse to obtain its integral and peak
+            for(auto bin : amplified_pulse_vec) {
+                evaluation.add(bin);
+            }
         }
 
         // Find threshold crossing - if any:
-        auto arrival = get_toa(timestep, amplified_pulse_vec);
-        if(!std::get<0>(arrival)) {
+        if(!evaluation.threshold_crossed) {
             LOG(DEBUG) << "Amplified signal never crossed threshold, continuing.";
             continue;
         }
+        LOG(TRACE) << "Peak of the amplified signal: " << Units::display(evaluation.peak, {"mV", "V"});
 
         // Decide whether to store ToA or arrival time:
-        auto time = (store_toa_ ? static_cast<double>(std::get<1>(arrival)) : std::get<2>(arrival));
+        auto time = (store_toa_ ? static_cast<double>(evaluation.toa_cycles) : evaluation.arrival_time);
 
         // Decide whether to store ToT or the pulse integral:
-        auto charge = (store_tot_ ? static_cast<double>(get_tot(timestep, std::get<2>(arrival), amplified_pulse_vec))
-                                  : std::accumulate(amplified_pulse_vec.begin(), amplified_pulse_vec.end(), 0.0));
+        auto charge = (store_tot_ ? static_cast<double>(evaluation.tot_cycles) : evaluation.integral);
 
         LOG(DEBUG) << "Pixel " << pixel_index << ": time "
                    << (store_toa_ ? std::to_string(static_cast<int>(time)) + "clk"
@@ -329,7 +408,7 @@ void CSADigitizerModule::run(Event* event) {
         }
 
         // Add the hit to the hitmap
-        hits.emplace_back(pixel, time, pixel_charge.getGlobalTime() + std::get<2>(arrival), charge, &pixel_charge);
+        hits.emplace_back(pixel, time, pixel_charge.getGlobalTime() + evaluation.arrival_time, charge, &pixel_charge);
     }
 
     // Output summary and update statistics
@@ -337,65 +416,164 @@ void CSADigitizerModule::run(Event* event) {
 
     if(!hits.empty()) {
         // Create and dispatch hit message
-        auto hits_message = std::make_shared<PixelHitMessage>(std::move(hits), getDetector());
+        auto hits_message = event->makeShared<PixelHitMessage>(std::move(hits), getDetector());
         messenger_->dispatchMessage(this, hits_message, event);
     }
 }
 
-std::tuple<bool, unsigned int, double> CSADigitizerModule::get_toa(double timestep, const std::vector<double>& pulse) const {
+/**
+ * The impulse response is sampled once per pulse binning, over the full integration time, and shared by all events. Its
+ * Fourier transform for the fast convolution and the noise library are computed together with the samples. The response is
+ * only plotted for the first binning encountered.
+ */
+std::shared_ptr<const CSADigitizerModule::ImpulseResponse> CSADigitizerModule::get_impulse_response(double timestep) {
+    std::lock_guard<std::mutex> lock{impulse_response_mutex_};
+    auto iter = impulse_responses_.find(timestep);
+    if(iter != impulse_responses_.end()) {
+        return iter->second;
+    }
 
-    LOG(TRACE) << "Calculating time-of-arrival";
-    bool threshold_crossed = false;
-    unsigned int comparator_cycles = 0;
-    double arrival_time = 0;
+    auto ntimepoints = static_cast<size_t>(ceil(integration_time_ / timestep));
+    auto response = std::make_shared<ImpulseResponse>();
+    response->samples.reserve(ntimepoints);
+    for(size_t itimepoint = 0; itimepoint < ntimepoints; ++itimepoint) {
+        response->samples.push_back(calculate_impulse_response_->Eval(timestep * static_cast<double>(itimepoint)));
+    }
+    response->convolution = FFTConvolution(response->samples);
+    if(noise_library_size_ > 0) {
+        response->noise = generate_noise_library(timestep, ntimepoints);
+    }
 
-    // Lambda for threshold calculation:
-    auto is_above_threshold = [=](double bin) {
-        if(ignore_polarity_) {
-            return (std::fabs(bin) > std::fabs(threshold_));
-        } else {
-            return (threshold_ > 0 ? bin > threshold_ : bin < threshold_);
-        }
-    };
+    if(output_plots_ && impulse_responses_.empty()) {
+        // Generate x-axis:
+        std::vector<double> time(response->samples.size());
+        // clang-format off
+        std::generate(time.begin(), time.end(), [n = 0.0, timestep]() mutable {  auto now = n; n += timestep; return now; });
+        // clang-format on
+
+        auto* response_graph = new TGraph(static_cast<int>(response->samples.size()), &time[0], &response->samples[0]);
+        response_graph->GetXaxis()->SetTitle("t [ns]");
+        response_graph->GetYaxis()->SetTitle("amp. response");
+        response_graph->SetTitle("Amplifier response function");
+        getROOTDirectory()->WriteTObject(response_graph, "response_function");
+    }
 
-    // Find the point where the signal crosses the threshold, latch ToA
-    while(arrival_time < integration_time_) {
-        auto bin = pulse.at(static_cast<size_t>(std::floor(arrival_time / timestep)));
-        if(is_above_threshold(bin)) {
-            threshold_crossed = true;
-            break;
-        };
-        comparator_cycles++;
-        arrival_time += (store_toa_ ? clockToA_ : timestep);
+    LOG(INFO) << "Initialized impulse response with timestep " << Units::display(timestep, {"ps", "ns", "us"})
+              << " and integration time " << Units::display(integration_time_, {"ns", "us", "ms"})
+              << ", samples: " << ntimepoints;
+    return impulse_responses_.emplace(timestep, std::move(response)).first->second;
+}
+
+/**
+ * White Gaussian noise is transformed to the frequency domain and weighted with the square root of the power spectral
+ * density S(f) = 1 + (f_c / f)^alpha, which is white above the corner frequency f_c and rises with the exponent alpha below.
+ * The constant component is removed. The inverse transform is periodic, such that windows wrapping around the end of the
+ * library remain continuous, and is normalized to unit standard deviation. The library is generated from a seed derived from
+ * the run and the binning, such that it does not depend on the event requesting it first.
+ */
+std::vector<double> CSADigitizerModule::generate_noise_library(double timestep, size_t ntimepoints) const {
+    FastFourierTransform fft(FastFourierTransform::sizeFor(std::max({noise_library_size_, ntimepoints, size_t(2)})));
+    auto size = fft.size();
+
+    std::mt19937_64 random_generator(noise_seed_ ^ std::hash<double>()(timestep));
+    allpix::normal_distribution<double> white_noise(0, 1);
+    std::vector<std::complex<double>> data(size);
+    for(auto& value : data) {
+        value = white_noise(random_generator);
+    }
+
+    // Shape the spectrum, the weights are symmetric in frequency such that the filtered trace remains real
+    fft.transform(data, false);
+    data[0] = 0.;
+    for(size_t k = 1; k < size; ++k) {
+        auto frequency = static_cast<double>(std::min(k, size - k)) / (static_cast<double>(size) * timestep);
+        data[k] *= std::sqrt(1. + std::pow(noise_corner_frequency_ / frequency, noise_spectrum_exponent_));
     }
-    return {threshold_crossed, comparator_cycles, arrival_time};
+    fft.transform(data, true);
+
+    std::vector<double> noise(size);
+    double sum_squares = 0;
+    for(size_t i = 0; i < size; ++i) {
+        noise[i] = data[i].real();
+        sum_squares += noise[i] * noise[i];
+    }
+    auto normalization = std::sqrt(static_cast<double>(size) / sum_squares);
+    for(auto& value : noise) {
+        value *= normalization;
+    }
+
+    LOG(DEBUG) << "Generated noise library with " << size << " samples for timestep "
+               << Units::display(timestep, {"ps", "ns", "us"});
+    return noise;
 }
 
-unsigned int CSADigitizerModule::get_tot(double timestep, double arrival_time, const std::vector<double>& pulse) const {
+CSADigitizerModule::PulseEvaluation::PulseEvaluation(const CSADigitizerModule& module, double timestep, double threshold)
+    : timestep_(timestep), integration_time_(module.integration_time_),
+      clock_toa_(module.store_toa_ ? module.clockToA_ : timestep), clock_tot_(module.clockToT_),
+      evaluate_tot_(module.store_tot_), ignore_polarity_(module.ignore_polarity_), polarity_(threshold > 0 ? 1. : -1.),
+      level_(ignore_polarity_ ? std::fabs(threshold) : polarity_ * threshold),
+      peak_signal_(std::numeric_limits<double>::lowest()) {}
 
-    LOG(TRACE) << "Calculating time-over-threshold, starting at " << Units::display(arrival_time, {"ps", "ns", "us"});
-    unsigned int tot_clock_cycles = 0;
+/**
+ * The comparisons with the threshold are carried out on the signal oriented in direction of the threshold, such that each
+ * bin is only transformed once. The comparator is sampled at the bins containing the clock edges, several clock edges may
+ * fall into the same bin if the clock is faster than the binning of the pulse.
+ */
+bool CSADigitizerModule::PulseEvaluation::add(double bin) {
+    auto signal = (ignore_polarity_ ? std::fabs(bin) : polarity_ * bin);
+    integral += bin;
+    if(signal > peak_signal_) {
+        peak_signal_ = signal;
+        peak = bin;
+    }
 
-    // Lambda for threshold calculation:
-    auto is_below_threshold = [=](double bin) {
-        if(ignore_polarity_) {
-            return (std::fabs(bin) < std::fabs(threshold_));
-        } else {
-            return (threshold_ > 0 ? bin < threshold_ : bin > threshold_);
+    // Find the point where the signal crosses the threshold, latch ToA
+    while(!threshold_crossed && arrival_time < integration_time_ && sample_index(arrival_time) == index_) {
+        if(signal > level_) {
+            threshold_crossed = true;
+            // Start calculation from the next ToT clock cycle following the threshold crossing
+            if(evaluate_tot_) {
+                tot_time_ = clock_tot_ * std::ceil(arrival_time / clock_tot_);
+            }
+            break;
         }
-    };
+        toa_cycles++;
+        arrival_time += clock_toa_;
+    }
 
-    // Start calculation from the next ToT clock cycle following the threshold crossing
-    auto tot_time = clockToT_ * std::ceil(arrival_time / clockToT_);
-    while(tot_time < integration_time_) {
-        auto bin = pulse.at(static_cast<size_t>(std::floor(tot_time / timestep)));
-        if(is_below_threshold(bin)) {
-            break;
+    // Count the ToT clock cycles until the signal is back below the threshold
+    if(threshold_crossed && evaluate_tot_ && !finished_) {
+        while(tot_time_ < integration_time_ && sample_index(tot_time_) == index_) {
+            if(signal < level_) {
+                finished_ = true;
+                break;
+            }
+            tot_cycles++;
+            tot_time_ += clock_tot_;
         }
-        tot_clock_cycles++;
-        tot_time += clockToT_;
+        finished_ = finished_ || tot_time_ >= integration_time_;
+    }
+
+    index_++;
+    return finished_;
+}
+
+PixelCalibrationMap CSADigitizerModule::load_calibration_map(const std::string& key, const std::string& units) const {
+    if(!config_.has(key)) {
+        return {};
+    }
+
+    try {
+        auto map = PixelCalibrationMap::load(config_.getPath(key, true), getDetector()->getModel()->getNPixels(), units);
+        LOG(INFO) << "Loaded per-pixel calibration \"" << key << "\" from file";
+        return map;
+    } catch(std::invalid_argument& e) {
+        throw InvalidValueError(config_, key, e.what());
+    } catch(std::runtime_error& e) {
+        throw InvalidValueError(config_, key, e.what());
+    } catch(std::bad_alloc& e) {
+        throw InvalidValueError(config_, key, "file too large");
     }
-    return tot_clock_cycles;
 }
 
 void CSADigitizerModule::create_output_pulsegraphs(const std::string& s_event_num,
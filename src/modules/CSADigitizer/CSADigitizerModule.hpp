@@ -10,7 +10,10 @@
 #ifndef ALLPIX_CSA_DIGITIZER_MODULE_H
 #define ALLPIX_CSA_DIGITIZER_MODULE_H
 
+#include <cmath>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <random>
 #include <string>
 
@@ -19,6 +22,8 @@
 #include "core/module/Module.hpp"
 
 #include "objects/PixelCharge.hpp"
+#include "tools/fft_convolution.h"
+#include "tools/pixel_calibration.h"
 
 #include <TF1.h>
 #include <TH1D.h>
@@ -72,7 +77,7 @@ namespace allpix {
     private:
         // Control of module output settings
         bool output_plots_{}, output_pulsegraphs_{};
-        bool store_tot_{false}, store_toa_{false}, ignore_polarity_{};
+        bool store_tot_{false}, store_toa_{false}, ignore_polarity_{}, truncate_pulse_{};
         Messenger* messenger_;
         DigitizerType model_;
 
@@ -82,32 +87,102 @@ namespace allpix {
         // Parameters of the electronics: Noise, time-over-threshold logic
         double sigmaNoise_{}, clockToT_{}, clockToA_{}, threshold_{};
 
+        // Spectrum and size of the library of colored noise, disabled for a size of zero
+        size_t noise_library_size_{};
+        double noise_corner_frequency_{}, noise_spectrum_exponent_{};
+        uint64_t noise_seed_{};
+
+        /**
+         * @brief Impulse response and noise library sampled with the binning of the pulses
+         */
+        struct ImpulseResponse {
+            std::vector<double> samples;
+            FFTConvolution convolution;
+            std::vector<double> noise; ///< Periodic noise trace with unit standard deviation, empty if not used
+        };
+
         // Helper variables for transfer function
         double integration_time_{};
-        std::vector<double> impulse_response_function_;
-        std::once_flag first_event_flag_;
+        std::map<double, std::shared_ptr<const ImpulseResponse>> impulse_responses_;
+        std::mutex impulse_response_mutex_;
+
+        /**
+         * @brief Get the impulse response sampled with the binning of a pulse, tabulating it on first use
+         * @param timestep Binning of the pulse
+         * @return Samples of the impulse response over the integration time, together with their transform
+         */
+        std::shared_ptr<const ImpulseResponse> get_impulse_response(double timestep);
+
+        /**
+         * @brief Generate a periodic trace of colored noise by filtering white noise in the frequency domain
+         * @param timestep Binning of the pulse
+         * @param ntimepoints Number of bins of the amplified pulse, the library is at least as long
+         * @return Noise trace with unit standard deviation and a length of a power of two
+         */
+        std::vector<double> generate_noise_library(double timestep, size_t ntimepoints) const;
+
+        // Per-pixel calibration
+        PixelCalibrationMap noise_map_, gain_map_, threshold_map_;
 
         // Output histograms
         Histogram<TH1D> h_tot{}, h_toa{};
         Histogram<TH2D> h_pxq_vs_tot{};
 
         /**
-         * @brief Calculate time of first threshold crossing
-         * @param timestep Step size of the input pulse
-         * @param pulse    Pulse after amplification and electronics noise
-         * @return Tuple containing information about threshold crossing: Boolean (true if crossed), unsigned int (number
-         *         of ToA clock cycles before crossing) and double (time of crossing)
+         * @brief Evaluation of the comparator for a pulse in a single pass over its bins
+         *
+         * The bins of the amplified pulse are added in order. The comparator is sampled with the ToA clock until the
+         * threshold is crossed and with the ToT clock from the first ToT clock cycle after the crossing until the signal is
+         * back below the threshold. The integral and the peak of the pulse are accumulated in the same pass.
          */
-        std::tuple<bool, unsigned int, double> get_toa(double timestep, const std::vector<double>& pulse) const;
+        class PulseEvaluation {
+        public:
+            /**
+             * @brief Prepare the evaluation of a pulse
+             * @param module   Digitizer providing the clock and polarity settings
+             * @param timestep Step size of the input pulse
+             * @param threshold Threshold of the pixel
+             */
+            PulseEvaluation(const CSADigitizerModule& module, double timestep, double threshold);
+
+            /**
+             * @brief Add the next bin of the pulse after amplification and electronics noise
+             * @param bin Amplitude of the bin
+             * @return True if the following bins do not change the ToA and ToT anymore
+             */
+            bool add(double bin);
+
+            bool threshold_crossed{};   ///< True if the threshold has been crossed
+            unsigned int toa_cycles{};  ///< Number of ToA clock cycles before the crossing
+            double arrival_time{};      ///< Time of the crossing
+            unsigned int tot_cycles{};  ///< Number of ToT clock cycles the signal is above the threshold
+            double integral{};          ///< Sum of the bins added
+            double peak{};              ///< Amplitude of the bin with the largest signal in direction of the threshold
+
+        private:
+            // Index of a sampling time in the pulse
+            size_t sample_index(double time) const { return static_cast<size_t>(std::floor(time / timestep_)); }
+
+            double timestep_, integration_time_, clock_toa_, clock_tot_;
+            bool evaluate_tot_;
+
+            // Signal and threshold level, oriented such that the threshold is crossed by signals above the level
+            bool ignore_polarity_;
+            double polarity_, level_;
+
+            size_t index_{};
+            double tot_time_{};
+            double peak_signal_;
+            bool finished_{};
+        };
 
         /**
-         * @brief Calculate time-over-threshold
-         * @param  timestep    Step size of the input pulse
-         * @param arrival_time Time of crossing the threshold
-         * @param  pulse       Pulse after amplification and electronics noise
-         * @return             Number of clock cycles signal was over threshold
+         * @brief Load a per-pixel calibration map if configured
+         * @param key Configuration key of the path to the map
+         * @param units Units of the values in file formats not using internal units
+         * @return Calibration map, empty if the key is not configured
          */
-        unsigned int get_tot(double timestep, double arrival_time, const std::vector<double>& pulse) const;
+        PixelCalibrationMap load_calibration_map(const std::string& key, const std::string& units) const;
 
         /**
          * @brief Create output plots of the pulses
@@ -7,13 +7,16 @@
 
 #include "CapacitiveTransferModule.hpp"
 
+#include <cmath>
 #include <fstream>
 #include <limits>
+#include <map>
 #include <memory>
 #include <new>
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "core/config/exceptions.h"
 #include "core/geometry/HybridPixelDetectorModel.hpp"
@@ -256,15 +259,71 @@ void CapacitiveTransferModule::initialize() {
             "Capacitive coupling was not defined. Please, check the README file for configuration options or use "
             "the SimpleTransfer module.");
     }
+
+    // Resolve the coupling matrix into a kernel of pixel offsets, dropping the pixels without coupling
+    auto coupling_scan = config_.has("coupling_scan_file");
+    auto center_col = matrix_cols_ / 2;
+    auto center_row = matrix_rows_ / 2;
+    for(unsigned int row = 0; row < matrix_rows_; row++) {
+        for(unsigned int col = 0; col < matrix_cols_; col++) {
+            if(!cross_coupling_ && (col != center_col || row != center_row)) {
+                continue;
+            }
+
+            // The coupling from scan files depends on the gap at the receiving pixel and is tabulated below
+            double ccpd_factor = 0;
+            if(coupling_scan) {
+                ccpd_factor = 1;
+            } else if(config_.has("coupling_file")) {
+                ccpd_factor = relative_coupling_[col][row];
+            } else {
+                ccpd_factor = relative_coupling_[matrix_rows_ - row - 1][col];
+            }
+            if(std::fabs(ccpd_factor) < std::numeric_limits<double>::epsilon()) {
+                LOG(TRACE) << "Detected zero coupling to neighbour " << col << "," << row << ", skipping";
+                continue;
+            }
+
+            kernel_.push_back({static_cast<int>(col) - static_cast<int>(center_col),
+                               static_cast<int>(row) - static_cast<int>(center_row),
+                               row * matrix_cols_ + col,
+                               ccpd_factor});
+        }
+    }
+
+    // Tabulate the coupling of every pixel to the neighbours of the kernel from the capacitance scans
+    if(coupling_scan) {
+        auto npixels = model_->getNPixels();
+        scan_coupling_.resize(static_cast<size_t>(npixels.x()) * npixels.y() * kernel_.size());
+        for(unsigned int x = 0; x < npixels.x(); x++) {
+            for(unsigned int y = 0; y < npixels.y(); y++) {
+                double local_x = x * model_->getPixelSize().x();
+                double local_y = y * model_->getPixelSize().y();
+                auto pixel_point = Eigen::Vector3d(local_x, local_y, 0);
+                auto pixel_projection = plane_.projection(pixel_point);
+                auto pixel_gap = static_cast<double>(Units::convert(pixel_projection[2], "um"));
+
+                auto* coupling = &scan_coupling_[(static_cast<size_t>(x) * npixels.y() + y) * kernel_.size()];
+                for(const auto& neighbour : kernel_) {
+                    *coupling++ = capacitances_[neighbour.graph]->Eval(pixel_gap, nullptr, "S") * normalization_;
+                }
+            }
+        }
+    }
+    LOG(DEBUG) << "Coupling kernel with " << kernel_.size() << " neighbours";
 }
 
 void CapacitiveTransferModule::run(Event* event) {
     auto propagated_message = messenger_->fetchMessage<PropagatedChargeMessage>(this, event);
 
-    // Find corresponding pixels for all propagated charges
+    // Sum the propagated charges at their nearest pixel
     LOG(TRACE) << "Transferring charges to pixels";
-    unsigned int transferred_charges_count = 0;
-    std::map<Pixel::Index, std::pair<double, std::vector<const PropagatedCharge*>>> pixel_map;
+    struct SourceCharge {
+        unsigned int charge{};
+        double signed_charge{};
+        std::vector<const PropagatedCharge*> propagated_charges;
+    };
+    std::map<std::pair<int, int>, SourceCharge> source_map;
     for(const auto& propagated_charge : propagated_message->getData()) {
         auto position = propagated_charge.getLocalPosition();
         // Ignore if outside depth range of implant
@@ -279,65 +338,55 @@ void CapacitiveTransferModule::run(Event* event) {
         auto [xpixel, ypixel] = model_->getPixelIndex(position);
         LOG(DEBUG) << "Hit at pixel " << xpixel << ", " << ypixel;
 
-        for(size_t row = 0; row < max_row_; row++) {
-            for(size_t col = 0; col < max_col_; col++) {
-                if(!cross_coupling_) {
-                    col = static_cast<size_t>(std::floor(matrix_cols_ / 2));
-                    row = static_cast<size_t>(std::floor(matrix_rows_ / 2));
-                }
-
-                auto xcoord = xpixel + static_cast<int>(col - static_cast<size_t>(std::floor(matrix_cols_ / 2)));
-                auto ycoord = ypixel + static_cast<int>(row - static_cast<size_t>(std::floor(matrix_rows_ / 2)));
-
-                // Ignore if out of pixel grid
-                if(!detector_->getModel()->isWithinPixelGrid(xcoord, ycoord)) {
-                    LOG(DEBUG) << "Skipping set of propagated charges at " << propagated_charge.getLocalPosition()
-                               << " because their nearest pixel (" << xpixel << "," << ypixel
-                               << ") is outside the pixel matrix";
-                    continue;
-                }
+        auto& source = source_map[{xpixel, ypixel}];
+        source.charge += propagated_charge.getCharge();
+        source.signed_charge += static_cast<double>(propagated_charge.getSign() * propagated_charge.getCharge());
+        source.propagated_charges.emplace_back(&propagated_charge);
+    }
 
-                auto pixel_index = Pixel::Index(static_cast<unsigned int>(xcoord), static_cast<unsigned int>(ycoord));
+    // Transfer the charges to the pixels by convolving them with the coupling kernel
+    unsigned int transferred_charges_count = 0;
+    std::map<Pixel::Index, std::pair<double, std::vector<const PropagatedCharge*>>> pixel_map;
+    auto npixels_y = model_->getNPixels().y();
+    for(const auto& [source_pixel, source] : source_map) {
+        for(size_t neighbour = 0; neighbour < kernel_.size(); neighbour++) {
+            const auto& coupling = kernel_[neighbour];
+            auto xcoord = source_pixel.first + coupling.dx;
+            auto ycoord = source_pixel.second + coupling.dy;
+
+            // Ignore if out of pixel grid
+            if(!model_->isWithinPixelGrid(xcoord, ycoord)) {
+                LOG(DEBUG) << "Skipping set of propagated charges at pixel (" << source_pixel.first << ","
+                           << source_pixel.second << ") because neighbour (" << xcoord << "," << ycoord
+                           << ") is outside the pixel matrix";
+                continue;
+            }
 
-                double ccpd_factor = 0;
-                if(config_.has("coupling_scan_file")) {
-                    double local_x = pixel_index.x() * model_->getPixelSize().x();
-                    double local_y = pixel_index.y() * model_->getPixelSize().y();
-                    auto pixel_point = Eigen::Vector3d(local_x, local_y, 0);
-                    auto pixel_projection = plane_.projection(pixel_point);
-                    auto pixel_gap = pixel_projection[2];
+            auto pixel_index = Pixel::Index(static_cast<unsigned int>(xcoord), static_cast<unsigned int>(ycoord));
 
-                    ccpd_factor = capacitances_[row * 3 + col]->Eval(
-                                      static_cast<double>(Units::convert(pixel_gap, "um")), nullptr, "S") *
-                                  normalization_;
-                } else if(config_.has("coupling_file")) {
-                    ccpd_factor = relative_coupling_[col][row];
-                } else if(config_.has("coupling_matrix")) {
-                    ccpd_factor = relative_coupling_[max_row_ - row - 1][col];
-                } else {
-                    ccpd_factor = 1;
-                    LOG(ERROR) << "This shouldn't happen. Transferring 100% of detected charge";
-                }
+            auto ccpd_factor = coupling.factor;
+            if(!scan_coupling_.empty()) {
+                auto pixel = static_cast<size_t>(pixel_index.x()) * npixels_y + pixel_index.y();
+                ccpd_factor = scan_coupling_[pixel * kernel_.size() + neighbour];
 
                 // If there is no cross-coupling (factor is zero) don't create a pixel hit:
                 if(std::fabs(ccpd_factor) < std::numeric_limits<double>::epsilon()) {
                     LOG(TRACE) << "Detected zero coupling, skipping pixel hit creation";
                     continue;
                 }
+            }
 
-                // Update statistics
-                transferred_charges_count += static_cast<unsigned int>(propagated_charge.getCharge() * ccpd_factor);
-                auto neighbour_charge =
-                    static_cast<double>(propagated_charge.getSign() * propagated_charge.getCharge()) * ccpd_factor;
+            // Update statistics
+            transferred_charges_count += static_cast<unsigned int>(source.charge * ccpd_factor);
 
-                LOG(DEBUG) << "Set of " << propagated_charge.getCharge() * ccpd_factor << " charges brought to neighbour "
-                           << col << "," << row << " pixel " << pixel_index << "with cross-coupling of " << ccpd_factor * 100
-                           << "%";
+            LOG(DEBUG) << "Set of " << source.charge * ccpd_factor << " charges brought to neighbour " << coupling.dx
+                       << "," << coupling.dy << " pixel " << pixel_index << " with cross-coupling of "
+                       << ccpd_factor * 100 << "%";
 
-                // Add the pixel the list of hit pixels
-                pixel_map[pixel_index].first += neighbour_charge;
-                pixel_map[pixel_index].second.emplace_back(&propagated_charge);
-            }
+            // Add the pixel the list of hit pixels
+            auto& pixel = pixel_map[pixel_index];
+            pixel.first += source.signed_charge * ccpd_factor;
+            pixel.second.insert(pixel.second.end(), source.propagated_charges.begin(), source.propagated_charges.end());
         }
     }
 
@@ -358,7 +407,7 @@ void CapacitiveTransferModule::run(Event* event) {
     total_transferred_charges_ += transferred_charges_count;
 
     // Dispatch message of pixel charges
-    auto pixel_message = std::make_shared<PixelChargeMessage>(pixel_charges, detector_);
+    auto pixel_message = event->makeShared<PixelChargeMessage>(pixel_charges, detector_);
     messenger_->dispatchMessage(this, pixel_message, event);
 }
 
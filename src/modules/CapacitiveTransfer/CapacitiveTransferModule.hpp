@@ -85,6 +85,20 @@ namespace allpix {
         double max_depth_distance_{};
         bool cross_coupling_{};
 
+        /**
+         * @brief Coupling of a pixel to its neighbour at a fixed offset
+         */
+        struct Coupling {
+            int dx;
+            int dy;
+            unsigned int graph;
+            double factor;
+        };
+        // Kernel of all neighbours with coupling
+        std::vector<Coupling> kernel_;
+        // Coupling from capacitance scans for every pixel and neighbour of the kernel
+        std::vector<double> scan_coupling_;
+
         void getCapacitanceScan(TFile* root_file);
         TGraph* capacitances_[9]{};
 
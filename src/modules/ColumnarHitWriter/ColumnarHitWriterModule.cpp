@@ -0,0 +1,166 @@
+/**
+ * @file
+ * @brief Implementation of the module writing pixel hits to flat ROOT trees with one column per quantity
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "ColumnarHitWriterModule.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/utils/log.h"
+#include "objects/exceptions.h"
+
+using namespace allpix;
+
+ColumnarHitWriterModule::ColumnarHitWriterModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager)
+    : SequentialModule(config), messenger_(messenger), geo_manager_(geo_manager) {
+    // Enable multithreading of this module if multithreading is enabled
+    allow_multithreading();
+
+    // Bind to all pixel hit messages
+    messenger_->bindMulti<PixelHitMessage>(this, MsgFlags::REQUIRED);
+
+    config_.setDefault("file_name", "hits");
+    config_.setDefault("include_mc_truth", false);
+    config_.setDefault("basket_size", 262144);
+
+    include_mc_truth_ = config_.get<bool>("include_mc_truth");
+    basket_size_ = config_.get<int>("basket_size");
+    if(basket_size_ <= 0) {
+        throw InvalidValueError(config_, "basket_size", "basket size should be positive");
+    }
+}
+
+void ColumnarHitWriterModule::initialize() {
+    output_file_name_ = createOutputFile(config_.get<std::string>("file_name"), "root", true);
+    output_file_ = std::make_unique<TFile>(output_file_name_.c_str(), "RECREATE");
+
+    // Store the names of the detectors once, the hit columns only refer to their index
+    auto* detector_tree = create_tree("Detectors", "Names of the detectors");
+    UShort_t detector_index = 0;
+    std::string detector_name;
+    detector_tree->Branch("detector", &detector_index);
+    detector_tree->Branch("name", &detector_name);
+    for(auto& detector : geo_manager_->getDetectors()) {
+        detector_name = detector->getName();
+        detector_index_[detector_name] = detector_index;
+        detector_tree->Fill();
+        ++detector_index;
+    }
+    detector_tree->ResetBranchAddresses();
+
+    hit_tree_ = create_tree("Hits", "Pixel hits");
+    hit_tree_->Branch("event", &hit_.event, basket_size_);
+    hit_tree_->Branch("detector", &hit_.detector, basket_size_);
+    hit_tree_->Branch("column", &hit_.column, basket_size_);
+    hit_tree_->Branch("row", &hit_.row, basket_size_);
+    hit_tree_->Branch("signal", &hit_.signal, basket_size_);
+    hit_tree_->Branch("local_time", &hit_.local_time, basket_size_);
+    hit_tree_->Branch("global_time", &hit_.global_time, basket_size_);
+
+    event_tree_ = create_tree("Events", "Range of the hits of every event");
+    event_tree_->Branch("event", &event_.event);
+    event_tree_->Branch("first_hit", &event_.first_hit);
+    event_tree_->Branch("hits", &event_.hits);
+
+    if(include_mc_truth_) {
+        particle_tree_ = create_tree("MCParticles", "Monte Carlo particles of the pixel hits");
+        particle_tree_->Branch("event", &particle_.event, basket_size_);
+        particle_tree_->Branch("detector", &particle_.detector, basket_size_);
+        particle_tree_->Branch("particle_id", &particle_.particle_id, basket_size_);
+        particle_tree_->Branch("start_x", &particle_.start_x, basket_size_);
+        particle_tree_->Branch("start_y", &particle_.start_y, basket_size_);
+        particle_tree_->Branch("start_z", &particle_.start_z, basket_size_);
+        particle_tree_->Branch("end_x", &particle_.end_x, basket_size_);
+        particle_tree_->Branch("end_y", &particle_.end_y, basket_size_);
+        particle_tree_->Branch("end_z", &particle_.end_z, basket_size_);
+        particle_tree_->Branch("global_time", &particle_.global_time, basket_size_);
+
+        association_tree_ = create_tree("HitMCParticles", "Entries of the Monte Carlo particles of every pixel hit");
+        association_tree_->Branch("hit", &association_.hit, basket_size_);
+        association_tree_->Branch("particle", &association_.particle, basket_size_);
+    }
+}
+
+void ColumnarHitWriterModule::run(Event* event) {
+    auto messages = messenger_->fetchMultiMessage<PixelHitMessage>(this, event);
+
+    event_.event = event->number;
+    event_.first_hit = hit_count_;
+    event_.hits = 0;
+
+    // Entries of the particles written for this event, particles shared by several hits are only written once
+    std::unordered_map<const MCParticle*, ULong64_t> particle_entries;
+    const std::vector<const MCParticle*> no_particles;
+
+    for(auto& message : messages) {
+        hit_.event = event->number;
+        hit_.detector = detector_index_.at(message->getDetector()->getName());
+        for(const auto& hit : message->getData()) {
+            auto index = hit.getIndex();
+            hit_.column = index.x();
+            hit_.row = index.y();
+            hit_.signal = hit.getSignal();
+            hit_.local_time = hit.getLocalTime();
+            hit_.global_time = hit.getGlobalTime();
+            hit_tree_->Fill();
+
+            if(include_mc_truth_) {
+                const std::vector<const MCParticle*>* particles = &no_particles;
+                try {
+                    particles = &hit.getMCParticles();
+                } catch(MissingReferenceException&) {
+                    LOG_ONCE(WARNING) << "Monte Carlo particles of pixel hits are not available, skipping their history";
+                }
+                for(const auto* particle : *particles) {
+                    auto entry = particle_entries.find(particle);
+                    if(entry == particle_entries.end()) {
+                        auto start = particle->getLocalStartPoint();
+                        auto end = particle->getLocalEndPoint();
+                        particle_ = {event->number,
+                                     hit_.detector,
+                                     particle->getParticleID(),
+                                     start.x(),
+                                     start.y(),
+                                     start.z(),
+                                     end.x(),
+                                     end.y(),
+                                     end.z(),
+                                     particle->getGlobalTime()};
+                        particle_tree_->Fill();
+                        entry = particle_entries.emplace(particle, particle_count_++).first;
+                    }
+
+                    association_.hit = hit_count_;
+                    association_.particle = entry->second;
+                    association_tree_->Fill();
+                }
+            }
+
+            ++hit_count_;
+            ++event_.hits;
+        }
+    }
+
+    event_tree_->Fill();
+    LOG(TRACE) << "Wrote " << event_.hits << " hits of event " << event->number;
+}
+
+void ColumnarHitWriterModule::finalize() {
+    output_file_->Write();
+    LOG(STATUS) << "Wrote " << hit_count_ << " hits of " << event_tree_->GetEntries() << " events to file:" << std::endl
+                << output_file_name_;
+}
+
+TTree* ColumnarHitWriterModule::create_tree(const std::string& name, const std::string& title) {
+    output_file_->cd();
+    auto* tree = new TTree(name.c_str(), title.c_str());
+    tree->SetDirectory(output_file_.get());
+    return tree;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file
+ * @brief Definition of the module writing pixel hits to flat ROOT trees with one column per quantity
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include <TFile.h>
+#include <TTree.h>
+
+#include "core/config/Configuration.hpp"
+#include "core/geometry/GeometryManager.hpp"
+#include "core/messenger/Messenger.hpp"
+#include "core/module/Event.hpp"
+#include "core/module/Module.hpp"
+
+#include "objects/MCParticle.hpp"
+#include "objects/PixelHit.hpp"
+
+namespace allpix {
+    /**
+     * @ingroup Modules
+     * @brief Module to write pixel hits to flat ROOT trees with one entry per hit and a plain branch per quantity
+     *
+     * Every branch holds a single number per entry, such that ROOT stores every quantity as a separate column of compressed
+     * baskets. The trees can be read as plain arrays without the object dictionaries and only the columns required need to
+     * be read. Optionally, the Monte Carlo particles of the hits are stored in a separate table together with a table
+     * associating hits and particles by their entry numbers.
+     */
+    class ColumnarHitWriterModule : public SequentialModule {
+    public:
+        /**
+         * @brief Constructor for this unique module
+         * @param config Configuration object for this module as retrieved from the steering file
+         * @param messenger Pointer to the messenger object to allow binding to messages on the bus
+         * @param geo_manager Pointer to the geometry manager, containing the detectors
+         */
+        ColumnarHitWriterModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager);
+
+        /**
+         * @brief Open the output file and create the trees with their branches
+         */
+        void initialize() override;
+
+        /**
+         * @brief Append the hits of an event to the trees
+         */
+        void run(Event* event) override;
+
+        /**
+         * @brief Write the trees to the output file
+         */
+        void finalize() override;
+
+    private:
+        /**
+         * @brief Create a tree in the output file
+         * @param name Name of the tree
+         * @param title Title of the tree
+         * @return Tree owned by the output file
+         */
+        TTree* create_tree(const std::string& name, const std::string& title);
+
+        Messenger* messenger_;
+        GeometryManager* geo_manager_;
+
+        bool include_mc_truth_{};
+        int basket_size_{};
+
+        // Output data file and its trees, owned by the file
+        std::unique_ptr<TFile> output_file_;
+        std::string output_file_name_;
+        TTree* hit_tree_{};
+        TTree* event_tree_{};
+        TTree* particle_tree_{};
+        TTree* association_tree_{};
+
+        // Index of every detector as stored in the detector column
+        std::map<std::string, UShort_t> detector_index_;
+
+        // Values of the current entry of every tree
+        struct {
+            ULong64_t event;
+            UShort_t detector;
+            UInt_t column;
+            UInt_t row;
+            Double_t signal;
+            Double_t local_time;
+            Double_t global_time;
+        } hit_{};
+        struct {
+            ULong64_t event;
+            ULong64_t first_hit;
+            UInt_t hits;
+        } event_{};
+        struct {
+            ULong64_t event;
+            UShort_t detector;
+            Int_t particle_id;
+            Double_t start_x;
+            Double_t start_y;
+            Double_t start_z;
+            Double_t end_x;
+            Double_t end_y;
+            Double_t end_z;
+            Double_t global_time;
+        } particle_{};
+        struct {
+            ULong64_t hit;
+            ULong64_t particle;
+        } association_{};
+
+        // Number of entries written to the hit and particle tables
+        ULong64_t hit_count_{};
+        ULong64_t particle_count_{};
+    };
+} // namespace allpix
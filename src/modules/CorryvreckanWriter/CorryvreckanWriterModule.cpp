@@ -10,7 +10,10 @@
 #include "CorryvreckanWriterModule.hpp"
 
 #include <Math/RotationZYX.h>
+#include <TClass.h>
+#include <TMessage.h>
 #include <TProcessID.h>
+#include <TServerSocket.h>
 
 #include <fstream>
 #include <string>
@@ -32,6 +35,7 @@ CorryvreckanWriterModule::CorryvreckanWriterModule(Configuration& config, Messen
     config_.setDefault("geometry_file", "corryvreckanGeometry.conf");
     config_.setDefault("global_timing", false);
     config_.setDefault("output_mctruth", true);
+    config_.setDefault("stream_timeout", Units::get(60, "s"));
 }
 
 // Set up the output trees
@@ -54,15 +58,25 @@ void CorryvreckanWriterModule::initialize() {
     // Select pixel hit timing information to be saved:
     timing_global_ = config_.get<bool>("global_timing");
 
+    // Create geometry file:
+    geometryFileName_ = createOutputFile(config_.get<std::string>("geometry_file"), "conf");
+
+    // Initialise the time
+    time_ = 0;
+
+    // Send the objects directly to Corryvreckan instead of writing them to file
+    stream_ = config_.has("stream_port");
+    if(stream_) {
+        connect_stream();
+        return;
+    }
+
     // Create output file and directories
     fileName_ = createOutputFile(config_.get<std::string>("file_name"), "root");
     LOG(TRACE) << "Creating output file \"" << fileName_ << "\"";
     output_file_ = std::make_unique<TFile>(fileName_.c_str(), "RECREATE");
     output_file_->cd();
 
-    // Create geometry file:
-    geometryFileName_ = createOutputFile(config_.get<std::string>("geometry_file"), "conf");
-
     // Create trees:
     LOG(TRACE) << "Booking event tree";
     event_tree_ = std::make_unique<TTree>("Event", (std::string("Tree of Events").c_str()));
@@ -75,9 +89,55 @@ void CorryvreckanWriterModule::initialize() {
         LOG(TRACE) << "Booking MCParticle tree";
         mcparticle_tree_ = std::make_unique<TTree>("MCParticle", (std::string("Tree of MCParticles").c_str()));
     }
+}
 
-    // Initialise the time
-    time_ = 0;
+/**
+ * The module listens on the configured port and accepts a single connection, the simulation only starts once Corryvreckan
+ * is connected.
+ */
+void CorryvreckanWriterModule::connect_stream() {
+    auto port = config_.get<int>("stream_port");
+    TServerSocket server(port, true);
+    if(!server.IsValid()) {
+        throw InvalidValueError(config_, "stream_port", "cannot listen on port " + std::to_string(port));
+    }
+
+    LOG(STATUS) << "Waiting for Corryvreckan to connect on port " << port;
+    auto timeout = static_cast<Long_t>(Units::convert(config_.get<double>("stream_timeout"), "ms"));
+    if(server.Select(TSocket::kRead, timeout) <= 0) {
+        throw ModuleError("No connection has been established on port " + std::to_string(port) + " within " +
+                          Units::display(config_.get<double>("stream_timeout"), {"s", "ms"}));
+    }
+    stream_socket_.reset(server.Accept());
+    if(stream_socket_ == nullptr || !stream_socket_->IsValid()) {
+        throw ModuleError("Accepting the connection on port " + std::to_string(port) + " failed");
+    }
+    LOG(INFO) << "Corryvreckan connected from " << stream_socket_->GetInetAddress().GetHostName();
+}
+
+/**
+ * Every event is sent as a single message containing the event, followed by the number of detectors with objects. For
+ * every detector its name, the vector of pixels and, if the Monte Carlo truth is written, the vector of particles follow.
+ */
+void CorryvreckanWriterModule::send_event() {
+    static auto* pixel_class = TClass::GetClass("std::vector<corryvreckan::Pixel*>");
+    static auto* mcparticle_class = TClass::GetClass("std::vector<corryvreckan::MCParticle*>");
+
+    TMessage message(kMESS_OBJECT);
+    message.WriteObjectAny(event_, corryvreckan::Event::Class());
+    message.WriteUInt(static_cast<UInt_t>(write_list_px_.size()));
+    for(auto& index_data : write_list_px_) {
+        message.WriteStdString(&index_data.first);
+        message.WriteObjectAny(index_data.second, pixel_class);
+        if(output_mc_truth_) {
+            message.WriteObjectAny(write_list_mcp_[index_data.first], mcparticle_class);
+        }
+    }
+
+    if(stream_socket_->Send(message) <= 0) {
+        throw ModuleError("Sending event to Corryvreckan failed, connection has been lost");
+    }
+    stream_cnt_++;
 }
 
 // Make instantiations of Corryvreckan pixels, and store these in the trees during run time
@@ -95,46 +155,52 @@ void CorryvreckanWriterModule::run(Event* event) {
     event_ = new corryvreckan::Event(time_, time_ + 5);
     LOG(DEBUG) << "Defining event for Corryvreckan: [" << Units::display(event_->start(), {"ns", "um"}) << ","
                << Units::display(event_->end(), {"ns", "um"}) << "]";
-    event_tree_->Fill();
+    if(!stream_) {
+        event_tree_->Fill();
+    }
 
     // Events start with 1, pre-filling only with empty events before:
     auto event_id = event->number - 1;
 
     // Loop through all received messages
-    for(auto& message : pixel_messages) {
+    for(const auto& message : pixel_messages) {
 
         auto detector_name = message->getDetector()->getName();
         LOG(DEBUG) << "Received " << message->getData().size() << " pixel hits from detector " << detector_name;
 
         if(write_list_px_.find(detector_name) == write_list_px_.end()) {
             write_list_px_[detector_name] = new std::vector<corryvreckan::Pixel*>();
-            pixel_tree_->Bronch(detector_name.c_str(),
-                                std::string("std::vector<corryvreckan::Pixel*>").c_str(),
-                                &write_list_px_[detector_name]);
-
-            if(event_id > 0) {
-                LOG(DEBUG) << "Pre-filling new branch " << detector_name << " of corryvreckan::Pixel with " << event_id
-                           << " empty events";
-                auto* branch = pixel_tree_->GetBranch(detector_name.c_str());
-                for(unsigned int i = 0; i < event_id; ++i) {
-                    branch->Fill();
+            if(!stream_) {
+                pixel_tree_->Bronch(detector_name.c_str(),
+                                    std::string("std::vector<corryvreckan::Pixel*>").c_str(),
+                                    &write_list_px_[detector_name]);
+
+                if(event_id > 0) {
+                    LOG(DEBUG) << "Pre-filling new branch " << detector_name << " of corryvreckan::Pixel with " << event_id
+                               << " empty events";
+                    auto* branch = pixel_tree_->GetBranch(detector_name.c_str());
+                    for(unsigned int i = 0; i < event_id; ++i) {
+                        branch->Fill();
+                    }
                 }
             }
         }
 
         if(output_mc_truth_ && write_list_mcp_.find(detector_name) == write_list_mcp_.end()) {
             write_list_mcp_[detector_name] = new std::vector<corryvreckan::MCParticle*>();
-            mcparticle_tree_->Bronch(detector_name.c_str(),
-                                     std::string("std::vector<corryvreckan::MCParticle*>").c_str(),
-                                     &write_list_mcp_[detector_name]);
-
-            if(event_id > 0) {
-
-                LOG(DEBUG) << "Pre-filling new branch " << detector_name << " of corryvreckan::MCParticle with " << event_id
-                           << " empty events";
-                auto* branch = mcparticle_tree_->GetBranch(detector_name.c_str());
-                for(unsigned int i = 0; i < event_id; ++i) {
-                    branch->Fill();
+            if(!stream_) {
+                mcparticle_tree_->Bronch(detector_name.c_str(),
+                                         std::string("std::vector<corryvreckan::MCParticle*>").c_str(),
+                                         &write_list_mcp_[detector_name]);
+
+                if(event_id > 0) {
+
+                    LOG(DEBUG) << "Pre-filling new branch " << detector_name << " of corryvreckan::MCParticle with "
+                               << event_id << " empty events";
+                    auto* branch = mcparticle_tree_->GetBranch(detector_name.c_str());
+                    for(unsigned int i = 0; i < event_id; ++i) {
+                        branch->Fill();
+                    }
                 }
             }
         }
@@ -156,7 +222,7 @@ void CorryvreckanWriterModule::run(Event* event) {
             }
 
             // Get all associated particles
-            auto mcp = apx_pixel.getMCParticles();
+            const auto& mcp = apx_pixel.getMCParticles();
             LOG(DEBUG) << "Received " << mcp.size() << " Monte Carlo particles from pixel hit";
             for(auto& particle : mcp) {
                 auto* mcParticle = new corryvreckan::MCParticle(
@@ -170,12 +236,17 @@ void CorryvreckanWriterModule::run(Event* event) {
         }
     }
 
-    LOG(TRACE) << "Writing new objects to tree";
-    output_file_->cd();
+    if(stream_) {
+        LOG(TRACE) << "Sending new objects to Corryvreckan";
+        send_event();
+    } else {
+        LOG(TRACE) << "Writing new objects to tree";
+        output_file_->cd();
 
-    pixel_tree_->Fill();
-    if(output_mc_truth_) {
-        mcparticle_tree_->Fill();
+        pixel_tree_->Fill();
+        if(output_mc_truth_) {
+            mcparticle_tree_->Fill();
+        }
     }
 
     // Clear the current write lists
@@ -207,11 +278,18 @@ void CorryvreckanWriterModule::run(Event* event) {
 // Save the output trees to file
 void CorryvreckanWriterModule::finalize() {
 
-    // Finish writing to output file
-    output_file_->Write();
-
-    // Print statistics
-    LOG(STATUS) << "Wrote output data to file:" << std::endl << fileName_;
+    if(stream_) {
+        // Signal the end of the run and close the connection
+        stream_socket_->Send("Finished");
+        stream_socket_->Close();
+        LOG(STATUS) << "Sent " << stream_cnt_ << " events to Corryvreckan";
+    } else {
+        // Finish writing to output file
+        output_file_->Write();
+
+        // Print statistics
+        LOG(STATUS) << "Wrote output data to file:" << std::endl << fileName_;
+    }
 
     // Loop over all detectors and store the geometry:
     // Write geometry:
@@ -24,6 +24,7 @@
 
 // ROOT includes
 #include "TFile.h"
+#include "TSocket.h"
 #include "TTree.h"
 
 namespace allpix {
@@ -60,6 +61,16 @@ namespace allpix {
         void finalize() override;
 
     private:
+        /**
+         * @brief Wait for Corryvreckan to connect to the configured port
+         */
+        void connect_stream();
+
+        /**
+         * @brief Send the objects of the current event to the connected Corryvreckan instance
+         */
+        void send_event();
+
         // General module members
         Messenger* messenger_;
         GeometryManager* geometryManager_;
@@ -82,5 +93,10 @@ namespace allpix {
         std::unique_ptr<TTree> mcparticle_tree_;
         std::map<std::string, std::vector<corryvreckan::Pixel*>*> write_list_px_;
         std::map<std::string, std::vector<corryvreckan::MCParticle*>*> write_list_mcp_;
+
+        // Connection to Corryvreckan if the objects are streamed instead of written to file
+        bool stream_{};
+        std::unique_ptr<TSocket> stream_socket_;
+        unsigned long stream_cnt_{};
     };
 } // namespace allpix
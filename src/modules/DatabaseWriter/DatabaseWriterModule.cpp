@@ -10,6 +10,7 @@
 #include "DatabaseWriterModule.hpp"
 
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <utility>
 
@@ -25,6 +26,36 @@
 
 using namespace allpix;
 
+// Columns of the tables without the number of the row, in the order of the values written by the module
+const std::map<std::string, DatabaseWriterModule::Table> DatabaseWriterModule::tables = {
+    {"Event", {"event_nr", "run_nr, eventID"}},
+    {"MCTrack",
+     {"mctrack_nr",
+      "run_nr, event_nr, detector, address, parentAddress, particleID, productionProcess, productionVolume, "
+      "initialPositionX, initialPositionY, initialPositionZ, finalPositionX, finalPositionY, finalPositionZ, "
+      "initialKineticEnergy, finalKineticEnergy"}},
+    {"MCParticle",
+     {"mcparticle_nr",
+      "run_nr, event_nr, mctrack_nr, detector, address, parentAddress, trackAddress, particleID, localStartPointX, "
+      "localStartPointY, localStartPointZ, localEndPointX, localEndPointY, localEndPointZ, globalStartPointX, "
+      "globalStartPointY, globalStartPointZ, globalEndPointX, globalEndPointY, globalEndPointZ"}},
+    {"DepositedCharge",
+     {"depositedcharge_nr",
+      "run_nr, event_nr, mcparticle_nr, detector, carriertype, charge, localx, localy, localz, globalx, globaly, globalz"}},
+    {"PropagatedCharge",
+     {"propagatedcharge_nr",
+      "run_nr, event_nr, depositedcharge_nr, detector, carriertype, charge, localx, localy, localz, globalx, globaly, "
+      "globalz"}},
+    {"PixelCharge",
+     {"pixelCharge_nr",
+      "run_nr, event_nr, propagatedcharge_nr, detector, charge, x, y, localx, localy, globalx, globaly"}},
+    {"PixelHit",
+     {"pixelHit_nr", "run_nr, event_nr, mcparticle_nr, pixelcharge_nr, detector, x, y, signal, hittime"}}};
+
+// Order in which the tables are written, referenced rows have to exist before the rows referencing them
+const std::vector<std::string> DatabaseWriterModule::table_order = {
+    "Event", "MCTrack", "MCParticle", "DepositedCharge", "PropagatedCharge", "PixelCharge", "PixelHit"};
+
 DatabaseWriterModule::DatabaseWriterModule(Configuration& config, Messenger* messenger, GeometryManager*)
     : SequentialModule(config), messenger_(messenger) {
     // Enable multithreading of this module if multithreading is enabled
@@ -35,6 +66,8 @@ DatabaseWriterModule::DatabaseWriterModule(Configuration& config, Messenger* mes
 
     config_.setDefault("global_timing", false);
     config_.setDefault("run_id", "none");
+    config_.setDefault("batch_size", 0);
+    config_.setDefault("id_block_size", 1024);
 }
 
 void DatabaseWriterModule::initialize() {
@@ -50,6 +83,13 @@ void DatabaseWriterModule::initialize() {
     // Select pixel hit timing information to be saved:
     timing_global_ = config_.get<bool>("global_timing");
 
+    // Number of events written in a single transaction and number of rows reserved at once
+    batch_size_ = config_.get<unsigned int>("batch_size");
+    id_block_size_ = config_.get<unsigned int>("id_block_size");
+    if(id_block_size_ == 0) {
+        throw InvalidValueError(config_, "id_block_size", "number of reserved row numbers should be positive");
+    }
+
     // Establishing connection to the database
     conn_ = std::make_shared<pqxx::connection>("host=" + host_ + " port=" + port_ + " dbname=" + database_name_ +
                                                " user=" + user_ + " password=" + password_);
@@ -57,10 +97,13 @@ void DatabaseWriterModule::initialize() {
         throw ModuleError("Could not connect to database " + database_name_ + " at host " + host_);
     }
 
-    W_ = std::make_shared<pqxx::nontransaction>(*conn_);
+    // Rows are written directly without transaction unless they are collected in batches
+    if(batch_size_ == 0) {
+        W_ = std::make_shared<pqxx::nontransaction>(*conn_);
+    }
 
     // inserting run entry in the database
-    pqxx::result runR = W_->exec("INSERT INTO Run (run_id) VALUES ('" + run_id_ + "') RETURNING run_nr;");
+    pqxx::result runR = execute("INSERT INTO Run (run_id) VALUES ('" + run_id_ + "') RETURNING run_nr;");
     run_nr_ = atoi(runR[0][0].c_str());
 
     // Read include and exclude list
@@ -92,7 +135,7 @@ bool DatabaseWriterModule::filter(const std::shared_ptr<BaseMessage>& message,
         }
 
         // Read the object
-        auto object_array = message->getObjectArray();
+        auto object_array = message->getObjects();
         if(!object_array.empty()) {
             const Object& first_object = object_array[0];
             auto* cls = TClass::GetClass(typeid(first_object));
@@ -136,23 +179,19 @@ void DatabaseWriterModule::run(Event* event) {
     // initializing database referenced parameters to negative
     // if negative values are retained (i.e. the corresponding object is excluded), no reference is created when inserting a
     // new entry in the table
-    int mctrack_nr = -1;
-    int mcparticle_nr = -1;
-    int depositedcharge_nr = -1;
-    int propagatedcharge_nr = -1;
-    int pixelcharge_nr = -1;
+    long mctrack_nr = -1;
+    long mcparticle_nr = -1;
+    long depositedcharge_nr = -1;
+    long propagatedcharge_nr = -1;
+    long pixelcharge_nr = -1;
 
     LOG(TRACE) << "Writing new objects to database";
 
     std::stringstream insertionLine;
-    pqxx::result insertionResult;
 
     // Writing entry to event table
-    insertionLine.str(std::string());
-    insertionLine << "INSERT INTO Event (run_nr, eventID) VALUES (" << run_nr_ << ", " << event->number
-                  << ") RETURNING event_nr;";
-    insertionResult = W_->exec(insertionLine.str());
-    int event_nr = atoi(insertionResult[0][0].c_str());
+    insertionLine << run_nr_ << ", " << event->number;
+    long event_nr = insert("Event", insertionLine.str());
 
     // Looping through messages
     for(auto& pair : messages) {
@@ -165,7 +204,7 @@ void DatabaseWriterModule::run(Event* event) {
         } else {
             detectorName = "global";
         }
-        for(auto& object : message->getObjectArray()) {
+        for(auto& object : message->getObjects()) {
             // Retrieving object type
             Object& current_object = object;
             auto* cls = TClass::GetClass(typeid(current_object));
@@ -176,111 +215,58 @@ void DatabaseWriterModule::run(Event* event) {
                 class_name.replace(ap_idx, apx_namespace.size(), "");
             }
             // Writing objects to corresponding database tables
+            insertionLine.str(std::string());
+            insertionLine << run_nr_ << ", " << event_nr << ", ";
             if(class_name == "PixelHit") {
                 LOG(TRACE) << "inserting PixelHit" << std::endl;
                 PixelHit hit = static_cast<PixelHit&>(current_object);
-                insertionLine.str(std::string());
-                insertionLine << "INSERT INTO PixelHit (run_nr, event_nr, ";
-                if(mcparticle_nr >= 0)
-                    insertionLine << "mcparticle_nr, ";
-                if(pixelcharge_nr >= 0)
-                    insertionLine << "pixelcharge_nr, ";
-                insertionLine << "detector, x, y, signal, hittime) VALUES (" << run_nr_ << ", " << event_nr << ", ";
-                if(mcparticle_nr >= 0)
-                    insertionLine << mcparticle_nr << ", ";
-                if(pixelcharge_nr >= 0)
-                    insertionLine << pixelcharge_nr << ", ";
-                insertionLine << "'" << detectorName << "', " << hit.getIndex().X() << ", " << hit.getIndex().Y() << ", "
-                              << hit.getSignal() << ", " << (timing_global_ ? hit.getGlobalTime() : hit.getLocalTime())
-                              << ") RETURNING pixelHit_nr;";
-                insertionResult = W_->exec(insertionLine.str());
+                insertionLine << reference(mcparticle_nr) << ", " << reference(pixelcharge_nr) << ", '" << detectorName
+                              << "', " << hit.getIndex().X() << ", " << hit.getIndex().Y() << ", " << hit.getSignal()
+                              << ", " << (timing_global_ ? hit.getGlobalTime() : hit.getLocalTime());
+                insert(class_name, insertionLine.str());
             } else if(class_name == "PixelCharge") {
                 LOG(TRACE) << "inserting PixelCharge" << std::endl;
                 PixelCharge charge = static_cast<PixelCharge&>(current_object);
-                insertionLine.str(std::string());
-                insertionLine << "INSERT INTO PixelCharge (run_nr, event_nr, ";
-                if(propagatedcharge_nr >= 0)
-                    insertionLine << "propagatedcharge_nr, ";
-                insertionLine << "detector, charge, x, y, localx, localy, globalx, globaly) VALUES (" << run_nr_ << ", "
-                              << event_nr << ", ";
-                if(propagatedcharge_nr >= 0)
-                    insertionLine << propagatedcharge_nr << ", ";
-                insertionLine << "'" << detectorName << "', " << charge.getCharge() << ", " << charge.getIndex().X() << ", "
-                              << charge.getIndex().Y() << ", " << charge.getPixel().getLocalCenter().X() << ", "
-                              << charge.getPixel().getLocalCenter().Y() << ", " << charge.getPixel().getGlobalCenter().X()
-                              << ", " << charge.getPixel().getGlobalCenter().Y() << ") RETURNING pixelCharge_nr";
-                insertionResult = W_->exec(insertionLine.str());
-                pixelcharge_nr = atoi(insertionResult[0][0].c_str());
+                insertionLine << reference(propagatedcharge_nr) << ", '" << detectorName << "', " << charge.getCharge()
+                              << ", " << charge.getIndex().X() << ", " << charge.getIndex().Y() << ", "
+                              << charge.getPixel().getLocalCenter().X() << ", " << charge.getPixel().getLocalCenter().Y()
+                              << ", " << charge.getPixel().getGlobalCenter().X() << ", "
+                              << charge.getPixel().getGlobalCenter().Y();
+                pixelcharge_nr = insert(class_name, insertionLine.str());
             } else if(class_name == "PropagatedCharge") { // not recommended, this will slow down the simulation considerably
                 LOG(TRACE) << "inserting PropagatedCharge" << std::endl;
                 PropagatedCharge charge = static_cast<PropagatedCharge&>(current_object);
-                insertionLine.str(std::string());
-                insertionLine << "INSERT INTO PropagatedCharge (run_nr, event_nr, ";
-                if(depositedcharge_nr >= 0)
-                    insertionLine << "depositedcharge_nr, ";
-                insertionLine << "detector, carriertype, charge, localx, localy, localz, globalx, globaly, globalz) VALUES ("
-                              << run_nr_ << ", " << event_nr << ", ";
-                if(depositedcharge_nr >= 0)
-                    insertionLine << depositedcharge_nr << ", ";
-                insertionLine << "'" << detectorName << "', " << static_cast<int>(charge.getType()) << ", "
-                              << charge.getCharge() << ", " << charge.getLocalPosition().X() << ", "
-                              << charge.getLocalPosition().Y() << ", " << charge.getLocalPosition().Z() << ", "
-                              << charge.getGlobalPosition().X() << ", " << charge.getGlobalPosition().Y() << ", "
-                              << charge.getGlobalPosition().Z() << ") RETURNING propagatedcharge_nr;";
-                insertionResult = W_->exec(insertionLine.str());
-                propagatedcharge_nr = atoi(insertionResult[0][0].c_str());
+                insertionLine << reference(depositedcharge_nr) << ", '" << detectorName << "', "
+                              << static_cast<int>(charge.getType()) << ", " << charge.getCharge() << ", "
+                              << charge.getLocalPosition().X() << ", " << charge.getLocalPosition().Y() << ", "
+                              << charge.getLocalPosition().Z() << ", " << charge.getGlobalPosition().X() << ", "
+                              << charge.getGlobalPosition().Y() << ", " << charge.getGlobalPosition().Z();
+                propagatedcharge_nr = insert(class_name, insertionLine.str());
             } else if(class_name == "MCTrack") {
                 LOG(TRACE) << "inserting MCTrack" << std::endl;
                 MCTrack track = static_cast<MCTrack&>(current_object);
-                insertionLine.str(std::string());
-                insertionLine << "INSERT INTO MCTrack (run_nr, event_nr, detector, address, parentAddress, particleID, "
-                                 "productionProcess, productionVolume, initialPositionX, initialPositionY, "
-                                 "initialPositionZ, finalPositionX, finalPositionY, finalPositionZ, initialKineticEnergy, "
-                                 "finalKineticEnergy) VALUES ("
-                              << run_nr_ << ", " << event_nr << ", '" << detectorName << "', "
-                              << reinterpret_cast<uintptr_t>(&current_object) << ", "
+                insertionLine << "'" << detectorName << "', " << reinterpret_cast<uintptr_t>(&current_object) << ", "
                               << reinterpret_cast<uintptr_t>(track.getParent()) << ", " << track.getParticleID() << ", '"
                               << track.getCreationProcessName() << "', '" << track.getOriginatingVolumeName() << "', "
                               << track.getStartPoint().X() << ", " << track.getStartPoint().Y() << ", "
                               << track.getStartPoint().Z() << ", " << track.getEndPoint().X() << ", "
                               << track.getEndPoint().Y() << ", " << track.getEndPoint().Z() << ", "
-                              << track.getKineticEnergyInitial() << ", " << track.getKineticEnergyFinal()
-                              << ") RETURNING mctrack_nr;";
-                insertionResult = W_->exec(insertionLine.str());
-                mctrack_nr = atoi(insertionResult[0][0].c_str());
+                              << track.getKineticEnergyInitial() << ", " << track.getKineticEnergyFinal();
+                mctrack_nr = insert(class_name, insertionLine.str());
             } else if(class_name == "DepositedCharge") {
                 LOG(TRACE) << "inserting DepositedCharge" << std::endl;
                 DepositedCharge charge = static_cast<DepositedCharge&>(current_object);
-                insertionLine.str(std::string());
-                insertionLine << "INSERT INTO DepositedCharge (run_nr, event_nr, ";
-                if(mcparticle_nr >= 0)
-                    insertionLine << "mcparticle_nr, ";
-                insertionLine << "detector, carriertype, charge, localx, localy, localz, globalx, globaly, globalz) VALUES ("
-                              << run_nr_ << ", " << event_nr << ", ";
-                if(mcparticle_nr >= 0)
-                    insertionLine << mcparticle_nr << ", ";
-                insertionLine << "'" << detectorName << "', " << static_cast<int>(charge.getType()) << ", "
-                              << charge.getCharge() << ", " << charge.getLocalPosition().X() << ", "
-                              << charge.getLocalPosition().Y() << ", " << charge.getLocalPosition().Z() << ", "
-                              << charge.getGlobalPosition().X() << ", " << charge.getGlobalPosition().Y() << ", "
-                              << charge.getGlobalPosition().Z() << ") RETURNING depositedcharge_nr";
-                insertionResult = W_->exec(insertionLine.str());
-                depositedcharge_nr = atoi(insertionResult[0][0].c_str());
+                insertionLine << reference(mcparticle_nr) << ", '" << detectorName << "', "
+                              << static_cast<int>(charge.getType()) << ", " << charge.getCharge() << ", "
+                              << charge.getLocalPosition().X() << ", " << charge.getLocalPosition().Y() << ", "
+                              << charge.getLocalPosition().Z() << ", " << charge.getGlobalPosition().X() << ", "
+                              << charge.getGlobalPosition().Y() << ", " << charge.getGlobalPosition().Z();
+                depositedcharge_nr = insert(class_name, insertionLine.str());
             } else if(class_name == "MCParticle") {
                 LOG(TRACE) << "inserting MCParticle" << std::endl;
                 MCParticle particle = static_cast<MCParticle&>(current_object);
-                insertionLine.str(std::string());
-                insertionLine << "INSERT INTO MCParticle (run_nr, event_nr, ";
-                if(mctrack_nr >= 0)
-                    insertionLine << "mctrack_nr, ";
-                insertionLine
-                    << "detector, address, parentAddress, trackAddress, particleID, localStartPointX, localStartPointY, "
-                       "localStartPointZ, localEndPointX, localEndPointY, localEndPointZ, globalStartPointX, "
-                       "globalStartPointY, globalStartPointZ, globalEndPointX, globalEndPointY, globalEndPointZ) VALUES ("
-                    << run_nr_ << ", " << event_nr << ", ";
-                if(mctrack_nr >= 0)
-                    insertionLine << mctrack_nr << ", ";
-                insertionLine << "'" << detectorName << "', " << reinterpret_cast<uintptr_t>(&current_object) << ", "
+                insertionLine << reference(mctrack_nr) << ", '" << detectorName << "', "
+                              << reinterpret_cast<uintptr_t>(&current_object) << ", "
                               << reinterpret_cast<uintptr_t>(particle.getParent()) << ", "
                               << reinterpret_cast<uintptr_t>(particle.getTrack()) << ", " << particle.getParticleID() << ", "
                               << particle.getLocalStartPoint().X() << ", " << particle.getLocalStartPoint().Y() << ", "
@@ -288,10 +274,8 @@ void DatabaseWriterModule::run(Event* event) {
                               << particle.getLocalEndPoint().Y() << ", " << particle.getLocalEndPoint().Z() << ", "
                               << particle.getGlobalStartPoint().X() << ", " << particle.getGlobalStartPoint().Y() << ", "
                               << particle.getGlobalStartPoint().Z() << ", " << particle.getGlobalEndPoint().X() << ", "
-                              << particle.getGlobalEndPoint().Y() << ", " << particle.getGlobalEndPoint().Z()
-                              << ") RETURNING mcparticle_nr;";
-                insertionResult = W_->exec(insertionLine.str());
-                mcparticle_nr = atoi(insertionResult[0][0].c_str());
+                              << particle.getGlobalEndPoint().Y() << ", " << particle.getGlobalEndPoint().Z();
+                mcparticle_nr = insert(class_name, insertionLine.str());
             } else {
                 LOG(WARNING) << "Following object type is not yet accounted for in database output: " << class_name
                              << std::endl;
@@ -300,9 +284,75 @@ void DatabaseWriterModule::run(Event* event) {
         }
         msg_cnt_++;
     }
+
+    // Write the buffered rows once the batch is complete
+    if(batch_size_ > 0 && ++batched_events_ >= batch_size_) {
+        flush();
+    }
+}
+
+std::string DatabaseWriterModule::reference(long nr) {
+    return nr >= 0 ? std::to_string(nr) : "NULL";
+}
+
+pqxx::result DatabaseWriterModule::execute(const std::string& query) {
+    if(W_ != nullptr) {
+        return W_->exec(query);
+    }
+    pqxx::nontransaction transaction(*conn_);
+    return transaction.exec(query);
+}
+
+long DatabaseWriterModule::insert(const std::string& table_name, const std::string& values) {
+    const auto& table = tables.at(table_name);
+
+    // Insert the row directly and retrieve the number assigned by the database
+    if(batch_size_ == 0) {
+        pqxx::result result = execute("INSERT INTO " + table_name + " (" + table.columns + ") VALUES (" + values +
+                                      ") RETURNING " + table.id_column + ";");
+        return atol(result[0][0].c_str());
+    }
+
+    // Reserve a block of numbers from the sequence of the table if all reserved numbers have been used
+    auto& buffer = buffers_[table_name];
+    if(buffer.reserved.empty()) {
+        pqxx::result result = execute("SELECT nextval(pg_get_serial_sequence('" + table_name + "', '" + table.id_column +
+                                      "')) FROM generate_series(1, " + std::to_string(id_block_size_) + ");");
+        for(auto row = result.rbegin(); row != result.rend(); ++row) {
+            buffer.reserved.push_back(atol((*row)[0].c_str()));
+        }
+    }
+    auto nr = buffer.reserved.back();
+    buffer.reserved.pop_back();
+
+    // Buffer the row with its number until the batch is written
+    buffer.rows += (buffer.rows.empty() ? "(" : ",(") + std::to_string(nr) + ", " + values + ")";
+    return nr;
+}
+
+void DatabaseWriterModule::flush() {
+    batched_events_ = 0;
+
+    // Write the tables in the order of their references within a single transaction
+    pqxx::work transaction(*conn_);
+    for(const auto& table_name : table_order) {
+        auto& buffer = buffers_[table_name];
+        if(buffer.rows.empty()) {
+            continue;
+        }
+        const auto& table = tables.at(table_name);
+        transaction.exec("INSERT INTO " + table_name + " (" + table.id_column + ", " + table.columns + ") VALUES " +
+                         buffer.rows + ";");
+        buffer.rows.clear();
+    }
+    transaction.commit();
 }
 
 void DatabaseWriterModule::finalize() {
+    // Write the rows of the last incomplete batch
+    if(batch_size_ > 0) {
+        flush();
+    }
 
     // disconnecting from database
     conn_->disconnect();
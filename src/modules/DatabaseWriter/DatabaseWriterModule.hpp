@@ -11,6 +11,7 @@
 #include <fstream>
 #include <map>
 #include <string>
+#include <vector>
 
 #include "core/config/Configuration.hpp"
 #include "core/geometry/GeometryManager.hpp"
@@ -25,7 +26,8 @@ namespace allpix {
      * @brief Module to write object data to PostgreSQL databases
      *
      * Listens to all objects dispatched in the framework and stores a representation of every object to the specified
-     * database.
+     * database. Objects are either inserted one by one or collected for a number of events and written in a single
+     * transaction with one multi-row insertion per table, using row numbers reserved from the table sequences in advance.
      */
     class DatabaseWriterModule : public SequentialModule {
     public:
@@ -61,6 +63,52 @@ namespace allpix {
         void finalize() override;
 
     private:
+        /**
+         * @brief Columns of a database table
+         */
+        struct Table {
+            std::string id_column;
+            std::string columns;
+        };
+
+        /**
+         * @brief Rows of a table collected for the current batch and row numbers reserved for the table
+         */
+        struct TableBuffer {
+            std::string rows;
+            std::vector<long> reserved;
+        };
+
+        /**
+         * @brief Insert a row into a table, or add it to the current batch
+         * @param table_name Name of the table
+         * @param values Values of all columns of the table except the row number
+         * @return Number of the row in the table
+         */
+        long insert(const std::string& table_name, const std::string& values);
+
+        /**
+         * @brief Write all rows of the current batch in a single transaction
+         */
+        void flush();
+
+        /**
+         * @brief Execute a query outside of a transaction
+         * @param query SQL query to execute
+         * @return Result of the query
+         */
+        pqxx::result execute(const std::string& query);
+
+        /**
+         * @brief Get the value of a reference to a row
+         * @param nr Number of the row referenced, negative if the row has not been written
+         * @return Number of the row or NULL if the row has not been written
+         */
+        static std::string reference(long nr);
+
+        static const std::map<std::string, Table> tables;
+        static const std::vector<std::string> table_order;
+
         Messenger* messenger_;
 
         // Object names to include or exclude from writing
@@ -79,6 +127,12 @@ namespace allpix {
         int run_nr_;
         bool timing_global_{};
 
+        // Rows collected for the current batch of events
+        unsigned int batch_size_{};
+        unsigned int id_block_size_{};
+        unsigned int batched_events_{};
+        std::map<std::string, TableBuffer> buffers_;
+
         // Statistical information about number of objects
         std::atomic<unsigned long> write_cnt_{};
         std::atomic<unsigned long> msg_cnt_{};
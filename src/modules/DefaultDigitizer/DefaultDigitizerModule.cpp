@@ -14,6 +14,12 @@
 #include "objects/PixelHit.hpp"
 #include "tools/ROOT.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <string>
+
 #include <TFile.h>
 #include <TH1D.h>
 #include <TProfile.h>
@@ -27,8 +33,10 @@ DefaultDigitizerModule::DefaultDigitizerModule(Configuration& config,
     // Enable multithreading of this module if multithreading is enabled
     allow_multithreading();
 
-    // Require PixelCharge message for single detector
-    messenger_->bindSingle<PixelChargeMessage>(this, MsgFlags::REQUIRED);
+    // Require PixelCharge message for single detector, unless noise hits are generated also for events without charge
+    config_.setDefault<bool>("noise_hits", false);
+    noise_hits_ = config_.get<bool>("noise_hits");
+    messenger_->bindSingle<PixelChargeMessage>(this, noise_hits_ ? MsgFlags::NONE : MsgFlags::REQUIRED);
 
     // Set defaults for config variables
     config_.setDefault<int>("electronics_noise", Units::get(110, "e"));
@@ -87,9 +95,43 @@ DefaultDigitizerModule::DefaultDigitizerModule(Configuration& config,
     tdc_offset_ = config_.get<double>("tdc_offset");
     tdc_slope_ = config_.get<double>("tdc_slope");
     allow_zero_tdc_ = config_.get<bool>("allow_zero_tdc");
+
+    // Settings of a threshold or gain scan, sharing the noise of all settings
+    auto scan_thresholds = config_.getArray<double>("scan_thresholds", {});
+    auto scan_gains = config_.getArray<double>("scan_gains", {});
+    if(!scan_thresholds.empty() && !scan_gains.empty() && scan_thresholds.size() != scan_gains.size()) {
+        throw InvalidCombinationError(
+            config_, {"scan_thresholds", "scan_gains"}, "the same number of thresholds and gains has to be scanned");
+    }
+    for(size_t i = 0; i < std::max(scan_thresholds.size(), scan_gains.size()); ++i) {
+        scan_settings_.push_back({scan_thresholds.empty() ? threshold_ : scan_thresholds[i],
+                                  scan_gains.empty() ? gain_ : scan_gains[i]});
+    }
+    total_scan_hits_ = std::vector<std::atomic<unsigned long long>>(scan_settings_.size());
 }
 
 void DefaultDigitizerModule::initialize() {
+    // Per-pixel calibration of noise, gain and threshold, replacing the values common to all pixels:
+    noise_map_ = load_calibration_map("electronics_noise_map", "e");
+    gain_map_ = load_calibration_map("gain_map", "");
+    threshold_map_ = load_calibration_map("threshold_map", "e");
+
+    if(noise_hits_) {
+        compute_noise_occupancy();
+    }
+
+    // Scanned values replace the common values, which is not possible if every pixel has its own value
+    if(config_.has("scan_thresholds") && !threshold_map_.empty()) {
+        throw InvalidCombinationError(
+            config_, {"scan_thresholds", "threshold_map"}, "thresholds cannot be scanned with per-pixel thresholds");
+    }
+    if(config_.has("scan_gains") && !gain_map_.empty()) {
+        throw InvalidCombinationError(config_, {"scan_gains", "gain_map"}, "gains cannot be scanned with per-pixel gains");
+    }
+    if(!scan_settings_.empty()) {
+        LOG(INFO) << "Digitizing " << scan_settings_.size() << " scan settings in addition to the default setting";
+    }
+
     // Conversion to ADC units requested:
     if(qdc_resolution_ > 31) {
         throw InvalidValueError(config_, "qdc_resolution", "precision higher than 31bit is not possible");
@@ -178,131 +220,165 @@ void DefaultDigitizerModule::initialize() {
     }
 }
 
+/**
+ * All pixel charges of the event are digitized as one batch, with every quantity stored in a separate array. The random
+ * numbers are drawn in a single pass over the generator, in the same order as they would be drawn for every pixel in turn,
+ * such that the result for a given seed does not depend on the batching. The conversions to QDC and TDC units are then
+ * applied to all arrays at once.
+ */
 void DefaultDigitizerModule::run(Event* event) {
-    auto pixel_message = messenger_->fetchMessage<PixelChargeMessage>(this, event);
-
-    // Loop through all pixels with charges
-    std::vector<PixelHit> hits;
-    for(const auto& pixel_charge : pixel_message->getData()) {
-        auto pixel = pixel_charge.getPixel();
-        auto pixel_index = pixel.getIndex();
-        auto charge = static_cast<double>(pixel_charge.getAbsoluteCharge());
+    Batch batch;
+    digitize(event, batch);
+}
 
-        LOG(DEBUG) << "Received pixel " << pixel_index << ", (absolute) charge " << Units::display(charge, "e");
-        if(output_plots_) {
-            h_pxq->Fill(charge / 1e3);
-        }
+/**
+ * The arrays of intermediate values are allocated once and reused for all events of the batch
+ */
+void DefaultDigitizerModule::run(const std::vector<Event*>& events) {
+    Batch batch;
+    for(auto* event : events) {
+        digitize(event, batch);
+    }
+}
 
-        // Add electronics noise from Gaussian:
-        allpix::normal_distribution<double> el_noise(0, electronics_noise_);
-        charge += el_noise(event->getRandomEngine());
+void DefaultDigitizerModule::digitize(Event* event, Batch& batch) {
+    // Without generating noise hits the message is required, otherwise events without any charge are digitized as well
+    auto pixel_message = messenger_->fetchMessage<PixelChargeMessage>(this, event);
+    static const std::vector<PixelCharge> no_pixel_charges;
+    const auto& pixel_charges = (pixel_message != nullptr ? pixel_message->getData() : no_pixel_charges);
+    auto pixels = pixel_charges.size();
+
+    batch.resize(pixels);
+    for(size_t i = 0; i < pixels; ++i) {
+        auto pixel_index = pixel_charges[i].getIndex();
+        batch.charge[i] = static_cast<double>(pixel_charges[i].getAbsoluteCharge());
+        batch.noise_level[i] = noise_map_.get(pixel_index, electronics_noise_);
+        batch.gain_level[i] = gain_map_.get(pixel_index, gain_);
+        batch.threshold_level[i] = threshold_map_.get(pixel_index, threshold_);
+    }
 
-        LOG(DEBUG) << "Charge with noise: " << Units::display(charge, "e");
-        if(output_plots_) {
-            h_pxq_noise->Fill(charge / 1e3);
+    // Sample noise, gain, saturation and threshold of all pixels, followed by the QDC and TDC smearing of the pixels which
+    // pass the threshold
+    using normal_parameters = allpix::normal_distribution<double>::param_type;
+    allpix::normal_distribution<double> normal;
+    allpix::normal_distribution<double> saturation_smearing(saturation_mean_, saturation_width_);
+    allpix::normal_distribution<double> adc_smearing(0, qdc_smearing_);
+    allpix::normal_distribution<double> tdc_smearing(0, tdc_smearing_);
+    // The deviations of gain and threshold are kept to apply them to all scan settings, which all pass the QDC and TDC
+    auto scan = !scan_settings_.empty();
+    auto sample = [&](auto& engine) {
+        for(size_t i = 0; i < pixels; ++i) {
+            batch.noisy_charge[i] = batch.charge[i] + normal(engine, normal_parameters(0, batch.noise_level[i]));
+            batch.gain_deviation[i] = normal(engine);
+            batch.gain[i] = batch.gain_level[i] + gain_smearing_ * batch.gain_deviation[i];
+            batch.amplified_charge[i] = batch.noisy_charge[i] * batch.gain[i];
+            batch.saturation[i] = saturation_ ? saturation_smearing(engine) : std::numeric_limits<double>::infinity();
+            batch.saturated_charge[i] = std::min(batch.amplified_charge[i], batch.saturation[i]);
+            batch.threshold_deviation[i] = normal(engine);
+            batch.threshold[i] = batch.threshold_level[i] + threshold_smearing_ * batch.threshold_deviation[i];
+            batch.passed[i] = !(batch.saturated_charge[i] < batch.threshold[i]);
+            batch.qdc_noise[i] = ((batch.passed[i] || scan) && qdc_resolution_ > 0) ? adc_smearing(engine) : 0.;
+            batch.tdc_noise[i] = ((batch.passed[i] || scan) && tdc_resolution_ > 0) ? tdc_smearing(engine) : 0.;
         }
+    };
+    // Only dispatch the engine once, unless the random numbers should be logged individually
+    IFLOG(PRNG) { sample(event->getRandomEngine()); }
+    else {
+        event->getRandomEngine().visit(sample);
+    }
 
-        // Smear the gain factor, Gaussian distribution around "gain" with width "gain_smearing"
-        allpix::normal_distribution<double> gain_smearing(gain_, gain_smearing_);
-        double gain = gain_smearing(event->getRandomEngine());
-        if(output_plots_) {
-            h_gain->Fill(gain);
+    // Simulate QDC if resolution set to more than 0bit, converting to ADC units and precision, making sure the ADC count is
+    // at least 1
+    if(qdc_resolution_ > 0) {
+        auto qdc_minimum = (allow_zero_qdc_ ? 0 : 1);
+        auto qdc_maximum = (1 << qdc_resolution_) - 1;
+        for(size_t i = 0; i < pixels; ++i) {
+            batch.smeared_charge[i] = batch.saturated_charge[i] + batch.qdc_noise[i];
+            batch.qdc_charge[i] = static_cast<double>(std::clamp(
+                static_cast<int>((qdc_offset_ + batch.smeared_charge[i]) / qdc_slope_), qdc_minimum, qdc_maximum));
         }
+    }
 
-        // Apply the gain to the charge:
-        charge *= gain;
-        LOG(DEBUG) << "Charge after amplifier (gain): " << Units::display(charge, "e");
-        if(output_plots_) {
-            h_pxq_gain->Fill(charge / 1e3);
-        }
+    // Find the time of arrival of all pixels passing the threshold
+    for(size_t i = 0; i < pixels; ++i) {
+        batch.time[i] = batch.passed[i] ? time_of_arrival(pixel_charges[i], batch.threshold[i]) : 0.;
+    }
 
-        // Simulate simple front-end saturation if enabled:
-        if(saturation_) {
-            allpix::normal_distribution<double> saturation_smearing(saturation_mean_, saturation_width_);
-            auto saturation = saturation_smearing(event->getRandomEngine());
-            if(charge > saturation) {
-                LOG(DEBUG) << "Above front-end saturation, " << Units::display(charge, {"e", "ke"}) << " > "
-                           << Units::display(saturation, {"e", "ke"}) << ", setting to saturation value";
-                charge = saturation;
-            }
+    // Simulate TDC if resolution set to more than 0bit, converting to TDC units and precision, making sure the TDC count is
+    // at least 1
+    if(tdc_resolution_ > 0) {
+        auto tdc_minimum = (allow_zero_tdc_ ? 0 : 1);
+        auto tdc_maximum = (1 << tdc_resolution_) - 1;
+        for(size_t i = 0; i < pixels; ++i) {
+            batch.smeared_time[i] = batch.time[i] + batch.tdc_noise[i];
+            batch.tdc_time[i] = static_cast<double>(
+                std::clamp(static_cast<int>((tdc_offset_ + batch.smeared_time[i]) / tdc_slope_), tdc_minimum, tdc_maximum));
         }
+    }
 
-        if(output_plots_) {
-            h_pxq_sat->Fill(charge / 1e3);
-        }
+    // Report the digitization steps and create the hits of all pixels passing the threshold
+    std::vector<PixelHit> hits;
+    for(size_t i = 0; i < pixels; ++i) {
+        const auto& pixel_charge = pixel_charges[i];
+        auto pixel = pixel_charge.getPixel();
 
-        // Smear the threshold, Gaussian distribution around "threshold" with width "threshold_smearing"
-        allpix::normal_distribution<double> thr_smearing(threshold_, threshold_smearing_);
-        double threshold = thr_smearing(event->getRandomEngine());
+        LOG(DEBUG) << "Received pixel " << pixel.getIndex() << ", (absolute) charge "
+                   << Units::display(batch.charge[i], "e");
+        LOG(DEBUG) << "Charge with noise: " << Units::display(batch.noisy_charge[i], "e");
+        LOG(DEBUG) << "Charge after amplifier (gain): " << Units::display(batch.amplified_charge[i], "e");
+        if(batch.amplified_charge[i] > batch.saturation[i]) {
+            LOG(DEBUG) << "Above front-end saturation, " << Units::display(batch.amplified_charge[i], {"e", "ke"})
+                       << " > " << Units::display(batch.saturation[i], {"e", "ke"}) << ", setting to saturation value";
+        }
         if(output_plots_) {
-            h_thr->Fill(threshold / 1e3);
+            h_pxq->Fill(batch.charge[i] / 1e3);
+            h_pxq_noise->Fill(batch.noisy_charge[i] / 1e3);
+            h_gain->Fill(batch.gain[i]);
+            h_pxq_gain->Fill(batch.amplified_charge[i] / 1e3);
+            h_pxq_sat->Fill(batch.saturated_charge[i] / 1e3);
+            h_thr->Fill(batch.threshold[i] / 1e3);
         }
 
         // Discard charges below threshold:
-        if(charge < threshold) {
-            LOG(DEBUG) << "Below smeared threshold: " << Units::display(charge, "e") << " < "
-                       << Units::display(threshold, "e");
+        if(!batch.passed[i]) {
+            LOG(DEBUG) << "Below smeared threshold: " << Units::display(batch.saturated_charge[i], "e") << " < "
+                       << Units::display(batch.threshold[i], "e");
             continue;
         }
 
-        LOG(DEBUG) << "Passed threshold: " << Units::display(charge, "e") << " > " << Units::display(threshold, "e");
+        LOG(DEBUG) << "Passed threshold: " << Units::display(batch.saturated_charge[i], "e") << " > "
+                   << Units::display(batch.threshold[i], "e");
         if(output_plots_) {
-            h_pxq_thr->Fill(charge / 1e3);
+            h_pxq_thr->Fill(batch.saturated_charge[i] / 1e3);
         }
 
-        // Simulate QDC if resolution set to more than 0bit
+        auto charge = batch.saturated_charge[i];
         if(qdc_resolution_ > 0) {
-            // temporarily store old charge for histogramming:
-            auto original_charge = charge;
-
-            // Add ADC smearing:
-            allpix::normal_distribution<double> adc_smearing(0, qdc_smearing_);
-            charge += adc_smearing(event->getRandomEngine());
-            if(output_plots_) {
-                h_pxq_adc_smear->Fill(charge / 1e3);
-            }
-            LOG(DEBUG) << "Smeared for simulating limited QDC sensitivity: " << Units::display(charge, "e");
-
-            // Convert to ADC units and precision, make sure ADC count is at least 1:
-            charge = static_cast<double>(std::clamp(static_cast<int>((qdc_offset_ + charge) / qdc_slope_),
-                                                    (allow_zero_qdc_ ? 0 : 1),
-                                                    (1 << qdc_resolution_) - 1));
+            charge = batch.qdc_charge[i];
+            LOG(DEBUG) << "Smeared for simulating limited QDC sensitivity: " << Units::display(batch.smeared_charge[i], "e");
             LOG(DEBUG) << "Charge converted to QDC units: " << charge;
-
             if(output_plots_) {
-                h_calibration->Fill(original_charge / 1e3, charge);
+                h_pxq_adc_smear->Fill(batch.smeared_charge[i] / 1e3);
+                h_calibration->Fill(batch.saturated_charge[i] / 1e3, charge);
                 h_pxq_adc->Fill(charge);
             }
         } else if(output_plots_) {
             h_pxq_adc->Fill(charge / 1e3);
         }
 
-        auto time = time_of_arrival(pixel_charge, threshold);
+        auto time = batch.time[i];
         LOG(DEBUG) << "Local time of arrival: " << Units::display(time, {"ns", "ps"});
         if(output_plots_) {
             h_px_toa->Fill(time);
         }
-
-        // Simulate TDC if resolution set to more than 0bit
         if(tdc_resolution_ > 0) {
-            // temporarily store full arrival time for histogramming:
-            auto original_time = time;
-
-            // Add TDC smearing:
-            allpix::normal_distribution<double> tdc_smearing(0, tdc_smearing_);
-            time += tdc_smearing(event->getRandomEngine());
-            if(output_plots_) {
-                h_px_tdc_smear->Fill(time);
-            }
-            LOG(DEBUG) << "Smeared for simulating limited TDC sensitivity: " << Units::display(time, {"ns", "ps"});
-
-            // Convert to TDC units and precision, make sure TDC count is at least 1:
-            time = static_cast<double>(std::clamp(
-                static_cast<int>((tdc_offset_ + time) / tdc_slope_), (allow_zero_tdc_ ? 0 : 1), (1 << tdc_resolution_) - 1));
+            time = batch.tdc_time[i];
+            LOG(DEBUG) << "Smeared for simulating limited TDC sensitivity: "
+                       << Units::display(batch.smeared_time[i], {"ns", "ps"});
             LOG(DEBUG) << "Time converted to TDC units: " << time;
-
             if(output_plots_) {
-                h_toa_calibration->Fill(original_time, time);
+                h_px_tdc_smear->Fill(batch.smeared_time[i]);
+                h_toa_calibration->Fill(batch.time[i], time);
                 h_px_tdc->Fill(time);
             }
         } else if(output_plots_) {
@@ -313,24 +389,233 @@ void DefaultDigitizerModule::run(Event* event) {
         hits.emplace_back(pixel, time, pixel_charge.getGlobalTime() + time, charge, &pixel_charge);
     }
 
+    if(noise_hits_) {
+        add_noise_hits(event, pixel_charges, hits);
+    }
+
+    for(size_t setting = 0; setting < scan_settings_.size(); ++setting) {
+        digitize_scan_setting(event, pixel_charges, batch, setting);
+    }
+
     // Output summary and update statistics
     LOG(INFO) << "Digitized " << hits.size() << " pixel hits";
     total_hits_ += hits.size();
 
     if(!hits.empty()) {
         // Create and dispatch hit message
-        auto hits_message = std::make_shared<PixelHitMessage>(std::move(hits), getDetector());
+        auto hits_message = event->makeShared<PixelHitMessage>(std::move(hits), getDetector());
         messenger_->dispatchMessage(this, hits_message, event);
     }
 }
 
+/**
+ * The scan settings replace the common threshold and gain, the noise, the saturation and the deviations of threshold, gain,
+ * QDC and TDC of every pixel are the same as for the default setting.
+ */
+void DefaultDigitizerModule::digitize_scan_setting(Event* event,
+                                                   const std::vector<PixelCharge>& pixel_charges,
+                                                   const Batch& batch,
+                                                   size_t setting) {
+    const auto& [threshold_level, gain_level] = scan_settings_[setting];
+
+    std::vector<PixelHit> hits;
+    for(size_t i = 0; i < pixel_charges.size(); ++i) {
+        auto amplified_charge = batch.noisy_charge[i] * (gain_level + gain_smearing_ * batch.gain_deviation[i]);
+        auto charge = std::min(amplified_charge, batch.saturation[i]);
+        auto threshold = threshold_level + threshold_smearing_ * batch.threshold_deviation[i];
+        if(charge < threshold) {
+            continue;
+        }
+
+        if(qdc_resolution_ > 0) {
+            auto smeared_charge = charge + batch.qdc_noise[i];
+            charge = static_cast<double>(std::clamp(static_cast<int>((qdc_offset_ + smeared_charge) / qdc_slope_),
+                                                    (allow_zero_qdc_ ? 0 : 1),
+                                                    (1 << qdc_resolution_) - 1));
+        }
+        auto time = time_of_arrival(pixel_charges[i], threshold);
+        if(tdc_resolution_ > 0) {
+            time = static_cast<double>(std::clamp(static_cast<int>((tdc_offset_ + time + batch.tdc_noise[i]) / tdc_slope_),
+                                                  (allow_zero_tdc_ ? 0 : 1),
+                                                  (1 << tdc_resolution_) - 1));
+        }
+        const auto& pixel_charge = pixel_charges[i];
+        hits.emplace_back(pixel_charge.getPixel(), time, pixel_charge.getGlobalTime() + time, charge, &pixel_charge);
+    }
+
+    LOG(DEBUG) << "Digitized " << hits.size() << " pixel hits for scan setting " << setting << " with threshold "
+               << Units::display(threshold_level, "e") << " and gain " << gain_level;
+    total_scan_hits_[setting] += hits.size();
+    if(!hits.empty()) {
+        auto hits_message = event->makeShared<PixelHitMessage>(std::move(hits), getDetector());
+        messenger_->dispatchMessage(this, hits_message, event, "scan" + std::to_string(setting));
+    }
+}
+
+/**
+ * A pixel without charge passes the threshold if its noise, amplified by the gain, exceeds the smeared threshold. The
+ * difference of both is normally distributed with a width combining the amplified noise and the threshold smearing, its
+ * tail above the threshold gives the noise occupancy of the pixel. The gain smearing and the saturation are neglected.
+ */
+void DefaultDigitizerModule::compute_noise_occupancy() {
+    auto npixels = getDetector()->getModel()->getNPixels();
+    auto occupancy = [&](const PixelCalibrationMap::PixelIndex& index) {
+        auto width = noise_width(index);
+        if(width <= 0) {
+            return 0.;
+        }
+        return std::erfc(threshold_map_.get(index, threshold_) / (std::sqrt(2.) * width)) / 2.;
+    };
+
+    // Calibration maps make the occupancy differ between pixels, otherwise one value applies to all of them
+    noise_occupancy_.clear();
+    if(noise_map_.empty() && gain_map_.empty() && threshold_map_.empty()) {
+        max_noise_occupancy_ = occupancy({0, 0});
+    } else {
+        noise_occupancy_.resize(static_cast<size_t>(npixels.x()) * npixels.y());
+        for(unsigned int x = 0; x < npixels.x(); ++x) {
+            for(unsigned int y = 0; y < npixels.y(); ++y) {
+                noise_occupancy_[static_cast<size_t>(x) * npixels.y() + y] = occupancy({x, y});
+            }
+        }
+        max_noise_occupancy_ = *std::max_element(noise_occupancy_.begin(), noise_occupancy_.end());
+    }
+
+    auto mean_occupancy = max_noise_occupancy_;
+    if(!noise_occupancy_.empty()) {
+        mean_occupancy = std::accumulate(noise_occupancy_.begin(), noise_occupancy_.end(), 0.) /
+                         static_cast<double>(noise_occupancy_.size());
+    }
+    LOG(INFO) << "Generating noise hits with a mean occupancy of " << mean_occupancy << " per pixel, "
+              << mean_occupancy * static_cast<double>(npixels.x()) * npixels.y() << " noise hits per event";
+}
+
+double DefaultDigitizerModule::noise_width(const PixelCalibrationMap::PixelIndex& index) const {
+    auto noise = noise_map_.get(index, electronics_noise_) * gain_map_.get(index, gain_);
+    return std::sqrt(noise * noise + static_cast<double>(threshold_smearing_) * threshold_smearing_);
+}
+
+/**
+ * The candidate pixels are found by skipping a geometrically distributed number of pixels with the largest occupancy of all
+ * pixels, and accepted with the ratio of their own occupancy to the largest one. This only costs random numbers for the
+ * noise hits instead of for all pixels of the matrix. Pixels with charge are skipped since their noise is already simulated.
+ * The amplitude of a noise hit is drawn from the tail of its noise distribution above the threshold.
+ */
+void DefaultDigitizerModule::add_noise_hits(Event* event,
+                                            const std::vector<PixelCharge>& pixel_charges,
+                                            std::vector<PixelHit>& hits) {
+    if(max_noise_occupancy_ <= 0) {
+        return;
+    }
+
+    auto npixels = getDetector()->getModel()->getNPixels();
+    auto total_pixels = static_cast<size_t>(npixels.x()) * npixels.y();
+    auto position = [&](const Pixel::Index& index) { return static_cast<size_t>(index.x()) * npixels.y() + index.y(); };
+
+    std::vector<size_t> charged_pixels;
+    charged_pixels.reserve(pixel_charges.size());
+    for(const auto& pixel_charge : pixel_charges) {
+        charged_pixels.push_back(position(pixel_charge.getIndex()));
+    }
+    std::sort(charged_pixels.begin(), charged_pixels.end());
+
+    auto& random_engine = event->getRandomEngine();
+    allpix::uniform_real_distribution<double> uniform(0., 1.);
+    allpix::normal_distribution<double> normal(0., 1.);
+    allpix::normal_distribution<double> adc_smearing(0, qdc_smearing_);
+    allpix::normal_distribution<double> tdc_smearing(0, tdc_smearing_);
+    auto log_complement = std::log1p(-std::min(max_noise_occupancy_, 1. - std::numeric_limits<double>::epsilon()));
+
+    // Draw a standard normal value conditioned to be above a bound, using an exponential proposal for far tails
+    auto sample_tail = [&](double bound) {
+        if(bound <= 0.) {
+            while(true) {
+                auto value = normal(random_engine);
+                if(value > bound) {
+                    return value;
+                }
+            }
+        }
+        auto rate = (bound + std::sqrt(bound * bound + 4.)) / 2.;
+        allpix::exponential_distribution<double> exponential(rate);
+        while(true) {
+            auto value = bound + exponential(random_engine);
+            if(uniform(random_engine) <= std::exp(-(value - rate) * (value - rate) / 2.)) {
+                return value;
+            }
+        }
+    };
+
+    size_t noise_hits = 0;
+    size_t next = 0;
+    while(true) {
+        // Skip the pixels without noise hit, at least one minus the uniform value is always positive
+        auto skip = std::floor(std::log1p(-uniform(random_engine)) / log_complement);
+        if(skip >= static_cast<double>(total_pixels - next)) {
+            break;
+        }
+        auto candidate = next + static_cast<size_t>(skip);
+        next = candidate + 1;
+
+        if(!noise_occupancy_.empty() && uniform(random_engine) * max_noise_occupancy_ >= noise_occupancy_[candidate]) {
+            continue;
+        }
+        if(std::binary_search(charged_pixels.begin(), charged_pixels.end(), candidate)) {
+            continue;
+        }
+
+        Pixel::Index index(static_cast<unsigned int>(candidate / npixels.y()),
+                           static_cast<unsigned int>(candidate % npixels.y()));
+        auto width = noise_width(index);
+        double charge = width * sample_tail(threshold_map_.get(index, threshold_) / width);
+        if(qdc_resolution_ > 0) {
+            auto smeared_charge = charge + adc_smearing(random_engine);
+            charge = static_cast<double>(std::clamp(static_cast<int>((qdc_offset_ + smeared_charge) / qdc_slope_),
+                                                    (allow_zero_qdc_ ? 0 : 1),
+                                                    (1 << qdc_resolution_) - 1));
+        }
+        double time = 0.;
+        if(tdc_resolution_ > 0) {
+            auto smeared_time = tdc_smearing(random_engine);
+            time = static_cast<double>(std::clamp(static_cast<int>((tdc_offset_ + smeared_time) / tdc_slope_),
+                                                  (allow_zero_tdc_ ? 0 : 1),
+                                                  (1 << tdc_resolution_) - 1));
+        }
+
+        LOG(DEBUG) << "Noise hit in pixel " << index << " with charge " << Units::display(charge, "e");
+        hits.emplace_back(getDetector()->getPixel(index.x(), index.y()), time, time, charge);
+        ++noise_hits;
+    }
+
+    LOG(DEBUG) << "Generated " << noise_hits << " noise hits";
+    total_noise_hits_ += noise_hits;
+}
+
+PixelCalibrationMap DefaultDigitizerModule::load_calibration_map(const std::string& key, const std::string& units) const {
+    if(!config_.has(key)) {
+        return {};
+    }
+
+    try {
+        auto map = PixelCalibrationMap::load(config_.getPath(key, true), getDetector()->getModel()->getNPixels(), units);
+        LOG(INFO) << "Loaded per-pixel calibration \"" << key << "\" from file";
+        return map;
+    } catch(std::invalid_argument& e) {
+        throw InvalidValueError(config_, key, e.what());
+    } catch(std::runtime_error& e) {
+        throw InvalidValueError(config_, key, e.what());
+    } catch(std::bad_alloc& e) {
+        throw InvalidValueError(config_, key, "file too large");
+    }
+}
+
 double DefaultDigitizerModule::time_of_arrival(const PixelCharge& pixel_charge, double threshold) const {
 
     // If this PixelCharge has a pulse, we can find out when it crossed the threshold:
     const auto& pulse = pixel_charge.getPulse();
     if(pulse.isInitialized()) {
-        auto charges = pulse.getPulse();
-        std::vector<double>::iterator bin;
+        const auto& charges = pulse.getPulse();
+        std::vector<double>::const_iterator bin;
         double integrated_charge = 0;
         for(bin = charges.begin(); bin != charges.end(); bin++) {
             integrated_charge += *bin;
@@ -346,6 +631,10 @@ double DefaultDigitizerModule::time_of_arrival(const PixelCharge& pixel_charge,
 }
 
 void DefaultDigitizerModule::finalize() {
+    if(noise_hits_) {
+        LOG(INFO) << "Generated total of " << total_noise_hits_ << " noise hits";
+    }
+
     if(output_plots_) {
         // Write histograms
         LOG(TRACE) << "Writing output plots to file";
@@ -375,4 +664,11 @@ void DefaultDigitizerModule::finalize() {
     }
 
     LOG(INFO) << "Digitized " << total_hits_ << " pixel hits in total";
+    if(!scan_settings_.empty()) {
+        std::string scan_hits;
+        for(const auto& hits : total_scan_hits_) {
+            scan_hits += (scan_hits.empty() ? "" : ", ") + std::to_string(hits.load());
+        }
+        LOG(INFO) << "Digitized " << scan_hits << " pixel hits in total for the scan settings";
+    }
 }
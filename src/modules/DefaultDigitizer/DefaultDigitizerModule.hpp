@@ -10,9 +10,11 @@
 #ifndef ALLPIX_DEFAULT_DIGITIZER_MODULE_H
 #define ALLPIX_DEFAULT_DIGITIZER_MODULE_H
 
+#include <atomic>
 #include <memory>
 #include <random>
 #include <string>
+#include <vector>
 
 #include "core/config/Configuration.hpp"
 #include "core/messenger/Messenger.hpp"
@@ -20,8 +22,10 @@
 #include "core/module/Module.hpp"
 
 #include "objects/PixelCharge.hpp"
+#include "objects/PixelHit.hpp"
 
 #include "tools/ROOT.h"
+#include "tools/pixel_calibration.h"
 
 #include <TH1D.h>
 #include <TH2D.h>
@@ -56,6 +60,11 @@ namespace allpix {
          */
         void run(Event*) override;
 
+        /**
+         * @brief Simulate digitization process for a batch of events, sharing the intermediate arrays
+         */
+        void run(const std::vector<Event*>& events) override;
+
         /**
          * @brief Finalize and write optional histograms
          */
@@ -64,6 +73,50 @@ namespace allpix {
     private:
         Messenger* messenger_;
 
+        /**
+         * @brief Intermediate values of the digitization of all pixels of an event, stored as one array per quantity
+         */
+        struct Batch {
+            std::vector<double> noise_level, gain_level, threshold_level;
+            std::vector<double> charge, noisy_charge, gain, amplified_charge, saturation, saturated_charge, threshold;
+            std::vector<double> gain_deviation, threshold_deviation;
+            std::vector<double> qdc_noise, smeared_charge, qdc_charge;
+            std::vector<double> time, tdc_noise, smeared_time, tdc_time;
+            std::vector<unsigned char> passed;
+
+            void resize(size_t pixels) {
+                for(auto* values : {&noise_level,
+                                    &gain_level,
+                                    &threshold_level,
+                                    &charge,
+                                    &noisy_charge,
+                                    &gain,
+                                    &amplified_charge,
+                                    &saturation,
+                                    &saturated_charge,
+                                    &threshold,
+                                    &gain_deviation,
+                                    &threshold_deviation,
+                                    &qdc_noise,
+                                    &smeared_charge,
+                                    &qdc_charge,
+                                    &time,
+                                    &tdc_noise,
+                                    &smeared_time,
+                                    &tdc_time}) {
+                    values->resize(pixels);
+                }
+                passed.resize(pixels);
+            }
+        };
+
+        /**
+         * @brief Digitize the pixel charges of an event
+         * @param event Event to digitize
+         * @param batch Arrays of intermediate values, resized to the number of pixels of the event
+         */
+        void digitize(Event* event, Batch& batch);
+
         /**
          * @brief Helper function to calculate time of crossing the threshold
          * @param  pixel_charge PixelCharge object to calculate the threshold crossing for
@@ -72,6 +125,47 @@ namespace allpix {
          */
         double time_of_arrival(const PixelCharge& pixel_charge, double threshold) const;
 
+        /**
+         * @brief Create and dispatch the hits of a setting of the threshold or gain scan
+         * @param event Event to digitize
+         * @param pixel_charges Pixel charges of the event
+         * @param batch Intermediate values of the digitization of the default setting
+         * @param setting Index of the scan setting
+         */
+        void digitize_scan_setting(Event* event,
+                                   const std::vector<PixelCharge>& pixel_charges,
+                                   const Batch& batch,
+                                   size_t setting);
+
+        /**
+         * @brief Compute the probability of every pixel without charge to pass the threshold
+         */
+        void compute_noise_occupancy();
+
+        /**
+         * @brief Width of the noise relative to the threshold of a pixel, combining the amplified noise and the threshold
+         * smearing
+         * @param index Index of the pixel
+         * @return Width of the noise distribution
+         */
+        double noise_width(const PixelCalibrationMap::PixelIndex& index) const;
+
+        /**
+         * @brief Generate hits from noise passing the threshold in pixels without charge
+         * @param event Event to generate the noise hits for
+         * @param pixel_charges Pixel charges of the event, their pixels do not receive noise hits
+         * @param hits List of hits to add the noise hits to
+         */
+        void add_noise_hits(Event* event, const std::vector<PixelCharge>& pixel_charges, std::vector<PixelHit>& hits);
+
+        /**
+         * @brief Helper function to load a per-pixel calibration map if configured
+         * @param key Configuration key of the path to the map
+         * @param units Units of the values in file formats not using internal units
+         * @return Calibration map, empty if the key is not configured
+         */
+        PixelCalibrationMap load_calibration_map(const std::string& key, const std::string& units) const;
+
         // Configuration
         bool output_plots_{};
 
@@ -83,6 +177,9 @@ namespace allpix {
 
         unsigned int threshold_{}, threshold_smearing_{};
 
+        // Threshold and gain of every setting of a scan
+        std::vector<std::pair<double, double>> scan_settings_;
+
         int qdc_resolution_{};
         unsigned int qdc_smearing_{};
         double qdc_offset_{};
@@ -95,8 +192,18 @@ namespace allpix {
         double tdc_slope_{};
         bool allow_zero_tdc_{};
 
+        // Per-pixel calibration
+        PixelCalibrationMap noise_map_, gain_map_, threshold_map_;
+
+        // Noise hits in pixels without charge, with the occupancy of every pixel only stored if calibration maps are used
+        bool noise_hits_{};
+        std::vector<double> noise_occupancy_;
+        double max_noise_occupancy_{};
+
         // Statistics
         std::atomic<unsigned long long> total_hits_{};
+        std::atomic<unsigned long long> total_noise_hits_{};
+        std::vector<std::atomic<unsigned long long>> total_scan_hits_;
 
         // Output histograms
         Histogram<TH1D> h_pxq, h_pxq_noise, h_gain, h_pxq_gain, h_thr, h_pxq_thr, h_pxq_sat, h_pxq_adc_smear, h_pxq_adc,
@@ -0,0 +1,90 @@
+/**
+ * @file
+ * @brief Implementation of the module rejecting events without sufficient charge deposits
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "DepositionFilterModule.hpp"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/module/exceptions.h"
+#include "core/utils/log.h"
+#include "core/utils/unit.h"
+
+using namespace allpix;
+
+DepositionFilterModule::DepositionFilterModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager)
+    : Module(config), geo_manager_(geo_manager), messenger_(messenger) {
+    // Enable multithreading of this module if multithreading is enabled
+    allow_multithreading();
+
+    config_.setDefaultArray<std::string>("detectors", {});
+    config_.setDefault<int>("minimum_charge", Units::get(1, "e"));
+    config_.setDefault<int>("minimum_total_charge", 0);
+
+    minimum_charge_ = config_.get<unsigned int>("minimum_charge");
+    minimum_total_charge_ = config_.get<unsigned int>("minimum_total_charge");
+
+    // Receive the deposits of all detectors, events without any deposits need to be rejected as well
+    messenger_->bindMulti<DepositedChargeMessage>(this, MsgFlags::NONE);
+}
+
+void DepositionFilterModule::initialize() {
+    for(const auto& name : config_.getArray<std::string>("detectors")) {
+        if(!geo_manager_->hasDetector(name)) {
+            throw InvalidValueError(config_, "detectors", "detector '" + name + "' is not part of the geometry");
+        }
+        required_detectors_.push_back(geo_manager_->getDetector(name));
+    }
+    if(required_detectors_.empty() && minimum_total_charge_ == 0) {
+        LOG(WARNING) << "Neither required detectors nor a minimum total charge configured, no event will be rejected";
+    }
+}
+
+void DepositionFilterModule::run(Event* event) {
+    // Count the deposited electrons for every detector, every deposited electron comes with a hole
+    std::map<std::shared_ptr<const Detector>, unsigned int> detector_charge;
+    unsigned int total_charge = 0;
+    auto messages = messenger_->fetchMultiMessage<DepositedChargeMessage>(this, event);
+    for(auto& message : messages) {
+        for(const auto& deposit : message->getData()) {
+            if(deposit.getType() == CarrierType::ELECTRON) {
+                detector_charge[message->getDetector()] += deposit.getCharge();
+                total_charge += deposit.getCharge();
+            }
+        }
+    }
+
+    for(const auto& detector : required_detectors_) {
+        auto charge = detector_charge[detector];
+        if(charge < minimum_charge_) {
+            LOG(DEBUG) << "Rejecting event, detector " << detector->getName() << " received "
+                       << Units::display(charge, "e") << " below the minimum charge";
+            event->reject();
+            rejected_events_++;
+            return;
+        }
+    }
+    if(total_charge < minimum_total_charge_) {
+        LOG(DEBUG) << "Rejecting event, detectors received " << Units::display(total_charge, "e")
+                   << " in total below the minimum total charge";
+        event->reject();
+        rejected_events_++;
+        return;
+    }
+
+    LOG(DEBUG) << "Accepting event with " << Units::display(total_charge, "e") << " deposited in total";
+    accepted_events_++;
+}
+
+void DepositionFilterModule::finalize() {
+    LOG(INFO) << "Accepted " << accepted_events_ << " and rejected " << rejected_events_ << " events";
+}
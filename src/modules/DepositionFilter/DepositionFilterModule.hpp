@@ -0,0 +1,71 @@
+/**
+ * @file
+ * @brief Definition of the module rejecting events without sufficient charge deposits
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/config/Configuration.hpp"
+#include "core/geometry/GeometryManager.hpp"
+#include "core/messenger/Messenger.hpp"
+#include "core/module/Event.hpp"
+#include "core/module/Module.hpp"
+
+#include "objects/DepositedCharge.hpp"
+
+namespace allpix {
+    /**
+     * @ingroup Modules
+     * @brief Module to reject events without sufficient charge deposits before the expensive simulation steps
+     *
+     * The deposited charge is counted from the electrons deposited in every detector. Events in which one of the required
+     * detectors or all detectors together received less than the configured charge are rejected, such that all later
+     * modules including the writers skip them.
+     */
+    class DepositionFilterModule : public Module {
+    public:
+        /**
+         * @brief Constructor for this unique module
+         * @param config Configuration object for this module as retrieved from the steering file
+         * @param messenger Pointer to the messenger object to allow binding to messages on the bus
+         * @param geo_manager Pointer to the geometry manager, containing the detectors
+         */
+        DepositionFilterModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager);
+
+        /**
+         * @brief Resolve the required detectors
+         */
+        void initialize() override;
+
+        /**
+         * @brief Sum the deposited charge of the event and reject it if below the thresholds
+         */
+        void run(Event* event) override;
+
+        /**
+         * @brief Display statistical summary
+         */
+        void finalize() override;
+
+    private:
+        GeometryManager* geo_manager_;
+        Messenger* messenger_;
+
+        // Detectors which all need to receive the minimum charge
+        std::vector<std::shared_ptr<const Detector>> required_detectors_;
+
+        unsigned int minimum_charge_{};
+        unsigned int minimum_total_charge_{};
+
+        // Statistics
+        std::atomic<size_t> accepted_events_{};
+        std::atomic<size_t> rejected_events_{};
+    };
+} // namespace allpix
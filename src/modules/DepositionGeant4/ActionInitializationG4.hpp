@@ -16,6 +16,7 @@
 
 #include "GeneratorActionG4.hpp"
 #include "SetTrackInfoUserHookG4.hpp"
+#include "TrackKillerG4.hpp"
 
 namespace allpix {
     class DepositionGeant4Module;
@@ -24,8 +25,10 @@ namespace allpix {
      */
     class ActionInitializationG4 : public G4VUserActionInitialization {
     public:
-        explicit ActionInitializationG4(const Configuration& config, DepositionGeant4Module* module)
-            : config_(config), module_(module){};
+        ActionInitializationG4(const Configuration& config,
+                               DepositionGeant4Module* module,
+                               const TrackKillingConditions& track_killing)
+            : config_(config), module_(module), track_killing_(track_killing){};
 
         /**
          * @brief Build the user action to be executed by the worker
@@ -37,6 +40,14 @@ namespace allpix {
 
             // tracker hook
             SetUserAction(new SetTrackInfoUserHookG4(module_));
+
+            // actions killing tracks which are not of interest, only added if enabled to avoid overhead per step
+            if(!track_killing_.particles.empty()) {
+                SetUserAction(new TrackKillerStackingActionG4(track_killing_));
+            }
+            if(track_killing_.killSteps()) {
+                SetUserAction(new TrackKillerSteppingActionG4(track_killing_));
+            }
         };
 
         /**
@@ -58,6 +69,7 @@ namespace allpix {
     private:
         const Configuration& config_;
         DepositionGeant4Module* module_;
+        const TrackKillingConditions& track_killing_;
     };
 } // namespace allpix
 
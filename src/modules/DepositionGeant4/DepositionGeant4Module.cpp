@@ -10,19 +10,34 @@
 
 #include "DepositionGeant4Module.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
 #include <limits>
+#include <map>
+#include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <G4EmParameters.hh>
 #include <G4HadronicProcessStore.hh>
 #include <G4LogicalVolume.hh>
+#include <G4Material.hh>
 #include <G4NuclearLevelData.hh>
+#include <G4PVPlacement.hh>
+#include <G4ParticleTable.hh>
 #include <G4PhysListFactory.hh>
+#include <G4ProductionCuts.hh>
 #include <G4RadioactiveDecayPhysics.hh>
+#include <G4Region.hh>
 #include <G4StepLimiterPhysics.hh>
 #include <G4UImanager.hh>
 #include <G4UserLimits.hh>
+#include <G4Version.hh>
 
 #include "G4FieldManager.hh"
 #include "G4TransportationManager.hh"
@@ -30,6 +45,7 @@
 
 #include "core/config/exceptions.h"
 #include "core/geometry/GeometryManager.hpp"
+#include "core/module/ThreadPool.hpp"
 #include "core/module/exceptions.h"
 #include "core/utils/log.h"
 #include "objects/DepositedCharge.hpp"
@@ -40,8 +56,10 @@
 
 #include "ActionInitializationG4.hpp"
 #include "GeneratorActionG4.hpp"
+#include "MagneticFieldG4.hpp"
 #include "SDAndFieldConstruction.hpp"
 #include "SensitiveDetectorActionG4.hpp"
+#include "SensitiveDetectorDispatcherG4.hpp"
 #include "SetTrackInfoUserHookG4.hpp"
 
 #define G4_NUM_SEEDS 10
@@ -66,6 +84,10 @@ DepositionGeant4Module::DepositionGeant4Module(Configuration& config, Messenger*
     // Set defaults for charge carrier creation
     config_.setDefault("fano_factor", 0.115);
     config_.setDefault("charge_creation_energy", Units::get(3.64, "eV"));
+    config_.setDefault<double>("deposit_merge_distance", 0);
+    if(config_.get<double>("deposit_merge_distance") < 0) {
+        throw InvalidValueError(config_, "deposit_merge_distance", "merge distance cannot be negative");
+    }
 
     config_.setDefault("source_type", "beam");
     config_.setDefault<bool>("output_plots", false);
@@ -74,6 +96,12 @@ DepositionGeant4Module::DepositionGeant4Module(Configuration& config, Messenger*
     // Default value chosen to ensure proper gamma generation for Cs137 decay
     config_.setDefault<double>("cutoff_time", 2.21e+11);
 
+    // Track killing is disabled by default
+    config_.setDefault<bool>("kill_outside_region", false);
+    config_.setDefault<double>("kill_region_margin", Units::get(1.0, "mm"));
+    config_.setDefault<double>("kill_energy_cut", 0);
+    config_.setDefaultArray<std::string>("kill_particles", {});
+
     // Create user limits for maximum step length and maximum event time in the sensor
     user_limits_ =
         std::make_unique<G4UserLimits>(config_.get<double>("max_step_length"), DBL_MAX, config_.get<double>("cutoff_time"));
@@ -111,6 +139,14 @@ void DepositionGeant4Module::initialize() {
     MTRunManager* run_manager_mt = nullptr;
 
     number_of_particles_ = config_.get<unsigned int>("number_of_particles", 1);
+    number_of_subevents_ = config_.get<unsigned int>("number_of_subevents", 1);
+    if(number_of_subevents_ == 0) {
+        throw InvalidValueError(config_, "number_of_subevents", "number of subevents should be at least one");
+    }
+    if(number_of_subevents_ > number_of_particles_) {
+        LOG(WARNING) << "Number of subevents larger than the number of particles, using one subevent per particle";
+        number_of_subevents_ = std::max(number_of_particles_, 1u);
+    }
     output_plots_ = config_.get<bool>("output_plots");
 
     // Load the G4 run manager (which is owned by the geometry builder)
@@ -129,6 +165,25 @@ void DepositionGeant4Module::initialize() {
     // Get UI manager for sending commands
     G4UImanager* ui_g4 = G4UImanager::GetUIpointer();
 
+    // Create a region for the sensor of every detector to confine the PAI model and the fine production cuts to it
+    // Detectors sharing the volumes of their model share a single region
+    std::map<std::string, G4Region*> sensor_regions;
+    std::map<G4LogicalVolume*, G4Region*> volume_regions;
+    for(auto& detector : geo_manager_->getDetectors()) {
+        // Get logical volume
+        auto logical_volume = geo_manager_->getExternalObject<G4LogicalVolume>(detector->getName(), "sensor_log");
+        if(logical_volume == nullptr) {
+            throw ModuleError("Detector " + detector->getName() + " has no sensitive device (broken Geant4 geometry)");
+        }
+        // Create region
+        auto& region = volume_regions[logical_volume.get()];
+        if(region == nullptr) {
+            region = new G4Region(detector->getName() + "_sensor_region");
+            region->AddRootLogicalVolume(logical_volume.get());
+        }
+        sensor_regions[detector->getName()] = region;
+    }
+
     // Apply optional PAI model
     if(config_.get<bool>("enable_pai", false)) {
         LOG(TRACE) << "Enabling PAI model on all detectors";
@@ -145,16 +200,7 @@ void DepositionGeant4Module::initialize() {
             throw InvalidValueError(config_, "pai_model", "model has to be either 'pai' or 'paiphoton'");
         }
 
-        for(auto& detector : geo_manager_->getDetectors()) {
-            // Get logical volume
-            auto logical_volume = geo_manager_->getExternalObject<G4LogicalVolume>(detector->getName(), "sensor_log");
-            if(logical_volume == nullptr) {
-                throw ModuleError("Detector " + detector->getName() + " has no sensitive device (broken Geant4 geometry)");
-            }
-            // Create region
-            auto* region = new G4Region(detector->getName() + "_sensor_region");
-            region->AddRootLogicalVolume(logical_volume.get());
-
+        for(auto& [volume, region] : volume_regions) {
             G4EmParameters::Instance()->AddPAIModel("all", region->GetName(), pai_model);
         }
     }
@@ -193,30 +239,55 @@ void DepositionGeant4Module::initialize() {
     // Register radioactive decay physics lists
     physicsList->RegisterPhysics(new G4RadioactiveDecayPhysics());
 
-    // Set the range-cut off threshold for secondary production:
+    // Set the range-cut off threshold for secondary production in the sensor regions:
+    std::map<std::string, double> sensor_cuts;
+    for(auto& detector : geo_manager_->getDetectors()) {
+        double production_cut = NAN;
+        if(config_.has("range_cut")) {
+            production_cut = config_.get<double>("range_cut");
+        } else {
+            // Define the production cut as one fifth of the minimum size (thickness, pitch) of the detector
+            auto model = detector->getModel();
+            production_cut =
+                std::min({model->getPixelSize().x(), model->getPixelSize().y(), model->getSensorSize().z()}) / 5;
+        }
+        LOG(INFO) << "Setting G4 production cut in sensor of detector \"" << detector->getName() << "\" to "
+                  << Units::display(production_cut, {"mm", "um"});
+
+        auto* cuts = new G4ProductionCuts();
+        cuts->SetProductionCut(production_cut);
+        sensor_regions[detector->getName()]->SetProductionCuts(cuts);
+        sensor_cuts[detector->getName()] = production_cut;
+    }
+
+    // Set the range-cut off threshold for secondary production in the passive materials and the world:
     double production_cut = NAN;
-    if(config_.has("range_cut")) {
-        production_cut = config_.get<double>("range_cut");
-        LOG(INFO) << "Setting configured G4 production cut to " << Units::display(production_cut, {"mm", "um"});
+    if(config_.has("range_cut_world")) {
+        production_cut = config_.get<double>("range_cut_world");
     } else {
-        // Define the production cut as one fifth of the minimum size (thickness, pitch) among the detectors
-        double min_size = std::numeric_limits<double>::max();
-        std::string min_detector;
-        for(auto& detector : geo_manager_->getDetectors()) {
-            auto model = detector->getModel();
-            double prev_min_size = min_size;
-            min_size =
-                std::min({min_size, model->getPixelSize().x(), model->getPixelSize().y(), model->getSensorSize().z()});
-            if(min_size != prev_min_size) {
-                min_detector = detector->getName();
-            }
+        // Use the finest cut of all sensors by default
+        production_cut = std::numeric_limits<double>::max();
+        for(auto& [name, cut] : sensor_cuts) {
+            production_cut = std::min(production_cut, cut);
         }
-        production_cut = min_size / 5;
-        LOG(INFO) << "Setting G4 production cut to " << Units::display(production_cut, {"mm", "um"})
-                  << ", derived from properties of detector \"" << min_detector << "\"";
     }
+    LOG(INFO) << "Setting G4 production cut outside of the sensors to " << Units::display(production_cut, {"mm", "um"});
     ui_g4->ApplyCommand("/run/setCut " + std::to_string(production_cut));
 
+    // Retrieve the physics tables from the cache if they have been stored for the same physics setup before
+    if(config_.has("physics_table_cache")) {
+        physics_table_directory_ = physics_table_cache_directory(production_cut, sensor_cuts);
+        if(std::filesystem::exists(std::filesystem::path(physics_table_directory_) / "physics_setup.txt")) {
+            LOG(INFO) << "Retrieving G4 physics tables from cache directory " << physics_table_directory_;
+            physicsList->SetPhysicsTableRetrieved(physics_table_directory_);
+        } else {
+            LOG(INFO) << "No cached G4 physics tables found, storing tables to " << physics_table_directory_
+                      << " at the end of the run";
+            store_physics_tables_ = true;
+        }
+    }
+    physics_list_ = physicsList;
+
     // Set user limits on world volume:
     auto world_log_volume = geo_manager_->getExternalObject<G4LogicalVolume>("", "world_log");
     if(world_log_volume != nullptr) {
@@ -241,27 +312,59 @@ void DepositionGeant4Module::initialize() {
     // Initialize the full run manager to ensure correct state flags
     run_manager_g4_->Initialize();
 
+    // Set up the conditions to kill tracks which do not contribute to the deposits in the sensors
+    if(config_.get<bool>("kill_outside_region")) {
+        auto margin = config_.get<double>("kill_region_margin");
+        if(margin < 0) {
+            throw InvalidValueError(config_, "kill_region_margin", "margin of the region of interest cannot be negative");
+        }
+        track_killing_.kill_outside_region = true;
+        track_killing_.region_min = toG4Vector(geo_manager_->getMinimumCoordinate()) - G4ThreeVector(margin, margin, margin);
+        track_killing_.region_max = toG4Vector(geo_manager_->getMaximumCoordinate()) + G4ThreeVector(margin, margin, margin);
+        LOG(INFO) << "Killing tracks leaving the region of interest from "
+                  << Units::display(geo_manager_->getMinimumCoordinate(), {"mm", "cm"}) << " to "
+                  << Units::display(geo_manager_->getMaximumCoordinate(), {"mm", "cm"}) << " with a margin of "
+                  << Units::display(margin, {"mm", "um"});
+    }
+    track_killing_.energy_cut = config_.get<double>("kill_energy_cut");
+    if(track_killing_.energy_cut < 0) {
+        throw InvalidValueError(config_, "kill_energy_cut", "energy cut cannot be negative");
+    }
+    if(track_killing_.energy_cut > 0) {
+        LOG(INFO) << "Killing tracks outside of the sensors below "
+                  << Units::display(track_killing_.energy_cut, {"keV", "MeV", "GeV"});
+    }
+    for(const auto& particle : config_.getArray<std::string>("kill_particles")) {
+        auto* definition = G4ParticleTable::GetParticleTable()->FindParticle(particle);
+        if(definition == nullptr) {
+            throw InvalidValueError(config_, "kill_particles", "particle type '" + particle + "' is not known to Geant4");
+        }
+        track_killing_.particles.insert(definition);
+        LOG(INFO) << "Killing secondary particles of type " << particle;
+    }
+
     // Build particle generator
     // User hook to store additional information at track initialization and termination as well as custom track ids
     LOG(TRACE) << "Constructing particle source";
 
-    auto* action_initialization = new ActionInitializationG4(config_, this);
+    auto* action_initialization = new ActionInitializationG4(config_, this, track_killing_);
     run_manager_g4_->SetUserInitialization(action_initialization);
 
     // Get the creation energy for charge (default is silicon electron hole pair energy)
     auto charge_creation_energy = config_.get<double>("charge_creation_energy");
     auto fano_factor = config_.get<double>("fano_factor");
     auto cutoff_time = config_.get<double>("cutoff_time");
+    auto merge_distance = config_.get<double>("deposit_merge_distance");
 
     // Construct the sensitive detectors and fields.
     if(run_manager_mt == nullptr) {
         // Create the info track manager for the main thread before creating the Sensitive detectors.
         track_info_manager_ = std::make_unique<TrackInfoManager>();
-        construct_sensitive_detectors_and_fields(fano_factor, charge_creation_energy, cutoff_time);
+        construct_sensitive_detectors_and_fields(fano_factor, charge_creation_energy, cutoff_time, merge_distance);
     } else {
         // In MT-mode we register a builder that will be called for each thread to construct the SD when needed.
-        auto detector_construction =
-            std::make_unique<SDAndFieldConstruction>(this, fano_factor, charge_creation_energy, cutoff_time);
+        auto detector_construction = std::make_unique<SDAndFieldConstruction>(
+            this, fano_factor, charge_creation_energy, cutoff_time, merge_distance);
         run_manager_mt->SetSDAndFieldConstruction(std::move(detector_construction));
     }
 
@@ -289,23 +392,20 @@ void DepositionGeant4Module::initializeThread() {
 
 void DepositionGeant4Module::run(Event* event) {
 
-    // Seed the sensitive detectors RNG
-    for(auto& sensor : sensors_) {
-        sensor->seed(event->getRandomNumber());
-    }
-
-    // Start a single event from the beam
-    LOG(TRACE) << "Enabling beam";
-    auto seed1 = event->getRandomNumber();
-    auto seed2 = event->getRandomNumber();
-    LOG(DEBUG) << "Seeding Geant4 event with seeds " << seed1 << " " << seed2;
-
-    if(multithreadingEnabled()) {
-        auto* run_manager_mt = static_cast<MTRunManager*>(run_manager_g4_);
-        run_manager_mt->Run(static_cast<int>(number_of_particles_), seed1, seed2);
+    if(number_of_subevents_ > 1) {
+        run_subevents(event);
     } else {
-        auto* run_manager = static_cast<RunManager*>(run_manager_g4_);
-        run_manager->Run(static_cast<int>(number_of_particles_), seed1, seed2);
+        // Seed the sensitive detectors RNG
+        for(auto& sensor : sensors_) {
+            sensor->seed(event->getRandomNumber());
+        }
+
+        // Start a single event from the beam
+        LOG(TRACE) << "Enabling beam";
+        auto seed1 = event->getRandomNumber();
+        auto seed2 = event->getRandomNumber();
+        LOG(DEBUG) << "Seeding Geant4 event with seeds " << seed1 << " " << seed2;
+        run_geant4(number_of_particles_, seed1, seed2);
     }
 
     uint64_t last_event_num = last_event_num_.load();
@@ -329,6 +429,19 @@ void DepositionGeant4Module::run(Event* event) {
 }
 
 void DepositionGeant4Module::finalize() {
+    // Store the physics tables built during this run in the cache
+    if(store_physics_tables_ && last_event_num_ > 0) {
+        std::filesystem::create_directories(physics_table_directory_);
+        if(physics_list_->StorePhysicsTable(physics_table_directory_)) {
+            // The description of the setup marks the cache entry as complete
+            std::ofstream setup_file(std::filesystem::path(physics_table_directory_) / "physics_setup.txt");
+            setup_file << physics_setup_;
+            LOG(INFO) << "Stored G4 physics tables in cache directory " << physics_table_directory_;
+        } else {
+            LOG(WARNING) << "Storing G4 physics tables in cache directory " << physics_table_directory_ << " failed";
+        }
+    }
+
     if(output_plots_) {
         // Write histograms
         LOG(TRACE) << "Writing output plots to file";
@@ -362,7 +475,8 @@ void DepositionGeant4Module::finalizeThread() {
 
 void DepositionGeant4Module::construct_sensitive_detectors_and_fields(double fano_factor,
                                                                       double charge_creation_energy,
-                                                                      double cutoff_time) {
+                                                                      double cutoff_time,
+                                                                      double merge_distance) {
     if(geo_manager_->hasMagneticField()) {
         MagneticFieldType magnetic_field_type_ = geo_manager_->getMagneticFieldType();
 
@@ -373,10 +487,21 @@ void DepositionGeant4Module::construct_sensitive_detectors_and_fields(double fan
             globalFieldMgr->SetDetectorField(magField);
             globalFieldMgr->CreateChordFinder(magField);
         } else {
-            throw ModuleError("Magnetic field enabled, but not constant. This can't be handled by this module yet.");
+            // Evaluate the field function of the geometry manager at every step, e.g. for a field interpolated from a grid
+            G4MagneticField* magField = new MagneticFieldG4(geo_manager_);
+            G4FieldManager* globalFieldMgr = G4TransportationManager::GetTransportationManager()->GetFieldManager();
+            globalFieldMgr->SetDetectorField(magField);
+            globalFieldMgr->CreateChordFinder(magField);
         }
     }
 
+    // Count the detectors placing every sensor volume, more than one if the volumes of their model are shared
+    std::map<G4LogicalVolume*, size_t> volume_detectors;
+    for(auto& detector : geo_manager_->getDetectors()) {
+        ++volume_detectors[geo_manager_->getExternalObject<G4LogicalVolume>(detector->getName(), "sensor_log").get()];
+    }
+    std::map<G4LogicalVolume*, SensitiveDetectorDispatcherG4*> dispatchers;
+
     // Loop through all detectors and set the sensitive detector action that handles the particle passage
     bool useful_deposition = false;
     for(auto& detector : geo_manager_->getDetectors()) {
@@ -395,8 +520,13 @@ void DepositionGeant4Module::construct_sensitive_detectors_and_fields(double fan
         auto* hit_transform = calculate_hit_transform(detector->getModel());
 
         // Get model of the sensitive device
-        auto* sensitive_detector_action = new SensitiveDetectorActionG4(
-            detector, track_info_manager_.get(), hit_transform, charge_creation_energy, fano_factor, cutoff_time);
+        auto* sensitive_detector_action = new SensitiveDetectorActionG4(detector,
+                                                                        track_info_manager_.get(),
+                                                                        hit_transform,
+                                                                        charge_creation_energy,
+                                                                        fano_factor,
+                                                                        cutoff_time,
+                                                                        merge_distance);
         auto logical_volume = geo_manager_->getExternalObject<G4LogicalVolume>(detector->getName(), "sensor_log");
         if(logical_volume == nullptr) {
             throw ModuleError("Detector " + detector->getName() + " has no sensitive device (broken Geant4 geometry)");
@@ -405,8 +535,18 @@ void DepositionGeant4Module::construct_sensitive_detectors_and_fields(double fan
         // Apply the user limits to this element
         logical_volume->SetUserLimits(user_limits_.get());
 
-        // Add the sensitive detector action
-        logical_volume->SetSensitiveDetector(sensitive_detector_action);
+        // Add the sensitive detector action, through a dispatcher selecting the detector if the volume is shared
+        if(volume_detectors[logical_volume.get()] > 1) {
+            auto& dispatcher = dispatchers[logical_volume.get()];
+            if(dispatcher == nullptr) {
+                dispatcher = new SensitiveDetectorDispatcherG4(logical_volume->GetName());
+                logical_volume->SetSensitiveDetector(dispatcher);
+            }
+            auto wrapper_phys = geo_manager_->getExternalObject<G4PVPlacement>(detector->getName(), "wrapper_phys");
+            dispatcher->addAction(wrapper_phys->GetCopyNo(), sensitive_detector_action);
+        } else {
+            logical_volume->SetSensitiveDetector(sensitive_detector_action);
+        }
         sensors_.push_back(sensitive_detector_action);
 
         // If requested, prepare output plots
@@ -435,6 +575,86 @@ void DepositionGeant4Module::construct_sensitive_detectors_and_fields(double fan
     }
 }
 
+void DepositionGeant4Module::run_geant4(unsigned int number_of_particles, uint64_t seed1, uint64_t seed2) {
+    if(multithreadingEnabled()) {
+        auto* run_manager_mt = static_cast<MTRunManager*>(run_manager_g4_);
+        run_manager_mt->Run(static_cast<int>(number_of_particles), seed1, seed2);
+    } else {
+        auto* run_manager = static_cast<RunManager*>(run_manager_g4_);
+        run_manager->Run(static_cast<int>(number_of_particles), seed1, seed2);
+    }
+}
+
+/**
+ * Every subevent is a separate Geant4 run on the worker run manager of the thread executing it. Its tracks and deposits are
+ * moved out of the thread-local track manager and sensitive detectors directly after the run, such that these are empty
+ * again whenever a subtask starts, also if the thread executes subevents of another event. The tracks of every subevent
+ * are numbered from a distinct range of ids. The records are merged on the calling thread in the order of the subevents
+ * and dispatched as for a single run, such that the result does not depend on the distribution over the workers.
+ */
+void DepositionGeant4Module::run_subevents(Event* event) {
+    struct Subevent {
+        unsigned int number_of_particles{};
+        uint64_t seed1{};
+        uint64_t seed2{};
+        TrackInfoManager tracks;
+        std::map<std::string, SensitiveDetectorActionG4::Record> records;
+    };
+
+    // Derive the seeds of all subevents from the event
+    std::vector<Subevent> subevents(number_of_subevents_);
+    for(unsigned int idx = 0; idx < number_of_subevents_; ++idx) {
+        auto& subevent = subevents[idx];
+        subevent.number_of_particles = static_cast<unsigned int>(
+            (static_cast<uint64_t>(number_of_particles_) * (idx + 1)) / number_of_subevents_ -
+            (static_cast<uint64_t>(number_of_particles_) * idx) / number_of_subevents_);
+        subevent.seed1 = event->getRandomNumber();
+        subevent.seed2 = event->getRandomNumber();
+    }
+    auto track_id_range = std::numeric_limits<int>::max() / static_cast<int>(number_of_subevents_);
+
+    auto simulate = [&](unsigned int idx) {
+        auto& subevent = subevents[idx];
+        LOG(DEBUG) << "Seeding Geant4 subevent " << idx << " with seeds " << subevent.seed1 << " " << subevent.seed2;
+        track_info_manager_->setNextTrackID(1 + static_cast<int>(idx) * track_id_range);
+        run_geant4(subevent.number_of_particles, subevent.seed1, subevent.seed2);
+
+        subevent.tracks.mergeTrackInfos(*track_info_manager_);
+        for(auto& sensor : sensors_) {
+            subevent.records.emplace(sensor->getName(), sensor->extractRecord());
+        }
+    };
+
+    // The sensitive detectors of a thread are only constructed with its first run, simulate the first subevent here if
+    // they are missing such that the records can be merged into them
+    std::vector<std::function<void()>> tasks;
+    unsigned int first_task = 0;
+    if(sensors_.empty()) {
+        simulate(0);
+        first_task = 1;
+    }
+    for(unsigned int idx = first_task; idx < number_of_subevents_; ++idx) {
+        tasks.emplace_back([&simulate, idx]() { simulate(idx); });
+    }
+    ThreadPool::runSubtasks(tasks);
+
+    // Merge the subevents in their original order
+    for(auto& subevent : subevents) {
+        track_info_manager_->mergeTrackInfos(subevent.tracks);
+        for(auto& sensor : sensors_) {
+            auto record = subevent.records.find(sensor->getName());
+            if(record != subevent.records.end()) {
+                sensor->mergeRecord(std::move(record->second));
+            }
+        }
+    }
+
+    // The charge carriers of the merged deposits are created on this thread when dispatching them
+    for(auto& sensor : sensors_) {
+        sensor->seed(event->getRandomNumber());
+    }
+}
+
 void DepositionGeant4Module::record_module_statistics() {
     // Since sensors is thread local, some instances may not be used, hence, skip them
     auto num_sensors = sensors_.size();
@@ -448,6 +668,43 @@ void DepositionGeant4Module::record_module_statistics() {
     }
 }
 
+/**
+ * The physics tables depend on the Geant4 version, the physics list, the PAI model, the production cuts of all regions and
+ * the materials present in the geometry. The directory name is derived from a hash of these settings, and the full description of the
+ * setup is stored alongside the tables.
+ */
+std::string DepositionGeant4Module::physics_table_cache_directory(double production_cut,
+                                                                  const std::map<std::string, double>& sensor_cuts) {
+    std::vector<std::string> materials;
+    for(const auto* material : *G4Material::GetMaterialTable()) {
+        materials.emplace_back(material->GetName());
+    }
+    std::sort(materials.begin(), materials.end());
+
+    std::stringstream setup;
+    setup << "geant4 " << G4VERSION_NUMBER << std::endl;
+    setup << "physics_list " << config_.get<std::string>("physics_list") << std::endl;
+    setup << "pai_model " << (config_.get<bool>("enable_pai", false) ? config_.get<std::string>("pai_model") : "none")
+          << std::endl;
+    setup << "production_cut " << std::to_string(production_cut) << std::endl;
+    for(const auto& [name, cut] : sensor_cuts) {
+        setup << "production_cut " << name << " " << std::to_string(cut) << std::endl;
+    }
+    for(const auto& material : materials) {
+        setup << "material " << material << std::endl;
+    }
+    physics_setup_ = setup.str();
+
+    // FNV-1a hash of the setup, stable across platforms and runs
+    std::uint64_t hash = 14695981039346656037ULL;
+    for(char character : physics_setup_) {
+        hash = (hash ^ static_cast<unsigned char>(character)) * 1099511628211ULL;
+    }
+    std::stringstream directory;
+    directory << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return (std::filesystem::path(config_.getPath("physics_table_cache")) / directory.str()).string();
+}
+
 G4RotationMatrix* DepositionGeant4Module::calculate_hit_transform(const std::shared_ptr<DetectorModel>&) {
     return new G4RotationMatrix();
 }
@@ -11,6 +11,7 @@
 #define ALLPIX_SIMPLE_DEPOSITION_MODULE_H
 
 #include <atomic>
+#include <map>
 #include <memory>
 #include <string>
 
@@ -22,6 +23,7 @@
 
 #include "SensitiveDetectorActionG4.hpp"
 #include "TrackInfoManager.hpp"
+#include "TrackKillerG4.hpp"
 
 #include "tools/ROOT.h"
 
@@ -29,6 +31,7 @@
 
 class G4UserLimits;
 class G4RunManager;
+class G4VUserPhysicsList;
 
 namespace allpix {
     /**
@@ -84,8 +87,26 @@ namespace allpix {
          * @param fano_factor Fano factor for charge carrier creation uncertainty
          * @param charge_creation_energy Energy required to produce a single e/h pair
          * @param cutoff_time Time after which energy deposits and MCParticles are discarded
+         * @param merge_distance Distance below which consecutive deposits of the same track are merged
          */
-        void construct_sensitive_detectors_and_fields(double fano_factor, double charge_creation_energy, double cutoff_time);
+        void construct_sensitive_detectors_and_fields(double fano_factor,
+                                                      double charge_creation_energy,
+                                                      double cutoff_time,
+                                                      double merge_distance);
+
+        /**
+         * @brief Simulate a number of particles on the Geant4 run manager of the calling thread
+         * @param number_of_particles Number of particles to simulate
+         * @param seed1 First seed of the Geant4 run
+         * @param seed2 Second seed of the Geant4 run
+         */
+        void run_geant4(unsigned int number_of_particles, uint64_t seed1, uint64_t seed2);
+
+        /**
+         * @brief Split the particles of an event into subevents simulated concurrently and merge their tracks and deposits
+         * @param event Event to simulate
+         */
+        void run_subevents(Event* event);
 
         /**
          * @brief Record statistics for the module run.
@@ -102,12 +123,21 @@ namespace allpix {
          */
         G4RotationMatrix* calculate_hit_transform(const std::shared_ptr<DetectorModel>& model);
 
+        /**
+         * @brief Determine the cache directory of the physics tables for the current physics setup
+         * @param production_cut Range cut-off threshold applied for the production of secondaries outside of the sensors
+         * @param sensor_cuts Range cut-off thresholds applied in the sensor regions, indexed by the detector name
+         * @return Path of the cache directory for this setup
+         */
+        std::string physics_table_cache_directory(double production_cut, const std::map<std::string, double>& sensor_cuts);
+
         Messenger* messenger_;
         GeometryManager* geo_manager_;
 
         // Configuration parameters:
         bool output_plots_{};
         unsigned int number_of_particles_{};
+        unsigned int number_of_subevents_{};
 
         // The track manager which this module uses to assign custom track IDs and manage & create MCTracks
         static thread_local std::unique_ptr<TrackInfoManager> track_info_manager_;
@@ -122,9 +152,18 @@ namespace allpix {
         std::unique_ptr<G4UserLimits> user_limits_;
         std::unique_ptr<G4UserLimits> user_limits_world_;
 
+        // Conditions to kill tracks, read by the user actions of all threads
+        TrackKillingConditions track_killing_;
+
         // Pointer to the Geant4 manager (owned by GeometryBuilderGeant4)
         G4RunManager* run_manager_g4_;
 
+        // Physics list (owned by the Geant4 run manager) and the cache of its physics tables
+        G4VUserPhysicsList* physics_list_{};
+        std::string physics_table_directory_;
+        std::string physics_setup_;
+        bool store_physics_tables_{};
+
         // Vector of histogram pointers for debugging plots
         std::map<std::string, Histogram<TH1D>> charge_per_event_;
 
@@ -14,12 +14,16 @@
 #include <memory>
 #include <regex>
 
+#include <CLHEP/Random/MixMaxRng.h>
 #include <G4Event.hh>
 #include <G4IonTable.hh>
 #include <G4ParticleDefinition.hh>
 #include <G4ParticleTable.hh>
+#include <G4PrimaryParticle.hh>
+#include <G4PrimaryVertex.hh>
 #include <G4RunManager.hh>
 #include <G4UImanager.hh>
+#include <Randomize.hh>
 #include <core/module/exceptions.h>
 
 #include "core/config/exceptions.h"
@@ -82,12 +86,18 @@ std::map<std::string, std::tuple<int, int, int, double>> GeneratorActionG4::isot
     {"cs137", std::make_tuple(55, 137, 0, 0.)},
 };
 
+std::shared_ptr<const GeneratorActionG4::PresampledPrimaries> GeneratorActionG4::shared_presampled_primaries_;
+std::mutex GeneratorActionG4::presample_mutex_;
+
 GeneratorActionG4::GeneratorActionG4(const Configuration& config)
     : particle_source_(std::make_unique<G4GeneralParticleSource>()), config_(config) {
 
     // Set verbosity of source to off
     particle_source_->SetVerbosity(0);
 
+    // Number of primaries to draw from the source upfront, zero disables pre-sampling
+    presample_primaries_ = config_.get<size_t>("presample_primaries", 0);
+
     // Get source specific parameters
     auto source_type = config_.get<SourceType>("source_type");
 
@@ -302,7 +312,89 @@ void GeneratorActionG4::GeneratePrimaries(G4Event* event) {
         }
     }
 
-    particle_source_->GeneratePrimaryVertex(event);
+    if(presample_primaries_ > 0) {
+        if(presampled_primaries_ == nullptr) {
+            presampled_primaries_ = presample_primaries();
+        }
+        generate_presampled_primaries(event);
+    } else {
+        particle_source_->GeneratePrimaryVertex(event);
+    }
+}
+
+/**
+ * The source is sampled with a separate engine seeded from the configuration, such that the table does not depend on the
+ * thread or the event it is created in. The current engine of the thread is restored afterwards.
+ */
+std::shared_ptr<const GeneratorActionG4::PresampledPrimaries> GeneratorActionG4::presample_primaries() {
+    std::lock_guard<std::mutex> lock(presample_mutex_);
+    if(shared_presampled_primaries_ != nullptr) {
+        return shared_presampled_primaries_;
+    }
+
+    LOG(INFO) << "Pre-sampling " << presample_primaries_ << " primaries from the particle source";
+    auto primaries = std::make_shared<PresampledPrimaries>();
+    primaries->entries.reserve(presample_primaries_ + 1);
+    primaries->entries.push_back(0);
+
+    auto* thread_engine = G4Random::getTheEngine();
+    CLHEP::MixMaxRng engine(static_cast<long>(config_.get<uint64_t>("presample_seed", 0)));
+    G4Random::setTheEngine(&engine);
+    try {
+        for(size_t entry = 0; entry < presample_primaries_; ++entry) {
+            G4Event sample;
+            particle_source_->GeneratePrimaryVertex(&sample);
+
+            for(int i = 0; i < sample.GetNumberOfPrimaryVertex(); ++i) {
+                auto* vertex = sample.GetPrimaryVertex(i);
+                auto first_particle = primaries->particles.size();
+                for(auto* particle = vertex->GetPrimary(); particle != nullptr; particle = particle->GetNext()) {
+                    primaries->particles.push_back({particle->GetG4code(),
+                                                    particle->GetCharge(),
+                                                    particle->GetKineticEnergy(),
+                                                    particle->GetWeight(),
+                                                    particle->GetMomentumDirection(),
+                                                    particle->GetPolarization()});
+                }
+                primaries->vertices.push_back(
+                    {vertex->GetPosition(), vertex->GetT0(), vertex->GetWeight(), first_particle, primaries->particles.size()});
+            }
+            primaries->entries.push_back(primaries->vertices.size());
+        }
+    } catch(...) {
+        G4Random::setTheEngine(thread_engine);
+        throw;
+    }
+    G4Random::setTheEngine(thread_engine);
+
+    shared_presampled_primaries_ = primaries;
+    return shared_presampled_primaries_;
+}
+
+/**
+ * All entries of the table carry the same weight, the entry is therefore picked with a single uniform random number.
+ */
+void GeneratorActionG4::generate_presampled_primaries(G4Event* event) const {
+    auto size = presampled_primaries_->entries.size() - 1;
+    auto entry = std::min(static_cast<size_t>(G4UniformRand() * static_cast<double>(size)), size - 1);
+
+    for(auto v = presampled_primaries_->entries[entry]; v < presampled_primaries_->entries[entry + 1]; ++v) {
+        const auto& sampled_vertex = presampled_primaries_->vertices[v];
+        auto* vertex = new G4PrimaryVertex(sampled_vertex.position, sampled_vertex.time);
+        vertex->SetWeight(sampled_vertex.weight);
+
+        for(auto p = sampled_vertex.first_particle; p < sampled_vertex.last_particle; ++p) {
+            const auto& sampled_particle = presampled_primaries_->particles[p];
+            auto* particle = new G4PrimaryParticle(sampled_particle.definition);
+            particle->SetCharge(sampled_particle.charge);
+            particle->SetKineticEnergy(sampled_particle.kinetic_energy);
+            particle->SetMomentumDirection(sampled_particle.direction);
+            particle->SetPolarization(sampled_particle.polarization);
+            particle->SetWeight(sampled_particle.weight);
+            vertex->SetPrimary(particle);
+        }
+        event->AddPrimaryVertex(vertex);
+    }
 }
 
 GeneratorActionInitializationMaster::GeneratorActionInitializationMaster(const Configuration& config)
@@ -11,6 +11,8 @@
 #define ALLPIX_SIMPLE_DEPOSITION_MODULE_GENERATOR_ACTION_H
 
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include <G4GeneralParticleSource.hh>
 #include <G4ParticleDefinition.hh>
@@ -50,8 +52,59 @@ namespace allpix {
         void GeneratePrimaries(G4Event*) override;
 
     private:
+        /**
+         * @brief Primary particle drawn from the source when pre-sampling
+         */
+        struct PresampledParticle {
+            G4ParticleDefinition* definition;
+            double charge;
+            double kinetic_energy;
+            double weight;
+            G4ThreeVector direction;
+            G4ThreeVector polarization;
+        };
+
+        /**
+         * @brief Primary vertex drawn from the source when pre-sampling, referring to a range of particles
+         */
+        struct PresampledVertex {
+            G4ThreeVector position;
+            double time;
+            double weight;
+            size_t first_particle;
+            size_t last_particle;
+        };
+
+        /**
+         * @brief Table of primary vertices generated by the particle source, one entry per call to the source
+         */
+        struct PresampledPrimaries {
+            std::vector<PresampledParticle> particles;
+            std::vector<PresampledVertex> vertices;
+            std::vector<size_t> entries;
+        };
+
+        /**
+         * @brief Fill the table of pre-sampled primaries from the particle source
+         * @return Table of pre-sampled primaries, shared between all threads
+         *
+         * The table is filled only once using a dedicated random engine, independent of the thread it is filled on.
+         */
+        std::shared_ptr<const PresampledPrimaries> presample_primaries();
+
+        /**
+         * @brief Add a randomly picked entry of the pre-sampled primaries to the event
+         * @param event Event to add the primary vertices to
+         */
+        void generate_presampled_primaries(G4Event* event) const;
+
         std::unique_ptr<G4GeneralParticleSource> particle_source_;
 
+        size_t presample_primaries_{};
+        std::shared_ptr<const PresampledPrimaries> presampled_primaries_;
+        static std::shared_ptr<const PresampledPrimaries> shared_presampled_primaries_;
+        static std::mutex presample_mutex_;
+
         static std::map<std::string, std::tuple<int, int, int, double>> isotopes_;
 
         const Configuration& config_;
@@ -0,0 +1,22 @@
+/**
+ * @file
+ * @brief Implementation of the Geant4 magnetic field evaluating the magnetic field function of the geometry manager
+ * @copyright Copyright (c) 2017-2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "MagneticFieldG4.hpp"
+
+using namespace allpix;
+
+/**
+ * Geant4 and Allpix Squared share the same internal units, thus no conversion of positions or field values is required.
+ */
+void MagneticFieldG4::GetFieldValue(const G4double point[4], G4double* bfield) const {
+    auto field = geo_manager_->getMagneticField(ROOT::Math::XYZPoint(point[0], point[1], point[2]));
+    bfield[0] = field.x();
+    bfield[1] = field.y();
+    bfield[2] = field.z();
+}
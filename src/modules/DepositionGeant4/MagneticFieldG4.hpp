@@ -0,0 +1,43 @@
+/**
+ * @file
+ * @brief Geant4 magnetic field evaluating the magnetic field function of the geometry manager
+ * @copyright Copyright (c) 2017-2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_MODULE_DEPOSITION_MAGNETIC_FIELD_G4_H
+#define ALLPIX_MODULE_DEPOSITION_MAGNETIC_FIELD_G4_H
+
+#include <G4MagneticField.hh>
+
+#include "core/geometry/GeometryManager.hpp"
+
+namespace allpix {
+    /**
+     * @brief Magnetic field for the Geant4 tracking which is not uniform, e.g. interpolated from a grid
+     *
+     * The field is looked up from the same function as used for the propagation of charge carriers in the sensors.
+     */
+    class MagneticFieldG4 : public G4MagneticField {
+    public:
+        /**
+         * @brief Constructs the Geant4 magnetic field
+         * @param geo_manager Pointer to the geometry manager holding the magnetic field function
+         */
+        explicit MagneticFieldG4(GeometryManager* geo_manager) : geo_manager_(geo_manager){};
+
+        /**
+         * @brief Evaluate the magnetic field at a global position
+         * @param point Global position and time of the query
+         * @param bfield Output array for the three components of the magnetic field
+         */
+        void GetFieldValue(const G4double point[4], G4double* bfield) const override;
+
+    private:
+        GeometryManager* geo_manager_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_MODULE_DEPOSITION_MAGNETIC_FIELD_G4_H */
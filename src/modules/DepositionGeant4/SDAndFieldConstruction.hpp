@@ -21,9 +21,10 @@ namespace allpix {
         SDAndFieldConstruction(DepositionGeant4Module* module,
                                double fano_factor,
                                double charge_creation_energy,
-                               double cutoff_time)
+                               double cutoff_time,
+                               double merge_distance)
             : module_(module), fano_factor_(fano_factor), charge_creation_energy_(charge_creation_energy),
-              cutoff_time_(cutoff_time){};
+              cutoff_time_(cutoff_time), merge_distance_(merge_distance){};
 
         /**
          * @brief Constructs the SD and field.
@@ -35,6 +36,7 @@ namespace allpix {
         double fano_factor_;
         double charge_creation_energy_;
         double cutoff_time_;
+        double merge_distance_;
     };
 } // namespace allpix
 
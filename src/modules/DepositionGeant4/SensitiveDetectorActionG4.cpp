@@ -11,7 +11,9 @@
 #include "SensitiveDetectorActionG4.hpp"
 #include "TrackInfoG4.hpp"
 
+#include <cmath>
 #include <memory>
+#include <utility>
 
 #include "G4DecayTable.hh"
 #include "G4HCofThisEvent.hh"
@@ -39,16 +41,18 @@ SensitiveDetectorActionG4::SensitiveDetectorActionG4(const std::shared_ptr<Detec
                                                      const G4RotationMatrix* hit_transform,
                                                      double charge_creation_energy,
                                                      double fano_factor,
-                                                     double cutoff_time)
+                                                     double cutoff_time,
+                                                     double merge_distance)
     : G4VSensitiveDetector("SensitiveDetector_" + detector->getName()), detector_(detector),
       track_info_manager_(track_info_manager), charge_creation_energy_(charge_creation_energy), fano_factor_(fano_factor),
-      cutoff_time_(cutoff_time) {
+      cutoff_time_(cutoff_time), merge_distance_(merge_distance) {
 
     // Add the sensor to the internal sensitive detector manager
     G4SDManager* sd_man_g4 = G4SDManager::GetSDMpointer();
     sd_man_g4->AddNewDetector(this);
 
     hit_transform_ = hit_transform;
+    sensor_center_ = detector_->getModel()->getSensorCenter();
 }
 
 G4bool SensitiveDetectorActionG4::ProcessHits(G4Step* step, G4TouchableHistory*) {
@@ -58,9 +62,6 @@ G4bool SensitiveDetectorActionG4::ProcessHits(G4Step* step, G4TouchableHistory*)
     G4StepPoint* postStep = step->GetPostStepPoint();
     LOG(TRACE) << "Distance of this step: " << (postStep->GetPosition() - preStep->GetPosition()).mag();
 
-    // Get Transportaion Matrix
-    G4TouchableHandle theTouchable = step->GetPreStepPoint()->GetTouchableHandle();
-
     // Put the charge deposit in the middle of the step unless it is a photon:
     auto is_photon = (step->GetTrack()->GetDynamicParticle()->GetPDGcode() == 22);
     LOG(DEBUG) << "Placing energy deposit "
@@ -75,21 +76,6 @@ G4bool SensitiveDetectorActionG4::ProcessHits(G4Step* step, G4TouchableHistory*)
 
     // Calculate the charge deposit at a local position
     auto deposit_position = detector_->getLocalPosition(static_cast<ROOT::Math::XYZPoint>(step_pos));
-    auto deposit_position_g4 = theTouchable->GetHistory()->GetTopTransform().TransformPoint(step_pos);
-
-    // Transform the hit position using the rotation matrix
-    deposit_position_g4 *= *hit_transform_;
-
-    // Calculate number of electron hole pairs produced, taking into account fluctuations between ionization and lattice
-    // excitations via the Fano factor. We assume Gaussian statistics here.
-    auto mean_charge = edep / charge_creation_energy_;
-    allpix::normal_distribution<double> charge_fluctuation(mean_charge, std::sqrt(mean_charge * fano_factor_));
-    auto charge = static_cast<unsigned int>(charge_fluctuation(random_generator_));
-
-    auto deposit_position_g4loc =
-        ROOT::Math::XYZPoint(deposit_position_g4.x() + detector_->getModel()->getSensorCenter().x(),
-                             deposit_position_g4.y() + detector_->getModel()->getSensorCenter().y(),
-                             deposit_position_g4.z() + detector_->getModel()->getSensorCenter().z());
 
     const auto* userTrackInfo = dynamic_cast<TrackInfoG4*>(step->GetTrack()->GetUserInformation());
     if(userTrackInfo == nullptr) {
@@ -112,21 +98,24 @@ G4bool SensitiveDetectorActionG4::ProcessHits(G4Step* step, G4TouchableHistory*)
     auto end_position = detector_->getLocalPosition(static_cast<ROOT::Math::XYZPoint>(postStep->GetPosition()));
     track_end_[trackID] = end_position;
 
-    // Add new deposit if the charge is more than zero
-    if(charge == 0) {
-        return false;
-    }
-
-    // Store relevant quantities to create charge deposits:
-    deposit_position_.push_back(deposit_position);
-    deposit_charge_.push_back(charge);
-    deposit_time_.push_back(step_time);
-    deposit_to_id_.push_back(trackID);
-
-    LOG(DEBUG) << "Geant4 transformation to local: " << Units::display(deposit_position_g4loc, {"mm", "um"});
-    if((deposit_position_g4loc - deposit_position).mag2() > 0.001) {
-        LOG(ERROR) << "Difference G4 to internal: "
-                   << Units::display((deposit_position_g4loc - deposit_position), {"mm", "um"});
+    // Store relevant quantities to create charge deposits, the charge carriers are created for all deposits of the event
+    // at once when dispatching them. Deposits without energy are kept such that every step draws one random number.
+    deposits_.push_back(deposit_position, edep, step_time, trackID);
+
+    // Validate the local position against the transformation of the Geant4 navigation, only done when debugging since it
+    // requires the touchable history of the step
+    IFLOG(DEBUG) {
+        auto deposit_position_g4 = preStep->GetTouchableHandle()->GetHistory()->GetTopTransform().TransformPoint(step_pos);
+        deposit_position_g4 *= *hit_transform_;
+        auto deposit_position_g4loc = ROOT::Math::XYZPoint(deposit_position_g4.x() + sensor_center_.x(),
+                                                           deposit_position_g4.y() + sensor_center_.y(),
+                                                           deposit_position_g4.z() + sensor_center_.z());
+
+        LOG(DEBUG) << "Geant4 transformation to local: " << Units::display(deposit_position_g4loc, {"mm", "um"});
+        if((deposit_position_g4loc - deposit_position).mag2() > 0.001) {
+            LOG(ERROR) << "Difference G4 to internal: "
+                       << Units::display((deposit_position_g4loc - deposit_position), {"mm", "um"});
+        }
     }
     return true;
 }
@@ -152,6 +141,7 @@ void SensitiveDetectorActionG4::dispatchMessages(Module* module, Messenger* mess
 
     // Create the mc particles
     std::vector<MCParticle> mc_particles;
+    mc_particles.reserve(track_begin_.size());
     for(auto& track_id_point : track_begin_) {
         auto track_id = track_id_point.first;
         auto local_begin = track_id_point.second;
@@ -189,7 +179,7 @@ void SensitiveDetectorActionG4::dispatchMessages(Module* module, Messenger* mess
     }
 
     // Send the mc particle information
-    auto mc_particle_message = std::make_shared<MCParticleMessage>(std::move(mc_particles), detector_);
+    auto mc_particle_message = event->makeShared<MCParticleMessage>(std::move(mc_particles), detector_);
     messenger->dispatchMessage(module, mc_particle_message, event);
 
     // Clear track data for the next event
@@ -201,30 +191,44 @@ void SensitiveDetectorActionG4::dispatchMessages(Module* module, Messenger* mess
 
     // Send a deposit message if we have any deposits
     unsigned int charges = 0;
-    if(!deposit_position_.empty()) {
-        // Prepare charge deposits for this event
+    if(!deposits_.empty()) {
+        merge_deposits();
+        create_charges();
+
+        // Prepare charge deposits for this event, an electron and a hole deposit for every entry with charge carriers
         std::vector<DepositedCharge> deposits;
-        for(size_t i = 0; i < deposit_position_.size(); i++) {
-            auto local_position = deposit_position_.at(i);
+        deposits.reserve(2 * deposits_.size());
+        const MCParticle* mc_particle = nullptr;
+        int mc_particle_track_id = 0;
+        for(size_t i = 0; i < deposits_.size(); i++) {
+            auto charge = static_cast<unsigned int>(charges_[i]);
+            if(charge == 0) {
+                continue;
+            }
+
+            const auto& local_position = deposits_.position[i];
             auto global_position = detector_->getGlobalPosition(local_position);
 
-            auto global_time = deposit_time_.at(i);
+            auto global_time = deposits_.time[i];
             auto local_time = global_time - time_reference;
 
-            auto charge = deposit_charge_.at(i);
             charges += 2 * charge;
             total_deposited_charge_ += 2 * charge;
 
-            // Match deposit with mc particle if possible
-            auto track_id = deposit_to_id_.at(i);
+            // Match deposit with mc particle, consecutive deposits usually belong to the same track
+            auto track_id = deposits_.track_id[i];
+            if(mc_particle == nullptr || track_id != mc_particle_track_id) {
+                mc_particle = &mc_particle_message->getData().at(id_to_particle_.at(track_id));
+                mc_particle_track_id = track_id;
+            }
 
             // Deposit electron
             deposits.emplace_back(local_position, global_position, CarrierType::ELECTRON, charge, local_time, global_time);
-            deposits.back().setMCParticle(&mc_particle_message->getData().at(id_to_particle_.at(track_id)));
+            deposits.back().setMCParticle(mc_particle);
 
             // Deposit hole
             deposits.emplace_back(local_position, global_position, CarrierType::HOLE, charge, local_time, global_time);
-            deposits.back().setMCParticle(&mc_particle_message->getData().at(id_to_particle_.at(track_id)));
+            deposits.back().setMCParticle(mc_particle);
 
             LOG(DEBUG) << "Created deposit of " << charge << " charges at " << Units::display(global_position, {"mm", "um"})
                        << " global / " << Units::display(local_position, {"mm", "um"}) << " local in "
@@ -232,23 +236,129 @@ void SensitiveDetectorActionG4::dispatchMessages(Module* module, Messenger* mess
                        << Units::display(local_time, {"ns", "ps"}) << " local";
         }
 
-        LOG(INFO) << "Deposited " << charges << " charges in sensor of detector " << detector_->getName();
+        // Send the message only if any of the deposits created charge carriers
+        if(!deposits.empty()) {
+            LOG(INFO) << "Deposited " << charges << " charges in sensor of detector " << detector_->getName();
 
-        // Create a new charge deposit message
-        auto deposit_message = std::make_shared<DepositedChargeMessage>(std::move(deposits), detector_);
+            // Create a new charge deposit message
+            auto deposit_message = event->makeShared<DepositedChargeMessage>(std::move(deposits), detector_);
 
-        // Dispatch the message
-        messenger->dispatchMessage(module, deposit_message, event);
+            // Dispatch the message
+            messenger->dispatchMessage(module, deposit_message, event);
+        }
     }
     // Store the number of charge carriers:
     deposited_charge_ = charges;
 
-    // Clear deposit information for next event
-    deposit_position_.clear();
-    deposit_charge_.clear();
-    deposit_time_.clear();
-
-    // Clear link tables for next event
-    deposit_to_id_.clear();
+    // Clear deposit information and link tables for next event
+    reset_deposits();
     id_to_particle_.clear();
 }
+
+SensitiveDetectorActionG4::Record SensitiveDetectorActionG4::extractRecord() {
+    Record record;
+    record.deposits = std::move(deposits_);
+    record.track_begin = std::move(track_begin_);
+    record.track_end = std::move(track_end_);
+    record.track_parents = std::move(track_parents_);
+    record.track_pdg = std::move(track_pdg_);
+    record.track_time = std::move(track_time_);
+
+    // Leave the moved-from containers in a defined empty state
+    deposits_.clear();
+    track_begin_.clear();
+    track_end_.clear();
+    track_parents_.clear();
+    track_pdg_.clear();
+    track_time_.clear();
+    return record;
+}
+
+void SensitiveDetectorActionG4::mergeRecord(Record&& record) {
+    auto append = [](auto& target, auto& source) { target.insert(target.end(), source.begin(), source.end()); };
+    deposits_.reserve(deposits_.size() + record.deposits.size());
+    append(deposits_.position, record.deposits.position);
+    append(deposits_.energy, record.deposits.energy);
+    append(deposits_.time, record.deposits.time);
+    append(deposits_.track_id, record.deposits.track_id);
+
+    track_begin_.merge(record.track_begin);
+    track_end_.merge(record.track_end);
+    track_parents_.merge(record.track_parents);
+    track_pdg_.merge(record.track_pdg);
+    track_time_.merge(record.track_time);
+}
+
+/**
+ * The buffer keeps its memory between events and reserves twice the running average of the number of deposits per event.
+ * Memory is only released if the capacity exceeds this estimate by far, such that single events with many deposits do not
+ * keep their memory indefinitely.
+ */
+void SensitiveDetectorActionG4::reset_deposits() {
+    expected_deposits_ = 0.9 * expected_deposits_ + 0.1 * static_cast<double>(deposits_.size());
+    auto expected = static_cast<size_t>(2 * expected_deposits_) + 16;
+
+    deposits_.clear();
+    if(deposits_.capacity() > 4 * expected) {
+        deposits_.shrink_to_fit();
+    }
+    deposits_.reserve(expected);
+}
+
+/**
+ * Deposits are only merged with the preceding deposit of the buffer, since the steps of a track are recorded consecutively.
+ * The merged deposit is placed at the energy-weighted mean position and time of its steps. The distance is measured to the
+ * position of the merged deposit, such that a chain of short steps is not merged beyond the configured distance.
+ */
+void SensitiveDetectorActionG4::merge_deposits() {
+    if(merge_distance_ <= 0 || deposits_.size() < 2) {
+        return;
+    }
+
+    auto merge_distance2 = merge_distance_ * merge_distance_;
+    size_t last = 0;
+    for(size_t i = 1; i < deposits_.size(); ++i) {
+        auto& position = deposits_.position[last];
+        auto& energy = deposits_.energy[last];
+        auto& time = deposits_.time[last];
+        if(deposits_.track_id[i] == deposits_.track_id[last] &&
+           (deposits_.position[i] - position).Mag2() < merge_distance2) {
+            auto total_energy = energy + deposits_.energy[i];
+            if(total_energy > 0) {
+                auto weight = deposits_.energy[i] / total_energy;
+                position += (deposits_.position[i] - position) * weight;
+                time += (deposits_.time[i] - time) * weight;
+            }
+            energy = total_energy;
+            continue;
+        }
+
+        ++last;
+        deposits_.position[last] = deposits_.position[i];
+        deposits_.energy[last] = deposits_.energy[i];
+        deposits_.time[last] = deposits_.time[i];
+        deposits_.track_id[last] = deposits_.track_id[i];
+    }
+
+    auto size = last + 1;
+    LOG(DEBUG) << "Merged " << deposits_.size() << " deposits into " << size << " in sensor of detector "
+               << detector_->getName();
+    deposits_.position.resize(size);
+    deposits_.energy.resize(size);
+    deposits_.time.resize(size);
+    deposits_.track_id.resize(size);
+}
+
+/**
+ * The number of electron hole pairs produced is calculated taking into account fluctuations between ionization and lattice
+ * excitations via the Fano factor, assuming Gaussian statistics. The unit normal numbers for all deposits are drawn in one
+ * batch in the order of the deposits, which consumes the generator exactly as sampling a distribution for every deposit.
+ */
+void SensitiveDetectorActionG4::create_charges() {
+    charges_.resize(deposits_.size());
+    allpix::fill_normal<double>(random_generator_, charges_.data(), charges_.size(), 0, 1);
+    for(size_t i = 0; i < charges_.size(); ++i) {
+        auto mean_charge = deposits_.energy[i] / charge_creation_energy_;
+        charges_[i] = charges_[i] * std::sqrt(mean_charge * fano_factor_) + mean_charge;
+    }
+}
@@ -10,7 +10,9 @@
 #ifndef ALLPIX_SIMPLE_DEPOSITION_MODULE_SENSITIVE_DETECTOR_ACTION_H
 #define ALLPIX_SIMPLE_DEPOSITION_MODULE_SENSITIVE_DETECTOR_ACTION_H
 
+#include <map>
 #include <memory>
+#include <vector>
 
 #include <G4VSensitiveDetector.hh>
 #include <G4WrapperProcess.hh>
@@ -32,6 +34,61 @@ namespace allpix {
      */
     class SensitiveDetectorActionG4 : public G4VSensitiveDetector {
     public:
+        /**
+         * @brief Buffer of the deposits of an event, with every quantity stored in a separate array
+         */
+        struct DepositBuffer {
+            std::vector<ROOT::Math::XYZPoint> position;
+            // Deposited energy, converted into charge carriers when dispatching the deposits
+            std::vector<double> energy;
+            std::vector<double> time;
+            // Track id the deposit belongs to
+            std::vector<int> track_id;
+
+            size_t size() const { return energy.size(); }
+            bool empty() const { return energy.empty(); }
+            size_t capacity() const { return energy.capacity(); }
+            void push_back(const ROOT::Math::XYZPoint& deposit_position,
+                           double deposit_energy,
+                           double deposit_time,
+                           int deposit_track_id) {
+                position.push_back(deposit_position);
+                energy.push_back(deposit_energy);
+                time.push_back(deposit_time);
+                track_id.push_back(deposit_track_id);
+            }
+            void reserve(size_t deposits) {
+                position.reserve(deposits);
+                energy.reserve(deposits);
+                time.reserve(deposits);
+                track_id.reserve(deposits);
+            }
+            void clear() {
+                position.clear();
+                energy.clear();
+                time.clear();
+                track_id.clear();
+            }
+            void shrink_to_fit() {
+                position.shrink_to_fit();
+                energy.shrink_to_fit();
+                time.shrink_to_fit();
+                track_id.shrink_to_fit();
+            }
+        };
+
+        /**
+         * @brief Tracks and deposits of a detector recorded by one or several Geant4 runs of an event
+         */
+        struct Record {
+            DepositBuffer deposits;
+            std::map<int, ROOT::Math::XYZPoint> track_begin;
+            std::map<int, ROOT::Math::XYZPoint> track_end;
+            std::map<int, int> track_parents;
+            std::map<int, int> track_pdg;
+            std::map<int, double> track_time;
+        };
+
         /**
          * @brief Constructs the action handling for every sensitive detector
          * @param detector Detector this sensitive device is bound to
@@ -40,13 +97,15 @@ namespace allpix {
          * @param charge_creation_energy Energy needed per deposited charge
          * @param fano_factor Fano factor for fluctuations in the energy fraction going into e/h pair creation
          * @param cutoff_time Cut-off time for the creation of secondary particles
+         * @param merge_distance Distance below which consecutive deposits of the same track are merged, zero to disable
          */
         SensitiveDetectorActionG4(const std::shared_ptr<Detector>& detector,
                                   TrackInfoManager* track_info_manager,
                                   const G4RotationMatrix* hit_transform,
                                   double charge_creation_energy,
                                   double fano_factor,
-                                  double cutoff_time);
+                                  double cutoff_time,
+                                  double merge_distance);
 
         /**
          * @brief Get total number of charges deposited in the sensitive device bound to this action
@@ -85,6 +144,20 @@ namespace allpix {
          */
         void dispatchMessages(Module* module, Messenger* messenger, Event* event);
 
+        /**
+         * @brief Move the tracks and deposits recorded since the last dispatch out of this action
+         * @return Record of the tracks and deposits, this action is left without any
+         */
+        Record extractRecord();
+
+        /**
+         * @brief Add the tracks and deposits recorded by another action of the same detector
+         * @param record Record to add, the track ids are required to be distinct from the ones of this action
+         *
+         * The deposits are appended to the ones of this action, such that they are dispatched together.
+         */
+        void mergeRecord(Record&& record);
+
     private:
         std::shared_ptr<Detector> detector_;
         // Pointer to track info manager to register tracks which pass through sensitive detectors
@@ -93,6 +166,7 @@ namespace allpix {
         double charge_creation_energy_;
         double fano_factor_;
         double cutoff_time_;
+        double merge_distance_;
 
         /**
          * Random number generator for e/h pair creation fluctuation
@@ -105,10 +179,26 @@ namespace allpix {
         unsigned int total_deposited_charge_{};
         unsigned int deposited_charge_{};
 
-        // List of positions for deposits
-        std::vector<ROOT::Math::XYZPoint> deposit_position_;
-        std::vector<unsigned int> deposit_charge_;
-        std::vector<double> deposit_time_;
+        /**
+         * @brief Clear the deposit buffer and adapt its capacity to the running estimate of deposits per event
+         */
+        void reset_deposits();
+
+        /**
+         * @brief Merge consecutive deposits of the same track which are closer than the merge distance
+         */
+        void merge_deposits();
+
+        /**
+         * @brief Draw the number of charge carriers created by every deposit, including the Fano fluctuations
+         */
+        void create_charges();
+
+        // Deposits of the current event and running average of the number of deposits per event
+        DepositBuffer deposits_;
+        double expected_deposits_{};
+        // Number of charge carriers created by every deposit, kept to reuse its memory
+        std::vector<double> charges_;
 
         // List of begin points for tracks
         std::map<int, ROOT::Math::XYZPoint> track_begin_;
@@ -121,12 +211,12 @@ namespace allpix {
         // Arrival timestamp of the tracks
         std::map<int, double> track_time_;
 
-        // Map from deposit index to track id
-        std::vector<int> deposit_to_id_;
         // Map from track id to mc particle index
         std::map<int, size_t> id_to_particle_;
 
         const G4RotationMatrix* hit_transform_;
+        // Center of the sensor in local coordinates, cached since the model is fixed
+        ROOT::Math::XYZPoint sensor_center_;
     };
 } // namespace allpix
 
@@ -0,0 +1,39 @@
+/**
+ * @file
+ * @brief Implements the dispatching of steps in a sensor volume shared by several detectors
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "SensitiveDetectorDispatcherG4.hpp"
+
+#include <G4SDManager.hh>
+#include <G4Step.hh>
+#include <G4VTouchable.hh>
+
+using namespace allpix;
+
+SensitiveDetectorDispatcherG4::SensitiveDetectorDispatcherG4(const std::string& name)
+    : G4VSensitiveDetector("SensitiveDetectorDispatcher_" + name) {
+    // Add the dispatcher to the internal sensitive detector manager
+    G4SDManager::GetSDMpointer()->AddNewDetector(this);
+}
+
+void SensitiveDetectorDispatcherG4::addAction(int copy_number, SensitiveDetectorActionG4* action) {
+    if(actions_.size() <= static_cast<size_t>(copy_number)) {
+        actions_.resize(static_cast<size_t>(copy_number) + 1, nullptr);
+    }
+    actions_[static_cast<size_t>(copy_number)] = action;
+}
+
+G4bool SensitiveDetectorDispatcherG4::ProcessHits(G4Step* step, G4TouchableHistory* history) {
+    // The wrapper of the detector is the outermost volume below the world
+    const auto* touchable = step->GetPreStepPoint()->GetTouchable();
+    auto copy_number = static_cast<size_t>(touchable->GetCopyNumber(touchable->GetHistoryDepth() - 1));
+    if(copy_number >= actions_.size() || actions_[copy_number] == nullptr) {
+        return false;
+    }
+    return actions_[copy_number]->ProcessHits(step, history);
+}
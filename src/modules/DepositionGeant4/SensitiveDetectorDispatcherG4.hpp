@@ -0,0 +1,55 @@
+/**
+ * @file
+ * @brief Defines the dispatching of steps in a sensor volume shared by several detectors
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_SENSITIVE_DETECTOR_DISPATCHER_H
+#define ALLPIX_SENSITIVE_DETECTOR_DISPATCHER_H
+
+#include <string>
+#include <vector>
+
+#include <G4VSensitiveDetector.hh>
+
+#include "SensitiveDetectorActionG4.hpp"
+
+namespace allpix {
+    /**
+     * @brief Forwards the steps in a sensor logical volume placed for several detectors to the action of the detector hit
+     *
+     * Detectors sharing the logical volumes of their model are told apart by the copy number of their wrapper volume,
+     * which is placed directly in the world volume.
+     */
+    class SensitiveDetectorDispatcherG4 : public G4VSensitiveDetector {
+    public:
+        /**
+         * @brief Constructs the dispatcher for a shared sensor volume
+         * @param name Name of the shared logical volume
+         */
+        explicit SensitiveDetectorDispatcherG4(const std::string& name);
+
+        /**
+         * @brief Add the action handling the steps of one of the detectors sharing the volume
+         * @param copy_number Copy number of the wrapper volume of the detector
+         * @param action Sensitive detector action of the detector
+         */
+        void addAction(int copy_number, SensitiveDetectorActionG4* action);
+
+        /**
+         * @brief Forward a single step to the action of the detector it belongs to
+         * @param step Information about the step
+         * @param history Parameter passed on to the action
+         */
+        G4bool ProcessHits(G4Step* step, G4TouchableHistory* history) override;
+
+    private:
+        // Actions indexed by the copy number of the wrapper, null for detectors without deposition
+        std::vector<SensitiveDetectorActionG4*> actions_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_SENSITIVE_DETECTOR_DISPATCHER_H */
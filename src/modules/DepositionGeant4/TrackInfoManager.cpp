@@ -9,47 +9,74 @@
 
 #include "TrackInfoManager.hpp"
 
+#include <algorithm>
+
 using namespace allpix;
 
-TrackInfoManager::TrackInfoManager() : counter_(1) {}
+TrackInfoManager::TrackInfoManager() : counter_(1), first_id_(1) {}
 
 std::unique_ptr<TrackInfoG4> TrackInfoManager::makeTrackInfo(const G4Track* const track) {
     auto custom_id = counter_++;
     auto G4ParentID = track->GetParentID();
-    auto parent_track_id = G4ParentID == 0 ? G4ParentID : g4_to_custom_id_.at(G4ParentID);
-    g4_to_custom_id_[track->GetTrackID()] = custom_id;
-    track_id_to_parent_id_[custom_id] = parent_track_id;
+    auto parent_track_id = G4ParentID == 0 ? G4ParentID : g4_to_custom_id_.at(static_cast<size_t>(G4ParentID));
+    auto g4_id = static_cast<size_t>(track->GetTrackID());
+    if(g4_id >= g4_to_custom_id_.size()) {
+        g4_to_custom_id_.resize(g4_id + 1, 0);
+    }
+    g4_to_custom_id_[g4_id] = custom_id;
     return std::make_unique<TrackInfoG4>(custom_id, parent_track_id, track);
 }
 
 void TrackInfoManager::setTrackInfoToBeStored(int track_id) {
-    auto element = std::find(to_store_track_ids_.begin(), to_store_track_ids_.end(), track_id);
-    // If track id is not present we add it, otherwise skip as we only need each track once
-    if(element == to_store_track_ids_.end()) {
-        to_store_track_ids_.emplace_back(track_id);
+    if(track_id < first_id_) {
+        return;
     }
+    // Flagging a track repeatedly has no effect, as we only need each track once
+    auto index = static_cast<size_t>(track_id - first_id_);
+    if(index >= to_store_.size()) {
+        to_store_.resize(index + 1, false);
+    }
+    to_store_[index] = true;
 }
 
 void TrackInfoManager::storeTrackInfo(std::unique_ptr<TrackInfoG4> the_track_info) {
     auto track_id = the_track_info->getID();
-    auto element = std::find(to_store_track_ids_.begin(), to_store_track_ids_.end(), track_id);
-    if(element != to_store_track_ids_.end()) {
+    if(track_id < first_id_) {
+        return;
+    }
+    auto index = static_cast<size_t>(track_id - first_id_);
+    if(index < to_store_.size() && to_store_[index]) {
         stored_track_infos_.push_back(std::move(the_track_info));
-        to_store_track_ids_.erase(element);
+        to_store_[index] = false;
     }
 }
 
+/**
+ * The containers are only cleared, such that their memory is reused for the next event
+ */
 void TrackInfoManager::resetTrackInfoManager() {
     counter_ = 1;
+    first_id_ = 1;
     stored_tracks_.clear();
-    to_store_track_ids_.clear();
+    to_store_.clear();
     g4_to_custom_id_.clear();
-    track_id_to_parent_id_.clear();
     stored_track_infos_.clear();
-    stored_track_ids_.clear();
     id_to_track_.clear();
 }
 
+void TrackInfoManager::setNextTrackID(int track_id) {
+    counter_ = track_id;
+    first_id_ = track_id;
+    to_store_.clear();
+}
+
+void TrackInfoManager::mergeTrackInfos(TrackInfoManager& other) {
+    for(auto& track_info : other.stored_track_infos_) {
+        stored_track_infos_.push_back(std::move(track_info));
+    }
+    other.resetTrackInfoManager();
+}
+
 void TrackInfoManager::dispatchMessage(Module* module, Messenger* messenger, Event* event) {
     set_all_track_parents();
     IFLOG(DEBUG) {
@@ -59,18 +86,20 @@ void TrackInfoManager::dispatchMessage(Module* module, Messenger* messenger, Eve
                        << " and terminates at: " << Units::display(mc_track.getEndPoint(), {"mm", "um"});
         }
     }
-    auto mc_track_message = std::make_shared<MCTrackMessage>(std::move(stored_tracks_));
+    auto mc_track_message = event->makeShared<MCTrackMessage>(std::move(stored_tracks_));
     messenger->dispatchMessage(module, mc_track_message, event);
 }
 
 MCTrack const* TrackInfoManager::findMCTrack(int track_id) const {
-    auto it = id_to_track_.find(track_id);
-    return (it == id_to_track_.end()) ? nullptr : it->second;
+    auto it = std::lower_bound(
+        id_to_track_.begin(), id_to_track_.end(), track_id, [](const auto& entry, int id) { return entry.first < id; });
+    return (it == id_to_track_.end() || it->first != track_id) ? nullptr : it->second;
 }
 
 void TrackInfoManager::createMCTracks() {
     // Reserve size so we don't move the vector around and change addresses:
     stored_tracks_.reserve(stored_track_infos_.size());
+    id_to_track_.reserve(stored_track_infos_.size());
 
     for(auto& track_info : stored_track_infos_) {
         stored_tracks_.emplace_back(track_info->getStartPoint(),
@@ -84,15 +113,16 @@ void TrackInfoManager::createMCTracks() {
                                     track_info->getTotalEnergyInitial(),
                                     track_info->getTotalEnergyFinal());
 
-        id_to_track_[track_info->getID()] = &stored_tracks_.back();
-        stored_track_ids_.emplace_back(track_info->getID());
+        id_to_track_.emplace_back(track_info->getID(), &stored_tracks_.back());
     }
+    std::sort(id_to_track_.begin(), id_to_track_.end());
 }
 
+/**
+ * The parent of every stored track is taken from its track information, parents which have not been stored are not linked
+ */
 void TrackInfoManager::set_all_track_parents() {
-    for(size_t ix = 0; ix < stored_track_ids_.size(); ++ix) {
-        auto track_id = stored_track_ids_[ix];
-        auto parent_id = track_id_to_parent_id_[track_id];
-        stored_tracks_[ix].setParent(findMCTrack(parent_id));
+    for(size_t ix = 0; ix < stored_track_infos_.size(); ++ix) {
+        stored_tracks_[ix].setParent(findMCTrack(stored_track_infos_[ix]->getParentID()));
     }
 }
@@ -11,7 +11,9 @@
 #ifndef TrackInfoManager_H
 #define TrackInfoManager_H 1
 
-#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #include "G4Track.hh"
 #include "TrackInfoG4.hpp"
@@ -66,6 +68,23 @@ namespace allpix {
          */
         void resetTrackInfoManager();
 
+        /**
+         * @brief Set the id assigned to the next track
+         * @param track_id Id of the next track
+         *
+         * Several managers recording parts of the same event start at distinct ids, such that their tracks can be merged
+         * with \ref mergeTrackInfos without any collision.
+         */
+        void setNextTrackID(int track_id);
+
+        /**
+         * @brief Take over the tracks registered with another manager
+         * @param other Manager to move the tracks from, it is reset afterwards
+         * @warning Must be called before \ref createMCTracks and after all tracks of the other manager have finished, and
+         * the track ids of both managers are required to be distinct
+         */
+        void mergeTrackInfos(TrackInfoManager& other);
+
         /**
          * @brief Dispatch the stored tracks as a MCTrackMessage
          * @param module The module which is responsible for dispatching the message
@@ -99,20 +118,18 @@ namespace allpix {
 
         // Counter to store highest assigned track id
         int counter_{};
-        // Geant4 id to custom id translation
-        std::map<int, int> g4_to_custom_id_{};
-        // Custom id to custom parent id tracking
-        std::map<int, int> track_id_to_parent_id_{};
-        // List of track ids to be stored if they are provided via #storeTrackInfo
-        std::vector<int> to_store_track_ids_;
+        // First id assigned since the last reset, used as offset of #to_store_
+        int first_id_{};
+        // Geant4 id to custom id translation, indexed by the Geant4 id which is dense within a Geant4 event
+        std::vector<int> g4_to_custom_id_;
+        // Flags of the tracks to be stored if they are provided via #storeTrackInfo, indexed by custom id minus #first_id_
+        std::vector<bool> to_store_;
         // The TrackInfoG4 instances which are handed over to this track manager
         std::vector<std::unique_ptr<TrackInfoG4>> stored_track_infos_;
         // The MCTrack vector which is dispatched via #dispatchMessage
         std::vector<MCTrack> stored_tracks_;
-        // Ids ins same order as tracks stored in #stored_tracks_
-        std::vector<int> stored_track_ids_;
-        // Id to index in #stored_tracks_ for easier handling
-        std::map<int, MCTrack const*> id_to_track_;
+        // Pairs of id and track in #stored_tracks_, sorted by id for lookup
+        std::vector<std::pair<int, MCTrack const*>> id_to_track_;
     };
 } // namespace allpix
 #endif /* TrackInfoManager_H */
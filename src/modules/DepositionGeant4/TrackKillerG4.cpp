@@ -0,0 +1,56 @@
+/**
+ * @file
+ * @brief Implements the user actions for Geant4 killing tracks which are not of interest for the deposits in the sensors
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "TrackKillerG4.hpp"
+
+#include <G4LogicalVolume.hh>
+#include <G4Step.hh>
+#include <G4Track.hh>
+#include <G4VPhysicalVolume.hh>
+
+using namespace allpix;
+
+/**
+ * Primary particles are never killed, since they define the event.
+ */
+G4ClassificationOfNewTrack TrackKillerStackingActionG4::ClassifyNewTrack(const G4Track* track) {
+    if(track->GetParentID() > 0 && conditions_.particles.count(track->GetDefinition()) != 0) {
+        return fKill;
+    }
+    return fUrgent;
+}
+
+/**
+ * Tracks entering a sensor are never killed by the energy cut, such that all deposits in the sensors are kept.
+ */
+void TrackKillerSteppingActionG4::UserSteppingAction(const G4Step* step) {
+    auto* track = step->GetTrack();
+    if(track->GetTrackStatus() != fAlive) {
+        return;
+    }
+
+    const auto* post_point = step->GetPostStepPoint();
+    if(conditions_.kill_outside_region) {
+        const auto& position = post_point->GetPosition();
+        if(position.x() < conditions_.region_min.x() || position.x() > conditions_.region_max.x() ||
+           position.y() < conditions_.region_min.y() || position.y() > conditions_.region_max.y() ||
+           position.z() < conditions_.region_min.z() || position.z() > conditions_.region_max.z()) {
+            track->SetTrackStatus(fStopAndKill);
+            return;
+        }
+    }
+
+    if(conditions_.energy_cut > 0 && post_point->GetKineticEnergy() < conditions_.energy_cut) {
+        // The volume is missing for tracks leaving the world
+        auto* volume = post_point->GetPhysicalVolume();
+        if(volume != nullptr && volume->GetLogicalVolume()->GetSensitiveDetector() == nullptr) {
+            track->SetTrackStatus(fStopAndKill);
+        }
+    }
+}
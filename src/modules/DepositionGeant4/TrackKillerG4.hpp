@@ -0,0 +1,87 @@
+/**
+ * @file
+ * @brief Defines the user actions for Geant4 killing tracks which are not of interest for the deposits in the sensors
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_DEPOSITION_GEANT4_TRACK_KILLER_H
+#define ALLPIX_DEPOSITION_GEANT4_TRACK_KILLER_H
+
+#include <set>
+
+#include <G4ParticleDefinition.hh>
+#include <G4ThreeVector.hh>
+#include <G4UserStackingAction.hh>
+#include <G4UserSteppingAction.hh>
+
+namespace allpix {
+    /**
+     * @brief Conditions under which tracks are killed
+     */
+    struct TrackKillingConditions {
+        // Kill tracks leaving the box spanned by the minimum and maximum corner of the region of interest
+        bool kill_outside_region{};
+        G4ThreeVector region_min;
+        G4ThreeVector region_max;
+
+        // Kill tracks outside of the sensors below this kinetic energy, disabled if zero
+        double energy_cut{};
+
+        // Kill secondaries of these particle types at their creation
+        std::set<const G4ParticleDefinition*> particles;
+
+        /**
+         * @brief Check if tracks need to be inspected while stepping
+         * @return True if the region of interest or the energy cut is enabled
+         */
+        bool killSteps() const { return kill_outside_region || energy_cut > 0; }
+    };
+
+    /**
+     * @brief Kills secondaries of the configured particle types before they are tracked
+     */
+    class TrackKillerStackingActionG4 : public G4UserStackingAction {
+    public:
+        /**
+         * @brief Constructor taking the conditions to kill tracks
+         * @param conditions Conditions to kill tracks, shared by all threads
+         */
+        explicit TrackKillerStackingActionG4(const TrackKillingConditions& conditions) : conditions_(conditions){};
+
+        /**
+         * @brief Classify a new track, killing secondaries of the configured particle types
+         * @param track The new track
+         * @return Classification of the track
+         */
+        G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* track) override;
+
+    private:
+        const TrackKillingConditions& conditions_;
+    };
+
+    /**
+     * @brief Kills tracks leaving the region of interest or falling below the energy cut outside of the sensors
+     */
+    class TrackKillerSteppingActionG4 : public G4UserSteppingAction {
+    public:
+        /**
+         * @brief Constructor taking the conditions to kill tracks
+         * @param conditions Conditions to kill tracks, shared by all threads
+         */
+        explicit TrackKillerSteppingActionG4(const TrackKillingConditions& conditions) : conditions_(conditions){};
+
+        /**
+         * @brief Check the end point of a step and kill the track if it fulfills one of the conditions
+         * @param step The step of the track
+         */
+        void UserSteppingAction(const G4Step* step) override;
+
+    private:
+        const TrackKillingConditions& conditions_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_DEPOSITION_GEANT4_TRACK_KILLER_H */
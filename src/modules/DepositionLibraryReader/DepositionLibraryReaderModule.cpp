@@ -0,0 +1,155 @@
+/**
+ * @file
+ * @brief Implementation of the module replaying charge deposits from a deposition library
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "DepositionLibraryReaderModule.hpp"
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/module/exceptions.h"
+#include "core/utils/distributions.h"
+#include "core/utils/log.h"
+#include "tools/ROOT.h"
+
+using namespace allpix;
+
+DepositionLibraryReaderModule::DepositionLibraryReaderModule(Configuration& config,
+                                                             Messenger* messenger,
+                                                             GeometryManager* geo_manager)
+    : Module(config), geo_manager_(geo_manager), messenger_(messenger) {
+    // Enable multithreading of this module if multithreading is enabled
+    allow_multithreading();
+
+    config_.setDefault("sampling", Sampling::SEQUENTIAL);
+    config_.setDefault("translation_range", ROOT::Math::XYVector(0., 0.));
+
+    sampling_ = config_.get<Sampling>("sampling");
+    translation_range_ = config_.get<ROOT::Math::XYVector>("translation_range");
+    if(translation_range_.x() < 0 || translation_range_.y() < 0) {
+        throw InvalidValueError(config_, "translation_range", "range of the translation cannot be negative");
+    }
+}
+
+void DepositionLibraryReaderModule::initialize() {
+    auto file_path = config_.getPathWithExtension("file_name", "apdl", true);
+    try {
+        library_ = std::make_unique<DepositionLibraryInput>(file_path);
+    } catch(const std::runtime_error& e) {
+        throw InvalidValueError(config_, "file_name", e.what());
+    }
+    if(library_->size() == 0) {
+        throw InvalidValueError(config_, "file_name", "deposition library does not contain any entries");
+    }
+    LOG(INFO) << "Opened deposition library with " << library_->size() << " entries";
+}
+
+void DepositionLibraryReaderModule::run(Event* event) {
+    // Select the entry of this event, sequential entries only depend on the event number to allow parallel events
+    size_t index = 0;
+    if(sampling_ == Sampling::RANDOM) {
+        index = allpix::uniform_int_distribution<size_t>(0, library_->size() - 1)(event->getRandomEngine());
+    } else {
+        index = event->number - 1;
+        if(index >= library_->size()) {
+            throw EndOfRunException("Requesting end of run, deposition library only contains " +
+                                    std::to_string(library_->size()) + " entries");
+        }
+    }
+
+    DepositionLibraryEntry entry;
+    try {
+        std::lock_guard<std::mutex> lock(library_mutex_);
+        entry = library_->read(index);
+    } catch(const std::runtime_error& e) {
+        throw ModuleError(e.what());
+    }
+    LOG(DEBUG) << "Replaying entry " << index << " of the library, recorded in event " << entry.event;
+
+    for(auto& stored : entry.detectors) {
+        if(!geo_manager_->hasDetector(stored.name)) {
+            LOG_ONCE(WARNING) << "Deposition library contains detector " << stored.name
+                              << " which is not part of the geometry, ignoring its deposits";
+            continue;
+        }
+        auto detector = geo_manager_->getDetector(stored.name);
+        auto model = detector->getModel();
+
+        // Shift all deposits and particles of the detector by the same random translation
+        ROOT::Math::XYZVector shift;
+        if(translation_range_.x() > 0 || translation_range_.y() > 0) {
+            auto half_range = translation_range_ / 2;
+            shift.SetX(allpix::uniform_real_distribution<double>(-half_range.x(), half_range.x())(event->getRandomEngine()));
+            shift.SetY(allpix::uniform_real_distribution<double>(-half_range.y(), half_range.y())(event->getRandomEngine()));
+            LOG(DEBUG) << "Translating deposits in detector " << stored.name << " by "
+                       << Units::display(shift, {"um", "mm"});
+        }
+        auto to_point = [&shift](const std::array<double, 3>& position) {
+            return ROOT::Math::XYZPoint(position[0], position[1], position[2]) + shift;
+        };
+
+        std::vector<MCParticle> mc_particles;
+        mc_particles.reserve(stored.particles.size());
+        for(const auto& particle : stored.particles) {
+            auto start = to_point(particle.start);
+            auto end = to_point(particle.end);
+            mc_particles.emplace_back(start,
+                                      detector->getGlobalPosition(start),
+                                      end,
+                                      detector->getGlobalPosition(end),
+                                      particle.particle_id,
+                                      particle.local_time,
+                                      particle.global_time);
+        }
+        std::shared_ptr<MCParticleMessage> mc_particle_message;
+        if(!mc_particles.empty()) {
+            mc_particle_message = event->makeShared<MCParticleMessage>(std::move(mc_particles), detector);
+            messenger_->dispatchMessage(this, mc_particle_message, event);
+        }
+
+        std::vector<DepositedCharge> deposits;
+        deposits.reserve(stored.deposits.size());
+        for(const auto& deposit : stored.deposits) {
+            auto position = to_point(deposit.position);
+            if(!model->isWithinSensor(position)) {
+                outside_count_++;
+                continue;
+            }
+
+            const MCParticle* mc_particle = nullptr;
+            if(mc_particle_message != nullptr && deposit.particle >= 0 &&
+               static_cast<size_t>(deposit.particle) < mc_particle_message->getData().size()) {
+                mc_particle = &mc_particle_message->getData()[static_cast<size_t>(deposit.particle)];
+            }
+            deposits.emplace_back(position,
+                                  detector->getGlobalPosition(position),
+                                  static_cast<CarrierType>(deposit.type),
+                                  deposit.charge,
+                                  deposit.local_time,
+                                  deposit.global_time,
+                                  mc_particle);
+        }
+
+        if(!deposits.empty()) {
+            LOG(DEBUG) << "Dispatching " << deposits.size() << " deposits in detector " << stored.name;
+            deposit_count_ += deposits.size();
+            auto deposit_message = event->makeShared<DepositedChargeMessage>(std::move(deposits), detector);
+            messenger_->dispatchMessage(this, deposit_message, event);
+        }
+    }
+}
+
+void DepositionLibraryReaderModule::finalize() {
+    if(outside_count_ > 0) {
+        LOG(WARNING) << outside_count_ << " deposits have been translated outside of the sensor and were discarded";
+    }
+    LOG(INFO) << "Replayed " << deposit_count_ << " deposits from the deposition library";
+}
@@ -0,0 +1,85 @@
+/**
+ * @file
+ * @brief Definition of the module replaying charge deposits from a deposition library
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <Math/Vector2D.h>
+
+#include "core/config/Configuration.hpp"
+#include "core/geometry/GeometryManager.hpp"
+#include "core/messenger/Messenger.hpp"
+#include "core/module/Event.hpp"
+#include "core/module/Module.hpp"
+
+#include "objects/DepositedCharge.hpp"
+#include "objects/MCParticle.hpp"
+
+#include "tools/deposition_library.h"
+
+namespace allpix {
+    /**
+     * @ingroup Modules
+     * @brief Module to dispatch pre-computed charge deposits stored in a deposition library
+     *
+     * Every event, one entry of a library written by the DepositionLibraryWriter module is read and its deposits and Monte
+     * Carlo particles are dispatched for all detectors. Entries are either replayed in their order or sampled randomly, and
+     * the deposits can be shifted by a random translation within the sensor.
+     */
+    class DepositionLibraryReaderModule : public Module {
+        /**
+         * @brief Sampling of the entries of the library
+         */
+        enum class Sampling {
+            SEQUENTIAL, ///< Entries in the order of the library, one per event
+            RANDOM,     ///< Entries drawn randomly for every event
+        };
+
+    public:
+        /**
+         * @brief Constructor for this unique module
+         * @param config Configuration object for this module as retrieved from the steering file
+         * @param messenger Pointer to the messenger object to allow binding to messages on the bus
+         * @param geo_manager Pointer to the geometry manager, containing the detectors
+         */
+        DepositionLibraryReaderModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager);
+
+        /**
+         * @brief Open the library and read its index
+         */
+        void initialize() override;
+
+        /**
+         * @brief Read an entry of the library and dispatch its deposits and particles
+         */
+        void run(Event* event) override;
+
+        /**
+         * @brief Display statistical summary
+         */
+        void finalize() override;
+
+    private:
+        GeometryManager* geo_manager_;
+        Messenger* messenger_;
+
+        // Library and mutex serializing the access to its file
+        std::unique_ptr<DepositionLibraryInput> library_;
+        std::mutex library_mutex_;
+
+        Sampling sampling_;
+        ROOT::Math::XYVector translation_range_;
+
+        // Statistics
+        std::atomic<size_t> deposit_count_{};
+        std::atomic<size_t> outside_count_{};
+    };
+} // namespace allpix
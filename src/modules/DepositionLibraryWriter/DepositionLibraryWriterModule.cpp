@@ -0,0 +1,118 @@
+/**
+ * @file
+ * @brief Implementation of the module writing charge deposits to a deposition library
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "DepositionLibraryWriterModule.hpp"
+
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "core/messenger/exceptions.h"
+#include "core/module/exceptions.h"
+#include "core/utils/log.h"
+#include "objects/exceptions.h"
+
+using namespace allpix;
+
+DepositionLibraryWriterModule::DepositionLibraryWriterModule(Configuration& config, Messenger* messenger, GeometryManager*)
+    : SequentialModule(config), messenger_(messenger) {
+    // Enable multithreading of this module if multithreading is enabled
+    allow_multithreading();
+
+    // Bind to the deposits and particles of all detectors
+    messenger_->bindMulti<DepositedChargeMessage>(this, MsgFlags::REQUIRED);
+    messenger_->bindMulti<MCParticleMessage>(this, MsgFlags::NONE);
+}
+
+void DepositionLibraryWriterModule::initialize() {
+    output_file_name_ = createOutputFile(config_.get<std::string>("file_name", "deposits"), "apdl", true);
+    try {
+        library_ = std::make_unique<DepositionLibraryOutput>(output_file_name_);
+    } catch(const std::runtime_error& e) {
+        throw InvalidValueError(config_, "file_name", e.what());
+    }
+}
+
+void DepositionLibraryWriterModule::run(Event* event) {
+    DepositionLibraryEntry entry;
+    entry.event = event->number;
+
+    // Store the particles of every detector and remember their index to link the deposits
+    std::map<std::string, size_t> detector_index;
+    std::map<const MCParticle*, int> particle_index;
+    auto get_detector = [&](const std::shared_ptr<Detector>& detector) -> DepositionLibraryEntry::Detector& {
+        auto iter = detector_index.emplace(detector->getName(), entry.detectors.size());
+        if(iter.second) {
+            entry.detectors.emplace_back();
+            entry.detectors.back().name = detector->getName();
+        }
+        return entry.detectors[iter.first->second];
+    };
+
+    try {
+        for(const auto& message : messenger_->fetchMultiMessage<MCParticleMessage>(this, event)) {
+            auto& detector = get_detector(message->getDetector());
+            for(const auto& particle : message->getData()) {
+                auto start = particle.getLocalStartPoint();
+                auto end = particle.getLocalEndPoint();
+                particle_index[&particle] = static_cast<int>(detector.particles.size());
+                detector.particles.push_back({{start.x(), start.y(), start.z()},
+                                              {end.x(), end.y(), end.z()},
+                                              particle.getLocalTime(),
+                                              particle.getGlobalTime(),
+                                              particle.getParticleID(),
+                                              0});
+            }
+        }
+    } catch(const MessageNotFoundException&) {
+        LOG(TRACE) << "No Monte Carlo particles received, storing deposits without particle information";
+    }
+
+    for(const auto& message : messenger_->fetchMultiMessage<DepositedChargeMessage>(this, event)) {
+        auto& detector = get_detector(message->getDetector());
+        detector.deposits.reserve(detector.deposits.size() + message->getData().size());
+        for(const auto& deposit : message->getData()) {
+            auto position = deposit.getLocalPosition();
+            int particle = -1;
+            try {
+                auto iter = particle_index.find(deposit.getMCParticle());
+                if(iter != particle_index.end()) {
+                    particle = iter->second;
+                }
+            } catch(const MissingReferenceException&) {
+                // Deposits without a particle are stored unlinked
+            }
+            detector.deposits.push_back({{position.x(), position.y(), position.z()},
+                                         deposit.getLocalTime(),
+                                         deposit.getGlobalTime(),
+                                         deposit.getCharge(),
+                                         static_cast<int32_t>(deposit.getType()),
+                                         particle,
+                                         0});
+        }
+        deposit_count_ += message->getData().size();
+        LOG(DEBUG) << "Storing " << message->getData().size() << " deposits of detector "
+                   << message->getDetector()->getName();
+    }
+
+    library_->write(entry);
+}
+
+void DepositionLibraryWriterModule::finalize() {
+    auto entries = library_->size();
+    try {
+        library_->close();
+    } catch(const std::runtime_error& e) {
+        throw ModuleError(e.what());
+    }
+
+    LOG(STATUS) << "Wrote " << deposit_count_ << " deposits of " << entries << " events to deposition library:" << std::endl
+                << output_file_name_;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file
+ * @brief Definition of the module writing charge deposits to a deposition library
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include <memory>
+#include <string>
+
+#include "core/config/Configuration.hpp"
+#include "core/geometry/GeometryManager.hpp"
+#include "core/messenger/Messenger.hpp"
+#include "core/module/Event.hpp"
+#include "core/module/Module.hpp"
+
+#include "objects/DepositedCharge.hpp"
+#include "objects/MCParticle.hpp"
+
+#include "tools/deposition_library.h"
+
+namespace allpix {
+    /**
+     * @ingroup Modules
+     * @brief Module to store the charge deposits of every event in a binary deposition library
+     *
+     * Collects the deposited charges and Monte Carlo particles of all detectors and appends them as one entry per event to
+     * a deposition library, which can be replayed with the DepositionLibraryReader module.
+     */
+    class DepositionLibraryWriterModule : public SequentialModule {
+    public:
+        /**
+         * @brief Constructor for this unique module
+         * @param config Configuration object for this module as retrieved from the steering file
+         * @param messenger Pointer to the messenger object to allow binding to messages on the bus
+         * @param geo_manager Pointer to the geometry manager, containing the detectors
+         */
+        DepositionLibraryWriterModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager);
+
+        /**
+         * @brief Create the library file
+         */
+        void initialize() override;
+
+        /**
+         * @brief Append the deposits of the event to the library
+         */
+        void run(Event* event) override;
+
+        /**
+         * @brief Write the index of the library and close it
+         */
+        void finalize() override;
+
+    private:
+        Messenger* messenger_;
+
+        std::string output_file_name_;
+        std::unique_ptr<DepositionLibraryOutput> library_;
+        size_t deposit_count_{};
+    };
+} // namespace allpix
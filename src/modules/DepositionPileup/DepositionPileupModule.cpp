@@ -0,0 +1,138 @@
+/**
+ * @file
+ * @brief Implementation of the module overlaying pile-up deposits from a deposition library
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "DepositionPileupModule.hpp"
+
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/module/exceptions.h"
+#include "core/utils/distributions.h"
+#include "core/utils/log.h"
+#include "core/utils/unit.h"
+
+using namespace allpix;
+
+DepositionPileupModule::DepositionPileupModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager)
+    : Module(config), geo_manager_(geo_manager), messenger_(messenger) {
+    // Enable multithreading of this module if multithreading is enabled
+    allow_multithreading();
+
+    config_.setDefault<double>("pileup_mean", 1.);
+    config_.setDefaultArray<double>("time_offset_range", {0., 0.});
+
+    pileup_mean_ = config_.get<double>("pileup_mean");
+    if(pileup_mean_ < 0) {
+        throw InvalidValueError(config_, "pileup_mean", "mean number of pile-up events cannot be negative");
+    }
+    auto time_offset_range = config_.getArray<double>("time_offset_range");
+    if(time_offset_range.size() != 2 || time_offset_range[0] > time_offset_range[1]) {
+        throw InvalidValueError(
+            config_, "time_offset_range", "range of the time offsets requires a lower and a larger or equal upper bound");
+    }
+    time_offset_min_ = time_offset_range[0];
+    time_offset_max_ = time_offset_range[1];
+
+    // Receive the deposits of all detectors, events without deposits still receive pile-up
+    messenger_->bindMulti<DepositedChargeMessage>(this, MsgFlags::NONE);
+}
+
+/**
+ * The full library is read once, such that the entries can be overlaid by all threads without serializing the access to the
+ * file.
+ */
+void DepositionPileupModule::initialize() {
+    auto file_path = config_.getPathWithExtension("file_name", "apdl", true);
+    try {
+        DepositionLibraryInput library(file_path);
+        entries_.reserve(library.size());
+        for(size_t index = 0; index < library.size(); ++index) {
+            entries_.push_back(library.read(index));
+        }
+    } catch(const std::runtime_error& e) {
+        throw InvalidValueError(config_, "file_name", e.what());
+    }
+    if(entries_.empty()) {
+        throw InvalidValueError(config_, "file_name", "deposition library does not contain any entries");
+    }
+    LOG(INFO) << "Loaded " << entries_.size() << " pile-up entries from deposition library";
+}
+
+void DepositionPileupModule::run(Event* event) {
+    // Collect the deposits of the event for every detector
+    std::map<std::shared_ptr<const Detector>, std::vector<DepositedCharge>> deposits;
+    auto messages = messenger_->fetchMultiMessage<DepositedChargeMessage>(this, event);
+    for(auto& message : messages) {
+        auto& detector_deposits = deposits[message->getDetector()];
+        detector_deposits.insert(detector_deposits.end(), message->getData().begin(), message->getData().end());
+    }
+
+    // Draw the pile-up entries, every entry is shifted by the same time offset in all detectors
+    auto count = allpix::poisson_distribution<unsigned int>(pileup_mean_)(event->getRandomEngine());
+    LOG(DEBUG) << "Overlaying " << count << " pile-up events";
+    for(unsigned int i = 0; i < count; ++i) {
+        auto index = allpix::uniform_int_distribution<size_t>(0, entries_.size() - 1)(event->getRandomEngine());
+        auto offset = time_offset_min_;
+        if(time_offset_max_ > time_offset_min_) {
+            offset =
+                allpix::uniform_real_distribution<double>(time_offset_min_, time_offset_max_)(event->getRandomEngine());
+        }
+        LOG(TRACE) << "Overlaying entry " << index << " of the library with a time offset of "
+                   << Units::display(offset, {"ns", "ps"});
+
+        for(const auto& stored : entries_[index].detectors) {
+            if(!geo_manager_->hasDetector(stored.name)) {
+                LOG_ONCE(WARNING) << "Deposition library contains detector " << stored.name
+                                  << " which is not part of the geometry, ignoring its deposits";
+                continue;
+            }
+            auto detector = geo_manager_->getDetector(stored.name);
+            auto model = detector->getModel();
+
+            // The particles of the pile-up events are not dispatched, the deposits therefore do not refer to them
+            auto& detector_deposits = deposits[detector];
+            for(const auto& deposit : stored.deposits) {
+                auto position = ROOT::Math::XYZPoint(deposit.position[0], deposit.position[1], deposit.position[2]);
+                if(!model->isWithinSensor(position)) {
+                    outside_count_++;
+                    continue;
+                }
+                detector_deposits.emplace_back(position,
+                                               detector->getGlobalPosition(position),
+                                               static_cast<CarrierType>(deposit.type),
+                                               deposit.charge,
+                                               deposit.local_time + offset,
+                                               deposit.global_time + offset);
+                pileup_deposits_++;
+            }
+        }
+    }
+    pileup_events_ += count;
+
+    // Dispatch the merged deposits of every detector
+    for(auto& [detector, detector_deposits] : deposits) {
+        if(detector_deposits.empty()) {
+            continue;
+        }
+        LOG(DEBUG) << "Dispatching " << detector_deposits.size() << " deposits in detector " << detector->getName();
+        auto deposit_message = event->makeShared<DepositedChargeMessage>(std::move(detector_deposits), detector);
+        messenger_->dispatchMessage(this, deposit_message, event);
+    }
+}
+
+void DepositionPileupModule::finalize() {
+    if(outside_count_ > 0) {
+        LOG(WARNING) << outside_count_ << " pile-up deposits are outside of the sensor and were discarded";
+    }
+    LOG(INFO) << "Overlaid " << pileup_events_ << " pile-up events with " << pileup_deposits_ << " deposits";
+}
@@ -0,0 +1,74 @@
+/**
+ * @file
+ * @brief Definition of the module overlaying pile-up deposits from a deposition library
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "core/config/Configuration.hpp"
+#include "core/geometry/GeometryManager.hpp"
+#include "core/messenger/Messenger.hpp"
+#include "core/module/Event.hpp"
+#include "core/module/Module.hpp"
+
+#include "objects/DepositedCharge.hpp"
+
+#include "tools/deposition_library.h"
+
+namespace allpix {
+    /**
+     * @ingroup Modules
+     * @brief Module to overlay pile-up events from a deposition library on the deposits of every event
+     *
+     * All entries of a library written by the DepositionLibraryWriter module are loaded into memory at initialization and
+     * shared by all threads. For every event, a number of entries drawn from a Poisson distribution is overlaid with random
+     * time offsets on the deposits of the event, and the merged deposits are dispatched for every detector.
+     */
+    class DepositionPileupModule : public Module {
+    public:
+        /**
+         * @brief Constructor for this unique module
+         * @param config Configuration object for this module as retrieved from the steering file
+         * @param messenger Pointer to the messenger object to allow binding to messages on the bus
+         * @param geo_manager Pointer to the geometry manager, containing the detectors
+         */
+        DepositionPileupModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager);
+
+        /**
+         * @brief Load all entries of the library
+         */
+        void initialize() override;
+
+        /**
+         * @brief Overlay pile-up entries on the deposits of the event and dispatch the merged deposits
+         */
+        void run(Event* event) override;
+
+        /**
+         * @brief Display statistical summary
+         */
+        void finalize() override;
+
+    private:
+        GeometryManager* geo_manager_;
+        Messenger* messenger_;
+
+        // Entries of the library, read-only after initialization
+        std::vector<DepositionLibraryEntry> entries_;
+
+        double pileup_mean_{};
+        double time_offset_min_{};
+        double time_offset_max_{};
+
+        // Statistics
+        std::atomic<size_t> pileup_events_{};
+        std::atomic<size_t> pileup_deposits_{};
+        std::atomic<size_t> outside_count_{};
+    };
+} // namespace allpix
@@ -12,6 +12,7 @@
 #include <cmath>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "core/messenger/Messenger.hpp"
 #include "core/module/Event.hpp"
@@ -83,20 +84,53 @@ void DepositionPointChargeModule::initialize() {
         ConfigManager* conf_manager = getConfigManager();
         auto events = conf_manager->getGlobalConfiguration().get<unsigned int>("number_of_events");
 
+        // Several scan points per event are placed in separate pixels, shifted by multiples of the pitch from the pixel
+        // volume in the center of the sensor such that they have the same in-pixel position as with a single scan point
+        config_.setDefault("scan_points_per_event", 1);
+        config_.setDefault("scan_spacing", 5);
+        auto scan_points = config_.get<unsigned int>("scan_points_per_event");
+        if(scan_points == 0) {
+            throw InvalidValueError(config_, "scan_points_per_event", "at least one scan point per event is required");
+        }
+        if(scan_points > 1) {
+            auto spacing = config_.get<unsigned int>("scan_spacing");
+            if(spacing < 2) {
+                throw InvalidValueError(config_, "scan_spacing", "scan points have to be separated by at least one pixel");
+            }
+            auto sites_x = model->getNPixels().x() / spacing;
+            auto sites_y = model->getNPixels().y() / spacing;
+            if(sites_x * sites_y < scan_points) {
+                throw InvalidValueError(config_,
+                                        "scan_points_per_event",
+                                        "only " + std::to_string(sites_x * sites_y) + " scan points spaced by " +
+                                            std::to_string(spacing) + " pixels fit into the pixel matrix");
+            }
+
+            scan_shifts_.clear();
+            for(unsigned int point = 0; point < scan_points; ++point) {
+                auto shift_x = static_cast<int>((point % sites_x) * spacing) - static_cast<int>((sites_x - 1) * spacing / 2);
+                auto shift_y = static_cast<int>((point / sites_x) * spacing) - static_cast<int>((sites_y - 1) * spacing / 2);
+                scan_shifts_.emplace_back(shift_x * model->getPixelSize().x(), shift_y * model->getPixelSize().y(), 0);
+            }
+            LOG(INFO) << "Scanning " << scan_points << " pixels per event, spaced by " << spacing << " pixels";
+        }
+        auto positions = events * scan_points;
+        auto quantity = (scan_points > 1 ? "Number of scan positions" : "Number of events");
+
         // Scan with points required 3D scanning, scan with MIPs only 2D:
         if(type_ == SourceType::MIP) {
-            root_ = static_cast<unsigned int>(std::round(std::sqrt(events)));
-            if(events != root_ * root_) {
-                LOG(WARNING) << "Number of events is not a square, pixel cell volume cannot fully be covered in scan. "
+            root_ = static_cast<unsigned int>(std::round(std::sqrt(positions)));
+            if(positions != root_ * root_) {
+                LOG(WARNING) << quantity << " is not a square, pixel cell volume cannot fully be covered in scan. "
                              << "Closest square is " << root_ * root_;
             }
             // Calculate voxel size:
             voxel_ = ROOT::Math::XYZVector(
                 model->getPixelSize().x() / root_, model->getPixelSize().y() / root_, model->getSensorSize().z());
         } else {
-            root_ = static_cast<unsigned int>(std::round(std::cbrt(events)));
-            if(events != root_ * root_ * root_) {
-                LOG(WARNING) << "Number of events is not a cube, pixel cell volume cannot fully be covered in scan. "
+            root_ = static_cast<unsigned int>(std::round(std::cbrt(positions)));
+            if(positions != root_ * root_ * root_) {
+                LOG(WARNING) << quantity << " is not a cube, pixel cell volume cannot fully be covered in scan. "
                              << "Closest cube is " << root_ * root_ * root_;
             }
             // Calculate voxel size:
@@ -109,12 +143,12 @@ void DepositionPointChargeModule::initialize() {
 
 void DepositionPointChargeModule::run(Event* event) {
 
-    ROOT::Math::XYZPoint position;
+    std::vector<ROOT::Math::XYZPoint> positions;
     auto model = detector_->getModel();
 
     if(model_ == DepositionModel::FIXED) {
         // Fixed position as read from the configuration:
-        position = position_;
+        positions.emplace_back(position_);
     } else if(model_ == DepositionModel::SCAN) {
         // Center the volume to be scanned in the center of the sensor,
         // reference point is lower left corner of one pixel volume
@@ -122,10 +156,15 @@ void DepositionPointChargeModule::run(Event* event) {
                    ROOT::Math::XYZVector(
                        model->getPixelSize().x() / 2.0, model->getPixelSize().y() / 2.0, model->getSensorSize().z() / 2.0);
         LOG(DEBUG) << "Reference: " << Units::display(ref, {"um", "mm"});
-        position = ROOT::Math::XYZPoint(voxel_.x() * static_cast<double>((event->number - 1) % root_),
-                                        voxel_.y() * static_cast<double>(((event->number - 1) / root_) % root_),
-                                        voxel_.z() * static_cast<double>(((event->number - 1) / root_ / root_) % root_)) +
-                   ref;
+
+        // Consecutive scan positions are distributed over the scan points of the event
+        for(size_t point = 0; point < scan_shifts_.size(); ++point) {
+            auto index = (event->number - 1) * scan_shifts_.size() + point;
+            positions.push_back(ROOT::Math::XYZPoint(voxel_.x() * static_cast<double>(index % root_),
+                                                     voxel_.y() * static_cast<double>((index / root_) % root_),
+                                                     voxel_.z() * static_cast<double>((index / root_ / root_) % root_)) +
+                                ref + scan_shifts_[point]);
+        }
     } else {
         // Calculate random offset from configured position
         auto shift = [&](auto size) {
@@ -136,22 +175,37 @@ void DepositionPointChargeModule::run(Event* event) {
         };
 
         // Spot around the configured position
-        position = position_ + shift(spot_size_);
-    }
-
-    // Create charge carriers at requested position
-    if(type_ == SourceType::MIP) {
-        DepositLine(event, position);
-    } else {
-        DepositPoint(event, position);
+        positions.emplace_back(position_ + shift(spot_size_));
     }
-}
 
-void DepositionPointChargeModule::DepositPoint(Event* event, const ROOT::Math::XYZPoint& position) {
-    // Vector of deposited charges and their "MCParticle"
+    // Vector of deposited charges and their "MCParticle", the charges refer to the particles which must not be reallocated
     std::vector<DepositedCharge> charges;
     std::vector<MCParticle> mcparticles;
+    mcparticles.reserve(positions.size());
+
+    // Create charge carriers at requested positions
+    for(const auto& position : positions) {
+        if(type_ == SourceType::MIP) {
+            DepositLine(position, charges, mcparticles);
+        } else {
+            DepositPoint(position, charges, mcparticles);
+        }
+    }
+    if(mcparticles.empty()) {
+        return;
+    }
+
+    // Dispatch the messages to the framework
+    auto mcparticle_message = event->makeShared<MCParticleMessage>(std::move(mcparticles), detector_);
+    messenger_->dispatchMessage(this, mcparticle_message, event);
+
+    auto deposit_message = event->makeShared<DepositedChargeMessage>(std::move(charges), detector_);
+    messenger_->dispatchMessage(this, deposit_message, event);
+}
 
+void DepositionPointChargeModule::DepositPoint(const ROOT::Math::XYZPoint& position,
+                                               std::vector<DepositedCharge>& charges,
+                                               std::vector<MCParticle>& mcparticles) {
     LOG(DEBUG) << "Position (local coordinates): " << Units::display(position, {"um", "mm"});
     // Cross-check calculated position to be within sensor:
     if(!detector_->getModel()->isWithinSensor(position)) {
@@ -170,22 +224,13 @@ void DepositionPointChargeModule::DepositPoint(Event* event, const ROOT::Math::X
     charges.emplace_back(position, position_global, CarrierType::HOLE, carriers_, 0., 0., &(mcparticles.back()));
     LOG(DEBUG) << "Deposited " << carriers_ << " charge carriers of both types at global position "
                << Units::display(position_global, {"um", "mm"}) << " in detector " << detector_->getName();
-
-    // Dispatch the messages to the framework
-    auto mcparticle_message = std::make_shared<MCParticleMessage>(std::move(mcparticles), detector_);
-    messenger_->dispatchMessage(this, mcparticle_message, event);
-
-    auto deposit_message = std::make_shared<DepositedChargeMessage>(std::move(charges), detector_);
-    messenger_->dispatchMessage(this, deposit_message, event);
 }
 
-void DepositionPointChargeModule::DepositLine(Event* event, const ROOT::Math::XYZPoint& position) {
+void DepositionPointChargeModule::DepositLine(const ROOT::Math::XYZPoint& position,
+                                              std::vector<DepositedCharge>& charges,
+                                              std::vector<MCParticle>& mcparticles) {
     auto model = detector_->getModel();
 
-    // Vector of deposited charges and their "MCParticle"
-    std::vector<DepositedCharge> charges;
-    std::vector<MCParticle> mcparticles;
-
     // Cross-check calculated position to be within sensor:
     if(!detector_->getModel()->isWithinSensor(ROOT::Math::XYZPoint(position.x(), position.y(), 0))) {
         LOG(DEBUG) << "Requested position is outside active sensor volume.";
@@ -215,11 +260,4 @@ void DepositionPointChargeModule::DepositLine(Event* event, const ROOT::Math::XY
         LOG(TRACE) << "Deposited " << carriers_ << " charge carriers of both types at global position "
                    << Units::display(position_global, {"um", "mm"}) << " in detector " << detector_->getName();
     }
-
-    // Dispatch the messages to the framework
-    auto mcparticle_message = std::make_shared<MCParticleMessage>(std::move(mcparticles), detector_);
-    messenger_->dispatchMessage(this, mcparticle_message, event);
-
-    auto deposit_message = std::make_shared<DepositedChargeMessage>(std::move(charges), detector_);
-    messenger_->dispatchMessage(this, deposit_message, event);
 }
@@ -8,8 +8,11 @@
  */
 
 #include <string>
+#include <vector>
 
 #include "core/module/Module.hpp"
+#include "objects/DepositedCharge.hpp"
+#include "objects/MCParticle.hpp"
 
 namespace allpix {
     /**
@@ -58,17 +61,23 @@ namespace allpix {
     private:
         /**
          * @brief Helper function to deposit charges at a single point
-         * @param event Pointer to current event
-         * @param position
+         * @param position Position of the deposition in local coordinates
+         * @param charges Deposited charges of the event to append to
+         * @param mcparticles MCParticles of the event to append to, with capacity for the new particle
          */
-        void DepositPoint(Event*, const ROOT::Math::XYZPoint& position);
+        void DepositPoint(const ROOT::Math::XYZPoint& position,
+                          std::vector<DepositedCharge>& charges,
+                          std::vector<MCParticle>& mcparticles);
 
         /**
          * @brief Helper function to deposit charges along a line
-         * @param event Pointer to current event
-         * @param position
+         * @param position Position of the line in local coordinates
+         * @param charges Deposited charges of the event to append to
+         * @param mcparticles MCParticles of the event to append to, with capacity for the new particle
          */
-        void DepositLine(Event*, const ROOT::Math::XYZPoint& position);
+        void DepositLine(const ROOT::Math::XYZPoint& position,
+                         std::vector<DepositedCharge>& charges,
+                         std::vector<MCParticle>& mcparticles);
 
         Messenger* messenger_;
 
@@ -81,5 +90,6 @@ namespace allpix {
         double step_size_z_{};
         unsigned int root_{}, carriers_{};
         ROOT::Math::XYZVector position_{};
+        std::vector<ROOT::Math::XYZVector> scan_shifts_{ROOT::Math::XYZVector()};
     };
 } // namespace allpix
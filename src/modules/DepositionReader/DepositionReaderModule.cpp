@@ -10,14 +10,80 @@
 
 #include "DepositionReaderModule.hpp"
 
+#include <array>
+#include <filesystem>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
+#include "core/module/ThreadPool.hpp"
 #include "core/utils/distributions.h"
 #include "core/utils/log.h"
 
 using namespace allpix;
 
+namespace {
+    // Event headers consist of a word starting with E, followed by the event number
+    uint64_t parse_event_header(std::string_view line) {
+        auto separator = line.find_first_of(" \t");
+        if(separator == std::string_view::npos) {
+            return 0;
+        }
+        return LineTokenizer::parse<uint64_t>(LineTokenizer::trim(line.substr(separator)));
+    }
+
+    // Size and modification time of an input file, identifying the version of the file an index has been created for
+    std::array<uint64_t, 2> file_version(const std::string& file_path) {
+        return {static_cast<uint64_t>(std::filesystem::file_size(file_path)),
+                static_cast<uint64_t>(std::filesystem::last_write_time(file_path).time_since_epoch().count())};
+    }
+
+    // Index files start with a magic word, the version of the indexed file and the number of entries, followed by the
+    // entries themselves
+    template <size_t N>
+    bool read_index_file(const std::string& index_path,
+                         const std::array<char, 8>& magic,
+                         const std::string& file_path,
+                         std::vector<std::array<uint64_t, N>>& entries) {
+        std::ifstream index_in(index_path, std::ios::binary);
+        std::array<char, 8> magic_read{};
+        std::array<uint64_t, 2> version_read{};
+        uint64_t count = 0;
+        index_in.read(magic_read.data(), magic_read.size());
+        index_in.read(reinterpret_cast<char*>(version_read.data()), sizeof(version_read)); // NOLINT
+        index_in.read(reinterpret_cast<char*>(&count), sizeof(count));                     // NOLINT
+        if(!index_in.good() || magic_read != magic || version_read != file_version(file_path)) {
+            return false;
+        }
+        entries.resize(count);
+        index_in.read(reinterpret_cast<char*>(entries.data()), // NOLINT
+                      static_cast<std::streamsize>(entries.size() * sizeof(entries[0])));
+        return index_in.good();
+    }
+
+    template <size_t N>
+    bool write_index_file(const std::string& index_path,
+                          const std::array<char, 8>& magic,
+                          const std::string& file_path,
+                          const std::vector<std::array<uint64_t, N>>& entries) {
+        std::ofstream index_out(index_path, std::ios::binary);
+        auto version = file_version(file_path);
+        uint64_t count = entries.size();
+        index_out.write(magic.data(), magic.size());
+        index_out.write(reinterpret_cast<const char*>(version.data()), sizeof(version)); // NOLINT
+        index_out.write(reinterpret_cast<const char*>(&count), sizeof(count));           // NOLINT
+        index_out.write(reinterpret_cast<const char*>(entries.data()),                   // NOLINT
+                        static_cast<std::streamsize>(entries.size() * sizeof(entries[0])));
+        index_out.close();
+        if(index_out.fail()) {
+            std::filesystem::remove(index_path);
+            return false;
+        }
+        return true;
+    }
+} // namespace
+
 DepositionReaderModule::DepositionReaderModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager)
     : SequentialModule(config), geo_manager_(geo_manager), messenger_(messenger) {
     // Enable multithreading of this module if multithreading is enabled
@@ -32,6 +98,9 @@ DepositionReaderModule::DepositionReaderModule(Configuration& config, Messenger*
     config_.setDefault<bool>("require_sequential_events", true);
     config_.setDefault<bool>("assign_timestamps", true);
     config_.setDefault<bool>("create_mcparticles", true);
+    config_.setDefault<bool>("csv_index", true);
+    config_.setDefault<bool>("root_index", true);
+    config_.setDefault<bool>("assign_by_position", false);
 
     config_.setDefaultArray<std::string>("branch_names",
                                          {"event",
@@ -62,11 +131,17 @@ DepositionReaderModule::DepositionReaderModule(Configuration& config, Messenger*
     require_sequential_events_ = config_.get<bool>("require_sequential_events");
     time_available_ = config_.get<bool>("assign_timestamps");
     create_mcparticles_ = config.get<bool>("create_mcparticles");
+    csv_index_ = config_.get<bool>("csv_index");
+    root_index_ = config_.get<bool>("root_index");
+    assign_by_position_ = config_.get<bool>("assign_by_position");
 
     output_plots_ = config_.get<bool>("output_plots");
 }
 
 void DepositionReaderModule::initialize() {
+    for(auto& detector : geo_manager_->getDetectors()) {
+        detectors_[detector->getName()] = detector;
+    }
 
     if(!time_available_) {
         LOG(WARNING) << "No time information provided, all energy deposition will be assigned to t = 0";
@@ -77,26 +152,10 @@ void DepositionReaderModule::initialize() {
 
     // Check which file type we want to read:
     if(file_model_ == FileModel::CSV) {
-        // Open the file with the objects
-        auto file_path = config_.getPathWithExtension("file_name", "csv", true);
-        input_file_ = std::make_unique<std::ifstream>(file_path);
-        if(!input_file_->is_open()) {
-            throw InvalidValueError(config_, "file_name", "could not open input file");
-        }
+        file_path_ = config_.getPathWithExtension("file_name", "csv", true);
     } else if(file_model_ == FileModel::ROOT) {
-        auto file_path = config_.getPathWithExtension("file_name", "root", true);
-        input_file_root_ = std::make_unique<TFile>(file_path.c_str(), "READ");
-        if(!input_file_root_->IsOpen()) {
-            throw InvalidValueError(config_, "file_name", "could not open input file");
-        }
-        input_file_root_->cd();
-        auto tree = config_.get<std::string>("tree_name");
-        tree_reader_ = std::make_shared<TTreeReader>(tree.c_str(), input_file_root_.get());
-        if(tree_reader_->GetEntryStatus() == TTreeReader::kEntryNoTree) {
-            throw InvalidValueError(config_, "tree_name", "could not open tree");
-        }
-        LOG(INFO) << "Initialized tree reader for tree " << tree << ", found " << tree_reader_->GetEntries(false)
-                  << " entries";
+        file_path_ = config_.getPathWithExtension("file_name", "root", true);
+        tree_name_ = config_.get<std::string>("tree_name");
 
         // Check if we have branch names configured and use the default values otherwise:
         auto branch_list = config_.getArray<std::string>("branch_names");
@@ -113,60 +172,41 @@ void DepositionReaderModule::initialize() {
 
         // Convert list to map for easier lookup:
         size_t it = (time_available_ ? 3 : 2);
-        std::map<std::string, std::string> branches = {{"event", branch_list.at(0)},
-                                                       {"energy", branch_list.at(1)},
-                                                       {"px", branch_list.at(it++)},
-                                                       {"py", branch_list.at(it++)},
-                                                       {"pz", branch_list.at(it++)},
-                                                       {"volume", branch_list.at(it++)},
-                                                       {"pdg", branch_list.at(it++)}};
+        branches_ = {{"event", branch_list.at(0)},
+                     {"energy", branch_list.at(1)},
+                     {"px", branch_list.at(it++)},
+                     {"py", branch_list.at(it++)},
+                     {"pz", branch_list.at(it++)},
+                     {"volume", branch_list.at(it++)},
+                     {"pdg", branch_list.at(it++)}};
         if(time_available_) {
-            branches["time"] = branch_list.at(2);
+            branches_["time"] = branch_list.at(2);
         }
         if(create_mcparticles_) {
-            branches["track_id"] = branch_list.at(it++);
-            branches["parent_id"] = branch_list.at(it++);
+            branches_["track_id"] = branch_list.at(it++);
+            branches_["parent_id"] = branch_list.at(it++);
         }
 
         LOG(DEBUG) << "List of configured branches and their names:";
-        for(const auto& branch : branches) {
+        for(const auto& branch : branches_) {
             LOG(DEBUG) << branch.first << ": \"" << branch.second << "\"";
         }
+    }
 
-        // Set up branch pointers
-        create_tree_reader(event_, branches.at("event"));
-        create_tree_reader(edep_, branches.at("energy"));
-        if(time_available_) {
-            create_tree_reader(time_, branches.at("time"));
-        }
-        create_tree_reader(px_, branches.at("px"));
-        create_tree_reader(py_, branches.at("py"));
-        create_tree_reader(pz_, branches.at("pz"));
-        create_tree_reader(volume_, branches.at("volume"));
-        create_tree_reader(pdg_code_, branches.at("pdg"));
-        if(create_mcparticles_) {
-            create_tree_reader(track_id_, branches.at("track_id"));
-            create_tree_reader(parent_id_, branches.at("parent_id"));
-        }
-
-        // Advance to first entry of the tree:
-        tree_reader_->Next();
+    // Open the input file, which also checks the branches of ROOT trees
+    reader_ = open_file();
+    if(file_model_ == FileModel::ROOT) {
+        LOG(INFO) << "Initialized tree reader for tree " << tree_name_ << ", found "
+                  << reader_->tree_reader->GetEntries(false) << " entries";
+    }
 
-        // Only after loading the first entry we can actually check the branch status:
-        check_tree_reader(event_);
-        check_tree_reader(edep_);
-        if(time_available_) {
-            check_tree_reader(time_);
-        }
-        check_tree_reader(px_);
-        check_tree_reader(py_);
-        check_tree_reader(pz_);
-        check_tree_reader(volume_);
-        check_tree_reader(pdg_code_);
-        if(create_mcparticles_) {
-            check_tree_reader(track_id_);
-            check_tree_reader(parent_id_);
-        }
+    // With an index, every event can be read independently of the others by every thread from its own file handle
+    if(file_model_ == FileModel::CSV && csv_index_) {
+        load_csv_index(file_path_);
+        waive_sequence_requirement();
+    } else if(file_model_ == FileModel::ROOT && root_index_) {
+        load_root_index();
+        waive_sequence_requirement();
     }
 
     // If requested, prepare output plots
@@ -186,12 +226,88 @@ void DepositionReaderModule::initialize() {
     }
 }
 
+std::unique_ptr<DepositionReaderModule::FileReader> DepositionReaderModule::open_file() const {
+    auto reader = std::make_unique<FileReader>();
+    if(file_model_ == FileModel::CSV) {
+        // Open the file with the objects
+        reader->input_file = std::make_unique<std::ifstream>(file_path_, std::ios::binary);
+        if(!reader->input_file->is_open()) {
+            throw InvalidValueError(config_, "file_name", "could not open input file");
+        }
+        reader->line_reader = std::make_unique<BufferedLineReader>(*reader->input_file);
+        return reader;
+    }
+
+    reader->input_file_root = std::make_unique<TFile>(file_path_.c_str(), "READ");
+    if(!reader->input_file_root->IsOpen()) {
+        throw InvalidValueError(config_, "file_name", "could not open input file");
+    }
+    reader->input_file_root->cd();
+    reader->tree_reader = std::make_shared<TTreeReader>(tree_name_.c_str(), reader->input_file_root.get());
+    if(reader->tree_reader->GetEntryStatus() == TTreeReader::kEntryNoTree) {
+        throw InvalidValueError(config_, "tree_name", "could not open tree");
+    }
+
+    // Set up branch pointers
+    create_tree_reader(*reader, reader->event, branches_.at("event"));
+    create_tree_reader(*reader, reader->edep, branches_.at("energy"));
+    if(time_available_) {
+        create_tree_reader(*reader, reader->time, branches_.at("time"));
+    }
+    create_tree_reader(*reader, reader->px, branches_.at("px"));
+    create_tree_reader(*reader, reader->py, branches_.at("py"));
+    create_tree_reader(*reader, reader->pz, branches_.at("pz"));
+    create_tree_reader(*reader, reader->volume, branches_.at("volume"));
+    create_tree_reader(*reader, reader->pdg_code, branches_.at("pdg"));
+    if(create_mcparticles_) {
+        create_tree_reader(*reader, reader->track_id, branches_.at("track_id"));
+        create_tree_reader(*reader, reader->parent_id, branches_.at("parent_id"));
+    }
+
+    // Advance to first entry of the tree:
+    reader->tree_reader->Next();
+
+    // Only after loading the first entry we can actually check the branch status:
+    check_tree_reader(reader->event);
+    check_tree_reader(reader->edep);
+    if(time_available_) {
+        check_tree_reader(reader->time);
+    }
+    check_tree_reader(reader->px);
+    check_tree_reader(reader->py);
+    check_tree_reader(reader->pz);
+    check_tree_reader(reader->volume);
+    check_tree_reader(reader->pdg_code);
+    if(create_mcparticles_) {
+        check_tree_reader(reader->track_id);
+        check_tree_reader(reader->parent_id);
+    }
+    return reader;
+}
+
+/**
+ * Every thread opens the file separately, such that the events of indexed files can be read concurrently. The entries read
+ * for an event only depend on the event number and not on the thread.
+ */
+DepositionReaderModule::FileReader& DepositionReaderModule::get_thread_reader() {
+    auto thread_num = ThreadPool::threadNum();
+    std::lock_guard<std::mutex> lock(readers_mutex_);
+    auto& reader = readers_[thread_num];
+    if(reader == nullptr) {
+        LOG(DEBUG) << "Opening input file for thread " << thread_num;
+        reader = open_file();
+    }
+    return *reader;
+}
+
 template <typename T>
-void DepositionReaderModule::create_tree_reader(std::shared_ptr<T>& branch_ptr, const std::string& name) {
-    branch_ptr = std::make_shared<T>(*tree_reader_, name.c_str());
+void DepositionReaderModule::create_tree_reader(FileReader& reader,
+                                                std::shared_ptr<T>& branch_ptr,
+                                                const std::string& name) const {
+    branch_ptr = std::make_shared<T>(*reader.tree_reader, name.c_str());
 }
 
-template <typename T> void DepositionReaderModule::check_tree_reader(std::shared_ptr<T> branch_ptr) {
+template <typename T> void DepositionReaderModule::check_tree_reader(std::shared_ptr<T> branch_ptr) const {
     if(branch_ptr->GetSetupStatus() < 0) {
         throw InvalidValueError(
             config_, "branch_names", "Could not read branch \"" + std::string(branch_ptr->GetBranchName()) + "\"");
@@ -220,19 +336,48 @@ void DepositionReaderModule::run(Event* event) {
     bool end_of_run = false;
     std::string eof_message;
 
-    do {
+    // Indexed files are read through the file handle of the current thread, other files sequentially
+    bool indexed = (file_model_ == FileModel::CSV ? csv_index_ : root_index_);
+    auto& reader = (indexed ? get_thread_reader() : *reader_);
+
+    // Jump to the event in indexed CSV files
+    bool event_available = true;
+    if(file_model_ == FileModel::CSV && csv_index_) {
+        try {
+            event_available = seek_csv_event(reader, event_num);
+        } catch(EndOfRunException& e) {
+            end_of_run = true;
+            eof_message = e.what();
+        }
+    }
+
+    // Read all entries of the event from indexed ROOT trees at once
+    std::vector<Deposit> root_deposits;
+    size_t root_deposit = 0;
+    bool end_of_tree = false;
+    if(file_model_ == FileModel::ROOT && root_index_) {
+        try {
+            end_of_tree = read_root_event(reader, event_num, root_deposits);
+        } catch(EndOfRunException& e) {
+            end_of_run = true;
+            eof_message = e.what();
+        }
+    }
+
+    while(event_available && !end_of_run) {
         bool read_status = false;
-        ROOT::Math::XYZPoint global_position;
-        std::string volume;
-        double energy = NAN, time = NAN;
-        int pdg_code = 0, track_id = 0, parent_id = 0;
+        Deposit deposit;
 
         try {
             if(file_model_ == FileModel::CSV) {
-                read_status = read_csv(event_num, volume, global_position, time, energy, pdg_code, track_id, parent_id);
-            } else if(file_model_ == FileModel::ROOT) {
-                read_status = read_root(
-                    event_num, curr_event_id, volume, global_position, time, energy, pdg_code, track_id, parent_id);
+                read_status = read_csv(reader, event_num, deposit);
+            } else if(root_index_) {
+                read_status = (root_deposit < root_deposits.size());
+                if(read_status) {
+                    deposit = std::move(root_deposits[root_deposit++]);
+                }
+            } else {
+                read_status = read_root(reader, event_num, curr_event_id, deposit);
             }
         } catch(EndOfRunException& e) {
             end_of_run = true;
@@ -243,16 +388,31 @@ void DepositionReaderModule::run(Event* event) {
             break;
         }
 
-        auto detectors = geo_manager_->getDetectors();
-        auto pos = std::find_if(detectors.begin(), detectors.end(), [volume](const std::shared_ptr<Detector>& d) {
-            return d->getName() == volume;
-        });
-        if(pos == detectors.end()) {
-            LOG(TRACE) << "Ignored detector \"" << volume << "\", not found in current simulation";
-            continue;
+        const auto& global_position = deposit.position;
+        const auto& volume = deposit.volume;
+        auto time = deposit.time;
+        auto energy = deposit.energy;
+        auto pdg_code = deposit.pdg_code;
+        auto track_id = deposit.track_id;
+        auto parent_id = deposit.parent_id;
+
+        // Assign detector, either from the position of the deposit or from its volume name
+        std::shared_ptr<Detector> detector;
+        if(assign_by_position_) {
+            detector = geo_manager_->getDetectorAt(global_position);
+            if(detector == nullptr) {
+                LOG(TRACE) << "Ignored deposit at " << Units::display(global_position, {"mm", "um"})
+                           << ", not within any sensor";
+                continue;
+            }
+        } else {
+            auto pos = detectors_.find(volume);
+            if(pos == detectors_.end()) {
+                LOG(TRACE) << "Ignored detector \"" << volume << "\", not found in current simulation";
+                continue;
+            }
+            detector = pos->second;
         }
-        // Assign detector
-        auto detector = (*pos);
         LOG(DEBUG) << "Found detector \"" << detector->getName() << "\"";
 
         auto local_position = detector->getLocalPosition(global_position);
@@ -299,7 +459,11 @@ void DepositionReaderModule::run(Event* event) {
         }
 
         particles_to_deposits[detector].push_back(track_id);
-    } while(true);
+    }
+    if(end_of_tree && !end_of_run) {
+        end_of_run = true;
+        eof_message = "Requesting end of run: end of tree reached";
+    }
 
     LOG(INFO) << "Finished reading event " << event;
 
@@ -347,7 +511,7 @@ void DepositionReaderModule::run(Event* event) {
 
         // Send the mc particle information if available
         bool has_mcparticles = !mc_particles.empty();
-        auto mc_particle_message = std::make_shared<MCParticleMessage>(std::move(mc_particles), detector);
+        auto mc_particle_message = event->makeShared<MCParticleMessage>(std::move(mc_particles), detector);
         if(has_mcparticles) {
             messenger_->dispatchMessage(this, mc_particle_message, event);
         }
@@ -383,7 +547,7 @@ void DepositionReaderModule::run(Event* event) {
 
             // Create a new charge deposit message
             LOG(DEBUG) << "Detector " << detector->getName() << " has " << deposits[detector].size() << " deposits";
-            auto deposit_message = std::make_shared<DepositedChargeMessage>(std::move(deposits[detector]), detector);
+            auto deposit_message = event->makeShared<DepositedChargeMessage>(std::move(deposits[detector]), detector);
 
             // Dispatch the message
             messenger_->dispatchMessage(this, deposit_message, event);
@@ -411,17 +575,9 @@ void DepositionReaderModule::finalize() {
         }
     }
 }
-bool DepositionReaderModule::read_root(uint64_t event_num,
-                                       int64_t& curr_event_id,
-                                       std::string& volume,
-                                       ROOT::Math::XYZPoint& position,
-                                       double& time,
-                                       double& energy,
-                                       int& pdg_code,
-                                       int& track_id,
-                                       int& parent_id) {
-
-    auto status = tree_reader_->GetEntryStatus();
+bool DepositionReaderModule::read_root(FileReader& reader, uint64_t event_num, int64_t& curr_event_id, Deposit& deposit) {
+
+    auto status = reader.tree_reader->GetEntryStatus();
     if(status == TTreeReader::kEntryNotFound || status == TTreeReader::kEntryBeyondEnd) {
         throw EndOfRunException("Requesting end of run: end of tree reached");
     } else if(status != TTreeReader::kEntryValid) {
@@ -430,78 +586,74 @@ bool DepositionReaderModule::read_root(uint64_t event_num,
 
     if(require_sequential_events_) {
         // sequential read, return if eventID is larger than allpix-squared event number
-        if(static_cast<uint64_t>(*event_->Get()) > event_num - 1) {
+        if(static_cast<uint64_t>(*reader.event->Get()) > event_num - 1) {
             return false;
         }
     } else {
         // non-sequential read, return if eventID changes (requires events to be in blocks)
         if(curr_event_id == -1) {
             // first entry in event, save eventID for later
-            curr_event_id = *event_->Get();
+            curr_event_id = *reader.event->Get();
             LOG(TRACE) << "Read eventID " << curr_event_id;
         } else {
             // check if eventID changed compared to last entry, if yes reset curr_event_id
-            if(*event_->Get() != curr_event_id) {
+            if(*reader.event->Get() != curr_event_id) {
                 curr_event_id = -1;
                 return false;
             }
         }
     }
 
+    read_root_entry(reader, deposit);
+
+    // Return and advance to next tree entry:
+    reader.tree_reader->Next();
+    return true;
+}
+
+void DepositionReaderModule::read_root_entry(FileReader& reader, Deposit& deposit) const {
     // Read detector name
-    // NOTE volume_->GetSize() is the full length, we might want to cut only part of the name
+    // NOTE volume->GetSize() is the full length, we might want to cut only part of the name
     // NOTE the string is a C string ending with \0, so we have to remove the last character
-    auto full_length = volume_->GetSize() - 1;
+    auto full_length = reader.volume->GetSize() - 1;
     auto length = (volume_chars_ != 0 ? std::min(volume_chars_, full_length) : full_length);
-    volume = std::string(static_cast<char*>(volume_->GetAddress()), length);
+    deposit.volume.assign(static_cast<char*>(reader.volume->GetAddress()), length);
 
     // Read other information, interpret in framework units:
-    position = ROOT::Math::XYZPoint(
-        Units::get(*px_->Get(), unit_length_), Units::get(*py_->Get(), unit_length_), Units::get(*pz_->Get(), unit_length_));
+    deposit.position = ROOT::Math::XYZPoint(Units::get(*reader.px->Get(), unit_length_),
+                                            Units::get(*reader.py->Get(), unit_length_),
+                                            Units::get(*reader.pz->Get(), unit_length_));
 
     // Attempt to read time only if available:
-    time = (time_available_ ? Units::get(*time_->Get(), unit_time_) : 0);
-    energy = Units::get(*edep_->Get(), unit_energy_);
+    deposit.time = (time_available_ ? Units::get(*reader.time->Get(), unit_time_) : 0);
+    deposit.energy = Units::get(*reader.edep->Get(), unit_energy_);
 
     // Read PDG code and track ids
-    pdg_code = (*pdg_code_->Get());
+    deposit.pdg_code = (*reader.pdg_code->Get());
     if(create_mcparticles_) {
-        track_id = (*track_id_->Get());
-        parent_id = (*parent_id_->Get());
+        deposit.track_id = (*reader.track_id->Get());
+        deposit.parent_id = (*reader.parent_id->Get());
     }
-
-    // Return and advance to next tree entry:
-    tree_reader_->Next();
-    return true;
 }
 
-bool DepositionReaderModule::read_csv(uint64_t event_num,
-                                      std::string& volume,
-                                      ROOT::Math::XYZPoint& position,
-                                      double& time,
-                                      double& energy,
-                                      int& pdg_code,
-                                      int& track_id,
-                                      int& parent_id) {
+bool DepositionReaderModule::read_csv(FileReader& reader, uint64_t event_num, Deposit& deposit) {
 
-    std::string line, tmp;
+    std::string_view line;
     do {
         // Read input file line-by-line and trim whitespaces at beginning and end:
-        std::getline(*input_file_, line);
-        line = allpix::trim(line);
+        auto terminated = reader.line_reader->getline(line);
+        line = LineTokenizer::trim(line);
         LOG(TRACE) << "Line read: " << line;
 
         // Request end of run if we reached end of file:
-        if(input_file_->eof()) {
+        if(!terminated) {
             throw EndOfRunException("Requesting end of run, CSV file only contains data for " + std::to_string(event_num) +
                                     " events");
         }
 
         // Check for event header:
-        if(line.front() == 'E') {
-            std::stringstream lse(line);
-            uint64_t event_read = 0;
-            lse >> tmp >> event_read;
+        if(!line.empty() && line.front() == 'E') {
+            auto event_read = parse_event_header(line);
             if(event_read + 1 > event_num) {
                 return false;
             }
@@ -510,48 +662,182 @@ bool DepositionReaderModule::read_csv(uint64_t event_num,
         }
     } while(line.empty() || line.front() == '#' || line.front() == 'E');
 
-    std::istringstream ls(line);
-    double px = NAN, py = NAN, pz = NAN;
+    // Split the line in place, without copying the fields
+    LineTokenizer tokens(line);
+    deposit.pdg_code = LineTokenizer::parse<int>(tokens.next());
+    double time = 0;
+    if(time_available_) {
+        time = LineTokenizer::parse<double>(tokens.next());
+    }
+    auto energy = LineTokenizer::parse<double>(tokens.next());
 
-    std::getline(ls, tmp, ',');
-    std::istringstream(tmp) >> pdg_code;
+    auto px = LineTokenizer::parse<double>(tokens.next());
+    auto py = LineTokenizer::parse<double>(tokens.next());
+    auto pz = LineTokenizer::parse<double>(tokens.next());
 
-    if(time_available_) {
-        std::getline(ls, tmp, ',');
-        std::istringstream(tmp) >> time;
+    auto volume_token = tokens.next();
+    // Select the detector name from this:
+    if(volume_chars_ != 0) {
+        volume_token = volume_token.substr(0, volume_chars_);
+        LOG(TRACE) << "Truncated detector name: " << volume_token;
     }
+    deposit.volume.assign(volume_token.data(), volume_token.size());
 
-    std::getline(ls, tmp, ',');
-    std::istringstream(tmp) >> energy;
+    if(create_mcparticles_) {
+        deposit.track_id = LineTokenizer::parse<int>(tokens.next());
+        deposit.parent_id = LineTokenizer::parse<int>(tokens.next());
+    }
 
-    std::getline(ls, tmp, ',');
-    std::istringstream(tmp) >> px;
-    std::getline(ls, tmp, ',');
-    std::istringstream(tmp) >> py;
-    std::getline(ls, tmp, ',');
-    std::istringstream(tmp) >> pz;
+    // Calculate the charge deposit at a global position and convert the proper units
+    deposit.position =
+        ROOT::Math::XYZPoint(Units::get(px, unit_length_), Units::get(py, unit_length_), Units::get(pz, unit_length_));
+    deposit.time = (time_available_ ? Units::get(time, unit_time_) : 0);
+    deposit.energy = Units::get(energy, unit_energy_);
 
-    std::getline(ls, volume, ',');
-    volume = allpix::trim(volume);
+    return true;
+}
 
-    if(create_mcparticles_) {
-        std::getline(ls, tmp, ',');
-        std::istringstream(tmp) >> track_id;
-        std::getline(ls, tmp, ',');
-        std::istringstream(tmp) >> parent_id;
+/**
+ * The sidecar file next to the CSV file stores the size and modification time of the CSV file it was created for, followed
+ * by the number of events and pairs of event number and offset. It is recreated if it does not match the CSV file. If it
+ * cannot be written, the index is only kept in memory.
+ */
+void DepositionReaderModule::load_csv_index(const std::string& file_path) {
+    constexpr std::array<char, 8> magic = {'A', 'P', 'C', 'S', 'V', 'I', 'D', 'X'};
+    auto index_path = file_path + ".index";
+
+    // Try to load an existing index matching the file
+    std::vector<std::array<uint64_t, 2>> entries;
+    if(read_index_file(index_path, magic, file_path, entries)) {
+        for(const auto& entry : entries) {
+            csv_event_offsets_.emplace(entry[0], entry[1]);
+        }
+        LOG(INFO) << "Loaded index of " << csv_event_offsets_.size() << " events from " << index_path;
+        return;
+    }
+    if(std::filesystem::exists(index_path)) {
+        LOG(INFO) << "Index " << index_path << " does not match the input file, recreating it";
     }
 
-    // Select the detector name from this:
-    if(volume_chars_ != 0) {
-        volume = volume.substr(0, std::min(volume_chars_, volume.size()));
-        LOG(TRACE) << "Truncated detector name: " << volume;
+    // Scan the file once for the event headers
+    LOG(INFO) << "Indexing events of " << file_path;
+    std::string_view line;
+    bool terminated = true;
+    while(terminated) {
+        terminated = reader_->line_reader->getline(line);
+        line = LineTokenizer::trim(line);
+        if(!line.empty() && line.front() == 'E') {
+            // Only the first occurrence of an event is indexed
+            csv_event_offsets_.emplace(parse_event_header(line), reader_->line_reader->tell());
+        }
     }
+    reader_->line_reader->seek(0);
+    LOG(INFO) << "Indexed " << csv_event_offsets_.size() << " events";
 
-    // Calculate the charge deposit at a global position and convert the proper units
-    position =
-        ROOT::Math::XYZPoint(Units::get(px, unit_length_), Units::get(py, unit_length_), Units::get(pz, unit_length_));
-    time = (time_available_ ? Units::get(time, unit_time_) : 0);
-    energy = Units::get(energy, unit_energy_);
+    // Store the index next to the file
+    entries.clear();
+    for(const auto& [event, offset] : csv_event_offsets_) {
+        entries.push_back({event, offset});
+    }
+    if(!write_index_file(index_path, magic, file_path, entries)) {
+        LOG(WARNING) << "Could not write index file " << index_path << ", the input file will be indexed again next time";
+    }
+}
+
+/**
+ * The tree is indexed by reading only its event branch. Every block of consecutive entries with the same event id is stored
+ * with its range of entries in the sidecar file next to the ROOT file, which is recreated if it does not match the file.
+ * With sequential events, the event id N is read as event N + 1 and only the first block of every event id is used.
+ * Otherwise, the blocks are assigned to the events in the order of the tree.
+ */
+void DepositionReaderModule::load_root_index() {
+    constexpr std::array<char, 8> magic = {'A', 'P', 'R', 'O', 'O', 'T', 'I', 'X'};
+    auto index_path = file_path_ + "." + tree_name_ + ".index";
 
+    // Try to load an existing index matching the file, otherwise scan the event branch of the tree
+    if(read_index_file(index_path, magic, file_path_, root_event_blocks_)) {
+        LOG(INFO) << "Loaded index of " << root_event_blocks_.size() << " blocks of entries from " << index_path;
+    } else {
+        if(std::filesystem::exists(index_path)) {
+            LOG(INFO) << "Index " << index_path << " does not match the input file, recreating it";
+        }
+        LOG(INFO) << "Indexing events of tree " << tree_name_ << " in " << file_path_;
+
+        // A separate reader of the file only reads the baskets of the event branch
+        TFile index_file(file_path_.c_str(), "READ");
+        TTreeReader index_reader(tree_name_.c_str(), &index_file);
+        TTreeReaderValue<int> event_id(index_reader, branches_.at("event").c_str());
+        root_event_blocks_.clear();
+        uint64_t entry = 0;
+        while(index_reader.Next()) {
+            auto id = static_cast<uint64_t>(*event_id);
+            if(root_event_blocks_.empty() || root_event_blocks_.back()[0] != id) {
+                root_event_blocks_.push_back({id, entry, entry});
+            }
+            root_event_blocks_.back()[2] = ++entry;
+        }
+        LOG(INFO) << "Indexed " << root_event_blocks_.size() << " blocks of entries";
+
+        if(!write_index_file(index_path, magic, file_path_, root_event_blocks_)) {
+            LOG(WARNING) << "Could not write index file " << index_path
+                         << ", the input file will be indexed again next time";
+        }
+    }
+
+    for(size_t block = 0; block < root_event_blocks_.size(); ++block) {
+        root_event_ids_.emplace(root_event_blocks_[block][0], block);
+    }
+}
+
+bool DepositionReaderModule::read_root_event(FileReader& reader, uint64_t event_num, std::vector<Deposit>& deposits) {
+    // Find the block of entries of the event
+    size_t block = 0;
+    if(require_sequential_events_) {
+        auto id = root_event_ids_.find(event_num - 1);
+        if(id == root_event_ids_.end()) {
+            if(root_event_ids_.empty() || event_num - 1 > root_event_ids_.rbegin()->first) {
+                throw EndOfRunException("Requesting end of run: end of tree reached");
+            }
+            LOG(DEBUG) << "Tree does not contain event " << event_num;
+            return false;
+        }
+        block = id->second;
+    } else {
+        if(event_num > root_event_blocks_.size()) {
+            throw EndOfRunException("Requesting end of run: end of tree reached");
+        }
+        block = event_num - 1;
+    }
+    auto first = root_event_blocks_[block][1];
+    auto last = root_event_blocks_[block][2];
+
+    // Read all entries of the block
+    deposits.resize(static_cast<size_t>(last - first));
+    for(size_t i = 0; i < deposits.size(); ++i) {
+        auto status = reader.tree_reader->SetEntry(static_cast<Long64_t>(first + i));
+        if(status != TTreeReader::kEntryValid) {
+            throw EndOfRunException("Problem reading from tree, error: " + std::to_string(static_cast<int>(status)));
+        }
+        read_root_entry(reader, deposits[i]);
+    }
+    LOG(DEBUG) << "Read " << deposits.size() << " entries " << first << " to " << last - 1 << " of event " << event_num;
+
+    // The end of the run is reached with the event containing the last entries of the tree
+    return last == static_cast<uint64_t>(reader.tree_reader->GetEntries(false));
+}
+
+bool DepositionReaderModule::seek_csv_event(FileReader& reader, uint64_t event_num) {
+    // Deposits following the header of event N belong to event N + 1
+    auto offset = csv_event_offsets_.find(event_num - 1);
+    if(offset == csv_event_offsets_.end()) {
+        if(csv_event_offsets_.empty() || event_num - 1 > csv_event_offsets_.rbegin()->first) {
+            throw EndOfRunException("Requesting end of run, CSV file only contains data for " +
+                                    std::to_string(csv_event_offsets_.empty() ? 0 : csv_event_offsets_.rbegin()->first + 1) +
+                                    " events");
+        }
+        LOG(DEBUG) << "CSV file does not contain event " << event_num;
+        return false;
+    }
+    reader.line_reader->seek(offset->second);
     return true;
 }
@@ -13,9 +13,15 @@
  * Refer to the User's Manual for more details.
  */
 
+#include <array>
 #include <fstream>
 #include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <TFile.h>
 #include <TH1D.h>
@@ -27,6 +33,7 @@
 #include "core/messenger/Messenger.hpp"
 #include "core/module/Module.hpp"
 #include "objects/DepositedCharge.hpp"
+#include "tools/buffered_line_reader.h"
 
 namespace allpix {
     /**
@@ -76,26 +83,55 @@ namespace allpix {
         GeometryManager* geo_manager_;
         Messenger* messenger_;
 
-        // File containing the input data
-        std::unique_ptr<std::ifstream> input_file_;
-        std::unique_ptr<TFile> input_file_root_;
+        /**
+         * @brief Input file opened by a single reader, with the branches of the tree for ROOT files
+         */
+        struct FileReader {
+            std::unique_ptr<std::ifstream> input_file;
+            std::unique_ptr<BufferedLineReader> line_reader;
+            std::unique_ptr<TFile> input_file_root;
+
+            std::shared_ptr<TTreeReader> tree_reader;
+            std::shared_ptr<TTreeReaderValue<int>> event;
+            std::shared_ptr<TTreeReaderValue<double>> edep;
+            std::shared_ptr<TTreeReaderValue<double>> time;
+            std::shared_ptr<TTreeReaderValue<double>> px;
+            std::shared_ptr<TTreeReaderValue<double>> py;
+            std::shared_ptr<TTreeReaderValue<double>> pz;
+            std::shared_ptr<TTreeReaderArray<char>> volume;
+            std::shared_ptr<TTreeReaderValue<int>> pdg_code;
+            std::shared_ptr<TTreeReaderValue<int>> track_id;
+            std::shared_ptr<TTreeReaderValue<int>> parent_id;
+        };
+
+        /**
+         * @brief Open the input file and set up the branches of the tree for ROOT files
+         * @return Reader of the input file
+         */
+        std::unique_ptr<FileReader> open_file() const;
+
+        /**
+         * @brief Get the reader of the current thread for indexed files, opening the input file if it is not yet open for
+         * this thread
+         * @return Reader of the current thread
+         */
+        FileReader& get_thread_reader();
 
         // Helper to create and check tree branches
-        template <typename T> void create_tree_reader(std::shared_ptr<T>& branch_ptr, const std::string& name);
-        template <typename T> void check_tree_reader(std::shared_ptr<T> branch_ptr);
-
-        // Set up branches:
-        std::shared_ptr<TTreeReader> tree_reader_;
-        std::shared_ptr<TTreeReaderValue<int>> event_;
-        std::shared_ptr<TTreeReaderValue<double>> edep_;
-        std::shared_ptr<TTreeReaderValue<double>> time_;
-        std::shared_ptr<TTreeReaderValue<double>> px_;
-        std::shared_ptr<TTreeReaderValue<double>> py_;
-        std::shared_ptr<TTreeReaderValue<double>> pz_;
-        std::shared_ptr<TTreeReaderArray<char>> volume_;
-        std::shared_ptr<TTreeReaderValue<int>> pdg_code_;
-        std::shared_ptr<TTreeReaderValue<int>> track_id_;
-        std::shared_ptr<TTreeReaderValue<int>> parent_id_;
+        template <typename T>
+        void create_tree_reader(FileReader& reader, std::shared_ptr<T>& branch_ptr, const std::string& name) const;
+        template <typename T> void check_tree_reader(std::shared_ptr<T> branch_ptr) const;
+
+        // Input file and its configured branches
+        std::string file_path_;
+        std::string tree_name_;
+        std::map<std::string, std::string> branches_;
+
+        // Reader of the input file used for sequential reading, and readers of every thread for indexed files
+        std::unique_ptr<FileReader> reader_;
+        std::mutex readers_mutex_;
+        std::map<unsigned int, std::unique_ptr<FileReader>> readers_;
+
         double charge_creation_energy_;
         double fano_factor_;
 
@@ -106,23 +142,72 @@ namespace allpix {
 
         bool require_sequential_events_{}, create_mcparticles_{}, time_available_{};
 
-        bool read_csv(uint64_t event_num,
-                      std::string& volume,
-                      ROOT::Math::XYZPoint& position,
-                      double& time,
-                      double& energy,
-                      int& pdg_code,
-                      int& track_id,
-                      int& parent_id);
-        bool read_root(uint64_t event_num,
-                       int64_t& curr_event_id,
-                       std::string& volume,
-                       ROOT::Math::XYZPoint& position,
-                       double& time,
-                       double& energy,
-                       int& pdg_code,
-                       int& track_id,
-                       int& parent_id);
+        // Detectors by name, or assigned by the position of the deposits through the geometry
+        bool assign_by_position_{};
+        std::unordered_map<std::string, std::shared_ptr<Detector>> detectors_;
+
+        // Index of the CSV file, containing the offset of the first line after the header of every event
+        bool csv_index_{};
+        std::map<uint64_t, uint64_t> csv_event_offsets_;
+
+        // Index of the ROOT tree, containing the event id and the range of entries of every block of entries of one event in
+        // the order of the tree, and the first block of every event id
+        bool root_index_{};
+        std::vector<std::array<uint64_t, 3>> root_event_blocks_;
+        std::map<uint64_t, size_t> root_event_ids_;
+
+        /**
+         * @brief Deposit read from a file, with all values in framework units
+         */
+        struct Deposit {
+            std::string volume;
+            ROOT::Math::XYZPoint position;
+            double time{};
+            double energy{};
+            int pdg_code{};
+            int track_id{};
+            int parent_id{};
+        };
+
+        /**
+         * @brief Load the index of the CSV file from its sidecar file, or scan the input file and store it
+         * @param file_path Path of the CSV file
+         */
+        void load_csv_index(const std::string& file_path);
+
+        /**
+         * @brief Continue reading the CSV file at the first line of an event
+         * @param reader Reader of the CSV file
+         * @param event_num Number of the event
+         * @return True if the file contains the event, false if the event has no entries
+         * @throws EndOfRunException If the event is beyond the last event of the file
+         */
+        bool seek_csv_event(FileReader& reader, uint64_t event_num);
+
+        /**
+         * @brief Load the index of the ROOT tree from its sidecar file, or scan the event branch of the tree and store it
+         */
+        void load_root_index();
+
+        /**
+         * @brief Read all deposits of an event from the indexed ROOT tree at once
+         * @param reader Reader of the ROOT file
+         * @param event_num Number of the event
+         * @param deposits Deposits of the event, empty if the tree does not contain the event
+         * @return True if the event contains the last entries of the tree
+         * @throws EndOfRunException If the event is beyond the last event of the tree
+         */
+        bool read_root_event(FileReader& reader, uint64_t event_num, std::vector<Deposit>& deposits);
+
+        /**
+         * @brief Read the values of the current entry of the ROOT tree
+         * @param reader Reader of the ROOT file
+         * @param deposit Deposit to store the values in
+         */
+        void read_root_entry(FileReader& reader, Deposit& deposit) const;
+
+        bool read_csv(FileReader& reader, uint64_t event_num, Deposit& deposit);
+        bool read_root(FileReader& reader, uint64_t event_num, int64_t& curr_event_id, Deposit& deposit);
 
         // Vector of histogram pointers for debugging plots
         std::map<std::string, Histogram<TH1D>> charge_per_event_;
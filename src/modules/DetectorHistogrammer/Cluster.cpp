@@ -11,30 +11,22 @@
 
 #include <algorithm>
 #include <cmath>
-#include <set>
+#include <utility>
 
 #include "core/utils/log.h"
 #include "objects/exceptions.h"
 
 using namespace allpix;
 
-Cluster::Cluster(const PixelHit* seed_pixel_hit) : seed_pixel_hit_(seed_pixel_hit) {
-    pixel_hits_.insert(seed_pixel_hit);
-    cluster_charge_ = seed_pixel_hit->getSignal();
+Cluster::Cluster(std::vector<const PixelHit*> pixel_hits) : pixel_hits_(std::move(pixel_hits)) {
+    seed_pixel_hit_ = pixel_hits_.front();
 
-    minX_ = seed_pixel_hit->getPixel().getIndex().x();
+    minX_ = seed_pixel_hit_->getPixel().getIndex().x();
     maxX_ = minX_;
-    minY_ = seed_pixel_hit->getPixel().getIndex().y();
+    minY_ = seed_pixel_hit_->getPixel().getIndex().y();
     maxY_ = minY_;
 
-    for(const auto* mc_particle : seed_pixel_hit->getMCParticles()) {
-        mc_particles_.insert(mc_particle);
-    }
-}
-
-bool Cluster::addPixelHit(const PixelHit* pixel_hit) {
-    auto ret = pixel_hits_.insert(pixel_hit);
-    if(ret.second == true) {
+    for(const auto* pixel_hit : pixel_hits_) {
         cluster_charge_ += pixel_hit->getSignal();
         unsigned int pixX = pixel_hit->getPixel().getIndex().x();
         unsigned int pixY = pixel_hit->getPixel().getIndex().y();
@@ -49,13 +41,13 @@ bool Cluster::addPixelHit(const PixelHit* pixel_hit) {
             seed_pixel_hit_ = pixel_hit;
         }
 
-        for(const auto* mc_particle : pixel_hit->getMCParticles()) {
-            mc_particles_.insert(mc_particle);
-        }
-
-        return true;
+        const auto& mc_particles = pixel_hit->getMCParticles();
+        mc_particles_.insert(mc_particles_.end(), mc_particles.begin(), mc_particles.end());
     }
-    return false;
+
+    // Keep every MCParticle only once
+    std::sort(mc_particles_.begin(), mc_particles_.end());
+    mc_particles_.erase(std::unique(mc_particles_.begin(), mc_particles_.end()), mc_particles_.end());
 }
 
 ROOT::Math::XYZPoint Cluster::getPosition() const {
@@ -75,7 +67,7 @@ std::pair<unsigned int, unsigned int> Cluster::getSizeXY() const {
 /**
  * MCParticles can only be fetched if the full history of objects are in scope and stored
  */
-std::set<const MCParticle*> Cluster::getMCParticles() const {
+const std::vector<const MCParticle*>& Cluster::getMCParticles() const {
     return mc_particles_;
 }
 
@@ -12,7 +12,7 @@
 
 #include <Math/Vector3D.h>
 
-#include <set>
+#include <vector>
 
 #include "objects/Pixel.hpp"
 #include "objects/PixelHit.hpp"
@@ -23,9 +23,9 @@ namespace allpix {
     public:
         /**
          * @brief Construct a cluster
-         * @param seed_pixel_hit PixelHit to start the cluster with
+         * @param pixel_hits PixelHits forming the cluster, each PixelHit is only allowed once
          */
-        explicit Cluster(const PixelHit* seed_pixel_hit);
+        explicit Cluster(std::vector<const PixelHit*> pixel_hits);
 
         /**
          * @brief Get the total accumulated signal of the cluster
@@ -33,12 +33,6 @@ namespace allpix {
          */
         double getCharge() const { return cluster_charge_; }
 
-        /**
-         * @brief Add a PixelHit to the cluster
-         * @param pixel_hit PixelHit to be added
-         */
-        bool addPixelHit(const PixelHit* pixel_hit);
-
         /**
          * @brief Get the cluster size
          * @return cluster size
@@ -75,19 +69,19 @@ namespace allpix {
          * @brief Get the PixelHits contained in this cluster
          * @return List of all contained PixelHits
          */
-        std::set<const PixelHit*> getPixelHits() const { return pixel_hits_; }
+        const std::vector<const PixelHit*>& getPixelHits() const { return pixel_hits_; }
 
         /**
          * @brief Get all MCParticles related to the cluster
-         * @return Vector of all related MCParticles
+         * @return Vector of all related MCParticles, sorted by their address
          */
-        std::set<const MCParticle*> getMCParticles() const;
+        const std::vector<const MCParticle*>& getMCParticles() const;
 
     private:
         const PixelHit* seed_pixel_hit_;
 
-        std::set<const PixelHit*> pixel_hits_;
-        std::set<const MCParticle*> mc_particles_;
+        std::vector<const PixelHit*> pixel_hits_;
+        std::vector<const MCParticle*> mc_particles_;
 
         double cluster_charge_{};
 
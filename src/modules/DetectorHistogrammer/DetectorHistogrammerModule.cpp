@@ -10,6 +10,8 @@
 #include "DetectorHistogrammerModule.hpp"
 
 #include <algorithm>
+#include <cmath>
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -20,6 +22,8 @@
 #include "core/utils/log.h"
 
 #include "tools/ROOT.h"
+#include "tools/pixel_clustering.h"
+#include "tools/units.h"
 
 using namespace allpix;
 
@@ -45,6 +49,7 @@ DetectorHistogrammerModule::DetectorHistogrammerModule(Configuration& config,
         DisplacementVector2D<Cartesian2D<int>>(static_cast<int>(Units::convert(model->getPixelSize().x(), "um")),
                                                static_cast<int>(Units::convert(model->getPixelSize().y(), "um"))));
     config_.setDefault<double>("max_cluster_charge", Units::get(50., "ke"));
+    config_.setDefault<size_t>("sparse_threshold", 65536);
 
     matching_cut_ = config_.get<XYVector>("matching_cut");
     track_resolution_ = config_.get<XYVector>("track_resolution");
@@ -61,20 +66,37 @@ void DetectorHistogrammerModule::initialize() {
     auto xpixels = static_cast<int>(model->getNPixels().x());
     auto ypixels = static_cast<int>(model->getNPixels().y());
 
+    // Histograms with more bins than the threshold only store their filled bins until they are written
+    auto sparse_threshold = config_.get<size_t>("sparse_threshold");
+
     // Create histogram of hitmap
     LOG(TRACE) << "Creating histograms";
     std::string hit_map_title = "Hitmap for " + detector_->getName() + ";x (pixels);y (pixels);hits";
-    hit_map =
-        CreateHistogram<TH2D>("hit_map", hit_map_title.c_str(), xpixels, -0.5, xpixels - 0.5, ypixels, -0.5, ypixels - 0.5);
+    hit_map = CreateSparseHistogram<TH2D>(
+        sparse_threshold, "hit_map", hit_map_title.c_str(), xpixels, -0.5, xpixels - 0.5, ypixels, -0.5, ypixels - 0.5);
 
     std::string charge_map_title = "Charge map for " + detector_->getName() + ";x (pixels);y (pixels); charge [ke]";
-    charge_map = CreateHistogram<TH2D>(
-        "charge_map", charge_map_title.c_str(), xpixels, -0.5, xpixels - 0.5, ypixels, -0.5, ypixels - 0.5);
+    charge_map = CreateSparseHistogram<TH2D>(sparse_threshold,
+                                             "charge_map",
+                                             charge_map_title.c_str(),
+                                             xpixels,
+                                             -0.5,
+                                             xpixels - 0.5,
+                                             ypixels,
+                                             -0.5,
+                                             ypixels - 0.5);
 
     // Create histogram of cluster map
     std::string cluster_map_title = "Cluster map for " + detector_->getName() + ";x (pixels);y (pixels); clusters";
-    cluster_map = CreateHistogram<TH2D>(
-        "cluster_map", cluster_map_title.c_str(), xpixels, -0.5, xpixels - 0.5, ypixels, -0.5, ypixels - 0.5);
+    cluster_map = CreateSparseHistogram<TH2D>(sparse_threshold,
+                                              "cluster_map",
+                                              cluster_map_title.c_str(),
+                                              xpixels,
+                                              -0.5,
+                                              xpixels - 0.5,
+                                              ypixels,
+                                              -0.5,
+                                              ypixels - 0.5);
 
     // Calculate the granularity of in-pixel maps:
     auto inpixel_bins = config_.get<DisplacementVector2D<Cartesian2D<int>>>("granularity");
@@ -89,63 +111,72 @@ void DetectorHistogrammerModule::initialize() {
     // Create histogram of cluster map
     std::string cluster_size_map_title = "Cluster size as function of in-pixel impact position for " + detector_->getName() +
                                          ";x%pitch [#mum];y%pitch [#mum]";
-    cluster_size_map = CreateHistogram<TProfile2D>("cluster_size_map",
-                                                   cluster_size_map_title.c_str(),
-                                                   inpixel_bins.x(),
-                                                   -pitch_x / 2,
-                                                   pitch_x / 2,
-                                                   inpixel_bins.y(),
-                                                   -pitch_y / 2,
-                                                   pitch_y / 2);
+    cluster_size_map = CreateSparseHistogram<TProfile2D>(sparse_threshold,
+                                                         "cluster_size_map",
+                                                         cluster_size_map_title.c_str(),
+                                                         inpixel_bins.x(),
+                                                         -pitch_x / 2,
+                                                         pitch_x / 2,
+                                                         inpixel_bins.y(),
+                                                         -pitch_y / 2,
+                                                         pitch_y / 2);
 
     std::string cluster_size_x_map_title = "Cluster size in X as function of in-pixel impact position for " +
                                            detector_->getName() + ";x%pitch [#mum];y%pitch [#mum]";
-    cluster_size_x_map = CreateHistogram<TProfile2D>("cluster_size_x_map",
-                                                     cluster_size_x_map_title.c_str(),
-                                                     inpixel_bins.x(),
-                                                     -pitch_x / 2,
-                                                     pitch_x / 2,
-                                                     inpixel_bins.y(),
-                                                     -pitch_y / 2,
-                                                     pitch_y / 2);
+    cluster_size_x_map = CreateSparseHistogram<TProfile2D>(sparse_threshold,
+                                                           "cluster_size_x_map",
+                                                           cluster_size_x_map_title.c_str(),
+                                                           inpixel_bins.x(),
+                                                           -pitch_x / 2,
+                                                           pitch_x / 2,
+                                                           inpixel_bins.y(),
+                                                           -pitch_y / 2,
+                                                           pitch_y / 2);
 
     std::string cluster_size_y_map_title = "Cluster size in Y as function of in-pixel impact position for " +
                                            detector_->getName() + ";x%pitch [#mum];y%pitch [#mum]";
-    cluster_size_y_map = CreateHistogram<TProfile2D>("cluster_size_y_map",
-                                                     cluster_size_y_map_title.c_str(),
-                                                     inpixel_bins.x(),
-                                                     -pitch_x / 2,
-                                                     pitch_x / 2,
-                                                     inpixel_bins.y(),
-                                                     -pitch_y / 2,
-                                                     pitch_y / 2);
+    cluster_size_y_map = CreateSparseHistogram<TProfile2D>(sparse_threshold,
+                                                           "cluster_size_y_map",
+                                                           cluster_size_y_map_title.c_str(),
+                                                           inpixel_bins.x(),
+                                                           -pitch_x / 2,
+                                                           pitch_x / 2,
+                                                           inpixel_bins.y(),
+                                                           -pitch_y / 2,
+                                                           pitch_y / 2);
 
     // Charge maps:
     std::string cluster_charge_map_title = "Cluster charge as function of in-pixel impact position for " +
                                            detector_->getName() + ";x%pitch [#mum];y%pitch [#mum];<cluster charge> [ke]";
-    cluster_charge_map = CreateHistogram<TProfile2D>("cluster_charge_map",
-                                                     cluster_charge_map_title.c_str(),
-                                                     inpixel_bins.x(),
-                                                     -pitch_x / 2,
-                                                     pitch_x / 2,
-                                                     inpixel_bins.y(),
-                                                     -pitch_y / 2,
-                                                     pitch_y / 2);
+    cluster_charge_map = CreateSparseHistogram<TProfile2D>(sparse_threshold,
+                                                           "cluster_charge_map",
+                                                           cluster_charge_map_title.c_str(),
+                                                           inpixel_bins.x(),
+                                                           -pitch_x / 2,
+                                                           pitch_x / 2,
+                                                           inpixel_bins.y(),
+                                                           -pitch_y / 2,
+                                                           pitch_y / 2);
     std::string seed_charge_map_title = "Seed pixel charge as function of in-pixel impact position for " +
                                         detector_->getName() + ";x%pitch [#mum];y%pitch [#mum];<seed pixel charge> [ke]";
-    seed_charge_map = CreateHistogram<TProfile2D>("seed_charge_map",
-                                                  seed_charge_map_title.c_str(),
-                                                  inpixel_bins.x(),
-                                                  -pitch_x / 2,
-                                                  pitch_x / 2,
-                                                  inpixel_bins.y(),
-                                                  -pitch_y / 2,
-                                                  pitch_y / 2);
+    seed_charge_map = CreateSparseHistogram<TProfile2D>(sparse_threshold,
+                                                        "seed_charge_map",
+                                                        seed_charge_map_title.c_str(),
+                                                        inpixel_bins.x(),
+                                                        -pitch_x / 2,
+                                                        pitch_x / 2,
+                                                        inpixel_bins.y(),
+                                                        -pitch_y / 2,
+                                                        pitch_y / 2);
 
     // Create cluster size plots, preventing a zero-bin histogram by scaling with integer ceiling: (x + y - 1) / y
     std::string cluster_size_title = "Cluster size for " + detector_->getName() + ";cluster size [px];clusters";
-    cluster_size = CreateHistogram<TH1D>(
-        "cluster_size", cluster_size_title.c_str(), (xpixels * ypixels + 9) / 10, 0.5, (xpixels * ypixels + 9) / 10 + 0.5);
+    cluster_size = CreateSparseHistogram<TH1D>(sparse_threshold,
+                                               "cluster_size",
+                                               cluster_size_title.c_str(),
+                                               (xpixels * ypixels + 9) / 10,
+                                               0.5,
+                                               (xpixels * ypixels + 9) / 10 + 0.5);
 
     std::string cluster_size_x_title = "Cluster size X for " + detector_->getName() + ";cluster size x [px];clusters";
     cluster_size_x = CreateHistogram<TH1D>("cluster_size_x", cluster_size_x_title.c_str(), xpixels, 0.5, xpixels + 0.5);
@@ -155,8 +186,8 @@ void DetectorHistogrammerModule::initialize() {
 
     // Create event size plot
     std::string event_size_title = "Event size for " + detector_->getName() + ";event size [px];events";
-    event_size =
-        CreateHistogram<TH1D>("event_size", event_size_title.c_str(), xpixels * ypixels, 0.5, xpixels * ypixels + 0.5);
+    event_size = CreateSparseHistogram<TH1D>(
+        sparse_threshold, "event_size", event_size_title.c_str(), xpixels * ypixels, 0.5, xpixels * ypixels + 0.5);
 
     // Create residual plots
     std::string residual_x_title = "Residual in X for " + detector_->getName() + ";x_{track} - x_{cluster} [#mum];events";
@@ -188,87 +219,101 @@ void DetectorHistogrammerModule::initialize() {
     std::string residual_map_title = "Mean absolute deviation of residual as function of in-pixel impact position for " +
                                      detector_->getName() +
                                      ";x%pitch [#mum];y%pitch [#mum];MAD(#sqrt{#Deltax^{2}+#Deltay^{2}}) [#mum]";
-    residual_map = CreateHistogram<TProfile2D>("residual_map",
-                                               residual_map_title.c_str(),
-                                               inpixel_bins.x(),
-                                               -pitch_x / 2,
-                                               pitch_x / 2,
-                                               inpixel_bins.y(),
-                                               -pitch_y / 2,
-                                               pitch_y / 2);
+    residual_map = CreateSparseHistogram<TProfile2D>(sparse_threshold,
+                                                     "residual_map",
+                                                     residual_map_title.c_str(),
+                                                     inpixel_bins.x(),
+                                                     -pitch_x / 2,
+                                                     pitch_x / 2,
+                                                     inpixel_bins.y(),
+                                                     -pitch_y / 2,
+                                                     pitch_y / 2);
     std::string residual_detector_title = "Mean absolute deviation of residual of " + detector_->getName() +
                                           ";x (pixels);y (pixels);MAD(#sqrt{#Deltax^{2}+#Deltay^{2}}) [#mum]";
-    residual_detector = CreateHistogram<TProfile2D>(
-        "residual_detector", residual_detector_title.c_str(), xpixels, -0.5, xpixels - 0.5, ypixels, -0.5, ypixels - 0.5);
+    residual_detector = CreateSparseHistogram<TProfile2D>(sparse_threshold,
+                                                          "residual_detector",
+                                                          residual_detector_title.c_str(),
+                                                          xpixels,
+                                                          -0.5,
+                                                          xpixels - 0.5,
+                                                          ypixels,
+                                                          -0.5,
+                                                          ypixels - 0.5);
 
     std::string residual_x_map_title =
         "Mean absolute deviation of residual in X as function of in-pixel impact position for " + detector_->getName() +
         ";x%pitch [#mum];y%pitch [#mum];MAD(#Deltax) [#mum]";
-    residual_x_map = CreateHistogram<TProfile2D>("residual_x_map",
-                                                 residual_x_map_title.c_str(),
-                                                 inpixel_bins.x(),
-                                                 -pitch_x / 2,
-                                                 pitch_x / 2,
-                                                 inpixel_bins.y(),
-                                                 -pitch_y / 2,
-                                                 pitch_y / 2);
+    residual_x_map = CreateSparseHistogram<TProfile2D>(sparse_threshold,
+                                                       "residual_x_map",
+                                                       residual_x_map_title.c_str(),
+                                                       inpixel_bins.x(),
+                                                       -pitch_x / 2,
+                                                       pitch_x / 2,
+                                                       inpixel_bins.y(),
+                                                       -pitch_y / 2,
+                                                       pitch_y / 2);
     std::string residual_x_detector_title =
         "Mean absolute deviation of residual in X of " + detector_->getName() + ";x (pixels);y (pixels);MAD(#Deltax) [#mum]";
-    residual_x_detector = CreateHistogram<TProfile2D>("residual_x_detector",
-                                                      residual_x_detector_title.c_str(),
-                                                      xpixels,
-                                                      -0.5,
-                                                      xpixels - 0.5,
-                                                      ypixels,
-                                                      -0.5,
-                                                      ypixels - 0.5);
+    residual_x_detector = CreateSparseHistogram<TProfile2D>(sparse_threshold,
+                                                            "residual_x_detector",
+                                                            residual_x_detector_title.c_str(),
+                                                            xpixels,
+                                                            -0.5,
+                                                            xpixels - 0.5,
+                                                            ypixels,
+                                                            -0.5,
+                                                            ypixels - 0.5);
 
     std::string residual_y_map_title =
         "Mean absolute deviation of residual in Y as function of in-pixel impact position for " + detector_->getName() +
         ";x%pitch [#mum];y%pitch [#mum];MAD(#Deltay) [#mum]";
-    residual_y_map = CreateHistogram<TProfile2D>("residual_y_map",
-                                                 residual_y_map_title.c_str(),
-                                                 inpixel_bins.x(),
-                                                 -pitch_x / 2,
-                                                 pitch_x / 2,
-                                                 inpixel_bins.y(),
-                                                 -pitch_y / 2,
-                                                 pitch_y / 2);
+    residual_y_map = CreateSparseHistogram<TProfile2D>(sparse_threshold,
+                                                       "residual_y_map",
+                                                       residual_y_map_title.c_str(),
+                                                       inpixel_bins.x(),
+                                                       -pitch_x / 2,
+                                                       pitch_x / 2,
+                                                       inpixel_bins.y(),
+                                                       -pitch_y / 2,
+                                                       pitch_y / 2);
     std::string residual_y_detector_title =
         "Mean absolute deviation of residual in Y of " + detector_->getName() + ";x (pixels);y (pixels);MAD(#Deltay) [#mum]";
-    residual_y_detector = CreateHistogram<TProfile2D>("residual_y_detector",
-                                                      residual_y_detector_title.c_str(),
-                                                      xpixels,
-                                                      -0.5,
-                                                      xpixels - 0.5,
-                                                      ypixels,
-                                                      -0.5,
-                                                      ypixels - 0.5);
+    residual_y_detector = CreateSparseHistogram<TProfile2D>(sparse_threshold,
+                                                            "residual_y_detector",
+                                                            residual_y_detector_title.c_str(),
+                                                            xpixels,
+                                                            -0.5,
+                                                            xpixels - 0.5,
+                                                            ypixels,
+                                                            -0.5,
+                                                            ypixels - 0.5);
 
     // Efficiency maps:
     std::string efficiency_map_title = "Efficiency as function of in-pixel impact position for " + detector_->getName() +
                                        ";x%pitch [#mum];y%pitch [#mum];efficiency";
-    efficiency_map = CreateHistogram<TProfile2D>("efficiency_map",
-                                                 efficiency_map_title.c_str(),
-                                                 inpixel_bins.x(),
-                                                 -pitch_x / 2,
-                                                 pitch_x / 2,
-                                                 inpixel_bins.y(),
-                                                 -pitch_y / 2,
-                                                 pitch_y / 2,
-                                                 0,
-                                                 1);
+    efficiency_map = CreateSparseHistogram<TProfile2D>(sparse_threshold,
+                                                       "efficiency_map",
+                                                       efficiency_map_title.c_str(),
+                                                       inpixel_bins.x(),
+                                                       -pitch_x / 2,
+                                                       pitch_x / 2,
+                                                       inpixel_bins.y(),
+                                                       -pitch_y / 2,
+                                                       pitch_y / 2,
+                                                       0,
+                                                       1);
     std::string efficiency_detector_title = "Efficiency of " + detector_->getName() + ";x (pixels);y (pixels);efficiency";
-    efficiency_detector = CreateHistogram<TProfile2D>("efficiency_detector",
-                                                      efficiency_detector_title.c_str(),
-                                                      xpixels,
-                                                      -0.5,
-                                                      xpixels - 0.5,
-                                                      ypixels,
-                                                      -0.5,
-                                                      ypixels - 0.5,
-                                                      0,
-                                                      1);
+    efficiency_detector = CreateSparseHistogram<TProfile2D>(sparse_threshold,
+                                                            "efficiency_detector",
+                                                            efficiency_detector_title.c_str(),
+                                                            xpixels,
+                                                            -0.5,
+                                                            xpixels - 0.5,
+                                                            ypixels,
+                                                            -0.5,
+                                                            ypixels - 0.5,
+                                                            0,
+                                                            1);
     // Efficiency projections
     std::string efficiency_vs_x_title =
         "Efficiency as function of in-pixel X position for " + detector_->getName() + ";x%pitch [#mum];efficiency";
@@ -281,7 +326,8 @@ void DetectorHistogrammerModule::initialize() {
 
     // Create number of clusters plot
     std::string n_cluster_title = "Number of clusters for " + detector_->getName() + ";clusters;events";
-    n_cluster = CreateHistogram<TH1D>("n_cluster", n_cluster_title.c_str(), xpixels * ypixels, 0.5, xpixels * ypixels + 0.5);
+    n_cluster = CreateSparseHistogram<TH1D>(
+        sparse_threshold, "n_cluster", n_cluster_title.c_str(), xpixels * ypixels, 0.5, xpixels * ypixels + 0.5);
 
     // Create cluster charge plot
     auto max_cluster_charge = Units::convert(config_.get<double>("max_cluster_charge"), "ke");
@@ -319,8 +365,8 @@ void DetectorHistogrammerModule::run(Event* event) {
 
             // Add pixel
             hit_map->Fill(pixel_idx.x(), pixel_idx.y());
-            charge_map->Fill(pixel_idx.x(), pixel_idx.y(), static_cast<double>(Units::convert(pixel_hit.getSignal(), "ke")));
-            pixel_charge->Fill(static_cast<double>(Units::convert(pixel_hit.getSignal(), "ke")));
+            charge_map->Fill(pixel_idx.x(), pixel_idx.y(), pixel_hit.getSignal() / units::ke);
+            pixel_charge->Fill(pixel_hit.getSignal() / units::ke);
 
             // Update statistics
             total_hits_ += 1;
@@ -342,6 +388,15 @@ void DetectorHistogrammerModule::run(Event* event) {
     auto primary_particles = getPrimaryParticles(mcparticle_message);
     LOG(DEBUG) << "Found " << primary_particles.size() << " primary particles in this event";
 
+    // Index the cluster positions in a grid with cells of the size of the matching cut, such that a particle only has to be
+    // compared to the clusters in its own and the neighbouring cells
+    auto grid_cell = [this](const XYZPoint& position) {
+        return std::make_pair(static_cast<long>(std::floor(position.x() / matching_cut_.x())),
+                              static_cast<long>(std::floor(position.y() / matching_cut_.y())));
+    };
+    bool matching_enabled = (matching_cut_.x() > 0 && matching_cut_.y() > 0);
+    std::map<std::pair<long, long>, std::vector<XYZPoint>> cluster_grid;
+
     // Evaluate the clusters
     double charge_sum = 0;
     for(const auto& clus : clusters) {
@@ -356,19 +411,23 @@ void DetectorHistogrammerModule::run(Event* event) {
         LOG(DEBUG) << "Cluster at indices " << cluster_x << ", " << cluster_y << "(" << clusterPos
                    << " local coordinates) with charge " << Units::display(clus.getCharge(), "ke");
         cluster_map->Fill(cluster_x, cluster_y);
-        cluster_charge->Fill(static_cast<double>(Units::convert(clus.getCharge(), "ke")));
+        cluster_charge->Fill(clus.getCharge() / units::ke);
         charge_sum += clus.getCharge();
+        if(matching_enabled) {
+            cluster_grid[grid_cell(clusterPos)].push_back(clusterPos);
+        }
 
-        auto cluster_particles = clus.getMCParticles();
+        const auto& cluster_particles = clus.getMCParticles();
         LOG(DEBUG) << "This cluster is connected to " << cluster_particles.size() << " MC particles";
 
-        // Find all particles connected to this cluster which are also primaries:
+        // Find all particles connected to this cluster which are also primaries, both lists are sorted by address:
         std::vector<const MCParticle*> intersection;
-        std::set_intersection(primary_particles.begin(),
-                              primary_particles.end(),
-                              cluster_particles.begin(),
-                              cluster_particles.end(),
-                              std::back_inserter(intersection));
+        std::copy_if(cluster_particles.begin(),
+                     cluster_particles.end(),
+                     std::back_inserter(intersection),
+                     [&primary_particles](const MCParticle* particle) {
+                         return std::binary_search(primary_particles.begin(), primary_particles.end(), particle);
+                     });
 
         LOG(TRACE) << "Matching primaries: " << intersection.size();
         for(const auto& particle : intersection) {
@@ -380,8 +439,8 @@ void DetectorHistogrammerModule::run(Event* event) {
 
             auto inPixelPos = particlePos - detector_->getModel()->getPixelCenter(static_cast<unsigned int>(xpixel),
                                                                                   static_cast<unsigned int>(ypixel));
-            auto inPixel_um_x = static_cast<double>(Units::convert(inPixelPos.x(), "um"));
-            auto inPixel_um_y = static_cast<double>(Units::convert(inPixelPos.y(), "um"));
+            auto inPixel_um_x = inPixelPos.x() / units::um;
+            auto inPixel_um_y = inPixelPos.y() / units::um;
 
             cluster_size_map->Fill(inPixel_um_x, inPixel_um_y, static_cast<double>(clus.getSize()));
             cluster_size_x_map->Fill(inPixel_um_x, inPixel_um_y, clusSizesXY.first);
@@ -389,17 +448,17 @@ void DetectorHistogrammerModule::run(Event* event) {
 
             // Charge maps:
             cluster_charge_map->Fill(
-                inPixel_um_x, inPixel_um_y, static_cast<double>(Units::convert(clus.getCharge(), "ke")));
+                inPixel_um_x, inPixel_um_y, clus.getCharge() / units::ke);
 
             // Retrieve the seed pixel:
             const auto* seed_pixel = clus.getSeedPixelHit();
             seed_charge_map->Fill(
-                inPixel_um_x, inPixel_um_y, static_cast<double>(Units::convert(seed_pixel->getSignal(), "ke")));
-            cluster_seed_charge->Fill(static_cast<double>(Units::convert(seed_pixel->getSignal(), "ke")));
+                inPixel_um_x, inPixel_um_y, seed_pixel->getSignal() / units::ke);
+            cluster_seed_charge->Fill(seed_pixel->getSignal() / units::ke);
 
             // Calculate residual with cluster position:
-            auto residual_um_x = static_cast<double>(Units::convert(particlePos.x() - clusterPos.x(), "um"));
-            auto residual_um_y = static_cast<double>(Units::convert(particlePos.y() - clusterPos.y(), "um"));
+            auto residual_um_x = (particlePos.x() - clusterPos.x()) / units::um;
+            auto residual_um_y = (particlePos.y() - clusterPos.y()) / units::um;
             residual_x->Fill(residual_um_x);
             residual_y->Fill(residual_um_y);
             residual_x_vs_x->Fill(inPixel_um_x, std::fabs(residual_um_x));
@@ -418,7 +477,7 @@ void DetectorHistogrammerModule::run(Event* event) {
     }
 
     // Store total charge in event:
-    total_charge->Fill(static_cast<double>(Units::convert(charge_sum, "ke")));
+    total_charge->Fill(charge_sum / units::ke);
 
     // Calculate efficiency: search for matching clusters for all primary MCParticles
     for(auto& particle : primary_particles) {
@@ -430,16 +489,26 @@ void DetectorHistogrammerModule::run(Event* event) {
 
         auto inPixelPos = particlePos - detector_->getModel()->getPixelCenter(static_cast<unsigned int>(xpixel),
                                                                               static_cast<unsigned int>(ypixel));
-        auto inPixel_um_x = static_cast<double>(Units::convert(inPixelPos.x(), "um"));
-        auto inPixel_um_y = static_cast<double>(Units::convert(inPixelPos.y(), "um"));
-
-        auto matched_cluster = std::find_if(clusters.begin(), clusters.end(), [this, &particlePos](const Cluster& clus) {
-            return (std::fabs(clus.getPosition().x() - particlePos.x()) < matching_cut_.x()) &&
-                   (std::fabs(clus.getPosition().y() - particlePos.y()) < matching_cut_.y());
-        });
-
-        // Do we have a match?
-        bool matched = matched_cluster != clusters.end();
+        auto inPixel_um_x = inPixelPos.x() / units::um;
+        auto inPixel_um_y = inPixelPos.y() / units::um;
+
+        // Search for a matching cluster in the neighbouring cells of the grid
+        bool matched = false;
+        if(matching_enabled) {
+            auto [cell_x, cell_y] = grid_cell(particlePos);
+            for(auto x = cell_x - 1; x <= cell_x + 1 && !matched; ++x) {
+                for(auto y = cell_y - 1; y <= cell_y + 1 && !matched; ++y) {
+                    auto cell = cluster_grid.find({x, y});
+                    if(cell == cluster_grid.end()) {
+                        continue;
+                    }
+                    matched = std::any_of(cell->second.begin(), cell->second.end(), [&](const XYZPoint& position) {
+                        return (std::fabs(position.x() - particlePos.x()) < matching_cut_.x()) &&
+                               (std::fabs(position.y() - particlePos.y()) < matching_cut_.y());
+                    });
+                }
+            }
+        }
         LOG(DEBUG) << "Particle at " << Units::display(particlePos, {"mm", "um"})
                    << (matched ? " has a matching cluster" : " has no matching cluster");
 
@@ -616,52 +685,28 @@ void DetectorHistogrammerModule::finalize() {
  * @brief Perform a sparse clustering on the PixelHits
  */
 std::vector<Cluster> DetectorHistogrammerModule::doClustering(std::shared_ptr<PixelHitMessage>& pixels_message) {
-    std::vector<Cluster> clusters;
-    std::map<const PixelHit*, bool> usedPixel;
-
-    auto pixel_it = pixels_message->getData().begin();
-    for(; pixel_it != pixels_message->getData().end(); pixel_it++) {
-        const PixelHit* pixel_hit = &(*pixel_it);
+    const auto& pixel_hits = pixels_message->getData();
 
-        // Check if the pixel has been used:
-        if(usedPixel[pixel_hit]) {
-            continue;
-        }
-
-        // Create new cluster
-        Cluster cluster(pixel_hit);
-        usedPixel[pixel_hit] = true;
-        LOG(TRACE) << "Creating new cluster with seed: " << pixel_hit->getPixel().getIndex();
-
-        auto touching = [&](const PixelHit* pixel) {
-            auto pxi1 = pixel->getIndex();
-            for(const auto& cluster_pixel : cluster.getPixelHits()) {
-
-                auto distance = [](unsigned int lhs, unsigned int rhs) { return (lhs > rhs ? lhs - rhs : rhs - lhs); };
-
-                auto pxi2 = cluster_pixel->getIndex();
-                if(distance(pxi1.x(), pxi2.x()) <= 1 && distance(pxi1.y(), pxi2.y()) <= 1) {
-                    return true;
-                }
-            }
-            return false;
-        };
+    std::vector<Pixel::Index> indices;
+    indices.reserve(pixel_hits.size());
+    for(const auto& pixel_hit : pixel_hits) {
+        indices.push_back(pixel_hit.getIndex());
+    }
 
-        // Keep adding pixels to the cluster:
-        for(auto other_pixel = pixel_it + 1; other_pixel != pixels_message->getData().end(); other_pixel++) {
-            const PixelHit* neighbor = &(*other_pixel);
+    auto pixel_clusters = cluster_pixels(indices);
 
-            // Check if neighbor has been used or if it touches the current cluster:
-            if(usedPixel[neighbor] || !touching(neighbor)) {
-                continue;
-            }
-
-            cluster.addPixelHit(neighbor);
-            LOG(TRACE) << "Adding pixel: " << neighbor->getPixel().getIndex();
-            usedPixel[neighbor] = true;
-            other_pixel = pixel_it;
+    std::vector<Cluster> clusters;
+    clusters.reserve(pixel_clusters.size());
+    for(size_t i = 0; i < pixel_clusters.size(); ++i) {
+        auto [first, last] = pixel_clusters.get(i);
+        std::vector<const PixelHit*> cluster_hits;
+        cluster_hits.reserve(static_cast<size_t>(last - first));
+        for(const auto* pixel = first; pixel != last; ++pixel) {
+            cluster_hits.push_back(&pixel_hits[*pixel]);
         }
-        clusters.push_back(cluster);
+        LOG(TRACE) << "Creating new cluster with seed " << cluster_hits.front()->getPixel().getIndex() << " and "
+                   << cluster_hits.size() << " pixels";
+        clusters.emplace_back(std::move(cluster_hits));
     }
     return clusters;
 }
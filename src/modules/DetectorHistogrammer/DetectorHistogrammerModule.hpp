@@ -29,6 +29,7 @@
 #include "Cluster.hpp"
 #include "objects/PixelHit.hpp"
 #include "tools/ROOT.h"
+#include "tools/sparse_histogram.h"
 
 namespace allpix {
     /**
@@ -70,7 +71,8 @@ namespace allpix {
 
         /**
          * @brief analyze the available MCParticles and return the all particles identified as primary (i.e. that do not have
-         * a parent). This might be several particles.
+         * a parent). This might be several particles. The particles are returned in the order of the message, i.e. sorted by
+         * their address.
          */
         static std::vector<const MCParticle*> getPrimaryParticles(std::shared_ptr<MCParticleMessage>& mcparticle_message);
 
@@ -87,19 +89,20 @@ namespace allpix {
         // Reference track resolution
         ROOT::Math::XYVector track_resolution_{};
 
-        // Histograms to output
-        Histogram<TH2D> hit_map, charge_map, cluster_map;
-        Histogram<TProfile2D> cluster_size_map, cluster_size_x_map, cluster_size_y_map;
-        Histogram<TProfile2D> cluster_charge_map, seed_charge_map;
-        Histogram<TProfile2D> residual_map, residual_x_map, residual_y_map, residual_detector, residual_x_detector,
+        // Histograms to output, the ones scaling with the pixel matrix or in-pixel granularity are stored sparsely
+        SparseHistogram<TH2D> hit_map, charge_map, cluster_map;
+        SparseHistogram<TProfile2D> cluster_size_map, cluster_size_x_map, cluster_size_y_map;
+        SparseHistogram<TProfile2D> cluster_charge_map, seed_charge_map;
+        SparseHistogram<TProfile2D> residual_map, residual_x_map, residual_y_map, residual_detector, residual_x_detector,
             residual_y_detector;
         Histogram<TH1D> residual_x, residual_y;
         Histogram<TProfile> residual_x_vs_x, residual_y_vs_y, residual_x_vs_y, residual_y_vs_x;
-        Histogram<TProfile2D> efficiency_map, efficiency_detector;
+        SparseHistogram<TProfile2D> efficiency_map, efficiency_detector;
         Histogram<TProfile> efficiency_vs_x, efficiency_vs_y;
-        Histogram<TH1D> event_size;
-        Histogram<TH1D> cluster_size, cluster_size_x, cluster_size_y;
-        Histogram<TH1D> n_cluster;
+        SparseHistogram<TH1D> event_size;
+        SparseHistogram<TH1D> cluster_size;
+        Histogram<TH1D> cluster_size_x, cluster_size_y;
+        SparseHistogram<TH1D> n_cluster;
         Histogram<TH1D> cluster_charge, pixel_charge, total_charge, cluster_seed_charge;
     };
 } // namespace allpix
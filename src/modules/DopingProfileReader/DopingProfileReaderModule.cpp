@@ -9,8 +9,13 @@
 
 #include "DopingProfileReaderModule.hpp"
 
+#include <array>
+#include <cmath>
+#include <limits>
+#include <map>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "core/utils/log.h"
 
@@ -20,6 +25,9 @@ DopingProfileReaderModule::DopingProfileReaderModule(Configuration& config, Mess
     : Module(config, detector), detector_(std::move(detector)) {
     // Enable multithreading of this module if multithreading is enabled
     allow_multithreading();
+
+    // Reading the doping profile can run concurrently with other modules
+    allow_parallel_initialization();
 }
 
 void DopingProfileReaderModule::initialize() {
@@ -56,9 +64,29 @@ void DopingProfileReaderModule::initialize() {
         LOG(DEBUG) << "Doping concentration map starts with offset " << offset << " to pixel boundary";
         std::array<double, 2> field_offset{{offset.x(), offset.y()}};
 
-        auto field_data = read_field(field_scale);
-        detector_->setDopingProfileGrid(
-            field_data.getData(), field_data.getDimensions(), field_scale, field_offset, thickness_domain);
+        // Get the precision the doping map is stored with, defaults to double precision:
+        auto precision = config_.get<FieldPrecision>("field_precision", FieldPrecision::DOUBLE);
+        if(precision == FieldPrecision::SINGLE) {
+            LOG(DEBUG) << "Doping concentration map will be stored in single precision";
+        }
+
+        // Get the mirror symmetry of the doping map within the field cell, defaults to a mesh covering the full cell:
+        auto symmetry = config_.get<FieldSymmetry>("field_symmetry", FieldSymmetry::NONE);
+        if(symmetry != FieldSymmetry::NONE) {
+            LOG(DEBUG) << "Doping concentration map will be stored for the part with positive coordinates along mirrored "
+                          "axes only";
+        }
+
+        auto field_data = read_field(field_scale, symmetry);
+        detector_->setDopingProfileGrid(field_data.getRawData(),
+                                        field_data.getEntries(),
+                                        field_data.getDimensions(),
+                                        field_scale,
+                                        field_offset,
+                                        thickness_domain,
+                                        precision,
+                                        symmetry,
+                                        field_data.getZEdges());
 
     } else if(field_model == DopingProfile::CONSTANT) {
         LOG(TRACE) << "Adding constant doping concentration";
@@ -66,9 +94,9 @@ void DopingProfileReaderModule::initialize() {
 
         auto concentration = config_.get<double>("doping_concentration");
         LOG(INFO) << "Set constant doping concentration of " << Units::display(concentration, {"/cm/cm/cm"});
-        FieldFunction<double> function = [concentration](const ROOT::Math::XYZPoint&) noexcept { return concentration; };
 
-        detector_->setDopingProfileFunction(function, type);
+        // A single region spanning the full sensor is returned directly by the lookup
+        detector_->setDopingProfileTable({std::numeric_limits<double>::max()}, {concentration}, type);
     } else if(field_model == DopingProfile::REGIONS) {
         LOG(TRACE) << "Adding doping concentration depending on sensor region";
         type = FieldType::CUSTOM;
@@ -85,19 +113,19 @@ void DopingProfileReaderModule::initialize() {
             LOG(INFO) << "Set constant doping concentration of " << Units::display(region.back(), {"/cm/cm/cm"})
                       << " at sensor depth " << Units::display(region.front(), {"um", "mm"});
         }
-        FieldFunction<double> function = [concentration_map, thickness = detector_->getModel()->getSensorSize().z()](
-                                             const ROOT::Math::XYZPoint& position) {
-            // Lower bound returns the first element that is *not less* than the given key - in this case, the z position
-            // should always be *before* the region boundary set in the vector
-            auto item = concentration_map.lower_bound(thickness / 2 - position.z());
-            if(item != concentration_map.end()) {
-                return item->second;
-            } else {
-                return concentration_map.rbegin()->second;
-            }
-        };
 
-        detector_->setDopingProfileFunction(function, type);
+        if(concentration_map.empty()) {
+            throw InvalidValueError(config_, "doping_concentration", "expecting at least one region");
+        }
+
+        // Flatten the regions into a depth table, searched directly by the doping profile lookup
+        std::vector<double> depths;
+        std::vector<double> concentrations;
+        for(const auto& [depth, region_concentration] : concentration_map) {
+            depths.push_back(depth);
+            concentrations.push_back(region_concentration);
+        }
+        detector_->setDopingProfileTable(std::move(depths), std::move(concentrations), type);
     }
 }
 
@@ -105,19 +133,43 @@ void DopingProfileReaderModule::initialize() {
  * The field read from the INIT format are shared between module instantiations using the static FieldParser.
  */
 FieldParser<double> DopingProfileReaderModule::field_parser_(FieldQuantity::SCALAR);
-FieldData<double> DopingProfileReaderModule::read_field(std::array<double, 2> field_scale) {
+FieldData<double> DopingProfileReaderModule::read_field(std::array<double, 2> field_scale, FieldSymmetry symmetry) {
 
     try {
         LOG(TRACE) << "Fetching doping concentration map from mesh file";
 
         // Get field from file
-        auto field_data = field_parser_.getByFileName(config_.getPath("file_name", true), "/cm/cm/cm");
+        auto field_data = field_parser_.getByFileName(
+            config_.getPath("file_name", true), "/cm/cm/cm", config_.get<bool>("shared_memory", false));
+
+        // Reduce maps covering the full field cell along mirrored axes to the part with positive coordinates
+        auto size = field_data.getSize();
+        auto pitch = detector_->getModel()->getPixelSize();
+        std::array<double, 2> extent{{field_scale[0] * pitch.x(), field_scale[1] * pitch.y()}};
+        std::array<bool, 2> mirrored{{symmetry == FieldSymmetry::MIRROR_X || symmetry == FieldSymmetry::MIRROR_XY,
+                                      symmetry == FieldSymmetry::MIRROR_Y || symmetry == FieldSymmetry::MIRROR_XY}};
+        std::array<bool, 2> reduce{};
+        for(size_t axis = 0; axis < 2; ++axis) {
+            reduce[axis] =
+                mirrored[axis] && std::fabs(size[axis] - extent[axis]) < std::fabs(size[axis] - extent[axis] / 2);
+        }
+        if(reduce[0] || reduce[1]) {
+            LOG(DEBUG) << "Verifying the symmetry of the doping concentration map covering the full field cell";
+            field_data = reduce_mirrored_field(field_data, reduce, config_.get<double>("field_symmetry_tolerance", 0.01));
+        }
 
-        // Check if electric field matches chip
-        check_detector_match(field_data.getSize(), field_scale);
+        // Check if doping concentration map matches chip, mirrored maps cover half of the field cell
+        size = field_data.getSize();
+        for(size_t axis = 0; axis < 2; ++axis) {
+            size[axis] *= (mirrored[axis] ? 2. : 1.);
+        }
+        check_detector_match(size, field_scale);
 
         LOG(INFO) << "Set doping concentration map with " << field_data.getDimensions().at(0) << "x"
                   << field_data.getDimensions().at(1) << "x" << field_data.getDimensions().at(2) << " cells";
+        if(!field_data.getZEdges().empty()) {
+            LOG(DEBUG) << "Doping concentration map uses non-uniform binning in z";
+        }
 
         // Return the field data
         return field_data;
@@ -52,8 +52,9 @@ namespace allpix {
         /**
          * @brief Read field in the init format and apply it
          * @param field_scale Scaling parameters for the field size in x and y
+         * @param symmetry Mirror symmetry of the doping profile, maps covering the full field cell are reduced accordingly
          */
-        FieldData<double> read_field(std::array<double, 2> field_scale);
+        FieldData<double> read_field(std::array<double, 2> field_scale, FieldSymmetry symmetry);
         static FieldParser<double> field_parser_;
 
         /**
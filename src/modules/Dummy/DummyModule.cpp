@@ -38,7 +38,7 @@ void DummyModule::run(Event* event) {
     auto messages = messenger_->fetchMultiMessage<PixelHitMessage>(this, event);
     // ... Implement ... (Typically uses the configuration to execute function and outputs an message)
     // Loop through all received messages and print some information
-    for(auto& message : messages) {
+    for(const auto& message : messages) {
         std::string detectorName = message->getDetector()->getName();
         LOG(DEBUG) << "Picked up " << message->getData().size() << " objects from detector " << detectorName;
     }
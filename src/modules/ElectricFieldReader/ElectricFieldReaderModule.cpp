@@ -9,6 +9,9 @@
 
 #include "ElectricFieldReaderModule.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <fstream>
 #include <limits>
 #include <memory>
@@ -16,6 +19,7 @@
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <Math/Vector3D.h>
 #include <TF3.h>
@@ -35,6 +39,11 @@ ElectricFieldReaderModule::ElectricFieldReaderModule(Configuration& config, Mess
 
     // NOTE use voltage as a synonym for bias voltage
     config_.setAlias("bias_voltage", "voltage");
+
+    // Reading the field can run concurrently with other modules unless plots are written or functions are compiled
+    if(!config_.get<bool>("output_plots", false) && config_.get<ElectricField>("model") != ElectricField::CUSTOM) {
+        allow_parallel_initialization();
+    }
 }
 
 void ElectricFieldReaderModule::initialize() {
@@ -84,10 +93,36 @@ void ElectricFieldReaderModule::initialize() {
         LOG(DEBUG) << "Electric field starts with offset " << offset << " to pixel boundary";
         std::array<double, 2> field_offset{{model->getPixelSize().x() * offset.x(), model->getPixelSize().y() * offset.y()}};
 
-        auto field_data = read_field(thickness_domain, field_scale);
+        // Get the method to look up the field from the grid, defaults to the value of the nearest bin:
+        auto interpolation = config_.get<FieldInterpolation>("field_interpolation", FieldInterpolation::NEAREST);
+        if(interpolation == FieldInterpolation::LINEAR) {
+            LOG(DEBUG) << "Electric field will be interpolated trilinearly between the grid bins";
+        }
+
+        // Get the precision the field grid is stored with, defaults to double precision:
+        auto precision = config_.get<FieldPrecision>("field_precision", FieldPrecision::DOUBLE);
+        if(precision == FieldPrecision::SINGLE) {
+            LOG(DEBUG) << "Electric field will be stored in single precision";
+        }
+
+        // Get the mirror symmetry of the field within the field cell, defaults to a mesh covering the full cell:
+        auto symmetry = config_.get<FieldSymmetry>("field_symmetry", FieldSymmetry::NONE);
+        if(symmetry != FieldSymmetry::NONE) {
+            LOG(DEBUG) << "Electric field will be stored for the part with positive coordinates along mirrored axes only";
+        }
 
-        detector_->setElectricFieldGrid(
-            field_data.getData(), field_data.getDimensions(), field_scale, field_offset, thickness_domain);
+        auto field_data = read_field(thickness_domain, field_scale, symmetry);
+
+        detector_->setElectricFieldGrid(field_data.getRawData(),
+                                        field_data.getEntries(),
+                                        field_data.getDimensions(),
+                                        field_scale,
+                                        field_offset,
+                                        thickness_domain,
+                                        interpolation,
+                                        precision,
+                                        symmetry,
+                                        field_data.getZEdges());
     } else if(field_model == ElectricField::CONSTANT) {
         LOG(TRACE) << "Adding constant electric field";
         auto field_z = config_.get<double>("bias_voltage") / getDetector()->getModel()->getSensorSize().z();
@@ -116,8 +151,12 @@ void ElectricFieldReaderModule::initialize() {
             get_parabolic_field_function(thickness_domain), thickness_domain, FieldType::CUSTOM);
     } else if(field_model == ElectricField::CUSTOM) {
         LOG(TRACE) << "Adding custom electric field";
-        detector_->setElectricFieldFunction(
-            get_custom_field_function(thickness_domain), thickness_domain, FieldType::CUSTOM);
+        auto function = get_custom_field_function(thickness_domain);
+        if(config_.get<bool>("tabulate_field", false)) {
+            tabulate_field(function, thickness_domain);
+        } else {
+            detector_->setElectricFieldFunction(function, thickness_domain, FieldType::CUSTOM);
+        }
     }
 
     // Produce histograms if needed
@@ -285,25 +324,122 @@ ElectricFieldReaderModule::get_custom_field_function(std::pair<double, double> t
     }
 }
 
+/**
+ * The field functions are evaluated at the bin centers of a grid covering a single pixel cell and the thickness domain, which
+ * is the region the functions are evaluated in without tabulation. The deviation from the functions is estimated at the
+ * upper corners of a subset of the grid bins, where the distance to the neighboring bin centers is largest.
+ */
+void ElectricFieldReaderModule::tabulate_field(const FieldFunction<ROOT::Math::XYZVector>& function,
+                                               std::pair<double, double> thickness_domain) {
+    auto model = detector_->getModel();
+    auto bins = config_.getArray<size_t>("tabulation_bins", {100, 100, 100});
+    if(bins.size() != 3 || std::find(bins.begin(), bins.end(), 0) != bins.end()) {
+        throw InvalidValueError(config_, "tabulation_bins", "three positive numbers of bins in x, y and z are required");
+    }
+    std::array<size_t, 3> dimensions = {{bins[0], bins[1], bins[2]}};
+    std::array<double, 3> size = {
+        {model->getPixelSize().x(), model->getPixelSize().y(), thickness_domain.second - thickness_domain.first}};
+    std::array<double, 3> origin = {{-size[0] / 2.0, -size[1] / 2.0, thickness_domain.first}};
+
+    LOG(INFO) << "Tabulating custom electric field on " << dimensions[0] << "x" << dimensions[1] << "x" << dimensions[2]
+              << " cells";
+    auto field = std::make_shared<std::vector<double>>(dimensions[0] * dimensions[1] * dimensions[2] * 3);
+    auto center = [&](size_t axis, double bin) {
+        return origin[axis] + (bin + 0.5) * size[axis] / static_cast<double>(dimensions[axis]);
+    };
+    for(size_t x = 0; x < dimensions[0]; ++x) {
+        LOG_PROGRESS(INFO, "tabulation") << "Tabulating custom electric field: " << 100 * x / dimensions[0] << "%";
+        for(size_t y = 0; y < dimensions[1]; ++y) {
+            for(size_t z = 0; z < dimensions[2]; ++z) {
+                auto value = function(ROOT::Math::XYZPoint(center(0, static_cast<double>(x)),
+                                                           center(1, static_cast<double>(y)),
+                                                           center(2, static_cast<double>(z))));
+                auto index = ((x * dimensions[1] + y) * dimensions[2] + z) * 3;
+                (*field)[index] = value.x();
+                (*field)[index + 1] = value.y();
+                (*field)[index + 2] = value.z();
+            }
+        }
+    }
+    LOG_PROGRESS(INFO, "tabulation") << "Tabulating custom electric field: done";
+
+    auto interpolation = config_.get<FieldInterpolation>("field_interpolation", FieldInterpolation::NEAREST);
+    auto precision = config_.get<FieldPrecision>("field_precision", FieldPrecision::DOUBLE);
+    auto entries = field->size();
+    detector_->setElectricFieldGrid(std::shared_ptr<const double>(field, field->data()),
+                                    entries,
+                                    dimensions,
+                                    std::array<double, 2>{{1, 1}},
+                                    std::array<double, 2>{{0, 0}},
+                                    thickness_domain,
+                                    interpolation,
+                                    precision);
+
+    // Compare the tabulated with the analytic field within the pixel cell. The outermost bins are probed at their centers,
+    // since the upper edges of the cell belong to the neighboring field replica or are outside of the grid along z
+    auto probe = [&](size_t axis, size_t bin) {
+        return center(axis, std::min(static_cast<double>(bin) + 0.5, static_cast<double>(dimensions[axis] - 1)));
+    };
+    double max_deviation = 0;
+    std::array<size_t, 3> strides{};
+    for(size_t axis = 0; axis < 3; ++axis) {
+        strides[axis] = std::max<size_t>(1, dimensions[axis] / 20);
+    }
+    for(size_t x = 0; x < dimensions[0]; x += strides[0]) {
+        for(size_t y = 0; y < dimensions[1]; y += strides[1]) {
+            for(size_t z = 0; z < dimensions[2]; z += strides[2]) {
+                ROOT::Math::XYZPoint pos(probe(0, x), probe(1, y), probe(2, z));
+                auto deviation = detector_->getElectricField(pos) - function(pos);
+                max_deviation = std::max(max_deviation, std::sqrt(deviation.Mag2()));
+            }
+        }
+    }
+    LOG(INFO) << "Maximum deviation of the tabulated from the custom electric field: "
+              << Units::display(max_deviation, "V/cm");
+}
+
 /**
  * The field data read from files are shared between module instantiations using the static
  * FieldParser's getByFileName method.
  */
 FieldParser<double> ElectricFieldReaderModule::field_parser_(FieldQuantity::VECTOR);
 FieldData<double> ElectricFieldReaderModule::read_field(std::pair<double, double> thickness_domain,
-                                                        std::array<double, 2> field_scale) {
+                                                        std::array<double, 2> field_scale,
+                                                        FieldSymmetry symmetry) {
 
     try {
         LOG(TRACE) << "Fetching electric field from mesh file";
 
         // Get field from file
-        auto field_data = field_parser_.getByFileName(config_.getPath("file_name", true), "V/cm");
+        auto field_data = field_parser_.getByFileName(
+            config_.getPath("file_name", true), "V/cm", config_.get<bool>("shared_memory", false));
+
+        // Reduce meshes covering the full field cell along mirrored axes to the part with positive coordinates
+        auto size = field_data.getSize();
+        auto pitch = detector_->getModel()->getPixelSize();
+        std::array<double, 2> extent{{field_scale[0] * pitch.x(), field_scale[1] * pitch.y()}};
+        std::array<bool, 2> mirrored{{symmetry == FieldSymmetry::MIRROR_X || symmetry == FieldSymmetry::MIRROR_XY,
+                                      symmetry == FieldSymmetry::MIRROR_Y || symmetry == FieldSymmetry::MIRROR_XY}};
+        std::array<bool, 2> reduce{};
+        for(size_t axis = 0; axis < 2; ++axis) {
+            reduce[axis] =
+                mirrored[axis] && std::fabs(size[axis] - extent[axis]) < std::fabs(size[axis] - extent[axis] / 2);
+        }
+        if(reduce[0] || reduce[1]) {
+            LOG(DEBUG) << "Verifying the symmetry of the electric field mesh covering the full field cell";
+            field_data = reduce_mirrored_field(field_data, reduce, config_.get<double>("field_symmetry_tolerance", 0.01));
+        }
 
-        // Check if electric field matches chip
-        check_detector_match(field_data.getSize(), thickness_domain, field_scale);
+        // Check if electric field matches chip, mirrored meshes cover half of the field cell
+        size = field_data.getSize();
+        for(size_t axis = 0; axis < 2; ++axis) {
+            size[axis] *= (mirrored[axis] ? 2. : 1.);
+        }
+        check_detector_match(size, thickness_domain, field_scale);
 
         // Warn at field values larger than 1MV/cm / 10 MV/mm. Simple lookup per vector component, not total field magnitude
-        auto max_field = *std::max_element(std::begin(*field_data.getData()), std::end(*field_data.getData()));
+        const auto* data = field_data.getRawData().get();
+        auto max_field = *std::max_element(data, data + field_data.getEntries());
         if(max_field > 10) {
             LOG(WARNING) << "Very high electric field of " << Units::display(max_field, "kV/cm")
                          << ", this is most likely not desired.";
@@ -311,6 +447,9 @@ FieldData<double> ElectricFieldReaderModule::read_field(std::pair<double, double
 
         LOG(INFO) << "Set electric field with " << field_data.getDimensions().at(0) << "x"
                   << field_data.getDimensions().at(1) << "x" << field_data.getDimensions().at(2) << " cells";
+        if(!field_data.getZEdges().empty()) {
+            LOG(DEBUG) << "Electric field uses non-uniform binning in z";
+        }
 
         // Return the field data
         return field_data;
@@ -77,12 +77,23 @@ namespace allpix {
          */
         FieldFunction<ROOT::Math::XYZVector> get_custom_field_function(std::pair<double, double> thickness_domain);
 
+        /**
+         * @brief Tabulate a field function on a grid and apply the grid instead of the function
+         * @param function Field function to tabulate
+         * @param thickness_domain Domain of the thickness where the field is defined
+         */
+        void tabulate_field(const FieldFunction<ROOT::Math::XYZVector>& function,
+                            std::pair<double, double> thickness_domain);
+
         /**
          * @brief Read field from a file in init or apf format and apply it
          * @param thickness_domain Domain of the thickness where the field is defined
          * @param field_scale Scaling parameters for the field size in x and y
+         * @param symmetry Mirror symmetry of the field, meshes covering the full field cell are reduced accordingly
          */
-        FieldData<double> read_field(std::pair<double, double> thickness_domain, std::array<double, 2> field_scale);
+        FieldData<double> read_field(std::pair<double, double> thickness_domain,
+                                     std::array<double, 2> field_scale,
+                                     FieldSymmetry symmetry);
         static FieldParser<double> field_parser_;
 
         /**
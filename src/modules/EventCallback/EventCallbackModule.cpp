@@ -0,0 +1,141 @@
+/**
+ * @file
+ * @brief Implementation of the module passing the data of every event to a callback registered by the application
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "EventCallbackModule.hpp"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/utils/log.h"
+#include "tools/event_records.h"
+
+#include "objects/DepositedCharge.hpp"
+#include "objects/PixelCharge.hpp"
+#include "objects/PixelHit.hpp"
+
+using namespace allpix;
+
+namespace {
+    event_records::PixelHit make_record(const PixelHit& hit) {
+        auto index = hit.getIndex();
+        return {hit.getLocalTime(),
+                hit.getGlobalTime(),
+                hit.getSignal(),
+                static_cast<std::uint32_t>(index.x()),
+                static_cast<std::uint32_t>(index.y())};
+    }
+
+    event_records::PixelCharge make_record(const PixelCharge& charge) {
+        auto index = charge.getIndex();
+        return {charge.getLocalTime(),
+                charge.getGlobalTime(),
+                static_cast<std::int64_t>(charge.getCharge()),
+                static_cast<std::uint32_t>(index.x()),
+                static_cast<std::uint32_t>(index.y())};
+    }
+
+    event_records::DepositedCharge make_record(const DepositedCharge& charge) {
+        auto local = charge.getLocalPosition();
+        auto global = charge.getGlobalPosition();
+        return {local.x(),
+                local.y(),
+                local.z(),
+                global.x(),
+                global.y(),
+                global.z(),
+                charge.getLocalTime(),
+                charge.getGlobalTime(),
+                charge.getCharge(),
+                static_cast<std::int32_t>(charge.getType())};
+    }
+} // namespace
+
+EventCallbackModule::EventCallbackModule(Configuration& config, Messenger* messenger, GeometryManager*)
+    : SequentialModule(config), messenger_(messenger) {
+    // Enable multithreading of this module if multithreading is enabled, the callback is still invoked sequentially
+    allow_multithreading();
+
+    config_.setDefault("callback", "default");
+    config_.setDefault<std::vector<std::string>>("include", {"PixelHit", "PixelCharge", "DepositedCharge"});
+
+    callback_name_ = config_.get<std::string>("callback");
+    for(auto& type : config_.getArray<std::string>("include")) {
+        if(type != "PixelHit" && type != "PixelCharge" && type != "DepositedCharge") {
+            throw InvalidValueError(config_, "include", "object type '" + type + "' is not supported");
+        }
+        include_.insert(type);
+    }
+
+    // Bind to the messages of all included types
+    if(include_.count("PixelHit") != 0) {
+        messenger_->bindMulti<PixelHitMessage>(this, MsgFlags::NONE);
+    }
+    if(include_.count("PixelCharge") != 0) {
+        messenger_->bindMulti<PixelChargeMessage>(this, MsgFlags::NONE);
+    }
+    if(include_.count("DepositedCharge") != 0) {
+        messenger_->bindMulti<DepositedChargeMessage>(this, MsgFlags::NONE);
+    }
+}
+
+void EventCallbackModule::initialize() {
+    callback_ = CallbackRegistry::get(callback_name_);
+    if(!callback_) {
+        throw InvalidValueError(config_, "callback", "no callback registered with this name");
+    }
+}
+
+void EventCallbackModule::run(Event* event) {
+    if(include_.count("DepositedCharge") != 0) {
+        process<DepositedCharge>(event, "DepositedCharge");
+    }
+    if(include_.count("PixelCharge") != 0) {
+        process<PixelCharge>(event, "PixelCharge");
+    }
+    if(include_.count("PixelHit") != 0) {
+        process<PixelHit>(event, "PixelHit");
+    }
+}
+
+/**
+ * The records are converted once into memory owned by the array passed to the callback, which can keep it beyond the
+ * callback without copying it.
+ */
+template <typename T> void EventCallbackModule::process(Event* event, const std::string& type) {
+    using Record = decltype(make_record(std::declval<const T&>()));
+
+    auto messages = messenger_->fetchMultiMessage<Message<T>>(this, event);
+    for(auto& message : messages) {
+        const auto& objects = message->getData();
+        auto records = std::make_shared<std::vector<Record>>();
+        records->reserve(objects.size());
+        for(const auto& object : objects) {
+            records->push_back(make_record(object));
+        }
+
+        RecordArray array;
+        array.type = type;
+        array.detector = (message->getDetector() != nullptr ? message->getDetector()->getName() : "");
+        array.event = event->number;
+        array.count = records->size();
+        array.record_size = sizeof(Record);
+        array.data = std::shared_ptr<const void>(records, records->data());
+
+        LOG(TRACE) << "Passing " << array.count << " " << array.type << " records of detector '" << array.detector
+                   << "' to callback " << callback_name_;
+        callback_(array);
+        record_count_ += array.count;
+    }
+}
+
+void EventCallbackModule::finalize() {
+    LOG(STATUS) << "Passed " << record_count_ << " records to callback " << callback_name_;
+}
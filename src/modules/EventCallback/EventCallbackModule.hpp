@@ -0,0 +1,71 @@
+/**
+ * @file
+ * @brief Definition of the module passing the data of every event to a callback registered by the application
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include <set>
+#include <string>
+
+#include "core/config/Configuration.hpp"
+#include "core/geometry/GeometryManager.hpp"
+#include "core/messenger/Messenger.hpp"
+#include "core/module/CallbackRegistry.hpp"
+#include "core/module/Event.hpp"
+#include "core/module/Module.hpp"
+
+namespace allpix {
+    /**
+     * @ingroup Modules
+     * @brief Module to hand the objects of every event as flat records to a callback of the embedding application
+     *
+     * The objects of every message are converted to a contiguous array of \ref event_records, which is passed to the
+     * callback together with the event number and the detector of the message. The callback is invoked for the events in
+     * their order and never concurrently.
+     */
+    class EventCallbackModule : public SequentialModule {
+    public:
+        /**
+         * @brief Constructor for this unique module
+         * @param config Configuration object for this module as retrieved from the steering file
+         * @param messenger Pointer to the messenger object to allow binding to messages on the bus
+         * @param geo_manager Pointer to the geometry manager, containing the detectors
+         */
+        EventCallbackModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager);
+
+        /**
+         * @brief Look up the callback in the registry
+         */
+        void initialize() override;
+
+        /**
+         * @brief Convert the messages of the event and pass them to the callback
+         */
+        void run(Event* event) override;
+
+        /**
+         * @brief Report the number of records passed to the callback
+         */
+        void finalize() override;
+
+    private:
+        /**
+         * @brief Convert the objects of all messages of a type and pass them to the callback
+         * @param event Event to fetch the messages from
+         * @param type Name of the object type passed to the callback
+         */
+        template <typename T> void process(Event* event, const std::string& type);
+
+        Messenger* messenger_;
+
+        std::string callback_name_;
+        CallbackRegistry::Callback callback_;
+        std::set<std::string> include_;
+
+        // Statistics
+        unsigned long long record_count_{};
+    };
+} // namespace allpix
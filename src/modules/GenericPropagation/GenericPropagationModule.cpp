@@ -10,13 +10,17 @@
 
 #include "GenericPropagationModule.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <functional>
 #include <limits>
 #include <map>
 #include <memory>
 #include <random>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 #include <Eigen/Core>
@@ -34,13 +38,17 @@
 
 #include "core/config/Configuration.hpp"
 #include "core/messenger/Messenger.hpp"
+#include "core/module/ThreadPool.hpp"
 #include "core/utils/distributions.h"
 #include "core/utils/log.h"
 #include "core/utils/unit.h"
 #include "tools/ROOT.h"
 #include "tools/runge_kutta.h"
+#include "tools/units.h"
 
 #include "objects/DepositedCharge.hpp"
+#include "objects/PixelCharge.hpp"
+#include "objects/PixelChargeAccumulator.hpp"
 #include "objects/PropagatedCharge.hpp"
 
 using namespace allpix;
@@ -66,11 +74,29 @@ GenericPropagationModule::GenericPropagationModule(Configuration& config,
     config_.setDefault<double>("timestep_max", Units::get(0.5, "ns"));
     config_.setDefault<double>("integration_time", Units::get(25, "ns"));
     config_.setDefault<unsigned int>("charge_per_step", 10);
+    config_.setDefault<unsigned int>("max_charge_groups", 0);
+    config_.setDefault<double>("merge_distance", 0);
+    config_.setDefault<unsigned int>("split_charge_per_step", 0);
+    config_.setDefault<double>("split_distance", 3.);
+    config_.setDefault<bool>("parallel_propagation", false);
+    config_.setDefault<unsigned int>("propagation_batch_size", 1);
+    config_.setDefault<FieldPrecision>("propagation_precision", FieldPrecision::DOUBLE);
+    config_.setDefault<bool>("terminate_unreachable", false);
+    config_.setDefault<double>("reachability_sigma", 5.);
+    config_.setDefault<unsigned int>("max_steps", 0);
+    config_.setDefault<double>("diffusion_field_threshold", Units::get(10, "V/cm"));
     config_.setDefault<double>("temperature", 293.15);
 
     // Models:
     config_.setDefault<std::string>("mobility_model", "jacoboni");
+    config_.setDefault<bool>("mobility_table", false);
+    config_.setDefault<double>("mobility_table_precision", 1e-4);
+    config_.setDefault<bool>("velocity_grid", false);
     config_.setDefault<std::string>("recombination_model", "none");
+    config_.setDefault<bool>("sample_survival_time", false);
+    config_.setDefault<bool>("transfer_charges", false);
+    config_.setDefault<double>("max_depth_distance", Units::get(5.0, "um"));
+    config_.setDefault<bool>("collect_from_implant", false);
 
     config_.setDefault<bool>("output_linegraphs", false);
     config_.setDefault<bool>("output_animations", false);
@@ -111,6 +137,69 @@ GenericPropagationModule::GenericPropagationModule(Configuration& config,
     propagate_electrons_ = config_.get<bool>("propagate_electrons");
     propagate_holes_ = config_.get<bool>("propagate_holes");
     charge_per_step_ = config_.get<unsigned int>("charge_per_step");
+    if(charge_per_step_ == 0) {
+        throw InvalidValueError(config_, "charge_per_step", "at least one charge carrier has to be propagated per step");
+    }
+    max_charge_groups_ = config_.get<unsigned int>("max_charge_groups");
+    merge_distance_ = config_.get<double>("merge_distance");
+    split_charge_per_step_ = config_.get<unsigned int>("split_charge_per_step");
+    if(split_charge_per_step_ > 0) {
+        if(split_charge_per_step_ >= charge_per_step_) {
+            throw InvalidValueError(
+                config_, "split_charge_per_step", "sets can only be split into sets smaller than charge_per_step");
+        }
+        split_distance_ = config_.get<double>("split_distance");
+        if(split_distance_ <= 0) {
+            throw InvalidValueError(config_, "split_distance", "number of standard deviations has to be positive");
+        }
+    }
+    parallel_propagation_ = config_.get<bool>("parallel_propagation");
+    propagation_batch_size_ = config_.get<unsigned int>("propagation_batch_size");
+    if(propagation_batch_size_ == 0) {
+        throw InvalidValueError(config_, "propagation_batch_size", "batch size should be at least one set of charges");
+    }
+    propagation_precision_ = config_.get<FieldPrecision>("propagation_precision");
+    if(propagation_precision_ == FieldPrecision::SINGLE && propagation_batch_size_ == 1) {
+        throw InvalidCombinationError(config_,
+                                      {"propagation_precision", "propagation_batch_size"},
+                                      "single precision propagation is only available for batches of sets of charges");
+    }
+    sample_survival_time_ = config_.get<bool>("sample_survival_time");
+    transfer_charges_ = config_.get<bool>("transfer_charges");
+    if(transfer_charges_) {
+        max_depth_distance_ = config_.get<double>("max_depth_distance");
+        collect_from_implant_ = config_.get<bool>("collect_from_implant");
+    }
+    terminate_unreachable_ = config_.get<bool>("terminate_unreachable");
+    reachability_sigma_ = config_.get<double>("reachability_sigma");
+    if(reachability_sigma_ < 0) {
+        throw InvalidValueError(config_, "reachability_sigma", "number of standard deviations cannot be negative");
+    }
+    max_steps_ = config_.get<unsigned int>("max_steps");
+    diffusion_field_threshold_ = config_.get<double>("diffusion_field_threshold");
+    if(split_charge_per_step_ > 0 && propagation_batch_size_ > 1) {
+        throw InvalidCombinationError(config_,
+                                      {"split_charge_per_step", "propagation_batch_size"},
+                                      "sets of charges cannot be split when propagating them in batches");
+    }
+    if(split_charge_per_step_ > 0 && output_linegraphs_) {
+        throw InvalidCombinationError(config_,
+                                      {"split_charge_per_step", "output_linegraphs"},
+                                      "line graphs cannot be drawn for sets of charges which are split");
+    }
+
+    // Bind the parameters of the output plots, which are drawn for every event
+    if(output_plots_) {
+        output_plots_use_pixel_units_ = config_.bind<bool>("output_plots_use_pixel_units");
+        output_plots_use_equal_scaling_ = config_.bind<bool>("output_plots_use_equal_scaling", true);
+        output_plots_align_pixels_ = config_.bind<bool>("output_plots_align_pixels");
+        output_animations_color_markers_ = config_.bind<bool>("output_animations_color_markers");
+        output_plots_theta_ = config_.bind<double>("output_plots_theta");
+        output_plots_phi_ = config_.bind<double>("output_plots_phi");
+        output_animations_marker_size_ = config_.bind<double>("output_animations_marker_size", 1);
+        output_animations_contour_max_scaling_ = config_.bind<double>("output_animations_contour_max_scaling", 10);
+        output_animations_time_scaling_ = config_.bind<long double>("output_animations_time_scaling", 1e9);
+    }
 
     // Enable multithreading of this module if multithreading is enabled and no per-event output plots are requested:
     // FIXME: Review if this is really the case or we can still use multithreading
@@ -118,6 +207,12 @@ GenericPropagationModule::GenericPropagationModule(Configuration& config,
         allow_multithreading();
     } else {
         LOG(WARNING) << "Per-event line graphs or animations requested, disabling parallel event processing";
+        if(parallel_propagation_ || propagation_batch_size_ > 1) {
+            LOG(WARNING) << "Per-event line graphs or animations requested, disabling parallel and batch propagation";
+            parallel_propagation_ = false;
+            propagation_batch_size_ = 1;
+            propagation_precision_ = FieldPrecision::DOUBLE;
+        }
     }
 
     boltzmann_kT_ = Units::get(8.6173e-5, "eV/K") * temperature_;
@@ -132,7 +227,7 @@ void GenericPropagationModule::create_output_plots(uint64_t event_num, OutputPlo
     LOG(TRACE) << "Writing output plots";
 
     // Convert to pixel units if necessary
-    if(config_.get<bool>("output_plots_use_pixel_units")) {
+    if(output_plots_use_pixel_units_) {
         for(auto& deposit_points : output_plot_points) {
             for(auto& point : deposit_points.second) {
                 point.SetX(point.x() / model_->getPixelSize().x());
@@ -164,10 +259,10 @@ void GenericPropagationModule::create_output_plots(uint64_t event_num, OutputPlo
     }
 
     // Compute frame axis sizes if equal scaling is requested
-    if(config_.get<bool>("output_plots_use_equal_scaling", true)) {
+    if(output_plots_use_equal_scaling_) {
         double centerX = (minX + maxX) / 2.0;
         double centerY = (minY + maxY) / 2.0;
-        if(config_.get<bool>("output_plots_use_pixel_units")) {
+        if(output_plots_use_pixel_units_) {
             minX = centerX - model_->getSensorSize().z() / model_->getPixelSize().x() / 2.0;
             maxX = centerX + model_->getSensorSize().z() / model_->getPixelSize().x() / 2.0;
 
@@ -183,8 +278,8 @@ void GenericPropagationModule::create_output_plots(uint64_t event_num, OutputPlo
     }
 
     // Align on pixels if requested
-    if(config_.get<bool>("output_plots_align_pixels")) {
-        if(config_.get<bool>("output_plots_use_pixel_units")) {
+    if(output_plots_align_pixels_) {
+        if(output_plots_use_pixel_units_) {
             minX = std::floor(minX - 0.5) + 0.5;
             minY = std::floor(minY + 0.5) - 0.5;
             maxX = std::ceil(maxX - 0.5) + 0.5;
@@ -221,14 +316,14 @@ void GenericPropagationModule::create_output_plots(uint64_t event_num, OutputPlo
                                             1280,
                                             1024);
     canvas->cd();
-    canvas->SetTheta(config_.get<float>("output_plots_theta") * 180.0f / ROOT::Math::Pi());
-    canvas->SetPhi(config_.get<float>("output_plots_phi") * 180.0f / ROOT::Math::Pi());
+    canvas->SetTheta(static_cast<float>(*output_plots_theta_) * 180.0f / ROOT::Math::Pi());
+    canvas->SetPhi(static_cast<float>(*output_plots_phi_) * 180.0f / ROOT::Math::Pi());
 
     // Draw the frame on the canvas
     histogram_frame->GetXaxis()->SetTitle(
-        (std::string("x ") + (config_.get<bool>("output_plots_use_pixel_units") ? "(pixels)" : "(mm)")).c_str());
+        (std::string("x ") + (output_plots_use_pixel_units_ ? "(pixels)" : "(mm)")).c_str());
     histogram_frame->GetYaxis()->SetTitle(
-        (std::string("y ") + (config_.get<bool>("output_plots_use_pixel_units") ? "(pixels)" : "(mm)")).c_str());
+        (std::string("y ") + (output_plots_use_pixel_units_ ? "(pixels)" : "(mm)")).c_str());
     histogram_frame->GetZaxis()->SetTitle("z (mm)");
     histogram_frame->Draw();
 
@@ -264,10 +359,10 @@ void GenericPropagationModule::create_output_plots(uint64_t event_num, OutputPlo
     canvas->cd();
 
     // Change axis labels if close to zero or PI as they behave different here
-    if(std::fabs(config_.get<double>("output_plots_theta") / (ROOT::Math::Pi() / 2.0) -
-                 std::round(config_.get<double>("output_plots_theta") / (ROOT::Math::Pi() / 2.0))) < 1e-6 ||
-       std::fabs(config_.get<double>("output_plots_phi") / (ROOT::Math::Pi() / 2.0) -
-                 std::round(config_.get<double>("output_plots_phi") / (ROOT::Math::Pi() / 2.0))) < 1e-6) {
+    if(std::fabs(output_plots_theta_ / (ROOT::Math::Pi() / 2.0) -
+                 std::round(output_plots_theta_ / (ROOT::Math::Pi() / 2.0))) < 1e-6 ||
+       std::fabs(output_plots_phi_ / (ROOT::Math::Pi() / 2.0) - std::round(output_plots_phi_ / (ROOT::Math::Pi() / 2.0))) <
+           1e-6) {
         histogram_frame->GetXaxis()->SetLabelOffset(-0.1f);
         histogram_frame->GetYaxis()->SetLabelOffset(-0.075f);
     } else {
@@ -340,8 +435,8 @@ void GenericPropagationModule::create_output_plots(uint64_t event_num, OutputPlo
 
         // Create animation of moving charges
         auto animation_time = static_cast<unsigned int>(
-            std::round((Units::convert(config_.get<long double>("output_plots_step"), "ms") / 10.0) *
-                       config_.get<long double>("output_animations_time_scaling", 1e9)));
+            std::round((Units::convert(static_cast<long double>(output_plots_step_), "ms") / 10.0) *
+                       output_animations_time_scaling_));
         unsigned long plot_idx = 0;
         unsigned int point_cnt = 0;
         LOG_PROGRESS(INFO, getUniqueName() + "_OUTPUT_PLOTS") << "Written 0 of " << tot_point_cnt << " points for animation";
@@ -351,21 +446,21 @@ void GenericPropagationModule::create_output_plots(uint64_t event_num, OutputPlo
 
             // Reset the canvas
             canvas->Clear();
-            canvas->SetTheta(config_.get<float>("output_plots_theta") * 180.0f / ROOT::Math::Pi());
-            canvas->SetPhi(config_.get<float>("output_plots_phi") * 180.0f / ROOT::Math::Pi());
+            canvas->SetTheta(static_cast<float>(*output_plots_theta_) * 180.0f / ROOT::Math::Pi());
+            canvas->SetPhi(static_cast<float>(*output_plots_phi_) * 180.0f / ROOT::Math::Pi());
             canvas->Draw();
 
             // Reset the histogram frame
             histogram_frame->SetTitle("Charge propagation in sensor");
             histogram_frame->GetXaxis()->SetTitle(
-                (std::string("x ") + (config_.get<bool>("output_plots_use_pixel_units") ? "(pixels)" : "(mm)")).c_str());
+                (std::string("x ") + (output_plots_use_pixel_units_ ? "(pixels)" : "(mm)")).c_str());
             histogram_frame->GetYaxis()->SetTitle(
-                (std::string("y ") + (config_.get<bool>("output_plots_use_pixel_units") ? "(pixels)" : "(mm)")).c_str());
+                (std::string("y ") + (output_plots_use_pixel_units_ ? "(pixels)" : "(mm)")).c_str());
             histogram_frame->GetZaxis()->SetTitle("z (mm)");
             histogram_frame->Draw();
 
             auto text = std::make_unique<TPaveText>(-0.75, -0.75, -0.60, -0.65);
-            auto time_ns = Units::convert(plot_idx * config_.get<long double>("output_plots_step"), "ns");
+            auto time_ns = Units::convert(plot_idx * static_cast<long double>(output_plots_step_), "ns");
             std::stringstream sstr;
             sstr << std::fixed << std::setprecision(2) << time_ns << "ns";
             auto time_str = std::string(8 - sstr.str().size(), ' ');
@@ -376,7 +471,7 @@ void GenericPropagationModule::create_output_plots(uint64_t event_num, OutputPlo
             // Plot all the required points
             for(auto& [deposit, points] : output_plot_points) {
                 auto diff = static_cast<unsigned long>(
-                    std::round((deposit.getGlobalTime() - start_time) / config_.get<long double>("output_plots_step")));
+                    std::round((deposit.getGlobalTime() - start_time) / static_cast<long double>(output_plots_step_)));
                 if(plot_idx < diff) {
                     min_idx_diff = std::min(min_idx_diff, diff - plot_idx);
                     continue;
@@ -390,12 +485,12 @@ void GenericPropagationModule::create_output_plots(uint64_t event_num, OutputPlo
                 auto marker = std::make_unique<TPolyMarker3D>();
                 marker->SetMarkerStyle(kFullCircle);
                 marker->SetMarkerSize(
-                    static_cast<float>(deposit.getCharge() * config_.get<double>("output_animations_marker_size", 1)) /
+                    static_cast<float>(deposit.getCharge() * output_animations_marker_size_) /
                     static_cast<float>(max_charge));
                 auto initial_z_perc = static_cast<int>(
                     ((points[0].z() + model_->getSensorSize().z() / 2.0) / model_->getSensorSize().z()) * 80);
                 initial_z_perc = std::max(std::min(79, initial_z_perc), 0);
-                if(config_.get<bool>("output_animations_color_markers")) {
+                if(output_animations_color_markers_) {
                     marker->SetMarkerColor(static_cast<Color_t>(colors[initial_z_perc]->GetNumber()));
                 }
                 marker->SetNextPoint(points[idx].x(), points[idx].y(), points[idx].z());
@@ -429,29 +524,28 @@ void GenericPropagationModule::create_output_plots(uint64_t event_num, OutputPlo
                     switch(i) {
                     case 0 /* x */:
                         histogram_contour[i]->GetXaxis()->SetTitle(
-                            (std::string("y ") + (config_.get<bool>("output_plots_use_pixel_units") ? "(pixels)" : "(mm)"))
+                            (std::string("y ") + (output_plots_use_pixel_units_ ? "(pixels)" : "(mm)"))
                                 .c_str());
                         histogram_contour[i]->GetYaxis()->SetTitle("z (mm)");
                         break;
                     case 1 /* y */:
                         histogram_contour[i]->GetXaxis()->SetTitle(
-                            (std::string("x ") + (config_.get<bool>("output_plots_use_pixel_units") ? "(pixels)" : "(mm)"))
+                            (std::string("x ") + (output_plots_use_pixel_units_ ? "(pixels)" : "(mm)"))
                                 .c_str());
                         histogram_contour[i]->GetYaxis()->SetTitle("z (mm)");
                         break;
                     case 2 /* z */:
                         histogram_contour[i]->GetXaxis()->SetTitle(
-                            (std::string("x ") + (config_.get<bool>("output_plots_use_pixel_units") ? "(pixels)" : "(mm)"))
+                            (std::string("x ") + (output_plots_use_pixel_units_ ? "(pixels)" : "(mm)"))
                                 .c_str());
                         histogram_contour[i]->GetYaxis()->SetTitle(
-                            (std::string("y ") + (config_.get<bool>("output_plots_use_pixel_units") ? "(pixels)" : "(mm)"))
+                            (std::string("y ") + (output_plots_use_pixel_units_ ? "(pixels)" : "(mm)"))
                                 .c_str());
                         break;
                     default:;
                     }
                     histogram_contour[i]->SetMinimum(1);
-                    histogram_contour[i]->SetMaximum(total_charge /
-                                                     config_.get<double>("output_animations_contour_max_scaling", 10));
+                    histogram_contour[i]->SetMaximum(total_charge / output_animations_contour_max_scaling_);
                     histogram_contour[i]->Draw("CONTZ 0");
                     if(point_cnt < tot_point_cnt - 1) {
                         canvas->Print((file_name_contour[i] + "+" + std::to_string(animation_time)).c_str());
@@ -498,6 +592,18 @@ void GenericPropagationModule::initialize() {
         }
     }
 
+    // Propagated charges are only created if they are stored or used by another module when transferring directly
+    store_propagated_charges_ = true;
+    if(transfer_charges_) {
+        if(collect_from_implant_ && detector->getElectricFieldType() == FieldType::LINEAR) {
+            throw ModuleError("Charge collection from implant region should not be used with linear electric fields.");
+        }
+        store_propagated_charges_ = messenger_->hasReceiver(
+            this, std::make_shared<PropagatedChargeMessage>(std::vector<PropagatedCharge>(), detector_));
+        LOG(DEBUG) << "Transferring propagated charges to pixels directly"
+                   << (store_propagated_charges_ ? "" : ", not creating propagated charges without receivers");
+    }
+
     // Check for magnetic field
     has_magnetic_field_ = detector->hasMagneticField();
     if(has_magnetic_field_) {
@@ -507,6 +613,7 @@ void GenericPropagationModule::initialize() {
         } else {
             LOG(DEBUG) << "This detector sees a magnetic field.";
             magnetic_field_ = detector_->getMagneticField();
+            uniform_magnetic_field_ = detector_->hasUniformMagneticField();
         }
     }
 
@@ -552,12 +659,169 @@ void GenericPropagationModule::initialize() {
         throw InvalidValueError(config_, "mobility_model", e.what());
     }
 
+    // Replace the mobility model by a lookup table if requested
+    if(config_.get<bool>("mobility_table")) {
+        auto precision = config_.get<double>("mobility_table_precision");
+        if(precision <= 0) {
+            throw InvalidValueError(config_, "mobility_table_precision", "precision of the table has to be positive");
+        }
+        auto error = mobility_.tabulate(precision);
+        LOG(INFO) << "Using tabulated mobility model with a maximum relative interpolation error of " << error;
+    }
+
+    // Precompute the drift velocity of electrons and holes on the grid of the electric field
+    velocity_grid_ = config_.get<bool>("velocity_grid");
+    if(velocity_grid_ && detector->getElectricFieldType() != FieldType::GRID) {
+        LOG(WARNING) << "Electric field is not given by a grid, drift velocity is not precomputed";
+        velocity_grid_ = false;
+    } else if(velocity_grid_ && has_magnetic_field_ && !uniform_magnetic_field_) {
+        LOG(WARNING) << "Drift velocity depends on the non-uniform magnetic field, drift velocity is not precomputed";
+        velocity_grid_ = false;
+    }
+    if(velocity_grid_) {
+        // A uniform magnetic field only adds a deflection depending on the local mobility, which is included in the grid
+        for(auto type : {CarrierType::ELECTRON, CarrierType::HOLE}) {
+            auto hole = (type == CarrierType::HOLE ? 1 : 0);
+            auto sign = static_cast<int>(type);
+            auto hall_factor = (type == CarrierType::ELECTRON ? electron_Hall_ : hole_Hall_);
+            velocity_grids_[hole] = detector->deriveElectricFieldGrid(
+                [&, type, sign, hall_factor](const ROOT::Math::XYZPoint& position, const ROOT::Math::XYZVector& efield) {
+                    auto mobility = mobility_(type, std::sqrt(efield.Mag2()), detector->getDopingConcentration(position));
+                    if(!has_magnetic_field_) {
+                        return sign * mobility * efield;
+                    }
+                    const auto& bfield = magnetic_field_;
+                    auto term_factor = mobility * mobility * hall_factor * hall_factor;
+                    auto rnorm = 1 + term_factor * bfield.Mag2();
+                    return sign * mobility *
+                           (efield + sign * mobility * hall_factor * efield.Cross(bfield) +
+                            term_factor * efield.Dot(bfield) * bfield) /
+                           rnorm;
+                });
+        }
+        LOG(INFO) << "Using drift velocity precomputed on the grid of the electric field"
+                  << (has_magnetic_field_ ? " including the uniform magnetic field" : "");
+    }
+
     // Prepare recombination model
     try {
         recombination_ = Recombination(config_.get<std::string>("recombination_model"), detector->hasDopingProfile());
     } catch(ModelError& e) {
         throw InvalidValueError(config_, "recombination_model", e.what());
     }
+
+    if(terminate_unreachable_) {
+        create_reachability_table();
+    }
+}
+
+/**
+ * The sensor is divided into bins in depth. For every bin, the drift velocity and the diffusion constant are sampled on a
+ * grid of positions covering a pixel cell, and the largest values are kept as upper bound for the whole bin. Since the
+ * magnitude of the drift velocity is used regardless of its direction and the magnetic field can only reduce it, the time
+ * to cross a bin can never be shorter than its height divided by this bound. Diffusion can carry the carriers through bins
+ * without sufficient drift, which is accounted for in \ref GenericPropagationModule::is_reachable.
+ */
+void GenericPropagationModule::create_reachability_table() {
+    constexpr size_t depth_bins = 100;
+    constexpr size_t pixel_samples = 10;
+
+    auto thickness = model_->getSensorSize().z();
+    auto center = model_->getSensorCenter();
+    auto pixel_size = model_->getPixelSize();
+    auto pixel_center = model_->getPixelCenter(0, 0);
+    reachability_bin_size_ = thickness / depth_bins;
+
+    for(auto type : {CarrierType::ELECTRON, CarrierType::HOLE}) {
+        auto hole = (type == CarrierType::HOLE ? 1 : 0);
+
+        // Largest drift velocity in every bin and largest diffusion constant in the sensor
+        std::vector<double> max_velocity(depth_bins, 0.);
+        max_diffusion_constant_[hole] = 0.;
+        for(size_t k = 0; k < depth_bins; ++k) {
+            for(size_t i = 0; i <= pixel_samples; ++i) {
+                for(size_t j = 0; j <= pixel_samples; ++j) {
+                    // Sample the edges of the bin and the pixel cell as well
+                    for(auto edge : {0., 1.}) {
+                        ROOT::Math::XYZPoint position(
+                            pixel_center.x() + pixel_size.x() * (static_cast<double>(i) / pixel_samples - 0.5),
+                            pixel_center.y() + pixel_size.y() * (static_cast<double>(j) / pixel_samples - 0.5),
+                            center.z() - thickness / 2 + reachability_bin_size_ * (static_cast<double>(k) + edge));
+                        auto efield_mag = std::sqrt(detector_->getElectricField(position).Mag2());
+                        auto mobility = mobility_(type, efield_mag, detector_->getDopingConcentration(position));
+                        max_velocity[k] = std::max(max_velocity[k], mobility * efield_mag);
+                        max_diffusion_constant_[hole] = std::max(max_diffusion_constant_[hole], boltzmann_kT_ * mobility);
+                    }
+                }
+            }
+        }
+
+        // Sort the bins above every bin by their slowness and accumulate their length and drift time
+        auto& steps = reachability_steps_[hole];
+        steps.assign(depth_bins, {});
+        for(size_t k = 0; k < depth_bins; ++k) {
+            std::vector<double> slowness;
+            for(size_t above = k + 1; above < depth_bins; ++above) {
+                slowness.push_back(max_velocity[above] > 0 ? 1. / max_velocity[above]
+                                                           : std::numeric_limits<double>::infinity());
+            }
+            std::sort(slowness.begin(), slowness.end(), std::greater<>());
+
+            double length = 0;
+            double time = 0;
+            for(auto value : slowness) {
+                steps[k].push_back({value, length, time});
+                length += reachability_bin_size_;
+                time += (std::isinf(value) ? 0. : value * reachability_bin_size_);
+            }
+            // Closing step reached when diffusion alone can cover the full distance
+            steps[k].push_back({0., length, time});
+        }
+
+        // Report the depth below which deposits cannot be collected at all within the integration time
+        size_t unreachable = 0;
+        auto bin_center = [&](size_t k) {
+            return center.z() - thickness / 2 + reachability_bin_size_ * (static_cast<double>(k) + 0.5);
+        };
+        while(unreachable < depth_bins && !is_reachable(type, bin_center(unreachable), integration_time_)) {
+            ++unreachable;
+        }
+        auto name = (type == CarrierType::ELECTRON ? "electrons" : "holes");
+        if(unreachable > 0) {
+            LOG(INFO) << "Deposited " << name << " up to "
+                      << Units::display(reachability_bin_size_ * static_cast<double>(unreachable), {"um", "mm"})
+                      << " from the back side cannot reach the implant side within the integration time";
+        } else {
+            LOG(INFO) << "Deposited " << name << " at any depth can reach the implant side within the integration time";
+        }
+    }
+}
+
+/**
+ * The diffusion of the carriers within the remaining time is bounded by the configured number of standard deviations of the
+ * largest diffusion constant in the sensor. This distance is credited to the slowest bins between the carriers and the
+ * implant side, and the carriers are only out of reach if drifting through the remaining bins at their largest velocity
+ * takes longer than the remaining time. The bin containing the carriers is not taken into account.
+ */
+bool GenericPropagationModule::is_reachable(const CarrierType& type, double z, double remaining_time) const {
+    auto hole = (type == CarrierType::HOLE ? 1 : 0);
+    const auto& all_steps = reachability_steps_[hole];
+    auto bin = static_cast<long>(
+        std::floor((z - model_->getSensorCenter().z() + model_->getSensorSize().z() / 2) / reachability_bin_size_));
+    const auto& steps = all_steps[static_cast<size_t>(std::clamp(bin, 0L, static_cast<long>(all_steps.size()) - 1))];
+
+    // Distance covered by diffusion, skipping the slowest bins
+    auto diffusion = reachability_sigma_ * std::sqrt(2. * max_diffusion_constant_[hole] * std::max(remaining_time, 0.));
+    auto step = std::upper_bound(
+        steps.begin(), steps.end(), diffusion, [](double value, const ReachabilityStep& s) { return value < s.length; });
+    const auto& partial = *std::prev(step);
+    if(std::isinf(partial.slowness)) {
+        return false;
+    }
+
+    // Drift time through the remaining part of the partially skipped bin and all faster bins
+    auto drift_time = steps.back().time - partial.time - (diffusion - partial.length) * partial.slowness;
+    return drift_time <= remaining_time;
 }
 
 void GenericPropagationModule::run(Event* event) {
@@ -569,12 +833,9 @@ void GenericPropagationModule::run(Event* event) {
     // List of points to plot to plot for output plots
     OutputPlotPoints output_plot_points;
 
-    // Loop over all deposits for propagation
+    // Select the deposits to propagate
     LOG(TRACE) << "Propagating charges in sensor";
-    unsigned int propagated_charges_count = 0;
-    unsigned int recombined_charges_count = 0;
-    unsigned int step_count = 0;
-    long double total_time = 0;
+    std::vector<const DepositedCharge*> deposits;
     for(const auto& deposit : deposits_message->getData()) {
 
         if((deposit.getType() == CarrierType::ELECTRON && !propagate_electrons_) ||
@@ -592,72 +853,185 @@ void GenericPropagationModule::run(Event* event) {
             continue;
         }
 
-        // Loop over all charges in the deposit
-        unsigned int charges_remaining = deposit.getCharge();
-
         LOG(DEBUG) << "Set of charge carriers (" << deposit.getType() << ") on "
                    << Units::display(deposit.getLocalPosition(), {"mm", "um"});
+        deposits.push_back(&deposit);
+    }
+
+    // Split all deposits into sets of charges to be propagated together
+    size_t unmerged_sets = 0;
+    auto charge_sets = create_charge_groups(deposits, charge_per_step_, max_charge_groups_, merge_distance_, unmerged_sets);
+    if(charge_sets.size() < unmerged_sets) {
+        LOG(DEBUG) << "Propagating " << charge_sets.size() << " sets of charges instead of " << unmerged_sets;
+    }
+    total_charge_sets_ += charge_sets.size();
+    total_unmerged_charge_sets_ += unmerged_sets;
+    increment_counter("saved_charge_sets", unmerged_sets - charge_sets.size());
+
+    // Propagate all sets of charges, storing the final position, the propagation time and if the set is still alive
+    std::vector<PropagationResult> propagation_results(charge_sets.size());
+    // Results of the sets split into smaller sets close to the pixel boundaries, indexed by the original set
+    std::vector<std::vector<std::pair<PropagationResult, unsigned int>>> split_results;
+    if(split_charge_per_step_ > 0) {
+        split_results.resize(charge_sets.size());
+    }
+    auto propagate_set = [&](size_t idx, RandomNumberGenerator& random_generator) {
+        const auto& deposit = *charge_sets[idx].first;
+
+        // Get position and propagate through sensor
+        auto initial_position = deposit.getLocalPosition();
+
+        // Add point of deposition to the output plots if requested
+        if(output_linegraphs_) {
+            auto global_position = detector_->getGlobalPosition(initial_position);
+            std::lock_guard<std::mutex> lock{stats_mutex_};
+            output_plot_points.emplace_back(PropagatedCharge(initial_position,
+                                                             global_position,
+                                                             deposit.getType(),
+                                                             charge_sets[idx].second,
+                                                             deposit.getLocalTime(),
+                                                             deposit.getGlobalTime()),
+                                            std::vector<ROOT::Math::XYZPoint>());
+        }
 
-        auto charge_per_step = charge_per_step_;
-        while(charges_remaining > 0) {
-            // Define number of charges to be propagated and remove charges of this step from the total
-            if(charge_per_step > charges_remaining) {
-                charge_per_step = charges_remaining;
+        // Propagate a single charge deposit, splitting it into smaller sets close to the pixel boundaries if requested
+        if(split_charge_per_step_ > 0 && charge_sets[idx].second > split_charge_per_step_) {
+            split_results[idx] = propagate_split(initial_position,
+                                                 deposit.getType(),
+                                                 deposit.getLocalTime(),
+                                                 charge_sets[idx].second,
+                                                 random_generator,
+                                                 output_plot_points);
+        } else {
+            propagation_results[idx] = propagate(
+                initial_position, deposit.getType(), deposit.getLocalTime(), random_generator, output_plot_points);
+        }
+    };
+
+    if(parallel_propagation_ || propagation_batch_size_ > 1) {
+        // Derive a seed for every set from the event, such that results do not depend on the distribution over workers
+        std::vector<uint64_t> seeds(charge_sets.size());
+        for(auto& seed : seeds) {
+            seed = event->getRandomNumber();
+        }
+        auto engine = event->getRandomEngine().getEngine();
+
+        // Propagate a block of sets, either in lockstep batches or one after the other
+        auto propagate_block = [&](size_t begin, size_t end) {
+            if(propagation_batch_size_ > 1) {
+                for(auto type : {CarrierType::ELECTRON, CarrierType::HOLE}) {
+                    if(propagation_precision_ == FieldPrecision::SINGLE) {
+                        propagate_batch<float>(type, charge_sets, seeds, engine, begin, end, propagation_results);
+                    } else {
+                        propagate_batch<double>(type, charge_sets, seeds, engine, begin, end, propagation_results);
+                    }
+                }
+            } else {
+                RandomNumberGenerator random_generator(engine);
+                for(size_t idx = begin; idx < end; ++idx) {
+                    random_generator.seed(seeds[idx]);
+                    propagate_set(idx, random_generator);
+                }
             }
-            charges_remaining -= charge_per_step;
-
-            // Get position and propagate through sensor
-            auto initial_position = deposit.getLocalPosition();
-
-            // Add point of deposition to the output plots if requested
-            if(output_linegraphs_) {
-                auto global_position = detector_->getGlobalPosition(initial_position);
-                std::lock_guard<std::mutex> lock{stats_mutex_};
-                output_plot_points.emplace_back(PropagatedCharge(initial_position,
-                                                                 global_position,
-                                                                 deposit.getType(),
-                                                                 charge_per_step,
-                                                                 deposit.getLocalTime(),
-                                                                 deposit.getGlobalTime()),
-                                                std::vector<ROOT::Math::XYZPoint>());
+        };
+
+        if(parallel_propagation_) {
+            // Split the sets in blocks to be propagated by idle workers of the thread pool
+            auto num_tasks = std::min<size_t>(charge_sets.size(), 4 * ThreadPool::threadCount());
+            std::vector<std::function<void()>> tasks;
+            for(size_t task = 0; task < num_tasks; ++task) {
+                auto begin = charge_sets.size() * task / num_tasks;
+                auto end = charge_sets.size() * (task + 1) / num_tasks;
+                tasks.emplace_back([&propagate_block, begin, end]() { propagate_block(begin, end); });
             }
+            ThreadPool::runSubtasks(tasks);
+        } else {
+            propagate_block(0, charge_sets.size());
+        }
+    } else {
+        for(size_t idx = 0; idx < charge_sets.size(); ++idx) {
+            propagate_set(idx, event->getRandomEngine());
+        }
+    }
 
-            // Propagate a single charge deposit
-            auto [final_position, time, alive] = propagate(
-                initial_position, deposit.getType(), deposit.getLocalTime(), event->getRandomEngine(), output_plot_points);
+    // Accumulate the charges at the pixels if transferring directly, the propagated charges are referenced as history only
+    // if they are created. Reserving their space keeps the references valid
+    auto result_count = charge_sets.size();
+    for(const auto& results : split_results) {
+        result_count += std::max<size_t>(results.size(), 1) - 1;
+    }
+    PixelChargeAccumulator pixel_map(transfer_charges_ ? result_count : 0);
+    unsigned int transferred_charges_count = 0;
+    if(store_propagated_charges_) {
+        propagated_charges.reserve(result_count);
+    }
 
-            if(!alive) {
-                LOG(DEBUG) << " Recombined " << charge_per_step << " at " << Units::display(final_position, {"mm", "um"})
-                           << " in " << Units::display(time, "ns") << " time, removing";
-                recombined_charges_count += charge_per_step;
-                continue;
-            }
+    // Collect the propagated charges in the original order
+    unsigned int propagated_charges_count = 0;
+    unsigned int recombined_charges_count = 0;
+    unsigned int step_count = 0;
+    long double total_time = 0;
+    auto collect = [&](const DepositedCharge& deposit, unsigned int charge_per_step, const PropagationResult& result) {
+        const auto& [final_position, time, alive] = result;
+
+        if(!alive) {
+            LOG(DEBUG) << " Recombined " << charge_per_step << " at " << Units::display(final_position, {"mm", "um"})
+                       << " in " << Units::display(time, "ns") << " time, removing";
+            recombined_charges_count += charge_per_step;
+            return;
+        }
 
-            LOG(DEBUG) << " Propagated " << charge_per_step << " to " << Units::display(final_position, {"mm", "um"})
-                       << " in " << Units::display(time, "ns") << " time";
+        LOG(DEBUG) << " Propagated " << charge_per_step << " to " << Units::display(final_position, {"mm", "um"})
+                   << " in " << Units::display(time, "ns") << " time";
 
-            // Create a new propagated charge and add it to the list
+        // Create a new propagated charge and add it to the list, weighted by the number of configured sets it represents
+        const PropagatedCharge* propagated_charge = nullptr;
+        if(store_propagated_charges_) {
             auto global_position = detector_->getGlobalPosition(final_position);
-            PropagatedCharge propagated_charge(final_position,
-                                               global_position,
-                                               deposit.getType(),
-                                               charge_per_step,
-                                               deposit.getLocalTime() + time,
-                                               deposit.getGlobalTime() + time,
-                                               &deposit);
-
-            propagated_charges.push_back(std::move(propagated_charge));
-
-            // Update statistical information
-            ++step_count;
-            propagated_charges_count += charge_per_step;
-            total_time += charge_per_step * time;
-            if(output_plots_) {
-                drift_time_histo_->Fill(static_cast<double>(Units::convert(time, "ns")), charge_per_step);
-                group_size_histo_->Fill(charge_per_step);
+            propagated_charges.emplace_back(final_position,
+                                            global_position,
+                                            deposit.getType(),
+                                            charge_per_step,
+                                            deposit.getLocalTime() + time,
+                                            deposit.getGlobalTime() + time,
+                                            &deposit,
+                                            std::max(1., static_cast<double>(charge_per_step) / charge_per_step_));
+            propagated_charge = &propagated_charges.back();
+        }
+
+        // Add the charge to its pixel
+        Pixel::Index pixel_index;
+        if(transfer_charges_ && get_transfer_pixel(final_position, pixel_index)) {
+            auto charge = static_cast<double>(deposit.getSign() * static_cast<long>(charge_per_step));
+            pixel_map.add(pixel_index, charge, propagated_charge);
+            transferred_charges_count += charge_per_step;
+        }
+
+        // Update statistical information
+        ++step_count;
+        propagated_charges_count += charge_per_step;
+        total_time += charge_per_step * time;
+        if(output_plots_) {
+            drift_time_histo_->Fill(time / units::ns, charge_per_step);
+            group_size_histo_->Fill(charge_per_step);
+        }
+    };
+    size_t split_sets = 0;
+    for(size_t idx = 0; idx < charge_sets.size(); ++idx) {
+        const auto& deposit = *charge_sets[idx].first;
+        if(!split_results.empty() && !split_results[idx].empty()) {
+            for(const auto& [result, charge] : split_results[idx]) {
+                collect(deposit, charge, result);
             }
+            split_sets += (split_results[idx].size() > 1 ? 1 : 0);
+        } else {
+            collect(deposit, charge_sets[idx].second, propagation_results[idx]);
         }
     }
+    if(split_sets > 0) {
+        LOG(DEBUG) << "Split " << split_sets << " sets of charges close to the pixel boundaries";
+        total_split_charge_sets_ += split_sets;
+    }
 
     // Output plots if required
     if(output_linegraphs_) {
@@ -671,6 +1045,8 @@ void GenericPropagationModule::run(Event* event) {
               << "Recombined " << recombined_charges_count << " charges during transport";
     total_propagated_charges_ += propagated_charges_count;
     total_steps_ += step_count;
+    increment_counter("propagated_charges", propagated_charges_count);
+    increment_counter("propagation_steps", step_count);
     total_time_picoseconds_ += static_cast<long unsigned int>(total_time * 1e3);
 
     if(output_plots_) {
@@ -678,11 +1054,57 @@ void GenericPropagationModule::run(Event* event) {
                                (propagated_charges_count + recombined_charges_count));
     }
 
-    // Create a new message with propagated charges
-    auto propagated_charge_message = std::make_shared<PropagatedChargeMessage>(std::move(propagated_charges), detector_);
+    if(store_propagated_charges_) {
+        // Create a new message with propagated charges
+        auto propagated_charge_message =
+            event->makeShared<PropagatedChargeMessage>(std::move(propagated_charges), detector_);
 
-    // Dispatch the message with propagated charges
-    messenger_->dispatchMessage(this, propagated_charge_message, event);
+        // Dispatch the message with propagated charges
+        messenger_->dispatchMessage(this, propagated_charge_message, event);
+    }
+
+    if(transfer_charges_) {
+        // Combine the charges at the same pixel
+        pixel_map.sort();
+        std::vector<PixelCharge> pixel_charges;
+        pixel_charges.reserve(pixel_map.size());
+        for(size_t i = 0; i < pixel_map.size(); ++i) {
+            auto pixel = detector_->getPixel(pixel_map.getIndex(i).x(), pixel_map.getIndex(i).y());
+            pixel_charges.emplace_back(pixel, static_cast<long>(pixel_map.getCharge(i)), pixel_map.getPropagatedCharges(i));
+        }
+
+        LOG(INFO) << "Transferred " << transferred_charges_count << " charges to " << pixel_map.size() << " pixels";
+        total_transferred_charges_ += transferred_charges_count;
+
+        // Dispatch the message with pixel charges
+        auto pixel_message = event->makeShared<PixelChargeMessage>(std::move(pixel_charges), detector_);
+        messenger_->dispatchMessage(this, pixel_message, event);
+    }
+}
+
+/**
+ * Applies the same selection as the SimpleTransfer module: only charges close to the implant side and within the pixel grid
+ * are collected, optionally only those within the implant of their nearest pixel.
+ */
+bool GenericPropagationModule::get_transfer_pixel(const ROOT::Math::XYZPoint& position, Pixel::Index& pixel_index) const {
+    // Ignore if outside depth range of implant
+    if(std::fabs(position.z() - (model_->getSensorCenter().z() + model_->getSensorSize().z() / 2.0)) > max_depth_distance_) {
+        return false;
+    }
+
+    // Ignore if the nearest pixel is outside the pixel grid
+    auto [xpixel, ypixel] = model_->getPixelIndex(position);
+    if(!model_->isWithinPixelGrid(xpixel, ypixel)) {
+        return false;
+    }
+
+    // Ignore if outside the implant region
+    if(collect_from_implant_ && !model_->isWithinImplant(position)) {
+        return false;
+    }
+
+    pixel_index = Pixel::Index(static_cast<unsigned int>(xpixel), static_cast<unsigned int>(ypixel));
+    return true;
 }
 
 /**
@@ -695,52 +1117,69 @@ GenericPropagationModule::propagate(const ROOT::Math::XYZPoint& pos,
                                     const CarrierType& type,
                                     const double initial_time,
                                     RandomNumberGenerator& random_generator,
-                                    OutputPlotPoints& output_plot_points) const {
+                                    OutputPlotPoints& output_plot_points,
+                                    bool* split) const {
     // Create a runge kutta solver using the electric field as step function
     Eigen::Vector3d position(pos.x(), pos.y(), pos.z());
 
+    // Remember the field cells of the previous lookups, as the consecutive positions of the carrier are close to each other
+    FieldCursor efield_cursor;
+    FieldCursor doping_cursor;
+
     // Define a function to compute the diffusion
     auto carrier_diffusion = [&](double efield_mag, double doping_concentration, double timestep) -> Eigen::Vector3d {
         double diffusion_constant = boltzmann_kT_ * mobility_(type, efield_mag, doping_concentration);
         double diffusion_std_dev = std::sqrt(2. * diffusion_constant * timestep);
 
         // Compute the independent diffusion in three
-        allpix::normal_distribution<double> gauss_distribution(0, diffusion_std_dev);
         Eigen::Vector3d diffusion;
-        for(int i = 0; i < 3; ++i) {
-            diffusion[i] = gauss_distribution(random_generator);
-        }
+        allpix::fill_normal<double>(random_generator, diffusion.data(), 3, 0, diffusion_std_dev);
         return diffusion;
     };
 
-    // Survival probability of this charge carrier package, evaluated at every step
+    // Survival of this charge carrier package, evaluated at every step or consuming a survival time drawn once
     std::uniform_real_distribution<double> survival(0, 1);
+    auto survival_time = (sample_survival_time_ ? allpix::exponential_distribution<double>(1)(random_generator) : 0.);
+    auto recombined = [&](double doping, double timestep) {
+        return (sample_survival_time_ ? recombination_.consume(type, doping, survival_time, timestep)
+                                      : recombination_(type, doping, survival(random_generator), timestep));
+    };
 
     // Define lambda functions to compute the charge carrier velocity with or without magnetic field
-    std::function<Eigen::Vector3d(double, const Eigen::Vector3d&)> carrier_velocity_noB =
-        [&](double, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
-        auto raw_field = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+    FieldCursor velocity_cursor;
+    const auto& velocity_grid = velocity_grids_[type == CarrierType::HOLE ? 1 : 0];
+    auto carrier_velocity_noB = [&](double, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
+        if(velocity_grid_) {
+            auto velocity = velocity_grid.get(static_cast<ROOT::Math::XYZPoint>(cur_pos), velocity_cursor);
+            return {velocity.x(), velocity.y(), velocity.z()};
+        }
+
+        auto raw_field = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(cur_pos), efield_cursor);
         Eigen::Vector3d efield(raw_field.x(), raw_field.y(), raw_field.z());
-        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(cur_pos), doping_cursor);
 
         return static_cast<int>(type) * mobility_(type, efield.norm(), doping) * efield;
     };
 
-    std::function<Eigen::Vector3d(double, const Eigen::Vector3d&)> carrier_velocity_withB =
-        [&](double, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
-        auto raw_field = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+    // A uniform magnetic field is only read once, a non-uniform one at every position
+    Eigen::Vector3d uniform_bfield(magnetic_field_.x(), magnetic_field_.y(), magnetic_field_.z());
+    double hallFactor = (type == CarrierType::ELECTRON ? electron_Hall_ : hole_Hall_);
+    auto carrier_velocity_withB = [&](double, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
+        auto raw_field = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(cur_pos), efield_cursor);
         Eigen::Vector3d efield(raw_field.x(), raw_field.y(), raw_field.z());
 
-        Eigen::Vector3d velocity;
-        Eigen::Vector3d bfield(magnetic_field_.x(), magnetic_field_.y(), magnetic_field_.z());
+        Eigen::Vector3d bfield = uniform_bfield;
+        if(!uniform_magnetic_field_) {
+            auto raw_bfield = detector_->getMagneticField(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+            bfield = Eigen::Vector3d(raw_bfield.x(), raw_bfield.y(), raw_bfield.z());
+        }
 
-        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(cur_pos), doping_cursor);
 
         auto mob = mobility_(type, efield.norm(), doping);
         auto exb = efield.cross(bfield);
 
         Eigen::Vector3d term1;
-        double hallFactor = (type == CarrierType::ELECTRON ? electron_Hall_ : hole_Hall_);
         term1 = static_cast<int>(type) * mob * hallFactor * exb;
 
         Eigen::Vector3d term2 = mob * mob * hallFactor * hallFactor * efield.dot(bfield) * bfield;
@@ -750,17 +1189,55 @@ GenericPropagationModule::propagate(const ROOT::Math::XYZPoint& pos,
     };
 
     // Create the runge kutta solver with an RKF5 tableau, using different velocity calculators depending on the magnetic
-    // field
-    auto runge_kutta = make_runge_kutta(
-        tableau::RK5, (has_magnetic_field_ ? carrier_velocity_withB : carrier_velocity_noB), timestep_start_, position);
+    // field. The precomputed drift velocity already includes a uniform magnetic field.
+    auto carrier_velocity = [&](double time, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
+        return (has_magnetic_field_ && !velocity_grid_ ? carrier_velocity_withB(time, cur_pos)
+                                                        : carrier_velocity_noB(time, cur_pos));
+    };
+    auto runge_kutta = make_runge_kutta(static_tableau::RK5(), carrier_velocity, timestep_start_, position);
 
     // Continue propagation until the deposit is outside the sensor
     Eigen::Vector3d last_position = position;
     double last_time = 0;
     size_t next_idx = 0;
     bool is_alive = true;
+    bool unreachable = false;
+    unsigned int steps = 0;
     while(detector_->getModel()->isWithinSensor(static_cast<ROOT::Math::XYZPoint>(position)) &&
           (initial_time + runge_kutta.getTime()) < integration_time_ && is_alive) {
+        // Stop carriers which exhausted their step budget
+        if(max_steps_ > 0 && steps >= max_steps_) {
+            auto point = static_cast<ROOT::Math::XYZPoint>(position);
+            auto remaining_time = integration_time_ - initial_time - runge_kutta.getTime();
+            if(exceed_step_budget(type, point, remaining_time, random_generator)) {
+                is_alive = !recombined(detector_->getDopingConcentration(point, doping_cursor), remaining_time);
+                return std::make_tuple(point, integration_time_, is_alive);
+            }
+            return std::make_tuple(point, initial_time + runge_kutta.getTime(), is_alive);
+        }
+
+        // Stop carriers which cannot arrive at the implants any more within the integration time
+        if(terminate_unreachable_ &&
+           !is_reachable(type, position.z(), integration_time_ - initial_time - runge_kutta.getTime())) {
+            unreachable = true;
+            break;
+        }
+
+        // Stop the set if it has to be split into smaller sets at its current position
+        if(split != nullptr) {
+            auto point = static_cast<ROOT::Math::XYZPoint>(position);
+            if(near_pixel_boundary(type,
+                                   point,
+                                   detector_->getElectricField(point, efield_cursor),
+                                   detector_->getDopingConcentration(point, doping_cursor),
+                                   integration_time_ - initial_time - runge_kutta.getTime())) {
+                *split = true;
+                LOG(TRACE) << "Splitting set of charges close to the pixel boundary at "
+                           << Units::display(point, {"um", "mm"});
+                return std::make_tuple(point, initial_time + runge_kutta.getTime(), true);
+            }
+        }
+
         // Update output plots if necessary (depending on the plot step)
         if(output_linegraphs_) {
             auto time_idx = static_cast<size_t>(runge_kutta.getTime() / output_plots_step_);
@@ -776,14 +1253,15 @@ GenericPropagationModule::propagate(const ROOT::Math::XYZPoint& pos,
 
         // Execute a Runge Kutta step
         auto step = runge_kutta.step();
+        ++steps;
 
         // Get the current result and timestep
         auto timestep = runge_kutta.getTimeStep();
         position = runge_kutta.getValue();
 
         // Get electric field at current position and fall back to empty field if it does not exist
-        auto efield = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(position));
-        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(position));
+        auto efield = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(position), efield_cursor);
+        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(position), doping_cursor);
 
         // Apply diffusion step
         auto diffusion = carrier_diffusion(std::sqrt(efield.Mag2()), doping, timestep);
@@ -791,10 +1269,8 @@ GenericPropagationModule::propagate(const ROOT::Math::XYZPoint& pos,
         runge_kutta.setValue(position);
 
         // Check if charge carrier is still alive:
-        is_alive = !recombination_(type,
-                                   detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(position)),
-                                   survival(random_generator),
-                                   timestep);
+        is_alive = !recombined(
+            detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(position), doping_cursor), timestep);
 
         LOG(TRACE) << "Step from " << Units::display(static_cast<ROOT::Math::XYZPoint>(last_position), {"um", "mm"})
                    << " to " << Units::display(static_cast<ROOT::Math::XYZPoint>(position), {"um", "mm"}) << " at "
@@ -805,8 +1281,8 @@ GenericPropagationModule::propagate(const ROOT::Math::XYZPoint& pos,
 
         // Update step length histogram
         if(output_plots_) {
-            step_length_histo_->Fill(static_cast<double>(Units::convert(step.value.norm(), "um")));
-            uncertainty_histo_->Fill(static_cast<double>(Units::convert(step.error.norm(), "nm")));
+            step_length_histo_->Fill(step.value.norm() / units::um);
+            uncertainty_histo_->Fill(step.error.norm() / units::nm);
         }
 
         // Lower timestep when reaching the sensor edge
@@ -828,6 +1304,16 @@ GenericPropagationModule::propagate(const ROOT::Math::XYZPoint& pos,
         runge_kutta.setTimeStep(timestep);
     }
 
+    // Carriers out of reach stay in place until the end of the integration time, recombining with the same probability
+    if(unreachable) {
+        auto remaining_time = integration_time_ - initial_time - runge_kutta.getTime();
+        is_alive = !recombined(
+            detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(position), doping_cursor), remaining_time);
+        LOG(DEBUG) << "Charge carrier cannot reach the implant side, terminated after "
+                   << Units::display(runge_kutta.getTime(), {"ns"});
+        return std::make_tuple(static_cast<ROOT::Math::XYZPoint>(position), integration_time_, is_alive);
+    }
+
     // Find proper final position in the sensor
     auto time = runge_kutta.getTime();
     if(!detector_->getModel()->isWithinSensor(static_cast<ROOT::Math::XYZPoint>(position))) {
@@ -863,6 +1349,476 @@ GenericPropagationModule::propagate(const ROOT::Math::XYZPoint& pos,
     return std::make_tuple(static_cast<ROOT::Math::XYZPoint>(position), initial_time + time, is_alive);
 }
 
+/**
+ * The set is propagated as a whole until its diffusion until the end of the propagation could carry it across a pixel
+ * boundary. From this point, the carriers are divided into sets of the configured smaller size, which are propagated
+ * independently with their own diffusion. The diffusion before the split is shared by all of them, which is why the split
+ * distance is given in units of the diffusion still ahead. Since the survival time is exponentially distributed, it is
+ * drawn again for every smaller set without changing the recombination statistics.
+ */
+std::vector<std::pair<PropagationResult, unsigned int>>
+GenericPropagationModule::propagate_split(const ROOT::Math::XYZPoint& pos,
+                                          const CarrierType& type,
+                                          const double initial_time,
+                                          unsigned int charge,
+                                          RandomNumberGenerator& random_generator,
+                                          OutputPlotPoints& output_plot_points) const {
+    std::vector<std::pair<PropagationResult, unsigned int>> results;
+    bool split = false;
+    auto result = propagate(pos, type, initial_time, random_generator, output_plot_points, &split);
+    if(!split) {
+        results.emplace_back(result, charge);
+        return results;
+    }
+
+    const auto& split_position = std::get<0>(result);
+    auto split_time = std::get<1>(result);
+    while(charge > 0) {
+        auto group = std::min(charge, split_charge_per_step_);
+        charge -= group;
+        results.emplace_back(propagate(split_position, type, split_time, random_generator, output_plot_points), group);
+    }
+    return results;
+}
+
+/**
+ * The distance to the closest boundary of the pixel cell is compared to the width of the diffusion expected until the end
+ * of the propagation. The remaining time is estimated from the drift along the sensor thickness at the local velocity,
+ * limited by the time left within the integration time.
+ */
+bool GenericPropagationModule::near_pixel_boundary(const CarrierType& type,
+                                                   const ROOT::Math::XYZPoint& position,
+                                                   const ROOT::Math::XYZVector& efield,
+                                                   double doping,
+                                                   double remaining_time) const {
+    auto pitch = model_->getPixelSize();
+    auto origin = model_->getPixelCenter(0, 0);
+    auto [xpixel, ypixel] = model_->getPixelIndex(position);
+    auto distance = std::min(pitch.x() / 2 - std::fabs(position.x() - origin.x() - xpixel * pitch.x()),
+                             pitch.y() / 2 - std::fabs(position.y() - origin.y() - ypixel * pitch.y()));
+
+    auto mobility = mobility_(type, std::sqrt(efield.Mag2()), doping);
+    auto velocity = static_cast<int>(type) * mobility * efield.z();
+    auto surface = model_->getSensorSize().z() / 2;
+    auto depth = (velocity > 0 ? surface - position.z() : position.z() + surface);
+    if(std::fabs(velocity) > 0) {
+        remaining_time = std::min(remaining_time, depth / std::fabs(velocity));
+    }
+    auto diffusion_std_dev = std::sqrt(2. * boltzmann_kT_ * mobility * std::max(remaining_time, 0.));
+    return distance < split_distance_ * diffusion_std_dev;
+}
+
+/**
+ * Sets stopped in a field below the threshold are only subject to diffusion for the remaining integration time, which is
+ * applied as a single Gaussian step with the width accumulated over this time. Sets which would diffuse out of the sensor
+ * stay at their position. Sets stopped in a higher field are terminated at their current position.
+ */
+bool GenericPropagationModule::exceed_step_budget(const CarrierType& type,
+                                                  ROOT::Math::XYZPoint& position,
+                                                  double remaining_time,
+                                                  RandomNumberGenerator& random_generator) const {
+    total_exceeded_step_budget_++;
+    auto efield_mag = std::sqrt(detector_->getElectricField(position).Mag2());
+    if(efield_mag >= diffusion_field_threshold_) {
+        LOG(DEBUG) << "Set of charges exceeded the step budget in a field of " << Units::display(efield_mag, "V/cm")
+                   << ", terminated at " << Units::display(position, {"um", "mm"});
+        return false;
+    }
+
+    auto doping = detector_->getDopingConcentration(position);
+    auto diffusion_constant = boltzmann_kT_ * mobility_(type, efield_mag, doping);
+    std::array<double, 3> diffusion{};
+    allpix::fill_normal<double>(random_generator,
+                                diffusion.data(),
+                                diffusion.size(),
+                                0,
+                                std::sqrt(2. * diffusion_constant * std::max(remaining_time, 0.)));
+    auto target = position + ROOT::Math::XYZVector(diffusion[0], diffusion[1], diffusion[2]);
+    if(model_->isWithinSensor(target)) {
+        position = target;
+    }
+    LOG(DEBUG) << "Set of charges exceeded the step budget in low field, diffused over the remaining "
+               << Units::display(remaining_time, {"ns", "ps"}) << " to " << Units::display(position, {"um", "mm"});
+    total_diffusion_jumps_++;
+    return true;
+}
+
+/**
+ * The batch follows the same sequence of operations as \ref GenericPropagationModule::propagate for every set, with each set
+ * using its own random number generator. Results therefore do not depend on the batch size or the order of the sets.
+ *
+ * In single precision, the positions are stored relative to the start position of every set, such that the precision of
+ * the Runge-Kutta steps does not depend on the position in the sensor. Field lookups, the mobility and the time of every set
+ * are still evaluated in double precision. In double precision, the origin of all sets is zero and the arithmetic is
+ * identical to the propagation of a single set.
+ */
+template <typename Scalar>
+void GenericPropagationModule::propagate_batch(const CarrierType& type,
+                                               const std::vector<ChargeSet>& charge_sets,
+                                               const std::vector<uint64_t>& seeds,
+                                               RandomNumberGenerator::Engine engine,
+                                               size_t begin,
+                                               size_t end,
+                                               std::vector<PropagationResult>& results) const {
+    using Eigen::ArrayXd;
+    using Array = Eigen::Array<Scalar, Eigen::Dynamic, 1>;
+    constexpr bool relative_positions = !std::is_same<Scalar, double>::value;
+    const auto batch_size = static_cast<Eigen::Index>(propagation_batch_size_);
+    using Tableau = static_tableau::RK5;
+    constexpr std::size_t stages = Tableau::stages;
+    const auto sign = static_cast<Scalar>(static_cast<int>(type));
+
+    // State of every lane of the batch, with the positions relative to the origin of the lane
+    ArrayXd origin_x = ArrayXd::Zero(batch_size), origin_y = ArrayXd::Zero(batch_size), origin_z = ArrayXd::Zero(batch_size);
+    Array x(batch_size), y(batch_size), z(batch_size);
+    Array last_x(batch_size), last_y(batch_size), last_z(batch_size);
+    ArrayXd time(batch_size), last_time(batch_size), initial_time(batch_size);
+    Array timestep(batch_size);
+    ArrayXd survival_time(batch_size);
+    Eigen::Array<bool, Eigen::Dynamic, 1> alive(batch_size);
+    Eigen::Array<unsigned int, Eigen::Dynamic, 1> steps(batch_size);
+    std::vector<size_t> set_idx(static_cast<size_t>(batch_size));
+    std::vector<RandomNumberGenerator> random_generators(static_cast<size_t>(batch_size), RandomNumberGenerator(engine));
+
+    // Intermediate positions and velocities of the Runge-Kutta stages and the resulting step and error
+    Array yt_x(batch_size), yt_y(batch_size), yt_z(batch_size);
+    std::array<Array, stages> k_x, k_y, k_z;
+    for(std::size_t i = 0; i < stages; ++i) {
+        k_x[i].resize(batch_size);
+        k_y[i].resize(batch_size);
+        k_z[i].resize(batch_size);
+    }
+    Array ys_x(batch_size), ys_y(batch_size), ys_z(batch_size);
+    Array yse_x(batch_size), yse_y(batch_size), yse_z(batch_size);
+
+    // Field values and mobility at the intermediate positions
+    Array efield_x(batch_size), efield_y(batch_size), efield_z(batch_size);
+    ArrayXd efield_mag(batch_size), doping(batch_size), mobility(batch_size);
+    Array bfield_x(batch_size), bfield_y(batch_size), bfield_z(batch_size);
+    std::vector<ROOT::Math::XYZPoint> field_positions(static_cast<size_t>(batch_size));
+    std::vector<ROOT::Math::XYZVector> raw_fields(static_cast<size_t>(batch_size));
+
+    // Absolute position of a lane in local coordinates
+    auto local_position = [&](Eigen::Index lane, Scalar rel_x, Scalar rel_y, Scalar rel_z) {
+        return ROOT::Math::XYZPoint(origin_x[lane] + rel_x, origin_y[lane] + rel_y, origin_z[lane] + rel_z);
+    };
+
+    // Compute the charge carrier velocity for the first lanes, with or without magnetic field
+    const auto& velocity_grid = velocity_grids_[type == CarrierType::HOLE ? 1 : 0];
+    auto carrier_velocity = [&](Eigen::Index lanes, Array& v_x, Array& v_y, Array& v_z) {
+        for(Eigen::Index lane = 0; lane < lanes; ++lane) {
+            field_positions[static_cast<size_t>(lane)] = local_position(lane, yt_x[lane], yt_y[lane], yt_z[lane]);
+        }
+
+        // Read the precomputed drift velocity, without evaluating the doping and the mobility
+        if(velocity_grid_) {
+            velocity_grid.get(field_positions.data(), raw_fields.data(), static_cast<size_t>(lanes));
+            for(Eigen::Index lane = 0; lane < lanes; ++lane) {
+                const auto& velocity = raw_fields[static_cast<size_t>(lane)];
+                v_x[lane] = static_cast<Scalar>(velocity.x());
+                v_y[lane] = static_cast<Scalar>(velocity.y());
+                v_z[lane] = static_cast<Scalar>(velocity.z());
+            }
+            return;
+        }
+
+        detector_->getElectricField(field_positions.data(), raw_fields.data(), static_cast<size_t>(lanes));
+        detector_->getDopingConcentration(field_positions.data(), doping.data(), static_cast<size_t>(lanes));
+        for(Eigen::Index lane = 0; lane < lanes; ++lane) {
+            const auto& raw_field = raw_fields[static_cast<size_t>(lane)];
+            efield_x[lane] = static_cast<Scalar>(raw_field.x());
+            efield_y[lane] = static_cast<Scalar>(raw_field.y());
+            efield_z[lane] = static_cast<Scalar>(raw_field.z());
+        }
+        auto e_x = efield_x.head(lanes);
+        auto e_y = efield_y.head(lanes);
+        auto e_z = efield_z.head(lanes);
+        efield_mag.head(lanes) = (e_x.square() + e_y.square() + e_z.square()).sqrt().template cast<double>();
+        mobility_.evaluate(type, efield_mag.data(), doping.data(), mobility.data(), static_cast<size_t>(lanes));
+
+        Array mob = mobility.head(lanes).template cast<Scalar>();
+        if(!has_magnetic_field_) {
+            v_x.head(lanes) = sign * mob * e_x;
+            v_y.head(lanes) = sign * mob * e_y;
+            v_z.head(lanes) = sign * mob * e_z;
+            return;
+        }
+
+        // Look up a non-uniform magnetic field for every lane, a uniform one is set for all lanes once
+        if(!uniform_magnetic_field_) {
+            for(Eigen::Index lane = 0; lane < lanes; ++lane) {
+                auto raw_bfield = detector_->getMagneticField(field_positions[static_cast<size_t>(lane)]);
+                bfield_x[lane] = static_cast<Scalar>(raw_bfield.x());
+                bfield_y[lane] = static_cast<Scalar>(raw_bfield.y());
+                bfield_z[lane] = static_cast<Scalar>(raw_bfield.z());
+            }
+        }
+
+        auto hall_factor = static_cast<Scalar>(type == CarrierType::ELECTRON ? electron_Hall_ : hole_Hall_);
+        auto b_x = bfield_x.head(lanes);
+        auto b_y = bfield_y.head(lanes);
+        auto b_z = bfield_z.head(lanes);
+        Array term_factor = mob * mob * hall_factor * hall_factor;
+        Array e_dot_b = e_x * b_x + e_y * b_y + e_z * b_z;
+        Array rnorm = Scalar(1) + term_factor * (b_x * b_x + b_y * b_y + b_z * b_z);
+        v_x.head(lanes) =
+            sign * mob * (e_x + sign * mob * hall_factor * (e_y * b_z - e_z * b_y) + term_factor * e_dot_b * b_x) / rnorm;
+        v_y.head(lanes) =
+            sign * mob * (e_y + sign * mob * hall_factor * (e_z * b_x - e_x * b_z) + term_factor * e_dot_b * b_y) / rnorm;
+        v_z.head(lanes) =
+            sign * mob * (e_z + sign * mob * hall_factor * (e_x * b_y - e_y * b_x) + term_factor * e_dot_b * b_z) / rnorm;
+    };
+
+    if(uniform_magnetic_field_) {
+        bfield_x.setConstant(static_cast<Scalar>(magnetic_field_.x()));
+        bfield_y.setConstant(static_cast<Scalar>(magnetic_field_.y()));
+        bfield_z.setConstant(static_cast<Scalar>(magnetic_field_.z()));
+    }
+
+    // Load the next set of charges of the requested type into a lane
+    size_t next = begin;
+    auto load_lane = [&](Eigen::Index lane) {
+        while(next < end && charge_sets[next].first->getType() != type) {
+            ++next;
+        }
+        if(next == end) {
+            return false;
+        }
+
+        const auto& deposit = *charge_sets[next].first;
+        auto position = deposit.getLocalPosition();
+        if constexpr(relative_positions) {
+            origin_x[lane] = position.x();
+            origin_y[lane] = position.y();
+            origin_z[lane] = position.z();
+            x[lane] = y[lane] = z[lane] = 0;
+        } else {
+            x[lane] = static_cast<Scalar>(position.x());
+            y[lane] = static_cast<Scalar>(position.y());
+            z[lane] = static_cast<Scalar>(position.z());
+        }
+        last_x[lane] = x[lane];
+        last_y[lane] = y[lane];
+        last_z[lane] = z[lane];
+        time[lane] = last_time[lane] = 0;
+        timestep[lane] = static_cast<Scalar>(timestep_start_);
+        initial_time[lane] = deposit.getLocalTime();
+        alive[lane] = true;
+        steps[lane] = 0;
+        set_idx[static_cast<size_t>(lane)] = next;
+        random_generators[static_cast<size_t>(lane)].seed(seeds[next]);
+        if(sample_survival_time_) {
+            survival_time[lane] =
+                allpix::exponential_distribution<double>(1)(random_generators[static_cast<size_t>(lane)]);
+        }
+        ++next;
+        return true;
+    };
+
+    // Move the state of a lane to another lane
+    auto move_lane = [&](Eigen::Index from, Eigen::Index to) {
+        origin_x[to] = origin_x[from];
+        origin_y[to] = origin_y[from];
+        origin_z[to] = origin_z[from];
+        x[to] = x[from];
+        y[to] = y[from];
+        z[to] = z[from];
+        last_x[to] = last_x[from];
+        last_y[to] = last_y[from];
+        last_z[to] = last_z[from];
+        time[to] = time[from];
+        last_time[to] = last_time[from];
+        timestep[to] = timestep[from];
+        initial_time[to] = initial_time[from];
+        survival_time[to] = survival_time[from];
+        alive[to] = alive[from];
+        steps[to] = steps[from];
+        set_idx[static_cast<size_t>(to)] = set_idx[static_cast<size_t>(from)];
+        std::swap(random_generators[static_cast<size_t>(to)], random_generators[static_cast<size_t>(from)]);
+    };
+
+    // Store the result of a lane which finished propagation
+    auto finish_lane = [&](Eigen::Index lane) {
+        auto current = local_position(lane, x[lane], y[lane], z[lane]);
+        auto last = local_position(lane, last_x[lane], last_y[lane], last_z[lane]);
+        Eigen::Vector3d position(current.x(), current.y(), current.z());
+        Eigen::Vector3d last_position(last.x(), last.y(), last.z());
+        auto final_time = time[lane];
+
+        // Find proper final position in the sensor
+        if(!model_->isWithinSensor(static_cast<ROOT::Math::XYZPoint>(position))) {
+            auto check_position = position;
+            check_position.z() = last_position.z();
+            if(position.z() > 0 && model_->isWithinSensor(static_cast<ROOT::Math::XYZPoint>(check_position))) {
+                // Carrier left sensor on the side of the pixel grid, interpolate end point on surface
+                auto z_cur_border = std::fabs(position.z() - model_->getSensorSize().z() / 2.0);
+                auto z_last_border = std::fabs(model_->getSensorSize().z() / 2.0 - last_position.z());
+                auto z_total = z_cur_border + z_last_border;
+                position = (z_last_border / z_total) * position + (z_cur_border / z_total) * last_position;
+                final_time = (z_last_border / z_total) * final_time + (z_cur_border / z_total) * last_time[lane];
+            } else {
+                // Carrier left sensor on any order border, use last position inside instead
+                position = last_position;
+                final_time = last_time[lane];
+            }
+        }
+
+        if(!alive[lane]) {
+            LOG(DEBUG) << "Charge carrier recombined after " << Units::display(last_time[lane], {"ns"});
+        }
+        results[set_idx[static_cast<size_t>(lane)]] =
+            std::make_tuple(static_cast<ROOT::Math::XYZPoint>(position), initial_time[lane] + final_time, alive[lane]);
+    };
+
+    // Fill the batch and continue until all sets of the block are propagated
+    Eigen::Index lanes = 0;
+    while(lanes < batch_size && load_lane(lanes)) {
+        ++lanes;
+    }
+    std::uniform_real_distribution<double> survival(0, 1);
+    auto recombined = [&](Eigen::Index lane, double timestep) {
+        auto doping = detector_->getDopingConcentration(local_position(lane, x[lane], y[lane], z[lane]));
+        return (sample_survival_time_
+                    ? recombination_.consume(type, doping, survival_time[lane], timestep)
+                    : recombination_(type, doping, survival(random_generators[static_cast<size_t>(lane)]), timestep));
+    };
+    while(lanes > 0) {
+        // Retire all lanes which finished propagation and refill them with the next sets
+        for(Eigen::Index lane = 0; lane < lanes;) {
+            auto position = local_position(lane, x[lane], y[lane], z[lane]);
+            if(model_->isWithinSensor(position) && (initial_time[lane] + time[lane]) < integration_time_ && alive[lane]) {
+                auto remaining_time = integration_time_ - initial_time[lane] - time[lane];
+                if(max_steps_ > 0 && steps[lane] >= max_steps_) {
+                    // Carriers which exhausted their step budget
+                    if(exceed_step_budget(type, position, remaining_time, random_generators[static_cast<size_t>(lane)])) {
+                        x[lane] = static_cast<Scalar>(position.x() - origin_x[lane]);
+                        y[lane] = static_cast<Scalar>(position.y() - origin_y[lane]);
+                        z[lane] = static_cast<Scalar>(position.z() - origin_z[lane]);
+                        alive[lane] = !recombined(lane, remaining_time);
+                        results[set_idx[static_cast<size_t>(lane)]] =
+                            std::make_tuple(position, integration_time_, alive[lane]);
+                    } else {
+                        results[set_idx[static_cast<size_t>(lane)]] =
+                            std::make_tuple(position, initial_time[lane] + time[lane], alive[lane]);
+                    }
+                } else if(!terminate_unreachable_ || is_reachable(type, position.z(), remaining_time)) {
+                    ++lane;
+                    continue;
+                } else {
+                    // Carriers out of reach stay in place until the end of the integration time
+                    alive[lane] = !recombined(lane, remaining_time);
+                    results[set_idx[static_cast<size_t>(lane)]] =
+                        std::make_tuple(position, integration_time_, alive[lane]);
+                }
+            } else {
+                finish_lane(lane);
+            }
+            if(!load_lane(lane)) {
+                --lanes;
+                if(lane != lanes) {
+                    move_lane(lanes, lane);
+                }
+            }
+        }
+        if(lanes == 0) {
+            break;
+        }
+
+        // Save previous position and time
+        last_x.head(lanes) = x.head(lanes);
+        last_y.head(lanes) = y.head(lanes);
+        last_z.head(lanes) = z.head(lanes);
+        last_time.head(lanes) = time.head(lanes);
+
+        // Execute a Runge Kutta step for all lanes
+        ys_x.head(lanes).setZero();
+        ys_y.head(lanes).setZero();
+        ys_z.head(lanes).setZero();
+        yse_x.head(lanes).setZero();
+        yse_y.head(lanes).setZero();
+        yse_z.head(lanes).setZero();
+        for(std::size_t i = 0; i < stages; ++i) {
+            yt_x.head(lanes) = x.head(lanes);
+            yt_y.head(lanes) = y.head(lanes);
+            yt_z.head(lanes) = z.head(lanes);
+            for(std::size_t j = 0; j < i; ++j) {
+                auto coefficient = static_cast<Scalar>(Tableau::values[i][j]);
+                yt_x.head(lanes) += timestep.head(lanes) * coefficient * k_x[j].head(lanes);
+                yt_y.head(lanes) += timestep.head(lanes) * coefficient * k_y[j].head(lanes);
+                yt_z.head(lanes) += timestep.head(lanes) * coefficient * k_z[j].head(lanes);
+            }
+            carrier_velocity(lanes, k_x[i], k_y[i], k_z[i]);
+
+            auto coefficient = static_cast<Scalar>(Tableau::values[stages][i]);
+            auto error_coefficient = static_cast<Scalar>(Tableau::values[stages + 1][i]);
+            ys_x.head(lanes) += timestep.head(lanes) * coefficient * k_x[i].head(lanes);
+            ys_y.head(lanes) += timestep.head(lanes) * coefficient * k_y[i].head(lanes);
+            ys_z.head(lanes) += timestep.head(lanes) * coefficient * k_z[i].head(lanes);
+            yse_x.head(lanes) += timestep.head(lanes) * error_coefficient * k_x[i].head(lanes);
+            yse_y.head(lanes) += timestep.head(lanes) * error_coefficient * k_y[i].head(lanes);
+            yse_z.head(lanes) += timestep.head(lanes) * error_coefficient * k_z[i].head(lanes);
+        }
+        x.head(lanes) += ys_x.head(lanes);
+        y.head(lanes) += ys_y.head(lanes);
+        z.head(lanes) += ys_z.head(lanes);
+        time.head(lanes) += timestep.head(lanes).template cast<double>();
+        steps.head(lanes) += 1;
+
+        // Get electric field and mobility at the current positions of all lanes
+        for(Eigen::Index lane = 0; lane < lanes; ++lane) {
+            field_positions[static_cast<size_t>(lane)] = local_position(lane, x[lane], y[lane], z[lane]);
+        }
+        detector_->getElectricField(field_positions.data(), raw_fields.data(), static_cast<size_t>(lanes));
+        detector_->getDopingConcentration(field_positions.data(), doping.data(), static_cast<size_t>(lanes));
+        for(Eigen::Index lane = 0; lane < lanes; ++lane) {
+            efield_mag[lane] = std::sqrt(raw_fields[static_cast<size_t>(lane)].Mag2());
+        }
+        mobility_.evaluate(type, efield_mag.data(), doping.data(), mobility.data(), static_cast<size_t>(lanes));
+
+        // Apply diffusion, recombination and the timestep adaptation for every lane
+        for(Eigen::Index lane = 0; lane < lanes; ++lane) {
+            auto& random_generator = random_generators[static_cast<size_t>(lane)];
+            auto cur_timestep = static_cast<double>(timestep[lane]);
+
+            // Apply diffusion step
+            double diffusion_constant = boltzmann_kT_ * mobility[lane];
+            std::array<double, 3> diffusion{};
+            allpix::fill_normal<double>(
+                random_generator, diffusion.data(), diffusion.size(), 0, std::sqrt(2. * diffusion_constant * cur_timestep));
+            x[lane] += static_cast<Scalar>(diffusion[0]);
+            y[lane] += static_cast<Scalar>(diffusion[1]);
+            z[lane] += static_cast<Scalar>(diffusion[2]);
+
+            // Check if charge carrier is still alive:
+            alive[lane] = !recombined(lane, cur_timestep);
+
+            // Adapt step size to match target precision
+            Eigen::Vector3d step_value(ys_x[lane], ys_y[lane], ys_z[lane]);
+            Eigen::Vector3d step_error = step_value - Eigen::Vector3d(yse_x[lane], yse_y[lane], yse_z[lane]);
+            double uncertainty = step_error.norm();
+
+            // Update step length histogram
+            if(output_plots_) {
+                step_length_histo_->Fill(step_value.norm() / units::um);
+                uncertainty_histo_->Fill(uncertainty / units::nm);
+            }
+
+            // Lower timestep when reaching the sensor edge
+            if(std::fabs(model_->getSensorSize().z() / 2.0 - (origin_z[lane] + z[lane])) < 2 * step_value.z()) {
+                cur_timestep *= 0.75;
+            } else {
+                if(uncertainty > target_spatial_precision_) {
+                    cur_timestep *= 0.75;
+                } else if(2 * uncertainty < target_spatial_precision_) {
+                    cur_timestep *= 1.5;
+                }
+            }
+            // Limit the timestep to certain minimum and maximum step sizes
+            timestep[lane] = static_cast<Scalar>(std::min(std::max(cur_timestep, timestep_min_), timestep_max_));
+        }
+    }
+}
+
 void GenericPropagationModule::finalize() {
     if(output_plots_) {
         step_length_histo_->Write();
@@ -876,4 +1832,19 @@ void GenericPropagationModule::finalize() {
                                std::max(1u, static_cast<unsigned int>(total_propagated_charges_));
     LOG(INFO) << "Propagated total of " << total_propagated_charges_ << " charges in " << total_steps_
               << " steps in average time of " << Units::display(average_time, "ns");
+    if(total_charge_sets_ < total_unmerged_charge_sets_) {
+        LOG(INFO) << "Propagated " << total_charge_sets_ << " sets of charges instead of " << total_unmerged_charge_sets_
+                  << " by merging deposits and enlarging sets";
+    }
+    if(max_steps_ > 0) {
+        LOG(INFO) << "Stopped " << total_exceeded_step_budget_ << " sets of charges after " << max_steps_ << " steps, "
+                  << total_diffusion_jumps_ << " of them diffused over the remaining integration time in low field";
+    }
+    if(split_charge_per_step_ > 0) {
+        LOG(INFO) << "Split " << total_split_charge_sets_ << " of " << total_charge_sets_
+                  << " sets of charges close to the pixel boundaries";
+    }
+    if(transfer_charges_) {
+        LOG(INFO) << "Transferred total of " << total_transferred_charges_ << " charges";
+    }
 }
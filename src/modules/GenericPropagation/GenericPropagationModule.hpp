@@ -7,10 +7,13 @@
  * Intergovernmental Organization or submit itself to any jurisdiction.
  */
 
+#include <array>
 #include <atomic>
 #include <memory>
 #include <random>
 #include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 #include <Math/Point3D.h>
@@ -18,21 +21,26 @@
 #include <TH1D.h>
 
 #include "core/config/Configuration.hpp"
+#include "core/geometry/DetectorField.hpp"
 #include "core/geometry/DetectorModel.hpp"
 #include "core/messenger/Messenger.hpp"
 #include "core/module/Event.hpp"
 #include "core/module/Module.hpp"
 
 #include "objects/DepositedCharge.hpp"
+#include "objects/Pixel.hpp"
 #include "objects/PropagatedCharge.hpp"
 
 #include "physics/Mobility.hpp"
 #include "physics/Recombination.hpp"
 
 #include "tools/ROOT.h"
+#include "tools/charge_groups.h"
 
 namespace allpix {
     using OutputPlotPoints = std::vector<std::pair<PropagatedCharge, std::vector<ROOT::Math::XYZPoint>>>;
+    using ChargeSet = ChargeGroup;
+    using PropagationResult = std::tuple<ROOT::Math::XYZPoint, double, bool>;
 
     /**
      * @ingroup Modules
@@ -88,6 +96,7 @@ namespace allpix {
          * @param initial_time Initial time passed before propagation starts in local time coordinates
          * @param random_generator Reference to the random number engine to be used
          * @param output_plot_points Reference to vector to hold points for line graph output plots
+         * @param split Flag set if the propagation stopped since the set has to be split, only checked if given
          * @return Tuple with the point where the deposit ended after propagation, the time the propagation took and a flag
          * whether it has recombined
          */
@@ -95,19 +104,156 @@ namespace allpix {
                                                                  const CarrierType& type,
                                                                  const double initial_time,
                                                                  RandomNumberGenerator& random_generator,
-                                                                 OutputPlotPoints& output_plot_points) const;
+                                                                 OutputPlotPoints& output_plot_points,
+                                                                 bool* split = nullptr) const;
+
+        /**
+         * @brief Propagate a set of charges, splitting it into smaller sets when approaching a pixel boundary
+         * @param pos Position of the deposit in the sensor
+         * @param type Type of the carrier to propagate
+         * @param initial_time Initial time passed before propagation starts in local time coordinates
+         * @param charge Number of charge carriers in the set
+         * @param random_generator Reference to the random number engine to be used
+         * @param output_plot_points Reference to vector to hold points for line graph output plots
+         * @return Propagation result of every set the charges ended in together with its number of charge carriers
+         */
+        std::vector<std::pair<PropagationResult, unsigned int>>
+        propagate_split(const ROOT::Math::XYZPoint& pos,
+                        const CarrierType& type,
+                        const double initial_time,
+                        unsigned int charge,
+                        RandomNumberGenerator& random_generator,
+                        OutputPlotPoints& output_plot_points) const;
+
+        /**
+         * @brief Handle a set of charges which exhausted its step budget
+         * @param type Type of the charge carriers
+         * @param position Position of the set in local coordinates, updated by the diffusion over the remaining time
+         * @param remaining_time Time left until the end of the integration time
+         * @param random_generator Reference to the random number engine to be used
+         * @return True if the set diffused over the remaining time in low field, false if it is terminated in place
+         */
+        bool exceed_step_budget(const CarrierType& type,
+                                ROOT::Math::XYZPoint& position,
+                                double remaining_time,
+                                RandomNumberGenerator& random_generator) const;
+
+        /**
+         * @brief Check if the diffusion of a set of charges can carry it across the boundary of its pixel cell
+         * @param type Type of the charge carriers
+         * @param position Current position of the set in local coordinates
+         * @param efield Electric field at the position
+         * @param doping Doping concentration at the position
+         * @param remaining_time Time left until the end of the integration time
+         * @return True if the boundary is closer than the split distance in units of the remaining diffusion width
+         */
+        bool near_pixel_boundary(const CarrierType& type,
+                                 const ROOT::Math::XYZPoint& position,
+                                 const ROOT::Math::XYZVector& efield,
+                                 double doping,
+                                 double remaining_time) const;
+
+        /**
+         * @brief Propagate a block of sets of charges of the same type through the sensor in lockstep
+         * @tparam Scalar Floating point type of the positions, velocities and timesteps of the Runge-Kutta integration
+         * @param type Type of the carriers to propagate, sets of other types in the block are skipped
+         * @param charge_sets List of all sets of charges
+         * @param seeds Random seed for every set of charges
+         * @param engine Engine of the random number generators seeded for every set
+         * @param begin Index of the first set of the block
+         * @param end Index past the last set of the block
+         * @param results List to store the final position, the propagation time and the survival flag of every set in
+         *
+         * The state of all propagated sets is stored as structure of arrays, advancing all of them with the same Runge-Kutta
+         * stages and evaluating the mobility for the full batch at once. Sets leaving the sensor are replaced by the next
+         * set of the block.
+         */
+        template <typename Scalar>
+        void propagate_batch(const CarrierType& type,
+                             const std::vector<ChargeSet>& charge_sets,
+                             const std::vector<uint64_t>& seeds,
+                             RandomNumberGenerator::Engine engine,
+                             size_t begin,
+                             size_t end,
+                             std::vector<PropagationResult>& results) const;
+
+        /**
+         * @brief Find the pixel collecting the charges at the end of their propagation
+         * @param position Final position of the charges in local coordinates
+         * @param pixel_index Index of the collecting pixel, only set if the charges are collected
+         * @return True if the charges are collected by a pixel, false otherwise
+         */
+        bool get_transfer_pixel(const ROOT::Math::XYZPoint& position, Pixel::Index& pixel_index) const;
+
+        /**
+         * @brief Tabulate the bound on the time needed to reach the implant side from every depth of the sensor
+         */
+        void create_reachability_table();
+
+        /**
+         * @brief Check if charge carriers at a given depth can possibly reach the implant side in the remaining time
+         * @param type Type of the charge carriers
+         * @param z Depth of the charge carriers in local coordinates
+         * @param remaining_time Time left until the end of the integration time
+         * @return False if the implant side is certainly out of reach, true otherwise
+         */
+        bool is_reachable(const CarrierType& type, double z, double remaining_time) const;
+
+        /**
+         * @brief Depth bin above the bin of a charge carrier on the way to the implant side
+         *
+         * The bins above a start bin are sorted by decreasing slowness, such that the diffusion of the carriers can be
+         * credited to the slowest bins. Length and time are the sums over all bins before this one, bins without any drift
+         * do not contribute to the time.
+         */
+        struct ReachabilityStep {
+            double slowness;
+            double length;
+            double time;
+        };
 
         // Local copies of configuration parameters to avoid costly lookup:
         double temperature_{}, timestep_min_{}, timestep_max_{}, timestep_start_{}, integration_time_{},
             target_spatial_precision_{}, output_plots_step_{};
         bool output_plots_{}, output_linegraphs_{}, output_animations_{}, output_plots_lines_at_implants_{};
         bool propagate_electrons_{}, propagate_holes_{};
-        unsigned int charge_per_step_{};
+        unsigned int charge_per_step_{}, max_charge_groups_{};
+        double merge_distance_{};
+        unsigned int split_charge_per_step_{};
+        double split_distance_{};
+        bool parallel_propagation_{};
+        unsigned int propagation_batch_size_{};
+        FieldPrecision propagation_precision_{FieldPrecision::DOUBLE};
+        bool sample_survival_time_{};
+        bool terminate_unreachable_{};
+        double reachability_sigma_{};
+        unsigned int max_steps_{};
+        double diffusion_field_threshold_{};
+        bool transfer_charges_{};
+        bool store_propagated_charges_{true};
+        double max_depth_distance_{};
+        bool collect_from_implant_{};
+
+        // Bound on the time to reach the implant side for electrons and holes, one list of steps for every depth bin
+        double reachability_bin_size_{};
+        std::array<std::vector<std::vector<ReachabilityStep>>, 2> reachability_steps_;
+        std::array<double, 2> max_diffusion_constant_{};
+
+        // Parameters of the output plots bound to the configuration, only parsed if output plots are requested
+        ConfigParameter<bool> output_plots_use_pixel_units_, output_plots_use_equal_scaling_, output_plots_align_pixels_,
+            output_animations_color_markers_;
+        ConfigParameter<double> output_plots_theta_, output_plots_phi_, output_animations_marker_size_,
+            output_animations_contour_max_scaling_;
+        ConfigParameter<long double> output_animations_time_scaling_;
 
         // Models for electron and hole mobility and lifetime
         Mobility mobility_;
         Recombination recombination_;
 
+        // Drift velocity of electrons and holes precomputed on the grid of the electric field
+        bool velocity_grid_{};
+        std::array<DetectorField<ROOT::Math::XYZVector>, 2> velocity_grids_;
+
         // Precalculated value for Boltzmann constant:
         double boltzmann_kT_;
 
@@ -115,14 +261,22 @@ namespace allpix {
         double electron_Hall_;
         double hole_Hall_;
 
-        // Magnetic field
+        // Magnetic field, only looked up once if uniform
         bool has_magnetic_field_;
+        bool uniform_magnetic_field_{};
         ROOT::Math::XYZVector magnetic_field_;
 
         // Statistical information
         std::atomic<unsigned int> total_propagated_charges_{};
         std::atomic<unsigned int> total_steps_{};
         std::atomic<long unsigned int> total_time_picoseconds_{};
+        std::atomic<size_t> total_charge_sets_{};
+        std::atomic<size_t> total_unmerged_charge_sets_{};
+        std::atomic<size_t> total_split_charge_sets_{};
+        // Updated while propagating, which is otherwise independent of the module state
+        mutable std::atomic<size_t> total_exceeded_step_budget_{};
+        mutable std::atomic<size_t> total_diffusion_jumps_{};
+        std::atomic<unsigned int> total_transferred_charges_{};
         Histogram<TH1D> step_length_histo_;
         Histogram<TH1D> drift_time_histo_;
         Histogram<TH1D> uncertainty_histo_;
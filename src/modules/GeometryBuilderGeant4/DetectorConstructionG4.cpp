@@ -10,6 +10,7 @@
 
 #include "DetectorConstructionG4.hpp"
 
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -45,7 +46,39 @@
 
 using namespace allpix;
 
-DetectorConstructionG4::DetectorConstructionG4(GeometryManager* geo_manager) : geo_manager_(geo_manager) {}
+DetectorConstructionG4::DetectorConstructionG4(GeometryManager* geo_manager,
+                                               bool homogeneous_bumps,
+                                               bool share_model_volumes)
+    : geo_manager_(geo_manager), homogeneous_bumps_(homogeneous_bumps), share_model_volumes_(share_model_volumes) {}
+
+/**
+ * Registers an external object of the source under the name of the target, if the source has an object with this ID
+ */
+template <typename T>
+static void share_object(GeometryManager* geo_manager,
+                         const std::string& source,
+                         const std::string& target,
+                         const std::string& id) {
+    auto object = geo_manager->getExternalObject<T>(source, id);
+    if(object != nullptr) {
+        geo_manager->setExternalObject(target, id, object);
+    }
+}
+
+void DetectorConstructionG4::share_volumes(const std::string& source, const std::string& target) {
+    for(const auto* id : {"wrapper_log", "sensor_log", "pixel_log", "chip_log", "bumps_wrapper_log", "bumps_cell_log"}) {
+        share_object<G4LogicalVolume>(geo_manager_, source, target, id);
+    }
+    for(const auto* id : {"sensor_phys", "chip_phys", "bumps_wrapper_phys", "bumps_layer_phys"}) {
+        share_object<G4PVPlacement>(geo_manager_, source, target, id);
+    }
+    share_object<G4VPVParameterisation>(geo_manager_, source, target, "pixel_param");
+    share_object<G4VPVParameterisation>(geo_manager_, source, target, "bumps_param");
+    share_object<G4PVParameterised>(geo_manager_, source, target, "bumps_param_phys");
+    share_object<std::vector<std::shared_ptr<G4LogicalVolume>>>(geo_manager_, source, target, "supports_log");
+    share_object<std::vector<std::shared_ptr<G4PVPlacement>>>(geo_manager_, source, target, "supports_phys");
+    share_object<double>(geo_manager_, source, target, "material_budget");
+}
 
 void DetectorConstructionG4::build(const std::shared_ptr<G4LogicalVolume>& world_log) {
 
@@ -58,6 +91,10 @@ void DetectorConstructionG4::build(const std::shared_ptr<G4LogicalVolume>& world
     std::vector<std::shared_ptr<Detector>> detectors = geo_manager_->getDetectors();
     LOG(TRACE) << "Building " << detectors.size() << " device(s)";
 
+    // Detectors the volumes of every model have been built for, if the volumes are shared between detectors
+    std::map<const DetectorModel*, std::string> model_volumes_source;
+    size_t detector_index = 0;
+
     for(auto& detector : detectors) {
         // Material budget:
         double total_material_budget = 0;
@@ -72,14 +109,6 @@ void DetectorConstructionG4::build(const std::shared_ptr<G4LogicalVolume>& world
         LOG(TRACE) << " Chip dimensions: " << Units::display(model->getChipSize(), {"mm", "um"});
         LOG(DEBUG) << " Global position and orientation of the detector:";
 
-        // Create the wrapper box and logical volume
-        auto wrapper_box = make_shared_no_delete<G4Box>(
-            "wrapper_" + name, model->getSize().x() / 2.0, model->getSize().y() / 2.0, model->getSize().z() / 2.0);
-        solids_.push_back(wrapper_box);
-        auto wrapper_log = make_shared_no_delete<G4LogicalVolume>(
-            wrapper_box.get(), materials.get("world_material"), "wrapper_" + name + "_log");
-        geo_manager_->setExternalObject(name, "wrapper_log", wrapper_log);
-
         // Get position and orientation
         auto position = detector->getPosition();
         LOG(DEBUG) << " - Position\t\t:\t" << Units::display(position, {"mm", "um"});
@@ -102,9 +131,37 @@ void DetectorConstructionG4::build(const std::shared_ptr<G4LogicalVolume>& world
             throw ModuleError("Cannot find world volume");
         }
 
+        // The copy number of the wrapper identifies the detector if its volumes are shared with other detectors
+        auto copy_number = static_cast<G4int>(detector_index++);
+
+        // Place the volumes already built for another detector with the same model if requested
+        auto model_volumes = model_volumes_source.find(model.get());
+        if(model_volumes != model_volumes_source.end()) {
+            LOG(DEBUG) << " Sharing volumes of detector " << model_volumes->second;
+            share_volumes(model_volumes->second, name);
+            auto wrapper_log = geo_manager_->getExternalObject<G4LogicalVolume>(name, "wrapper_log");
+            auto wrapper_phys = make_shared_no_delete<G4PVPlacement>(
+                transform_phys, wrapper_log.get(), "wrapper_" + name + "_phys", world_log.get(), false, copy_number, true);
+            geo_manager_->setExternalObject(name, "wrapper_phys", wrapper_phys);
+
+            LOG(TRACE) << " Constructed detector " << detector->getName() << " successfully";
+            continue;
+        }
+        if(share_model_volumes_) {
+            model_volumes_source.emplace(model.get(), name);
+        }
+
+        // Create the wrapper box and logical volume
+        auto wrapper_box = make_shared_no_delete<G4Box>(
+            "wrapper_" + name, model->getSize().x() / 2.0, model->getSize().y() / 2.0, model->getSize().z() / 2.0);
+        solids_.push_back(wrapper_box);
+        auto wrapper_log = make_shared_no_delete<G4LogicalVolume>(
+            wrapper_box.get(), materials.get("world_material"), "wrapper_" + name + "_log");
+        geo_manager_->setExternalObject(name, "wrapper_log", wrapper_log);
+
         // Place the wrapper
         auto wrapper_phys = make_shared_no_delete<G4PVPlacement>(
-            transform_phys, wrapper_log.get(), "wrapper_" + name + "_phys", world_log.get(), false, 0, true);
+            transform_phys, wrapper_log.get(), "wrapper_" + name + "_phys", world_log.get(), false, copy_number, true);
         geo_manager_->setExternalObject(name, "wrapper_phys", wrapper_phys);
 
         LOG(DEBUG) << " Center of the geometry parts relative to the detector wrapper geometric center:";
@@ -306,48 +363,83 @@ void DetectorConstructionG4::build(const std::shared_ptr<G4LogicalVolume>& world
                                                                            true);
             geo_manager_->setExternalObject(name, "bumps_wrapper_phys", bumps_wrapper_phys);
 
-            // Create the individual bump solid
-            auto bump_sphere = make_shared_no_delete<G4Sphere>(
-                "bumps_" + name + "_sphere", 0, bump_sphere_radius, 0, 360 * CLHEP::deg, 0, 360 * CLHEP::deg);
-            solids_.push_back(bump_sphere);
-            auto bump_tube = make_shared_no_delete<G4Tubs>(
-                "bumps_" + name + "_tube", 0., bump_cylinder_radius, bump_height / 2., 0., 360 * CLHEP::deg);
-            solids_.push_back(bump_tube);
-            auto bump = make_shared_no_delete<G4UnionSolid>("bumps_" + name, bump_sphere.get(), bump_tube.get());
-            solids_.push_back(bump);
-
-            // Create the logical volume for the individual bumps
-            auto bumps_cell_log =
-                make_shared_no_delete<G4LogicalVolume>(bump.get(), materials.get("solder"), "bumps_" + name + "_log");
-            geo_manager_->setExternalObject(name, "bumps_cell_log", bumps_cell_log);
-
-            // Add bump material equivalent to uniform solder layer to total material budget:
+            // Relative area covered by the bumps, equivalent to a uniform solder layer
             auto radius = std::max(hybrid_model->getBumpSphereRadius(), hybrid_model->getBumpCylinderRadius());
             auto relativeArea = M_PI * radius * radius / model->getPixelSize().x() / model->getPixelSize().y();
-            total_material_budget +=
-                (relativeArea * hybrid_model->getBumpHeight() / bumps_cell_log->GetMaterial()->GetRadlen());
-
-            // Place the bump bonds grid
-            std::shared_ptr<G4VPVParameterisation> bumps_param = std::make_shared<Parameterization2DG4>(
-                hybrid_model->getNPixels().x(),
-                hybrid_model->getPixelSize().x(),
-                hybrid_model->getPixelSize().y(),
-                -(hybrid_model->getNPixels().x() * hybrid_model->getPixelSize().x()) / 2.0 +
-                    (hybrid_model->getBumpsCenter().x() - hybrid_model->getCenter().x()),
-                -(hybrid_model->getNPixels().y() * hybrid_model->getPixelSize().y()) / 2.0 +
-                    (hybrid_model->getBumpsCenter().y() - hybrid_model->getCenter().y()),
-                0);
-            geo_manager_->setExternalObject(name, "bumps_param", bumps_param);
-
-            std::shared_ptr<G4PVParameterised> bumps_param_phys =
-                std::make_shared<ParameterisedG4>("bumps_" + name + "_phys",
-                                                  bumps_cell_log.get(),
-                                                  bumps_wrapper_log.get(),
-                                                  kUndefined,
-                                                  hybrid_model->getNPixels().x() * hybrid_model->getNPixels().y(),
-                                                  bumps_param.get(),
-                                                  false);
-            geo_manager_->setExternalObject(name, "bumps_param_phys", bumps_param_phys);
+
+            if(homogeneous_bumps_) {
+                // Build a single layer over the pixel grid with the solder diluted to the area covered by the bumps
+                auto bumps_layer_box = make_shared_no_delete<G4Box>("bumps_" + name,
+                                                                    hybrid_model->getGridSize().x() / 2.0,
+                                                                    hybrid_model->getGridSize().y() / 2.0,
+                                                                    bump_height / 2.);
+                solids_.push_back(bumps_layer_box);
+
+                auto* solder = materials.get("solder");
+                auto* bumps_material = new G4Material(
+                    "bumps_" + name + "_solder", relativeArea * solder->GetDensity(), solder, solder->GetState());
+                auto bumps_cell_log = make_shared_no_delete<G4LogicalVolume>(
+                    bumps_layer_box.get(), bumps_material, "bumps_" + name + "_log");
+                geo_manager_->setExternalObject(name, "bumps_cell_log", bumps_cell_log);
+
+                // Add the material of the layer to total material budget:
+                total_material_budget += (hybrid_model->getBumpHeight() / bumps_cell_log->GetMaterial()->GetRadlen());
+
+                // Place the layer at the center of the bump grid
+                G4ThreeVector bumps_layer_pos(hybrid_model->getBumpsCenter().x() - hybrid_model->getCenter().x(),
+                                              hybrid_model->getBumpsCenter().y() - hybrid_model->getCenter().y(),
+                                              0);
+                auto bumps_layer_phys = make_shared_no_delete<G4PVPlacement>(nullptr,
+                                                                             bumps_layer_pos,
+                                                                             bumps_cell_log.get(),
+                                                                             "bumps_" + name + "_phys",
+                                                                             bumps_wrapper_log.get(),
+                                                                             false,
+                                                                             0,
+                                                                             true);
+                geo_manager_->setExternalObject(name, "bumps_layer_phys", bumps_layer_phys);
+            } else {
+                // Create the individual bump solid
+                auto bump_sphere = make_shared_no_delete<G4Sphere>(
+                    "bumps_" + name + "_sphere", 0, bump_sphere_radius, 0, 360 * CLHEP::deg, 0, 360 * CLHEP::deg);
+                solids_.push_back(bump_sphere);
+                auto bump_tube = make_shared_no_delete<G4Tubs>(
+                    "bumps_" + name + "_tube", 0., bump_cylinder_radius, bump_height / 2., 0., 360 * CLHEP::deg);
+                solids_.push_back(bump_tube);
+                auto bump = make_shared_no_delete<G4UnionSolid>("bumps_" + name, bump_sphere.get(), bump_tube.get());
+                solids_.push_back(bump);
+
+                // Create the logical volume for the individual bumps
+                auto bumps_cell_log =
+                    make_shared_no_delete<G4LogicalVolume>(bump.get(), materials.get("solder"), "bumps_" + name + "_log");
+                geo_manager_->setExternalObject(name, "bumps_cell_log", bumps_cell_log);
+
+                // Add bump material equivalent to uniform solder layer to total material budget:
+                total_material_budget +=
+                    (relativeArea * hybrid_model->getBumpHeight() / bumps_cell_log->GetMaterial()->GetRadlen());
+
+                // Place the bump bonds grid
+                std::shared_ptr<G4VPVParameterisation> bumps_param = std::make_shared<Parameterization2DG4>(
+                    hybrid_model->getNPixels().x(),
+                    hybrid_model->getPixelSize().x(),
+                    hybrid_model->getPixelSize().y(),
+                    -(hybrid_model->getNPixels().x() * hybrid_model->getPixelSize().x()) / 2.0 +
+                        (hybrid_model->getBumpsCenter().x() - hybrid_model->getCenter().x()),
+                    -(hybrid_model->getNPixels().y() * hybrid_model->getPixelSize().y()) / 2.0 +
+                        (hybrid_model->getBumpsCenter().y() - hybrid_model->getCenter().y()),
+                    0);
+                geo_manager_->setExternalObject(name, "bumps_param", bumps_param);
+
+                std::shared_ptr<G4PVParameterised> bumps_param_phys =
+                    std::make_shared<ParameterisedG4>("bumps_" + name + "_phys",
+                                                      bumps_cell_log.get(),
+                                                      bumps_wrapper_log.get(),
+                                                      kUndefined,
+                                                      hybrid_model->getNPixels().x() * hybrid_model->getNPixels().y(),
+                                                      bumps_param.get(),
+                                                      false);
+                geo_manager_->setExternalObject(name, "bumps_param_phys", bumps_param_phys);
+            }
         }
 
         // ALERT: NO COVER LAYER YET
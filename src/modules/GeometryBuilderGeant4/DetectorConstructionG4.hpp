@@ -11,6 +11,7 @@
 #define ALLPIX_MODULE_DETECTOR_CONSTRUCTION_H
 
 #include <memory>
+#include <string>
 #include <utility>
 
 #include "G4LogicalVolume.hh"
@@ -28,8 +29,10 @@ namespace allpix {
         /**
          * @brief Constructs geometry construction module
          * @param geo_manager Pointer to the geometry manager, containing the detectors
+         * @param homogeneous_bumps Build the bump bonds as a single homogeneous layer instead of individual bumps
+         * @param share_model_volumes Build the volumes of every detector model only once and place them for each detector
          */
-        explicit DetectorConstructionG4(GeometryManager* geo_manager);
+        DetectorConstructionG4(GeometryManager* geo_manager, bool homogeneous_bumps, bool share_model_volumes);
 
         /**
          * @brief Constructs the world geometry with all detectors
@@ -38,7 +41,16 @@ namespace allpix {
         void build(const std::shared_ptr<G4LogicalVolume>& world_log);
 
     private:
+        /**
+         * @brief Registers the volumes built for one detector as the volumes of another detector of the same model
+         * @param source Name of the detector the volumes have been built for
+         * @param target Name of the detector sharing the volumes
+         */
+        void share_volumes(const std::string& source, const std::string& target);
+
         GeometryManager* geo_manager_;
+        bool homogeneous_bumps_;
+        bool share_model_volumes_;
 
         // Storage of internal objects
         std::vector<std::shared_ptr<G4VSolid>> solids_;
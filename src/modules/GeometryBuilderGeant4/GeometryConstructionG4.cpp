@@ -44,7 +44,8 @@ using namespace allpix;
 
 GeometryConstructionG4::GeometryConstructionG4(GeometryManager* geo_manager, Configuration& config)
     : geo_manager_(geo_manager), config_(config) {
-    detector_builder_ = std::make_unique<DetectorConstructionG4>(geo_manager_);
+    detector_builder_ = std::make_unique<DetectorConstructionG4>(
+        geo_manager_, config_.get<bool>("homogeneous_bumps", false), config_.get<bool>("share_model_volumes", false));
     passive_builder_ = std::make_unique<PassiveMaterialConstructionG4>(geo_manager_);
     passive_builder_->registerVolumes();
 }
@@ -0,0 +1,171 @@
+/**
+ * @file
+ * @brief Implementation of the module writing the pixel hits of all events as one time-ordered stream
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "HitStreamWriterModule.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "core/utils/distributions.h"
+#include "core/utils/log.h"
+#include "core/utils/unit.h"
+
+using namespace allpix;
+
+// Number of records collected before they are written to the file
+static constexpr size_t output_buffer_size = 65536;
+
+HitStreamWriterModule::HitStreamWriterModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager)
+    : SequentialModule(config), messenger_(messenger), geo_manager_(geo_manager) {
+    // Enable multithreading of this module if multithreading is enabled
+    allow_multithreading();
+
+    // Bind to all pixel hit messages, events without hits still advance the time of the stream
+    messenger_->bindMulti<PixelHitMessage>(this, MsgFlags::NONE);
+
+    config_.setDefault("file_name", "hitstream");
+    config_.setDefault("interval_distribution", IntervalDistribution::EXPONENTIAL);
+    config_.setDefault("buffer_events", 1000);
+
+    event_interval_ = config_.get<double>("event_interval");
+    if(event_interval_ <= 0) {
+        throw InvalidValueError(config_, "event_interval", "mean time between events should be positive");
+    }
+    interval_distribution_ = config_.get<IntervalDistribution>("interval_distribution");
+    buffer_events_ = config_.get<size_t>("buffer_events");
+    if(buffer_events_ == 0) {
+        throw InvalidValueError(config_, "buffer_events", "at least one event has to be buffered");
+    }
+}
+
+void HitStreamWriterModule::initialize() {
+    output_file_name_ = createOutputFile(config_.get<std::string>("file_name"), "aphs", true);
+    output_file_.open(output_file_name_, std::ios::binary);
+    if(!output_file_.good()) {
+        throw ModuleError("Cannot create hit stream file " + output_file_name_);
+    }
+
+    // Store the names of the detectors once, the records only refer to their index
+    output_file_.write(hit_stream::magic.data(), hit_stream::magic.size());
+    output_file_.write(reinterpret_cast<const char*>(&hit_stream::version), sizeof(hit_stream::version)); // NOLINT
+    auto detectors = geo_manager_->getDetectors();
+    auto detector_count = static_cast<std::uint32_t>(detectors.size());
+    output_file_.write(reinterpret_cast<const char*>(&detector_count), sizeof(detector_count)); // NOLINT
+    for(auto& detector : detectors) {
+        auto name = detector->getName();
+        auto length = static_cast<std::uint32_t>(name.size());
+        output_file_.write(reinterpret_cast<const char*>(&length), sizeof(length)); // NOLINT
+        output_file_.write(name.data(), static_cast<std::streamsize>(name.size()));
+        detector_index_.emplace(name, static_cast<std::uint16_t>(detector_index_.size()));
+    }
+
+    output_buffer_.reserve(output_buffer_size);
+}
+
+/**
+ * The time of the following event is drawn together with the time of the current event. Since hits cannot precede their
+ * event, all buffered hits earlier than the following event are final and written. Events with hits much later than the
+ * time between events are kept in the buffer, which is limited to a number of events: if it overflows, the merge proceeds
+ * until the oldest event is written completely, and later hits preceding the hits written are counted as out of order.
+ */
+void HitStreamWriterModule::run(Event* event) {
+    auto messages = messenger_->fetchMultiMessage<PixelHitMessage>(this, event);
+
+    auto event_time = next_event_time_;
+    if(interval_distribution_ == IntervalDistribution::EXPONENTIAL) {
+        next_event_time_ += allpix::exponential_distribution<double>(1. / event_interval_)(event->getRandomEngine());
+    } else {
+        next_event_time_ += event_interval_;
+    }
+
+    // Collect the hits of the event with their time in the stream
+    std::vector<hit_stream::Record> hits;
+    for(auto& message : messages) {
+        auto detector = detector_index_.at(message->getDetector()->getName());
+        for(const auto& hit : message->getData()) {
+            auto index = hit.getIndex();
+            hits.push_back({event_time + hit.getGlobalTime(),
+                            hit.getSignal(),
+                            event->number,
+                            static_cast<std::uint32_t>(index.x()),
+                            static_cast<std::uint32_t>(index.y()),
+                            detector,
+                            {}});
+        }
+    }
+    LOG(TRACE) << "Placing " << hits.size() << " hits of event " << event->number << " at "
+               << Units::display(event_time, {"ns", "us", "ms", "s"});
+
+    if(!hits.empty()) {
+        std::stable_sort(hits.begin(), hits.end(), [](const auto& a, const auto& b) { return a.time < b.time; });
+        merge_.emplace(hits.front().time, event->number);
+        pending_[event->number].hits = std::move(hits);
+    }
+
+    // Write all hits which cannot be preceded by the hits of later events
+    while(!merge_.empty() && merge_.top().first < next_event_time_) {
+        write_next();
+    }
+
+    // Limit the number of buffered events
+    while(pending_.size() > buffer_events_) {
+        auto oldest = pending_.begin()->first;
+        while(pending_.count(oldest) != 0) {
+            write_next();
+        }
+    }
+}
+
+void HitStreamWriterModule::finalize() {
+    while(!merge_.empty()) {
+        write_next();
+    }
+    flush();
+    output_file_.close();
+
+    if(unordered_count_ > 0) {
+        LOG(WARNING) << unordered_count_ << " hits are written out of time order, the buffer of " << buffer_events_
+                     << " events is too small for the time spread of the hits";
+    }
+    LOG(STATUS) << "Wrote " << hit_count_ << " hits covering " << Units::display(last_time_, {"ns", "us", "ms", "s"})
+                << " to file:" << std::endl
+                << output_file_name_;
+}
+
+void HitStreamWriterModule::write_next() {
+    auto event = merge_.top().second;
+    merge_.pop();
+
+    auto& pending = pending_.at(event);
+    const auto& record = pending.hits[pending.next];
+    if(record.time < last_time_) {
+        unordered_count_++;
+    }
+    last_time_ = std::max(last_time_, record.time);
+    output_buffer_.push_back(record);
+    hit_count_++;
+
+    // Continue with the next hit of the event, or remove the event once all of its hits are written
+    if(++pending.next < pending.hits.size()) {
+        merge_.emplace(pending.hits[pending.next].time, event);
+    } else {
+        pending_.erase(event);
+    }
+
+    if(output_buffer_.size() >= output_buffer_size) {
+        flush();
+    }
+}
+
+void HitStreamWriterModule::flush() {
+    output_file_.write(reinterpret_cast<const char*>(output_buffer_.data()), // NOLINT
+                       static_cast<std::streamsize>(output_buffer_.size() * sizeof(hit_stream::Record)));
+    output_buffer_.clear();
+}
@@ -0,0 +1,144 @@
+/**
+ * @file
+ * @brief Definition of the module writing the pixel hits of all events as one time-ordered stream
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <queue>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "core/config/Configuration.hpp"
+#include "core/geometry/GeometryManager.hpp"
+#include "core/messenger/Messenger.hpp"
+#include "core/module/Event.hpp"
+#include "core/module/Module.hpp"
+
+#include "objects/PixelHit.hpp"
+
+namespace allpix {
+    /**
+     * @brief Layout of hit stream files
+     *
+     * A stream starts with a header of the magic string and the version, followed by the number of detectors and their
+     * names, each stored as length and characters. The hits follow as plain memory layout of \ref Record until the end of
+     * the file, ordered by their time in the stream. Streams are written in the byte order of the machine, they can only be
+     * read on machines with the same byte order.
+     */
+    namespace hit_stream {
+        constexpr std::array<char, 8> magic = {'A', 'P', 'H', 'I', 'T', 'S', 'T', 'R'};
+        constexpr std::uint32_t version = 1;
+
+        /**
+         * @brief Pixel hit in the stream
+         */
+        struct Record {
+            // Time of the hit in the stream, i.e. the time of its event in the stream plus its global time
+            double time;
+            double signal;
+            std::uint64_t event;
+            std::uint32_t column;
+            std::uint32_t row;
+            // Index of the detector in the list of the header
+            std::uint16_t detector;
+            std::array<std::uint16_t, 3> padding;
+        };
+
+        static_assert(std::is_trivially_copyable<Record>::value && sizeof(Record) == 40, "unexpected layout of hit records");
+    } // namespace hit_stream
+
+    /**
+     * @ingroup Modules
+     * @brief Module to write the pixel hits of consecutive events as one continuous stream ordered in time
+     *
+     * Every event is placed at a time in the stream drawn from a rate process. The hits of the events buffered are merged by
+     * their time in the stream and written as soon as no hit of a later event can precede them anymore.
+     */
+    class HitStreamWriterModule : public SequentialModule {
+        /**
+         * @brief Distribution of the time between consecutive events
+         */
+        enum class IntervalDistribution {
+            EXPONENTIAL, ///< Events arriving as Poisson process
+            CONSTANT,    ///< Events arriving with a fixed period
+        };
+
+    public:
+        /**
+         * @brief Constructor for this unique module
+         * @param config Configuration object for this module as retrieved from the steering file
+         * @param messenger Pointer to the messenger object to allow binding to messages on the bus
+         * @param geo_manager Pointer to the geometry manager, containing the detectors
+         */
+        HitStreamWriterModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager);
+
+        /**
+         * @brief Open the output file and write its header
+         */
+        void initialize() override;
+
+        /**
+         * @brief Place the event in the stream and write all hits which cannot be preceded by later events
+         */
+        void run(Event* event) override;
+
+        /**
+         * @brief Write the hits remaining in the buffer and close the file
+         */
+        void finalize() override;
+
+    private:
+        /**
+         * @brief Write the next hit of the merge to the output buffer
+         */
+        void write_next();
+
+        /**
+         * @brief Write the output buffer to the file
+         */
+        void flush();
+
+        Messenger* messenger_;
+        GeometryManager* geo_manager_;
+
+        double event_interval_{};
+        IntervalDistribution interval_distribution_{};
+        size_t buffer_events_{};
+
+        // Time of the next event in the stream
+        double next_event_time_{};
+
+        // Hits of the buffered events sorted by time, and position of the next hit to merge
+        struct PendingEvent {
+            std::vector<hit_stream::Record> hits;
+            size_t next{};
+        };
+        std::map<uint64_t, PendingEvent> pending_;
+
+        // Next hit of every buffered event, ordered by its time in the stream
+        using Cursor = std::pair<double, uint64_t>;
+        std::priority_queue<Cursor, std::vector<Cursor>, std::greater<>> merge_;
+
+        // Index of every detector as stored in the records
+        std::map<std::string, std::uint16_t> detector_index_;
+
+        // Output file and records not yet written
+        std::ofstream output_file_;
+        std::string output_file_name_;
+        std::vector<hit_stream::Record> output_buffer_;
+
+        // Statistics
+        unsigned long long hit_count_{};
+        unsigned long long unordered_count_{};
+        double last_time_{};
+    };
+} // namespace allpix
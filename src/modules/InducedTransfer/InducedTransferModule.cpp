@@ -9,12 +9,18 @@
 
 #include "InducedTransferModule.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "core/config/exceptions.h"
 #include "core/module/Event.hpp"
 #include "core/utils/log.h"
 #include "objects/PixelCharge.hpp"
+#include "objects/PixelChargeAccumulator.hpp"
 
 using namespace allpix;
 using namespace ROOT::Math;
@@ -34,6 +40,11 @@ InducedTransferModule::InducedTransferModule(Configuration& config,
     // Set default value for config variables and store value
     config_.setDefault<XYVectorInt>("induction_matrix", XYVectorInt(3, 3));
     matrix_ = config_.get<XYVectorInt>("induction_matrix");
+    config_.setDefault<size_t>("surface_table_size", 0);
+    surface_table_size_ = config_.get<size_t>("surface_table_size");
+    if(surface_table_size_ == 1) {
+        throw InvalidValueError(config_, "surface_table_size", "table requires at least two points per axis");
+    }
 
     // Require propagated deposits for single detector
     messenger_->bindSingle<PropagatedChargeMessage>(this, MsgFlags::REQUIRED);
@@ -45,6 +56,72 @@ void InducedTransferModule::initialize() {
     if(!detector_->hasWeightingPotential()) {
         throw ModuleError("This module requires a weighting potential.");
     }
+
+    if(surface_table_size_ > 0) {
+        build_surface_table();
+    }
+}
+
+/**
+ * Positions beyond the thickness domain of the weighting potential are extrapolated with its value at the border, such that
+ * the table holds for all positions on or outside of the sensor surfaces. The table is evaluated for a pixel far enough from
+ * the edge of the pixel grid to have all pixels of the induction matrix at non-negative indices.
+ */
+void InducedTransferModule::build_surface_table() {
+    auto sensor_z = model_->getSensorCenter().z();
+    surface_z_ = {sensor_z - model_->getSensorSize().z() / 2, sensor_z + model_->getSensorSize().z() / 2};
+
+    auto pixel_size = model_->getPixelSize();
+    auto reference_x = static_cast<unsigned int>(matrix_.x() / 2);
+    auto reference_y = static_cast<unsigned int>(matrix_.y() / 2);
+    auto reference_center = model_->getPixelCenter(reference_x, reference_y);
+
+    std::vector<Pixel::Index> pixels;
+    for(int x = -matrix_.x() / 2; x <= matrix_.x() / 2; x++) {
+        for(int y = -matrix_.y() / 2; y <= matrix_.y() / 2; y++) {
+            pixels.emplace_back(reference_x + static_cast<unsigned int>(x), reference_y + static_cast<unsigned int>(y));
+        }
+    }
+
+    auto points = surface_table_size_;
+    surface_table_pixels_ = pixels.size();
+    surface_potential_.resize(2 * pixels.size() * points * points);
+    std::vector<double> potentials(pixels.size());
+    for(size_t surface = 0; surface < 2; ++surface) {
+        for(size_t i = 0; i < points; ++i) {
+            for(size_t j = 0; j < points; ++j) {
+                auto u = (static_cast<double>(i) / static_cast<double>(points - 1) - 0.5) * pixel_size.x();
+                auto v = (static_cast<double>(j) / static_cast<double>(points - 1) - 0.5) * pixel_size.y();
+                ROOT::Math::XYZPoint position(reference_center.x() + u, reference_center.y() + v, surface_z_[surface]);
+                detector_->getWeightingPotential(position, pixels.data(), potentials.data(), pixels.size());
+                for(size_t offset = 0; offset < pixels.size(); ++offset) {
+                    surface_potential_[((surface * pixels.size() + offset) * points + i) * points + j] = potentials[offset];
+                }
+            }
+        }
+    }
+    LOG(DEBUG) << "Tabulated weighting potential of " << pixels.size() << " pixels on the sensor surfaces with " << points
+               << "x" << points << " points";
+}
+
+double InducedTransferModule::surface_potential(size_t surface,
+                                                size_t offset,
+                                                const ROOT::Math::XYVector& in_pixel) const {
+    auto points = surface_table_size_;
+    auto pixel_size = model_->getPixelSize();
+
+    // Fractional table coordinates, clamped to the pixel to cover rounding at the pixel border
+    auto last = static_cast<double>(points - 1);
+    auto fx = std::clamp((in_pixel.x() / pixel_size.x() + 0.5) * last, 0., last);
+    auto fy = std::clamp((in_pixel.y() / pixel_size.y() + 0.5) * last, 0., last);
+    auto i = std::min(static_cast<size_t>(fx), points - 2);
+    auto j = std::min(static_cast<size_t>(fy), points - 2);
+    auto tx = fx - static_cast<double>(i);
+    auto ty = fy - static_cast<double>(j);
+
+    const auto* table = &surface_potential_[(surface * surface_table_pixels_ + offset) * points * points];
+    return (1 - tx) * ((1 - ty) * table[i * points + j] + ty * table[i * points + j + 1]) +
+           tx * ((1 - ty) * table[(i + 1) * points + j] + ty * table[(i + 1) * points + j + 1]);
 }
 
 void InducedTransferModule::run(Event* event) {
@@ -54,7 +131,7 @@ void InducedTransferModule::run(Event* event) {
     LOG(TRACE) << "Calculating induced charge on pixels";
     bool found_electrons = false, found_holes = false;
 
-    std::map<Pixel::Index, std::vector<std::pair<double, const PropagatedCharge*>>> pixel_map;
+    PixelChargeAccumulator pixel_map(propagated_message->getData().size());
     for(const auto& propagated_charge : propagated_message->getData()) {
 
         // Make sure both electrons and holes are present in the input data
@@ -69,18 +146,35 @@ void InducedTransferModule::run(Event* event) {
         // Get start and end point by looking at deposited and propagated charge local positions
         auto position_end = propagated_charge.getLocalPosition();
         auto position_start = deposited_charge->getLocalPosition();
+        std::array<ROOT::Math::XYZPoint, 2> positions{{position_end, position_start}};
 
         // Find the nearest pixel
         auto [xpixel, ypixel] = model_->getPixelIndex(position_end);
 
+        // End positions on a sensor surface are looked up in the table, relative to the center of the nearest pixel
+        int surface = -1;
+        ROOT::Math::XYVector in_pixel;
+        if(!surface_potential_.empty() && model_->isWithinPixelGrid(xpixel, ypixel)) {
+            if(position_end.z() <= surface_z_[0]) {
+                surface = 0;
+            } else if(position_end.z() >= surface_z_[1]) {
+                surface = 1;
+            }
+        }
+        if(surface >= 0) {
+            auto center = model_->getPixelCenter(static_cast<unsigned int>(xpixel), static_cast<unsigned int>(ypixel));
+            in_pixel = ROOT::Math::XYVector(position_end.x() - center.x(), position_end.y() - center.y());
+        }
+
         LOG(TRACE) << "Calculating induced charge from carriers below pixel "
                    << Pixel::Index(static_cast<unsigned int>(xpixel), static_cast<unsigned int>(ypixel)) << ", moved from "
                    << Units::display(position_start, {"um", "mm"}) << " to " << Units::display(position_end, {"um", "mm"})
                    << ", " << Units::display(propagated_charge.getGlobalTime() - deposited_charge->getGlobalTime(), "ns");
 
         // Loop over NxN pixels:
+        size_t offset = 0;
         for(int x = xpixel - matrix_.x() / 2; x <= xpixel + matrix_.x() / 2; x++) {
-            for(int y = ypixel - matrix_.y() / 2; y <= ypixel + matrix_.y() / 2; y++) {
+            for(int y = ypixel - matrix_.y() / 2; y <= ypixel + matrix_.y() / 2; y++, offset++) {
                 // Ignore if out of pixel grid
                 if(!detector_->getModel()->isWithinPixelGrid(x, y)) {
                     LOG(TRACE) << "Pixel (" << x << "," << y << ") skipped, outside the grid";
@@ -88,8 +182,14 @@ void InducedTransferModule::run(Event* event) {
                 }
 
                 Pixel::Index pixel_index(static_cast<unsigned int>(x), static_cast<unsigned int>(y));
-                auto ramo_end = detector_->getWeightingPotential(position_end, pixel_index);
-                auto ramo_start = detector_->getWeightingPotential(position_start, pixel_index);
+                std::array<double, 2> ramo{};
+                if(surface >= 0) {
+                    ramo[0] = surface_potential(static_cast<size_t>(surface), offset, in_pixel);
+                    ramo[1] = detector_->getWeightingPotential(position_start, pixel_index);
+                } else {
+                    detector_->getWeightingPotential(positions.data(), pixel_index, ramo.data(), positions.size());
+                }
+                auto [ramo_end, ramo_start] = ramo;
 
                 // Induced charge on electrode is q_int = q * (phi(x1) - phi(x0))
                 auto induced = static_cast<double>(propagated_charge.getSign() * propagated_charge.getCharge()) *
@@ -98,7 +198,7 @@ void InducedTransferModule::run(Event* event) {
                            << propagated_charge.getType() << " q = " << Units::display(induced, "e");
 
                 // Add the pixel the list of hit pixels
-                pixel_map[pixel_index].emplace_back(induced, &propagated_charge);
+                pixel_map.add(pixel_index, induced, &propagated_charge);
             }
         }
     }
@@ -112,23 +212,20 @@ void InducedTransferModule::run(Event* event) {
 
     // Create pixel charges
     LOG(TRACE) << "Combining charges at same pixel";
+    pixel_map.sort();
     std::vector<PixelCharge> pixel_charges;
-    for(auto& pixel_index_charge : pixel_map) {
-        double charge = 0;
-        std::vector<const PropagatedCharge*> prop_charges;
-        for(auto& prop_pair : pixel_index_charge.second) {
-            charge += prop_pair.first;
-            prop_charges.push_back(prop_pair.second);
-        }
+    pixel_charges.reserve(pixel_map.size());
+    for(size_t i = 0; i < pixel_map.size(); ++i) {
+        auto charge = pixel_map.getCharge(i);
 
         // Get pixel object from detector
-        auto pixel = detector_->getPixel(pixel_index_charge.first.x(), pixel_index_charge.first.y());
+        auto pixel = detector_->getPixel(pixel_map.getIndex(i).x(), pixel_map.getIndex(i).y());
 
-        pixel_charges.emplace_back(pixel, std::round(charge), prop_charges);
+        pixel_charges.emplace_back(pixel, std::round(charge), pixel_map.getPropagatedCharges(i));
         LOG(DEBUG) << "Set of " << charge << " charges combined at " << pixel.getIndex();
     }
 
     // Dispatch message of pixel charges
-    auto pixel_message = std::make_shared<PixelChargeMessage>(pixel_charges, detector_);
+    auto pixel_message = event->makeShared<PixelChargeMessage>(pixel_charges, detector_);
     messenger_->dispatchMessage(this, pixel_message, event);
 }
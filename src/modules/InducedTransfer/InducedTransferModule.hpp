@@ -7,7 +7,9 @@
  * Intergovernmental Organization or submit itself to any jurisdiction.
  */
 
+#include <array>
 #include <string>
+#include <vector>
 
 #include "core/config/Configuration.hpp"
 #include "core/geometry/DetectorModel.hpp"
@@ -50,6 +52,20 @@ namespace allpix {
         void run(Event*) override;
 
     private:
+        /**
+         * @brief Tabulate the weighting potential of every pixel of the induction matrix on both sensor surfaces
+         */
+        void build_surface_table();
+
+        /**
+         * @brief Interpolate the tabulated weighting potential on a sensor surface
+         * @param surface Index of the surface, zero for the lower and one for the upper surface
+         * @param offset Index of the pixel within the induction matrix
+         * @param in_pixel Position relative to the center of the pixel the carrier ended in
+         * @return Weighting potential of the pixel at the given position
+         */
+        double surface_potential(size_t surface, size_t offset, const ROOT::Math::XYVector& in_pixel) const;
+
         Messenger* messenger_;
 
         std::shared_ptr<Detector> detector_;
@@ -57,5 +73,12 @@ namespace allpix {
 
         // Induction matrix size in number of pixels along x and y
         ROOT::Math::DisplacementVector2D<ROOT::Math::Cartesian2D<int>> matrix_;
+
+        // Weighting potential on the sensor surfaces, indexed by surface, pixel of the induction matrix and in-pixel
+        // position. Read-only after initialization and empty if disabled
+        std::vector<double> surface_potential_;
+        size_t surface_table_size_{};
+        size_t surface_table_pixels_{};
+        std::array<double, 2> surface_z_{};
     };
 } // namespace allpix
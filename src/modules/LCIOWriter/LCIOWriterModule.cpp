@@ -9,6 +9,8 @@
 
 #include "LCIOWriterModule.hpp"
 
+#include <array>
+#include <filesystem>
 #include <fstream>
 #include <string>
 #include <utility>
@@ -102,6 +104,8 @@ LCIOWriterModule::LCIOWriterModule(Configuration& config, Messenger* messenger,
     config_.setDefault("dump_mc_truth", false);
 
     pixel_type_ = config_.get<int>("pixel_type");
+    // Number of values stored per pixel: EUTelSimpleSparsePixel, EUTelTimepix3SparsePixel or EUTelGenericSparsePixel
+    pixel_values_ = (pixel_type_ == 1 ? 3 : (pixel_type_ == 5 ? 7 : 4));
     detector_name_ = config_.get<std::string>("detector_name");
     dump_mc_truth_ = config_.get<bool>("dump_mc_truth");
     // There are two ways to configure this module - either by providing a "output_collection_name" or a
@@ -239,132 +243,167 @@ LCIOWriterModule::LCIOWriterModule(Configuration& config, Messenger* messenger,
 void LCIOWriterModule::initialize() {
     // Create the output GEAR file for the detector geometry
     geometry_file_name_ = createOutputFile(config_.get<std::string>("geometry_file"), "xml");
-    // Open LCIO file and write run header
-    lcio_file_name_ = createOutputFile(config_.get<std::string>("file_name"), "slcio");
+    // Open LCIO file, or the file of the first chunk if the output is split
+    file_name_ = config_.get<std::string>("file_name");
+    rotation_ =
+        OutputRotation(config_.get<uint64_t>("max_events_per_file", 0), config_.get<uint64_t>("max_file_size", 0));
     lcWriter_ = std::shared_ptr<IO::LCWriter>(LCFactory::getInstance()->createLCWriter());
-    lcWriter_->open(lcio_file_name_, LCIO::WRITE_NEW);
-    auto run = std::make_unique<LCRunHeaderImpl>();
-    run->setRunNumber(1);
-    run->setDetectorName(detector_name_);
-    lcWriter_->writeRunHeader(run.get());
+    open_output_file();
+
+    // Start the thread writing the events in the background
+    asynchronous_ = config_.get<bool>("asynchronous_write", true);
+    if(asynchronous_) {
+        queue_size_ = config_.get<size_t>("write_queue_size", 16);
+        if(queue_size_ == 0) {
+            throw InvalidValueError(config_, "write_queue_size", "queue needs to hold at least one event");
+        }
+        writer_thread_ = std::thread(&LCIOWriterModule::run_writer, this, Log::getReportingLevel(), Log::getFormat());
+    }
 }
 
-void LCIOWriterModule::run(Event* event) {
-    auto pixel_messages = messenger_->fetchMultiMessage<PixelHitMessage>(this, event);
+LCIOWriterModule::~LCIOWriterModule() {
+    stop_writer();
+}
+
+std::unique_ptr<LCIOWriterModule::EventSlot> LCIOWriterModule::create_slot() const {
+    auto slot = std::make_unique<EventSlot>();
+    slot->event = std::make_unique<LCEventImpl>();
+    slot->event->setRunNumber(1);
+    slot->event->parameters().setValue("EventType", 2);
 
-    auto evt = std::make_unique<LCEventImpl>(); // create the event
-    evt->setRunNumber(1);
-    evt->setEventNumber(static_cast<int>(event->number)); // set the event attributes
-    evt->parameters().setValue("EventType", 2);
-
-    auto output_col_vec = std::vector<LCCollectionVec*>();
-    auto output_col_encoder_vec = std::vector<std::unique_ptr<CellIDEncoder<TrackerDataImpl>>>();
-    // Prepare dynamic output setup and their CellIDEncoders which are defined by the user's config
-    for(size_t i = 0; i < collection_names_vector_.size(); ++i) {
-        output_col_vec.emplace_back(new LCCollectionVec(LCIO::TRACKERDATA));
-        output_col_encoder_vec.emplace_back(
-            std::make_unique<CellIDEncoder<TrackerDataImpl>>(eutelescope::gTrackerDataEncoding, output_col_vec.back()));
+    // Create the output collections with one data object per detector, the sensor ids never change
+    for(const auto& collection_name : collection_names_vector_) {
+        auto* collection = new LCCollectionVec(LCIO::TRACKERDATA);
+        slot->event->addCollection(collection, collection_name);
+    }
+    for(auto const& det_id_name_pair : detector_names_to_id_) {
+        auto det_id = det_id_name_pair.second;
+        auto* collection = static_cast<LCCollectionVec*>(
+            slot->event->getCollection(collection_names_vector_[detector_ids_to_colllection_index_.at(det_id)]));
+        CellIDEncoder<TrackerDataImpl> encoder(eutelescope::gTrackerDataEncoding, collection);
+        auto* hit = new TrackerDataImpl();
+        encoder["sensorID"] = det_id;
+        encoder["sparsePixelType"] = pixel_type_;
+        encoder.setCellID(hit);
+        collection->push_back(hit);
+        slot->detector_data[det_id] = hit;
     }
 
-    LCCollectionVec* mc_cluster_vec = nullptr;
-    LCCollectionVec* mc_cluster_raw_vec = nullptr;
-    LCCollectionVec* mc_hit_vec = nullptr;
-    LCCollectionVec* mc_track_vec = nullptr;
+    if(dump_mc_truth_) {
+        // Prepare static Monte-Carlo output setup and their CellIDEncoders which are the same every time
+        slot->mc_track = new LCCollectionVec(LCIO::TRACK);
+        slot->mc_hit = new LCCollectionVec(LCIO::TRACKERHIT);
+        slot->mc_cluster_raw = new LCCollectionVec(LCIO::TRACKERDATA);
+        slot->mc_cluster = new LCCollectionVec(LCIO::TRACKERPULSE);
 
-    std::unique_ptr<CellIDEncoder<TrackerDataImpl>> mc_cluster_raw_encoder = nullptr;
-    std::unique_ptr<CellIDEncoder<TrackerPulseImpl>> mc_cluster_encoder = nullptr;
-    std::unique_ptr<CellIDEncoder<TrackerHitImpl>> mc_hit_encoder = nullptr;
+        LCFlagImpl flag(slot->mc_track->getFlag());
+        flag.setBit(LCIO::TRBIT_HITS);
+        slot->mc_track->setFlag(flag.getFlag());
+
+        slot->mc_cluster_raw_encoder =
+            std::make_unique<CellIDEncoder<TrackerDataImpl>>(eutelescope::gTrackerDataEncoding, slot->mc_cluster_raw);
+        slot->mc_cluster_encoder =
+            std::make_unique<CellIDEncoder<TrackerPulseImpl>>(eutelescope::gTrackerPulseEncoding, slot->mc_cluster);
+        slot->mc_hit_encoder =
+            std::make_unique<CellIDEncoder<TrackerHitImpl>>(eutelescope::gTrackerHitEncoding, slot->mc_hit);
+
+        slot->event->addCollection(slot->mc_track, "mc_track");
+        slot->event->addCollection(slot->mc_hit, "mc_hit");
+        slot->event->addCollection(slot->mc_cluster_raw, "mc_raw_cluster");
+        slot->event->addCollection(slot->mc_cluster, "mc_cluster");
+    }
+    return slot;
+}
 
-    // The detector id is only attached to the message, not the MCParticle, thus we store it here
-    auto mcp_to_det_id = std::map<MCParticle const*, unsigned>{};
-    // Multiple pixel hits can be assigned to a single MCParticle, here we store them in a LCIO 'float vector' to create the
-    // Monte Carlo truth cluster
-    auto mcp_to_pixel_data_vec = std::map<MCParticle const*, std::vector<std::vector<float>>>{};
+/**
+ * Events are allocated until the queue of the writing thread is full, afterwards the events written are reused.
+ */
+LCIOWriterModule::EventSlot* LCIOWriterModule::acquire_slot() {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    if(free_slots_.empty() && slots_.size() <= queue_size_) {
+        slots_.push_back(create_slot());
+        return slots_.back().get();
+    }
 
-    if(dump_mc_truth_ == true) {
-        // Prepare static Monte-Carlo output setup and their CellIDEncoders which are the same every time
-        mc_cluster_vec = new LCCollectionVec(LCIO::TRACKERPULSE);
-        mc_cluster_raw_vec = new LCCollectionVec(LCIO::TRACKERDATA);
-        mc_hit_vec = new LCCollectionVec(LCIO::TRACKERHIT);
-        mc_track_vec = new LCCollectionVec(LCIO::TRACK);
-
-        mc_cluster_raw_encoder =
-            std::make_unique<CellIDEncoder<TrackerDataImpl>>(eutelescope::gTrackerDataEncoding, mc_cluster_raw_vec);
-        mc_cluster_encoder =
-            std::make_unique<CellIDEncoder<TrackerPulseImpl>>(eutelescope::gTrackerPulseEncoding, mc_cluster_vec);
-        mc_hit_encoder = std::make_unique<CellIDEncoder<TrackerHitImpl>>(eutelescope::gTrackerHitEncoding, mc_hit_vec);
+    push_condition_.wait(lock, [this]() { return !free_slots_.empty() || !writer_error_.empty(); });
+    if(!writer_error_.empty()) {
+        throw ModuleError("Writing events to file failed: " + writer_error_);
+    }
+    auto* slot = free_slots_.back();
+    free_slots_.pop_back();
+    return slot;
+}
+
+/**
+ * Objects of the Monte Carlo truth collections are deleted, the collections themselves are kept
+ */
+static void clear_collection(LCCollectionVec* collection) {
+    for(auto* object : *collection) {
+        delete object;
     }
+    collection->clear();
+}
+
+void LCIOWriterModule::run(Event* event) {
+    auto pixel_messages = messenger_->fetchMultiMessage<PixelHitMessage>(this, event);
+
+    auto* slot = acquire_slot();
+    slot->number = event->number;
+    slot->event->setEventNumber(static_cast<int>(event->number)); // set the event attributes
 
     // In LCIO the 'charge vector' is a vector of floats which correspond to hit pixels, depending on the pixel
     // type in EUTelescope the number of entries per pixel varies
-    std::map<unsigned, std::vector<float>> charges;
-    for(auto const& det : detector_names_to_id_) {
-        charges[det.second] = std::vector<float>{};
+    for(auto& detector_data : slot->detector_data) {
+        detector_data.second->chargeValues().clear();
     }
 
+    // The detector id is only attached to the message, not the MCParticle, thus we store it here
+    auto mcp_to_det_id = std::map<MCParticle const*, unsigned>{};
+    // Multiple pixel hits can be assigned to a single MCParticle, here we store their charge values in a LCIO 'float
+    // vector' to create the Monte Carlo truth cluster
+    auto mcp_to_pixel_data_vec = std::map<MCParticle const*, std::vector<float>>{};
+
     // Receive all pixel messages, fill charge vectors
     for(const auto& hit_msg : pixel_messages) {
         LOG(DEBUG) << hit_msg->getDetector()->getName();
-        for(const auto& hitdata : hit_msg->getData()) {
-
-            auto this_hit_charge_vec = std::vector<float>{};
+        unsigned det_id = detector_names_to_id_[hit_msg->getDetector()->getName()];
+        auto& charges = slot->detector_data[det_id]->chargeValues();
 
+        for(const auto& hitdata : hit_msg->getData()) {
             LOG(DEBUG) << "X: " << hitdata.getPixel().getIndex().x() << ", Y:" << hitdata.getPixel().getIndex().y()
                        << ", Signal: " << hitdata.getSignal();
 
-            unsigned det_id = detector_names_to_id_[hit_msg->getDetector()->getName()];
-
-            switch(pixel_type_) {
-            case 1:                                                                               // EUTelSimpleSparsePixel
-                charges[det_id].push_back(static_cast<float>(hitdata.getPixel().getIndex().x())); // x
-                charges[det_id].push_back(static_cast<float>(hitdata.getPixel().getIndex().y())); // y
-                charges[det_id].push_back(static_cast<float>(hitdata.getSignal()));               // signal
-                this_hit_charge_vec.push_back(static_cast<float>(hitdata.getPixel().getIndex().x())); // x
-                this_hit_charge_vec.push_back(static_cast<float>(hitdata.getPixel().getIndex().y())); // y
-                this_hit_charge_vec.push_back(static_cast<float>(hitdata.getSignal()));               // signal
-                break;
-            case 2:  // EUTelGenericSparsePixel
-            default: // EUTelGenericSparsePixel is default
-                charges[det_id].push_back(static_cast<float>(hitdata.getPixel().getIndex().x())); // x
-                charges[det_id].push_back(static_cast<float>(hitdata.getPixel().getIndex().y())); // y
-                charges[det_id].push_back(static_cast<float>(hitdata.getSignal()));               // signal
-                charges[det_id].push_back(0.0);
-                this_hit_charge_vec.push_back(static_cast<float>(hitdata.getPixel().getIndex().x())); // x
-                this_hit_charge_vec.push_back(static_cast<float>(hitdata.getPixel().getIndex().y())); // y
-                this_hit_charge_vec.push_back(static_cast<float>(hitdata.getSignal()));               // signal
-                this_hit_charge_vec.push_back(0.0);                                                   // time
-                break;
-            case 5:                                                                               // EUTelTimepix3SparsePixel
-                charges[det_id].push_back(static_cast<float>(hitdata.getPixel().getIndex().x())); // x
-                charges[det_id].push_back(static_cast<float>(hitdata.getPixel().getIndex().y())); // y
-                charges[det_id].push_back(static_cast<float>(hitdata.getSignal()));               // signal
-                charges[det_id].push_back(0.0);                                                   // time
-                charges[det_id].push_back(0.0);                                                   // time
-                charges[det_id].push_back(0.0);                                                   // time
-                charges[det_id].push_back(0.0);                                                   // time
-                this_hit_charge_vec.push_back(static_cast<float>(hitdata.getPixel().getIndex().x())); // x
-                this_hit_charge_vec.push_back(static_cast<float>(hitdata.getPixel().getIndex().y())); // y
-                this_hit_charge_vec.push_back(static_cast<float>(hitdata.getSignal()));               // signal
-                this_hit_charge_vec.push_back(0.0);                                                   // time
-                this_hit_charge_vec.push_back(0.0);                                                   // time
-                this_hit_charge_vec.push_back(0.0);                                                   // time
-                this_hit_charge_vec.push_back(0.0);                                                   // time
-                break;
-            }
-
-            for(auto const& mcp : hitdata.getMCParticles()) {
-                mcp_to_det_id[mcp] = det_id;
-                mcp_to_pixel_data_vec[mcp].emplace_back(this_hit_charge_vec);
+            // Values of the pixel: x, y and signal, followed by the time values if stored for the pixel type
+            auto pixel = std::array<float, 7>{static_cast<float>(hitdata.getPixel().getIndex().x()),
+                                              static_cast<float>(hitdata.getPixel().getIndex().y()),
+                                              static_cast<float>(hitdata.getSignal())};
+            auto pixel_end = pixel.begin() + static_cast<std::ptrdiff_t>(pixel_values_);
+            charges.insert(charges.end(), pixel.begin(), pixel_end);
+
+            if(dump_mc_truth_) {
+                for(auto const& mcp : hitdata.getMCParticles()) {
+                    mcp_to_det_id[mcp] = det_id;
+                    auto& cluster_charges = mcp_to_pixel_data_vec[mcp];
+                    cluster_charges.insert(cluster_charges.end(), pixel.begin(), pixel_end);
+                }
             }
         }
     }
 
-    // Every track will be linked to at least one (typically multiple) MCParticles and thus TrackerData objects
-    auto mctrk_to_hit_data_vec = std::map<MCTrack const*, std::vector<TrackerHitImpl*>>{};
-
     // A MCParticle will be reflected by an LCIO hit and cluster - the hit is stored in a TrackerHit, the cluster in
     // a TrackerPulse linked to a TrackerData object
     if(dump_mc_truth_ == true) {
+        clear_collection(slot->mc_track);
+        clear_collection(slot->mc_hit);
+        clear_collection(slot->mc_cluster_raw);
+        clear_collection(slot->mc_cluster);
+
+        // Every track will be linked to at least one (typically multiple) MCParticles and thus TrackerData objects
+        auto mctrk_to_hit_data_vec = std::map<MCTrack const*, std::vector<TrackerHitImpl*>>{};
+
+        auto& mc_cluster_raw_encoder = *slot->mc_cluster_raw_encoder;
+        auto& mc_cluster_encoder = *slot->mc_cluster_encoder;
+        auto& mc_hit_encoder = *slot->mc_hit_encoder;
         for(auto& mcp_pixel_data_vec_pair : mcp_to_pixel_data_vec) {
             auto* mc_tracker_data = new TrackerDataImpl();
             auto* mc_tracker_pulse = new TrackerPulseImpl();
@@ -372,24 +411,18 @@ void LCIOWriterModule::run(Event* event) {
 
             const auto& mc_particle = mcp_pixel_data_vec_pair.first;
 
-            // Every detected pixel hit which had charge contribution from this MCParticle will be added to the cluster
-            std::vector<float> truth_cluster_charge_vec;
-            for(auto const& pixel_hit_charge_vec : mcp_pixel_data_vec_pair.second) {
-                truth_cluster_charge_vec.insert(
-                    std::end(truth_cluster_charge_vec), std::begin(pixel_hit_charge_vec), std::end(pixel_hit_charge_vec));
-            }
-
-            mc_tracker_data->setChargeValues(truth_cluster_charge_vec);
-            (*mc_cluster_raw_encoder)["sensorID"] = mcp_to_det_id[mc_particle];
-            (*mc_cluster_raw_encoder)["sparsePixelType"] = pixel_type_;
-            mc_cluster_raw_encoder->setCellID(mc_tracker_data);
-            mc_cluster_raw_vec->push_back(mc_tracker_data);
+            // Every detected pixel hit which had charge contribution from this MCParticle is part of the cluster
+            mc_tracker_data->chargeValues().swap(mcp_pixel_data_vec_pair.second);
+            mc_cluster_raw_encoder["sensorID"] = mcp_to_det_id[mc_particle];
+            mc_cluster_raw_encoder["sparsePixelType"] = pixel_type_;
+            mc_cluster_raw_encoder.setCellID(mc_tracker_data);
+            slot->mc_cluster_raw->push_back(mc_tracker_data);
 
             mc_tracker_pulse->setTrackerData(mc_tracker_data);
-            (*mc_cluster_encoder)["sensorID"] = mcp_to_det_id[mc_particle];
-            (*mc_cluster_encoder)["type"] = 1; // corresponds to kEUTelGenericSparseClusterImpl
-            mc_cluster_encoder->setCellID(mc_tracker_pulse);
-            mc_cluster_vec->push_back(mc_tracker_pulse);
+            mc_cluster_encoder["sensorID"] = mcp_to_det_id[mc_particle];
+            mc_cluster_encoder["type"] = 1; // corresponds to kEUTelGenericSparseClusterImpl
+            mc_cluster_encoder.setCellID(mc_tracker_pulse);
+            slot->mc_cluster->push_back(mc_tracker_pulse);
 
             // we take the centre of the MCParticle to be the global z-position
             auto const& hit_start_pos = mc_particle->getGlobalStartPoint();
@@ -399,64 +432,161 @@ void LCIOWriterModule::run(Event* event) {
                                                   0.5 * (hit_start_pos.z() + hit_end_pos.z())}};
             mc_tracker_hit->setPosition(pos_arr.data());
             mc_tracker_hit->setType(1); // corresponds to kEUTelGenericSparseClusterImpl
-            (*mc_hit_encoder)["sensorID"] = mcp_to_det_id[mc_particle];
+            mc_hit_encoder["sensorID"] = mcp_to_det_id[mc_particle];
 
             int hit_properties = eutelescope::HitProperties::kHitInGlobalCoord + eutelescope::HitProperties::kSimulatedHit;
             if(mc_particle->getTrack()->getParent() != nullptr) {
                 hit_properties += eutelescope::HitProperties::kDeltaHit;
             }
-            (*mc_hit_encoder)["properties"] = hit_properties;
+            mc_hit_encoder["properties"] = hit_properties;
 
-            mc_hit_encoder->setCellID(mc_tracker_hit);
+            mc_hit_encoder.setCellID(mc_tracker_hit);
             mc_tracker_hit->rawHits() = std::vector<LCObject*>{mc_tracker_data};
-            mc_hit_vec->push_back(mc_tracker_hit);
+            slot->mc_hit->push_back(mc_tracker_hit);
             mctrk_to_hit_data_vec[mc_particle->getTrack()].emplace_back(mc_tracker_hit);
         }
-    }
-    // Fill hitvector with event data
-    for(auto const& det_id_name_pair : detector_names_to_id_) {
-        auto det_id = det_id_name_pair.second;
-        auto* hit = new TrackerDataImpl();
-        hit->setChargeValues(charges[det_id]);
-        auto col_index = detector_ids_to_colllection_index_[det_id];
-        (*output_col_encoder_vec[col_index])["sensorID"] = det_id;
-        (*output_col_encoder_vec[col_index])["sparsePixelType"] = pixel_type_;
-        output_col_encoder_vec[col_index]->setCellID(hit);
-        output_col_vec[col_index]->push_back(hit);
-    }
 
-    if(dump_mc_truth_ == true) {
-        LCFlagImpl flag(mc_track_vec->getFlag());
-        flag.setBit(LCIO::TRBIT_HITS);
-        mc_track_vec->setFlag(flag.getFlag());
         for(auto& pair : mctrk_to_hit_data_vec) {
             auto* track = new TrackImpl();
             for(auto& hit : pair.second) {
-                // std::cout << "Got hit: " << hit << " z-pos: " << hit->getPosition()[2] << '\n';
                 track->addHit(hit);
             }
-            mc_track_vec->push_back(track);
+            slot->mc_track->push_back(track);
         }
+    }
+
+    if(!asynchronous_) {
+        write_event(slot);
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        free_slots_.push_back(slot);
+        return;
+    }
+
+    // Hand the event to the writing thread
+    slot->log_section = Log::getSection();
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        LOG(TRACE) << "Handing event " << slot->number << " to the writing thread";
+        queue_.push_back(slot);
+    }
+    pop_condition_.notify_one();
+}
 
-        // Add collection to event and write event to LCIO file
-        evt->addCollection(mc_track_vec, "mc_track");
-        evt->addCollection(mc_hit_vec, "mc_hit");
-        evt->addCollection(mc_cluster_raw_vec, "mc_raw_cluster");
-        evt->addCollection(mc_cluster_vec, "mc_cluster");
+/**
+ * Every file of a split output starts with the run header, such that it can be read on its own.
+ */
+void LCIOWriterModule::open_output_file() {
+    auto file_name = file_name_;
+    if(rotation_.enabled()) {
+        file_name = OutputRotation::chunk_name(file_name, rotation_.chunks().size() + 1);
+    }
+    lcio_file_name_ = createOutputFile(file_name, "slcio");
+    lcWriter_->open(lcio_file_name_, LCIO::WRITE_NEW);
+    auto run = std::make_unique<LCRunHeaderImpl>();
+    run->setRunNumber(1);
+    run->setDetectorName(detector_name_);
+    lcWriter_->writeRunHeader(run.get());
+    if(rotation_.enabled()) {
+        rotation_.open(lcio_file_name_);
     }
-    for(size_t i = 0; i < collection_names_vector_.size(); i++) {
-        evt->addCollection(output_col_vec[i], collection_names_vector_[i]);
+}
+
+/**
+ * The size of a chunk is taken from the file on disk, which does not include the data still buffered by LCIO.
+ */
+void LCIOWriterModule::write_event(EventSlot* slot) {
+    if(rotation_.enabled()) {
+        std::error_code error;
+        auto bytes = std::filesystem::file_size(lcio_file_name_, error);
+        if(rotation_.full(error ? 0 : bytes)) {
+            lcWriter_->close();
+            LOG(INFO) << "Closed output file " << lcio_file_name_ << " with " << rotation_.chunks().back().events
+                      << " events";
+            open_output_file();
+        }
+        rotation_.add_event(slot->number);
     }
 
-    lcWriter_->writeEvent(evt.get()); // write the event to the file
+    lcWriter_->writeEvent(slot->event.get());
     write_cnt_++;
 }
 
+/**
+ * The writing thread writes the events in the order they have been queued, which is the order of the events since this
+ * module is sequential. Errors are stored and reported by the next event requesting a free LCIO event.
+ */
+void LCIOWriterModule::run_writer(LogLevel log_level, LogFormat log_format) {
+    Log::setReportingLevel(log_level);
+    Log::setFormat(log_format);
+
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    while(true) {
+        pop_condition_.wait(lock, [this]() { return !queue_.empty() || stop_writer_; });
+        if(queue_.empty()) {
+            return;
+        }
+
+        auto* slot = queue_.front();
+        queue_.pop_front();
+        lock.unlock();
+
+        Log::setSection(slot->log_section);
+        Log::setEventNum(slot->number);
+        std::string error;
+        try {
+            write_event(slot);
+        } catch(const std::exception& e) {
+            error = e.what();
+        }
+
+        lock.lock();
+        free_slots_.push_back(slot);
+        if(!error.empty()) {
+            // Discard all pending events and wake up the waiting worker to report the error
+            writer_error_ = error;
+            free_slots_.insert(free_slots_.end(), queue_.begin(), queue_.end());
+            queue_.clear();
+            push_condition_.notify_all();
+            return;
+        }
+        push_condition_.notify_one();
+    }
+}
+
+void LCIOWriterModule::stop_writer() {
+    if(!writer_thread_.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        stop_writer_ = true;
+    }
+    pop_condition_.notify_one();
+    writer_thread_.join();
+}
+
 void LCIOWriterModule::finalize() {
+    // Write all queued events before closing the file
+    stop_writer();
+    if(!writer_error_.empty()) {
+        throw ModuleError("Writing events to file failed: " + writer_error_);
+    }
     lcWriter_->close();
     // Print statistics
     LOG(STATUS) << "Wrote " << write_cnt_ << " events to file:" << std::endl << lcio_file_name_;
 
+    if(rotation_.enabled()) {
+        auto manifest_name = createOutputFile(file_name_, "manifest");
+        try {
+            rotation_.write_manifest(manifest_name);
+        } catch(const std::runtime_error& e) {
+            throw ModuleError(e.what());
+        }
+        LOG(STATUS) << "Wrote " << rotation_.chunks().size() << " output files listed in manifest:" << std::endl
+                    << manifest_name;
+    }
+
     // Write geometry:
     std::ofstream geometry_file;
     if(!geometry_file_name_.empty()) {
@@ -7,7 +7,13 @@
  * Intergovernmental Organization or submit itself to any jurisdiction.
  */
 
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "core/config/Configuration.hpp"
@@ -15,10 +21,19 @@
 #include "core/messenger/Messenger.hpp"
 #include "core/module/Event.hpp"
 #include "core/module/Module.hpp"
+#include "core/utils/log.h"
 
 #include "objects/PixelHit.hpp"
 
+#include "tools/output_rotation.h"
+
+#include <IMPL/LCCollectionVec.h>
+#include <IMPL/LCEventImpl.h>
+#include <IMPL/TrackerDataImpl.h>
+#include <IMPL/TrackerHitImpl.h>
+#include <IMPL/TrackerPulseImpl.h>
 #include <IO/LCWriter.h>
+#include <UTIL/CellIDEncoder.h>
 
 namespace allpix {
 
@@ -26,7 +41,8 @@ namespace allpix {
      * @ingroup Modules
      * @brief Module to write hit data to LCIO file
      *
-     * Create LCIO file, compatible to EUTelescope analysis framework.
+     * Create LCIO file, compatible to EUTelescope analysis framework. The LCIO events and their collections are allocated
+     * once and reused for all events, events are written to file by a separate thread while the next events are processed.
      */
     class LCIOWriterModule : public SequentialModule {
     public:
@@ -38,7 +54,10 @@ namespace allpix {
          */
         LCIOWriterModule(Configuration& config, Messenger* messenger, GeometryManager* geo_manager);
 
-        ~LCIOWriterModule(){};
+        /**
+         * @brief Stop the writing thread if it is still running
+         */
+        ~LCIOWriterModule() override;
 
         /**
          * @brief Initialize LCIO and GEAR output files
@@ -56,6 +75,64 @@ namespace allpix {
         void finalize() override;
 
     private:
+        /**
+         * @brief LCIO event with all its collections, reused for many events
+         */
+        struct EventSlot {
+            std::unique_ptr<IMPL::LCEventImpl> event;
+
+            // Pixel data of every detector by sensor id, owned by the output collections of the event
+            std::map<unsigned, IMPL::TrackerDataImpl*> detector_data;
+
+            // Collections of the Monte Carlo truth and their encoders, owned by the event
+            IMPL::LCCollectionVec* mc_track{};
+            IMPL::LCCollectionVec* mc_hit{};
+            IMPL::LCCollectionVec* mc_cluster_raw{};
+            IMPL::LCCollectionVec* mc_cluster{};
+            std::unique_ptr<UTIL::CellIDEncoder<IMPL::TrackerDataImpl>> mc_cluster_raw_encoder;
+            std::unique_ptr<UTIL::CellIDEncoder<IMPL::TrackerPulseImpl>> mc_cluster_encoder;
+            std::unique_ptr<UTIL::CellIDEncoder<IMPL::TrackerHitImpl>> mc_hit_encoder;
+
+            // Log section and number of the event currently stored
+            std::string log_section;
+            uint64_t number{};
+        };
+
+        /**
+         * @brief Create an LCIO event with all output collections
+         * @return Event with empty collections
+         */
+        std::unique_ptr<EventSlot> create_slot() const;
+
+        /**
+         * @brief Get an event which is not being written, waiting for the writing thread if needed
+         * @return Event to fill
+         */
+        EventSlot* acquire_slot();
+
+        /**
+         * @brief Open the output file, or the file of the next chunk if the output is split, and write the run header
+         */
+        void open_output_file();
+
+        /**
+         * @brief Write an event to the output file, starting a new chunk first if the current one is full
+         * @param slot Event to write
+         */
+        void write_event(EventSlot* slot);
+
+        /**
+         * @brief Writes the queued events in the background until the writing thread is stopped
+         * @param log_level Reporting level of the logger for the writing thread
+         * @param log_format Format of the logger for the writing thread
+         */
+        void run_writer(LogLevel log_level, LogFormat log_format);
+
+        /**
+         * @brief Waits until all queued events have been written and stops the writing thread
+         */
+        void stop_writer();
+
         Messenger* messenger_;
         GeometryManager* geo_mgr_{};
         std::shared_ptr<IO::LCWriter> lcWriter_{};
@@ -66,11 +143,29 @@ namespace allpix {
         std::map<std::string, std::vector<std::string>> collections_to_detectors_map_;
 
         int pixel_type_;
+        size_t pixel_values_{};
 
         bool dump_mc_truth_;
         std::string detector_name_;
         std::string lcio_file_name_;
+        std::string file_name_;
+        OutputRotation rotation_;
         std::string geometry_file_name_;
         std::atomic<int> write_cnt_{0};
+
+        // Events allocated for reuse, events free to fill and events queued for the writing thread
+        std::vector<std::unique_ptr<EventSlot>> slots_;
+        std::vector<EventSlot*> free_slots_;
+        std::deque<EventSlot*> queue_;
+
+        // Writing thread and its synchronization
+        bool asynchronous_{};
+        size_t queue_size_{};
+        std::thread writer_thread_;
+        std::mutex queue_mutex_;
+        std::condition_variable push_condition_;
+        std::condition_variable pop_condition_;
+        bool stop_writer_{false};
+        std::string writer_error_;
     };
 } // namespace allpix
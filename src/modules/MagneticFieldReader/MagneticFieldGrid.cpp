@@ -0,0 +1,102 @@
+/**
+ * @file
+ * @brief Implementation of a gridded magnetic field with trilinear interpolation
+ * @copyright Copyright (c) 2017-2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "MagneticFieldGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace allpix;
+
+/**
+ * The tiles and the bins within a tile are both stored in x-major order, the same order as used by the field files.
+ */
+MagneticFieldGrid::MagneticFieldGrid(const FieldData<double>& field_data, const ROOT::Math::XYZPoint& center)
+    : dimensions_(field_data.getDimensions()), size_(field_data.getSize()) {
+    if(field_data.getEntries() != dimensions_[0] * dimensions_[1] * dimensions_[2] * 3) {
+        throw std::invalid_argument("magnetic field requires three components for every bin");
+    }
+    if(!field_data.getZEdges().empty()) {
+        throw std::invalid_argument("magnetic field requires uniform binning along all axes");
+    }
+
+    std::array<double, 3> center_coordinates{center.x(), center.y(), center.z()};
+    for(size_t d = 0; d < 3; ++d) {
+        if(dimensions_[d] == 0 || size_[d] <= 0) {
+            throw std::invalid_argument("magnetic field grid has no extent along one of its axes");
+        }
+        lower_edge_[d] = center_coordinates[d] - size_[d] / 2.;
+        tiles_[d] = (dimensions_[d] + tile_size_ - 1) / tile_size_;
+    }
+
+    field_.resize(tiles_[0] * tiles_[1] * tiles_[2] * tile_size_ * tile_size_ * tile_size_ * 3);
+    const auto* data = field_data.getRawData().get();
+    for(size_t x = 0; x < dimensions_[0]; ++x) {
+        for(size_t y = 0; y < dimensions_[1]; ++y) {
+            for(size_t z = 0; z < dimensions_[2]; ++z) {
+                auto index = get_tiled_index(x, y, z);
+                for(size_t i = 0; i < 3; ++i) {
+                    field_[index + i] = *data++;
+                }
+            }
+        }
+    }
+}
+
+size_t MagneticFieldGrid::get_tiled_index(size_t x, size_t y, size_t z) const {
+    auto tile = ((x / tile_size_) * tiles_[1] + y / tile_size_) * tiles_[2] + z / tile_size_;
+    auto bin = ((x % tile_size_) * tile_size_ + y % tile_size_) * tile_size_ + z % tile_size_;
+    return (tile * tile_size_ * tile_size_ * tile_size_ + bin) * 3;
+}
+
+/**
+ * Between the outermost bin centers and the edges of the grid the value of the outermost bin is kept.
+ */
+ROOT::Math::XYZVector MagneticFieldGrid::get(const ROOT::Math::XYZPoint& position) const {
+    std::array<double, 3> coordinates{position.x(), position.y(), position.z()};
+    std::array<size_t, 3> lower{};
+    std::array<size_t, 3> upper{};
+    std::array<double, 3> fraction{};
+    for(size_t d = 0; d < 3; ++d) {
+        // Map to the bin center coordinates, the bin N extends from N-0.5 to N+0.5
+        auto bins = static_cast<double>(dimensions_[d]);
+        auto coord = bins * (coordinates[d] - lower_edge_[d]) / size_[d] - 0.5;
+        if(coord < -0.5 || coord >= bins - 0.5) {
+            return {};
+        }
+        coord = std::clamp(coord, 0., bins - 1.);
+        auto base = std::floor(coord);
+        lower[d] = static_cast<size_t>(base);
+        upper[d] = std::min(lower[d] + 1, dimensions_[d] - 1);
+        fraction[d] = coord - base;
+    }
+
+    // Accumulate the weighted values of the eight neighboring bins
+    std::array<double, 3> values{};
+    for(size_t corner = 0; corner < 8; ++corner) {
+        double weight = 1.;
+        std::array<size_t, 3> bin{};
+        for(size_t d = 0; d < 3; ++d) {
+            auto high = ((corner >> d) & 1u) != 0;
+            bin[d] = (high ? upper[d] : lower[d]);
+            weight *= (high ? fraction[d] : 1. - fraction[d]);
+        }
+        if(weight == 0.) {
+            continue;
+        }
+
+        const auto* tiled = field_.data() + get_tiled_index(bin[0], bin[1], bin[2]);
+        for(size_t i = 0; i < 3; ++i) {
+            values[i] += weight * tiled[i];
+        }
+    }
+
+    return {values[0], values[1], values[2]};
+}
@@ -0,0 +1,65 @@
+/**
+ * @file
+ * @brief Definition of a gridded magnetic field with trilinear interpolation
+ * @copyright Copyright (c) 2017-2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_MAGNETIC_FIELD_GRID_H
+#define ALLPIX_MAGNETIC_FIELD_GRID_H
+
+#include <array>
+#include <vector>
+
+#include <Math/Point3D.h>
+#include <Math/Vector3D.h>
+
+#include "tools/field_parser.h"
+
+namespace allpix {
+    /**
+     * @brief Magnetic field defined on a regular three-dimensional grid in global coordinates
+     *
+     * The field values are assumed to be located at the bin centers and are interpolated trilinearly between the eight
+     * surrounding bins. The grid is stored in cubic tiles of neighboring bins, such that the bins used for one lookup mostly
+     * share a cache line. Outside of the grid the magnetic field is zero.
+     */
+    class MagneticFieldGrid {
+    public:
+        /**
+         * @brief Construct the grid from parsed field data
+         * @param field_data Field data with three components per bin, in internal units
+         * @param center Position of the center of the grid in global coordinates
+         */
+        MagneticFieldGrid(const FieldData<double>& field_data, const ROOT::Math::XYZPoint& center);
+
+        /**
+         * @brief Get the interpolated magnetic field at a global position
+         * @param position Position in global coordinates
+         * @return Magnetic field vector, zero outside of the grid
+         */
+        ROOT::Math::XYZVector get(const ROOT::Math::XYZPoint& position) const;
+
+    private:
+        /**
+         * @brief Calculate the offset of a bin in the tiled storage
+         * @param x Bin index along x
+         * @param y Bin index along y
+         * @param z Bin index along z
+         * @return Offset of the first component of the bin
+         */
+        size_t get_tiled_index(size_t x, size_t y, size_t z) const;
+
+        std::array<size_t, 3> dimensions_{};
+        std::array<double, 3> size_{};
+        std::array<double, 3> lower_edge_{};
+
+        static constexpr size_t tile_size_{4};
+        std::array<size_t, 3> tiles_{};
+        std::vector<double> field_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_MAGNETIC_FIELD_GRID_H */
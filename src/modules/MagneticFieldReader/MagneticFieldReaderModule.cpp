@@ -35,30 +35,71 @@ MagneticFieldReaderModule::MagneticFieldReaderModule(Configuration& config, Mess
 }
 
 void MagneticFieldReaderModule::initialize() {
-    MagneticFieldType type = MagneticFieldType::NONE;
-
     // Check field strength
     auto field_model = config_.get<MagneticField>("model");
 
     // Calculate the field depending on the configuration
     if(field_model == MagneticField::CONSTANT) {
         LOG(TRACE) << "Adding constant magnetic field";
-        type = MagneticFieldType::CONSTANT;
 
         auto b_field = config_.get<ROOT::Math::XYZVector>("magnetic_field", ROOT::Math::XYZVector());
 
         MagneticFieldFunction function = [b_field](const ROOT::Math::XYZPoint&) { return b_field; };
 
-        geometryManager_->setMagneticFieldFunction(function, type);
+        geometryManager_->setMagneticFieldFunction(function, MagneticFieldType::CONSTANT);
         auto detectors = geometryManager_->getDetectors();
         for(auto& detector : detectors) {
-            // TODO the magnetic field is calculated once for the center position of the detector. This could be extended to
-            // a function enabling a gradient in the magnetic field inside the sensor
             detector->setMagneticField(detector->getOrientation().Inverse() *
                                        geometryManager_->getMagneticField(detector->getPosition()));
             LOG(DEBUG) << "Magnetic field in detector " << detector->getName() << ": "
                        << Units::display(detector->getMagneticField(), {"T", "mT"});
         }
         LOG(INFO) << "Set constant magnetic field: " << Units::display(b_field, {"T", "mT"});
+    } else if(field_model == MagneticField::MESH) {
+        LOG(TRACE) << "Adding magnetic field from mesh file";
+
+        auto grid = read_field();
+
+        // The same grid is looked up by Geant4 and by the propagation in all detectors
+        MagneticFieldFunction function = [grid](const ROOT::Math::XYZPoint& pos) { return grid->get(pos); };
+        geometryManager_->setMagneticFieldFunction(function, MagneticFieldType::CUSTOM);
+
+        auto detectors = geometryManager_->getDetectors();
+        for(auto& detector : detectors) {
+            // Evaluate the field at the global position and rotate it into the local frame of the detector
+            const Detector* det = detector.get();
+            auto inverse_orientation = detector->getOrientation().Inverse();
+            detector->setMagneticFieldFunction(
+                inverse_orientation * grid->get(detector->getPosition()),
+                [grid, det, inverse_orientation](const ROOT::Math::XYZPoint& pos) {
+                    return inverse_orientation * grid->get(det->getGlobalPosition(pos));
+                });
+            LOG(DEBUG) << "Magnetic field at the center of detector " << detector->getName() << ": "
+                       << Units::display(detector->getMagneticField(), {"T", "mT"});
+        }
+    }
+}
+
+/**
+ * The field data read from files are shared between module instantiations using the static
+ * FieldParser's getByFileName method.
+ */
+FieldParser<double> MagneticFieldReaderModule::field_parser_(FieldQuantity::VECTOR);
+std::shared_ptr<MagneticFieldGrid> MagneticFieldReaderModule::read_field() {
+    try {
+        auto field_data = field_parser_.getByFileName(
+            config_.getPath("file_name", true), "T", config_.get<bool>("shared_memory", false));
+        auto grid = std::make_shared<MagneticFieldGrid>(
+            field_data, config_.get<ROOT::Math::XYZPoint>("field_center", ROOT::Math::XYZPoint()));
+
+        LOG(INFO) << "Set magnetic field with " << field_data.getDimensions().at(0) << "x"
+                  << field_data.getDimensions().at(1) << "x" << field_data.getDimensions().at(2) << " cells";
+        return grid;
+    } catch(std::invalid_argument& e) {
+        throw InvalidValueError(config_, "file_name", e.what());
+    } catch(std::runtime_error& e) {
+        throw InvalidValueError(config_, "file_name", e.what());
+    } catch(std::bad_alloc& e) {
+        throw InvalidValueError(config_, "file_name", "file too large");
     }
 }
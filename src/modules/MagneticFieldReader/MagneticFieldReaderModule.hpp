@@ -17,14 +17,17 @@
 #include "core/messenger/Messenger.hpp"
 
 #include "core/module/Module.hpp"
+#include "tools/field_parser.h"
+
+#include "MagneticFieldGrid.hpp"
 
 namespace allpix {
     /**
      * @ingroup Modules
      * @brief Module to define magnetic fields
      *
-     * Read the model of the magnetic field from the config during initialization and apply a constant field throughout the
-     * whole volume
+     * Read the model of the magnetic field from the config during initialization and apply either a constant field
+     * throughout the whole volume or a field interpolated from a grid read from a mesh file
      */
     class MagneticFieldReaderModule : public Module {
         /**
@@ -32,6 +35,7 @@ namespace allpix {
          */
         enum class MagneticField {
             CONSTANT, ///< Constant magnetic field
+            MESH,     ///< Magnetic field defined on a grid read from a file
         };
 
     public:
@@ -50,5 +54,13 @@ namespace allpix {
 
     private:
         GeometryManager* geometryManager_;
+
+        /**
+         * @brief Read the magnetic field grid from the configured mesh file
+         * @return Shared pointer to the magnetic field grid
+         */
+        std::shared_ptr<MagneticFieldGrid> read_field();
+
+        static FieldParser<double> field_parser_;
     };
 } // namespace allpix
@@ -6,17 +6,21 @@
 
 #include "ProjectionPropagationModule.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <functional>
 #include <limits>
 #include <string>
 #include <utility>
 
+#include <Eigen/Core>
+
 #include "core/messenger/Messenger.hpp"
 #include "core/utils/distributions.h"
 #include "core/utils/log.h"
 #include "objects/DepositedCharge.hpp"
 #include "objects/PropagatedCharge.hpp"
+#include "tools/runge_kutta.h"
 
 using namespace allpix;
 
@@ -40,11 +44,56 @@ ProjectionPropagationModule::ProjectionPropagationModule(Configuration& config,
     config_.setDefault<bool>("output_plots", false);
     config_.setDefault<bool>("diffuse_deposit", false);
     config_.setDefault<std::string>("recombination_model", "none");
+    config_.setDefault<bool>("mobility_table", false);
+    config_.setDefault<double>("mobility_table_precision", 1e-4);
+    config_.setDefault<std::string>("mobility_model", "jacoboni");
+    config_.setDefault<bool>("drift_map", false);
+    config_.setDefault<bool>("analytic_sharing", false);
+    config_.setDefault<bool>("hybrid_propagation", false);
+    config_.setDefault<double>("hybrid_edge_distance", Units::get(1, "um"));
+    config_.setDefault<double>("hybrid_min_field", Units::get(1000, "V/cm"));
+    config_.setDefault<double>("hybrid_max_field_variation", 0.2);
+    config_.setDefault<double>("drift_map_timestep", Units::get(0.01, "ns"));
+    config_.setDefault<ROOT::Math::DisplacementVector3D<ROOT::Math::Cartesian3D<unsigned int>>>(
+        "drift_map_bins", ROOT::Math::DisplacementVector3D<ROOT::Math::Cartesian3D<unsigned int>>(11, 11, 51));
 
     integration_time_ = config_.get<double>("integration_time");
     output_plots_ = config_.get<bool>("output_plots");
     diffuse_deposit_ = config_.get<bool>("diffuse_deposit");
     charge_per_step_ = config_.get<unsigned int>("charge_per_step");
+    analytic_sharing_ = config_.get<bool>("analytic_sharing");
+
+    // Precompute the drift in the electric field instead of approximating it for linear fields
+    drift_map_ = config_.get<bool>("drift_map");
+    if(drift_map_) {
+        drift_map_timestep_ = config_.get<double>("drift_map_timestep");
+        if(drift_map_timestep_ <= 0) {
+            throw InvalidValueError(config_, "drift_map_timestep", "time step has to be positive");
+        }
+        auto bins = config_.get<ROOT::Math::DisplacementVector3D<ROOT::Math::Cartesian3D<unsigned int>>>("drift_map_bins");
+        if(bins.x() < 2 || bins.y() < 2 || bins.z() < 2) {
+            throw InvalidValueError(config_, "drift_map_bins", "at least two points are required in every dimension");
+        }
+        drift_map_bins_ = {bins.x(), bins.y(), bins.z()};
+    }
+
+    // Propagate carriers in regions where the interpolation of the drift map is inaccurate with the full drift-diffusion
+    hybrid_propagation_ = config_.get<bool>("hybrid_propagation");
+    if(hybrid_propagation_) {
+        if(!drift_map_) {
+            throw InvalidCombinationError(
+                config_, {"hybrid_propagation", "drift_map"}, "the hybrid propagation requires the drift map");
+        }
+        hybrid_edge_distance_ = config_.get<double>("hybrid_edge_distance");
+        hybrid_min_field_ = config_.get<double>("hybrid_min_field");
+        hybrid_max_field_variation_ = config_.get<double>("hybrid_max_field_variation");
+        if(hybrid_edge_distance_ < 0) {
+            throw InvalidValueError(config_, "hybrid_edge_distance", "distance cannot be negative");
+        }
+        if(hybrid_max_field_variation_ <= 0) {
+            throw InvalidValueError(config_, "hybrid_max_field_variation", "relative variation has to be positive");
+        }
+    }
 
     // Set default for charge carrier propagation:
     config_.setDefault<bool>("propagate_holes", false);
@@ -55,11 +104,10 @@ ProjectionPropagationModule::ProjectionPropagationModule(Configuration& config,
         propagate_type_ = CarrierType::ELECTRON;
     }
 
-    auto temperature = config_.get<double>("temperature");
+    temperature_ = config_.get<double>("temperature");
+    auto temperature = temperature_;
     boltzmann_kT_ = Units::get(8.6173e-5, "eV/K") * temperature;
 
-    // Mobility fixed to Jacoboni:
-    mobility_ = Mobility("jacoboni", temperature);
     // We need direct access to the critical field values of the model since we have a discrete integration of the formula
     // for the total drift time. Taken from https://doi.org/10.1016/0038-1101(77)90054-5 (section 5.2)
     electron_Ec_ = Units::get(1.01 * std::pow(temperature, 1.55), "V/cm");
@@ -69,12 +117,35 @@ ProjectionPropagationModule::ProjectionPropagationModule(Configuration& config,
 }
 
 void ProjectionPropagationModule::initialize() {
-    if(detector_->getElectricFieldType() != FieldType::LINEAR) {
-        throw ModuleError("This module should only be used with linear electric fields.");
+    // Mobility fixed to Jacoboni for the analytic drift time, the drift map can use any model
+    auto mobility_model = config_.get<std::string>("mobility_model");
+    if(!drift_map_ && mobility_model != "jacoboni") {
+        throw InvalidValueError(
+            config_, "mobility_model", "the analytic drift time requires the Jacoboni model, enable the drift map instead");
+    }
+    try {
+        mobility_ = Mobility(mobility_model, temperature_, drift_map_ && detector_->hasDopingProfile());
+    } catch(ModelError& e) {
+        throw InvalidValueError(config_, "mobility_model", e.what());
     }
 
-    if(detector_->hasDopingProfile() && detector_->getDopingProfileType() != FieldType::CONSTANT) {
-        throw ModuleError("This module should only be used with constant doping concentration.");
+    // Replace the mobility model by a lookup table if requested
+    if(config_.get<bool>("mobility_table")) {
+        auto precision = config_.get<double>("mobility_table_precision");
+        if(precision <= 0) {
+            throw InvalidValueError(config_, "mobility_table_precision", "precision of the table has to be positive");
+        }
+        auto error = mobility_.tabulate(precision);
+        LOG(INFO) << "Using tabulated mobility model with a maximum relative interpolation error of " << error;
+    }
+
+    if(!drift_map_ && detector_->getElectricFieldType() != FieldType::LINEAR) {
+        throw ModuleError("This module should only be used with linear electric fields, unless the drift map is enabled.");
+    }
+
+    if(!drift_map_ && detector_->hasDopingProfile() && detector_->getDopingProfileType() != FieldType::CONSTANT) {
+        throw ModuleError("This module should only be used with constant doping concentration, unless the drift map is "
+                          "enabled.");
     }
 
     // Prepare recombination model
@@ -105,6 +176,10 @@ void ProjectionPropagationModule::initialize() {
                "field is wrong!";
     }
 
+    if(drift_map_) {
+        create_drift_map();
+    }
+
     if(output_plots_) {
         // Initialize output plots
         propagation_time_histo_ =
@@ -182,11 +257,9 @@ void ProjectionPropagationModule::run(Event* event) {
 
             auto position = initial_position;
 
-            // Get the electric field at the position of the deposited charge and the top of the sensor:
+            // Get the electric field at the position of the deposited charge:
             auto efield = detector_->getElectricField(position);
             double efield_mag = std::sqrt(efield.Mag2());
-            auto efield_top = detector_->getElectricField(ROOT::Math::XYZPoint(0., 0., top_z_));
-            double efield_mag_top = std::sqrt(efield_top.Mag2());
             double doping = detector_->getDopingConcentration(position);
             double diffusion_time = 0;
 
@@ -248,29 +321,59 @@ void ProjectionPropagationModule::run(Event* event) {
                 LOG(TRACE) << " ... and a diffusion time prior to the drift of " << Units::display(diffusion_time, "ns");
             }
 
-            LOG(TRACE) << "Electric field at carrier position / top of the sensor: "
-                       << Units::display(efield_mag_top, "V/cm") << " , " << Units::display(efield_mag, "V/cm");
-
-            auto slope_efield = (efield_mag_top - efield_mag) / (std::abs(top_z_ - position.z()));
-
-            // Calculate the drift time
-            auto calc_drift_time = [&]() {
-                if(position.z() == top_z_) {
-                    return 0.;
+            double drift_time = 0;
+            double diffusion_std_dev = 0;
+            ROOT::Math::XYZVector drift_displacement;
+            if(drift_map_) {
+                // Interpolate the drift of carriers starting close to this position, unless the full drift-diffusion is
+                // required there
+                std::optional<DriftMapEntry> drift;
+                if(hybrid_propagation_ && requires_full_propagation(position)) {
+                    drift = integrate_drift(position, &event->getRandomEngine());
+                    if(!drift->valid) {
+                        drift.reset();
+                    }
+                    full_charge_sets_++;
+                } else {
+                    drift = lookup_drift_map(position);
+                }
+                total_charge_sets_++;
+                if(!drift.has_value()) {
+                    LOG(TRACE) << "Charge carrier does not reach the sensor surface from "
+                               << Units::display(position, {"mm", "um"});
+                    continue;
                 }
+                drift_time = drift->time;
+                diffusion_std_dev = drift->sigma;
+                drift_displacement = ROOT::Math::XYZVector(drift->dx, drift->dy, 0);
+            } else {
+                auto efield_top = detector_->getElectricField(ROOT::Math::XYZPoint(0., 0., top_z_));
+                double efield_mag_top = std::sqrt(efield_top.Mag2());
+                LOG(TRACE) << "Electric field at carrier position / top of the sensor: "
+                           << Units::display(efield_mag_top, "V/cm") << " , " << Units::display(efield_mag, "V/cm");
+
+                auto slope_efield = (efield_mag_top - efield_mag) / (std::abs(top_z_ - position.z()));
+
+                // Calculate the drift time
+                auto calc_drift_time = [&]() {
+                    if(position.z() == top_z_) {
+                        return 0.;
+                    }
 
-                double Ec = (type == CarrierType::ELECTRON ? electron_Ec_ : hole_Ec_);
+                    double Ec = (type == CarrierType::ELECTRON ? electron_Ec_ : hole_Ec_);
 
-                return ((log(efield_mag_top) - log(efield_mag)) / slope_efield + std::abs(top_z_ - position.z()) / Ec) /
-                       mobility_(type, 0, doping);
-            };
-            LOG(TRACE) << "Electric field is " << Units::display(efield_mag, "V/cm");
+                    return ((log(efield_mag_top) - log(efield_mag)) / slope_efield + std::abs(top_z_ - position.z()) / Ec) /
+                           mobility_(type, 0, doping);
+                };
+                LOG(TRACE) << "Electric field is " << Units::display(efield_mag, "V/cm");
 
-            // Assume linear electric field over the depleted part of the sensor
-            double diffusion_constant =
-                boltzmann_kT_ * (mobility_(type, efield_mag, doping) + mobility_(type, efield_mag_top, doping)) / 2.;
+                // Assume linear electric field over the depleted part of the sensor
+                double diffusion_constant =
+                    boltzmann_kT_ * (mobility_(type, efield_mag, doping) + mobility_(type, efield_mag_top, doping)) / 2.;
 
-            double drift_time = calc_drift_time();
+                drift_time = calc_drift_time();
+                diffusion_std_dev = std::sqrt(2. * diffusion_constant * drift_time);
+            }
             double propagation_time = deposit.getLocalTime() + drift_time + diffusion_time;
             LOG(TRACE) << "Drift time is " << Units::display(drift_time, "ns");
 
@@ -282,7 +385,6 @@ void ProjectionPropagationModule::run(Event* event) {
                 }
             }
 
-            double diffusion_std_dev = std::sqrt(2. * diffusion_constant * drift_time);
             LOG(TRACE) << "Diffusion width is " << Units::display(diffusion_std_dev, "um");
 
             // Check if charge carrier is still alive via its survival probability, evaluated once
@@ -295,12 +397,50 @@ void ProjectionPropagationModule::run(Event* event) {
                 continue;
             }
 
+            if(analytic_sharing_) {
+                auto global_time = deposit.getGlobalTime() + propagation_time;
+                auto local_time = deposit.getLocalTime() + propagation_time;
+                if(propagation_time > integration_time_) {
+                    LOG(DEBUG) << "Charge carriers propagation time not within integration time: "
+                               << Units::display(global_time, "ns") << " global / "
+                               << Units::display(local_time, {"ns", "ps"}) << " local";
+                    continue;
+                }
+
+                // Distribute the carriers over the pixels instead of moving all of them by one sampled diffusion step
+                auto center = ROOT::Math::XYZPoint(position.x() + drift_displacement.x(),
+                                                   position.y() + drift_displacement.y(),
+                                                   top_z_);
+                auto pixel_charges = share_charge(center, diffusion_std_dev, charge_per_step, event->getRandomEngine());
+                for(const auto& [pixel, charge] : pixel_charges) {
+                    auto pixel_center = model_->getPixelCenter(pixel.x(), pixel.y());
+                    auto local_position = ROOT::Math::XYZPoint(pixel_center.x(), pixel_center.y(), top_z_);
+                    propagated_charges.emplace_back(local_position,
+                                                    detector_->getGlobalPosition(local_position),
+                                                    deposit.getType(),
+                                                    charge,
+                                                    local_time,
+                                                    global_time,
+                                                    &deposit);
+                    LOG(DEBUG) << "Shared " << charge << " " << type << " to pixel " << pixel;
+                    projected_charge += charge;
+                }
+
+                if(output_plots_) {
+                    initial_position_histo_->Fill(static_cast<double>(Units::convert(initial_position.z(), "um")),
+                                                  charge_per_step);
+                }
+                continue;
+            }
+
             allpix::normal_distribution<double> gauss_distribution(0, diffusion_std_dev);
             double diffusion_x = gauss_distribution(event->getRandomEngine());
             double diffusion_y = gauss_distribution(event->getRandomEngine());
 
             // Find projected position
-            auto local_position = ROOT::Math::XYZPoint(position.x() + diffusion_x, position.y() + diffusion_y, top_z_);
+            auto local_position = ROOT::Math::XYZPoint(position.x() + drift_displacement.x() + diffusion_x,
+                                                       position.y() + drift_displacement.y() + diffusion_y,
+                                                       top_z_);
 
             auto global_time = deposit.getGlobalTime() + propagation_time;
             auto local_time = deposit.getLocalTime() + propagation_time;
@@ -350,13 +490,345 @@ void ProjectionPropagationModule::run(Event* event) {
     }
 
     // Create a new message with propagated charges
-    auto propagated_charge_message = std::make_shared<PropagatedChargeMessage>(std::move(propagated_charges), detector_);
+    auto propagated_charge_message = event->makeShared<PropagatedChargeMessage>(std::move(propagated_charges), detector_);
 
     // Dispatch the message with propagated charges
     messenger_->dispatchMessage(this, propagated_charge_message, event);
 }
 
+/**
+ * The fraction of a two-dimensional Gaussian distribution contained in a pixel is the product of the differences of the
+ * error functions at the pixel edges in x and y. The carriers are distributed over the pixels within five standard
+ * deviations by a chain of binomial draws, which samples the multinomial distribution of independent carriers. Carriers
+ * falling outside of the pixel grid or beyond five standard deviations are not collected.
+ */
+std::vector<std::pair<Pixel::Index, unsigned int>>
+ProjectionPropagationModule::share_charge(const ROOT::Math::XYZPoint& center,
+                                          double sigma,
+                                          unsigned int charge,
+                                          RandomNumberGenerator& random_generator) const {
+    std::vector<std::pair<Pixel::Index, unsigned int>> pixel_charges;
+    auto npixels = model_->getNPixels();
+    auto pitch = model_->getPixelSize();
+
+    // Without diffusion all carriers end in the pixel containing the center
+    if(sigma <= 0) {
+        auto [xpixel, ypixel] = model_->getPixelIndex(center);
+        if(model_->isWithinPixelGrid(xpixel, ypixel)) {
+            pixel_charges.emplace_back(Pixel::Index(static_cast<unsigned int>(xpixel), static_cast<unsigned int>(ypixel)),
+                                       charge);
+        }
+        return pixel_charges;
+    }
+
+    // Range of pixels within the sharing distance around the center, clipped to the pixel grid
+    constexpr double sharing_range = 5.;
+    auto [xmin, ymin] = model_->getPixelIndex(
+        ROOT::Math::XYZPoint(center.x() - sharing_range * sigma, center.y() - sharing_range * sigma, center.z()));
+    auto [xmax, ymax] = model_->getPixelIndex(
+        ROOT::Math::XYZPoint(center.x() + sharing_range * sigma, center.y() + sharing_range * sigma, center.z()));
+    xmin = std::max(xmin, 0);
+    ymin = std::max(ymin, 0);
+    xmax = std::min(xmax, static_cast<int>(npixels.x()) - 1);
+    ymax = std::min(ymax, static_cast<int>(npixels.y()) - 1);
+    if(xmin > xmax || ymin > ymax) {
+        return pixel_charges;
+    }
+
+    // Fraction of the distribution along every axis contained in the pixels of the range
+    auto fractions = [&](int first, int last, double mean, double size, double origin) {
+        std::vector<double> fraction;
+        fraction.reserve(static_cast<size_t>(last - first + 1));
+        auto edge = [&](int index) { return std::erf((origin + (index - 0.5) * size - mean) / (std::sqrt(2.) * sigma)); };
+        auto lower = edge(first);
+        for(int index = first; index <= last; ++index) {
+            auto upper = edge(index + 1);
+            fraction.push_back((upper - lower) / 2.);
+            lower = upper;
+        }
+        return fraction;
+    };
+    auto origin = model_->getPixelCenter(0, 0);
+    auto fraction_x = fractions(xmin, xmax, center.x(), pitch.x(), origin.x());
+    auto fraction_y = fractions(ymin, ymax, center.y(), pitch.y(), origin.y());
+
+    // Draw the number of carriers in every pixel conditional on the carriers and probability left over
+    unsigned int remaining_charge = charge;
+    double remaining_probability = 1.;
+    for(int x = xmin; x <= xmax && remaining_charge > 0; ++x) {
+        for(int y = ymin; y <= ymax && remaining_charge > 0; ++y) {
+            auto probability = fraction_x[static_cast<size_t>(x - xmin)] * fraction_y[static_cast<size_t>(y - ymin)];
+            if(probability <= 0. || remaining_probability <= 0.) {
+                continue;
+            }
+            allpix::binomial_distribution<unsigned int> binomial(remaining_charge,
+                                                                  std::min(1., probability / remaining_probability));
+            auto pixel_charge = binomial(random_generator);
+            remaining_charge -= pixel_charge;
+            remaining_probability -= probability;
+            if(pixel_charge > 0) {
+                pixel_charges.emplace_back(Pixel::Index(static_cast<unsigned int>(x), static_cast<unsigned int>(y)),
+                                           pixel_charge);
+            }
+        }
+    }
+    return pixel_charges;
+}
+
+/**
+ * The start points are placed on a regular grid spanning the pixel cell in the center of the pixel matrix including its
+ * borders, and the full thickness of the sensor. Since the map is only computed for this cell, the electric field and the
+ * doping profile are assumed to repeat for every pixel, as for fields simulated for a single pixel cell.
+ */
+void ProjectionPropagationModule::create_drift_map() {
+    auto pixel_size = model_->getPixelSize();
+    auto npixels = model_->getNPixels();
+    auto center = model_->getPixelCenter(npixels.x() / 2, npixels.y() / 2);
+    auto surface = std::fabs(top_z_);
+    drift_map_origin_ = ROOT::Math::XYZPoint(center.x() - pixel_size.x() / 2, center.y() - pixel_size.y() / 2, -surface);
+    drift_map_spacing_ = ROOT::Math::XYZVector(pixel_size.x() / static_cast<double>(drift_map_bins_[0] - 1),
+                                               pixel_size.y() / static_cast<double>(drift_map_bins_[1] - 1),
+                                               2 * surface / static_cast<double>(drift_map_bins_[2] - 1));
+
+    drift_map_entries_.resize(drift_map_bins_[0] * drift_map_bins_[1] * drift_map_bins_[2]);
+    size_t valid_entries = 0;
+    for(size_t i = 0; i < drift_map_bins_[0]; ++i) {
+        for(size_t j = 0; j < drift_map_bins_[1]; ++j) {
+            for(size_t k = 0; k < drift_map_bins_[2]; ++k) {
+                auto start = drift_map_origin_ + ROOT::Math::XYZVector(static_cast<double>(i) * drift_map_spacing_.x(),
+                                                                       static_cast<double>(j) * drift_map_spacing_.y(),
+                                                                       static_cast<double>(k) * drift_map_spacing_.z());
+                auto& entry = drift_map_entries_[(i * drift_map_bins_[1] + j) * drift_map_bins_[2] + k];
+                entry = integrate_drift(start);
+                valid_entries += (entry.valid ? 1 : 0);
+            }
+        }
+    }
+    LOG(INFO) << "Created drift map with " << drift_map_entries_.size() << " start points, of which " << valid_entries
+              << " reach the sensor surface within the integration time";
+
+    if(!hybrid_propagation_) {
+        return;
+    }
+
+    // Mark the start points in low field, with a strongly varying field towards any neighbor or not reaching the surface
+    auto index = [&](size_t i, size_t j, size_t k) { return (i * drift_map_bins_[1] + j) * drift_map_bins_[2] + k; };
+    std::vector<ROOT::Math::XYZVector> fields(drift_map_entries_.size());
+    for(size_t i = 0; i < drift_map_bins_[0]; ++i) {
+        for(size_t j = 0; j < drift_map_bins_[1]; ++j) {
+            for(size_t k = 0; k < drift_map_bins_[2]; ++k) {
+                fields[index(i, j, k)] = detector_->getElectricField(
+                    drift_map_origin_ + ROOT::Math::XYZVector(static_cast<double>(i) * drift_map_spacing_.x(),
+                                                              static_cast<double>(j) * drift_map_spacing_.y(),
+                                                              static_cast<double>(k) * drift_map_spacing_.z()));
+            }
+        }
+    }
+    drift_map_full_.assign(drift_map_entries_.size(), false);
+    size_t full_entries = 0;
+    for(size_t i = 0; i < drift_map_bins_[0]; ++i) {
+        for(size_t j = 0; j < drift_map_bins_[1]; ++j) {
+            for(size_t k = 0; k < drift_map_bins_[2]; ++k) {
+                const auto& field = fields[index(i, j, k)];
+                auto magnitude = std::sqrt(field.Mag2());
+                bool full = !drift_map_entries_[index(i, j, k)].valid || magnitude < hybrid_min_field_;
+                auto compare = [&](size_t ni, size_t nj, size_t nk) {
+                    full = full || std::sqrt((fields[index(ni, nj, nk)] - field).Mag2()) >
+                                       hybrid_max_field_variation_ * magnitude;
+                };
+                if(i > 0) {
+                    compare(i - 1, j, k);
+                }
+                if(i + 1 < drift_map_bins_[0]) {
+                    compare(i + 1, j, k);
+                }
+                if(j > 0) {
+                    compare(i, j - 1, k);
+                }
+                if(j + 1 < drift_map_bins_[1]) {
+                    compare(i, j + 1, k);
+                }
+                if(k > 0) {
+                    compare(i, j, k - 1);
+                }
+                if(k + 1 < drift_map_bins_[2]) {
+                    compare(i, j, k + 1);
+                }
+                drift_map_full_[index(i, j, k)] = full;
+                full_entries += (full ? 1 : 0);
+            }
+        }
+    }
+    LOG(INFO) << "Carriers starting close to " << full_entries << " of " << drift_map_entries_.size()
+              << " start points of the drift map are propagated with the full drift-diffusion";
+}
+
+/**
+ * The drift is integrated with the same Runge-Kutta method as used by the GenericPropagation module. Without a random
+ * number generator, no diffusion is applied. Instead, the variance of the diffusion is accumulated along the path from the
+ * mobility at every step, such that the lateral diffusion can be applied as single Gaussian smearing at the end of the path.
+ * With a random number generator, a Gaussian diffusion step is applied after every step as in the GenericPropagation
+ * module, and no diffusion remains to be applied at the end of the path.
+ */
+ProjectionPropagationModule::DriftMapEntry
+ProjectionPropagationModule::integrate_drift(const ROOT::Math::XYZPoint& position,
+                                             RandomNumberGenerator* random_generator) const {
+    DriftMapEntry entry;
+    auto surface = std::fabs(top_z_);
+    if(std::fabs(position.z()) >= surface) {
+        entry.valid = (position.z() * top_z_ > 0);
+        return entry;
+    }
+    if(random_generator == nullptr &&
+       std::sqrt(detector_->getElectricField(position).Mag2()) < std::numeric_limits<double>::epsilon()) {
+        return entry;
+    }
+
+    auto type = propagate_type_;
+    auto mobility = [&](const Eigen::Vector3d& cur_pos, Eigen::Vector3d& efield) {
+        auto raw_field = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        efield = Eigen::Vector3d(raw_field.x(), raw_field.y(), raw_field.z());
+        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        return mobility_(type, efield.norm(), doping);
+    };
+    auto carrier_velocity = [&](double, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
+        Eigen::Vector3d efield;
+        auto mob = mobility(cur_pos, efield);
+        return static_cast<int>(type) * mob * efield;
+    };
+
+    Eigen::Vector3d start(position.x(), position.y(), position.z());
+    auto runge_kutta = make_runge_kutta(static_tableau::RK5(), carrier_velocity, drift_map_timestep_, start);
+    Eigen::Vector3d current = start;
+    Eigen::Vector3d efield;
+    double variance = 0;
+    while(runge_kutta.getTime() < integration_time_) {
+        Eigen::Vector3d last = current;
+        auto last_time = runge_kutta.getTime();
+        auto diffusion_constant = boltzmann_kT_ * mobility(last, efield);
+
+        runge_kutta.step();
+        current = runge_kutta.getValue();
+        auto step_time = runge_kutta.getTime() - last_time;
+        if(random_generator != nullptr) {
+            Eigen::Vector3d diffusion;
+            allpix::fill_normal<double>(
+                *random_generator, diffusion.data(), 3, 0, std::sqrt(2. * diffusion_constant * step_time));
+            current += diffusion;
+            runge_kutta.setValue(current);
+            // The diffusion of this step has been applied, no variance is left to accumulate
+            diffusion_constant = 0;
+        }
+
+        // Stop at the surface, interpolating the point where it is crossed
+        if(std::fabs(current.z()) >= surface) {
+            auto fraction = (std::copysign(surface, current.z()) - last.z()) / (current.z() - last.z());
+            current = last + fraction * (current - last);
+            variance += 2. * diffusion_constant * fraction * step_time;
+            entry.dx = current.x() - start.x();
+            entry.dy = current.y() - start.y();
+            entry.time = last_time + fraction * step_time;
+            entry.sigma = std::sqrt(variance);
+            entry.valid = (current.z() * top_z_ > 0);
+            return entry;
+        }
+        variance += 2. * diffusion_constant * step_time;
+    }
+    return entry;
+}
+
+std::array<double, 3> ProjectionPropagationModule::drift_map_coordinates(const ROOT::Math::XYZPoint& position) const {
+    auto pixel_size = model_->getPixelSize();
+    auto u = position.x() - drift_map_origin_.x();
+    auto v = position.y() - drift_map_origin_.y();
+    u -= std::floor(u / pixel_size.x()) * pixel_size.x();
+    v -= std::floor(v / pixel_size.y()) * pixel_size.y();
+    return {u / drift_map_spacing_.x(),
+            v / drift_map_spacing_.y(),
+            (position.z() - drift_map_origin_.z()) / drift_map_spacing_.z()};
+}
+
+/**
+ * Carriers within the edge distance of the border of their pixel cell always require the full propagation, since their
+ * sharing between the pixels depends on the details of the path. Otherwise, the flag of the nearest start point of the
+ * drift map is used.
+ */
+bool ProjectionPropagationModule::requires_full_propagation(const ROOT::Math::XYZPoint& position) const {
+    auto coordinates = drift_map_coordinates(position);
+    auto pixel_size = model_->getPixelSize();
+    auto u = coordinates[0] * drift_map_spacing_.x();
+    auto v = coordinates[1] * drift_map_spacing_.y();
+    if(std::min(u, pixel_size.x() - u) < hybrid_edge_distance_ || std::min(v, pixel_size.y() - v) < hybrid_edge_distance_) {
+        return true;
+    }
+
+    std::array<size_t, 3> nearest{};
+    for(size_t d = 0; d < 3; ++d) {
+        nearest[d] = static_cast<size_t>(
+            std::lround(std::clamp(coordinates[d], 0., static_cast<double>(drift_map_bins_[d] - 1))));
+    }
+    return drift_map_full_[(nearest[0] * drift_map_bins_[1] + nearest[1]) * drift_map_bins_[2] + nearest[2]];
+}
+
+/**
+ * The position is folded into the reference cell of the map using the pixel pitch, and the drift is interpolated trilinearly
+ * from the eight surrounding start points. Start points which do not reach the surface are excluded from the interpolation,
+ * unless the nearest start point does not reach it either, in which case the carrier is considered lost.
+ */
+std::optional<ProjectionPropagationModule::DriftMapEntry>
+ProjectionPropagationModule::lookup_drift_map(const ROOT::Math::XYZPoint& position) const {
+    auto coordinates = drift_map_coordinates(position);
+
+    // Lower corner and fractions of the cell of the map the position lies in
+    std::array<size_t, 3> lower{};
+    std::array<double, 3> fraction{};
+    for(size_t d = 0; d < 3; ++d) {
+        auto coordinate = std::clamp(coordinates[d], 0., static_cast<double>(drift_map_bins_[d] - 1));
+        lower[d] = std::min(static_cast<size_t>(coordinate), drift_map_bins_[d] - 2);
+        fraction[d] = coordinate - static_cast<double>(lower[d]);
+    }
+    auto entry_at = [&](size_t di, size_t dj, size_t dk) -> const DriftMapEntry& {
+        return drift_map_entries_[((lower[0] + di) * drift_map_bins_[1] + lower[1] + dj) * drift_map_bins_[2] + lower[2] +
+                                  dk];
+    };
+
+    if(!entry_at(fraction[0] < 0.5 ? 0 : 1, fraction[1] < 0.5 ? 0 : 1, fraction[2] < 0.5 ? 0 : 1).valid) {
+        return std::nullopt;
+    }
+
+    DriftMapEntry result;
+    double total_weight = 0;
+    for(size_t corner = 0; corner < 8; ++corner) {
+        size_t di = corner & 1U, dj = (corner >> 1U) & 1U, dk = (corner >> 2U) & 1U;
+        const auto& entry = entry_at(di, dj, dk);
+        if(!entry.valid) {
+            continue;
+        }
+        auto weight = (di == 1 ? fraction[0] : 1 - fraction[0]) * (dj == 1 ? fraction[1] : 1 - fraction[1]) *
+                      (dk == 1 ? fraction[2] : 1 - fraction[2]);
+        result.dx += weight * entry.dx;
+        result.dy += weight * entry.dy;
+        result.time += weight * entry.time;
+        result.sigma += weight * entry.sigma;
+        total_weight += weight;
+    }
+    if(total_weight <= 0) {
+        return std::nullopt;
+    }
+    result.dx /= total_weight;
+    result.dy /= total_weight;
+    result.time /= total_weight;
+    result.sigma /= total_weight;
+    result.valid = true;
+    return result;
+}
+
 void ProjectionPropagationModule::finalize() {
+    if(hybrid_propagation_) {
+        LOG(INFO) << "Propagated " << full_charge_sets_ << " of " << total_charge_sets_
+                  << " sets of charge carriers with the full drift-diffusion";
+    }
+
     if(output_plots_) {
         // Write output plots
         drift_time_histo_->Write();
@@ -8,8 +8,12 @@
  * Refer to the User's Manual for more details.
  */
 
+#include <array>
+#include <atomic>
+#include <optional>
 #include <random>
 #include <string>
+#include <vector>
 
 #include <TH1D.h>
 
@@ -20,6 +24,7 @@
 #include "core/module/Module.hpp"
 
 #include "objects/DepositedCharge.hpp"
+#include "objects/Pixel.hpp"
 #include "objects/PropagatedCharge.hpp"
 
 #include "physics/Mobility.hpp"
@@ -34,7 +39,11 @@ namespace allpix {
      *
      * The electrons from the deposition message are projected onto the sensor surface as a simple propagation method.
      * Diffusion is added by approximating the drift time and drawing a random number from a 2D gaussian distribution of the
-     * calculated width.
+     * calculated width. Alternatively, the drift of carriers starting on a grid of points within a single pixel cell is
+     * integrated once at initialization, and the end position, drift time and diffusion width are interpolated from this
+     * map for every carrier, which allows to use the module with arbitrary electric fields. In the hybrid mode, carriers
+     * starting close to the pixel edges or in regions of low or strongly varying field are propagated with the full
+     * drift-diffusion instead.
      */
     class ProjectionPropagationModule : public Module {
     public:
@@ -62,15 +71,86 @@ namespace allpix {
         void finalize() override;
 
     private:
+        /**
+         * @brief Drift of a carrier from a single start point, relative to the start point
+         */
+        struct DriftMapEntry {
+            double dx{};
+            double dy{};
+            double time{};
+            double sigma{};
+            bool valid{};
+        };
+
+        /**
+         * @brief Integrate the drift without diffusion for all start points of the drift map
+         */
+        void create_drift_map();
+
+        /**
+         * @brief Integrate the drift of a single carrier until it reaches the collecting surface
+         * @param position Local start position of the carrier
+         * @param random_generator Random number generator to apply the diffusion at every step, if not given the width of
+         * the diffusion is accumulated along the path instead
+         * @return Lateral displacement, drift time and the width of the diffusion not yet applied, marked invalid if the
+         * surface is not reached
+         */
+        DriftMapEntry integrate_drift(const ROOT::Math::XYZPoint& position,
+                                      RandomNumberGenerator* random_generator = nullptr) const;
+
+        /**
+         * @brief Get the position of a carrier in units of the spacing of the drift map, folded into its reference cell
+         * @param position Local position of the carrier
+         * @return Coordinates of the position relative to the first start point of the map
+         */
+        std::array<double, 3> drift_map_coordinates(const ROOT::Math::XYZPoint& position) const;
+
+        /**
+         * @brief Check if a carrier has to be propagated with the full drift-diffusion in the hybrid mode
+         * @param position Local start position of the carrier
+         * @return True if the carrier starts close to a pixel edge or next to a start point of the map marked for the full
+         * propagation, false if its drift can be interpolated from the map
+         */
+        bool requires_full_propagation(const ROOT::Math::XYZPoint& position) const;
+
+        /**
+         * @brief Interpolate the drift of a carrier from the drift map
+         * @param position Local start position of the carrier
+         * @return Interpolated drift or an empty optional if the nearest start point of the map does not reach the surface
+         */
+        std::optional<DriftMapEntry> lookup_drift_map(const ROOT::Math::XYZPoint& position) const;
+
+        /**
+         * @brief Distribute a set of carriers over the pixels according to the integral of their diffusion in every pixel
+         * @param center Mean position of the carriers on the collecting surface
+         * @param sigma Width of the diffusion in x and y
+         * @param charge Number of carriers to distribute
+         * @param random_generator Random number generator to draw the number of carriers per pixel
+         * @return Indices of the pixels receiving carriers together with their number of carriers
+         */
+        std::vector<std::pair<Pixel::Index, unsigned int>> share_charge(const ROOT::Math::XYZPoint& center,
+                                                                        double sigma,
+                                                                        unsigned int charge,
+                                                                        RandomNumberGenerator& random_generator) const;
+
         Messenger* messenger_;
         std::shared_ptr<const Detector> detector_;
         std::shared_ptr<DetectorModel> model_;
 
         // Config parameters
         bool output_plots_;
+        double temperature_{};
         double integration_time_{};
         bool diffuse_deposit_;
         unsigned int charge_per_step_{};
+        bool drift_map_{};
+        bool analytic_sharing_{};
+        double drift_map_timestep_{};
+        std::array<size_t, 3> drift_map_bins_{};
+        bool hybrid_propagation_{};
+        double hybrid_edge_distance_{};
+        double hybrid_min_field_{};
+        double hybrid_max_field_variation_{};
 
         // Carrier type to be propagated
         CarrierType propagate_type_;
@@ -88,6 +168,17 @@ namespace allpix {
         // Precalculated value for Boltzmann constant:
         double boltzmann_kT_;
 
+        // Drift map of the reference pixel cell, stored with the z index running fastest
+        std::vector<DriftMapEntry> drift_map_entries_;
+        ROOT::Math::XYZPoint drift_map_origin_;
+        ROOT::Math::XYZVector drift_map_spacing_;
+        // Start points of the drift map around which the full drift-diffusion is required in the hybrid mode
+        std::vector<bool> drift_map_full_;
+
+        // Statistics of the sets of charge carriers propagated with the full drift-diffusion in the hybrid mode
+        std::atomic<size_t> total_charge_sets_{};
+        std::atomic<size_t> full_charge_sets_{};
+
         // Output plot for drift time
         Histogram<TH1D> drift_time_histo_;
         Histogram<TH1D> diffusion_time_histo_;
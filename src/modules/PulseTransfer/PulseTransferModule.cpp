@@ -11,6 +11,8 @@
 #include "core/module/Event.hpp"
 #include "core/utils/log.h"
 #include "objects/PixelCharge.hpp"
+#include "objects/PixelChargeAccumulator.hpp"
+#include "objects/PulseAccumulator.hpp"
 
 #include <string>
 #include <utility>
@@ -92,13 +94,13 @@ void PulseTransferModule::initialize() {
 void PulseTransferModule::run(Event* event) {
     auto propagated_message = messenger_->fetchMessage<PropagatedChargeMessage>(this, event);
 
-    // Create map for all pixels: pulse and propagated charges
-    std::map<Pixel::Index, Pulse> pixel_pulse_map;
-    std::map<Pixel::Index, std::vector<const PropagatedCharge*>> pixel_charge_map;
+    // Accumulate the pulses of all pixels and create a map of their propagated charges
+    PulseAccumulator pulse_accumulator(timestep_);
+    PixelChargeAccumulator pixel_charge_map(propagated_message->getData().size());
 
     LOG(DEBUG) << "Received " << propagated_message->getData().size() << " propagated charge objects.";
     for(const auto& propagated_charge : propagated_message->getData()) {
-        auto pulses = propagated_charge.getPulses();
+        const auto& pulses = propagated_charge.getPulses();
 
         if(pulses.empty()) {
             LOG(TRACE) << "No pulse information available - producing pseudo-pulse from arrival time of charge carriers.";
@@ -144,35 +146,31 @@ void PulseTransferModule::run(Event* event) {
             Pixel::Index pixel_index(static_cast<unsigned int>(xpixel), static_cast<unsigned int>(ypixel));
 
             // Generate pseudo-pulse:
-            Pulse pulse(timestep_);
-            pulse.addCharge(propagated_charge.getCharge(), propagated_charge.getLocalTime());
-            pixel_pulse_map[pixel_index] += pulse;
+            pulse_accumulator.addCharge(pixel_index, propagated_charge.getCharge(), propagated_charge.getLocalTime());
 
-            auto px = pixel_charge_map[pixel_index];
             // For each pulse, store the corresponding propagated charges to preserve history:
-            if(std::find(px.begin(), px.end(), &propagated_charge) == px.end()) {
-                pixel_charge_map[pixel_index].emplace_back(&propagated_charge);
-            }
+            pixel_charge_map.add(pixel_index, 0, &propagated_charge);
         } else {
             LOG(TRACE) << "Found pulse information";
             LOG_ONCE(INFO) << "Pulses available - settings \"timestep\", \"max_depth_distance\" and "
                               "\"collect_from_implant\" have no effect";
 
-            for(auto& [pixel_index, pulse] : pulses) {
+            for(const auto& [pixel_index, pulse] : pulses) {
                 // Accumulate all pulses from input message data:
-                pixel_pulse_map[pixel_index] += pulse;
+                pulse_accumulator.addPulse(pixel_index, pulse);
 
-                auto px = pixel_charge_map[pixel_index];
                 // For each pulse, store the corresponding propagated charges to preserve history:
-                if(std::find(px.begin(), px.end(), &propagated_charge) == px.end()) {
-                    pixel_charge_map[pixel_index].emplace_back(&propagated_charge);
-                }
+                pixel_charge_map.add(pixel_index, 0, &propagated_charge);
             }
         }
     }
 
     // Create vector of pixel pulses to return for this detector
+    auto pixel_pulse_map = pulse_accumulator.getPulses();
+    pixel_charge_map.sort();
     std::vector<PixelCharge> pixel_charges;
+    pixel_charges.reserve(pixel_pulse_map.size());
+    size_t position = 0;
     Pulse total_pulse;
     for(auto& [index, pulse] : pixel_pulse_map) {
         // Sum all pulses for informational output:
@@ -183,7 +181,7 @@ void PulseTransferModule::run(Event* event) {
             h_induced_pixel_charge_->Fill(pulse.getCharge() / 1e3);
 
             auto step = pulse.getBinning();
-            auto pulse_vec = pulse.getPulse();
+            const auto& pulse_vec = pulse.getPulse();
             double charge = 0;
 
             for(auto bin = pulse_vec.begin(); bin != pulse_vec.end(); ++bin) {
@@ -201,10 +199,12 @@ void PulseTransferModule::run(Event* event) {
         if(output_pulsegraphs_) {
             create_pulsegraphs(event->number, index, pulse);
         }
-        LOG(DEBUG) << "Charge on pixel " << index << " has " << pixel_charge_map[index].size() << " ancestors";
+        // Both maps contain the same pixels in the same order
+        auto propagated_charges = pixel_charge_map.getPropagatedCharges(position++);
+        LOG(DEBUG) << "Charge on pixel " << index << " has " << propagated_charges.size() << " ancestors";
 
         // Store the pulse:
-        pixel_charges.emplace_back(detector_->getPixel(index), std::move(pulse), pixel_charge_map[index]);
+        pixel_charges.emplace_back(detector_->getPixel(index), std::move(pulse), propagated_charges);
     }
 
     if(output_pulsegraphs_) {
@@ -228,7 +228,7 @@ void PulseTransferModule::run(Event* event) {
     }
 
     // Create a new message with pixel pulses and dispatch:
-    auto pixel_charge_message = std::make_shared<PixelChargeMessage>(std::move(pixel_charges), detector_);
+    auto pixel_charge_message = event->makeShared<PixelChargeMessage>(std::move(pixel_charges), detector_);
     messenger_->dispatchMessage(this, pixel_charge_message, event);
 
     // Fill pixel charge histogram
@@ -255,7 +255,7 @@ void PulseTransferModule::finalize() {
 
 void PulseTransferModule::create_pulsegraphs(uint64_t event_num, const Pixel::Index& index, const Pulse& pulse) const {
     auto step = pulse.getBinning();
-    auto pulse_vec = pulse.getPulse();
+    const auto& pulse_vec = pulse.getPulse();
     LOG(TRACE) << "Preparing pulse for pixel " << index << ", " << pulse_vec.size() << " bins of "
                << Units::display(step, {"ps", "ns"}) << ", total charge: " << Units::display(pulse.getCharge(), "e");
 
@@ -9,6 +9,7 @@
 
 #include "RCEWriterModule.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <filesystem>
 #include <fstream>
@@ -20,6 +21,7 @@
 #include <TDirectory.h>
 #include <TMatrixD.h>
 
+#include "core/config/exceptions.h"
 #include "core/geometry/HybridPixelDetectorModel.hpp"
 #include "core/utils/log.h"
 #include "core/utils/type.h"
@@ -307,6 +309,15 @@ RCEWriterModule::RCEWriterModule(Configuration& config, Messenger* messenger, Ge
     // Use default names in Proteus
     config_.setDefault("device_file", "device.toml");
     config_.setDefault("geometry_file", "geometry.toml");
+
+    config_.setDefault("asynchronous_write", true);
+    config_.setDefault<size_t>("write_batch_size", 16);
+    config_.setDefault<size_t>("write_queue_size", 4);
+}
+
+RCEWriterModule::~RCEWriterModule() {
+    // Stop the writing thread before any of the data it uses is destroyed
+    stop_writer();
 }
 
 void RCEWriterModule::initialize() {
@@ -335,6 +346,9 @@ void RCEWriterModule::initialize() {
     int det_index = 0;
     for(const auto& detector_name : detector_names) {
         auto& sensor = sensors_[detector_name];
+        sensor.index = static_cast<size_t>(det_index);
+        // This contains no useful information but it expected to be present
+        std::fill(std::begin(sensor.hit_in_cluster_), std::end(sensor.hit_in_cluster_), 0);
 
         LOG(TRACE) << "Sensor " << det_index << ", detector " << detector_name;
 
@@ -359,62 +373,226 @@ void RCEWriterModule::initialize() {
     auto device_path = createOutputFile(config_.get<std::string>("device_file"), "toml");
     auto geometry_path = createOutputFile(config_.get<std::string>("geometry_file"), "toml");
     write_proteus_config(device_path, geometry_path, detector_names, *geo_mgr_, *getConfigManager());
+
+    batch_size_ = config_.get<size_t>("write_batch_size");
+    if(batch_size_ == 0) {
+        throw InvalidValueError(config_, "write_batch_size", "batch needs to hold at least one event");
+    }
+
+    // Allocate the batches once, the batch being collected and the batches waiting for the writing thread
+    asynchronous_ = config_.get<bool>("asynchronous_write");
+    size_t number_of_batches = 1;
+    if(asynchronous_) {
+        auto queue_size = config_.get<size_t>("write_queue_size");
+        if(queue_size == 0) {
+            throw InvalidValueError(config_, "write_queue_size", "queue needs to hold at least one batch");
+        }
+        number_of_batches += queue_size;
+    }
+    for(size_t i = 0; i < number_of_batches; ++i) {
+        auto batch = std::make_unique<event_batch>();
+        batch->numbers.reserve(batch_size_);
+        batch->sensors.resize(sensors_.size());
+        for(auto& columns : batch->sensors) {
+            columns.nhits.reserve(batch_size_);
+        }
+        free_batches_.push_back(batch.get());
+        batches_.push_back(std::move(batch));
+    }
+
+    if(asynchronous_) {
+        writer_thread_ = std::thread(&RCEWriterModule::run_writer, this, Log::getReportingLevel(), Log::getFormat());
+    }
 }
 
 void RCEWriterModule::run(Event* event) {
     auto pixel_hit_messages = messenger_->fetchMultiMessage<PixelHitMessage>(this, event);
 
-    // fill per-event data
-    timestamp_ = 0;
-    frame_number_ = event->number;
-    trigger_time_ = 0;
-    trigger_offset_ = 0;
-    trigger_info_ = 0;
-    invalid_ = false;
-    event_tree_->Fill();
-    LOG(TRACE) << "Wrote global event data";
-
-    // reset all per-sensor trees
-    for(auto& item : sensors_) {
-        item.second.nhits_ = 0;
+    // Add the event with no hits in all sensors to the batch
+    auto& batch = current_batch();
+    batch.numbers.push_back(event->number);
+    for(auto& columns : batch.sensors) {
+        columns.nhits.push_back(0);
     }
 
     // Loop over the pixel hit messages
     for(const auto& hit_msg : pixel_hit_messages) {
         const auto& detector_name = hit_msg->getDetector()->getName();
-        auto& sensor = sensors_[detector_name];
+        auto& columns = batch.sensors[sensors_.at(detector_name).index];
+        auto& nhits = columns.nhits.back();
 
         // Loop over all the hits
         for(const auto& hit : hit_msg->getData()) {
-            if(sensor_data::kMaxHits <= sensor.nhits_) {
+            if(sensor_data::kMaxHits <= nhits) {
                 LOG(ERROR) << "More than " << sensor_data::kMaxHits << " in detector " << detector_name;
                 continue;
             }
 
-            // Fill the tree with received messages
-            auto i = sensor.nhits_;
-            sensor.pix_x_[i] = static_cast<Int_t>(hit.getPixel().getIndex().x()); // NOLINT
-            sensor.pix_y_[i] = static_cast<Int_t>(hit.getPixel().getIndex().y()); // NOLINT
-            sensor.value_[i] = static_cast<Int_t>(hit.getSignal());               // NOLINT
+            // Append the hit to the columns of the sensor
+            columns.pix_x.push_back(static_cast<Int_t>(hit.getPixel().getIndex().x()));
+            columns.pix_y.push_back(static_cast<Int_t>(hit.getPixel().getIndex().y()));
+            columns.value.push_back(static_cast<Int_t>(hit.getSignal()));
             // Assumes that time is correctly digitized
-            sensor.timing_[i] = static_cast<Int_t>(hit.getLocalTime()); // NOLINT
-            // This contains no useful information but it expected to be present
-            sensor.hit_in_cluster_[i] = 0; // NOLINT
-            sensor.nhits_ += 1;
+            columns.timing.push_back(static_cast<Int_t>(hit.getLocalTime()));
+            nhits += 1;
 
             LOG(TRACE) << detector_name << " x=" << hit.getPixel().getIndex().x() << " y=" << hit.getPixel().getIndex().y()
                        << " t=" << hit.getLocalTime() << " signal=" << hit.getSignal();
         }
     }
 
-    // Loop over all the detectors to fill all corresponding sensor trees
-    for(auto& item : sensors_) {
-        item.second.tree->Fill();
-        LOG(TRACE) << "Wrote sensor event data for " << item.first;
+    if(batch.numbers.size() == batch_size_) {
+        dispatch_batch();
+    }
+}
+
+RCEWriterModule::event_batch& RCEWriterModule::current_batch() {
+    if(current_batch_ != nullptr) {
+        return *current_batch_;
+    }
+
+    // Wait for the writing thread to release a batch if all of them are queued
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    push_condition_.wait(lock, [this]() { return !free_batches_.empty() || !writer_error_.empty(); });
+    if(!writer_error_.empty()) {
+        throw ModuleError("Writing hits to file failed: " + writer_error_);
+    }
+    current_batch_ = free_batches_.front();
+    free_batches_.pop_front();
+    return *current_batch_;
+}
+
+void RCEWriterModule::dispatch_batch() {
+    if(current_batch_ == nullptr) {
+        return;
+    }
+
+    if(!asynchronous_) {
+        write_batch(*current_batch_);
+        free_batches_.push_back(current_batch_);
+    } else {
+        LOG(TRACE) << "Handing " << current_batch_->numbers.size() << " events to the writing thread";
+        current_batch_->log_section = Log::getSection();
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            queue_.push_back(current_batch_);
+        }
+        pop_condition_.notify_one();
+    }
+    current_batch_ = nullptr;
+}
+
+/**
+ * The columns of every sensor are copied into the arrays the branches are bound to, one event after the other. The arrays
+ * are only accessed by the thread writing the batch.
+ */
+void RCEWriterModule::write_batch(event_batch& batch) {
+    std::vector<size_t> offsets(batch.sensors.size(), 0);
+    for(size_t event = 0; event < batch.numbers.size(); ++event) {
+        // fill per-event data
+        timestamp_ = 0;
+        frame_number_ = batch.numbers[event];
+        trigger_time_ = 0;
+        trigger_offset_ = 0;
+        trigger_info_ = 0;
+        invalid_ = false;
+        event_tree_->Fill();
+
+        // Loop over all the detectors to fill all corresponding sensor trees
+        for(auto& item : sensors_) {
+            auto& sensor = item.second;
+            const auto& columns = batch.sensors[sensor.index];
+            auto offset = offsets[sensor.index];
+            auto nhits = columns.nhits[event];
+
+            sensor.nhits_ = nhits;
+            std::copy_n(columns.pix_x.begin() + static_cast<std::ptrdiff_t>(offset), nhits, sensor.pix_x_);
+            std::copy_n(columns.pix_y.begin() + static_cast<std::ptrdiff_t>(offset), nhits, sensor.pix_y_);
+            std::copy_n(columns.value.begin() + static_cast<std::ptrdiff_t>(offset), nhits, sensor.value_);
+            std::copy_n(columns.timing.begin() + static_cast<std::ptrdiff_t>(offset), nhits, sensor.timing_);
+            offsets[sensor.index] += static_cast<size_t>(nhits);
+
+            sensor.tree->Fill();
+        }
+    }
+    LOG(TRACE) << "Wrote event data of " << batch.numbers.size() << " events";
+
+    // Clearing the columns keeps their memory for the next batch
+    batch.numbers.clear();
+    for(auto& columns : batch.sensors) {
+        columns.nhits.clear();
+        columns.pix_x.clear();
+        columns.pix_y.clear();
+        columns.value.clear();
+        columns.timing.clear();
     }
 }
 
+/**
+ * The writing thread fills the trees in the order the batches have been queued, which is the order of the events since this
+ * module is sequential. Errors are stored and reported by the next event requiring a free batch.
+ */
+void RCEWriterModule::run_writer(LogLevel log_level, LogFormat log_format) {
+    Log::setReportingLevel(log_level);
+    Log::setFormat(log_format);
+
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    while(true) {
+        pop_condition_.wait(lock, [this]() { return !queue_.empty() || stop_writer_; });
+        if(queue_.empty()) {
+            return;
+        }
+
+        auto* batch = queue_.front();
+        queue_.pop_front();
+        lock.unlock();
+
+        Log::setSection(batch->log_section);
+        std::string error;
+        try {
+            write_batch(*batch);
+        } catch(const std::exception& e) {
+            error = e.what();
+        }
+
+        lock.lock();
+        free_batches_.push_back(batch);
+        if(!error.empty()) {
+            // Discard all pending batches and wake up the waiting worker to report the error
+            writer_error_ = error;
+            for(auto* pending : queue_) {
+                free_batches_.push_back(pending);
+            }
+            queue_.clear();
+            push_condition_.notify_all();
+            return;
+        }
+        push_condition_.notify_one();
+    }
+}
+
+void RCEWriterModule::stop_writer() {
+    if(!writer_thread_.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        stop_writer_ = true;
+    }
+    pop_condition_.notify_one();
+    writer_thread_.join();
+}
+
 void RCEWriterModule::finalize() {
+    // Write the remaining events and wait for the writing thread to finish
+    dispatch_batch();
+    LOG(TRACE) << "Waiting for the writing thread to write all events";
+    stop_writer();
+    if(!writer_error_.empty()) {
+        throw ModuleError("Writing hits to file failed: " + writer_error_);
+    }
+
     output_file_->Write();
     LOG(TRACE) << "Wrote data to file";
 }
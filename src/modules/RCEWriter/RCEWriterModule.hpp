@@ -7,8 +7,14 @@
  * Intergovernmental Organization or submit itself to any jurisdiction.
  */
 
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <TFile.h>
 #include <TTree.h>
@@ -20,6 +26,7 @@
 
 #include "core/module/Event.hpp"
 #include "core/module/Module.hpp"
+#include "core/utils/log.h"
 #include "objects/PixelHit.hpp"
 
 namespace allpix {
@@ -31,6 +38,10 @@ namespace allpix {
      * a root sub-directory for each detector with the name Plane* where * is the detector number. In each detector
      * sub-directory, it creates a Hits tree. Upon receiving the Pixel Hit messages, it writes the information to
      * the respective trees.
+     *
+     * The hits of consecutive events are collected in reusable column buffers and the trees are filled for a batch of
+     * events at once. By default, the complete batches are handed to a dedicated writing thread, such that filling and
+     * compressing the trees overlaps with the simulation of further events.
      */
     class RCEWriterModule : public SequentialModule {
     public:
@@ -42,9 +53,9 @@ namespace allpix {
          */
         RCEWriterModule(Configuration& config, Messenger*, GeometryManager*);
         /**
-         * @brief Destructor deletes the internal objects used to build the ROOT Tree
+         * @brief Destructor stops the writing thread
          */
-        ~RCEWriterModule() override = default;
+        ~RCEWriterModule() override;
 
         /**
          * @brief Opens the file to write the objects to, and initializes the trees
@@ -52,7 +63,7 @@ namespace allpix {
         void initialize() override;
 
         /**
-         * @brief Writes the objects fetched to their specific tree
+         * @brief Collects the hits of the event in the current batch and writes the batch once it is complete
          */
         void run(Event* event) override;
 
@@ -62,12 +73,58 @@ namespace allpix {
         void finalize() override;
 
     private:
+        /**
+         * @brief Hits of one sensor for all events of a batch, stored as one column per branch
+         */
+        struct sensor_columns {
+            std::vector<Int_t> nhits;
+            std::vector<Int_t> pix_x;
+            std::vector<Int_t> pix_y;
+            std::vector<Int_t> value;
+            std::vector<Int_t> timing;
+        };
+        /**
+         * @brief Batch of consecutive events to be written, the buffers keep their capacity when the batch is reused
+         */
+        struct event_batch {
+            std::vector<uint64_t> numbers;
+            std::vector<sensor_columns> sensors;
+            std::string log_section;
+        };
+
+        /**
+         * @brief Get the batch collecting the current events, waiting for a free batch if all are queued for writing
+         * @return Batch to add the event to
+         */
+        event_batch& current_batch();
+        /**
+         * @brief Writes the current batch or hands it to the writing thread
+         */
+        void dispatch_batch();
+        /**
+         * @brief Fills the trees with all events of a batch and clears the batch for reuse
+         * @param batch Batch of events to write
+         */
+        void write_batch(event_batch& batch);
+
+        /**
+         * @brief Writes the queued batches in the background until the writing thread is stopped
+         * @param log_level Reporting level of the logger for the writing thread
+         * @param log_format Format of the logger for the writing thread
+         */
+        void run_writer(LogLevel log_level, LogFormat log_format);
+        /**
+         * @brief Waits until all queued batches have been written and stops the writing thread
+         */
+        void stop_writer();
+
         Messenger* messenger_;
         GeometryManager* geo_mgr_;
 
         // Struct to store tree and information for each detector
         struct sensor_data {
             static constexpr int kMaxHits = (1 << 14);
+            size_t index;
             TTree* tree; // no unique_ptr, ROOT takes ownership
             Int_t nhits_;
             Int_t pix_x_[kMaxHits];
@@ -91,5 +148,21 @@ namespace allpix {
 
         // Output data file to write
         std::unique_ptr<TFile> output_file_;
+
+        // Batches of events, the batch currently collecting events and the free batches available for reuse
+        size_t batch_size_{};
+        std::vector<std::unique_ptr<event_batch>> batches_;
+        event_batch* current_batch_{};
+        std::deque<event_batch*> free_batches_;
+
+        // Writing thread and the queue of complete batches handed to it
+        bool asynchronous_{};
+        std::thread writer_thread_;
+        std::mutex queue_mutex_;
+        std::condition_variable push_condition_;
+        std::condition_variable pop_condition_;
+        std::deque<event_batch*> queue_;
+        bool stop_writer_{false};
+        std::string writer_error_;
     };
 } // namespace allpix
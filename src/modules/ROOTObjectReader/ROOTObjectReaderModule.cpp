@@ -9,17 +9,21 @@
 
 #include "ROOTObjectReaderModule.hpp"
 
+#include <algorithm>
 #include <climits>
+#include <map>
 #include <string>
 #include <utility>
 
 #include <TBranch.h>
 #include <TKey.h>
+#include <TMath.h>
 #include <TObjArray.h>
 #include <TProcessID.h>
 #include <TTree.h>
 
 #include "core/messenger/Messenger.hpp"
+#include "core/module/ThreadPool.hpp"
 #include "core/utils/log.h"
 #include "core/utils/text.h"
 #include "core/utils/type.h"
@@ -41,9 +45,8 @@ ROOTObjectReaderModule::ROOTObjectReaderModule(Configuration& config, Messenger*
  * @note Objects cannot be stored in smart pointers due to internal ROOT logic
  */
 ROOTObjectReaderModule::~ROOTObjectReaderModule() {
-    for(const auto& message_inf : message_info_array_) {
-        delete message_inf.objects;
-    }
+    // Close the files of the threads before the main input file
+    readers_.clear();
 }
 
 /**
@@ -121,8 +124,8 @@ void ROOTObjectReaderModule::initialize() {
     message_creator_map_ = gen_creator_map<allpix::OBJECTS>();
 
     // Open the file with the objects
-    auto input_file_name = config_.getPathWithExtension("file_name", "root", true);
-    input_file_ = std::make_unique<TFile>(input_file_name.c_str());
+    input_file_name_ = config_.getPathWithExtension("file_name", "root", true);
+    input_file_ = std::make_unique<TFile>(input_file_name_.c_str());
 
     // Read all the trees in the file
     TList* keys = input_file_->GetListOfKeys();
@@ -197,6 +200,14 @@ void ROOTObjectReaderModule::initialize() {
                      << " - this might lead to unexpected behavior.";
     }
 
+    // Map the class names of the objects to their types to check for receivers of their messages
+    auto skip_unused = config_.get<bool>("skip_unused_objects", false);
+    std::map<std::string, std::type_index> object_types;
+    for(auto& creator : message_creator_map_) {
+        object_types.emplace(allpix::demangle(creator.first.name()), creator.first);
+    }
+    size_t skipped_branches = 0;
+
     // Loop over all found trees
     for(auto& tree : trees_) {
         // Loop over the list of branches and create the set of receiver objects
@@ -204,11 +215,11 @@ void ROOTObjectReaderModule::initialize() {
         for(int i = 0; i < branches->GetEntries(); i++) {
             auto* branch = static_cast<TBranch*>(branches->At(i));
 
-            // Add a new vector of objects and bind it to the branch
+            // Add the information of the branch, the objects are bound to the trees of every thread
             message_info message_inf;
-            message_inf.objects = new std::vector<Object*>;
+            message_inf.tree_name = tree->GetName();
+            message_inf.branch_name = branch->GetName();
             message_info_array_.emplace_back(message_inf);
-            branch->SetAddress(&(message_info_array_.back().objects));
 
             // Fill the rest of the message information
             // FIXME: we want to index this in a different way
@@ -252,27 +263,207 @@ void ROOTObjectReaderModule::initialize() {
                     message_info_array_.back().detector = geo_mgr_->getDetector(split[det_idx]);
                 }
             }
+
+            // Do not read branches with objects that no module would receive
+            auto type = object_types.find(class_name);
+            if(skip_unused && type != object_types.end()) {
+                auto& info = message_info_array_.back();
+                auto empty_message = message_creator_map_[type->second]({}, info.detector);
+                if(!messenger_->hasReceiver(this, empty_message, info.name)) {
+                    LOG(DEBUG) << "Skipping branch " << branch_name << " of tree " << tree->GetName()
+                               << " because its objects are not received by any module";
+                    message_info_array_.pop_back();
+                    ++skipped_branches;
+                    continue;
+                }
+            }
+        }
+    }
+    if(skipped_branches > 0) {
+        LOG(INFO) << "Skipping " << skipped_branches << " branches with objects not received by any module";
+    }
+
+    // Size of the cache prefetching the baskets of the branches read
+    if(config_.has("cache_size")) {
+        cache_size_ = config_.get<Long64_t>("cache_size");
+    }
+
+    // Stored events to read instead of the events in sequence, located through the index if available
+    if(config_.has("index_file")) {
+        try {
+            index_ = event_index::read(config_.getPathWithExtension("index_file", "apidx", true));
+        } catch(const std::runtime_error& e) {
+            throw InvalidValueError(config_, "index_file", e.what());
+        }
+        LOG(INFO) << "Loaded index of " << index_.events.size() << " events";
+    }
+    events_ = config_.getArray<uint64_t>("events", {});
+    for(auto stored_event : events_) {
+        if(stored_event == 0) {
+            throw InvalidValueError(config_, "events", "event numbers start at one");
+        }
+        if(!index_.events.empty() && index_.find(stored_event) == index_.events.size()) {
+            throw InvalidValueError(
+                config_, "events", "event " + std::to_string(stored_event) + " is not part of the index");
+        }
+    }
+    if(!events_.empty()) {
+        LOG(INFO) << "Reading " << events_.size() << " selected events";
+    }
+}
+
+/**
+ * Every thread opens the file separately and reads its own copy of the trees, such that entries can be read and
+ * decompressed concurrently. The entry read for an event only depends on the event number and not on the thread.
+ */
+ROOTObjectReaderModule::ThreadReader& ROOTObjectReaderModule::get_thread_reader() {
+    auto thread_num = ThreadPool::threadNum();
+    std::lock_guard<std::mutex> lock(readers_mutex_);
+    auto& reader = readers_[thread_num];
+    if(reader != nullptr) {
+        return *reader;
+    }
+
+    LOG(DEBUG) << "Opening input file for thread " << thread_num;
+    reader = std::make_unique<ThreadReader>();
+    reader->file = std::make_unique<TFile>(input_file_name_.c_str());
+    if(reader->file->IsZombie()) {
+        throw ModuleError("Cannot open input file " + input_file_name_);
+    }
+
+    for(auto* main_tree : trees_) {
+        auto* tree = reader->file->Get<TTree>(main_tree->GetName());
+        if(tree == nullptr) {
+            throw ModuleError("Cannot read tree " + std::string(main_tree->GetName()) + " from input file");
+        }
+        reader->trees.push_back(tree);
+
+        // Bind the objects of all branches to read and exclude all other branches
+        TObjArray* branches = tree->GetListOfBranches();
+        for(int i = 0; i < branches->GetEntries(); i++) {
+            auto* branch = static_cast<TBranch*>(branches->At(i));
+            auto read = std::find_if(message_info_array_.begin(), message_info_array_.end(), [&](const auto& info) {
+                return info.tree_name == tree->GetName() && info.branch_name == branch->GetName();
+            });
+            if(read == message_info_array_.end()) {
+                disable_branch(branch);
+                continue;
+            }
+
+            auto message_inf = *read;
+            message_inf.objects = new std::vector<Object*>;
+            reader->message_info_array.emplace_back(message_inf);
+            branch->SetAddress(&(reader->message_info_array.back().objects));
+        }
+
+        // Prefetch the baskets of all branches which are read
+        if(cache_size_.has_value()) {
+            tree->SetCacheSize(cache_size_.value());
+            if(cache_size_.value() > 0) {
+                for(int i = 0; i < branches->GetEntries(); i++) {
+                    auto* branch = static_cast<TBranch*>(branches->At(i));
+                    if(!branch->TestBit(TBranch::kDoNotProcess)) {
+                        tree->AddBranchToCache(branch, true);
+                    }
+                }
+                tree->StopCacheLearningPhase();
+            }
         }
     }
+    return *reader;
+}
+
+ROOTObjectReaderModule::ThreadReader::~ThreadReader() {
+    for(const auto& message_inf : message_info_array) {
+        delete message_inf.objects;
+    }
+}
+
+/**
+ * Loading the baskets reads and decompresses the data of the entry, such that only the objects have to be streamed from
+ * the baskets afterwards. Only streaming the objects requires the process lock, since their references are registered in
+ * the global process tables.
+ */
+void ROOTObjectReaderModule::load_baskets(TBranch* branch, Long64_t entry) {
+    if(branch->TestBit(TBranch::kDoNotProcess)) {
+        return;
+    }
+    auto baskets = branch->GetWriteBasket() + 1;
+    auto* basket_entry = branch->GetBasketEntry();
+    if(basket_entry != nullptr && entry < branch->GetEntries()) {
+        auto basket = TMath::BinarySearch(static_cast<Long64_t>(baskets), basket_entry, entry);
+        if(basket >= 0) {
+            branch->GetBasket(static_cast<Int_t>(basket));
+        }
+    }
+
+    TObjArray* sub_branches = branch->GetListOfBranches();
+    for(int i = 0; i < sub_branches->GetEntries(); i++) {
+        load_baskets(static_cast<TBranch*>(sub_branches->At(i)), entry);
+    }
+}
+
+/**
+ * Branches are excluded from reading together with all of their sub-branches, as done by TTree::SetBranchStatus.
+ */
+void ROOTObjectReaderModule::disable_branch(TBranch* branch) {
+    branch->SetBit(TBranch::kDoNotProcess);
+    TObjArray* sub_branches = branch->GetListOfBranches();
+    for(int i = 0; i < sub_branches->GetEntries(); i++) {
+        disable_branch(static_cast<TBranch*>(sub_branches->At(i)));
+    }
 }
 
 void ROOTObjectReaderModule::run(Event* event) {
-    auto root_lock = root_process_lock();
+    auto& reader = get_thread_reader();
 
     // Beware: ROOT uses signed entry counters for its trees
     auto event_num = static_cast<int64_t>(event->number);
     --event_num;
-    for(auto& tree : trees_) {
+
+    // Look up the entry of the selected event, the events of the file are stored in sequence if no index is given
+    if(!events_.empty()) {
+        if(event->number > events_.size()) {
+            throw EndOfRunException("Requesting end of run because all " + std::to_string(events_.size()) +
+                                    " selected events have been read");
+        }
+        auto stored_event = events_[event->number - 1];
+        event_num = static_cast<int64_t>(stored_event) - 1;
+        if(!index_.events.empty()) {
+            auto position = index_.find(stored_event);
+            event_num = static_cast<int64_t>(index_.entries[position]);
+            uint64_t objects = 0;
+            for(size_t tree = 0; tree < index_.trees.size(); ++tree) {
+                objects += index_.count(position, tree);
+            }
+            LOG(DEBUG) << "Reading stored event " << stored_event << " with " << objects << " objects from entry "
+                       << event_num;
+        } else {
+            LOG(DEBUG) << "Reading stored event " << stored_event << " from entry " << event_num;
+        }
+    }
+    for(auto& tree : reader.trees) {
         if(event_num >= tree->GetEntries()) {
             throw EndOfRunException("Requesting end of run because TTree only contains data for " +
                                     std::to_string(event_num) + " events");
         }
+
+        // Read the data of the entry before locking, other threads can read their entries concurrently
+        tree->LoadTree(event_num);
+        TObjArray* branches = tree->GetListOfBranches();
+        for(int i = 0; i < branches->GetEntries(); i++) {
+            load_baskets(static_cast<TBranch*>(branches->At(i)), event_num);
+        }
+    }
+
+    auto root_lock = root_process_lock();
+    for(auto& tree : reader.trees) {
         tree->GetEntry(event_num);
     }
     LOG(TRACE) << "Building messages from stored objects";
 
     // Loop through all branches to construct messages
-    for(auto& message_inf : message_info_array_) {
+    for(auto& message_inf : reader.message_info_array) {
         auto* objects = message_inf.objects;
 
         // Skip empty objects in current event
@@ -296,15 +487,23 @@ void ROOTObjectReaderModule::run(Event* event) {
         message_inf.message = iter->second(*objects, message_inf.detector);
     }
 
-    for(auto& message_inf : message_info_array_) {
-        // We might not have every message, so just continue
+    // Resolve history
+    for(auto& message_inf : reader.message_info_array) {
         if(!message_inf.message) {
             continue;
         }
+        for(auto& object : message_inf.message->getObjects()) {
+            object.loadHistory();
+        }
+    }
+
+    // All references are resolved, dispatching the messages does not require the process lock anymore
+    root_lock.unlock();
 
-        // Resolve history
-        for(auto& object : message_inf.message->getObjectArray()) {
-            object.get().loadHistory();
+    for(auto& message_inf : reader.message_info_array) {
+        // We might not have every message, so just continue
+        if(!message_inf.message) {
+            continue;
         }
 
         // Dispatch the messages
@@ -8,7 +8,11 @@
  */
 
 #include <functional>
+#include <list>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 
 #include <TFile.h>
@@ -23,6 +27,8 @@
 // Contains tuple of all defined objects
 #include "objects/objects.h"
 
+#include "tools/event_index.h"
+
 namespace allpix {
     /**
      * @ingroup Modules
@@ -65,6 +71,19 @@ namespace allpix {
         void finalize() override;
 
     private:
+        /**
+         * @brief Exclude a branch and all its sub-branches from being read
+         * @param branch Branch to exclude
+         */
+        static void disable_branch(TBranch* branch);
+
+        /**
+         * @brief Read the baskets of a branch and all its sub-branches containing an entry
+         * @param branch Branch to read
+         * @param entry Entry of the tree
+         */
+        static void load_baskets(TBranch* branch, Long64_t entry);
+
         Messenger* messenger_;
         GeometryManager* geo_mgr_;
 
@@ -72,25 +91,59 @@ namespace allpix {
          * @brief Internal object storing objects and information to construct a message from tree
          */
         struct message_info {
-            std::vector<Object*>* objects;
+            std::vector<Object*>* objects{};
             std::shared_ptr<Detector> detector;
             std::string name;
             std::shared_ptr<BaseMessage> message;
+            std::string tree_name;
+            std::string branch_name;
         };
 
+        /**
+         * @brief Input file and trees read by a single thread
+         */
+        struct ThreadReader {
+            /**
+             * @brief Destructor deletes the internal objects read from the trees
+             */
+            ~ThreadReader();
+
+            std::unique_ptr<TFile> file;
+            std::vector<TTree*> trees;
+            std::list<message_info> message_info_array;
+        };
+
+        /**
+         * @brief Get the reader of the current thread, opening the input file if it is not yet open for this thread
+         * @return Reader of the current thread
+         */
+        ThreadReader& get_thread_reader();
+
         // Object names to include or exclude from reading
         std::set<std::string> include_;
         std::set<std::string> exclude_;
 
         // File containing the objects
         std::unique_ptr<TFile> input_file_;
+        std::string input_file_name_;
 
         // Object trees in the file
         std::vector<TTree*> trees_;
 
-        // List of objects and message information converted from the trees
+        // Message information of the branches read from the trees, bound to the objects by the reader of every thread
         std::list<message_info> message_info_array_;
 
+        // Readers of the input file for every thread
+        std::mutex readers_mutex_;
+        std::map<unsigned int, std::unique_ptr<ThreadReader>> readers_;
+
+        // Index of the events in the file and the stored events selected for reading, if configured
+        EventIndex index_;
+        std::vector<uint64_t> events_;
+
+        // Size of the cache prefetching baskets, if configured
+        std::optional<Long64_t> cache_size_;
+
         // Statistics for total amount of objects stored
         std::atomic<unsigned long> read_cnt_{};
 
@@ -9,22 +9,31 @@
 
 #include "ROOTObjectWriterModule.hpp"
 
+#include <algorithm>
+#include <exception>
+#include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <string>
 #include <utility>
 
+#include <Compression.h>
 #include <TBranchElement.h>
 #include <TClass.h>
 #include <TProcessID.h>
 
 #include "core/config/ConfigReader.hpp"
+#include "core/module/ThreadPool.hpp"
 #include "core/utils/log.h"
+#include "core/utils/profiling.h"
+#include "core/utils/text.h"
 #include "core/utils/type.h"
 
 #include "objects/Object.hpp"
 #include "objects/objects.h"
 
 #include "tools/ROOT.h"
+#include "tools/event_index.h"
 
 using namespace allpix;
 
@@ -40,17 +49,35 @@ ROOTObjectWriterModule::ROOTObjectWriterModule(Configuration& config, Messenger*
  * @note Objects cannot be stored in smart pointers due to internal ROOT logic
  */
 ROOTObjectWriterModule::~ROOTObjectWriterModule() {
+    // Stop the writing thread before any of the data it uses is destroyed
+    stop_writer();
+
+    // Delete the objects read while merging
+    for(auto& merge_data : merge_list_) {
+        for(auto* object : *merge_data.second) {
+            delete object;
+        }
+        delete merge_data.second;
+    }
+    for(auto* objects : restored_lists_) {
+        delete objects;
+    }
+}
+
+/**
+ * @note Objects cannot be stored in smart pointers due to internal ROOT logic
+ */
+ROOTObjectWriterModule::TreeSet::~TreeSet() {
     // Delete all object pointers
-    for(auto& index_data : write_list_) {
-        delete index_data.second;
+    for(auto* objects : write_list) {
+        delete objects;
     }
 }
 
 void ROOTObjectWriterModule::initialize() {
-    // Create output file
-    output_file_name_ = createOutputFile(config_.get<std::string>("file_name", "data"), "root", true);
-    output_file_ = std::make_unique<TFile>(output_file_name_.c_str(), "RECREATE");
-    output_file_->cd();
+    file_name_ = config_.get<std::string>("file_name", "data");
+    rotation_ =
+        OutputRotation(config_.get<uint64_t>("max_events_per_file", 0), config_.get<uint64_t>("max_file_size", 0));
 
     // Read include and exclude list
     if(config_.has("include") && config_.has("exclude")) {
@@ -63,26 +90,148 @@ void ROOTObjectWriterModule::initialize() {
         auto exc_arr = config_.getArray<std::string>("exclude");
         exclude_.insert(exc_arr.begin(), exc_arr.end());
     }
+
+    // Read the compression of the data file and the storage settings of all trees or individual trees and branches
+    auto compression_settings = [this](CompressionAlgorithm algorithm, int level, const std::string& key) {
+        if(level < 0 || level > 9) {
+            throw InvalidValueError(config_, key, "compression level should be between 0 and 9");
+        }
+        return ROOT::CompressionSettings(static_cast<ROOT::RCompressionSetting::EAlgorithm::EValues>(algorithm), level);
+    };
+    auto default_level = [](CompressionAlgorithm algorithm) {
+        switch(algorithm) {
+        case CompressionAlgorithm::LZMA:
+            return static_cast<int>(ROOT::RCompressionSetting::ELevel::kDefaultLZMA);
+        case CompressionAlgorithm::LZ4:
+            return static_cast<int>(ROOT::RCompressionSetting::ELevel::kDefaultLZ4);
+        case CompressionAlgorithm::ZSTD:
+            return static_cast<int>(ROOT::RCompressionSetting::ELevel::kDefaultZSTD);
+        default:
+            return static_cast<int>(ROOT::RCompressionSetting::ELevel::kDefaultZLIB);
+        }
+    };
+    if(config_.has("compression_algorithm") || config_.has("compression_level")) {
+        auto algorithm = config_.get<CompressionAlgorithm>("compression_algorithm", CompressionAlgorithm::GLOBAL);
+        auto level = config_.get<int>("compression_level", default_level(algorithm));
+        file_compression_ = compression_settings(algorithm, level, "compression_level");
+    }
+
+    default_storage_.basket_size = config_.get<int>("basket_size", 32000);
+    if(default_storage_.basket_size <= 0) {
+        throw InvalidValueError(config_, "basket_size", "basket size should be positive");
+    }
+    if(config_.has("auto_flush")) {
+        auto_flush_ = config_.get<Long64_t>("auto_flush");
+    }
+
+    if(config_.has("compression_overrides")) {
+        for(auto& row : config_.getMatrix<std::string>("compression_overrides")) {
+            if(row.size() < 2 || row.size() > 3) {
+                throw InvalidValueError(config_,
+                                        "compression_overrides",
+                                        "every entry should contain a tree or branch name, the algorithm and optionally "
+                                        "the compression level");
+            }
+            try {
+                auto algorithm = allpix::from_string<CompressionAlgorithm>(row[1]);
+                auto level = (row.size() == 3 ? allpix::from_string<int>(row[2]) : default_level(algorithm));
+                storage_[row[0]].compression = compression_settings(algorithm, level, "compression_overrides");
+            } catch(std::invalid_argument& e) {
+                throw InvalidValueError(config_, "compression_overrides", e.what());
+            }
+        }
+    }
+    if(config_.has("basket_size_overrides")) {
+        for(auto& row : config_.getMatrix<std::string>("basket_size_overrides")) {
+            if(row.size() != 2) {
+                throw InvalidValueError(config_,
+                                        "basket_size_overrides",
+                                        "every entry should contain a tree or branch name and the basket size");
+            }
+            try {
+                storage_[row[0]].basket_size = allpix::from_string<int>(row[1]);
+            } catch(std::invalid_argument& e) {
+                throw InvalidValueError(config_, "basket_size_overrides", e.what());
+            }
+            if(storage_[row[0]].basket_size <= 0) {
+                throw InvalidValueError(config_, "basket_size_overrides", "basket size should be positive");
+            }
+        }
+    }
+
+    write_index_ = config_.get<bool>("write_index", false);
+
+    // Let every worker fill its own trees without waiting for the previous events
+    parallel_ = config_.get<bool>("parallel_write", false);
+    if(parallel_) {
+        waive_sequence_requirement();
+    }
+
+    // Checkpoints require the entries to be written in sequence to a single file
+    const auto& global_config = getConfigManager()->getGlobalConfiguration();
+    resume_ = global_config.has("resume_checkpoint");
+    if(resume_ || global_config.get<uint64_t>("checkpoint_interval", 0) > 0) {
+        if(parallel_) {
+            throw InvalidValueError(config_, "parallel_write", "trees filled in parallel cannot be stored in checkpoints");
+        }
+        if(rotation_.enabled()) {
+            throw InvalidValueError(config_,
+                                    config_.has("max_events_per_file") ? "max_events_per_file" : "max_file_size",
+                                    "output split into several files cannot be stored in checkpoints");
+        }
+        if(write_index_) {
+            throw InvalidValueError(config_, "write_index", "the event index cannot be stored in checkpoints");
+        }
+    }
+
+    // Create output file, or the file of the first chunk if the output is split. A resumed run creates the file when
+    // restoring the checkpoint, after the entries of the interrupted run have been moved aside
+    if(!resume_) {
+        open_output_file();
+    }
+
+    // Start the thread writing the events in the background
+    asynchronous_ = !parallel_ && config_.get<bool>("asynchronous_write", true);
+    if(asynchronous_) {
+        queue_size_ = config_.get<size_t>("write_queue_size", 16);
+        if(queue_size_ == 0) {
+            throw InvalidValueError(config_, "write_queue_size", "queue needs to hold at least one event");
+        }
+        start_writer();
+    }
 }
 
+/**
+ * The include and exclude lists are only evaluated for the first message of every type, the result is cached for all
+ * further messages of the same type since all of them carry objects of the same class.
+ */
 bool ROOTObjectWriterModule::filter(const std::shared_ptr<BaseMessage>& message,
                                     const std::string& message_name) const { // NOLINT
+    // Empty messages are never stored
+    if(message->isEmpty()) {
+        return false;
+    }
+
+    const BaseMessage* inst = message.get();
+    std::type_index type_idx = typeid(*inst);
+    {
+        std::shared_lock<std::shared_mutex> lock(filter_mutex_);
+        auto iter = filter_cache_.find(type_idx);
+        if(iter != filter_cache_.end()) {
+            return iter->second;
+        }
+    }
+
+    bool keep = true;
     try {
-        const BaseMessage* inst = message.get();
         std::string name_str = " without a name";
         if(!message_name.empty()) {
             name_str = " named " + message_name;
         }
         LOG(TRACE) << "ROOT object writer received " << allpix::demangle(typeid(*inst).name()) << name_str;
 
-        // Get the detector name
-        std::string detector_name;
-        if(message->getDetector() != nullptr) {
-            detector_name = message->getDetector()->getName();
-        }
-
         // Read the object
-        auto object_array = message->getObjectArray();
+        auto object_array = message->getObjects();
         if(object_array.empty()) {
             return false;
         }
@@ -94,89 +243,325 @@ bool ROOTObjectWriterModule::filter(const std::shared_ptr<BaseMessage>& message,
            (!exclude_.empty() && exclude_.find(class_name) != exclude_.cend())) {
             LOG(TRACE) << "ROOT object writer ignored message with object " << allpix::demangle(typeid(*inst).name())
                        << " because it has been excluded or not explicitly included";
-            return false;
+            keep = false;
         }
     } catch(MessageWithoutObjectException& e) {
-        const BaseMessage* inst = message.get();
         LOG(WARNING) << "ROOT object writer cannot process message of type" << allpix::demangle(typeid(*inst).name())
                      << " with name " << message_name;
-        return false;
+        keep = false;
     }
 
-    return true;
+    std::unique_lock<std::shared_mutex> lock(filter_mutex_);
+    filter_cache_.emplace(type_idx, keep);
+    return keep;
 }
 
 void ROOTObjectWriterModule::run(Event* event) {
+    auto batch = prepare_event(event);
+
+    // Only the creation of the references uses the global process identifiers of ROOT and requires the process lock
     auto root_lock = root_process_lock();
+    petrify_history(batch);
+
+    if(!asynchronous_ && !parallel_) {
+        start_entry(batch.number);
+        write_event(tree_set_, batch.messages, batch.channels);
+        return;
+    }
+
+    // The references are fixed, filling the trees does not require the process lock anymore
+    root_lock.unlock();
+    store_event(std::move(batch));
+}
+
+/**
+ * The process lock is taken only once for all events of the batch
+ */
+void ROOTObjectWriterModule::run(const std::vector<Event*>& events) {
+    std::vector<EventBatch> batches;
+    batches.reserve(events.size());
+    for(auto* event : events) {
+        batches.push_back(prepare_event(event));
+    }
+
+    auto root_lock = root_process_lock();
+    for(auto& batch : batches) {
+        petrify_history(batch);
+    }
+
+    if(!asynchronous_ && !parallel_) {
+        for(auto& batch : batches) {
+            start_entry(batch.number);
+            write_event(tree_set_, batch.messages, batch.channels);
+        }
+        return;
+    }
 
+    root_lock.unlock();
+    for(auto& batch : batches) {
+        store_event(std::move(batch));
+    }
+}
+
+ROOTObjectWriterModule::EventBatch ROOTObjectWriterModule::prepare_event(Event* event) {
+    EventBatch batch;
+    batch.number = event->number;
     auto messages = messenger_->fetchFilteredMessages(this, event);
+    batch.messages.assign(messages.begin(), messages.end());
+
+    // Resolve the channel of every message once, such that writing the event only indexes the object lists
+    batch.channels.reserve(batch.messages.size());
+    for(auto& pair : batch.messages) {
+        batch.channels.push_back(get_channel(pair.first, pair.second));
+    }
 
     // Mark objects to be stored:
-    for(auto& pair : messages) {
+    for(auto& pair : batch.messages) {
         auto& message = pair.first;
-        auto object_array = message->getObjectArray();
+        auto object_array = message->getObjects();
         for(Object& object : object_array) {
             object.markForStorage();
         }
     }
 
-    // Generate trees and index data
-    for(auto& pair : messages) {
-        auto& message = pair.first;
-        auto& message_name = pair.second;
+    if(write_index_) {
+        std::lock_guard<std::mutex> lock(index_mutex_);
+        indexed_events_.push_back({batch.number, indexed_counts_.size(), batch.messages.size()});
+        for(size_t i = 0; i < batch.messages.size(); ++i) {
+            indexed_counts_.emplace_back(batch.channels[i],
+                                         static_cast<uint32_t>(batch.messages[i].first->getObjects().size()));
+        }
+    }
+    return batch;
+}
+
+void ROOTObjectWriterModule::petrify_history(EventBatch& batch) {
+    // Petrify the history of all objects:
+    for(auto& pair : batch.messages) {
+        auto object_array = pair.first->getObjects();
+        for(Object& object : object_array) {
+            // Trigger the creation of TRefs for cross-object references to be able to store them to file.
+            // We can reset the TObject count after processing this event because the TRef creation is only done here locally
+            // in one worker thread instead of framew-work wide.
+            object.petrifyHistory();
+        }
+    }
+}
+
+void ROOTObjectWriterModule::store_event(EventBatch batch) {
+    if(parallel_) {
+        auto& thread_trees = get_thread_trees();
+        std::lock_guard<std::mutex> lock(thread_trees.mutex);
+        write_event(thread_trees.tree_set, batch.messages, batch.channels);
+        thread_trees.events.push_back(batch.number);
+        return;
+    }
+
+    // Hand the event to the writing thread
+    batch.log_section = Log::getSection();
 
-        // Get the detector name
-        std::string detector_name;
-        if(message->getDetector() != nullptr) {
-            detector_name = message->getDetector()->getName();
+    // Wait for space in the queue and take the events written in the meantime to release them on this thread
+    std::vector<EventBatch> written;
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    push_condition_.wait(lock, [this]() { return queue_.size() < queue_size_ || !writer_error_.empty(); });
+    if(!writer_error_.empty()) {
+        throw ModuleError("Writing objects to file failed: " + writer_error_);
+    }
+    LOG(TRACE) << "Handing objects of event " << batch.number << " to the writing thread";
+    queue_.push_back(std::move(batch));
+    written.swap(written_);
+    lock.unlock();
+    pop_condition_.notify_one();
+}
+
+/**
+ * The writing thread fills the trees in the order the events have been queued, which is the order of the events since this
+ * module is sequential. Errors are stored and reported by the next event handed to the thread.
+ */
+void ROOTObjectWriterModule::run_writer(LogLevel log_level, LogFormat log_format) {
+    Log::setReportingLevel(log_level);
+    Log::setFormat(log_format);
+
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    while(true) {
+        pop_condition_.wait(lock, [this]() { return !queue_.empty() || stop_writer_; });
+        if(queue_.empty()) {
+            return;
         }
 
-        // Read the object
-        auto object_array = message->getObjectArray();
-        // object_array emptiness is checked in the filter
-        const Object& first_object = object_array[0];
-        std::type_index type_idx = typeid(first_object);
+        auto batch = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+        push_condition_.notify_one();
+
+        Log::setSection(batch.log_section);
+        Log::setEventNum(batch.number);
+        std::string error;
+        try {
+            start_entry(batch.number);
+            write_event(tree_set_, batch.messages, batch.channels);
+        } catch(const std::exception& e) {
+            error = e.what();
+        }
+
+        lock.lock();
+        written_.push_back(std::move(batch));
+        if(!error.empty()) {
+            // Discard all pending events and wake up the waiting worker to report the error
+            writer_error_ = error;
+            for(auto& pending : queue_) {
+                written_.push_back(std::move(pending));
+            }
+            queue_.clear();
+            push_condition_.notify_all();
+            return;
+        }
+    }
+}
+
+void ROOTObjectWriterModule::start_writer() {
+    stop_writer_ = false;
+    writer_thread_ = std::thread(&ROOTObjectWriterModule::run_writer, this, Log::getReportingLevel(), Log::getFormat());
+}
+
+void ROOTObjectWriterModule::stop_writer() {
+    if(!writer_thread_.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        stop_writer_ = true;
+    }
+    pop_condition_.notify_one();
+    writer_thread_.join();
+    written_.clear();
+}
+
+TTree* ROOTObjectWriterModule::create_tree(TreeSet& tree_set, const std::string& class_name) {
+    tree_set.directory->cd();
+    auto* tree = new TTree(class_name.c_str(), (std::string("Tree of ") + class_name).c_str());
+    tree_set.trees.emplace(class_name, std::unique_ptr<TTree>(tree));
+    if(auto_flush_.has_value()) {
+        tree->SetAutoFlush(auto_flush_.value());
+    }
+    return tree;
+}
+
+/**
+ * Settings for a branch, given by the tree name followed by a slash and the branch name, take precedence over the settings
+ * for the tree, which take precedence over the default settings.
+ */
+TBranch* ROOTObjectWriterModule::create_branch(TTree* tree,
+                                               const std::string& branch_name,
+                                               const std::string& type_name,
+                                               void* address) {
+    auto settings = default_storage_;
+    for(const auto& name : {std::string(tree->GetName()), std::string(tree->GetName()) + "/" + branch_name}) {
+        auto iter = storage_.find(name);
+        if(iter != storage_.end()) {
+            if(iter->second.compression >= 0) {
+                settings.compression = iter->second.compression;
+            }
+            if(iter->second.basket_size >= 0) {
+                settings.basket_size = iter->second.basket_size;
+            }
+        }
+    }
 
-        // Create a new branch of the correct type if this message was not received before
-        auto index_tuple = std::make_tuple(type_idx, detector_name, message_name);
-        if(write_list_.find(index_tuple) == write_list_.end()) {
+    auto* branch = tree->Bronch(branch_name.c_str(), type_name.c_str(), address, settings.basket_size);
+    if(settings.compression >= 0) {
+        branch->SetCompressionSettings(settings.compression);
+    }
+    return branch;
+}
 
-            std::string class_name = allpix::demangle(typeid(first_object).name());
-            std::string class_name_with_namespace = allpix::demangle(typeid(first_object).name(), true);
+size_t ROOTObjectWriterModule::get_channel(const std::shared_ptr<BaseMessage>& message, const std::string& name) {
+    const BaseMessage* inst = message.get();
+    auto key = std::make_tuple(std::type_index(typeid(*inst)), message->getDetector().get(), name);
+
+    std::lock_guard<std::mutex> lock(channel_mutex_);
+    auto iter = channel_ids_.find(key);
+    if(iter != channel_ids_.end()) {
+        return iter->second;
+    }
+
+    // Describe the branch of the new channel by its first object, non-empty messages are ensured by the filter
+    auto object_array = message->getObjects();
+    const Object& first_object = object_array[0];
+    Channel channel;
+    channel.class_name = allpix::demangle(typeid(first_object).name());
+    channel.class_name_with_namespace = allpix::demangle(typeid(first_object).name(), true);
+    channel.branch_name = (message->getDetector() == nullptr ? "global" : message->getDetector()->getName());
+    if(!name.empty()) {
+        channel.branch_name += "_";
+        channel.branch_name += name;
+    }
+
+    channels_.push_back(std::move(channel));
+    channel_ids_.emplace(std::move(key), channels_.size() - 1);
+    return channels_.size() - 1;
+}
+
+void ROOTObjectWriterModule::write_event(TreeSet& tree_set,
+                                         const std::vector<DispatchedMessage>& messages,
+                                         const std::vector<size_t>& channels) {
+    ALLPIX_PROFILE_ZONE("ROOTObjectWriter::writeEvent");
+    auto& trees = tree_set.trees;
+    auto& write_list = tree_set.write_list;
+
+    // Generate trees and index data
+    for(size_t i = 0; i < messages.size(); ++i) {
+        auto channel_id = channels[i];
+        if(write_list.size() <= channel_id) {
+            write_list.resize(channel_id + 1, nullptr);
+        }
+
+        // Create a new branch of the correct type if this channel was not written to this set of trees before
+        auto*& objects = write_list[channel_id];
+        if(objects == nullptr) {
+            Channel channel;
+            {
+                std::lock_guard<std::mutex> lock(channel_mutex_);
+                channel = channels_[channel_id];
+            }
+            const auto& class_name = channel.class_name;
+            const auto& branch_name = channel.branch_name;
 
             // Add vector of objects to write to the write list
-            write_list_[index_tuple] = new std::vector<Object*>();
-            auto* addr = &write_list_[index_tuple];
+            objects = new std::vector<Object*>();
 
-            auto new_tree = (trees_.find(class_name) == trees_.end());
+            auto new_tree = (trees.find(class_name) == trees.end());
             if(new_tree) {
                 // Create new tree
-                output_file_->cd();
-                trees_.emplace(class_name,
-                               std::make_unique<TTree>(class_name.c_str(), (std::string("Tree of ") + class_name).c_str()));
+                create_tree(tree_set, class_name);
             }
 
-            std::string branch_name = detector_name.empty() ? "global" : detector_name;
-            if(!message_name.empty()) {
-                branch_name += "_";
-                branch_name += message_name;
+            // Branches copied from the run interrupted at a checkpoint already hold all earlier entries
+            auto* restored_branch = (new_tree ? nullptr : trees[class_name]->GetBranch(branch_name.c_str()));
+            if(restored_branch != nullptr) {
+                LOG(DEBUG) << "Continuing branch " << branch_name << " of " << class_name << " restored from checkpoint";
+                restored_branch->SetAddress(&objects);
+            } else {
+                create_branch(trees[class_name].get(),
+                              branch_name,
+                              std::string("std::vector<") + channel.class_name_with_namespace + "*>",
+                              &objects);
             }
 
-            trees_[class_name]->Bronch(
-                branch_name.c_str(), (std::string("std::vector<") + class_name_with_namespace + "*>").c_str(), addr);
-
             // Prefill new tree or new branch with empty records for all events that were missed since the start
-            if(last_event_ > 0) {
+            if(tree_set.entries > 0 && restored_branch == nullptr) {
                 if(new_tree) {
-                    LOG(DEBUG) << "Pre-filling new tree of " << class_name << " with " << last_event_ << " empty events";
-                    for(uint64_t i = 0; i < last_event_; ++i) {
-                        trees_[class_name]->Fill();
+                    LOG(DEBUG) << "Pre-filling new tree of " << class_name << " with " << tree_set.entries
+                               << " empty events";
+                    for(uint64_t entry = 0; entry < tree_set.entries; ++entry) {
+                        trees[class_name]->Fill();
                     }
                 } else {
-                    LOG(DEBUG) << "Pre-filling new branch " << branch_name << " of " << class_name << " with " << last_event_
-                               << " empty events";
-                    auto* branch = trees_[class_name]->GetBranch(branch_name.c_str());
-                    for(uint64_t i = 0; i < last_event_; ++i) {
+                    LOG(DEBUG) << "Pre-filling new branch " << branch_name << " of " << class_name << " with "
+                               << tree_set.entries << " empty events";
+                    auto* branch = trees[class_name]->GetBranch(branch_name.c_str());
+                    for(uint64_t entry = 0; entry < tree_set.entries; ++entry) {
                         branch->Fill();
                     }
                 }
@@ -184,43 +569,400 @@ void ROOTObjectWriterModule::run(Event* event) {
         }
 
         // Fill the branch vector
-        for(Object& object : object_array) {
-            // Trigger the creation of TRefs for cross-object references to be able to store them to file.
-            // We can reset the TObject count after processing this event because the TRef creation is only done here locally
-            // in one worker thread instead of framew-work wide.
-            object.petrifyHistory();
+        for(Object& object : messages[i].first->getObjects()) {
             ++write_cnt_;
-            write_list_[index_tuple]->push_back(&object);
+            objects->push_back(&object);
         }
     }
 
     LOG(TRACE) << "Writing new objects to tree";
-    output_file_->cd();
+    tree_set.directory->cd();
 
-    // Save last event number for trees created later
-    last_event_ = event->number;
+    // Count the entries for trees created later
+    ++tree_set.entries;
 
     // Fill the tree with the current received messages
-    for(auto& tree : trees_) {
+    for(auto& tree : trees) {
         tree.second->Fill();
     }
 
     // Clear the current message list
-    for(auto& index_data : write_list_) {
-        index_data.second->clear();
+    for(auto* objects : write_list) {
+        if(objects != nullptr) {
+            objects->clear();
+        }
+    }
+}
+
+ROOTObjectWriterModule::ThreadTrees& ROOTObjectWriterModule::get_thread_trees() {
+    auto thread_num = ThreadPool::threadNum();
+    std::lock_guard<std::mutex> lock(thread_trees_mutex_);
+    auto& thread_trees = thread_trees_[thread_num];
+    if(thread_trees == nullptr) {
+        // Keep the trees of the thread in memory, compressed with the settings of the output file
+        LOG(DEBUG) << "Creating trees in memory for thread " << thread_num;
+        TDirectory::TContext directory_context;
+        thread_trees = std::make_unique<ThreadTrees>();
+        auto file_name = getUniqueName() + "_thread" + std::to_string(thread_num);
+        thread_trees->file = std::make_unique<TMemFile>(file_name.c_str(), "RECREATE");
+        thread_trees->file->SetCompressionSettings(output_file_->GetCompressionSettings());
+        thread_trees->tree_set.directory = thread_trees->file.get();
+    }
+    return *thread_trees;
+}
+
+/**
+ * All entries of the threads are sorted by their event number. The objects of every event are read from the trees of the
+ * thread which has processed it, into lists shared by all threads and bound to the branches of the trees in the data file.
+ * The history of the objects is restored from the stored references, which therefore requires the process lock.
+ */
+void ROOTObjectWriterModule::merge_thread_trees() {
+    ALLPIX_PROFILE_ZONE("ROOTObjectWriter::mergeThreadTrees");
+    struct Entry {
+        uint64_t event;
+        ThreadTrees* thread_trees;
+        Long64_t entry;
+    };
+    std::vector<Entry> entries;
+    for(auto& thread_trees : thread_trees_) {
+        auto& events = thread_trees.second->events;
+        for(size_t i = 0; i < events.size(); ++i) {
+            entries.push_back({events[i], thread_trees.second.get(), static_cast<Long64_t>(i)});
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) { return lhs.event < rhs.event; });
+    LOG(DEBUG) << "Merging " << entries.size() << " events written by " << thread_trees_.size() << " threads";
+
+    // Create the trees and branches of the data file and bind the branches of all threads to them
+    for(auto& thread_trees : thread_trees_) {
+        for(auto& tree : thread_trees.second->tree_set.trees) {
+            auto& class_name = tree.first;
+            if(tree_set_.trees.find(class_name) == tree_set_.trees.end()) {
+                create_tree(tree_set_, class_name);
+            }
+
+            TObjArray* branches = tree.second->GetListOfBranches();
+            for(int i = 0; i < branches->GetEntries(); ++i) {
+                auto* branch = static_cast<TBranch*>(branches->At(i));
+                auto key = std::make_pair(class_name, std::string(branch->GetName()));
+                if(merge_list_.find(key) == merge_list_.end()) {
+                    merge_list_[key] = new std::vector<Object*>();
+                    create_branch(tree_set_.trees[class_name].get(), key.second, branch->GetClassName(), &merge_list_[key]);
+                }
+                branch->SetAddress(&merge_list_[key]);
+            }
+        }
+    }
+
+    auto clear_objects = [this]() {
+        for(auto& merge_data : merge_list_) {
+            for(auto* object : *merge_data.second) {
+                delete object;
+            }
+            merge_data.second->clear();
+        }
+    };
+
+    for(auto& entry : entries) {
+        auto root_lock = root_process_lock();
+        clear_objects();
+        for(auto& tree : entry.thread_trees->tree_set.trees) {
+            tree.second->GetEntry(entry.entry);
+        }
+
+        start_entry(entry.event);
+        output_file_->cd();
+        for(auto& tree : tree_set_.trees) {
+            tree.second->Fill();
+        }
     }
+    clear_objects();
+
+    // Release the trees of the threads, which are not needed anymore
+    thread_trees_.clear();
 }
 
 void ROOTObjectWriterModule::finalize() {
+    ALLPIX_PROFILE_ZONE("ROOTObjectWriter::finalize");
+    LOG(TRACE) << "Waiting for the writing thread to write all events";
+    stop_writer();
+    if(!writer_error_.empty()) {
+        throw ModuleError("Writing objects to file failed: " + writer_error_);
+    }
+
+    if(parallel_) {
+        merge_thread_trees();
+    }
+
     LOG(TRACE) << "Writing objects to file";
     output_file_->cd();
 
     int branch_count = 0;
-    for(auto& tree : trees_) {
+    for(auto& tree : tree_set_.trees) {
         // Update statistics
         branch_count += tree.second->GetListOfBranches()->GetEntries();
     }
 
+    // Add the configuration and the detector setup
+    write_file_metadata();
+
+    // Finish writing to output file
+    output_file_->Write();
+
+    // Print the compression of every branch to tune the storage settings
+    for(auto& tree : tree_set_.trees) {
+        TObjArray* branches = tree.second->GetListOfBranches();
+        for(int i = 0; i < branches->GetEntries(); ++i) {
+            auto* branch = static_cast<TBranch*>(branches->At(i));
+            auto total_bytes = branch->GetTotBytes("*");
+            auto zip_bytes = branch->GetZipBytes("*");
+            auto factor = (zip_bytes > 0 ? static_cast<double>(total_bytes) / static_cast<double>(zip_bytes) : 1.);
+            LOG(INFO) << "Branch " << tree.first << "/" << branch->GetName() << " with compression settings "
+                      << branch->GetCompressionSettings() << " compressed from " << total_bytes << " to " << zip_bytes
+                      << " bytes, factor " << std::setprecision(3) << factor;
+        }
+    }
+
+    if(rotation_.enabled()) {
+        auto manifest_name = createOutputFile(file_name_, "manifest", true);
+        try {
+            rotation_.write_manifest(manifest_name);
+        } catch(const std::runtime_error& e) {
+            throw ModuleError(e.what());
+        }
+        LOG(STATUS) << "Wrote " << rotation_.chunks().size() << " output files listed in manifest:" << std::endl
+                    << manifest_name;
+    }
+
+    if(write_index_) {
+        write_event_index();
+    }
+
+    // Print statistics
+    LOG(STATUS) << "Wrote " << write_cnt_ << " objects to " << branch_count << " branches in file:" << std::endl
+                << output_file_name_;
+}
+
+/**
+ * The events handed to the writing thread are written before saving the trees. Saving the tree headers together with all
+ * filled baskets allows to recover the file up to the checkpoint even if the run is interrupted without closing it.
+ */
+void ROOTObjectWriterModule::storeCheckpoint(Configuration& state) {
+    stop_writer();
+    if(!writer_error_.empty()) {
+        throw ModuleError("Writing objects to file failed: " + writer_error_);
+    }
+
+    std::vector<std::string> trees;
+    for(auto& tree : tree_set_.trees) {
+        tree.second->AutoSave("SaveSelf FlushBaskets");
+        trees.push_back(tree.first);
+    }
+    state.set("file_name", output_file_name_);
+    state.set("entries", tree_set_.entries);
+    if(!trees.empty()) {
+        state.setArray("trees", trees);
+    }
+
+    if(asynchronous_) {
+        start_writer();
+    }
+}
+
+/**
+ * The file of the interrupted run is moved aside while the new data file is created, which usually has the same name.
+ * Its entries up to the checkpoint are copied, later entries are dropped since the events are simulated again. The copied
+ * branches are bound to empty object lists, until the first message of their channel replaces the list.
+ */
+void ROOTObjectWriterModule::restoreCheckpoint(const Configuration& state) {
+    if(!state.has("file_name")) {
+        throw ModuleError("Cannot resume from a checkpoint which does not contain the state of this module");
+    }
+    auto previous_file_name = state.get<std::string>("file_name");
+    auto entries = state.get<uint64_t>("entries");
+
+    // A previous attempt to resume might have stopped after moving the file aside
+    auto moved_file_name = previous_file_name + ".resume";
+    if(std::filesystem::is_regular_file(previous_file_name)) {
+        std::filesystem::rename(previous_file_name, moved_file_name);
+    } else if(!std::filesystem::is_regular_file(moved_file_name)) {
+        throw ModuleError("Cannot find data file " + previous_file_name + " of the interrupted run");
+    }
+    open_output_file();
+
+    {
+        auto root_lock = root_process_lock();
+        auto previous_file = std::make_unique<TFile>(moved_file_name.c_str(), "READ");
+        if(previous_file->IsZombie()) {
+            throw ModuleError("Cannot open data file " + previous_file_name + " of the interrupted run");
+        }
+        for(const auto& class_name : state.getArray<std::string>("trees", {})) {
+            TTree* previous_tree = nullptr;
+            previous_file->GetObject(class_name.c_str(), previous_tree);
+            if(previous_tree == nullptr || previous_tree->GetEntries() < static_cast<Long64_t>(entries)) {
+                throw ModuleError("Data file " + previous_file_name + " of the interrupted run does not contain " +
+                                  std::to_string(entries) + " entries of " + class_name);
+            }
+
+            // The copy is created in the current directory and should not share the object lists of the original
+            output_file_->cd();
+            auto* tree = previous_tree->CloneTree(static_cast<Long64_t>(entries));
+            tree->ResetBranchAddresses();
+            tree->SetDirectory(output_file_.get());
+            tree_set_.trees.emplace(class_name, std::unique_ptr<TTree>(tree));
+        }
+    }
+    tree_set_.entries = entries;
+
+    for(auto& tree : tree_set_.trees) {
+        TObjArray* branches = tree.second->GetListOfBranches();
+        for(int i = 0; i < branches->GetEntries(); ++i) {
+            restored_lists_.push_back(new std::vector<Object*>());
+            static_cast<TBranch*>(branches->At(i))->SetAddress(&restored_lists_.back());
+        }
+    }
+
+    if(output_file_name_ == previous_file_name) {
+        std::filesystem::remove(moved_file_name);
+    } else {
+        std::filesystem::rename(moved_file_name, previous_file_name);
+    }
+    LOG(STATUS) << "Copied " << entries << " events written before the checkpoint from file:" << std::endl
+                << previous_file_name;
+}
+
+/**
+ * Every event fills one entry of all trees, and the entries are ordered by the event numbers both when writing in sequence
+ * and when merging the trees of the threads. The entry of an event is therefore its position among the sorted events of its
+ * file, and the chunks of a split output hold consecutive ranges of the sorted events. Entries of ROOT trees are spread
+ * over the baskets of all branches, their data is located through the basket index of every branch and no single byte
+ * offset is stored.
+ */
+void ROOTObjectWriterModule::write_event_index() {
+    std::sort(indexed_events_.begin(), indexed_events_.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.number < rhs.number;
+    });
+
+    // All trees are listed in the index of every file, trees created only in later chunks have no objects in earlier ones
+    std::vector<std::string> trees;
+    std::map<std::string, size_t> tree_columns;
+    for(auto& tree : tree_set_.trees) {
+        tree_columns.emplace(tree.first, trees.size());
+        trees.push_back(tree.first);
+    }
+    std::vector<size_t> channel_columns;
+    for(auto& channel : channels_) {
+        channel_columns.push_back(tree_columns.at(channel.class_name));
+    }
+
+    std::vector<std::pair<std::string, uint64_t>> files;
+    if(rotation_.enabled()) {
+        for(const auto& chunk : rotation_.chunks()) {
+            files.emplace_back(chunk.file_name, chunk.events);
+        }
+    } else {
+        files.emplace_back(output_file_name_, indexed_events_.size());
+    }
+
+    size_t first_event = 0;
+    for(const auto& file : files) {
+        EventIndex index;
+        index.trees = trees;
+        index.counts.resize(file.second * trees.size());
+        for(size_t i = 0; i < file.second; ++i) {
+            const auto& event = indexed_events_.at(first_event + i);
+            index.events.push_back(event.number);
+            index.entries.push_back(i);
+            for(size_t j = event.first_count; j < event.first_count + event.count_size; ++j) {
+                index.counts[i * trees.size() + channel_columns[indexed_counts_[j].first]] += indexed_counts_[j].second;
+            }
+        }
+        first_event += file.second;
+
+        auto index_file_name = std::filesystem::path(file.first).replace_extension("apidx").string();
+        try {
+            event_index::write(index_file_name, index);
+        } catch(const std::runtime_error& e) {
+            throw ModuleError(e.what());
+        }
+        LOG(STATUS) << "Wrote index of " << index.events.size() << " events to file:" << std::endl << index_file_name;
+    }
+}
+
+void ROOTObjectWriterModule::open_output_file() {
+    auto file_name = file_name_;
+    if(rotation_.enabled()) {
+        file_name = OutputRotation::chunk_name(file_name, rotation_.chunks().size() + 1);
+    }
+    output_file_name_ = createOutputFile(file_name, "root", true);
+    output_file_ = std::make_unique<TFile>(output_file_name_.c_str(), "RECREATE");
+    if(file_compression_.has_value()) {
+        output_file_->SetCompressionSettings(file_compression_.value());
+    }
+    output_file_->cd();
+    tree_set_.directory = output_file_.get();
+    if(rotation_.enabled()) {
+        rotation_.open(output_file_name_);
+    }
+}
+
+void ROOTObjectWriterModule::start_entry(uint64_t event) {
+    if(!rotation_.enabled()) {
+        return;
+    }
+    if(rotation_.full(static_cast<uint64_t>(output_file_->GetEND()))) {
+        rotate_output_file();
+    }
+    rotation_.add_event(event);
+}
+
+/**
+ * The completed file is written together with the configuration and the detector setup, such that every chunk can be read
+ * on its own. The trees of the next file are created with the same branches, bound to the same object lists.
+ */
+void ROOTObjectWriterModule::rotate_output_file() {
+    write_file_metadata();
+    output_file_->Write();
+    LOG(INFO) << "Closing output file " << output_file_name_ << " with " << tree_set_.entries << " events";
+
+    std::vector<std::tuple<std::string, std::string, std::string>> branches;
+    for(auto& tree : tree_set_.trees) {
+        TObjArray* tree_branches = tree.second->GetListOfBranches();
+        for(int i = 0; i < tree_branches->GetEntries(); ++i) {
+            auto* branch = static_cast<TBranch*>(tree_branches->At(i));
+            branches.emplace_back(tree.first, branch->GetName(), branch->GetClassName());
+        }
+    }
+    tree_set_.trees.clear();
+    output_file_->Close();
+
+    open_output_file();
+    tree_set_.entries = 0;
+    for(auto& [class_name, branch_name, type_name] : branches) {
+        if(tree_set_.trees.find(class_name) == tree_set_.trees.end()) {
+            create_tree(tree_set_, class_name);
+        }
+        create_branch(
+            tree_set_.trees[class_name].get(), branch_name, type_name, get_branch_address(class_name, branch_name));
+    }
+}
+
+void* ROOTObjectWriterModule::get_branch_address(const std::string& class_name, const std::string& branch_name) {
+    if(parallel_) {
+        return &merge_list_.at(std::make_pair(class_name, branch_name));
+    }
+
+    std::lock_guard<std::mutex> lock(channel_mutex_);
+    for(size_t channel_id = 0; channel_id < tree_set_.write_list.size(); ++channel_id) {
+        if(tree_set_.write_list[channel_id] != nullptr && channels_[channel_id].class_name == class_name &&
+           channels_[channel_id].branch_name == branch_name) {
+            return &tree_set_.write_list[channel_id];
+        }
+    }
+    throw ModuleError("Cannot find the objects of branch " + branch_name + " of tree " + class_name);
+}
+
+void ROOTObjectWriterModule::write_file_metadata() {
     // Create main config directory
     TDirectory* config_dir = output_file_->mkdir("config");
     config_dir->cd();
@@ -249,13 +991,13 @@ void ROOTObjectWriterModule::finalize() {
         auto* section_dir = config_dir->mkdir(unique_name.c_str());
         LOG(TRACE) << "Writing configuration for: " << unique_name;
 
-        // Loop over all values in the section
-        for(auto& key_value : config.getAll()) {
+        // Loop over all values in the section, values shared between the instances of a module are not copied
+        for(auto& key_value : config.getAllShared()) {
             // Skip the identifier
             if(key_value.first == "identifier") {
                 continue;
             }
-            section_dir->WriteObject(&key_value.second, key_value.first.c_str());
+            section_dir->WriteObject(key_value.second.get(), key_value.first.c_str());
         }
     }
 
@@ -295,11 +1037,4 @@ void ROOTObjectWriterModule::finalize() {
             }
         }
     }
-
-    // Finish writing to output file
-    output_file_->Write();
-
-    // Print statistics
-    LOG(STATUS) << "Wrote " << write_cnt_ << " objects to " << branch_count << " branches in file:" << std::endl
-                << output_file_name_;
 }
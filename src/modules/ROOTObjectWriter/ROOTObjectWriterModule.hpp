@@ -8,10 +8,20 @@
  */
 
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <typeindex>
+#include <vector>
 
 #include <TFile.h>
+#include <TMemFile.h>
 #include <TTree.h>
 
 #include "core/config/Configuration.hpp"
@@ -19,6 +29,9 @@
 #include "core/messenger/Messenger.hpp"
 #include "core/module/Event.hpp"
 #include "core/module/Module.hpp"
+#include "core/utils/log.h"
+
+#include "tools/output_rotation.h"
 
 namespace allpix {
     /**
@@ -28,8 +41,24 @@ namespace allpix {
      * Listens to all objects dispatched in the framework. Creates a tree as soon as a new type of object is encountered and
      * saves the data in those objects to tree for every event. The tree name is the class name of the object. A separate
      * branch is created for every combination of detector name and message name that outputs this object.
+     *
+     * By default, the trees are filled by a dedicated writing thread. The messages of every event are handed to this thread
+     * through a bounded queue, such that compressing and writing the data overlaps with the simulation of further events.
+     * Alternatively, every worker fills its own set of trees in memory without requiring the events in sequence. These trees
+     * are merged into the data file in the order of the events when finalizing.
      */
     class ROOTObjectWriterModule : public SequentialModule {
+        /**
+         * @brief Compression algorithms of ROOT, with the values of the ROOT algorithm enumeration
+         */
+        enum class CompressionAlgorithm {
+            GLOBAL = 0, ///< Global default algorithm of ROOT
+            ZLIB = 1,   ///< ZLIB compression
+            LZMA = 2,   ///< LZMA compression, for the smallest files
+            LZ4 = 4,    ///< LZ4 compression, for the fastest compression and decompression
+            ZSTD = 5,   ///< ZSTD compression
+        };
+
     public:
         /**
          * @brief Constructor for this unique module
@@ -39,7 +68,7 @@ namespace allpix {
          */
         ROOTObjectWriterModule(Configuration& config, Messenger* messenger, GeometryManager* geo_mgr);
         /**
-         * @brief Destructor deletes the internal objects used to build the ROOT Tree
+         * @brief Destructor stops the writing thread and deletes the internal objects used to build the ROOT Tree
          */
         ~ROOTObjectWriterModule() override;
 
@@ -56,17 +85,210 @@ namespace allpix {
         void initialize() override;
 
         /**
-         * @brief Writes the objects fetched to their specific tree, constructing trees on the fly for new objects.
+         * @brief Prepares the objects fetched for storage and writes them or hands them to the writing thread
          */
         void run(Event* event) override;
 
+        /**
+         * @brief Prepares the objects of all events of a batch for storage under a single process lock
+         */
+        void run(const std::vector<Event*>& events) override;
+
         /**
          * @brief Add the main configuration and the detector setup to the data file and write it, also write statistics
          * information.
          */
         void finalize() override;
 
+        /**
+         * @brief Write all pending events and save the trees, storing the data file and the number of written entries
+         * @param state Configuration to store the state of the module in
+         */
+        void storeCheckpoint(Configuration& state) override;
+
+        /**
+         * @brief Create the data file with the entries written by the interrupted run up to the checkpoint
+         * @param state Configuration with the state of the module as stored by \ref storeCheckpoint
+         */
+        void restoreCheckpoint(const Configuration& state) override;
+
     private:
+        /**
+         * @brief Messages of a single event, keeping their objects alive until they have been written
+         */
+        struct EventBatch {
+            uint64_t number{};
+            std::string log_section;
+            std::vector<DispatchedMessage> messages;
+            std::vector<size_t> channels;
+        };
+
+        /**
+         * @brief Description of the objects of a message type, detector and message name stored in one branch
+         */
+        struct Channel {
+            std::string class_name;
+            std::string class_name_with_namespace;
+            std::string branch_name;
+        };
+
+        /**
+         * @brief Trees of all object types in a directory, together with the objects written for the current entry
+         */
+        struct TreeSet {
+            /**
+             * @brief Deletes the object lists bound to the branches
+             */
+            ~TreeSet();
+
+            TDirectory* directory{};
+
+            // List of trees of the set, by class name
+            std::map<std::string, std::unique_ptr<TTree>> trees;
+
+            // List of objects of every channel, null until the branch of the channel has been created in this set. A deque
+            // keeps the addresses bound to the branches valid when adding channels.
+            std::deque<std::vector<Object*>*> write_list;
+
+            // Number of entries filled into every tree
+            uint64_t entries{0};
+        };
+
+        /**
+         * @brief Trees filled by a single worker thread in memory, with the event number of every entry
+         */
+        struct ThreadTrees {
+            std::mutex mutex;
+            std::unique_ptr<TMemFile> file;
+            TreeSet tree_set;
+            std::vector<uint64_t> events;
+        };
+
+        /**
+         * @brief Tuning of the storage of a tree or branch
+         */
+        struct StorageSettings {
+            int compression{-1};
+            int basket_size{-1};
+        };
+
+        /**
+         * @brief Create a new tree in a set of trees, with the configured clustering
+         * @param tree_set Set of trees to add the tree to
+         * @param class_name Class name of the objects stored in the tree
+         * @return Created tree
+         */
+        TTree* create_tree(TreeSet& tree_set, const std::string& class_name);
+
+        /**
+         * @brief Create a new branch in a tree, with the configured basket size and compression
+         * @param tree Tree to add the branch to
+         * @param branch_name Name of the branch
+         * @param type_name Type of the object list stored in the branch
+         * @param address Address of the pointer to the object list
+         * @return Created branch
+         */
+        TBranch* create_branch(TTree* tree, const std::string& branch_name, const std::string& type_name, void* address);
+
+        /**
+         * @brief Fetch the messages of an event, resolve their channels and mark their objects for storage
+         * @param event Event to store
+         * @return Messages of the event to write
+         */
+        EventBatch prepare_event(Event* event);
+
+        /**
+         * @brief Create the references between the objects of an event, requires the process lock
+         * @param batch Messages of the event
+         */
+        static void petrify_history(EventBatch& batch);
+
+        /**
+         * @brief Write the messages of an event to the trees of the thread or hand them to the writing thread
+         * @param batch Messages of the event
+         */
+        void store_event(EventBatch batch);
+
+        /**
+         * @brief Write the index of the events to their entries and object counts next to every data file
+         */
+        void write_event_index();
+
+        /**
+         * @brief Create the data file, or the file of the next chunk if the output is split
+         */
+        void open_output_file();
+
+        /**
+         * @brief Account for the next entry of the data file, starting a new chunk first if the current one is full
+         * @param event Number of the event stored in the entry
+         */
+        void start_entry(uint64_t event);
+
+        /**
+         * @brief Complete the current data file and continue with the trees in the file of the next chunk
+         */
+        void rotate_output_file();
+
+        /**
+         * @brief Get the address of the object list bound to a branch of the data file
+         * @param class_name Class name of the tree
+         * @param branch_name Name of the branch
+         * @return Address of the pointer to the object list
+         */
+        void* get_branch_address(const std::string& class_name, const std::string& branch_name);
+
+        /**
+         * @brief Add the main configuration and the detector setup to the data file
+         */
+        void write_file_metadata();
+
+        /**
+         * @brief Get the identifier of the channel of a message, registering a new channel on first use
+         * @param message Message to store
+         * @param name Name of the message
+         * @return Index of the channel
+         */
+        size_t get_channel(const std::shared_ptr<BaseMessage>& message, const std::string& name);
+
+        /**
+         * @brief Writes the objects of an event to their specific tree, constructing trees on the fly for new objects
+         * @param tree_set Trees to fill with the objects
+         * @param messages Messages of the event to write
+         * @param channels Channel of every message
+         */
+        void write_event(TreeSet& tree_set,
+                         const std::vector<DispatchedMessage>& messages,
+                         const std::vector<size_t>& channels);
+
+        /**
+         * @brief Get the trees of the calling worker thread, creating them on first use
+         * @return Trees of the calling thread
+         */
+        ThreadTrees& get_thread_trees();
+
+        /**
+         * @brief Merges the trees of all worker threads into the data file in the order of the events
+         */
+        void merge_thread_trees();
+
+        /**
+         * @brief Writes the queued events in the background until the writing thread is stopped
+         * @param log_level Reporting level of the logger for the writing thread
+         * @param log_format Format of the logger for the writing thread
+         */
+        void run_writer(LogLevel log_level, LogFormat log_format);
+
+        /**
+         * @brief Starts the thread writing the queued events
+         */
+        void start_writer();
+
+        /**
+         * @brief Waits until all queued events have been written and stops the writing thread
+         */
+        void stop_writer();
+
         Messenger* messenger_;
         GeometryManager* geo_mgr_;
 
@@ -74,20 +296,68 @@ namespace allpix {
         std::set<std::string> include_;
         std::set<std::string> exclude_;
 
-        // Output data file to write
+        // Result of the include and exclude lists for every message type received so far
+        mutable std::shared_mutex filter_mutex_;
+        mutable std::map<std::type_index, bool> filter_cache_;
+
+        // Channels of all stored messages, by message type, detector and message name
+        std::mutex channel_mutex_;
+        std::map<std::tuple<std::type_index, const Detector*, std::string>, size_t> channel_ids_;
+        std::deque<Channel> channels_;
+
+        // Output data file to write, and the chunks of the output if it is split
         std::unique_ptr<TFile> output_file_;
         std::string output_file_name_{};
+        std::string file_name_;
+        std::optional<int> file_compression_;
+        OutputRotation rotation_;
 
-        // Last event processed
-        uint64_t last_event_{0};
+        // Trees that are stored in data file
+        TreeSet tree_set_;
 
-        // List of trees that are stored in data file
-        std::map<std::string, std::unique_ptr<TTree>> trees_;
+        // Empty object lists bound to the branches copied from the run interrupted at a checkpoint, until they are written
+        bool resume_{};
+        std::deque<std::vector<Object*>*> restored_lists_;
 
-        // List of objects of a particular type, bound to a specific detector and having a particular name
-        std::map<std::tuple<std::type_index, std::string, std::string>, std::vector<Object*>*> write_list_;
+        // Storage settings of the trees, of individual trees or branches and the clustering
+        StorageSettings default_storage_;
+        std::map<std::string, StorageSettings> storage_;
+        std::optional<Long64_t> auto_flush_;
 
         // Statistical information about number of objects
         std::atomic<unsigned long> write_cnt_{};
+
+        // Writing thread and the queue of events handed to it
+        bool asynchronous_{};
+        size_t queue_size_{};
+        std::thread writer_thread_;
+        std::mutex queue_mutex_;
+        std::condition_variable push_condition_;
+        std::condition_variable pop_condition_;
+        std::deque<EventBatch> queue_;
+        bool stop_writer_{false};
+        std::string writer_error_;
+
+        // Events written by the writing thread, released by the next worker to avoid freeing event memory on that thread
+        std::vector<EventBatch> written_;
+
+        // Trees of the worker threads when writing in parallel, by thread number
+        bool parallel_{};
+        std::mutex thread_trees_mutex_;
+        std::map<unsigned int, std::unique_ptr<ThreadTrees>> thread_trees_;
+
+        // Events stored for the index, with the number of objects of every channel they contain
+        struct IndexedEvent {
+            uint64_t number;
+            size_t first_count;
+            size_t count_size;
+        };
+        bool write_index_{};
+        std::mutex index_mutex_;
+        std::vector<IndexedEvent> indexed_events_;
+        std::vector<std::pair<size_t, uint32_t>> indexed_counts_;
+
+        // Objects read from the trees of the worker threads while merging, by class and branch name
+        std::map<std::pair<std::string, std::string>, std::vector<Object*>*> merge_list_;
     };
 } // namespace allpix
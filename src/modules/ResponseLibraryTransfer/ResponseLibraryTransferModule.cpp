@@ -0,0 +1,156 @@
+/**
+ * @file
+ * @brief Implementation of the module transferring deposited charges to pixels using a charge collection response library
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "ResponseLibraryTransferModule.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/config/exceptions.h"
+#include "core/utils/distributions.h"
+#include "core/utils/log.h"
+#include "core/utils/unit.h"
+#include "objects/Pulse.hpp"
+
+using namespace allpix;
+
+ResponseLibraryTransferModule::ResponseLibraryTransferModule(Configuration& config,
+                                                             Messenger* messenger,
+                                                             std::shared_ptr<Detector> detector)
+    : Module(config, detector), messenger_(messenger), detector_(std::move(detector)) {
+    // Enable multithreading of this module if multithreading is enabled
+    allow_multithreading();
+
+    config_.setDefault("timestep", Units::get(0.01, "ns"));
+    timestep_ = config_.get<double>("timestep");
+
+    // Require deposits for single detector
+    messenger_->bindSingle<DepositedChargeMessage>(this, MsgFlags::REQUIRED);
+}
+
+void ResponseLibraryTransferModule::initialize() {
+    try {
+        library_ = response_library::read(config_.getPath("file_name", true));
+    } catch(const std::runtime_error& e) {
+        throw InvalidValueError(config_, "file_name", e.what());
+    }
+
+    // The tabulated response is only valid for the pixel cell it has been created for
+    auto model = detector_->getModel();
+    auto matches = [](double library, double model) { return std::fabs(library - model) <= 1e-6 * std::fabs(model); };
+    if(!matches(library_.pixel_size[0], model->getPixelSize().x()) ||
+       !matches(library_.pixel_size[1], model->getPixelSize().y()) ||
+       !matches(library_.thickness, model->getSensorSize().z())) {
+        throw InvalidValueError(config_,
+                                "file_name",
+                                "response library has been created for a pixel size of " +
+                                    Units::display(ROOT::Math::XYVector(library_.pixel_size[0], library_.pixel_size[1]),
+                                                   {"um", "mm"}) +
+                                    " and a sensor thickness of " + Units::display(library_.thickness, {"um", "mm"}) +
+                                    " which do not match the model of detector " + detector_->getName());
+    }
+
+    auto filled = std::count_if(
+        library_.entries.begin(), library_.entries.end(), [](const auto& entry) { return entry.deposited > 0; });
+    LOG(INFO) << "Read response library with " << library_.bins[0] << "x" << library_.bins[1] << "x" << library_.bins[2]
+              << " bins, " << filled << " of " << library_.entries.size() << " bins filled";
+}
+
+void ResponseLibraryTransferModule::run(Event* event) {
+    auto deposits_message = messenger_->fetchMessage<DepositedChargeMessage>(this, event);
+    auto model = detector_->getModel();
+    auto radius = static_cast<int>(library_.radius);
+
+    std::map<Pixel::Index, Pulse> pixel_pulses;
+    unsigned long transferred_charges_count = 0;
+    for(const auto& deposit : deposits_message->getData()) {
+        auto position = deposit.getLocalPosition();
+        auto [xpixel, ypixel] = model->getPixelIndex(position);
+        if(!model->isWithinPixelGrid(xpixel, ypixel)) {
+            LOG(TRACE) << "Skipping set of " << deposit.getCharge() << " deposited charges at "
+                       << Units::display(position, {"mm", "um"}) << " because their pixel (" << xpixel << "," << ypixel
+                       << ") is outside the grid";
+            continue;
+        }
+
+        auto center = model->getPixelCenter(static_cast<unsigned int>(xpixel), static_cast<unsigned int>(ypixel));
+        auto bin = library_.locate((deposit.getType() == CarrierType::HOLE ? 1 : 0),
+                                   position.x() - center.x(),
+                                   position.y() - center.y(),
+                                   position.z() - model->getSensorCenter().z());
+        const auto& entry = library_.entries[bin];
+        if(entry.deposited <= 0) {
+            LOG_ONCE(WARNING) << "Response library contains no response for some of the deposits, these are ignored."
+                              << " Increase the statistics used to create the library or reduce its number of bins";
+            missing_response_ += deposit.getCharge();
+            continue;
+        }
+
+        // Distribute the carriers over the neighbours following their multinomial distribution, which is sampled as a
+        // sequence of binomial distributions of the remaining carriers
+        auto remaining = deposit.getCharge();
+        double remaining_fraction = 1.;
+        auto sign = static_cast<double>(static_cast<int>(deposit.getType()));
+        for(int dy = -radius; dy <= radius && remaining > 0; ++dy) {
+            for(int dx = -radius; dx <= radius && remaining > 0; ++dx) {
+                auto fraction = library_.fractions[library_.neighbour(bin, dx, dy)];
+                if(fraction <= 0 || remaining_fraction <= 0) {
+                    continue;
+                }
+                auto probability = std::min(fraction / remaining_fraction, 1.);
+                remaining_fraction -= fraction;
+                auto collected =
+                    allpix::binomial_distribution<unsigned int>(remaining, probability)(event->getRandomEngine());
+                remaining -= collected;
+                if(collected == 0 || !model->isWithinPixelGrid(xpixel + dx, ypixel + dy)) {
+                    continue;
+                }
+
+                auto arrival = entry.time_mean;
+                if(entry.time_sigma > 0) {
+                    arrival =
+                        allpix::normal_distribution<double>(entry.time_mean, entry.time_sigma)(event->getRandomEngine());
+                }
+                Pixel::Index index(static_cast<unsigned int>(xpixel + dx), static_cast<unsigned int>(ypixel + dy));
+                auto pulse = pixel_pulses.try_emplace(index, timestep_);
+                pulse.first->second.addCharge(sign * collected, std::max(deposit.getLocalTime() + arrival, 0.));
+                transferred_charges_count += collected;
+            }
+        }
+    }
+
+    // Create pixel charges
+    std::vector<PixelCharge> pixel_charges;
+    pixel_charges.reserve(pixel_pulses.size());
+    for(auto& [index, pulse] : pixel_pulses) {
+        auto pixel = detector_->getPixel(index);
+        pixel_charges.emplace_back(pixel, std::move(pulse));
+        LOG(DEBUG) << "Set of " << pixel_charges.back().getCharge() << " charges transferred to " << index;
+    }
+
+    LOG(INFO) << "Transferred " << transferred_charges_count << " charges to " << pixel_charges.size() << " pixels";
+    total_transferred_charges_ += transferred_charges_count;
+
+    // Dispatch message of pixel charges
+    auto pixel_message = event->makeShared<PixelChargeMessage>(std::move(pixel_charges), detector_);
+    messenger_->dispatchMessage(this, pixel_message, event);
+}
+
+void ResponseLibraryTransferModule::finalize() {
+    if(missing_response_ > 0) {
+        LOG(WARNING) << missing_response_ << " deposited charges have been ignored since the library has no response for "
+                     << "their bin";
+    }
+    LOG(INFO) << "Transferred total of " << total_transferred_charges_ << " charges";
+}
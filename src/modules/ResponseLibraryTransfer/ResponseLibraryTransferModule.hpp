@@ -0,0 +1,72 @@
+/**
+ * @file
+ * @brief Definition of the module transferring deposited charges to pixels using a charge collection response library
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "core/config/Configuration.hpp"
+#include "core/geometry/GeometryManager.hpp"
+#include "core/messenger/Messenger.hpp"
+#include "core/module/Event.hpp"
+#include "core/module/Module.hpp"
+
+#include "objects/DepositedCharge.hpp"
+#include "objects/PixelCharge.hpp"
+
+#include "tools/response_library.h"
+
+namespace allpix {
+    /**
+     * @ingroup Modules
+     * @brief Module converting deposited charges directly to pixel charges by looking up a response library
+     * @note This module supports multithreading
+     *
+     * Replaces the propagation and transfer of the charge carriers by the response tabulated with the
+     * ResponseLibraryWriter module. For every deposit, the number of charge carriers collected at each pixel of the
+     * neighbourhood is drawn according to the collected fraction of the bin of the deposit, and their arrival time is
+     * sampled from the tabulated arrival time distribution.
+     */
+    class ResponseLibraryTransferModule : public Module {
+    public:
+        /**
+         * @brief Constructor for this detector-specific module
+         * @param config Configuration object for this module as retrieved from the steering file
+         * @param messenger Pointer to the messenger object to allow binding to messages on the bus
+         * @param detector Pointer to the detector for this module instance
+         */
+        ResponseLibraryTransferModule(Configuration& config, Messenger* messenger, std::shared_ptr<Detector> detector);
+
+        /**
+         * @brief Read the library and check that it matches the detector model
+         */
+        void initialize() override;
+
+        /**
+         * @brief Transfer the deposited charges to the pixels
+         */
+        void run(Event* event) override;
+
+        /**
+         * @brief Display statistical summary
+         */
+        void finalize() override;
+
+    private:
+        Messenger* messenger_;
+        std::shared_ptr<Detector> detector_;
+
+        ResponseLibrary library_;
+        double timestep_{};
+
+        // Statistics
+        std::atomic<unsigned long> total_transferred_charges_{};
+        std::atomic<unsigned long> missing_response_{};
+    };
+} // namespace allpix
@@ -0,0 +1,174 @@
+/**
+ * @file
+ * @brief Implementation of the module building a charge collection response library from a full simulation
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "ResponseLibraryWriterModule.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <Math/DisplacementVector3D.h>
+
+#include "core/messenger/exceptions.h"
+#include "core/module/exceptions.h"
+#include "core/utils/log.h"
+#include "objects/exceptions.h"
+
+using namespace allpix;
+
+ResponseLibraryWriterModule::ResponseLibraryWriterModule(Configuration& config,
+                                                         Messenger* messenger,
+                                                         std::shared_ptr<Detector> detector)
+    : Module(config, detector), messenger_(messenger), detector_(std::move(detector)) {
+    // Enable multithreading of this module if multithreading is enabled
+    allow_multithreading();
+
+    config_.setDefault<std::string>("file_name", "response");
+    config_.setDefault<ROOT::Math::DisplacementVector3D<ROOT::Math::Cartesian3D<unsigned int>>>(
+        "bins", ROOT::Math::DisplacementVector3D<ROOT::Math::Cartesian3D<unsigned int>>(10, 10, 10));
+    config_.setDefault<unsigned int>("radius", 1);
+
+    // Require the deposits and the resulting pixel charges of the detector
+    messenger_->bindSingle<DepositedChargeMessage>(this, MsgFlags::REQUIRED);
+    messenger_->bindSingle<PixelChargeMessage>(this, MsgFlags::NONE);
+}
+
+void ResponseLibraryWriterModule::initialize() {
+    auto bins = config_.get<ROOT::Math::DisplacementVector3D<ROOT::Math::Cartesian3D<unsigned int>>>("bins");
+    if(bins.x() < 1 || bins.y() < 1 || bins.z() < 1) {
+        throw InvalidValueError(config_, "bins", "at least one bin is required in every dimension");
+    }
+
+    output_file_name_ = createOutputFile(config_.get<std::string>("file_name"), "aprl");
+
+    auto model = detector_->getModel();
+    library_.bins = {bins.x(), bins.y(), bins.z()};
+    library_.radius = config_.get<unsigned int>("radius");
+    library_.pixel_size = {model->getPixelSize().x(), model->getPixelSize().y()};
+    library_.thickness = model->getSensorSize().z();
+
+    auto entries = 2 * library_.size();
+    deposited_.assign(entries, 0.);
+    arrived_.assign(entries, 0.);
+    time_sum_.assign(entries, 0.);
+    time_sum2_.assign(entries, 0.);
+    collected_.assign(entries * library_.neighbours(), 0.);
+
+    LOG(INFO) << "Tabulating the response in " << bins.x() << "x" << bins.y() << "x" << bins.z() << " bins with "
+              << library_.neighbours() << " neighbouring pixels each";
+}
+
+void ResponseLibraryWriterModule::run(Event* event) {
+    auto deposits_message = messenger_->fetchMessage<DepositedChargeMessage>(this, event);
+    auto model = detector_->getModel();
+
+    // Collect the charge and arrival times at every pixel for each deposit from the history of the pixel charges
+    struct Collection {
+        double charge;
+        double time_sum;
+        double time_sum2;
+    };
+    std::map<const DepositedCharge*, std::map<Pixel::Index, Collection>> collections;
+    try {
+        auto pixels_message = messenger_->fetchMessage<PixelChargeMessage>(this, event);
+        for(const auto& pixel_charge : pixels_message->getData()) {
+            for(const auto* propagated_charge : pixel_charge.getPropagatedCharges()) {
+                const auto* deposit = propagated_charge->getDepositedCharge();
+                auto charge = static_cast<double>(propagated_charge->getCharge());
+                auto time = propagated_charge->getLocalTime() - deposit->getLocalTime();
+                auto& collection = collections[deposit][pixel_charge.getIndex()];
+                collection.charge += charge;
+                collection.time_sum += charge * time;
+                collection.time_sum2 += charge * time * time;
+            }
+        }
+    } catch(const MessageNotFoundException&) {
+        LOG(DEBUG) << "No pixel charges received, none of the deposits has been collected";
+    } catch(const MissingReferenceException&) {
+        throw ModuleError("Monte Carlo history of the pixel charges is not available, cannot relate it to the deposits");
+    }
+
+    std::lock_guard<std::mutex> lock{accumulator_mutex_};
+    for(const auto& deposit : deposits_message->getData()) {
+        auto position = deposit.getLocalPosition();
+        auto [xpixel, ypixel] = model->getPixelIndex(position);
+        if(!model->isWithinPixelGrid(xpixel, ypixel)) {
+            outside_grid_++;
+            continue;
+        }
+
+        auto center = model->getPixelCenter(static_cast<unsigned int>(xpixel), static_cast<unsigned int>(ypixel));
+        auto hole = (deposit.getType() == CarrierType::HOLE ? 1 : 0);
+        auto bin = library_.locate(hole,
+                                   position.x() - center.x(),
+                                   position.y() - center.y(),
+                                   position.z() - model->getSensorCenter().z());
+        deposited_[bin] += deposit.getCharge();
+
+        auto collection = collections.find(&deposit);
+        if(collection == collections.end()) {
+            continue;
+        }
+        for(const auto& [index, pixel] : collection->second) {
+            auto dx = static_cast<int>(index.x()) - xpixel;
+            auto dy = static_cast<int>(index.y()) - ypixel;
+            auto radius = static_cast<int>(library_.radius);
+            if(std::abs(dx) > radius || std::abs(dy) > radius) {
+                outside_neighbourhood_ += static_cast<size_t>(pixel.charge);
+                continue;
+            }
+            collected_[library_.neighbour(bin, dx, dy)] += pixel.charge;
+            arrived_[bin] += pixel.charge;
+            time_sum_[bin] += pixel.time_sum;
+            time_sum2_[bin] += pixel.time_sum2;
+        }
+    }
+}
+
+void ResponseLibraryWriterModule::finalize() {
+    library_.entries.resize(deposited_.size());
+    library_.fractions.assign(collected_.size(), 0.);
+    size_t filled = 0;
+    for(size_t bin = 0; bin < deposited_.size(); ++bin) {
+        auto& entry = library_.entries[bin];
+        entry.deposited = deposited_[bin];
+        entry.time_mean = (arrived_[bin] > 0 ? time_sum_[bin] / arrived_[bin] : 0.);
+        entry.time_sigma =
+            (arrived_[bin] > 0 ? std::sqrt(std::max(time_sum2_[bin] / arrived_[bin] - entry.time_mean * entry.time_mean, 0.))
+                               : 0.);
+        if(deposited_[bin] > 0) {
+            filled++;
+            for(size_t neighbour = 0; neighbour < library_.neighbours(); ++neighbour) {
+                auto index = bin * library_.neighbours() + neighbour;
+                library_.fractions[index] = collected_[index] / deposited_[bin];
+            }
+        }
+    }
+
+    if(outside_grid_ > 0) {
+        LOG(INFO) << outside_grid_ << " deposits outside the pixel grid have been ignored";
+    }
+    if(outside_neighbourhood_ > 0) {
+        LOG(WARNING) << outside_neighbourhood_ << " charge carriers have been collected outside the neighbourhood of "
+                     << library_.radius << " pixels around their deposit, consider increasing the radius";
+    }
+
+    try {
+        response_library::write(output_file_name_, library_);
+    } catch(const std::runtime_error& e) {
+        throw ModuleError(e.what());
+    }
+    LOG(STATUS) << "Wrote response library with " << filled << " of " << deposited_.size() << " bins filled to file:"
+                << std::endl
+                << output_file_name_;
+}
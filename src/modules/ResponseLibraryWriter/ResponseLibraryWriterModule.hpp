@@ -0,0 +1,84 @@
+/**
+ * @file
+ * @brief Definition of the module building a charge collection response library from a full simulation
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "core/config/Configuration.hpp"
+#include "core/geometry/GeometryManager.hpp"
+#include "core/messenger/Messenger.hpp"
+#include "core/module/Event.hpp"
+#include "core/module/Module.hpp"
+
+#include "objects/DepositedCharge.hpp"
+#include "objects/PixelCharge.hpp"
+
+#include "tools/response_library.h"
+
+namespace allpix {
+    /**
+     * @ingroup Modules
+     * @brief Module to tabulate the charge collection response of the pixel cell in a response library
+     * @note This module supports multithreading
+     *
+     * Follows the Monte Carlo history of the pixel charges back to the deposited charges they originate from and accumulates
+     * the fraction of every deposit collected at the pixels around the pixel of the deposit as well as the arrival time of
+     * the collected carriers, binned in in-pixel position and depth. The resulting library can be used with the
+     * ResponseLibraryTransfer module to convert deposited charges directly to pixel charges.
+     */
+    class ResponseLibraryWriterModule : public Module {
+    public:
+        /**
+         * @brief Constructor for this detector-specific module
+         * @param config Configuration object for this module as retrieved from the steering file
+         * @param messenger Pointer to the messenger object to allow binding to messages on the bus
+         * @param detector Pointer to the detector for this module instance
+         */
+        ResponseLibraryWriterModule(Configuration& config, Messenger* messenger, std::shared_ptr<Detector> detector);
+
+        /**
+         * @brief Set up the binning of the library
+         */
+        void initialize() override;
+
+        /**
+         * @brief Accumulate the response to the deposits of the event
+         */
+        void run(Event* event) override;
+
+        /**
+         * @brief Normalize the accumulated response and write the library
+         */
+        void finalize() override;
+
+    private:
+        Messenger* messenger_;
+        std::shared_ptr<Detector> detector_;
+
+        std::string output_file_name_;
+
+        // Binning of the library, the bin contents are only used for the final library
+        ResponseLibrary library_;
+
+        // Accumulated charge and arrival times, guarded by the mutex
+        std::mutex accumulator_mutex_;
+        std::vector<double> deposited_;
+        std::vector<double> collected_;
+        std::vector<double> arrived_;
+        std::vector<double> time_sum_;
+        std::vector<double> time_sum2_;
+
+        // Statistics
+        std::atomic<size_t> outside_grid_{};
+        std::atomic<size_t> outside_neighbourhood_{};
+    };
+} // namespace allpix
@@ -24,6 +24,7 @@
 #include "tools/ROOT.h"
 
 #include "objects/PixelCharge.hpp"
+#include "objects/PixelChargeAccumulator.hpp"
 
 using namespace allpix;
 
@@ -85,7 +86,7 @@ void SimpleTransferModule::run(Event* event) {
     // Find corresponding pixels for all propagated charges
     LOG(TRACE) << "Transferring charges to pixels";
     unsigned int transferred_charges_count = 0;
-    std::map<Pixel::Index, std::vector<const PropagatedCharge*>> pixel_map;
+    PixelChargeAccumulator pixel_map(propagated_message->getData().size());
     for(const auto& propagated_charge : propagated_message->getData()) {
         auto position = propagated_charge.getLocalPosition();
         // Ignore if outside depth range of implant
@@ -131,22 +132,22 @@ void SimpleTransferModule::run(Event* event) {
                    << pixel_index;
 
         // Add the pixel the list of hit pixels
-        pixel_map[pixel_index].emplace_back(&propagated_charge);
+        auto charge = static_cast<double>(propagated_charge.getSign() * propagated_charge.getCharge());
+        pixel_map.add(pixel_index, charge, &propagated_charge);
     }
 
     // Create pixel charges
     LOG(TRACE) << "Combining charges at same pixel";
+    pixel_map.sort();
     std::vector<PixelCharge> pixel_charges;
-    for(auto& pixel_index_charge : pixel_map) {
-        long charge = 0;
-        for(auto& propagated_charge : pixel_index_charge.second) {
-            charge += propagated_charge->getSign() * propagated_charge->getCharge();
-        }
+    pixel_charges.reserve(pixel_map.size());
+    for(size_t i = 0; i < pixel_map.size(); ++i) {
+        auto charge = static_cast<long>(pixel_map.getCharge(i));
 
         // Get pixel object from detector
-        auto pixel = detector_->getPixel(pixel_index_charge.first.x(), pixel_index_charge.first.y());
+        auto pixel = detector_->getPixel(pixel_map.getIndex(i).x(), pixel_map.getIndex(i).y());
 
-        pixel_charges.emplace_back(pixel, charge, pixel_index_charge.second);
+        pixel_charges.emplace_back(pixel, charge, pixel_map.getPropagatedCharges(i));
         LOG(DEBUG) << "Set of " << charge << " charges combined at " << pixel.getIndex();
     }
 
@@ -155,7 +156,7 @@ void SimpleTransferModule::run(Event* event) {
     total_transferred_charges_ += transferred_charges_count;
 
     // Dispatch message of pixel charges
-    auto pixel_message = std::make_shared<PixelChargeMessage>(pixel_charges, detector_);
+    auto pixel_message = event->makeShared<PixelChargeMessage>(pixel_charges, detector_);
     messenger_->dispatchMessage(this, pixel_message, event);
 }
 
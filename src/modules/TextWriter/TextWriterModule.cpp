@@ -9,6 +9,9 @@
 
 #include "TextWriterModule.hpp"
 
+#include <array>
+#include <charconv>
+#include <cstdio>
 #include <fstream>
 #include <string>
 #include <utility>
@@ -32,14 +35,36 @@ TextWriterModule::TextWriterModule(Configuration& config, Messenger* messenger,
 
     // Bind to all messages with filter
     messenger_->registerFilter(this, &TextWriterModule::filter);
+
+    config_.setDefault("format", OutputFormat::VERBOSE);
+    config_.setDefault("compression", Compression::NONE);
+    config_.setDefault("buffer_size", 1048576);
 }
 
 void TextWriterModule::initialize() {
+    format_ = config_.get<OutputFormat>("format");
+    buffer_size_ = config_.get<size_t>("buffer_size");
+    buffer_.reserve(buffer_size_ + 4096);
+
     // Create output file
-    output_file_name_ = createOutputFile(config_.get<std::string>("file_name", "data"), "txt", true);
-    output_file_ = std::make_unique<std::ofstream>(output_file_name_);
+    auto compression = config_.get<Compression>("compression");
+    if(compression == Compression::GZIP) {
+#ifdef ALLPIX_TEXTWRITER_ZLIB
+        output_file_name_ = createOutputFile(config_.get<std::string>("file_name", "data"), "txt.gz", true);
+        compressed_file_ = gzopen(output_file_name_.c_str(), "wb");
+        if(compressed_file_ == nullptr) {
+            throw ModuleError("Cannot create compressed output file " + output_file_name_);
+        }
+        gzbuffer(compressed_file_, 1 << 17);
+#else
+        throw InvalidValueError(config_, "compression", "module has been built without support for gzip compression");
+#endif
+    } else {
+        output_file_name_ = createOutputFile(config_.get<std::string>("file_name", "data"), "txt", true);
+        output_file_ = std::make_unique<std::ofstream>(output_file_name_, std::ios::binary);
+    }
 
-    *output_file_ << "# Allpix Squared ASCII data - https://cern.ch/allpix-squared" << std::endl << std::endl;
+    append("# Allpix Squared ASCII data - https://cern.ch/allpix-squared\n\n");
 
     // Read include and exclude list
     if(config_.has("include") && config_.has("exclude")) {
@@ -69,7 +94,7 @@ bool TextWriterModule::filter(const std::shared_ptr<BaseMessage>& message, const
         }
 
         // Read the object
-        auto object_array = message->getObjectArray();
+        auto object_array = message->getObjects();
         if(!object_array.empty()) {
             const Object& first_object = object_array[0];
             std::string class_name = allpix::demangle(typeid(first_object).name());
@@ -99,29 +124,157 @@ void TextWriterModule::run(Event* event) {
     LOG(TRACE) << "Writing new objects to text file";
 
     // Print the current event:
-    *output_file_ << "=== " << event->number << " ===" << std::endl;
+    append("=== ");
+    append(static_cast<long long>(event->number));
+    append(" ===\n");
 
     for(auto& pair : messages) {
         auto& message = pair.first;
 
         // Print the current detector:
         if(message->getDetector() != nullptr) {
-            *output_file_ << "--- " << message->getDetector()->getName() << " ---" << std::endl;
+            append("--- ");
+            append(message->getDetector()->getName());
+            append(" ---\n");
         } else {
-            *output_file_ << "--- <global> ---" << std::endl;
+            append("--- <global> ---\n");
         }
-        for(auto& object : message->getObjectArray()) {
+        for(auto& object : message->getObjects()) {
             // Print the object's ASCII representation:
-            *output_file_ << object << std::endl;
+            if(format_ == OutputFormat::COMPACT) {
+                append_compact(object);
+            } else {
+                object_stream_.str(std::string());
+                object_stream_ << object << '\n';
+                append(object_stream_.str());
+            }
             write_cnt_++;
         }
         msg_cnt_++;
     }
+
+    if(buffer_.size() >= buffer_size_) {
+        write_buffer();
+    }
+}
+
+/**
+ * The compact format writes the name of the object followed by its main quantities separated by spaces, positions are
+ * given in local coordinates. Objects without compact representation are written in the verbose format.
+ */
+void TextWriterModule::append_compact(const Object& object) {
+    auto append_point = [this](const ROOT::Math::XYZPoint& point) {
+        append(point.x());
+        append(" ");
+        append(point.y());
+        append(" ");
+        append(point.z());
+    };
+
+    if(const auto* hit = dynamic_cast<const PixelHit*>(&object)) {
+        append("PixelHit ");
+        append(static_cast<long long>(hit->getIndex().x()));
+        append(" ");
+        append(static_cast<long long>(hit->getIndex().y()));
+        append(" ");
+        append(hit->getSignal());
+        append(" ");
+        append(hit->getLocalTime());
+        append(" ");
+        append(hit->getGlobalTime());
+    } else if(const auto* pixel_charge = dynamic_cast<const PixelCharge*>(&object)) {
+        append("PixelCharge ");
+        append(static_cast<long long>(pixel_charge->getIndex().x()));
+        append(" ");
+        append(static_cast<long long>(pixel_charge->getIndex().y()));
+        append(" ");
+        append(static_cast<long long>(pixel_charge->getCharge()));
+        append(" ");
+        append(pixel_charge->getLocalTime());
+        append(" ");
+        append(pixel_charge->getGlobalTime());
+    } else if(const auto* charge = dynamic_cast<const SensorCharge*>(&object)) {
+        append(dynamic_cast<const DepositedCharge*>(&object) != nullptr ? "DepositedCharge " : "PropagatedCharge ");
+        append(static_cast<long long>(charge->getType()));
+        append(" ");
+        append(static_cast<long long>(charge->getCharge()));
+        append(" ");
+        append_point(charge->getLocalPosition());
+        append(" ");
+        append(charge->getLocalTime());
+        append(" ");
+        append(charge->getGlobalTime());
+    } else if(const auto* particle = dynamic_cast<const MCParticle*>(&object)) {
+        append("MCParticle ");
+        append(static_cast<long long>(particle->getParticleID()));
+        append(" ");
+        append_point(particle->getLocalStartPoint());
+        append(" ");
+        append_point(particle->getLocalEndPoint());
+        append(" ");
+        append(particle->getLocalTime());
+        append(" ");
+        append(particle->getGlobalTime());
+    } else {
+        object_stream_.str(std::string());
+        object_stream_ << object;
+        append(object_stream_.str());
+    }
+    append("\n");
+}
+
+void TextWriterModule::append(long long value) {
+    std::array<char, 24> number{};
+    auto* end = std::to_chars(number.data(), number.data() + number.size(), value).ptr;
+    buffer_.append(number.data(), static_cast<size_t>(end - number.data()));
+}
+
+/**
+ * Floating point numbers are written with the same precision as the default formatting of streams. They are formatted with
+ * std::snprintf since floating point support of std::to_chars is not available on all supported platforms.
+ */
+void TextWriterModule::append(double value) {
+    std::array<char, 32> number{};
+    auto length = std::snprintf(number.data(), number.size(), "%g", value);
+    buffer_.append(number.data(), static_cast<size_t>(length));
+}
+
+void TextWriterModule::write_buffer() {
+#ifdef ALLPIX_TEXTWRITER_ZLIB
+    if(compressed_file_ != nullptr) {
+        if(!buffer_.empty() &&
+           gzwrite(compressed_file_, buffer_.data(), static_cast<unsigned int>(buffer_.size())) <= 0) {
+            throw ModuleError("Writing to compressed output file failed");
+        }
+        buffer_.clear();
+        return;
+    }
+#endif
+    output_file_->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    if(!output_file_->good()) {
+        throw ModuleError("Writing to output file failed");
+    }
+    buffer_.clear();
 }
 
 void TextWriterModule::finalize() {
     // Finish writing to output file
-    *output_file_ << "# " << write_cnt_ << " objects from " << msg_cnt_ << " messages" << std::endl;
+    append("# ");
+    append(static_cast<long long>(write_cnt_));
+    append(" objects from ");
+    append(static_cast<long long>(msg_cnt_));
+    append(" messages\n");
+    write_buffer();
+#ifdef ALLPIX_TEXTWRITER_ZLIB
+    if(compressed_file_ != nullptr && gzclose(compressed_file_) != Z_OK) {
+        compressed_file_ = nullptr;
+        throw ModuleError("Closing compressed output file failed");
+    }
+    compressed_file_ = nullptr;
+#endif
+    if(output_file_ != nullptr) {
+        output_file_->close();
+    }
 
     // Print statistics
     LOG(STATUS) << "Wrote " << write_cnt_ << " objects from " << msg_cnt_ << " messages to file:" << std::endl
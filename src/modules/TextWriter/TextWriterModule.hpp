@@ -10,7 +10,9 @@
 #include <atomic>
 #include <fstream>
 #include <map>
+#include <sstream>
 #include <string>
+#include <string_view>
 
 #include "core/config/Configuration.hpp"
 #include "core/geometry/GeometryManager.hpp"
@@ -18,14 +20,37 @@
 #include "core/module/Event.hpp"
 #include "core/module/Module.hpp"
 
+#include "objects/Object.hpp"
+
+#ifdef ALLPIX_TEXTWRITER_ZLIB
+#include <zlib.h>
+#endif
+
 namespace allpix {
     /**
      * @ingroup Modules
      * @brief Module to write object data to simple ASCII text files
      *
      * Listens to all objects dispatched in the framework and stores an ASCII representation of every object to file.
+     * The text is collected in a large buffer which is written to the file, optionally compressed, once it is full.
      */
     class TextWriterModule : public SequentialModule {
+        /**
+         * @brief Format of the objects written to file
+         */
+        enum class OutputFormat {
+            VERBOSE, ///< Full description of every object as printed by the objects themselves
+            COMPACT, ///< Single line per object with only the main quantities of the most common objects
+        };
+
+        /**
+         * @brief Compression of the output file
+         */
+        enum class Compression {
+            NONE, ///< Plain text file
+            GZIP, ///< File compressed with gzip
+        };
+
     public:
         /**
          * @brief Constructor for this unique module
@@ -59,6 +84,26 @@ namespace allpix {
         void finalize() override;
 
     private:
+        /**
+         * @brief Append an object to the output buffer in the compact format
+         * @param object Object to format
+         */
+        void append_compact(const Object& object);
+
+        /// @{
+        /**
+         * @brief Append text or numbers to the output buffer
+         */
+        void append(std::string_view text) { buffer_.append(text); }
+        void append(long long value);
+        void append(double value);
+        /// @}
+
+        /**
+         * @brief Write the output buffer to the file
+         */
+        void write_buffer();
+
         Messenger* messenger_;
 
         // Object names to include or exclude from writing
@@ -68,6 +113,15 @@ namespace allpix {
         // Output data file to write
         std::string output_file_name_{};
         std::unique_ptr<std::ofstream> output_file_;
+#ifdef ALLPIX_TEXTWRITER_ZLIB
+        gzFile compressed_file_{};
+#endif
+
+        // Buffer of the text to write and stream to format objects without compact format
+        OutputFormat format_{};
+        std::string buffer_;
+        size_t buffer_size_{};
+        std::ostringstream object_stream_;
 
         // Statistical information about number of objects
         std::atomic<unsigned long> write_cnt_{};
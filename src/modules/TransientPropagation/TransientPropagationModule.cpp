@@ -9,18 +9,26 @@
 
 #include "TransientPropagationModule.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <Eigen/Core>
 
+#include "core/module/ThreadPool.hpp"
 #include "core/utils/distributions.h"
 #include "core/utils/log.h"
 #include "objects/PixelCharge.hpp"
 #include "objects/PropagatedCharge.hpp"
+#include "tools/charge_groups.h"
 #include "tools/runge_kutta.h"
+#include "tools/units.h"
 
 using namespace allpix;
 using namespace ROOT::Math;
@@ -42,12 +50,22 @@ TransientPropagationModule::TransientPropagationModule(Configuration& config,
 
     // Set default value for config variables
     config_.setDefault<double>("timestep", Units::get(0.01, "ns"));
+    config_.setDefault<bool>("adaptive_timestep", false);
+    config_.setDefault<double>("timestep_max", Units::get(0.5, "ns"));
+    config_.setDefault<double>("spatial_precision", Units::get(0.25, "nm"));
     config_.setDefault<double>("integration_time", Units::get(25, "ns"));
     config_.setDefault<unsigned int>("charge_per_step", 10);
+    config_.setDefault<unsigned int>("max_charge_groups", 0);
+    config_.setDefault<double>("merge_distance", 0);
+    config_.setDefault<bool>("parallel_propagation", false);
 
     // Models:
     config_.setDefault<std::string>("mobility_model", "jacoboni");
+    config_.setDefault<bool>("mobility_table", false);
+    config_.setDefault<double>("mobility_table_precision", 1e-4);
+    config_.setDefault<bool>("velocity_grid", false);
     config_.setDefault<std::string>("recombination_model", "none");
+    config_.setDefault<bool>("sample_survival_time", false);
 
     config_.setDefault<double>("temperature", 293.15);
     config_.setDefault<bool>("output_plots", false);
@@ -57,14 +75,31 @@ TransientPropagationModule::TransientPropagationModule(Configuration& config,
     // Copy some variables from configuration to avoid lookups:
     temperature_ = config_.get<double>("temperature");
     timestep_ = config_.get<double>("timestep");
+    adaptive_timestep_ = config_.get<bool>("adaptive_timestep");
     integration_time_ = config_.get<double>("integration_time");
+    sample_survival_time_ = config_.get<bool>("sample_survival_time");
     matrix_ = config_.get<XYVectorInt>("induction_matrix");
     charge_per_step_ = config_.get<unsigned int>("charge_per_step");
+    if(charge_per_step_ == 0) {
+        throw InvalidValueError(config_, "charge_per_step", "at least one charge carrier has to be propagated per step");
+    }
+    max_charge_groups_ = config_.get<unsigned int>("max_charge_groups");
+    merge_distance_ = config_.get<double>("merge_distance");
+    parallel_propagation_ = config_.get<bool>("parallel_propagation");
 
     if(matrix_.x() % 2 == 0 || matrix_.y() % 2 == 0) {
         throw InvalidValueError(config_, "induction_matrix", "Odd number of pixels in x and y required.");
     }
 
+    // The time step is the width of the pulse bins and the minimum step when adapting the step size
+    if(adaptive_timestep_) {
+        timestep_max_ = config_.get<double>("timestep_max");
+        target_spatial_precision_ = config_.get<double>("spatial_precision");
+        if(timestep_max_ < timestep_) {
+            throw InvalidValueError(config_, "timestep_max", "maximum time step has to be larger than the time step");
+        }
+    }
+
     output_plots_ = config_.get<bool>("output_plots");
     boltzmann_kT_ = Units::get(8.6173e-5, "eV/K") * temperature_;
 
@@ -98,6 +133,16 @@ void TransientPropagationModule::initialize() {
         throw InvalidValueError(config_, "mobility_model", e.what());
     }
 
+    // Replace the mobility model by a lookup table if requested
+    if(config_.get<bool>("mobility_table")) {
+        auto precision = config_.get<double>("mobility_table_precision");
+        if(precision <= 0) {
+            throw InvalidValueError(config_, "mobility_table_precision", "precision of the table has to be positive");
+        }
+        auto error = mobility_.tabulate(precision);
+        LOG(INFO) << "Using tabulated mobility model with a maximum relative interpolation error of " << error;
+    }
+
     // Prepare recombination model
     try {
         recombination_ = Recombination(config_.get<std::string>("recombination_model"), detector->hasDopingProfile());
@@ -113,10 +158,30 @@ void TransientPropagationModule::initialize() {
             LOG(WARNING) << "A magnetic field is switched on, but is set to be ignored for this module.";
         } else {
             LOG(DEBUG) << "This detector sees a magnetic field.";
-            magnetic_field_ = detector_->getMagneticField();
         }
     }
 
+    // Precompute the drift velocity of electrons and holes on the grid of the electric field
+    velocity_grid_ = config_.get<bool>("velocity_grid");
+    if(velocity_grid_ && detector->getElectricFieldType() != FieldType::GRID) {
+        LOG(WARNING) << "Electric field is not given by a grid, drift velocity is not precomputed";
+        velocity_grid_ = false;
+    } else if(velocity_grid_ && has_magnetic_field_) {
+        LOG(WARNING) << "Drift velocity depends on the magnetic field, drift velocity is not precomputed";
+        velocity_grid_ = false;
+    }
+    if(velocity_grid_) {
+        for(auto type : {CarrierType::ELECTRON, CarrierType::HOLE}) {
+            auto hole = (type == CarrierType::HOLE ? 1 : 0);
+            velocity_grids_[hole] = detector->deriveElectricFieldGrid(
+                [&, type](const ROOT::Math::XYZPoint& position, const ROOT::Math::XYZVector& efield) {
+                    auto mobility = mobility_(type, std::sqrt(efield.Mag2()), detector->getDopingConcentration(position));
+                    return static_cast<int>(type) * mobility * efield;
+                });
+        }
+        LOG(INFO) << "Using drift velocity precomputed on the grid of the electric field";
+    }
+
     if(output_plots_) {
         potential_difference_ = CreateHistogram<TH1D>(
             "potential_difference",
@@ -171,8 +236,13 @@ void TransientPropagationModule::run(Event* event) {
     unsigned int propagated_charges_count = 0;
     unsigned int recombined_charges_count = 0;
 
-    // Loop over all deposits for propagation
+    // Accumulator for the induced pulses, reserving the time bins of the full integration time
+    auto pulse_bins = static_cast<size_t>(std::lround(integration_time_ / timestep_)) + 2;
+    PulseAccumulator pulses(timestep_, pulse_bins);
+
+    // Select the deposits to propagate
     LOG(TRACE) << "Propagating charges in sensor";
+    std::vector<const DepositedCharge*> deposits;
     for(const auto& deposit : deposits_message->getData()) {
 
         // Only process if within requested integration time:
@@ -183,50 +253,98 @@ void TransientPropagationModule::run(Event* event) {
             continue;
         }
 
-        // Loop over all charges in the deposit
-        unsigned int charges_remaining = deposit.getCharge();
-
         LOG(DEBUG) << "Set of charge carriers (" << deposit.getType() << ") on "
                    << Units::display(deposit.getLocalPosition(), {"mm", "um"});
+        deposits.push_back(&deposit);
+    }
 
-        auto charge_per_step = charge_per_step_;
-        while(charges_remaining > 0) {
-            // Define number of charges to be propagated and remove charges of this step from the total
-            if(charge_per_step > charges_remaining) {
-                charge_per_step = charges_remaining;
-            }
-            charges_remaining -= charge_per_step;
-            std::map<Pixel::Index, Pulse> px_map;
-
-            // Get position and propagate through sensor
-            auto [local_position, time, alive] = propagate(
-                event, deposit.getLocalPosition(), deposit.getType(), charge_per_step, deposit.getLocalTime(), px_map);
-
-            // Create a new propagated charge and add it to the list
-            auto global_position = detector_->getGlobalPosition(local_position);
-            PropagatedCharge propagated_charge(local_position,
-                                               global_position,
-                                               deposit.getType(),
-                                               std::move(px_map),
-                                               deposit.getLocalTime() + time,
-                                               deposit.getGlobalTime() + time,
-                                               &deposit);
-
-            LOG(DEBUG) << " Propagated " << charge_per_step << " to " << Units::display(local_position, {"mm", "um"})
-                       << " in " << Units::display(time, "ns") << " time, induced "
-                       << Units::display(propagated_charge.getCharge(), {"e"});
-
-            propagated_charges.push_back(std::move(propagated_charge));
-
-            if(alive) {
-                propagated_charges_count += charge_per_step;
-            } else {
-                recombined_charges_count += charge_per_step;
-            }
+    // Split all deposits into groups of charges to be propagated together
+    size_t unmerged_groups = 0;
+    auto charge_groups =
+        create_charge_groups(deposits, charge_per_step_, max_charge_groups_, merge_distance_, unmerged_groups);
+    if(charge_groups.size() < unmerged_groups) {
+        LOG(DEBUG) << "Propagating " << charge_groups.size() << " groups of charges instead of " << unmerged_groups;
+    }
+    total_charge_groups_ += charge_groups.size();
+    total_unmerged_charge_groups_ += unmerged_groups;
+    increment_counter("saved_charge_groups", unmerged_groups - charge_groups.size());
+
+    // Propagate all groups, storing the final state and the induced pulses of every group
+    std::vector<std::tuple<ROOT::Math::XYZPoint, double, bool>> results(charge_groups.size());
+    std::vector<std::map<Pixel::Index, Pulse>> group_pulses(charge_groups.size());
+    auto propagate_group = [&](size_t idx, RandomNumberGenerator& random_generator, PulseAccumulator& accumulator) {
+        const auto& [deposit_ptr, charge_per_step] = charge_groups[idx];
+        accumulator.clear();
+        results[idx] = propagate(random_generator,
+                                 deposit_ptr->getLocalPosition(),
+                                 deposit_ptr->getType(),
+                                 charge_per_step,
+                                 deposit_ptr->getLocalTime(),
+                                 accumulator);
+        group_pulses[idx] = accumulator.getPulses();
+    };
 
-            if(output_plots_) {
-                drift_time_histo_->Fill(static_cast<double>(Units::convert(time, "ns")), charge_per_step);
-            }
+    if(parallel_propagation_) {
+        // Derive a seed for every group from the event, such that results do not depend on the distribution over workers
+        std::vector<uint64_t> seeds(charge_groups.size());
+        for(auto& seed : seeds) {
+            seed = event->getRandomNumber();
+        }
+        auto engine = event->getRandomEngine().getEngine();
+
+        // Split the groups in blocks to be propagated by idle workers of the thread pool, each with its own accumulator
+        auto num_tasks = std::min<size_t>(charge_groups.size(), 4 * ThreadPool::threadCount());
+        std::vector<std::function<void()>> tasks;
+        for(size_t task = 0; task < num_tasks; ++task) {
+            auto begin = charge_groups.size() * task / num_tasks;
+            auto end = charge_groups.size() * (task + 1) / num_tasks;
+            tasks.emplace_back([&, begin, end]() {
+                RandomNumberGenerator random_generator(engine);
+                PulseAccumulator accumulator(timestep_, pulse_bins);
+                for(size_t idx = begin; idx < end; ++idx) {
+                    random_generator.seed(seeds[idx]);
+                    propagate_group(idx, random_generator, accumulator);
+                }
+            });
+        }
+        ThreadPool::runSubtasks(tasks);
+    } else {
+        for(size_t idx = 0; idx < charge_groups.size(); ++idx) {
+            propagate_group(idx, event->getRandomEngine(), pulses);
+        }
+    }
+
+    // Collect the propagated charges in the original order
+    for(size_t idx = 0; idx < charge_groups.size(); ++idx) {
+        const auto& deposit = *charge_groups[idx].first;
+        auto charge_per_step = charge_groups[idx].second;
+        const auto& [local_position, time, alive] = results[idx];
+
+        // Create a new propagated charge and add it to the list, weighted by the number of configured groups it represents
+        auto global_position = detector_->getGlobalPosition(local_position);
+        PropagatedCharge propagated_charge(local_position,
+                                           global_position,
+                                           deposit.getType(),
+                                           std::move(group_pulses[idx]),
+                                           deposit.getLocalTime() + time,
+                                           deposit.getGlobalTime() + time,
+                                           &deposit,
+                                           std::max(1., static_cast<double>(charge_per_step) / charge_per_step_));
+
+        LOG(DEBUG) << " Propagated " << charge_per_step << " to " << Units::display(local_position, {"mm", "um"})
+                   << " in " << Units::display(time, "ns") << " time, induced "
+                   << Units::display(propagated_charge.getCharge(), {"e"});
+
+        propagated_charges.push_back(std::move(propagated_charge));
+
+        if(alive) {
+            propagated_charges_count += charge_per_step;
+        } else {
+            recombined_charges_count += charge_per_step;
+        }
+
+        if(output_plots_) {
+            drift_time_histo_->Fill(time / units::ns, charge_per_step);
         }
     }
 
@@ -236,7 +354,7 @@ void TransientPropagationModule::run(Event* event) {
     }
 
     // Create a new message with propagated charges
-    auto propagated_charge_message = std::make_shared<PropagatedChargeMessage>(std::move(propagated_charges), detector_);
+    auto propagated_charge_message = event->makeShared<PropagatedChargeMessage>(std::move(propagated_charges), detector_);
 
     // Dispatch the message with propagated charges
     messenger_->dispatchMessage(this, propagated_charge_message, event);
@@ -248,51 +366,63 @@ void TransientPropagationModule::run(Event* event) {
  * multiple steps, adding a random diffusion to the propagating charge every step.
  */
 std::tuple<ROOT::Math::XYZPoint, double, bool>
-TransientPropagationModule::propagate(Event* event,
+TransientPropagationModule::propagate(RandomNumberGenerator& random_generator,
                                       const ROOT::Math::XYZPoint& pos,
                                       const CarrierType& type,
                                       const unsigned int charge,
                                       const double initial_time,
-                                      std::map<Pixel::Index, Pulse>& pixel_map) {
+                                      PulseAccumulator& pulses) {
     Eigen::Vector3d position(pos.x(), pos.y(), pos.z());
 
+    // Remember the field cells of the previous lookups, as the consecutive positions of the carrier are close to each other
+    FieldCursor efield_cursor;
+    FieldCursor doping_cursor;
+
     // Define a function to compute the diffusion
     auto carrier_diffusion = [&](double efield_mag, double doping, double timestep) -> Eigen::Vector3d {
         double diffusion_constant = boltzmann_kT_ * mobility_(type, efield_mag, doping);
         double diffusion_std_dev = std::sqrt(2. * diffusion_constant * timestep);
 
         // Compute the independent diffusion in three
-        allpix::normal_distribution<double> gauss_distribution(0, diffusion_std_dev);
         Eigen::Vector3d diffusion;
-        for(int i = 0; i < 3; ++i) {
-            diffusion[i] = gauss_distribution(event->getRandomEngine());
-        }
+        allpix::fill_normal<double>(random_generator, diffusion.data(), 3, 0, diffusion_std_dev);
         return diffusion;
     };
 
-    // Survival probability of this charge carrier package, evaluated at every step
+    // Survival of this charge carrier package, evaluated at every step or consuming a survival time drawn once
     std::uniform_real_distribution<double> survival(0, 1);
+    auto survival_time = (sample_survival_time_ ? allpix::exponential_distribution<double>(1)(random_generator) : 0.);
+    auto recombined = [&](double doping, double timestep) {
+        return (sample_survival_time_ ? recombination_.consume(type, doping, survival_time, timestep)
+                                      : recombination_(type, doping, survival(random_generator), timestep));
+    };
 
     // Define lambda functions to compute the charge carrier velocity with or without magnetic field
-    std::function<Eigen::Vector3d(double, const Eigen::Vector3d&)> carrier_velocity_noB =
-        [&](double, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
-        auto raw_field = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+    FieldCursor velocity_cursor;
+    const auto& velocity_grid = velocity_grids_[type == CarrierType::HOLE ? 1 : 0];
+    auto carrier_velocity_noB = [&](double, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
+        if(velocity_grid_) {
+            auto velocity = velocity_grid.get(static_cast<ROOT::Math::XYZPoint>(cur_pos), velocity_cursor);
+            return {velocity.x(), velocity.y(), velocity.z()};
+        }
+
+        auto raw_field = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(cur_pos), efield_cursor);
         Eigen::Vector3d efield(raw_field.x(), raw_field.y(), raw_field.z());
 
-        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(cur_pos), doping_cursor);
 
         return static_cast<int>(type) * mobility_(type, efield.norm(), doping) * efield;
     };
 
-    std::function<Eigen::Vector3d(double, const Eigen::Vector3d&)> carrier_velocity_withB =
-        [&](double, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
-        auto raw_field = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+    auto carrier_velocity_withB = [&](double, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
+        auto raw_field = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(cur_pos), efield_cursor);
         Eigen::Vector3d efield(raw_field.x(), raw_field.y(), raw_field.z());
 
         Eigen::Vector3d velocity;
-        Eigen::Vector3d bfield(magnetic_field_.x(), magnetic_field_.y(), magnetic_field_.z());
+        auto raw_bfield = detector_->getMagneticField(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        Eigen::Vector3d bfield(raw_bfield.x(), raw_bfield.y(), raw_bfield.z());
 
-        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(cur_pos));
+        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(cur_pos), doping_cursor);
 
         auto mob = mobility_(type, efield.norm(), doping);
         auto exb = efield.cross(bfield);
@@ -308,8 +438,16 @@ TransientPropagationModule::propagate(Event* event,
     };
 
     // Create the runge kutta solver with an RKF5 tableau
-    auto runge_kutta = make_runge_kutta(
-        tableau::RK5, (has_magnetic_field_ ? carrier_velocity_withB : carrier_velocity_noB), timestep_, position);
+    auto carrier_velocity = [&](double time, const Eigen::Vector3d& cur_pos) -> Eigen::Vector3d {
+        return (has_magnetic_field_ ? carrier_velocity_withB(time, cur_pos) : carrier_velocity_noB(time, cur_pos));
+    };
+    auto runge_kutta = make_runge_kutta(static_tableau::RK5(), carrier_velocity, timestep_, position);
+
+    // Weighting potentials of the induction matrix at the end of the last step, stored column by column from its lower
+    // corner. They are the potentials at the start of the current step, only pixels entering the matrix are evaluated again.
+    std::array<int, 4> last_matrix{0, -1, 0, -1};
+    std::vector<double> last_potentials, matrix_potentials, potentials, missing_potentials;
+    std::vector<Pixel::Index> pixels, missing_pixels;
 
     // Continue propagation until the deposit is outside the sensor
     Eigen::Vector3d last_position = position;
@@ -318,31 +456,31 @@ TransientPropagationModule::propagate(Event* event,
     while(within_sensor && (initial_time + runge_kutta.getTime()) < integration_time_ && is_alive) {
         // Save previous position and time
         last_position = position;
+        auto last_time = runge_kutta.getTime();
 
         // Execute a Runge Kutta step
         auto step = runge_kutta.step();
+        auto step_time = runge_kutta.getTime() - last_time;
 
         // Get the current result
         position = runge_kutta.getValue();
 
         // Get electric field at current position and fall back to empty field if it does not exist
-        auto efield = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(position));
-        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(position));
+        auto efield = detector_->getElectricField(static_cast<ROOT::Math::XYZPoint>(position), efield_cursor);
+        auto doping = detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(position), doping_cursor);
 
         // Apply diffusion step
-        auto diffusion = carrier_diffusion(std::sqrt(efield.Mag2()), doping, timestep_);
+        auto diffusion = carrier_diffusion(std::sqrt(efield.Mag2()), doping, step_time);
         position += diffusion;
         runge_kutta.setValue(position);
 
         // Check if charge carrier is still alive:
-        is_alive = !recombination_(type,
-                                   detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(position)),
-                                   survival(event->getRandomEngine()),
-                                   timestep_);
+        is_alive = !recombined(
+            detector_->getDopingConcentration(static_cast<ROOT::Math::XYZPoint>(position), doping_cursor), step_time);
 
         // Update step length histogram
         if(output_plots_) {
-            step_length_histo_->Fill(static_cast<double>(Units::convert(step.value.norm(), "um")));
+            step_length_histo_->Fill(step.value.norm() / units::um);
         }
 
         // Check for overshooting outside the sensor and correct for it:
@@ -398,7 +536,8 @@ TransientPropagationModule::propagate(Event* event,
         int y_lower = std::min(ypixel, last_ypixel) - matrix_.y() / 2;
         int y_higher = std::max(ypixel, last_ypixel) + matrix_.y() / 2;
 
-        // Loop over NxN pixels:
+        // Collect the NxN pixels within the pixel grid
+        pixels.clear();
         for(int x = x_lower; x <= x_higher; x++) {
             for(int y = y_lower; y <= y_higher; y++) {
                 // Ignore if out of pixel grid
@@ -406,32 +545,87 @@ TransientPropagationModule::propagate(Event* event,
                     LOG(TRACE) << "Pixel (" << x << "," << y << ") skipped, outside the grid";
                     continue;
                 }
+                pixels.emplace_back(static_cast<unsigned int>(x), static_cast<unsigned int>(y));
+            }
+        }
 
-                Pixel::Index pixel_index(static_cast<unsigned int>(x), static_cast<unsigned int>(y));
-                auto ramo = detector_->getWeightingPotential(static_cast<ROOT::Math::XYZPoint>(position), pixel_index);
-                auto last_ramo =
-                    detector_->getWeightingPotential(static_cast<ROOT::Math::XYZPoint>(last_position), pixel_index);
-
-                // Induced charge on electrode is q_int = q * (phi(x1) - phi(x0))
-                auto induced = charge * (ramo - last_ramo) * static_cast<std::underlying_type<CarrierType>::type>(type);
-                LOG(TRACE) << "Pixel " << pixel_index << " dPhi = " << (ramo - last_ramo) << ", induced " << type
-                           << " q = " << Units::display(induced, "e");
-
-                // Create pulse if it doesn't exist. Store induced charge in the returned pulse iterator
-                auto pixel_map_iterator = pixel_map.emplace(pixel_index, Pulse(timestep_));
-                pixel_map_iterator.first->second.addCharge(induced, initial_time + runge_kutta.getTime());
-
-                if(output_plots_) {
-                    potential_difference_->Fill(std::fabs(ramo - last_ramo));
-                    induced_charge_histo_->Fill(initial_time + runge_kutta.getTime(), induced);
-                    if(type == CarrierType::ELECTRON) {
-                        induced_charge_e_histo_->Fill(initial_time + runge_kutta.getTime(), induced);
-                    } else {
-                        induced_charge_h_histo_->Fill(initial_time + runge_kutta.getTime(), induced);
-                    }
+        // Evaluate the weighting potential of all pixels at the current position, take the potential at the last position
+        // from the previous step and only evaluate it for pixels which were not part of the previous matrix
+        potentials.resize(pixels.size());
+        detector_->getWeightingPotential(
+            static_cast<ROOT::Math::XYZPoint>(position), pixels.data(), potentials.data(), pixels.size());
+        auto in_last_matrix = [&](const Pixel::Index& pixel_index) {
+            auto x = static_cast<int>(pixel_index.x());
+            auto y = static_cast<int>(pixel_index.y());
+            return x >= last_matrix[0] && x <= last_matrix[1] && y >= last_matrix[2] && y <= last_matrix[3];
+        };
+        missing_pixels.clear();
+        for(const auto& pixel_index : pixels) {
+            if(!in_last_matrix(pixel_index)) {
+                missing_pixels.push_back(pixel_index);
+            }
+        }
+        missing_potentials.resize(missing_pixels.size());
+        detector_->getWeightingPotential(static_cast<ROOT::Math::XYZPoint>(last_position),
+                                         missing_pixels.data(),
+                                         missing_potentials.data(),
+                                         missing_pixels.size());
+
+        auto matrix_size_y = y_higher - y_lower + 1;
+        auto last_matrix_size_y = last_matrix[3] - last_matrix[2] + 1;
+        matrix_potentials.assign(static_cast<size_t>((x_higher - x_lower + 1) * matrix_size_y), 0.);
+        size_t missing_index = 0;
+
+        // Loop over NxN pixels:
+        for(size_t pixel = 0; pixel < pixels.size(); ++pixel) {
+            const auto& pixel_index = pixels[pixel];
+            auto x = static_cast<int>(pixel_index.x());
+            auto y = static_cast<int>(pixel_index.y());
+
+            auto ramo = potentials[pixel];
+            auto last_ramo =
+                in_last_matrix(pixel_index)
+                    ? last_potentials[static_cast<size_t>((x - last_matrix[0]) * last_matrix_size_y + (y - last_matrix[2]))]
+                    : missing_potentials[missing_index++];
+            matrix_potentials[static_cast<size_t>((x - x_lower) * matrix_size_y + (y - y_lower))] = ramo;
+
+            // Induced charge on electrode is q_int = q * (phi(x1) - phi(x0))
+            auto induced = charge * (ramo - last_ramo) * static_cast<std::underlying_type<CarrierType>::type>(type);
+            LOG(TRACE) << "Pixel " << pixel_index << " dPhi = " << (ramo - last_ramo) << ", induced " << type
+                       << " q = " << Units::display(induced, "e");
+
+            // Store induced charge in the pulse of the pixel, distributed over all pulse bins covered by adaptive steps
+            if(adaptive_timestep_) {
+                pulses.addCharge(pixel_index, induced, initial_time + last_time, initial_time + runge_kutta.getTime());
+            } else {
+                pulses.addCharge(pixel_index, induced, initial_time + runge_kutta.getTime());
+            }
+
+            if(output_plots_) {
+                potential_difference_->Fill(std::fabs(ramo - last_ramo));
+                induced_charge_histo_->Fill(initial_time + runge_kutta.getTime(), induced);
+                if(type == CarrierType::ELECTRON) {
+                    induced_charge_e_histo_->Fill(initial_time + runge_kutta.getTime(), induced);
+                } else {
+                    induced_charge_h_histo_->Fill(initial_time + runge_kutta.getTime(), induced);
                 }
             }
         }
+        last_matrix = {x_lower, x_higher, y_lower, y_higher};
+        std::swap(last_potentials, matrix_potentials);
+
+        // Adapt step size to match target precision, lower it when reaching the sensor edge
+        if(adaptive_timestep_) {
+            auto timestep = runge_kutta.getTimeStep();
+            double uncertainty = step.error.norm();
+            if(std::fabs(model_->getSensorSize().z() / 2.0 - position.z()) < 2 * step.value.z() ||
+               uncertainty > target_spatial_precision_) {
+                timestep *= 0.75;
+            } else if(2 * uncertainty < target_spatial_precision_) {
+                timestep *= 1.5;
+            }
+            runge_kutta.setTimeStep(std::clamp(timestep, timestep_, timestep_max_));
+        }
     }
 
     // Return the final position of the propagated charge
@@ -448,4 +642,9 @@ void TransientPropagationModule::finalize() {
         induced_charge_e_histo_->Write();
         induced_charge_h_histo_->Write();
     }
+
+    if(total_charge_groups_ < total_unmerged_charge_groups_) {
+        LOG(INFO) << "Propagated " << total_charge_groups_ << " groups of charges instead of "
+                  << total_unmerged_charge_groups_ << " by merging deposits and enlarging groups";
+    }
 }
@@ -7,6 +7,8 @@
  * Intergovernmental Organization or submit itself to any jurisdiction.
  */
 
+#include <array>
+#include <atomic>
 #include <string>
 
 #include <Math/DisplacementVector2D.h>
@@ -14,6 +16,7 @@
 #include <TH1D.h>
 
 #include "core/config/Configuration.hpp"
+#include "core/geometry/DetectorField.hpp"
 #include "core/geometry/DetectorModel.hpp"
 #include "core/messenger/Messenger.hpp"
 #include "core/module/Event.hpp"
@@ -21,6 +24,7 @@
 
 #include "objects/DepositedCharge.hpp"
 #include "objects/Pulse.hpp"
+#include "objects/PulseAccumulator.hpp"
 
 #include "physics/Mobility.hpp"
 #include "physics/Recombination.hpp"
@@ -72,33 +76,42 @@ namespace allpix {
 
         /**
          * @brief Propagate a single set of charges through the sensor
-         * @param event        Pointer to current event
+         * @param random_generator Reference to the random number engine to be used
          * @param pos          Position of the deposit in the sensor
          * @param type         Type of the carrier to propagate
          * @param charge       Total charge of the observed charge carrier set
          * @param initial_time Initial timestamp referring to the start of the event
-         * @param pixel_map    Map of surrounding pixels and their induced pulses. Provided as reference to store simulation
-         *                  result in
+         * @param pulses       Accumulator of the pulses induced on the surrounding pixels. Provided as reference to store
+         *                  simulation result in
          * @return          Tuple of the point where the deposit ended after propagation, the time the propagation took and a
          * flag whether it is still alive or has recombined
          */
-        std::tuple<ROOT::Math::XYZPoint, double, bool> propagate(Event* event,
+        std::tuple<ROOT::Math::XYZPoint, double, bool> propagate(RandomNumberGenerator& random_generator,
                                                                  const ROOT::Math::XYZPoint& pos,
                                                                  const CarrierType& type,
                                                                  const unsigned int charge,
                                                                  const double initial_time,
-                                                                 std::map<Pixel::Index, Pulse>& pixel_map);
+                                                                 PulseAccumulator& pulses);
 
         // Local copies of configuration parameters to avoid costly lookup:
         double temperature_{}, timestep_{}, integration_time_{};
+        bool adaptive_timestep_{};
+        bool sample_survival_time_{};
+        double timestep_max_{}, target_spatial_precision_{};
         bool output_plots_{};
         ROOT::Math::DisplacementVector2D<ROOT::Math::Cartesian2D<int>> matrix_;
-        unsigned int charge_per_step_{};
+        unsigned int charge_per_step_{}, max_charge_groups_{};
+        double merge_distance_{};
+        bool parallel_propagation_{};
 
         // Models for electron and hole mobility and lifetime
         Mobility mobility_;
         Recombination recombination_;
 
+        // Drift velocity of electrons and holes precomputed on the grid of the electric field
+        bool velocity_grid_{};
+        std::array<DetectorField<ROOT::Math::XYZVector>, 2> velocity_grids_;
+
         // Precalculated value for Boltzmann constant:
         double boltzmann_kT_;
 
@@ -108,7 +121,10 @@ namespace allpix {
 
         // Magnetic field
         bool has_magnetic_field_{};
-        ROOT::Math::XYZVector magnetic_field_;
+
+        // Statistical information
+        std::atomic<size_t> total_charge_groups_{};
+        std::atomic<size_t> total_unmerged_charge_groups_{};
 
         // Output plots
         Histogram<TH1D> potential_difference_, induced_charge_histo_, induced_charge_e_histo_, induced_charge_h_histo_;
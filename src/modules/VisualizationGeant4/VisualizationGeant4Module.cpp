@@ -14,6 +14,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <set>
 #include <string>
 #include <thread>
 #include <utility>
@@ -52,6 +53,12 @@ VisualizationGeant4Module::VisualizationGeant4Module(Configuration& config, Mess
     config_.setDefault("simple_view", true);
 
     mode_ = config_.get<ViewingMode>("mode");
+
+    // Bind the parameters used to display every event
+    accumulate_ = config_.bind<bool>("accumulate");
+    if(!accumulate_) {
+        accumulate_time_step_ = config_.bind<unsigned long>("accumulate_time_step", Units::get(100ul, "ms"));
+    }
 }
 /**
  * Without applying this workaround the visualization (sometimes without content) is also shown when an exception occurred in
@@ -150,6 +157,32 @@ void VisualizationGeant4Module::initialize() {
     // Set default visualization settings
     set_visualization_settings();
 
+    // Snapshots are exported to image files, which is only supported by the OpenGL and TSG drivers
+    snapshot_interval_ = config_.get<uint64_t>("snapshot_interval", 0);
+    if(snapshot_interval_ > 0) {
+        auto driver = config_.get<std::string>("driver");
+        if(driver.rfind("OGL", 0) == 0) {
+            snapshot_command_ = "/vis/ogl/export ";
+        } else if(driver.rfind("TSG", 0) == 0) {
+            snapshot_command_ = "/vis/tsg/export ";
+        } else {
+            throw InvalidValueError(config_, "snapshot_interval", "snapshots require an OpenGL (OGL) or TSG driver");
+        }
+    }
+
+    // Limit the number of displayed events of every snapshot or of the full run
+    max_events_ = config_.get<uint64_t>("accumulate_max_events", 0);
+    if(max_events_ > 0) {
+        if(!accumulate_) {
+            throw InvalidValueError(
+                config_, "accumulate_max_events", "limiting the displayed events requires accumulate to be enabled");
+        }
+        auto& global_config = getConfigManager()->getGlobalConfiguration();
+        window_size_ = (snapshot_interval_ > 0 ? snapshot_interval_ : global_config.get<uint64_t>("number_of_events", 1));
+        random_generator_.seed(global_config.get<uint64_t>("random_seed"));
+        select_next_event();
+    }
+
     // Reset the default displayListLimit
     auto display_limit = config_.get<std::string>("display_limit", "1000000");
     UI->ApplyCommand("/vis/ogl/set/displayListLimit " + display_limit);
@@ -380,12 +413,63 @@ void VisualizationGeant4Module::set_visualization_attributes() {
     }
 }
 
-void VisualizationGeant4Module::run(Event*) {
-    if(!config_.get<bool>("accumulate")) {
+void VisualizationGeant4Module::run(Event* event) {
+    if(!accumulate_) {
         vis_manager_g4_->GetCurrentViewer()->ShowView();
-        std::this_thread::sleep_for(
-            std::chrono::nanoseconds(config_.get<unsigned long>("accumulate_time_step", Units::get(100ul, "ms"))));
+        std::this_thread::sleep_for(std::chrono::nanoseconds(*accumulate_time_step_));
+    }
+
+    last_event_ = event->number;
+    window_events_++;
+    if(snapshot_interval_ > 0 && window_events_ == snapshot_interval_) {
+        write_snapshot(event->number);
+    }
+    if(max_events_ > 0) {
+        select_next_event();
+    }
+}
+
+void VisualizationGeant4Module::write_snapshot(uint64_t event_number) {
+    auto file_name = createOutputFile(config_.get<std::string>("snapshot_file_name", "snapshot") + "_" +
+                                          std::to_string(event_number),
+                                      config_.get<std::string>("snapshot_format", "png"),
+                                      false,
+                                      true);
+
+    // The drawing is disabled if the next event has not been selected for display
+    G4UImanager* UI = G4UImanager::GetUIpointer();
+    UI->ApplyCommand("/vis/enable");
+    UI->ApplyCommand("/vis/viewer/flush");
+    if(UI->ApplyCommand(snapshot_command_ + file_name) != 0) {
+        throw ModuleError("Cannot export snapshot of the visualization to " + file_name);
     }
+    LOG(INFO) << "Wrote snapshot of the events up to event " << event_number << " to " << file_name;
+
+    // Discard the trajectories of the snapshot, the following events are accumulated from an empty scene
+    UI->ApplyCommand("/vis/viewer/clearTransients");
+    window_events_ = 0;
+    window_selected_ = 0;
+}
+
+/**
+ * The trajectories of an event cannot be removed from the Geant4 scene once drawn, thus events cannot be replaced later as
+ * done by reservoir sampling. Instead, every event is selected before it is simulated with the probability to still need
+ * the remaining number of events from the remaining events of the window. This selection sampling yields a uniform sample
+ * of exactly the maximum number of events as long as the window, a snapshot or the full run, is complete.
+ */
+void VisualizationGeant4Module::select_next_event() {
+    auto remaining = (window_size_ > window_events_ ? window_size_ - window_events_ : 0);
+    auto selected = false;
+    if(window_selected_ < max_events_ && remaining > 0) {
+        std::uniform_int_distribution<uint64_t> distribution(0, remaining - 1);
+        selected = distribution(random_generator_) < max_events_ - window_selected_;
+    }
+
+    // Events not selected are simulated without drawing or storing their trajectories in the scene
+    if(selected) {
+        window_selected_++;
+    }
+    G4UImanager::GetUIpointer()->ApplyCommand(selected ? "/vis/enable" : "/vis/disable");
 }
 
 static bool has_gui = false;
@@ -409,14 +493,16 @@ static void interrupt_handler(int signal) {
 void VisualizationGeant4Module::add_visualization_volumes() {
     // Only place the pixel matrix for the visualization if we have no simple view
     if(!config_.get<bool>("simple_view")) {
-        // Loop through detectors
+        // Loop through detectors, placing the pixels only once in sensor volumes shared by several detectors
+        std::set<G4LogicalVolume*> sensor_volumes;
         for(auto& detector : geo_manager_->getDetectors()) {
             auto sensor_log = geo_manager_->getExternalObject<G4LogicalVolume>(detector->getName(), "sensor_log");
             auto pixel_log = geo_manager_->getExternalObject<G4LogicalVolume>(detector->getName(), "pixel_log");
             auto pixel_param = geo_manager_->getExternalObject<G4VPVParameterisation>(detector->getName(), "pixel_param");
 
-            // Continue if a required external object is missing
-            if(sensor_log == nullptr || pixel_log == nullptr || pixel_param == nullptr) {
+            // Continue if a required external object is missing or the pixels have already been placed
+            if(sensor_log == nullptr || pixel_log == nullptr || pixel_param == nullptr ||
+               !sensor_volumes.insert(sensor_log.get()).second) {
                 continue;
             }
 
@@ -438,8 +524,14 @@ void VisualizationGeant4Module::finalize() {
     // Add volumes that are only used in the visualization
     add_visualization_volumes();
 
+    // Write the snapshot of the events since the last one
+    if(snapshot_interval_ > 0 && window_events_ > 0) {
+        write_snapshot(last_event_);
+    }
+
     // Enable automatic refresh before showing view
     G4UImanager* UI = G4UImanager::GetUIpointer();
+    UI->ApplyCommand("/vis/enable");
     UI->ApplyCommand("/vis/viewer/set/autoRefresh true");
 
     // Set new signal handler to fetch CTRL+C and close the Qt application
@@ -11,6 +11,7 @@
 #define ALLPIX_TEST_VISUALIZATION_MODULE_H
 
 #include <memory>
+#include <random>
 #include <string>
 
 #include "core/config/Configuration.hpp"
@@ -68,7 +69,7 @@ namespace allpix {
         void initialize() override;
 
         /**
-         * @brief Show visualization updates if not accumulating data
+         * @brief Show visualization updates if not accumulating data, write snapshots and select the next event to display
          */
         void run(Event*) override;
 
@@ -92,12 +93,37 @@ namespace allpix {
          * @brief Add visualization volumes, added at the end to prevent cluttering the geometry during deposition
          */
         void add_visualization_volumes();
+        /**
+         * @brief Export the current view to an image file and discard the trajectories displayed so far
+         * @param event_number Number of the last event contained in the snapshot
+         */
+        void write_snapshot(uint64_t event_number);
+        /**
+         * @brief Randomly decide if the next event is displayed to keep the number of displayed events below the maximum
+         */
+        void select_next_event();
 
         // Check if we did run successfully, used to apply workaround in destructor if needed
         bool has_run_;
 
         ViewingMode mode_;
 
+        // Display settings for every event bound to the configuration
+        ConfigParameter<bool> accumulate_;
+        ConfigParameter<unsigned long> accumulate_time_step_;
+
+        // Snapshots of the accumulated events written to image files
+        uint64_t snapshot_interval_{};
+        std::string snapshot_command_;
+        uint64_t last_event_{};
+
+        // Uniform sample of at most the maximum number of events displayed in every window of events
+        uint64_t max_events_{};
+        uint64_t window_size_{};
+        uint64_t window_events_{};
+        uint64_t window_selected_{};
+        std::mt19937_64 random_generator_;
+
         // Own the Geant4 visualization manager
         std::unique_ptr<G4VisManager> vis_manager_g4_;
 
@@ -9,6 +9,7 @@
 
 #include "WeightingPotentialReaderModule.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <limits>
@@ -17,6 +18,7 @@
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <TH2F.h>
 
@@ -33,6 +35,11 @@ WeightingPotentialReaderModule::WeightingPotentialReaderModule(Configuration& co
     : Module(config, detector), detector_(std::move(detector)) {
     // Enable multithreading of this module if multithreading is enabled
     allow_multithreading();
+
+    // Reading the potential can run concurrently with other modules unless plots are written
+    if(!config_.get<bool>("output_plots", false)) {
+        allow_parallel_initialization();
+    }
 }
 
 void WeightingPotentialReaderModule::initialize() {
@@ -46,22 +53,42 @@ void WeightingPotentialReaderModule::initialize() {
 
     // Calculate the potential depending on the configuration
     if(field_model == WeightingPotential::MESH) {
+        // Get the method to look up the potential from the grid, defaults to the value of the nearest bin:
+        auto interpolation = config_.get<FieldInterpolation>("field_interpolation", FieldInterpolation::NEAREST);
+        if(interpolation == FieldInterpolation::LINEAR) {
+            LOG(DEBUG) << "Weighting potential will be interpolated trilinearly between the grid bins";
+        }
+
+        // Get the precision the potential grid is stored with, defaults to double precision:
+        auto precision = config_.get<FieldPrecision>("field_precision", FieldPrecision::DOUBLE);
+        if(precision == FieldPrecision::SINGLE) {
+            LOG(DEBUG) << "Weighting potential will be stored in single precision";
+        }
+
         auto field_data = read_field(thickness_domain);
 
         // Set the field grid, provide scale factors as fraction of the pixel pitch for correct scaling:
-        detector_->setWeightingPotentialGrid(field_data.getData(),
+        detector_->setWeightingPotentialGrid(field_data.getRawData(),
+                                             field_data.getEntries(),
                                              field_data.getDimensions(),
                                              std::array<double, 2>{{field_data.getSize()[0] / model->getPixelSize().x(),
                                                                     field_data.getSize()[1] / model->getPixelSize().y()}},
                                              std::array<double, 2>{{0, 0}},
-                                             thickness_domain);
+                                             thickness_domain,
+                                             interpolation,
+                                             precision,
+                                             field_data.getZEdges());
     } else if(field_model == WeightingPotential::PAD) {
         LOG(TRACE) << "Adding weighting potential from pad in plane condenser";
 
         // Get pixel implant size from the detector model:
         auto implant = model->getImplantSize();
         auto function = get_pad_potential_function(implant, thickness_domain);
-        detector_->setWeightingPotentialFunction(function, thickness_domain, FieldType::CUSTOM);
+        if(config_.get<bool>("tabulate_potential", false)) {
+            tabulate_pad_potential(function, thickness_domain);
+        } else {
+            detector_->setWeightingPotentialFunction(function, thickness_domain, FieldType::CUSTOM);
+        }
     }
 
     // Produce histograms if needed
@@ -111,6 +138,89 @@ WeightingPotentialReaderModule::get_pad_potential_function(const ROOT::Math::XYV
     };
 }
 
+/**
+ * The potential is evaluated at the bin centers of a grid centered on the pixel. Since the pad potential is symmetric in x
+ * and y, only one quadrant of the grid is calculated and mirrored. The deviation from the analytic potential is estimated at
+ * the corners of a subset of the grid cells, where the distance to the neighboring bin centers is largest.
+ */
+void WeightingPotentialReaderModule::tabulate_pad_potential(const FieldFunction<double>& function,
+                                                            std::pair<double, double> thickness_domain) {
+    auto model = detector_->getModel();
+    auto extent = config_.get<ROOT::Math::XYVector>("tabulation_extent", {5, 5});
+    auto bins = config_.getArray<size_t>("tabulation_bins", {100, 100, 100});
+    if(extent.x() <= 0 || extent.y() <= 0) {
+        throw InvalidValueError(config_, "tabulation_extent", "extent of the tabulated potential should be positive");
+    }
+    if(bins.size() != 3 || std::find(bins.begin(), bins.end(), 0) != bins.end()) {
+        throw InvalidValueError(config_, "tabulation_bins", "three positive numbers of bins in x, y and z are required");
+    }
+    std::array<size_t, 3> dimensions = {{bins[0], bins[1], bins[2]}};
+    std::array<double, 3> size = {{extent.x() * model->getPixelSize().x(),
+                                   extent.y() * model->getPixelSize().y(),
+                                   thickness_domain.second - thickness_domain.first}};
+    std::array<double, 3> origin = {{-size[0] / 2.0, -size[1] / 2.0, thickness_domain.first}};
+
+    LOG(INFO) << "Tabulating weighting potential of the pad on " << dimensions[0] << "x" << dimensions[1] << "x"
+              << dimensions[2] << " cells";
+    auto field = std::make_shared<std::vector<double>>(dimensions[0] * dimensions[1] * dimensions[2]);
+    auto center = [&](size_t axis, double bin) {
+        return origin[axis] + (bin + 0.5) * size[axis] / static_cast<double>(dimensions[axis]);
+    };
+    auto index = [&](size_t x, size_t y, size_t z) { return (x * dimensions[1] + y) * dimensions[2] + z; };
+    for(size_t x = 0; x < (dimensions[0] + 1) / 2; ++x) {
+        LOG_PROGRESS(INFO, "tabulation") << "Tabulating weighting potential: " << 200 * x / dimensions[0] << "%";
+        for(size_t y = 0; y < (dimensions[1] + 1) / 2; ++y) {
+            auto mirror_x = dimensions[0] - 1 - x;
+            auto mirror_y = dimensions[1] - 1 - y;
+            for(size_t z = 0; z < dimensions[2]; ++z) {
+                auto potential = function(ROOT::Math::XYZPoint(center(0, static_cast<double>(x)),
+                                                               center(1, static_cast<double>(y)),
+                                                               center(2, static_cast<double>(z))));
+                (*field)[index(x, y, z)] = potential;
+                (*field)[index(mirror_x, y, z)] = potential;
+                (*field)[index(x, mirror_y, z)] = potential;
+                (*field)[index(mirror_x, mirror_y, z)] = potential;
+            }
+        }
+    }
+    LOG_PROGRESS(INFO, "tabulation") << "Tabulating weighting potential: done";
+
+    auto interpolation = config_.get<FieldInterpolation>("field_interpolation", FieldInterpolation::NEAREST);
+    auto precision = config_.get<FieldPrecision>("field_precision", FieldPrecision::DOUBLE);
+    auto entries = field->size();
+    detector_->setWeightingPotentialGrid(std::shared_ptr<const double>(field, field->data()),
+                                         entries,
+                                         dimensions,
+                                         std::array<double, 2>{{extent.x(), extent.y()}},
+                                         std::array<double, 2>{{0, 0}},
+                                         thickness_domain,
+                                         interpolation,
+                                         precision);
+
+    // Compare the tabulated with the analytic potential in the region of the pixel and its direct neighbors
+    double max_deviation = 0;
+    std::array<size_t, 3> strides{};
+    for(size_t axis = 0; axis < 3; ++axis) {
+        strides[axis] = std::max<size_t>(1, dimensions[axis] / 20);
+    }
+    for(size_t x = 0; x < dimensions[0]; x += strides[0]) {
+        for(size_t y = 0; y < dimensions[1]; y += strides[1]) {
+            for(size_t z = 0; z < dimensions[2]; z += strides[2]) {
+                ROOT::Math::XYZPoint pos(center(0, static_cast<double>(x) + 0.5),
+                                         center(1, static_cast<double>(y) + 0.5),
+                                         std::min(center(2, static_cast<double>(z) + 0.5), thickness_domain.second));
+                if(std::fabs(pos.x()) > 1.5 * model->getPixelSize().x() ||
+                   std::fabs(pos.y()) > 1.5 * model->getPixelSize().y()) {
+                    continue;
+                }
+                auto tabulated = detector_->getWeightingPotential(pos, Pixel::Index(0, 0));
+                max_deviation = std::max(max_deviation, std::fabs(tabulated - function(pos)));
+            }
+        }
+    }
+    LOG(INFO) << "Maximum deviation of the tabulated from the analytic weighting potential: " << max_deviation;
+}
+
 void WeightingPotentialReaderModule::create_output_plots() {
     LOG(TRACE) << "Creating output plots";
 
@@ -200,10 +310,12 @@ FieldData<double> WeightingPotentialReaderModule::read_field(std::pair<double, d
         LOG(TRACE) << "Fetching weighting potential from init file";
 
         // Get field from file
-        auto field_data = field_parser_.getByFileName(config_.getPath("file_name", true));
+        auto field_data = field_parser_.getByFileName(
+            config_.getPath("file_name", true), std::string(), config_.get<bool>("shared_memory", false));
 
         // Check maximum/minimum values of the potential:
-        auto elements = std::minmax_element(field_data.getData()->begin(), field_data.getData()->end());
+        const auto* data = field_data.getRawData().get();
+        auto elements = std::minmax_element(data, data + field_data.getEntries());
         if(*elements.first < 0 || *elements.second > 1) {
             throw InvalidValueError(config_,
                                     "file_name",
@@ -233,6 +345,9 @@ FieldData<double> WeightingPotentialReaderModule::read_field(std::pair<double, d
 
         LOG(INFO) << "Set weighting field with " << field_data.getDimensions()[0] << "x" << field_data.getDimensions()[1]
                   << "x" << field_data.getDimensions()[2] << " cells";
+        if(!field_data.getZEdges().empty()) {
+            LOG(DEBUG) << "Weighting potential uses non-uniform binning in z";
+        }
 
         // Return the field data
         return field_data;
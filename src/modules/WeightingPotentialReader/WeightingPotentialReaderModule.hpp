@@ -58,6 +58,13 @@ namespace allpix {
         FieldFunction<double> get_pad_potential_function(const ROOT::Math::XYVector& implant,
                                                          std::pair<double, double> thickness_domain);
 
+        /**
+         * @brief Tabulate the weighting potential of the pad on a grid and apply it
+         * @param function Analytic weighting potential of the pad
+         * @param thickness_domain Domain of the thickness where the field is defined
+         */
+        void tabulate_pad_potential(const FieldFunction<double>& function, std::pair<double, double> thickness_domain);
+
         /**
          * @brief Read pre-calculated field from file and apply it
          * @param thickness_domain Domain of the thickness where the field is defined
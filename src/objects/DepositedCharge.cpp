@@ -51,4 +51,5 @@ void DepositedCharge::loadHistory() {
 }
 void DepositedCharge::petrifyHistory() {
     mc_particle_.store();
+    petrify_positions();
 }
@@ -13,6 +13,10 @@
 #pragma link C++ class ROOT::Math::DisplacementVector2D < ROOT::Math::Cartesian2D < unsigned int>,                          \
     ROOT::Math::DefaultCoordinateSystemTag> +                                                                               \
     ;
+#pragma link C++ class ROOT::Math::Cartesian2D < float> + ;
+#pragma link C++ class ROOT::Math::DisplacementVector2D < ROOT::Math::Cartesian2D < float>,                                 \
+    ROOT::Math::DefaultCoordinateSystemTag> +                                                                               \
+    ;
 
 // AP2 objects
 #pragma link C++ class allpix::Object + ;
@@ -26,6 +30,53 @@
 #pragma link C++ class allpix::PixelHit + ;
 #pragma link C++ class allpix::Pulse + ;
 
+// Expand the compact representation of pulses, older versions stored all bins
+// clang-format off
+#pragma read sourceClass="allpix::Pulse" targetClass="allpix::Pulse" version="[3-]" \
+    source="unsigned int offset_; std::vector<float> samples_" target="pulse_" \
+    code="{ auto& s = onfile.samples_; pulse_.assign(onfile.offset_, 0.); pulse_.insert(pulse_.end(), s.begin(), s.end()); }"
+#pragma read sourceClass="allpix::Pulse" targetClass="allpix::Pulse" version="[-2]" \
+    source="std::vector<double> pulse_" target="pulse_" code="{ pulse_ = onfile.pulse_; }"
+
+// Convert the positions stored in single precision, older versions stored them in double precision
+#pragma read sourceClass="allpix::SensorCharge" targetClass="allpix::SensorCharge" version="[4-]" \
+    source="ROOT::Math::XYZPointF stored_local_position_; ROOT::Math::XYZPointF stored_global_position_" \
+    target="local_position_, global_position_" \
+    code="{ local_position_ = ROOT::Math::XYZPoint(onfile.stored_local_position_); \
+            global_position_ = ROOT::Math::XYZPoint(onfile.stored_global_position_); }"
+#pragma read sourceClass="allpix::SensorCharge" targetClass="allpix::SensorCharge" version="[-3]" \
+    source="ROOT::Math::XYZPoint local_position_; ROOT::Math::XYZPoint global_position_" \
+    target="local_position_, global_position_" \
+    code="{ local_position_ = onfile.local_position_; global_position_ = onfile.global_position_; }"
+
+#pragma read sourceClass="allpix::MCParticle" targetClass="allpix::MCParticle" version="[10-]" \
+    source="ROOT::Math::XYZPointF stored_local_start_point_; ROOT::Math::XYZPointF stored_global_start_point_; \
+            ROOT::Math::XYZPointF stored_local_end_point_; ROOT::Math::XYZPointF stored_global_end_point_" \
+    target="local_start_point_, global_start_point_, local_end_point_, global_end_point_" \
+    code="{ local_start_point_ = ROOT::Math::XYZPoint(onfile.stored_local_start_point_); \
+            global_start_point_ = ROOT::Math::XYZPoint(onfile.stored_global_start_point_); \
+            local_end_point_ = ROOT::Math::XYZPoint(onfile.stored_local_end_point_); \
+            global_end_point_ = ROOT::Math::XYZPoint(onfile.stored_global_end_point_); }"
+#pragma read sourceClass="allpix::MCParticle" targetClass="allpix::MCParticle" version="[-9]" \
+    source="ROOT::Math::XYZPoint local_start_point_; ROOT::Math::XYZPoint global_start_point_; \
+            ROOT::Math::XYZPoint local_end_point_; ROOT::Math::XYZPoint global_end_point_" \
+    target="local_start_point_, global_start_point_, local_end_point_, global_end_point_" \
+    code="{ local_start_point_ = onfile.local_start_point_; global_start_point_ = onfile.global_start_point_; \
+            local_end_point_ = onfile.local_end_point_; global_end_point_ = onfile.global_end_point_; }"
+
+#pragma read sourceClass="allpix::Pixel" targetClass="allpix::Pixel" version="[2-]" \
+    source="ROOT::Math::XYZPointF stored_local_center_; ROOT::Math::XYZPointF stored_global_center_; \
+            ROOT::Math::XYVectorF stored_size_" \
+    target="local_center_, global_center_, size_" \
+    code="{ local_center_ = ROOT::Math::XYZPoint(onfile.stored_local_center_); \
+            global_center_ = ROOT::Math::XYZPoint(onfile.stored_global_center_); \
+            size_ = ROOT::Math::XYVector(onfile.stored_size_); }"
+#pragma read sourceClass="allpix::Pixel" targetClass="allpix::Pixel" version="[-1]" \
+    source="ROOT::Math::XYZPoint local_center_; ROOT::Math::XYZPoint global_center_; ROOT::Math::XYVector size_" \
+    target="local_center_, global_center_, size_" \
+    code="{ local_center_ = onfile.local_center_; global_center_ = onfile.global_center_; size_ = onfile.size_; }"
+// clang-format on
+
 #pragma link C++ class allpix::Object::PointerWrapper < allpix::MCTrack> + ;
 #pragma link C++ class allpix::Object::PointerWrapper < allpix::MCParticle> + ;
 #pragma link C++ class allpix::Object::PointerWrapper < allpix::PropagatedCharge> + ;
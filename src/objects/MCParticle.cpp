@@ -156,4 +156,9 @@ void MCParticle::loadHistory() {
 void MCParticle::petrifyHistory() {
     parent_.store();
     track_.store();
+
+    stored_local_start_point_ = ROOT::Math::XYZPointF(local_start_point_);
+    stored_global_start_point_ = ROOT::Math::XYZPointF(global_start_point_);
+    stored_local_end_point_ = ROOT::Math::XYZPointF(local_end_point_);
+    stored_global_end_point_ = ROOT::Math::XYZPointF(global_end_point_);
 }
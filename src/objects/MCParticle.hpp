@@ -19,6 +19,9 @@
 namespace allpix {
     /**
      * @brief Monte-Carlo particle through the sensor
+     *
+     * On file, the entry and exit points are stored in single precision. The compact representation is created before
+     * writing and converted back when reading.
      */
     class MCParticle : public Object {
     public:
@@ -124,7 +127,7 @@ namespace allpix {
         /**
          * @brief ROOT class definition
          */
-        ClassDefOverride(MCParticle, 9); // NOLINT
+        ClassDefOverride(MCParticle, 10); // NOLINT
         /**
          * @brief Default constructor for ROOT I/O
          */
@@ -140,10 +143,16 @@ namespace allpix {
         void petrifyHistory() override;
 
     private:
-        ROOT::Math::XYZPoint local_start_point_{};
-        ROOT::Math::XYZPoint global_start_point_{};
-        ROOT::Math::XYZPoint local_end_point_{};
-        ROOT::Math::XYZPoint global_end_point_{};
+        ROOT::Math::XYZPoint local_start_point_{};  //!
+        ROOT::Math::XYZPoint global_start_point_{}; //!
+        ROOT::Math::XYZPoint local_end_point_{};    //!
+        ROOT::Math::XYZPoint global_end_point_{};   //!
+
+        // Compact representation for storage, the points in single precision
+        ROOT::Math::XYZPointF stored_local_start_point_{};
+        ROOT::Math::XYZPointF stored_global_start_point_{};
+        ROOT::Math::XYZPointF stored_local_end_point_{};
+        ROOT::Math::XYZPointF stored_global_end_point_{};
 
         int particle_id_{};
         double local_time_{};
@@ -76,6 +76,15 @@ namespace allpix {
             // Using bit 14 of the TObject bit field, unused by ROOT:
             this->SetBit(1ull << 14);
         }
+        /**
+         * @brief Remove the mark for storage, e.g. after the object has only been streamed temporarily
+         */
+        void unmarkForStorage() { this->ResetBit(1ull << 14); }
+        /**
+         * @brief Check if the object has been marked for storage
+         * @return True if the object is marked for storage, false otherwise
+         */
+        bool isMarkedForStorage() const { return this->TestBit(1ull << 14); }
 
     protected:
         /**
@@ -108,18 +117,24 @@ namespace allpix {
 
             /// @{
             /**
-             * @brief Use default copy behaviour
+             * @brief Explicit copy behaviour, copying the current value of the atomic pointer
              */
-            BaseWrapper(const BaseWrapper& rhs) = default;
-            BaseWrapper& operator=(const BaseWrapper& rhs) = default;
+            BaseWrapper(const BaseWrapper& rhs) : ptr_(rhs.ptr_.load(std::memory_order_relaxed)), ref_(rhs.ref_) {}
+            BaseWrapper& operator=(const BaseWrapper& rhs) {
+                ptr_.store(rhs.ptr_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                ref_ = rhs.ref_;
+                return *this;
+            }
             /// @}
 
             /// @{
             /**
-             * @brief Use default move behaviour
+             * @brief Explicit move behaviour, identical to copying since the pointer is not owned by the wrapper
              */
-            BaseWrapper(BaseWrapper&& rhs) = default;            // NOLINT
-            BaseWrapper& operator=(BaseWrapper&& rhs) = default; // NOLINT
+            BaseWrapper(BaseWrapper&& rhs) noexcept : BaseWrapper(static_cast<const BaseWrapper&>(rhs)) {} // NOLINT
+            BaseWrapper& operator=(BaseWrapper&& rhs) noexcept {                                          // NOLINT
+                return operator=(static_cast<const BaseWrapper&>(rhs));
+            }
             /// @}
 
             /**
@@ -157,7 +172,7 @@ namespace allpix {
              */
             bool markedForStorage() const { return get() == nullptr ? false : get()->TestBit(1ull << 14); }
 
-            mutable T* ptr_{}; //! transient value
+            mutable std::atomic<T*> ptr_{}; //! transient value
             TRef ref_{};
         };
 
@@ -172,61 +187,41 @@ namespace allpix {
              * @brief Constructor with object pointer to be wrapped
              * @param obj Pointer to object
              */
-            explicit PointerWrapper(const T* obj) : BaseWrapper<T>(obj), loaded_(true) {} // NOLINT
+            explicit PointerWrapper(const T* obj) : BaseWrapper<T>(obj) {} // NOLINT
 
             /**
              * @brief Required virtual destructor
              */
             ~PointerWrapper() override = default;
 
+            /// @{
             /**
-             * @brief Explicit copy constructor to avoid copying std::once_flag
-             */
-            PointerWrapper(const PointerWrapper& rhs) : BaseWrapper<T>(rhs), loaded_(rhs.loaded_.load()){};
-
-            /**
-             * @brief Explicit copy assignment operator to avoid copying std::once_flag
-             */
-            PointerWrapper& operator=(const PointerWrapper& rhs) {
-                BaseWrapper<T>::operator=(rhs);
-                loaded_ = rhs.loaded_.load();
-                return *this;
-            };
-
-            /**
-             * @brief Explicit move constructor to avoid copying std::once_flag
-             */
-            PointerWrapper(PointerWrapper&& rhs) noexcept : BaseWrapper<T>(std::move(rhs)), loaded_(rhs.loaded_.load()){};
-
-            /**
-             * @brief Explicit move assignment to avoid copying std::once_flag
+             * @brief Use copy and move behaviour of the base wrapper
              */
-            PointerWrapper& operator=(PointerWrapper&& rhs) noexcept {
-                BaseWrapper<T>::operator=(std::move(rhs));
-                loaded_ = rhs.loaded_.load();
-                return *this;
-            };
+            PointerWrapper(const PointerWrapper& rhs) = default;
+            PointerWrapper& operator=(const PointerWrapper& rhs) = default;
+            PointerWrapper(PointerWrapper&& rhs) noexcept = default;            // NOLINT
+            PointerWrapper& operator=(PointerWrapper&& rhs) noexcept = default; // NOLINT
+            /// @}
 
             /**
-             * @brief Implementation of base class lazy loading mechanism with thread-safe call_once
+             * @brief Implementation of base class lazy loading mechanism
              * @return Pointer to object
+             *
+             * The pointer is only resolved from the TRef if it is not set yet. Concurrent calls resolve the same object,
+             * such that a single atomic pointer is sufficient and copies of the wrapper do not require synchronisation.
              */
             T* get() const override {
-                // Lazy loading of pointer from TRef
-                if(!this->loaded_) {
-                    std::call_once(load_flag_, [&]() {
-                        this->ptr_ = static_cast<T*>(this->ref_.GetObject());
-                        this->loaded_ = true;
-                    });
+                auto* ptr = this->ptr_.load(std::memory_order_acquire);
+                if(ptr == nullptr) {
+                    // Lazy loading of pointer from TRef
+                    ptr = static_cast<T*>(this->ref_.GetObject());
+                    this->ptr_.store(ptr, std::memory_order_release);
                 }
-                return this->ptr_;
+                return ptr;
             };
 
             ClassDefOverride(PointerWrapper, 1); // NOLINT
-
-        private:
-            mutable std::once_flag load_flag_;       //! transient value
-            mutable std::atomic_bool loaded_{false}; //! transient value
         };
     };
 
@@ -39,3 +39,9 @@ ROOT::Math::XYZPoint Pixel::getGlobalCenter() const {
 ROOT::Math::XYVector Pixel::getSize() const {
     return size_;
 }
+
+void Pixel::petrify() {
+    stored_local_center_ = ROOT::Math::XYZPointF(local_center_);
+    stored_global_center_ = ROOT::Math::XYZPointF(global_center_);
+    stored_size_ = ROOT::Math::XYVectorF(size_);
+}
@@ -27,6 +27,9 @@ namespace allpix {
      * @ingroup Objects
      * @brief Pixel in the model with indices, location and size
      * @warning This object is special and is not meant to be written directly to a tree (not inheriting from \ref Object)
+     *
+     * On file, the positions and the size are stored in single precision. The compact representation is created by \ref
+     * petrify before writing and converted back when reading.
      */
     class Pixel {
     public:
@@ -62,6 +65,11 @@ namespace allpix {
          */
         ROOT::Math::XYVector getSize() const;
 
+        /**
+         * @brief Create the compact representation of the pixel stored to file
+         */
+        void petrify();
+
         /**
          * @brief ROOT class definition
          */
@@ -69,14 +77,19 @@ namespace allpix {
         /**
          * @brief Default constructor for ROOT I/O
          */
-        ClassDef(Pixel, 1); // NOLINT
+        ClassDef(Pixel, 2); // NOLINT
 
     private:
         Pixel::Index index_;
 
-        ROOT::Math::XYZPoint local_center_;
-        ROOT::Math::XYZPoint global_center_;
-        ROOT::Math::XYVector size_;
+        ROOT::Math::XYZPoint local_center_;  //!
+        ROOT::Math::XYZPoint global_center_; //!
+        ROOT::Math::XYVector size_;          //!
+
+        // Compact representation for storage, the positions and the size in single precision
+        ROOT::Math::XYZPointF stored_local_center_;
+        ROOT::Math::XYZPointF stored_global_center_;
+        ROOT::Math::XYVectorF stored_size_;
     };
 
 } // namespace allpix
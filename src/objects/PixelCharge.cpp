@@ -33,6 +33,7 @@ PixelCharge::PixelCharge(Pixel pixel, long charge, const std::vector<const Propa
         }
         mc_particles_.emplace_back(mc_particle);
     }
+    cache_mc_particles();
 
     // No pulse provided, set full charge in first bin:
     pulse_.addCharge(static_cast<double>(charge), 0);
@@ -64,6 +65,12 @@ const Pulse& PixelCharge::getPulse() const {
     return pulse_;
 }
 
+size_t PixelCharge::getSizeHint() const {
+    return pulse_.getSizeHint() + propagated_charges_.capacity() * sizeof(PointerWrapper<PropagatedCharge>) +
+           mc_particles_.capacity() * sizeof(PointerWrapper<MCParticle>) +
+           (mc_particles_cache_.capacity() + primary_mc_particles_cache_.capacity()) * sizeof(const MCParticle*);
+}
+
 double PixelCharge::getGlobalTime() const {
     return global_time_;
 }
@@ -94,18 +101,11 @@ std::vector<const PropagatedCharge*> PixelCharge::getPropagatedCharges() const {
  *
  * MCParticles can only be fetched if the full history of objects are in scope and stored
  */
-std::vector<const MCParticle*> PixelCharge::getMCParticles() const {
-
-    std::vector<const MCParticle*> mc_particles;
-    for(const auto& mc_particle : mc_particles_) {
-        if(mc_particle.get() == nullptr) {
-            throw MissingReferenceException(typeid(*this), typeid(MCParticle));
-        }
-        mc_particles.emplace_back(mc_particle.get());
+const std::vector<const MCParticle*>& PixelCharge::getMCParticles() const {
+    if(!mc_particles_cached_) {
+        throw MissingReferenceException(typeid(*this), typeid(MCParticle));
     }
-
-    // Return as a vector of mc particles
-    return mc_particles;
+    return mc_particles_cache_;
 }
 
 /**
@@ -113,23 +113,36 @@ std::vector<const MCParticle*> PixelCharge::getMCParticles() const {
  *
  * MCParticles can only be fetched if the full history of objects are in scope and stored
  */
-std::vector<const MCParticle*> PixelCharge::getPrimaryMCParticles() const {
-    std::vector<const MCParticle*> primary_particles;
+const std::vector<const MCParticle*>& PixelCharge::getPrimaryMCParticles() const {
+    if(!mc_particles_cached_) {
+        throw MissingReferenceException(typeid(*this), typeid(MCParticle));
+    }
+    return primary_mc_particles_cache_;
+}
+
+/**
+ * The references are resolved when the history is set, either on construction or when loading it, such that the lookups do
+ * not need to dereference them or allocate again. The cache is only valid if all particles are in scope.
+ */
+void PixelCharge::cache_mc_particles() {
+    mc_particles_cache_.clear();
+    primary_mc_particles_cache_.clear();
+    mc_particles_cached_ = false;
     for(const auto& mc_particle : mc_particles_) {
-        auto* particle = mc_particle.get();
+        const auto* particle = mc_particle.get();
         if(particle == nullptr) {
-            throw MissingReferenceException(typeid(*this), typeid(MCParticle));
+            mc_particles_cache_.clear();
+            primary_mc_particles_cache_.clear();
+            return;
         }
+        mc_particles_cache_.push_back(particle);
 
-        // Check for possible parents:
-        if(particle->getParent() != nullptr) {
-            continue;
+        // A particle is primary if it has no parent
+        if(particle->getParent() == nullptr) {
+            primary_mc_particles_cache_.push_back(particle);
         }
-        primary_particles.emplace_back(particle);
     }
-
-    // Return as a vector of mc particles
-    return primary_particles;
+    mc_particles_cached_ = true;
 }
 
 void PixelCharge::print(std::ostream& out) const {
@@ -151,8 +164,11 @@ void PixelCharge::print(std::ostream& out) const {
 void PixelCharge::loadHistory() {
     std::for_each(propagated_charges_.begin(), propagated_charges_.end(), [](auto& n) { n.get(); });
     std::for_each(mc_particles_.begin(), mc_particles_.end(), [](auto& n) { n.get(); });
+    cache_mc_particles();
 }
 void PixelCharge::petrifyHistory() {
     std::for_each(propagated_charges_.begin(), propagated_charges_.end(), [](auto& n) { n.store(); });
     std::for_each(mc_particles_.begin(), mc_particles_.end(), [](auto& n) { n.store(); });
+    pulse_.petrify();
+    pixel_.petrify();
 }
@@ -83,14 +83,14 @@ namespace allpix {
          * @brief Get the Monte-Carlo particles resulting in this pixel hit
          * @return List of all related Monte-Carlo particles
          */
-        std::vector<const MCParticle*> getMCParticles() const;
+        const std::vector<const MCParticle*>& getMCParticles() const;
 
         /**
          * @brief Get all primary Monte-Carlo particles contributing to this pixel charge. A particle is considered primary
          * if it has no parent particle set.
          * @return List of all related primary Monte-Carlo particles
          */
-        std::vector<const MCParticle*> getPrimaryMCParticles() const;
+        const std::vector<const MCParticle*>& getPrimaryMCParticles() const;
 
         /**
          *  @brief Get recoded charge pulse
@@ -98,6 +98,12 @@ namespace allpix {
          */
         const Pulse& getPulse() const;
 
+        /**
+         * @brief Get an estimate of the memory allocated by the pixel charge
+         * @return Size in bytes of the pulse and the references to the history
+         */
+        size_t getSizeHint() const;
+
         /**
          * @brief Get time after start of event in global reference frame
          * @return Time from start event
@@ -138,6 +144,16 @@ namespace allpix {
 
         std::vector<PointerWrapper<PropagatedCharge>> propagated_charges_;
         std::vector<PointerWrapper<MCParticle>> mc_particles_;
+
+        /**
+         * @brief Resolve the Monte-Carlo particles once and cache them together with the primary particles
+         */
+        void cache_mc_particles();
+
+        // Resolved Monte-Carlo particles, not stored but recomputed when loading the history
+        std::vector<const MCParticle*> mc_particles_cache_;         //!
+        std::vector<const MCParticle*> primary_mc_particles_cache_; //!
+        bool mc_particles_cached_{};                                //!
     };
 
     /**
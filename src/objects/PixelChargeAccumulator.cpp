@@ -0,0 +1,136 @@
+/**
+ * @file
+ * @brief Implementation of the accumulator summing the charges of many pixels together with their history
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "PixelChargeAccumulator.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+using namespace allpix;
+
+namespace {
+    constexpr uint64_t empty_key = std::numeric_limits<uint64_t>::max();
+
+    uint64_t pack(const Pixel::Index& pixel) { return (static_cast<uint64_t>(pixel.x()) << 32) | pixel.y(); }
+
+    // Fibonacci hashing spreads neighbouring pixels over the table
+    size_t hash(uint64_t key, size_t mask) { return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 20) & mask; }
+} // namespace
+
+PixelChargeAccumulator::PixelChargeAccumulator(size_t pixels) {
+    size_t table_size = 16;
+    while(table_size < 2 * pixels) {
+        table_size *= 2;
+    }
+    keys_.assign(table_size, empty_key);
+    positions_.resize(table_size);
+}
+
+void PixelChargeAccumulator::add(const Pixel::Index& pixel, double charge, const PropagatedCharge* propagated_charge) {
+    auto position = get_position(pixel);
+    charges_[position] += charge;
+    if(propagated_charge != nullptr && latest_[position] != propagated_charge) {
+        latest_[position] = propagated_charge;
+        entries_.emplace_back(static_cast<uint32_t>(position), propagated_charge);
+    }
+}
+
+/**
+ * The history is compacted by a counting sort over the pixel positions, which keeps the order the propagated charges have
+ * been added in for every pixel.
+ */
+void PixelChargeAccumulator::sort() {
+    // Order the pixels by their index
+    std::vector<uint32_t> order(pixels_.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](uint32_t lhs, uint32_t rhs) { return pixels_[lhs] < pixels_[rhs]; });
+
+    std::vector<uint32_t> rank(pixels_.size());
+    std::vector<Pixel::Index> pixels;
+    std::vector<double> charges;
+    pixels.reserve(pixels_.size());
+    charges.reserve(pixels_.size());
+    for(size_t i = 0; i < order.size(); ++i) {
+        rank[order[i]] = static_cast<uint32_t>(i);
+        pixels.push_back(pixels_[order[i]]);
+        charges.push_back(charges_[order[i]]);
+    }
+    pixels_ = std::move(pixels);
+    charges_ = std::move(charges);
+
+    // Compute the offsets of the history of every pixel and place the entries
+    offsets_.assign(pixels_.size() + 1, 0);
+    for(auto& entry : entries_) {
+        entry.first = rank[entry.first];
+        ++offsets_[entry.first + 1];
+    }
+    std::partial_sum(offsets_.begin(), offsets_.end(), offsets_.begin());
+
+    history_.resize(entries_.size());
+    std::vector<size_t> next(offsets_.begin(), offsets_.end() - 1);
+    for(const auto& entry : entries_) {
+        history_[next[entry.first]++] = entry.second;
+    }
+}
+
+std::vector<const PropagatedCharge*> PixelChargeAccumulator::getPropagatedCharges(size_t position) const {
+    return {history_.begin() + static_cast<std::ptrdiff_t>(offsets_[position]),
+            history_.begin() + static_cast<std::ptrdiff_t>(offsets_[position + 1])};
+}
+
+void PixelChargeAccumulator::clear() {
+    std::fill(keys_.begin(), keys_.end(), empty_key);
+    pixels_.clear();
+    charges_.clear();
+    latest_.clear();
+    entries_.clear();
+    history_.clear();
+    offsets_.clear();
+}
+
+size_t PixelChargeAccumulator::get_position(const Pixel::Index& pixel) {
+    auto key = pack(pixel);
+    auto mask = keys_.size() - 1;
+    auto slot = hash(key, mask);
+    while(keys_[slot] != empty_key) {
+        if(keys_[slot] == key) {
+            return positions_[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    // Add the pixel, keeping the table at most half full
+    auto position = pixels_.size();
+    keys_[slot] = key;
+    positions_[slot] = static_cast<uint32_t>(position);
+    pixels_.push_back(pixel);
+    charges_.push_back(0);
+    latest_.push_back(nullptr);
+    if(2 * pixels_.size() > keys_.size()) {
+        grow_table();
+    }
+    return position;
+}
+
+void PixelChargeAccumulator::grow_table() {
+    keys_.assign(2 * keys_.size(), empty_key);
+    positions_.resize(keys_.size());
+    auto mask = keys_.size() - 1;
+    for(size_t position = 0; position < pixels_.size(); ++position) {
+        auto key = pack(pixels_[position]);
+        auto slot = hash(key, mask);
+        while(keys_[slot] != empty_key) {
+            slot = (slot + 1) & mask;
+        }
+        keys_[slot] = key;
+        positions_[slot] = static_cast<uint32_t>(position);
+    }
+}
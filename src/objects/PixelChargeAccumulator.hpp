@@ -0,0 +1,124 @@
+/**
+ * @file
+ * @brief Definition of the accumulator summing the charges of many pixels together with their history
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_PIXEL_CHARGE_ACCUMULATOR_H
+#define ALLPIX_PIXEL_CHARGE_ACCUMULATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Pixel.hpp"
+
+namespace allpix {
+    class PropagatedCharge;
+
+    /**
+     * @ingroup Objects
+     * @brief Sparse accumulator of the charge and the propagated charges contributing to every pixel of an event
+     *
+     * Pixels are located by an open-addressing hash table on their packed index, and the contributions are appended to a
+     * single list. Adding charge therefore neither requires tree lookups nor an allocation per pixel. Calling \ref sort
+     * orders the pixels by their index and arranges the propagated charges of all pixels in one contiguous array, where the
+     * history of every pixel is a range given by offsets. Charges are summed in the order they have been added, such that the
+     * result is identical to summing them per pixel in a map. After clearing, the accumulator can be reused without releasing
+     * its memory.
+     *
+     * @warning This object is a helper for the modules and is not meant to be written to file
+     */
+    class PixelChargeAccumulator {
+    public:
+        /**
+         * @brief Construct a new accumulator
+         * @param pixels Number of pixels expected to receive charge
+         */
+        explicit PixelChargeAccumulator(size_t pixels = 0);
+
+        /**
+         * @brief Add charge to a pixel and record the propagated charge it originates from
+         * @param pixel Index of the pixel
+         * @param charge Charge to add
+         * @param propagated_charge Propagated charge to add to the history of the pixel, ignored if it is a null pointer or
+         *                          already the latest entry of the pixel
+         */
+        void add(const Pixel::Index& pixel, double charge, const PropagatedCharge* propagated_charge);
+
+        /**
+         * @brief Order the pixels by their index and compact the history of every pixel into a contiguous range
+         * @warning No charge should be added after sorting until the accumulator is cleared
+         */
+        void sort();
+
+        /**
+         * @brief Return the number of pixels which received a contribution
+         * @return Number of pixels
+         */
+        size_t size() const { return pixels_.size(); }
+
+        /**
+         * @brief Return if any pixel received a contribution
+         * @return True if no pixel has been added, false otherwise
+         */
+        bool empty() const { return pixels_.empty(); }
+
+        /**
+         * @brief Get the index of a pixel, ordered by the index after sorting
+         * @param position Position of the pixel in the accumulator
+         * @return Index of the pixel
+         */
+        const Pixel::Index& getIndex(size_t position) const { return pixels_[position]; }
+
+        /**
+         * @brief Get the charge accumulated for a pixel
+         * @param position Position of the pixel in the accumulator
+         * @return Total charge of the pixel
+         */
+        double getCharge(size_t position) const { return charges_[position]; }
+
+        /**
+         * @brief Get the history of a pixel
+         * @param position Position of the pixel in the accumulator
+         * @return Propagated charges contributing to the pixel in the order they were added
+         * @warning Only available after sorting
+         */
+        std::vector<const PropagatedCharge*> getPropagatedCharges(size_t position) const;
+
+        /**
+         * @brief Remove all pixels and their history, keeping the memory for further use
+         */
+        void clear();
+
+    private:
+        /**
+         * @brief Return the position of a pixel, adding it if necessary
+         */
+        size_t get_position(const Pixel::Index& pixel);
+
+        /**
+         * @brief Double the size of the hash table and insert all pixels again
+         */
+        void grow_table();
+
+        // Hash table of the packed pixel indices, empty entries hold the maximum key
+        std::vector<uint64_t> keys_;
+        std::vector<uint32_t> positions_;
+
+        std::vector<Pixel::Index> pixels_;
+        std::vector<double> charges_;
+        std::vector<const PropagatedCharge*> latest_;
+
+        // History appended as pairs of pixel position and propagated charge, compacted with offsets when sorting
+        std::vector<std::pair<uint32_t, const PropagatedCharge*>> entries_;
+        std::vector<const PropagatedCharge*> history_;
+        std::vector<size_t> offsets_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_PIXEL_CHARGE_ACCUMULATOR_H */
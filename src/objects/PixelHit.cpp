@@ -32,6 +32,7 @@ PixelHit::PixelHit(Pixel pixel, double local_time, double global_time, double si
             mc_particles_.emplace_back(mc_particle);
         }
     }
+    cache_mc_particles();
 }
 
 const Pixel& PixelHit::getPixel() const {
@@ -60,18 +61,11 @@ const PixelCharge* PixelHit::getPixelCharge() const {
  *
  * MCParticles can only be fetched if the full history of objects are in scope and stored
  */
-std::vector<const MCParticle*> PixelHit::getMCParticles() const {
-
-    std::vector<const MCParticle*> mc_particles;
-    for(const auto& mc_particle : mc_particles_) {
-        if(mc_particle.get() == nullptr) {
-            throw MissingReferenceException(typeid(*this), typeid(MCParticle));
-        }
-        mc_particles.emplace_back(mc_particle.get());
+const std::vector<const MCParticle*>& PixelHit::getMCParticles() const {
+    if(!mc_particles_cached_) {
+        throw MissingReferenceException(typeid(*this), typeid(MCParticle));
     }
-
-    // Return as a vector of mc particles
-    return mc_particles;
+    return mc_particles_cache_;
 }
 
 /**
@@ -79,23 +73,41 @@ std::vector<const MCParticle*> PixelHit::getMCParticles() const {
  *
  * MCParticles can only be fetched if the full history of objects are in scope and stored
  */
-std::vector<const MCParticle*> PixelHit::getPrimaryMCParticles() const {
-    std::vector<const MCParticle*> primary_particles;
+const std::vector<const MCParticle*>& PixelHit::getPrimaryMCParticles() const {
+    if(!mc_particles_cached_) {
+        throw MissingReferenceException(typeid(*this), typeid(MCParticle));
+    }
+    return primary_mc_particles_cache_;
+}
+
+/**
+ * The references are resolved when the history is set, either on construction or when loading it, such that the lookups do
+ * not need to dereference them or allocate again. The cache is only valid if all particles are in scope.
+ */
+void PixelHit::cache_mc_particles() {
+    mc_particles_cache_.clear();
+    primary_mc_particles_cache_.clear();
+    mc_particles_cached_ = false;
     for(const auto& mc_particle : mc_particles_) {
-        auto* particle = mc_particle.get();
+        const auto* particle = mc_particle.get();
         if(particle == nullptr) {
-            throw MissingReferenceException(typeid(*this), typeid(MCParticle));
+            mc_particles_cache_.clear();
+            primary_mc_particles_cache_.clear();
+            return;
         }
+        mc_particles_cache_.push_back(particle);
 
-        // Check for possible parents:
-        if(particle->getParent() != nullptr) {
-            continue;
+        // A particle is primary if it has no parent
+        if(particle->getParent() == nullptr) {
+            primary_mc_particles_cache_.push_back(particle);
         }
-        primary_particles.emplace_back(particle);
     }
+    mc_particles_cached_ = true;
+}
 
-    // Return as a vector of mc particles
-    return primary_particles;
+size_t PixelHit::getSizeHint() const {
+    return mc_particles_.capacity() * sizeof(PointerWrapper<MCParticle>) +
+           (mc_particles_cache_.capacity() + primary_mc_particles_cache_.capacity()) * sizeof(const MCParticle*);
 }
 
 void PixelHit::print(std::ostream& out) const {
@@ -106,8 +118,10 @@ void PixelHit::print(std::ostream& out) const {
 void PixelHit::loadHistory() {
     pixel_charge_.get();
     std::for_each(mc_particles_.begin(), mc_particles_.end(), [](auto& n) { n.get(); });
+    cache_mc_particles();
 }
 void PixelHit::petrifyHistory() {
     pixel_charge_.store();
     std::for_each(mc_particles_.begin(), mc_particles_.end(), [](auto& n) { n.store(); });
+    pixel_.petrify();
 }
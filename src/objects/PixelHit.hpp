@@ -78,14 +78,20 @@ namespace allpix {
          * @brief Get the Monte-Carlo particles resulting in this pixel hit
          * @return List of all related Monte-Carlo particles
          */
-        std::vector<const MCParticle*> getMCParticles() const;
+        const std::vector<const MCParticle*>& getMCParticles() const;
 
         /**
          * @brief Get all primary Monte-Carlo particles resulting in this pixel hit. A particle is considered primary if it
          * has no parent particle set.
          * @return List of all related primary Monte-Carlo particles
          */
-        std::vector<const MCParticle*> getPrimaryMCParticles() const;
+        const std::vector<const MCParticle*>& getPrimaryMCParticles() const;
+
+        /**
+         * @brief Get an estimate of the memory allocated by the pixel hit
+         * @return Size in bytes of the references to the Monte-Carlo particles
+         */
+        size_t getSizeHint() const;
 
         /**
          * @brief Print an ASCII representation of PixelHit to the given stream
@@ -113,6 +119,16 @@ namespace allpix {
 
         PointerWrapper<PixelCharge> pixel_charge_;
         std::vector<PointerWrapper<MCParticle>> mc_particles_;
+
+        /**
+         * @brief Resolve the Monte-Carlo particles once and cache them together with the primary particles
+         */
+        void cache_mc_particles();
+
+        // Resolved Monte-Carlo particles, not stored but recomputed when loading the history
+        std::vector<const MCParticle*> mc_particles_cache_;         //!
+        std::vector<const MCParticle*> primary_mc_particles_cache_; //!
+        bool mc_particles_cached_{};                                //!
     };
 
     /**
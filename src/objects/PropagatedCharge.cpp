@@ -21,8 +21,10 @@ PropagatedCharge::PropagatedCharge(ROOT::Math::XYZPoint local_position,
                                    unsigned int charge,
                                    double local_time,
                                    double global_time,
-                                   const DepositedCharge* deposited_charge)
-    : SensorCharge(std::move(local_position), std::move(global_position), type, charge, local_time, global_time) {
+                                   const DepositedCharge* deposited_charge,
+                                   double weight)
+    : SensorCharge(std::move(local_position), std::move(global_position), type, charge, local_time, global_time),
+      weight_(weight) {
     deposited_charge_ = PointerWrapper<DepositedCharge>(deposited_charge);
     if(deposited_charge != nullptr) {
         mc_particle_ = deposited_charge->mc_particle_;
@@ -35,7 +37,8 @@ PropagatedCharge::PropagatedCharge(ROOT::Math::XYZPoint local_position,
                                    std::map<Pixel::Index, Pulse> pulses,
                                    double local_time,
                                    double global_time,
-                                   const DepositedCharge* deposited_charge)
+                                   const DepositedCharge* deposited_charge,
+                                   double weight)
     : PropagatedCharge(std::move(local_position),
                        std::move(global_position),
                        type,
@@ -47,7 +50,8 @@ PropagatedCharge::PropagatedCharge(ROOT::Math::XYZPoint local_position,
                                        }),
                        local_time,
                        global_time,
-                       deposited_charge) {
+                       deposited_charge,
+                       weight) {
     pulses_ = std::move(pulses);
 }
 
@@ -77,13 +81,29 @@ const MCParticle* PropagatedCharge::getMCParticle() const {
     return mc_particle;
 }
 
-std::map<Pixel::Index, Pulse> PropagatedCharge::getPulses() const {
+const std::map<Pixel::Index, Pulse>& PropagatedCharge::getPulses() const {
     return pulses_;
 }
 
+double PropagatedCharge::getWeight() const {
+    return weight_;
+}
+
+/**
+ * Every node of the map is assumed to hold three pointers and the color of the tree besides the pulse and its key
+ */
+size_t PropagatedCharge::getSizeHint() const {
+    size_t size = 0;
+    for(const auto& [pixel, pulse] : pulses_) {
+        size += 4 * sizeof(void*) + sizeof(pixel) + sizeof(pulse) + pulse.getSizeHint();
+    }
+    return size;
+}
+
 void PropagatedCharge::print(std::ostream& out) const {
     out << "--- Propagated charge information\n";
     SensorCharge::print(out);
+    out << "Weight: " << weight_ << '\n';
 }
 
 void PropagatedCharge::loadHistory() {
@@ -93,4 +113,8 @@ void PropagatedCharge::loadHistory() {
 void PropagatedCharge::petrifyHistory() {
     deposited_charge_.store();
     mc_particle_.store();
+    petrify_positions();
+    for(auto& pulse : pulses_) {
+        pulse.second.petrify();
+    }
 }
@@ -36,6 +36,7 @@ namespace allpix {
          * @param local_time Time of propagation arrival after energy deposition, local reference frame
          * @param global_time Total time of propagation arrival after event start, global reference frame
          * @param deposited_charge Optional pointer to related deposited charge
+         * @param weight Statistical weight of the set, i.e. the number of sets of the configured size it represents
          */
         PropagatedCharge(ROOT::Math::XYZPoint local_position,
                          ROOT::Math::XYZPoint global_position,
@@ -43,7 +44,8 @@ namespace allpix {
                          unsigned int charge,
                          double local_time,
                          double global_time,
-                         const DepositedCharge* deposited_charge = nullptr);
+                         const DepositedCharge* deposited_charge = nullptr,
+                         double weight = 1.);
 
         /**
          * @brief Construct a set of propagated charges
@@ -54,6 +56,7 @@ namespace allpix {
          * @param local_time Time of propagation arrival after energy deposition, local reference frame
          * @param global_time Total time of propagation arrival after event start, global reference frame
          * @param deposited_charge Optional pointer to related deposited charge
+         * @param weight Statistical weight of the set, i.e. the number of sets of the configured size it represents
          */
         PropagatedCharge(ROOT::Math::XYZPoint local_position,
                          ROOT::Math::XYZPoint global_position,
@@ -61,7 +64,8 @@ namespace allpix {
                          std::map<Pixel::Index, Pulse> pulses,
                          double local_time,
                          double global_time,
-                         const DepositedCharge* deposited_charge = nullptr);
+                         const DepositedCharge* deposited_charge = nullptr,
+                         double weight = 1.);
 
         /**
          * @brief Get related deposited charge
@@ -77,9 +81,21 @@ namespace allpix {
 
         /**
          * @brief Get related induced pulses
-         * @return Map with induced pulses if available
+         * @return Constant reference to the map with induced pulses if available
          */
-        std::map<Pixel::Index, Pulse> getPulses() const;
+        const std::map<Pixel::Index, Pulse>& getPulses() const;
+
+        /**
+         * @brief Get the statistical weight of the propagated set of charges
+         * @return Number of sets of the configured size represented by this set, one unless deposits were thinned
+         */
+        double getWeight() const;
+
+        /**
+         * @brief Get an estimate of the memory allocated by the propagated charge
+         * @return Size in bytes of the induced pulses including the nodes of the map holding them
+         */
+        size_t getSizeHint() const;
 
         /**
          * @brief Print an ASCII representation of PropagatedCharge to the given stream
@@ -90,7 +106,7 @@ namespace allpix {
         /**
          * @brief ROOT class definition
          */
-        ClassDefOverride(PropagatedCharge, 6); // NOLINT
+        ClassDefOverride(PropagatedCharge, 7); // NOLINT
         /**
          * @brief Default constructor for ROOT I/O
          */
@@ -104,6 +120,8 @@ namespace allpix {
         PointerWrapper<MCParticle> mc_particle_;
 
         std::map<Pixel::Index, Pulse> pulses_;
+
+        double weight_{1.};
     };
 
     /**
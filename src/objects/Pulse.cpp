@@ -10,13 +10,22 @@
 #include "Pulse.hpp"
 #include "objects/exceptions.h"
 
+#include <algorithm>
 #include <cmath>
+#include <functional>
 #include <numeric>
+#include <utility>
 
 using namespace allpix;
 
 Pulse::Pulse(double time_bin) : bin_(time_bin), initialized_(true) {}
 
+Pulse::Pulse(double time_bin, double total_time) : bin_(time_bin), initialized_(true) {
+    pulse_.reserve(static_cast<size_t>(std::lround(total_time / time_bin)) + 1);
+}
+
+Pulse::Pulse(double time_bin, std::vector<double> pulse) : pulse_(std::move(pulse)), bin_(time_bin), initialized_(true) {}
+
 void Pulse::addCharge(double charge, double time) {
     // For uninitialized pulses, store all charge in the first bin:
     auto bin = (initialized_ ? static_cast<size_t>(std::lround(time / bin_)) : 0);
@@ -25,7 +34,7 @@ void Pulse::addCharge(double charge, double time) {
     if(bin >= pulse_.size()) {
         pulse_.resize(bin + 1);
     }
-    pulse_.at(bin) += charge;
+    pulse_[bin] += charge;
 }
 
 int Pulse::getCharge() const {
@@ -37,6 +46,10 @@ const std::vector<double>& Pulse::getPulse() const {
     return pulse_;
 }
 
+size_t Pulse::getSizeHint() const {
+    return pulse_.capacity() * sizeof(double) + samples_.capacity() * sizeof(float);
+}
+
 double Pulse::getBinning() const {
     return bin_;
 }
@@ -46,7 +59,7 @@ bool Pulse::isInitialized() const {
 }
 
 Pulse& Pulse::operator+=(const Pulse& rhs) {
-    auto rhs_pulse = rhs.getPulse();
+    const auto& rhs_pulse = rhs.getPulse();
 
     // Allow to initialize uninitialized pulse
     if(!this->initialized_) {
@@ -59,15 +72,28 @@ Pulse& Pulse::operator+=(const Pulse& rhs) {
         throw IncompatibleDatatypesException(typeid(*this), typeid(rhs), "different time binning");
     }
 
+    // An empty pulse takes over the bins, reusing its storage:
+    if(this->pulse_.empty()) {
+        this->pulse_.assign(rhs_pulse.begin(), rhs_pulse.end());
+        return *this;
+    }
+
     // If new pulse is longer, extend:
     if(this->pulse_.size() < rhs_pulse.size()) {
         this->pulse_.resize(rhs_pulse.size());
     }
 
-    // Add up the individual bins:
-    for(size_t bin = 0; bin < rhs_pulse.size(); bin++) {
-        this->pulse_.at(bin) += rhs_pulse.at(bin);
-    }
+    // Add up the individual bins in place:
+    std::transform(rhs_pulse.begin(), rhs_pulse.end(), this->pulse_.begin(), this->pulse_.begin(), std::plus<>());
 
     return *this;
 }
+
+void Pulse::petrify() {
+    auto is_filled = [](double charge) { return charge != 0.; };
+    auto first = std::find_if(pulse_.begin(), pulse_.end(), is_filled);
+    auto last = std::find_if(pulse_.rbegin(), std::make_reverse_iterator(first), is_filled).base();
+
+    offset_ = static_cast<unsigned int>(std::distance(pulse_.begin(), first));
+    samples_.assign(first, last);
+}
@@ -19,6 +19,11 @@ namespace allpix {
      * @ingroup Objects
      * @brief Pulse holding induced charges as a function of time
      * @warning This object is special and is not meant to be written directly to a tree (not inheriting from \ref Object)
+     *
+     * In memory, the pulse holds the charge of all its time bins. On file, only the bins from the first to the last bin with
+     * induced charge are stored in single precision together with the number of leading empty bins, since most bins of a
+     * pulse are usually empty. The compact representation is created by \ref petrify before writing and is expanded again
+     * when reading the pulse from file.
      */
     class Pulse {
     public:
@@ -27,6 +32,20 @@ namespace allpix {
          */
         explicit Pulse(double time_bin);
 
+        /**
+         * @brief Construct a new pulse with storage for all time bins of a time interval
+         * @param time_bin Width of the time bins
+         * @param total_time Length of the time interval, charge induced later is still added to the pulse
+         */
+        Pulse(double time_bin, double total_time);
+
+        /**
+         * @brief Construct a new pulse from the charges of its time bins
+         * @param time_bin Width of the time bins
+         * @param pulse Induced charge in every time bin
+         */
+        Pulse(double time_bin, std::vector<double> pulse);
+
         /**
          * @brief Construct default pulse, uninitialized
          */
@@ -63,21 +82,36 @@ namespace allpix {
          */
         bool isInitialized() const;
 
+        /**
+         * @brief Get an estimate of the memory allocated by the pulse
+         * @return Size in bytes of the storage of the time bins and of their compact representation
+         */
+        size_t getSizeHint() const;
+
         /**
          * @brief compound assignment operator to sum different pulses
          * @throws IncompatibleDatatypesException If the binning of the pulses does not match
          */
         Pulse& operator+=(const Pulse& rhs);
 
+        /**
+         * @brief Create the compact representation of the pulse stored to file
+         */
+        void petrify();
+
         /**
          * @brief Default constructor for ROOT I/O
          */
-        ClassDef(Pulse, 2); // NOLINT
+        ClassDef(Pulse, 3); // NOLINT
 
     private:
-        std::vector<double> pulse_;
+        std::vector<double> pulse_; //!
         double bin_{};
         bool initialized_{};
+
+        // Compact representation for storage, the bins with induced charge and the number of empty bins before them
+        unsigned int offset_{};
+        std::vector<float> samples_;
     };
 
 } // namespace allpix
@@ -0,0 +1,122 @@
+/**
+ * @file
+ * @brief Implementation of the accumulator summing the pulses of many pixels
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include "PulseAccumulator.hpp"
+#include "objects/exceptions.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace allpix;
+
+PulseAccumulator::PulseAccumulator(double time_bin, size_t bins)
+    : bin_(time_bin), bins_per_pixel_(std::max<size_t>(bins, 1)) {}
+
+/**
+ * The charge is stored in the time bin closest to the given time, the same bin as chosen by \ref Pulse::addCharge.
+ */
+void PulseAccumulator::addCharge(const Pixel::Index& pixel, double charge, double time) {
+    auto slot = get_slot(pixel);
+    auto bin = static_cast<size_t>(std::lround(time / bin_));
+    if(bin >= bins_per_pixel_) {
+        resize_bins(std::max(bin + 1, 2 * bins_per_pixel_));
+    }
+    bins_[slot * bins_per_pixel_ + bin] += charge;
+    lengths_[slot] = std::max(lengths_[slot], bin + 1);
+}
+
+/**
+ * Every time bin covers the times which are rounded to its center, the same as for the charge induced at a single time.
+ */
+void PulseAccumulator::addCharge(const Pixel::Index& pixel, double charge, double start_time, double end_time) {
+    auto first_bin = static_cast<size_t>(std::lround(start_time / bin_));
+    auto last_bin = static_cast<size_t>(std::lround(end_time / bin_));
+    if(first_bin == last_bin) {
+        addCharge(pixel, charge, end_time);
+        return;
+    }
+
+    auto slot = get_slot(pixel);
+    if(last_bin >= bins_per_pixel_) {
+        resize_bins(std::max(last_bin + 1, 2 * bins_per_pixel_));
+    }
+    auto* bins = bins_.data() + slot * bins_per_pixel_;
+    auto rate = charge / (end_time - start_time);
+    for(auto bin = first_bin; bin <= last_bin; ++bin) {
+        auto bin_start = std::max(start_time, (static_cast<double>(bin) - 0.5) * bin_);
+        auto bin_end = std::min(end_time, (static_cast<double>(bin) + 0.5) * bin_);
+        bins[bin] += rate * (bin_end - bin_start);
+    }
+    lengths_[slot] = std::max(lengths_[slot], last_bin + 1);
+}
+
+void PulseAccumulator::addPulse(const Pixel::Index& pixel, const Pulse& pulse) {
+    if(pixels_.empty()) {
+        bin_ = pulse.getBinning();
+    }
+    if(pulse.getBinning() != bin_) {
+        throw IncompatibleDatatypesException(typeid(*this), typeid(pulse), "different time binning");
+    }
+
+    const auto& values = pulse.getPulse();
+    auto slot = get_slot(pixel);
+    if(values.size() > bins_per_pixel_) {
+        resize_bins(std::max(values.size(), 2 * bins_per_pixel_));
+    }
+    auto* bins = bins_.data() + slot * bins_per_pixel_;
+    for(size_t bin = 0; bin < values.size(); ++bin) {
+        bins[bin] += values[bin];
+    }
+    lengths_[slot] = std::max(lengths_[slot], values.size());
+}
+
+bool PulseAccumulator::empty() const {
+    return pixels_.empty();
+}
+
+void PulseAccumulator::clear() {
+    slots_.clear();
+    pixels_.clear();
+    lengths_.clear();
+    bins_.clear();
+}
+
+std::map<Pixel::Index, Pulse> PulseAccumulator::getPulses() const {
+    std::map<Pixel::Index, Pulse> pulses;
+    for(size_t slot = 0; slot < pixels_.size(); ++slot) {
+        const auto* begin = bins_.data() + slot * bins_per_pixel_;
+        pulses.emplace(pixels_[slot], Pulse(bin_, std::vector<double>(begin, begin + lengths_[slot])));
+    }
+    return pulses;
+}
+
+size_t PulseAccumulator::get_slot(const Pixel::Index& pixel) {
+    auto key = (static_cast<uint64_t>(pixel.x()) << 32) | pixel.y();
+    auto [it, inserted] = slots_.try_emplace(key, pixels_.size());
+    if(inserted) {
+        pixels_.push_back(pixel);
+        lengths_.push_back(0);
+        bins_.resize(bins_.size() + bins_per_pixel_);
+    }
+    return it->second;
+}
+
+/**
+ * The bins are moved starting from the last pixel, such that the array can be extended in place.
+ */
+void PulseAccumulator::resize_bins(size_t bins) {
+    bins_.resize(pixels_.size() * bins);
+    for(size_t slot = pixels_.size(); slot-- > 0;) {
+        auto* old_begin = bins_.data() + slot * bins_per_pixel_;
+        auto* new_begin = bins_.data() + slot * bins;
+        std::copy_backward(old_begin, old_begin + bins_per_pixel_, new_begin + bins_per_pixel_);
+        std::fill(new_begin + bins_per_pixel_, new_begin + bins, 0.);
+    }
+    bins_per_pixel_ = bins;
+}
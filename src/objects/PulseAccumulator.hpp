@@ -0,0 +1,110 @@
+/**
+ * @file
+ * @brief Definition of the accumulator summing the pulses of many pixels
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_PULSE_ACCUMULATOR_H
+#define ALLPIX_PULSE_ACCUMULATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "Pixel.hpp"
+#include "Pulse.hpp"
+
+namespace allpix {
+    /**
+     * @ingroup Objects
+     * @brief Accumulator of the induced charge of many pixels in dense arrays of time bins
+     *
+     * The time bins of all pixels are stored in a single flat array with a fixed number of bins per pixel, and the pixels
+     * are found by a hash of their index. Adding charge therefore neither requires tree lookups nor reallocations once the
+     * expected number of bins has been reserved. The accumulated pulses are identical to summing individual \ref Pulse
+     * objects in the same order. After clearing, the accumulator can be reused without releasing its memory.
+     *
+     * @warning This object is a helper for the modules and is not meant to be written to file
+     */
+    class PulseAccumulator {
+    public:
+        /**
+         * @brief Construct a new accumulator
+         * @param time_bin Width of the time bins
+         * @param bins Number of time bins to reserve for every pixel
+         */
+        explicit PulseAccumulator(double time_bin, size_t bins = 1);
+
+        /**
+         * @brief Add induced charge to the pulse of a pixel
+         * @param pixel Index of the pixel
+         * @param charge Induced charge
+         * @param time Time when it has been induced
+         */
+        void addCharge(const Pixel::Index& pixel, double charge, double time);
+
+        /**
+         * @brief Add charge induced uniformly during a time interval to the pulse of a pixel
+         * @param pixel Index of the pixel
+         * @param charge Induced charge
+         * @param start_time Time when the interval starts
+         * @param end_time Time when the interval ends
+         *
+         * The charge is split over the time bins covered by the interval, proportional to their overlap with the interval.
+         */
+        void addCharge(const Pixel::Index& pixel, double charge, double start_time, double end_time);
+
+        /**
+         * @brief Add a pulse to the pulse of a pixel
+         * @param pixel Index of the pixel
+         * @param pulse Pulse to add
+         * @throws IncompatibleDatatypesException If the binning of the pulse does not match the accumulator
+         *
+         * If no charge has been accumulated yet, the binning of the pulse is adopted like for an uninitialized \ref Pulse.
+         */
+        void addPulse(const Pixel::Index& pixel, const Pulse& pulse);
+
+        /**
+         * @brief Return if any charge has been accumulated
+         * @return True if no pixel has received a charge, false otherwise
+         */
+        bool empty() const;
+
+        /**
+         * @brief Remove all accumulated charge, keeping the memory for further use
+         */
+        void clear();
+
+        /**
+         * @brief Create the pulses of all pixels which received charge
+         * @return Map of the pixel indices and their pulses
+         */
+        std::map<Pixel::Index, Pulse> getPulses() const;
+
+    private:
+        /**
+         * @brief Return the position of a pixel in the flat array of time bins, adding it if necessary
+         */
+        size_t get_slot(const Pixel::Index& pixel);
+
+        /**
+         * @brief Increase the number of time bins per pixel, moving the bins of all pixels
+         */
+        void resize_bins(size_t bins);
+
+        double bin_;
+        size_t bins_per_pixel_;
+
+        std::unordered_map<uint64_t, size_t> slots_;
+        std::vector<Pixel::Index> pixels_;
+        std::vector<size_t> lengths_;
+        std::vector<double> bins_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_PULSE_ACCUMULATOR_H */
@@ -48,6 +48,11 @@ double SensorCharge::getLocalTime() const {
     return local_time_;
 }
 
+void SensorCharge::petrify_positions() {
+    stored_local_position_ = ROOT::Math::XYZPointF(local_position_);
+    stored_global_position_ = ROOT::Math::XYZPointF(global_position_);
+}
+
 void SensorCharge::print(std::ostream& out) const {
     out << "Type: " << (type_ == CarrierType::ELECTRON ? "\"e\"" : "\"h\"") << "\nCharge: " << charge_ << " e"
         << "\nLocal Position: (" << local_position_.X() << ", " << local_position_.Y() << ", " << local_position_.Z()
@@ -29,6 +29,9 @@ namespace allpix {
     /**
      * @ingroup Objects
      * @brief Base object for charge deposits and propagated charges in the sensor
+     *
+     * On file, the positions are stored in single precision, which is sufficient for positions in the sensor and the setup.
+     * The compact representation is created by \ref petrify_positions before writing and converted back when reading.
      */
     class SensorCharge : public Object {
     public:
@@ -97,15 +100,25 @@ namespace allpix {
         /**
          * @brief ROOT class definition
          */
-        ClassDefOverride(SensorCharge, 3); // NOLINT
+        ClassDefOverride(SensorCharge, 4); // NOLINT
         /**
          * @brief Default constructor for ROOT I/O
          */
         SensorCharge() = default;
 
+    protected:
+        /**
+         * @brief Create the compact representation of the positions stored to file
+         */
+        void petrify_positions();
+
     private:
-        ROOT::Math::XYZPoint local_position_;
-        ROOT::Math::XYZPoint global_position_;
+        ROOT::Math::XYZPoint local_position_;  //!
+        ROOT::Math::XYZPoint global_position_; //!
+
+        // Compact representation for storage, the positions in single precision
+        ROOT::Math::XYZPointF stored_local_position_;
+        ROOT::Math::XYZPointF stored_global_position_;
 
         double local_time_{};
         double global_time_{};
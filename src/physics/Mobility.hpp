@@ -11,6 +11,12 @@
 #ifndef ALLPIX_MOBILITY_MODELS_H
 #define ALLPIX_MOBILITY_MODELS_H
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include "exceptions.h"
 
 #include "core/utils/unit.h"
@@ -42,6 +48,21 @@ namespace allpix {
          * @return Mobility of the charge carrier
          */
         virtual double operator()(const CarrierType& type, double efield_mag, double doping) const = 0;
+
+        /**
+         * Evaluate the mobility for a batch of charge carriers of the same type
+         * @param type Type of charge carriers (electron or hole)
+         * @param efield_mag Magnitudes of the electric field
+         * @param doping (Effective) doping concentrations
+         * @param mobility Array to store the mobility of every charge carrier in
+         * @param count Number of charge carriers in the batch
+         */
+        virtual void evaluate(
+            const CarrierType& type, const double* efield_mag, const double* doping, double* mobility, size_t count) const {
+            for(size_t i = 0; i < count; ++i) {
+                mobility[i] = this->operator()(type, efield_mag[i], doping[i]);
+            }
+        }
     };
 
     /**
@@ -71,6 +92,17 @@ namespace allpix {
             }
         };
 
+        void evaluate(const CarrierType& type, const double* efield_mag, const double*, double* mobility, size_t count)
+            const override {
+            // Select the constants once for the full batch to allow vectorization of the loop
+            const auto vm = (type == CarrierType::ELECTRON ? electron_Vm_ : hole_Vm_);
+            const auto ec = (type == CarrierType::ELECTRON ? electron_Ec_ : hole_Ec_);
+            const auto beta = (type == CarrierType::ELECTRON ? electron_Beta_ : hole_Beta_);
+            for(size_t i = 0; i < count; ++i) {
+                mobility[i] = vm / ec / std::pow(1. + std::pow(efield_mag[i] / ec, beta), 1.0 / beta);
+            }
+        }
+
     protected:
         double electron_Vm_;
         double electron_Beta_;
@@ -234,6 +266,15 @@ namespace allpix {
                 return masetti / std::pow(1. + std::pow(masetti * efield_mag / hole_Vm_, hole_Beta_), 1. / hole_Beta_);
             }
         };
+
+        void evaluate(const CarrierType& type,
+                      const double* efield_mag,
+                      const double* doping,
+                      double* mobility,
+                      size_t count) const override {
+            // Do not use the batch evaluation of the Canali model
+            MobilityModel::evaluate(type, efield_mag, doping, mobility, count);
+        }
     };
 
     /**
@@ -276,6 +317,196 @@ namespace allpix {
         double alpha_;
     };
 
+    /**
+     * @ingroup Models
+     * @brief Tabulated version of another mobility model
+     *
+     * The wrapped model is sampled at construction on a regular grid in the electric field magnitude and in the logarithm
+     * of the doping concentration, each only if the model depends on the respective quantity. Values are interpolated
+     * linearly between the grid points. The number of grid points is doubled until the maximum relative deviation from the
+     * wrapped model, evaluated half-way between the grid points, is below the requested precision. Outside the tabulated
+     * range the wrapped model is evaluated directly.
+     */
+    class TabulatedMobility : public MobilityModel {
+    public:
+        /**
+         * Construct the tables for the given model
+         * @param model            Mobility model to tabulate
+         * @param field_dependent  Boolean to indicate if the model depends on the electric field magnitude
+         * @param doping_dependent Boolean to indicate if the model depends on the doping concentration
+         * @param precision        Maximum relative interpolation error the tables are constructed for
+         */
+        TabulatedMobility(std::unique_ptr<MobilityModel> model,
+                          bool field_dependent,
+                          bool doping_dependent,
+                          double precision)
+            : model_(std::move(model)), field_max_(Units::get(1e6, "V/cm")),
+              doping_min_(std::log10(Units::get(1e10, "/cm/cm/cm"))),
+              doping_max_(std::log10(Units::get(1e22, "/cm/cm/cm"))) {
+            field_points_ = (field_dependent ? 65 : 1);
+            doping_points_ = (doping_dependent ? 65 : 1);
+            while(true) {
+                fill_tables();
+                error_ = max_error();
+
+                // Refining adds a grid point between all existing ones
+                auto next_field_points = (field_dependent ? 2 * field_points_ - 1 : 1);
+                auto next_doping_points = (doping_dependent ? 2 * doping_points_ - 1 : 1);
+                if(error_ <= precision || next_field_points * next_doping_points > max_points_) {
+                    break;
+                }
+                field_points_ = next_field_points;
+                doping_points_ = next_doping_points;
+            }
+        }
+
+        double operator()(const CarrierType& type, double efield_mag, double doping) const override {
+            double mobility = 0;
+            if(interpolate(type, efield_mag, doping, mobility)) {
+                return mobility;
+            }
+            return model_->operator()(type, efield_mag, doping);
+        };
+
+        void evaluate(const CarrierType& type,
+                      const double* efield_mag,
+                      const double* doping,
+                      double* mobility,
+                      size_t count) const override {
+            for(size_t i = 0; i < count; ++i) {
+                if(!interpolate(type, efield_mag[i], doping[i], mobility[i])) {
+                    mobility[i] = model_->operator()(type, efield_mag[i], doping[i]);
+                }
+            }
+        }
+
+        /**
+         * Get the maximum relative interpolation error found when constructing the tables
+         * @return Maximum relative error
+         */
+        double getMaximumError() const { return error_; }
+
+        /**
+         * Get the number of grid points of the tables
+         * @return Number of grid points in the electric field magnitude and the doping concentration
+         */
+        std::pair<size_t, size_t> getPoints() const { return {field_points_, doping_points_}; }
+
+    private:
+        /**
+         * Interpolate the mobility from the tables
+         * @param type Type of charge carrier (electron or hole)
+         * @param efield_mag Magnitude of the electric field
+         * @param doping (Effective) doping concentration
+         * @param mobility Interpolated mobility of the charge carrier
+         * @return True if the values are within the tabulated range, false otherwise
+         */
+        bool interpolate(const CarrierType& type, double efield_mag, double doping, double& mobility) const {
+            const auto& table = (type == CarrierType::ELECTRON ? electron_table_ : hole_table_);
+
+            size_t field_index = 0, field_step = 0;
+            double field_fraction = 0;
+            if(field_points_ > 1) {
+                auto coord = std::sqrt(efield_mag) * field_scale_;
+                if(!(coord >= 0. && coord < static_cast<double>(field_points_ - 1))) {
+                    return false;
+                }
+                field_index = static_cast<size_t>(coord);
+                field_fraction = coord - static_cast<double>(field_index);
+                field_step = doping_points_;
+            }
+
+            size_t doping_index = 0, doping_step = 0;
+            double doping_fraction = 0;
+            if(doping_points_ > 1) {
+                auto coord = (std::log10(std::fabs(doping)) - doping_min_) * doping_scale_;
+                if(!(coord >= 0. && coord < static_cast<double>(doping_points_ - 1))) {
+                    return false;
+                }
+                doping_index = static_cast<size_t>(coord);
+                doping_fraction = coord - static_cast<double>(doping_index);
+                doping_step = 1;
+            }
+
+            const auto* value = &table[field_index * doping_points_ + doping_index];
+            mobility = (1. - field_fraction) * ((1. - doping_fraction) * value[0] + doping_fraction * value[doping_step]) +
+                       field_fraction * ((1. - doping_fraction) * value[field_step] +
+                                         doping_fraction * value[field_step + doping_step]);
+            return true;
+        }
+
+        /**
+         * Sample the wrapped model at all grid points
+         */
+        void fill_tables() {
+            field_scale_ = (field_points_ > 1 ? static_cast<double>(field_points_ - 1) / std::sqrt(field_max_) : 0.);
+            doping_scale_ =
+                (doping_points_ > 1 ? static_cast<double>(doping_points_ - 1) / (doping_max_ - doping_min_) : 0.);
+
+            for(auto type : {CarrierType::ELECTRON, CarrierType::HOLE}) {
+                auto& table = (type == CarrierType::ELECTRON ? electron_table_ : hole_table_);
+                table.resize(field_points_ * doping_points_);
+                for(size_t i = 0; i < field_points_; ++i) {
+                    for(size_t j = 0; j < doping_points_; ++j) {
+                        table[i * doping_points_ + j] = model_->operator()(
+                            type, field_at(static_cast<double>(i)), doping_at(static_cast<double>(j)));
+                    }
+                }
+            }
+        }
+
+        /**
+         * Compare the interpolated values half-way between the grid points to the wrapped model
+         * @return Maximum relative deviation
+         */
+        double max_error() const {
+            double error = 0;
+            auto field_offsets = (field_points_ > 1 ? std::vector<double>{0., 0.5} : std::vector<double>{0.});
+            auto doping_offsets = (doping_points_ > 1 ? std::vector<double>{0., 0.5} : std::vector<double>{0.});
+            for(auto type : {CarrierType::ELECTRON, CarrierType::HOLE}) {
+                for(size_t i = 0; i < std::max(field_points_ - 1, size_t(1)); ++i) {
+                    for(size_t j = 0; j < std::max(doping_points_ - 1, size_t(1)); ++j) {
+                        for(auto di : field_offsets) {
+                            for(auto dj : doping_offsets) {
+                                auto efield_mag = field_at(static_cast<double>(i) + di);
+                                auto doping = doping_at(static_cast<double>(j) + dj);
+                                auto exact = model_->operator()(type, efield_mag, doping);
+                                double interpolated = exact;
+                                interpolate(type, efield_mag, doping, interpolated);
+                                if(exact != 0.) {
+                                    error = std::max(error, std::fabs(interpolated / exact - 1.));
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+            return error;
+        }
+
+        double field_at(double coord) const { return (field_points_ > 1 ? std::pow(coord / field_scale_, 2) : 0.); }
+        double doping_at(double coord) const {
+            return std::pow(10., (doping_points_ > 1 ? doping_min_ + coord / doping_scale_ : doping_max_));
+        }
+
+        std::unique_ptr<MobilityModel> model_;
+
+        // Tabulated range, the doping concentration is sampled logarithmically
+        double field_max_;
+        double doping_min_;
+        double doping_max_;
+
+        static constexpr size_t max_points_{1u << 21u};
+        size_t field_points_{};
+        size_t doping_points_{};
+        double field_scale_{};
+        double doping_scale_{};
+        double error_{};
+
+        std::vector<double> electron_table_;
+        std::vector<double> hole_table_;
+    };
+
     /**
      * @brief Wrapper class and factory for mobility models.
      *
@@ -303,14 +534,21 @@ namespace allpix {
                 model_ = std::make_unique<Canali>(temperature);
             } else if(model == "hamburg") {
                 model_ = std::make_unique<Hamburg>(temperature);
+                analytic_ = true;
             } else if(model == "hamburg_highfield") {
                 model_ = std::make_unique<HamburgHighField>(temperature);
+                analytic_ = true;
             } else if(model == "masetti") {
                 model_ = std::make_unique<Masetti>(temperature, doping);
+                field_dependent_ = false;
+                doping_dependent_ = true;
             } else if(model == "masetti_canali") {
                 model_ = std::make_unique<MasettiCanali>(temperature, doping);
+                doping_dependent_ = true;
             } else if(model == "arora") {
                 model_ = std::make_unique<Arora>(temperature, doping);
+                field_dependent_ = false;
+                doping_dependent_ = true;
             } else {
                 throw InvalidModelError(model);
             }
@@ -325,8 +563,49 @@ namespace allpix {
             return model_->operator()(std::forward<ARGS>(args)...);
         }
 
+        /**
+         * Batch evaluation forwarded to the mobility model
+         * @param type Type of charge carriers (electron or hole)
+         * @param efield_mag Magnitudes of the electric field
+         * @param doping (Effective) doping concentrations
+         * @param mobility Array to store the mobility of every charge carrier in
+         * @param count Number of charge carriers in the batch
+         */
+        void evaluate(
+            const CarrierType& type, const double* efield_mag, const double* doping, double* mobility, size_t count) const {
+            model_->evaluate(type, efield_mag, doping, mobility, count);
+        }
+
+        /**
+         * Replace the mobility model by a tabulated version of itself
+         * @note Models not using any transcendental functions are cheaper to evaluate directly and are not tabulated
+         * @param precision Maximum relative interpolation error the tables should be constructed for
+         * @return Maximum relative interpolation error of the constructed tables
+         */
+        double tabulate(double precision) {
+            if(analytic_) {
+                LOG(DEBUG) << "Mobility model can be evaluated as fast as its tabulated version, not tabulating";
+                return 0;
+            }
+
+            auto table =
+                std::make_unique<TabulatedMobility>(std::move(model_), field_dependent_, doping_dependent_, precision);
+            auto error = table->getMaximumError();
+            auto [field_points, doping_points] = table->getPoints();
+            LOG(DEBUG) << "Tabulated mobility model with " << field_points << " points in the electric field and "
+                       << doping_points << " points in the doping concentration";
+            model_ = std::move(table);
+            return error;
+        }
+
     private:
         std::unique_ptr<MobilityModel> model_{};
+
+        // Quantities the selected model depends on
+        bool field_dependent_{true};
+        bool doping_dependent_{false};
+        // Model can be evaluated without any transcendental functions
+        bool analytic_{false};
     };
 
 } // namespace allpix
@@ -11,6 +11,9 @@
 #ifndef ALLPIX_RECOMBINATION_MODELS_H
 #define ALLPIX_RECOMBINATION_MODELS_H
 
+#include <cmath>
+#include <limits>
+
 #include "exceptions.h"
 
 #include "core/utils/unit.h"
@@ -43,7 +46,17 @@ namespace allpix {
          * @param timestep Current time step performed for the charge carrier
          * @return Recombination status, true if charge carrier has recombined, false if it still is alive
          */
-        virtual bool operator()(const CarrierType& type, double doping, double survival_prob, double timestep) const = 0;
+        bool operator()(const CarrierType& type, double doping, double survival_prob, double timestep) const {
+            return survival_prob < (1 - std::exp(-1. * timestep / lifetime(type, doping)));
+        }
+
+        /**
+         * Lifetime of the given carrier at the given doping concentration
+         * @param type Type of charge carrier (electron or hole)
+         * @param doping (Effective) doping concentration
+         * @return Lifetime of the charge carrier, infinite if it does not recombine
+         */
+        virtual double lifetime(const CarrierType& type, double doping) const = 0;
     };
 
     /**
@@ -53,7 +66,7 @@ namespace allpix {
      */
     class None : virtual public RecombinationModel {
     public:
-        bool operator()(const CarrierType&, double, double, double) const override { return false; };
+        double lifetime(const CarrierType&, double) const override { return std::numeric_limits<double>::infinity(); }
     };
 
     /**
@@ -74,12 +87,7 @@ namespace allpix {
             }
         }
 
-        bool operator()(const CarrierType& type, double doping, double survival_prob, double timestep) const override {
-            return survival_prob < (1 - std::exp(-1. * timestep / lifetime(type, doping)));
-        };
-
-    protected:
-        double lifetime(const CarrierType& type, double doping) const {
+        double lifetime(const CarrierType& type, double doping) const override {
             return (type == CarrierType::ELECTRON ? electron_lifetime_reference_ : hole_lifetime_reference_) /
                    (1 + std::fabs(doping) /
                             (type == CarrierType::ELECTRON ? electron_doping_reference_ : hole_doping_reference_));
@@ -107,15 +115,12 @@ namespace allpix {
             }
         }
 
-        bool operator()(const CarrierType& type, double doping, double survival_prob, double timestep) const override {
-            // Auger only applies to minority charge carriers, if we have a majority carrier always return false (alive):
+        double lifetime(const CarrierType& type, double doping) const override {
+            // Auger only applies to minority charge carriers, majority carriers never recombine:
             auto minorityType = (doping > 0 ? CarrierType::HOLE : CarrierType::ELECTRON);
-            return (minorityType != type ? false
-                                         : (survival_prob < (1 - std::exp(-1. * timestep / lifetime(type, doping)))));
-        };
-
-    protected:
-        double lifetime(const CarrierType&, double doping) const { return 1. / (auger_coefficient_ * doping * doping); }
+            return (minorityType != type ? std::numeric_limits<double>::infinity()
+                                         : 1. / (auger_coefficient_ * doping * doping));
+        }
 
     private:
         double auger_coefficient_;
@@ -130,18 +135,16 @@ namespace allpix {
     public:
         ShockleyReadHallAuger(bool doping) : ShockleyReadHall(doping), Auger(doping) {}
 
-        bool operator()(const CarrierType& type, double doping, double survival_prob, double timestep) const override {
+        double lifetime(const CarrierType& type, double doping) const override {
             auto minorityType = (doping > 0 ? CarrierType::HOLE : CarrierType::ELECTRON);
             if(minorityType != type) {
                 // Auger only applies to minority charge carriers, if we have a majority carrier just return SRH lifetime:
-                return ShockleyReadHall::operator()(type, doping, survival_prob, timestep);
+                return ShockleyReadHall::lifetime(type, doping);
             } else {
                 // If we have a minority charge carrier, combine the lifetimes:
-                auto combined_lifetime =
-                    1. / (1. / ShockleyReadHall::lifetime(type, doping) + 1. / Auger::lifetime(type, doping));
-                return survival_prob < (1 - std::exp(-1. * timestep / combined_lifetime));
+                return 1. / (1. / ShockleyReadHall::lifetime(type, doping) + 1. / Auger::lifetime(type, doping));
             }
-        };
+        }
     };
 
     /**
@@ -187,6 +190,32 @@ namespace allpix {
             return model_->operator()(std::forward<ARGS>(args)...);
         }
 
+        /**
+         * Lifetime of the given carrier forwarded to the recombination model
+         * @param type Type of charge carrier (electron or hole)
+         * @param doping (Effective) doping concentration
+         * @return Lifetime of the charge carrier, infinite if it does not recombine
+         */
+        double lifetime(const CarrierType& type, double doping) const { return model_->lifetime(type, doping); }
+
+        /**
+         * Check whether a charge carrier with a given survival time has recombined after a time step
+         * @param type Type of charge carrier (electron or hole)
+         * @param doping (Effective) doping concentration
+         * @param survival_time Remaining survival time of the charge carrier in units of its lifetime, reduced by the step
+         * @param timestep Current time step performed for the charge carrier
+         * @return Recombination status, true if charge carrier has recombined, false if it still is alive
+         *
+         * Instead of one Bernoulli trial per step, the survival time of the carrier in units of its lifetime is drawn once
+         * from an exponential distribution when the carrier is created and consumed by every step. The carrier recombines
+         * when it is used up. The survival probability after a sequence of steps is the same as for the trials, while
+         * every step only requires the evaluation of the lifetime.
+         */
+        bool consume(const CarrierType& type, double doping, double& survival_time, double timestep) const {
+            survival_time -= timestep / model_->lifetime(type, doping);
+            return survival_time <= 0;
+        }
+
     private:
         std::unique_ptr<RecombinationModel> model_{};
     };
@@ -0,0 +1,156 @@
+/**
+ * @file
+ * @brief Python bindings for the run control of the framework and the event data passed to callbacks
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include <iostream>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pybind11/functional.h>
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "core/Allpix.hpp"
+#include "core/module/CallbackRegistry.hpp"
+#include "core/utils/log.h"
+#include "tools/event_records.h"
+
+namespace py = pybind11;
+using namespace allpix;
+
+PYBIND11_NUMPY_DTYPE(event_records::PixelHit, local_time, global_time, signal, column, row);
+PYBIND11_NUMPY_DTYPE(event_records::PixelCharge, local_time, global_time, charge, column, row);
+PYBIND11_NUMPY_DTYPE(event_records::DepositedCharge,
+                     local_x,
+                     local_y,
+                     local_z,
+                     global_x,
+                     global_y,
+                     global_z,
+                     local_time,
+                     global_time,
+                     charge,
+                     type);
+
+namespace {
+    // Names of the callbacks registered from Python, removed before the interpreter shuts down
+    std::set<std::string> python_callbacks;
+
+    /**
+     * @brief Return the structured type of the records of an object type
+     */
+    py::dtype record_dtype(const std::string& type) {
+        if(type == "PixelHit") {
+            return py::dtype::of<event_records::PixelHit>();
+        }
+        if(type == "PixelCharge") {
+            return py::dtype::of<event_records::PixelCharge>();
+        }
+        if(type == "DepositedCharge") {
+            return py::dtype::of<event_records::DepositedCharge>();
+        }
+        throw std::invalid_argument("records of type " + type + " cannot be converted");
+    }
+
+    /**
+     * The array refers to the memory of the records directly, which is kept alive by a capsule holding a reference to it
+     * for as long as the array or any view of it exists.
+     */
+    py::array to_array(const RecordArray& records) {
+        auto* owner = new std::shared_ptr<const void>(records.data);
+        py::capsule base(owner, [](void* pointer) { delete static_cast<std::shared_ptr<const void>*>(pointer); });
+        return py::array(record_dtype(records.type),
+                         {static_cast<py::ssize_t>(records.count)},
+                         {static_cast<py::ssize_t>(records.record_size)},
+                         records.data.get(),
+                         base);
+    }
+} // namespace
+
+PYBIND11_MODULE(pyallpix, m) {
+    m.doc() = "Run control of Allpix Squared and zero-copy access to the data of events passed to callbacks";
+
+    // Add cout as the default logging stream
+    Log::addStream(std::cout);
+
+    m.def(
+        "set_log_level",
+        [](const std::string& level) { Log::setReportingLevel(Log::getLevelFromString(level)); },
+        "Set the reporting level of the framework log, e.g. \"WARNING\" or \"DEBUG\"",
+        py::arg("level"));
+
+    m.def(
+        "register_callback",
+        [](const std::string& name, const py::function& function) {
+            // Copies of the callback are made without holding the interpreter lock, only the last one releases the function
+            std::shared_ptr<py::function> shared(new py::function(function), [](py::function* pointer) {
+                py::gil_scoped_acquire gil;
+                delete pointer;
+            });
+            CallbackRegistry::add(name, [shared](const RecordArray& records) {
+                py::gil_scoped_acquire gil;
+                try {
+                    (*shared)(records.event, records.detector, records.type, to_array(records));
+                } catch(py::error_already_set& error) {
+                    throw std::runtime_error("Python callback failed: " + std::string(error.what()));
+                }
+            });
+            python_callbacks.insert(name);
+        },
+        "Register a function called as function(event, detector, type, records) by EventCallback modules configured with "
+        "this callback name, with the records given as NumPy structured array",
+        py::arg("name"),
+        py::arg("function"));
+
+    m.def(
+        "remove_callback",
+        [](const std::string& name) {
+            CallbackRegistry::remove(name);
+            python_callbacks.erase(name);
+        },
+        "Remove a registered callback",
+        py::arg("name"));
+
+    m.def(
+        "record_dtype",
+        &record_dtype,
+        "Structured type of the records of an object type: PixelHit, PixelCharge or DepositedCharge",
+        py::arg("type"));
+
+    // The framework is run without holding the interpreter lock, callbacks acquire it when called
+    py::class_<Allpix>(m, "Allpix")
+        .def(py::init<std::string, const std::vector<std::string>&, const std::vector<std::string>&>(),
+             py::arg("config_file_name"),
+             py::arg("module_options") = std::vector<std::string>(),
+             py::arg("detector_options") = std::vector<std::string>(),
+             py::call_guard<py::gil_scoped_release>())
+        .def("load", &Allpix::load, py::call_guard<py::gil_scoped_release>())
+        .def("initialize", &Allpix::initialize, py::call_guard<py::gil_scoped_release>())
+        .def("run", &Allpix::run, py::call_guard<py::gil_scoped_release>())
+        .def("run_events",
+             &Allpix::runEvents,
+             "Process the next events, keeping the worker threads and modules for further calls",
+             py::arg("number_of_events"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("finalize", &Allpix::finalize, py::call_guard<py::gil_scoped_release>())
+        .def("terminate", &Allpix::terminate);
+
+    // Release the Python functions while the interpreter is still alive and write all pending log messages
+    py::module_::import("atexit").attr("register")(py::cpp_function([]() {
+        for(const auto& name : python_callbacks) {
+            CallbackRegistry::remove(name);
+        }
+        python_callbacks.clear();
+        Log::finish();
+    }));
+}
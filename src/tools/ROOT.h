@@ -173,14 +173,21 @@ namespace allpix {
          * @brief An easy way to fill a histogram
          */
         template <class... ARGS> Int_t Fill(ARGS&&... args) { // NOLINT
-            return this->Get()->Fill(std::forward<ARGS>(args)...);
+            return this->local()->Fill(std::forward<ARGS>(args)...);
+        }
+
+        /**
+         * @brief An easy way to fill a histogram with an array of values at once
+         */
+        template <class... ARGS> void FillN(ARGS&&... args) { // NOLINT
+            this->local()->FillN(std::forward<ARGS>(args)...);
         }
 
         /**
          * @brief An easy way to set bin contents
          */
         template <class... ARGS> void SetBinContent(ARGS&&... args) { // NOLINT
-            this->Get()->SetBinContent(std::forward<ARGS>(args)...);
+            this->local()->SetBinContent(std::forward<ARGS>(args)...);
         }
 
         /**
@@ -194,12 +201,8 @@ namespace allpix {
          * Based on get in https://root.cern/doc/master/classROOT_1_1TThreadedObject.html, optimized for faster retrieval.
          */
         std::shared_ptr<T> Get() { // NOLINT
-            auto idx = ThreadPool::threadNum();
-            auto& object = objects_[idx];
-            if(!object) {
-                object.reset(ROOT::Internal::TThreadedObjectUtils::Cloner<T>::Clone(model_.get(), directories_[idx]));
-            }
-            return object;
+            this->local();
+            return objects_[ThreadPool::threadNum()];
         }
 
         /**
@@ -218,6 +221,21 @@ namespace allpix {
         }
 
     private:
+        /**
+         * @brief Get the thread local instance of the histogram without sharing its ownership
+         *
+         * Every thread only fills its own copy, which is merged once when writing. Filling therefore only requires a lookup
+         * of the thread local thread number and neither locks nor atomic reference counting.
+         */
+        T* local() {
+            auto idx = ThreadPool::threadNum();
+            auto& object = objects_[idx];
+            if(!object) {
+                object.reset(ROOT::Internal::TThreadedObjectUtils::Cloner<T>::Clone(model_.get(), directories_[idx]));
+            }
+            return object.get();
+        }
+
         /**
          * @brief Initialize the threaded histogram
          *
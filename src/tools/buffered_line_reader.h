@@ -0,0 +1,197 @@
+/**
+ * @file
+ * @brief Utility to read large text files line by line through a block buffer without allocating per line
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_BUFFERED_LINE_READER_H
+#define ALLPIX_BUFFERED_LINE_READER_H
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <istream>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+namespace allpix {
+
+    /**
+     * @brief Reader of text lines from a stream through a large block buffer
+     *
+     * The stream is read in blocks and lines are returned as views into the buffer, such that no memory is allocated while
+     * reading. The buffer only grows if a single line is longer than the block size. The reader keeps track of the offset
+     * of every line in the stream, which allows to index the stream and to continue reading at such an offset later.
+     */
+    class BufferedLineReader {
+    public:
+        /**
+         * @brief Construct the reader
+         * @param stream Stream to read from, has to outlive the reader
+         * @param block_size Number of bytes read from the stream at once
+         */
+        explicit BufferedLineReader(std::istream& stream, size_t block_size = 1 << 20)
+            : stream_(stream), block_size_(block_size), buffer_(block_size) {}
+
+        /**
+         * @brief Read the next line
+         * @param line View of the line without the newline character, valid until the next call to the reader
+         * @return True if the line is terminated by a newline, false if the end of the stream has been reached before
+         */
+        bool getline(std::string_view& line) {
+            line_offset_ = offset_;
+            auto* newline = find_newline();
+            while(newline == nullptr) {
+                if(!fill()) {
+                    // End of the stream, return the remaining characters as unterminated line
+                    line = std::string_view(buffer_.data() + begin_, end_ - begin_);
+                    offset_ += end_ - begin_;
+                    begin_ = end_;
+                    return false;
+                }
+                newline = find_newline();
+            }
+
+            auto length = static_cast<size_t>(newline - (buffer_.data() + begin_));
+            line = std::string_view(buffer_.data() + begin_, length);
+            begin_ += length + 1;
+            offset_ += length + 1;
+            return true;
+        }
+
+        /**
+         * @brief Get the offset of the line returned last
+         * @return Offset of the line from the beginning of the stream
+         */
+        uint64_t lineOffset() const { return line_offset_; }
+
+        /**
+         * @brief Get the offset of the next line
+         * @return Offset of the next line from the beginning of the stream
+         */
+        uint64_t tell() const { return offset_; }
+
+        /**
+         * @brief Continue reading at an offset of the stream
+         * @param offset Offset from the beginning of the stream, usually obtained from \ref tell
+         */
+        void seek(uint64_t offset) {
+            stream_.clear();
+            stream_.seekg(static_cast<std::streamoff>(offset));
+            begin_ = end_ = 0;
+            offset_ = line_offset_ = offset;
+        }
+
+    private:
+        char* find_newline() {
+            return static_cast<char*>(std::memchr(buffer_.data() + begin_, '\n', end_ - begin_));
+        }
+
+        /**
+         * @brief Move the unread characters to the front of the buffer and append a block from the stream
+         * @return True if characters have been read from the stream
+         */
+        bool fill() {
+            std::copy(buffer_.begin() + static_cast<std::ptrdiff_t>(begin_),
+                      buffer_.begin() + static_cast<std::ptrdiff_t>(end_),
+                      buffer_.begin());
+            end_ -= begin_;
+            begin_ = 0;
+            if(buffer_.size() - end_ < block_size_) {
+                buffer_.resize(end_ + block_size_);
+            }
+
+            stream_.read(buffer_.data() + end_, static_cast<std::streamsize>(block_size_));
+            auto count = static_cast<size_t>(stream_.gcount());
+            end_ += count;
+            return count > 0;
+        }
+
+        std::istream& stream_;
+        size_t block_size_;
+        std::vector<char> buffer_;
+        size_t begin_{};
+        size_t end_{};
+        uint64_t offset_{};
+        uint64_t line_offset_{};
+    };
+
+    /**
+     * @brief Tokenizer splitting a line at a delimiter, with whitespace around the tokens removed
+     */
+    class LineTokenizer {
+    public:
+        /**
+         * @brief Construct the tokenizer
+         * @param line Line to split
+         * @param delimiter Character separating the tokens
+         */
+        explicit LineTokenizer(std::string_view line, char delimiter = ',') : line_(line), delimiter_(delimiter) {}
+
+        /**
+         * @brief Get the next token
+         * @return View of the token, empty if the line has no further tokens
+         */
+        std::string_view next() {
+            auto position = line_.find(delimiter_);
+            auto token = line_.substr(0, position);
+            line_ = (position == std::string_view::npos ? std::string_view() : line_.substr(position + 1));
+            return trim(token);
+        }
+
+        /**
+         * @brief Remove whitespace from the beginning and the end of a string
+         * @param str String to trim
+         * @return View of the trimmed string
+         */
+        static std::string_view trim(std::string_view str) {
+            constexpr std::string_view whitespace = " \t\n\r\v";
+            auto begin = str.find_first_not_of(whitespace);
+            if(begin == std::string_view::npos) {
+                return {};
+            }
+            return str.substr(begin, str.find_last_not_of(whitespace) - begin + 1);
+        }
+
+        /**
+         * @brief Parse a number from a token
+         * @param token Token to parse, only its leading number is converted
+         * @return Value of the number, zero if the token does not start with a number
+         *
+         * Integers are converted with std::from_chars. Floating point numbers are converted with std::strtod from a copy on
+         * the stack, since floating point support of std::from_chars is not available on all supported platforms.
+         */
+        template <typename T> static T parse(std::string_view token) {
+            if constexpr(std::is_floating_point<T>::value) {
+                std::array<char, 64> number{};
+                auto length = std::min(token.size(), number.size() - 1);
+                std::memcpy(number.data(), token.data(), length);
+                return static_cast<T>(std::strtod(number.data(), nullptr));
+            } else {
+                // Allow an explicit plus sign as the stream extraction does
+                if(!token.empty() && token.front() == '+') {
+                    token.remove_prefix(1);
+                }
+                T value{};
+                if(std::from_chars(token.data(), token.data() + token.size(), value).ec != std::errc()) {
+                    return T{};
+                }
+                return value;
+            }
+        }
+
+    private:
+        std::string_view line_;
+        char delimiter_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_BUFFERED_LINE_READER_H */
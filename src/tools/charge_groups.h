@@ -0,0 +1,102 @@
+/**
+ * @file
+ * @brief Utility to split deposited charges into groups of charge carriers propagated together
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_CHARGE_GROUPS_H
+#define ALLPIX_CHARGE_GROUPS_H
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "objects/DepositedCharge.hpp"
+#include "objects/exceptions.h"
+
+namespace allpix {
+    /**
+     * @brief Group of charge carriers propagated together, given by the deposit it starts from and its number of carriers
+     */
+    using ChargeGroup = std::pair<const DepositedCharge*, unsigned int>;
+
+    /**
+     * @brief Split deposits into groups of charge carriers to be propagated together
+     * @param deposits Deposits to split into groups
+     * @param charge_per_step Maximum number of charge carriers per group
+     * @param max_groups Maximum number of groups per deposit, enlarging the groups of large deposits, zero for no limit
+     * @param merge_distance Distance within which deposits are merged before splitting them, zero to disable merging
+     * @param unmerged_groups Number of groups the deposits would have been split into without merging or enlarging groups
+     * @return List of charge carrier groups
+     *
+     * Consecutive deposits of the same carrier type and particle are merged as long as they are within the merge distance
+     * of the first deposit of the merged cluster. The merged groups start from the deposit with the largest charge in the
+     * cluster, which is also used to link the propagated charges to the Monte-Carlo history. Without merging and limit on
+     * the number of groups, every deposit is split into groups of the given size and a group with the remaining carriers.
+     */
+    inline std::vector<ChargeGroup> create_charge_groups(const std::vector<const DepositedCharge*>& deposits,
+                                                         unsigned int charge_per_step,
+                                                         unsigned int max_groups,
+                                                         double merge_distance,
+                                                         size_t& unmerged_groups) {
+        struct Cluster {
+            const DepositedCharge* first;
+            const DepositedCharge* largest;
+            unsigned int charge;
+        };
+
+        // Merge deposits into clusters, only the most recent cluster of every carrier type and particle can be extended
+        std::vector<Cluster> clusters;
+        std::map<std::pair<const MCParticle*, CarrierType>, size_t> open_clusters;
+        unmerged_groups = 0;
+        for(const auto* deposit : deposits) {
+            unmerged_groups += (deposit->getCharge() + charge_per_step - 1) / charge_per_step;
+
+            if(merge_distance > 0) {
+                const MCParticle* particle = nullptr;
+                try {
+                    particle = deposit->getMCParticle();
+                } catch(MissingReferenceException&) {
+                    // Deposits without particle are only merged with each other
+                }
+
+                auto key = std::make_pair(particle, deposit->getType());
+                auto open_cluster = open_clusters.find(key);
+                if(open_cluster != open_clusters.end()) {
+                    auto& cluster = clusters[open_cluster->second];
+                    auto distance = deposit->getLocalPosition() - cluster.first->getLocalPosition();
+                    if(distance.Mag2() <= merge_distance * merge_distance) {
+                        cluster.charge += deposit->getCharge();
+                        if(deposit->getCharge() > cluster.largest->getCharge()) {
+                            cluster.largest = deposit;
+                        }
+                        continue;
+                    }
+                }
+                open_clusters[key] = clusters.size();
+            }
+            clusters.push_back({deposit, deposit, deposit->getCharge()});
+        }
+
+        // Split the clusters into groups
+        std::vector<ChargeGroup> groups;
+        for(const auto& cluster : clusters) {
+            auto group_size = charge_per_step;
+            if(max_groups > 0) {
+                group_size = std::max(group_size, (cluster.charge + max_groups - 1) / max_groups);
+            }
+            for(auto charges_remaining = cluster.charge; charges_remaining > 0;) {
+                auto charge = std::min(group_size, charges_remaining);
+                charges_remaining -= charge;
+                groups.emplace_back(cluster.largest, charge);
+            }
+        }
+        return groups;
+    }
+} // namespace allpix
+
+#endif /* ALLPIX_CHARGE_GROUPS_H */
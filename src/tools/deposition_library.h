@@ -0,0 +1,269 @@
+/**
+ * @file
+ * @brief Binary storage of the charge deposits of many events to replay them without simulating or parsing
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_DEPOSITION_LIBRARY_H
+#define ALLPIX_DEPOSITION_LIBRARY_H
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace allpix {
+
+    /**
+     * @brief Deposits and particles of all detectors of one event stored in a deposition library
+     */
+    struct DepositionLibraryEntry {
+        /**
+         * @brief Particle passing through a detector, with positions in local coordinates
+         */
+        struct Particle {
+            std::array<double, 3> start;
+            std::array<double, 3> end;
+            double local_time;
+            double global_time;
+            std::int32_t particle_id;
+            std::int32_t padding;
+        };
+
+        /**
+         * @brief Set of deposited charge carriers, with the position in local coordinates
+         */
+        struct Deposit {
+            std::array<double, 3> position;
+            double local_time;
+            double global_time;
+            std::uint32_t charge;
+            // Carrier type as stored in the CarrierType enumeration
+            std::int32_t type;
+            // Index of the particle causing the deposit, negative if not known
+            std::int32_t particle;
+            std::int32_t padding;
+        };
+
+        /**
+         * @brief Particles and deposits of a single detector
+         */
+        struct Detector {
+            std::string name;
+            std::vector<Particle> particles;
+            std::vector<Deposit> deposits;
+        };
+
+        std::uint64_t event{};
+        std::vector<Detector> detectors;
+    };
+
+    /**
+     * @brief Layout of deposition library files
+     *
+     * A library starts with a header of the magic string followed by the version. Entries are stored one after the other,
+     * particle and deposit records are the plain memory layout of \ref DepositionLibraryEntry::Particle and
+     * \ref DepositionLibraryEntry::Deposit such that they are read as a whole without any parsing. The file ends with an
+     * index holding the number of entries and their offsets, followed by the offset of the index itself. Libraries are
+     * written in the byte order of the machine, they can only be read on machines with the same byte order.
+     */
+    namespace deposition_library {
+        constexpr std::array<char, 8> magic = {'A', 'P', 'D', 'E', 'P', 'L', 'I', 'B'};
+        constexpr std::uint32_t version = 1;
+
+        static_assert(std::is_trivially_copyable<DepositionLibraryEntry::Particle>::value &&
+                          sizeof(DepositionLibraryEntry::Particle) == 72,
+                      "unexpected layout of particle records");
+        static_assert(std::is_trivially_copyable<DepositionLibraryEntry::Deposit>::value &&
+                          sizeof(DepositionLibraryEntry::Deposit) == 56,
+                      "unexpected layout of deposit records");
+    } // namespace deposition_library
+
+    /**
+     * @brief Writer of deposition libraries
+     */
+    class DepositionLibraryOutput {
+    public:
+        /**
+         * @brief Create a new library file
+         * @param file_name Path of the file, an existing file is overwritten
+         * @throws std::runtime_error If the file cannot be created
+         */
+        explicit DepositionLibraryOutput(const std::string& file_name) : file_(file_name, std::ios::binary) {
+            if(!file_.good()) {
+                throw std::runtime_error("cannot create deposition library " + file_name);
+            }
+            file_.write(deposition_library::magic.data(), deposition_library::magic.size());
+            write_value(deposition_library::version);
+        }
+
+        /// @{
+        /**
+         * @brief Copying or moving a writer is not allowed
+         */
+        DepositionLibraryOutput(const DepositionLibraryOutput&) = delete;
+        DepositionLibraryOutput& operator=(const DepositionLibraryOutput&) = delete;
+        /// @}
+
+        /**
+         * @brief Finish the library if it has not been closed explicitly
+         */
+        ~DepositionLibraryOutput() {
+            try {
+                close();
+            } catch(const std::runtime_error&) {
+                // Errors cannot be reported from the destructor, closing explicitly reports them
+            }
+        }
+
+        /**
+         * @brief Append an entry to the library
+         * @param entry Entry to store
+         */
+        void write(const DepositionLibraryEntry& entry) {
+            offsets_.push_back(static_cast<std::uint64_t>(file_.tellp()));
+            write_value(entry.event);
+            write_value(static_cast<std::uint32_t>(entry.detectors.size()));
+            for(const auto& detector : entry.detectors) {
+                write_value(static_cast<std::uint32_t>(detector.name.size()));
+                file_.write(detector.name.data(), static_cast<std::streamsize>(detector.name.size()));
+                write_records(detector.particles);
+                write_records(detector.deposits);
+            }
+        }
+
+        /**
+         * @brief Return the number of entries written
+         * @return Number of entries
+         */
+        size_t size() const { return offsets_.size(); }
+
+        /**
+         * @brief Write the index and close the file
+         * @throws std::runtime_error If writing the library failed
+         */
+        void close() {
+            if(!file_.is_open()) {
+                return;
+            }
+            auto index_offset = static_cast<std::uint64_t>(file_.tellp());
+            write_records(offsets_);
+            write_value(index_offset);
+            file_.close();
+            if(file_.fail()) {
+                throw std::runtime_error("writing the deposition library failed");
+            }
+        }
+
+    private:
+        template <typename T> void write_value(const T& value) {
+            file_.write(reinterpret_cast<const char*>(&value), sizeof(T)); // NOLINT
+        }
+        template <typename T> void write_records(const std::vector<T>& records) {
+            write_value(static_cast<std::uint64_t>(records.size()));
+            file_.write(reinterpret_cast<const char*>(records.data()), // NOLINT
+                        static_cast<std::streamsize>(records.size() * sizeof(T)));
+        }
+
+        std::ofstream file_;
+        std::vector<std::uint64_t> offsets_;
+    };
+
+    /**
+     * @brief Reader of deposition libraries with random access to the entries
+     *
+     * Only the index is read when opening a library, entries are read from the file when they are requested. Reading is not
+     * thread-safe, callers have to serialize the access.
+     */
+    class DepositionLibraryInput {
+    public:
+        /**
+         * @brief Open a library file and read its index
+         * @param file_name Path of the file
+         * @throws std::runtime_error If the file cannot be read or is not a valid deposition library
+         */
+        explicit DepositionLibraryInput(const std::string& file_name) : file_(file_name, std::ios::binary) {
+            if(!file_.good()) {
+                throw std::runtime_error("cannot open deposition library " + file_name);
+            }
+
+            std::array<char, 8> magic{};
+            file_.read(magic.data(), magic.size());
+            if(!file_.good() || magic != deposition_library::magic) {
+                throw std::runtime_error(file_name + " is not a deposition library");
+            }
+            if(read_value<std::uint32_t>() != deposition_library::version) {
+                throw std::runtime_error("deposition library " + file_name + " has an unsupported version");
+            }
+
+            // Read the index from the end of the file
+            file_.seekg(-static_cast<std::streamoff>(sizeof(std::uint64_t)), std::ios::end);
+            auto index_offset = read_value<std::uint64_t>();
+            file_.seekg(static_cast<std::streamoff>(index_offset));
+            offsets_ = read_records<std::uint64_t>();
+            if(!file_.good()) {
+                throw std::runtime_error("deposition library " + file_name + " has no valid index, it might be truncated");
+            }
+        }
+
+        /**
+         * @brief Return the number of entries in the library
+         * @return Number of entries
+         */
+        size_t size() const { return offsets_.size(); }
+
+        /**
+         * @brief Read an entry of the library
+         * @param index Index of the entry, required to be smaller than the number of entries
+         * @return Entry of the library
+         * @throws std::runtime_error If the entry cannot be read
+         */
+        DepositionLibraryEntry read(size_t index) {
+            file_.clear();
+            file_.seekg(static_cast<std::streamoff>(offsets_.at(index)));
+
+            DepositionLibraryEntry entry;
+            entry.event = read_value<std::uint64_t>();
+            entry.detectors.resize(read_value<std::uint32_t>());
+            for(auto& detector : entry.detectors) {
+                detector.name.resize(read_value<std::uint32_t>());
+                file_.read(&detector.name[0], static_cast<std::streamsize>(detector.name.size()));
+                detector.particles = read_records<DepositionLibraryEntry::Particle>();
+                detector.deposits = read_records<DepositionLibraryEntry::Deposit>();
+            }
+            if(!file_.good()) {
+                throw std::runtime_error("cannot read entry " + std::to_string(index) + " of the deposition library");
+            }
+            return entry;
+        }
+
+    private:
+        template <typename T> T read_value() {
+            T value{};
+            file_.read(reinterpret_cast<char*>(&value), sizeof(T)); // NOLINT
+            return value;
+        }
+        template <typename T> std::vector<T> read_records() {
+            auto count = read_value<std::uint64_t>();
+            if(!file_.good()) {
+                return {};
+            }
+            std::vector<T> records(count);
+            file_.read(reinterpret_cast<char*>(records.data()), // NOLINT
+                       static_cast<std::streamsize>(records.size() * sizeof(T)));
+            return records;
+        }
+
+        std::ifstream file_;
+        std::vector<std::uint64_t> offsets_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_DEPOSITION_LIBRARY_H */
@@ -0,0 +1,159 @@
+/**
+ * @file
+ * @brief Index of the events stored in the entries of a data file, for random access to individual events
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_EVENT_INDEX_H
+#define ALLPIX_EVENT_INDEX_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace allpix {
+
+    /**
+     * @brief Entries of the events stored in the trees of a data file, with the number of objects of every tree and event
+     *
+     * The events are sorted by their number. The object counts are stored as one row per event with one column per tree.
+     */
+    struct EventIndex {
+        std::vector<std::string> trees;
+        std::vector<std::uint64_t> events;
+        std::vector<std::uint64_t> entries;
+        std::vector<std::uint32_t> counts;
+
+        /**
+         * @brief Find the position of an event in the index
+         * @param event Number of the event
+         * @return Position of the event, equal to the number of events if the event is not part of the index
+         */
+        size_t find(std::uint64_t event) const {
+            auto iter = std::lower_bound(events.begin(), events.end(), event);
+            if(iter == events.end() || *iter != event) {
+                return events.size();
+            }
+            return static_cast<size_t>(iter - events.begin());
+        }
+
+        /**
+         * @brief Number of objects stored for an event in a tree
+         * @param position Position of the event in the index
+         * @param tree Index of the tree
+         * @return Number of objects
+         */
+        std::uint32_t count(size_t position, size_t tree) const { return counts[position * trees.size() + tree]; }
+    };
+
+    /**
+     * @brief Layout of event index files
+     *
+     * An index starts with a header of the magic string followed by the version and the names of the trees, each stored as
+     * length and characters. The number of events follows, together with the numbers of the events, their entries and the
+     * object counts as plain arrays. Indices are written in the byte order of the machine, they can only be read on machines
+     * with the same byte order.
+     */
+    namespace event_index {
+        constexpr std::array<char, 8> magic = {'A', 'P', 'E', 'V', 'T', 'I', 'D', 'X'};
+        constexpr std::uint32_t version = 1;
+
+        /**
+         * @brief Write an index to file
+         * @param file_name Path of the file, an existing file is overwritten
+         * @param index Index to write
+         * @throws std::runtime_error If the file cannot be written
+         */
+        inline void write(const std::string& file_name, const EventIndex& index) {
+            std::ofstream file(file_name, std::ios::binary);
+            auto write_value = [&file](const auto& value) {
+                file.write(reinterpret_cast<const char*>(&value), sizeof(value)); // NOLINT
+            };
+            auto write_array = [&file](const auto& values) {
+                file.write(reinterpret_cast<const char*>(values.data()), // NOLINT
+                           static_cast<std::streamsize>(values.size() * sizeof(values[0])));
+            };
+
+            file.write(magic.data(), magic.size());
+            write_value(version);
+            write_value(static_cast<std::uint32_t>(index.trees.size()));
+            for(const auto& tree : index.trees) {
+                write_value(static_cast<std::uint32_t>(tree.size()));
+                file.write(tree.data(), static_cast<std::streamsize>(tree.size()));
+            }
+            // The number of events is always written with 64 bits, independent of the width of size_t
+            const std::uint64_t event_count = index.events.size();
+            write_value(event_count);
+            write_array(index.events);
+            write_array(index.entries);
+            write_array(index.counts);
+            if(!file.good()) {
+                throw std::runtime_error("cannot write event index " + file_name);
+            }
+        }
+
+        /**
+         * @brief Read an index from file
+         * @param file_name Path of the file
+         * @return Index stored in the file
+         * @throws std::runtime_error If the file cannot be read or is not a valid event index
+         */
+        inline EventIndex read(const std::string& file_name) {
+            std::ifstream file(file_name, std::ios::binary);
+            if(!file.good()) {
+                throw std::runtime_error("cannot open event index " + file_name);
+            }
+            auto read_value = [&file](auto& value) {
+                file.read(reinterpret_cast<char*>(&value), sizeof(value)); // NOLINT
+            };
+            auto read_array = [&file](auto& values, size_t size) {
+                values.resize(size);
+                file.read(reinterpret_cast<char*>(values.data()), // NOLINT
+                          static_cast<std::streamsize>(values.size() * sizeof(values[0])));
+            };
+
+            std::array<char, 8> file_magic{};
+            file.read(file_magic.data(), file_magic.size());
+            if(!file.good() || file_magic != magic) {
+                throw std::runtime_error(file_name + " is not an event index");
+            }
+            std::uint32_t file_version{};
+            read_value(file_version);
+            if(file_version != version) {
+                throw std::runtime_error("event index " + file_name + " has an unsupported version");
+            }
+
+            EventIndex index;
+            std::uint32_t tree_count{};
+            read_value(tree_count);
+            index.trees.resize(file.good() ? tree_count : 0);
+            for(auto& tree : index.trees) {
+                std::uint32_t length{};
+                read_value(length);
+                tree.resize(file.good() ? length : 0);
+                file.read(&tree[0], static_cast<std::streamsize>(tree.size()));
+            }
+            std::uint64_t event_count{};
+            read_value(event_count);
+            if(!file.good()) {
+                throw std::runtime_error("event index " + file_name + " is truncated");
+            }
+            read_array(index.events, event_count);
+            read_array(index.entries, event_count);
+            read_array(index.counts, event_count * index.trees.size());
+            if(!file.good()) {
+                throw std::runtime_error("event index " + file_name + " is truncated");
+            }
+            return index;
+        }
+    } // namespace event_index
+} // namespace allpix
+
+#endif /* ALLPIX_EVENT_INDEX_H */
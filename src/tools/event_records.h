@@ -0,0 +1,64 @@
+/**
+ * @file
+ * @brief Flat records of the objects passed to event callbacks, viewed without copying from other languages
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_EVENT_RECORDS_H
+#define ALLPIX_EVENT_RECORDS_H
+
+#include <cstdint>
+#include <type_traits>
+
+namespace allpix {
+
+    /**
+     * @brief Layout of the records of every object type, with all values in the framework base units
+     *
+     * The records only hold the values of the objects themselves, relations to other objects are not part of them. Members
+     * are ordered by size such that the records contain no padding between members.
+     */
+    namespace event_records {
+        struct PixelHit {
+            double local_time;
+            double global_time;
+            double signal;
+            std::uint32_t column;
+            std::uint32_t row;
+        };
+
+        struct PixelCharge {
+            double local_time;
+            double global_time;
+            std::int64_t charge;
+            std::uint32_t column;
+            std::uint32_t row;
+        };
+
+        struct DepositedCharge {
+            double local_x;
+            double local_y;
+            double local_z;
+            double global_x;
+            double global_y;
+            double global_z;
+            double local_time;
+            double global_time;
+            std::uint32_t charge;
+            // Sign of the charge carriers, -1 for electrons and +1 for holes
+            std::int32_t type;
+        };
+
+        static_assert(std::is_trivially_copyable<PixelHit>::value && sizeof(PixelHit) == 32,
+                      "unexpected layout of pixel hit records");
+        static_assert(std::is_trivially_copyable<PixelCharge>::value && sizeof(PixelCharge) == 32,
+                      "unexpected layout of pixel charge records");
+        static_assert(std::is_trivially_copyable<DepositedCharge>::value && sizeof(DepositedCharge) == 72,
+                      "unexpected layout of deposited charge records");
+    } // namespace event_records
+} // namespace allpix
+
+#endif /* ALLPIX_EVENT_RECORDS_H */
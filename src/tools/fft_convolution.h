@@ -0,0 +1,179 @@
+/**
+ * @file
+ * @brief Utilities for fast Fourier transforms of sampled signals and their convolution with a fixed kernel
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_FFT_CONVOLUTION_H
+#define ALLPIX_FFT_CONVOLUTION_H
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace allpix {
+
+    /**
+     * @brief Radix-2 fast Fourier transform of a fixed size
+     *
+     * The bit reversal permutation and the roots of unity are precomputed on construction. Transforming is thread-safe.
+     */
+    class FastFourierTransform {
+    public:
+        /**
+         * @brief Construct an empty transform
+         */
+        FastFourierTransform() = default;
+
+        /**
+         * @brief Construct the transform for a number of samples
+         * @param size Number of samples, has to be a power of two
+         */
+        explicit FastFourierTransform(size_t size) : size_(size) {
+            reversed_.resize(size_);
+            for(size_t i = 1, j = 0; i < size_; ++i) {
+                auto bit = size_ >> 1;
+                for(; (j & bit) != 0; bit >>= 1) {
+                    j ^= bit;
+                }
+                j ^= bit;
+                reversed_[i] = j;
+            }
+            roots_.resize(size_ / 2);
+            for(size_t i = 0; i < roots_.size(); ++i) {
+                roots_[i] = std::polar(1.0, -2.0 * M_PI * static_cast<double>(i) / static_cast<double>(size_));
+            }
+        }
+
+        /**
+         * @brief Get the smallest power of two not below a number of samples
+         * @param length Number of samples
+         * @return Size of a transform covering the samples
+         */
+        static size_t sizeFor(size_t length) {
+            size_t size = 1;
+            while(size < length) {
+                size *= 2;
+            }
+            return size;
+        }
+
+        /**
+         * @brief Get the number of samples of the transform
+         * @return Number of samples
+         */
+        size_t size() const { return size_; }
+
+        /**
+         * @brief Unnormalized in-place transform of a full data set
+         * @param data Data to transform, requires the size of the transform
+         * @param inverse If the inverse transform should be calculated instead of the forward transform
+         */
+        void transform(std::vector<std::complex<double>>& data, bool inverse) const {
+            for(size_t i = 1; i < size_; ++i) {
+                if(i < reversed_[i]) {
+                    std::swap(data[i], data[reversed_[i]]);
+                }
+            }
+            for(size_t half = 1; half < size_; half *= 2) {
+                auto stride = size_ / (2 * half);
+                for(size_t start = 0; start < size_; start += 2 * half) {
+                    for(size_t k = 0; k < half; ++k) {
+                        auto root = inverse ? std::conj(roots_[k * stride]) : roots_[k * stride];
+                        auto odd = data[start + k + half] * root;
+                        data[start + k + half] = data[start + k] - odd;
+                        data[start + k] += odd;
+                    }
+                }
+            }
+        }
+
+    private:
+        size_t size_{};
+        std::vector<size_t> reversed_;
+        std::vector<std::complex<double>> roots_;
+    };
+
+    /**
+     * @brief Convolution of signals with a fixed kernel through a radix-2 fast Fourier transform
+     *
+     * The kernel is transformed once on construction. A convolution then only requires the forward transform of the input,
+     * a multiplication with the transformed kernel and the inverse transform, which scales with n log(n) instead of the n^2
+     * of the direct sum. The output is truncated to the length of the kernel, such that only the first samples of the input
+     * contribute. The transform is zero-padded to cover the full linear convolution, no circular wrap-around occurs. Results
+     * agree with the direct sum up to floating point rounding. Convolving is thread-safe.
+     */
+    class FFTConvolution {
+    public:
+        /**
+         * @brief Construct an empty convolution
+         */
+        FFTConvolution() = default;
+
+        /**
+         * @brief Construct the convolution with a kernel
+         * @param kernel Samples of the kernel, also defining the length of the output
+         */
+        explicit FFTConvolution(const std::vector<double>& kernel)
+            : length_(kernel.size()), size_(FastFourierTransform::sizeFor(2 * length_)), fft_(size_) {
+            kernel_.assign(size_, 0.);
+            std::copy(kernel.begin(), kernel.end(), kernel_.begin());
+            fft_.transform(kernel_, false);
+        }
+
+        /**
+         * @brief Get the length of the kernel and the output
+         * @return Number of samples
+         */
+        size_t size() const { return length_; }
+
+        /**
+         * @brief Estimate if the transform is faster than the direct sum for an input
+         * @param input_length Number of samples of the input
+         * @return True if the fast Fourier transform should be preferred
+         */
+        bool isEfficient(size_t input_length) const {
+            auto direct = static_cast<double>(length_) * static_cast<double>(std::min(input_length, length_));
+            // Two transforms and the multiplication, each butterfly costing a few multiply-adds
+            auto transform = 8. * static_cast<double>(size_) * std::log2(static_cast<double>(size_));
+            return direct > transform;
+        }
+
+        /**
+         * @brief Convolve an input with the kernel
+         * @param input Samples of the input signal
+         * @return Convolved signal with the length of the kernel
+         */
+        std::vector<double> convolve(const std::vector<double>& input) const {
+            std::vector<std::complex<double>> data(size_);
+            auto input_length = std::min(input.size(), length_);
+            std::copy(input.begin(), input.begin() + static_cast<std::ptrdiff_t>(input_length), data.begin());
+            fft_.transform(data, false);
+            for(size_t i = 0; i < size_; ++i) {
+                data[i] *= kernel_[i];
+            }
+            fft_.transform(data, true);
+
+            std::vector<double> output(length_);
+            auto normalization = 1. / static_cast<double>(size_);
+            for(size_t i = 0; i < length_; ++i) {
+                output[i] = data[i].real() * normalization;
+            }
+            return output;
+        }
+
+    private:
+        size_t length_{};
+        size_t size_{};
+        FastFourierTransform fft_;
+        std::vector<std::complex<double>> kernel_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_FFT_CONVOLUTION_H */
@@ -11,12 +11,38 @@
 #define ALLPIX_FIELD_PARSER_H
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cerrno>
 #include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
 #include <fstream>
+#include <future>
 #include <iostream>
+#include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "core/utils/log.h"
+#include "core/utils/profiling.h"
 #include "core/utils/unit.h"
 
 #include <cereal/archives/portable_binary.hpp>
@@ -28,7 +54,9 @@
 #include <utility>
 
 // Mime type version for APF files
-#define APF_MIME_TYPE_VERSION 1
+#define APF_MIME_TYPE_VERSION 2
+// Layout version for APF files with raw payload
+#define APF_RAW_LAYOUT_VERSION 3
 
 namespace allpix {
 
@@ -48,13 +76,44 @@ namespace allpix {
         UNKNOWN = 0, ///< Unknown file format
         INIT,        ///< Legacy file format, values stored in plain-text ASCII
         APF,         ///< Binary Allpix Squared format serialized using the cereal library
+        APF_RAW,     ///< Binary Allpix Squared format (version 2) with a raw, page-aligned payload for memory mapping
+    };
+
+    /**
+     * @brief Fixed-size header of APF files with raw payload
+     *
+     * The header is followed by the human readable header string, the bin edges in z for fields with non-uniform binning
+     * and the field data. The field data is stored as native doubles starting at payload_offset, which is aligned to the
+     * page size such that the data can be mapped into memory directly. The byte order marker allows to detect files written
+     * on machines with different endianness. Files of layout version 2 end the header before the number of bin edges.
+     */
+    struct APFRawHeader {
+        char magic[8];                   ///< Magic bytes identifying the file layout
+        std::uint32_t byte_order;        ///< Byte order marker
+        std::uint32_t version;           ///< Layout version
+        std::uint64_t components;        ///< Number of components per field point
+        std::uint64_t dimensions[3];     ///< Number of bins of the field in each coordinate
+        double size[3];                  ///< Physical extent of the field in each dimension, given in internal units
+        std::uint64_t header_length;     ///< Length of the human readable header string
+        std::uint64_t payload_offset;    ///< Offset of the field data from the beginning of the file
+        std::uint64_t payload_entries;   ///< Number of field data entries
+        std::uint64_t z_edges;           ///< Number of bin edges in z following the header string, zero for uniform bins
     };
 
+    // Magic bytes and constants of APF files with raw payload
+    static constexpr char apf_raw_magic[8] = {'A', 'P', 'F', 'R', 'A', 'W', '\0', '\0'};
+    static constexpr std::uint32_t apf_raw_byte_order = 0x01020304;
+    static constexpr std::uint64_t apf_raw_alignment = 65536;
+
+    // Number of field entries read or written at once when streaming field data between files
+    static constexpr size_t field_slice_entries = size_t(1) << 20;
+
     /**
      * Class to hold raw, three-dimensional field data with N components, containing
      * * The actual field data as shared pointer to vector
      * * An array specifying the number of bins in each dimension
      * * An array containing the physical extent of the field in each dimension, as specified in the file
+     * * Optionally the edges of the bins in z for fields with non-uniform binning along the thickness
      */
     template <typename T = double> class FieldData {
     public:
@@ -69,12 +128,35 @@ namespace allpix {
          * @param dimensions Number of bins of the field in each coordinate
          * @param size       Physical extent of the field in each dimension, given in internal units
          * @param data       Shared pointer to the flat field data
+         * @param z_edges    Edges of the bins in z, from zero to the size in z, or empty for uniform binning
+         */
+        FieldData(std::string header,
+                  std::array<size_t, 3> dimensions,
+                  std::array<T, 3> size,
+                  std::shared_ptr<std::vector<T>> data,
+                  std::vector<T> z_edges = {})
+            : header_(std::move(header)), dimensions_(dimensions), size_(size), z_edges_(std::move(z_edges)),
+              data_(std::move(data)) {
+            update_raw_data();
+        };
+
+        /**
+         * @brief Constructor for field data not held in a vector, e.g. mapped directly from a file
+         * @param header     Human readable header string to identify file content, program version used for generation etc.
+         * @param dimensions Number of bins of the field in each coordinate
+         * @param size       Physical extent of the field in each dimension, given in internal units
+         * @param raw_data   Shared pointer to the first element of the flat field data, owning the underlying storage
+         * @param entries    Number of entries of the flat field data
+         * @param z_edges    Edges of the bins in z, from zero to the size in z, or empty for uniform binning
          */
         FieldData(std::string header,
                   std::array<size_t, 3> dimensions,
                   std::array<T, 3> size,
-                  std::shared_ptr<std::vector<T>> data)
-            : header_(std::move(header)), dimensions_(dimensions), size_(size), data_(std::move(data)){};
+                  std::shared_ptr<const T> raw_data,
+                  size_t entries,
+                  std::vector<T> z_edges = {})
+            : header_(std::move(header)), dimensions_(dimensions), size_(size), z_edges_(std::move(z_edges)),
+              raw_data_(std::move(raw_data)), entries_(entries){};
 
         /**
          * @brief Function to obtain the header (human readbale content description) of the field data
@@ -95,11 +177,29 @@ namespace allpix {
         std::array<T, 3> getSize() const { return size_; }
 
         /**
-         * @brief Member to access the actual field data
-         * @return shared pointer to the flat vector of field data
+         * @brief Member to get the edges of the bins in z for fields with non-uniform binning along the thickness
+         * @return vector with the number of bins in z plus one edges from zero to the size in z, empty for uniform binning
+         */
+        const std::vector<T>& getZEdges() const { return z_edges_; }
+
+        /**
+         * @brief Member to access the actual field data held in memory
+         * @return shared pointer to the flat vector of field data, empty for field data mapped from a file
          */
         std::shared_ptr<std::vector<T>> getData() const { return data_; }
 
+        /**
+         * @brief Member to access the actual field data independent of its storage
+         * @return shared pointer to the first element of the flat field data
+         */
+        std::shared_ptr<const T> getRawData() const { return raw_data_; }
+
+        /**
+         * @brief Member to get the number of entries of the flat field data
+         * @return number of entries
+         */
+        size_t getEntries() const { return entries_; }
+
         /**
          * @brief get the dimensionality of the configured field in the x-y plane, e.g whether it is defined in 1D, 2D or 3D.
          * @return Dimensionality of the field
@@ -112,17 +212,28 @@ namespace allpix {
         }
 
     private:
+        /**
+         * @brief Point the raw data to the vector holding the field data
+         */
+        void update_raw_data() {
+            raw_data_ = (data_ ? std::shared_ptr<const T>(data_, data_->data()) : nullptr);
+            entries_ = (data_ ? data_->size() : 0);
+        }
+
         std::string header_;
         std::array<size_t, 3> dimensions_{};
         std::array<T, 3> size_{};
+        std::vector<T> z_edges_;
         std::shared_ptr<std::vector<T>> data_;
+        std::shared_ptr<const T> raw_data_;
+        size_t entries_{};
 
         friend class cereal::access;
 
         // Versioned serialization function:
         template <class Archive> void serialize(Archive& archive, std::uint32_t const version) {
-            // For now, we only know one version of this file type:
-            if(version != 1) {
+            // Version 2 adds the bin edges in z:
+            if(version != 1 && version != 2) {
                 throw std::runtime_error("unknown format version " + std::to_string(version));
             }
 
@@ -131,6 +242,10 @@ namespace allpix {
             archive(dimensions_);
             archive(size_);
             archive(data_);
+            if(version >= 2) {
+                archive(z_edges_);
+            }
+            update_raw_data();
         }
     };
 } // namespace allpix
@@ -154,12 +269,107 @@ namespace cereal {
 
 namespace allpix {
 
+    /**
+     * @brief Describe field data in the header of the layout of APF files with raw payload
+     * @param field_data Field data object describing the field
+     * @param components Number of components per field point
+     * @return Header of the layout, with the payload aligned after the header string and the bin edges in z
+     */
+    template <typename T> APFRawHeader make_apf_raw_header(const FieldData<T>& field_data, size_t components) {
+        auto dimensions = field_data.getDimensions();
+        auto size = field_data.getSize();
+
+        APFRawHeader header{};
+        std::memcpy(header.magic, apf_raw_magic, sizeof(header.magic));
+        header.byte_order = apf_raw_byte_order;
+        header.version = APF_RAW_LAYOUT_VERSION;
+        header.components = components;
+        for(size_t i = 0; i < 3; ++i) {
+            header.dimensions[i] = dimensions[i];
+            header.size[i] = size[i];
+        }
+        header.header_length = field_data.getHeader().size();
+        header.z_edges = field_data.getZEdges().size();
+        auto edges_end = sizeof(header) + header.header_length + header.z_edges * sizeof(T);
+        header.payload_offset = (edges_end + apf_raw_alignment - 1) / apf_raw_alignment * apf_raw_alignment;
+        header.payload_entries = field_data.getEntries();
+        return header;
+    }
+
+    /**
+     * @brief Reduce a field which is mirror-symmetric around the center of the x and/or y axis to its upper half
+     * @param field_data Field data covering the full extent along the mirrored axes
+     * @param mirror     Axes, x and y, along which the field is mirror-symmetric
+     * @param tolerance  Maximum deviation between mirrored values, relative to the largest absolute value of the field
+     * @return Field data holding only the bins above the center of the mirrored axes, with half the size along them
+     * @throws std::invalid_argument If a mirrored axis has an odd number of bins or the field is not symmetric
+     *
+     * For vector fields the component along a mirrored axis changes its sign under the reflection, the remaining components
+     * are expected to be equal on both sides.
+     */
+    template <typename T>
+    FieldData<T> reduce_mirrored_field(const FieldData<T>& field_data, std::array<bool, 2> mirror, T tolerance) {
+        auto dimensions = field_data.getDimensions();
+        auto size = field_data.getSize();
+        auto bins = dimensions[0] * dimensions[1] * dimensions[2];
+        auto components = field_data.getEntries() / bins;
+        const T* data = field_data.getRawData().get();
+
+        std::array<size_t, 3> reduced_dimensions = dimensions;
+        std::array<T, 3> reduced_size = size;
+        for(size_t axis = 0; axis < 2; ++axis) {
+            if(!mirror[axis]) {
+                continue;
+            }
+            if(dimensions[axis] % 2 != 0) {
+                throw std::invalid_argument("field cannot be mirrored along an axis with an odd number of bins");
+            }
+            reduced_dimensions[axis] = dimensions[axis] / 2;
+            reduced_size[axis] = size[axis] / 2;
+        }
+
+        T max_value = 0;
+        for(size_t i = 0; i < field_data.getEntries(); ++i) {
+            max_value = std::max(max_value, std::abs(data[i]));
+        }
+
+        auto reduced = std::make_shared<std::vector<T>>();
+        reduced->reserve(reduced_dimensions[0] * reduced_dimensions[1] * dimensions[2] * components);
+        for(size_t x = 0; x < dimensions[0]; ++x) {
+            for(size_t y = 0; y < dimensions[1]; ++y) {
+                // Bin mirrored to the current one, compared from the lower half of the mirrored axes
+                auto mx = (mirror[0] ? dimensions[0] - 1 - x : x);
+                auto my = (mirror[1] ? dimensions[1] - 1 - y : y);
+                auto keep = (!mirror[0] || x >= reduced_dimensions[0]) && (!mirror[1] || y >= reduced_dimensions[1]);
+                for(size_t z = 0; z < dimensions[2]; ++z) {
+                    for(size_t c = 0; c < components; ++c) {
+                        auto value = data[((x * dimensions[1] + y) * dimensions[2] + z) * components + c];
+                        auto mirrored = data[((mx * dimensions[1] + my) * dimensions[2] + z) * components + c];
+                        if(components == 3 && c < 2 && mirror[c]) {
+                            mirrored = -mirrored;
+                        }
+                        if(std::abs(value - mirrored) > tolerance * max_value) {
+                            throw std::invalid_argument("field is not mirror-symmetric at bin (" + std::to_string(x) +
+                                                        "," + std::to_string(y) + "," + std::to_string(z) + ")");
+                        }
+                        if(keep) {
+                            reduced->push_back(value);
+                        }
+                    }
+                }
+            }
+        }
+
+        return FieldData<T>(field_data.getHeader(), reduced_dimensions, reduced_size, reduced, field_data.getZEdges());
+    }
+
     /**
      * @brief Class to parse Allpix Squared field data from files
      *
      * This class can be used to deserialize and parse FieldData objects from files of different format. The FieldData
      * objects read from file are cached, and a cache hit will be returned when trying to re-read a file with the same
-     * canonical path.
+     * canonical path. The cache does not own the field data, such that the memory is released once no user of the data is
+     * left, e.g. when only a converted copy of the field is kept. Such a file is read again when requested later.
      */
     template <typename T = double> class FieldParser {
     public:
@@ -178,21 +388,222 @@ namespace allpix {
          * @brief Parse a file and retrieve the field data.
          * @param file_name  File name (as canonical path) of the input file to be parsed
          * @param units      Optional units to convert the field from after reading from file. Only used by some formats.
+         * @param shared     Share the field data with other processes on the same machine through shared memory
          * @return           Field data object read from file or internal cache
          *
-         * The type of the field data file to be read is deducted automatically from the file content
+         * The type of the field data file to be read is deducted automatically from the file content. Shared field data is
+         * looked up by the content of the file, the units and the field quantity in the shared memory segments published by
+         * other processes and mapped read-only if found. Otherwise the file is read and its data published for other
+         * processes. The segments remain available until they are removed explicitly or the machine is restarted.
          */
-        FieldData<T> getByFileName(const std::string& file_name, const std::string& units = std::string()) {
-            // Search in cache (NOTE: the path reached here is always a canonical name)
-            auto iter = field_map_.find(file_name);
-            if(iter != field_map_.end()) {
+        FieldData<T> getByFileName(const std::string& file_name,
+                                   const std::string& units = std::string(),
+                                   bool shared = false) {
+            // Search in cache (NOTE: the path reached here is always a canonical name), otherwise claim reading the file
+            std::shared_future<FieldData<T>> pending;
+            std::promise<FieldData<T>> promise;
+            {
+                std::lock_guard<std::mutex> lock{mutex_};
+                auto& entry = field_map_[file_name];
+                auto data = entry.data.lock();
+                if(entry.pending.valid()) {
+                    pending = entry.pending;
+                } else if(data != nullptr) {
+                    LOG(INFO) << "Using cached field data";
+                    return FieldData<T>(entry.header, entry.dimensions, entry.size, data, entry.entries, entry.z_edges);
+                } else {
+                    entry.pending = promise.get_future().share();
+                }
+            }
+            if(pending.valid()) {
                 LOG(INFO) << "Using cached field data";
-                return iter->second;
+                return pending.get();
+            }
+
+            // Read the file outside of the lock, such that different files can be read concurrently
+            try {
+                auto field_data = (shared ? read_shared(file_name, units) : read_file(file_name, units));
+                {
+                    std::lock_guard<std::mutex> lock{mutex_};
+                    auto& entry = field_map_[file_name];
+                    entry.pending = {};
+                    entry.header = field_data.getHeader();
+                    entry.dimensions = field_data.getDimensions();
+                    entry.size = field_data.getSize();
+                    entry.z_edges = field_data.getZEdges();
+                    entry.data = field_data.getRawData();
+                    entry.entries = field_data.getEntries();
+                }
+                promise.set_value(field_data);
+                return field_data;
+            } catch(...) {
+                {
+                    std::lock_guard<std::mutex> lock{mutex_};
+                    field_map_.erase(file_name);
+                }
+                promise.set_exception(std::current_exception());
+                throw;
+            }
+        }
+
+        /**
+         * @brief Get the format of a field data file
+         * @param file_name  File name of the field data file
+         * @return           Type of the file deduced from its content
+         */
+        FileType getFileType(const std::string& file_name) const { return guess_file_type(file_name); }
+
+        /**
+         * @brief Read the description of a field from a file without reading the field data
+         * @param file_name  File name of the input file
+         * @param units      Optional units to convert the field from after reading from file. Only used by some formats.
+         * @return           Field data object without data, holding the header, the binning and the number of entries
+         *
+         * The field quantity of INIT files is only checked against the first line of field data if this line holds the
+         * values of either a scalar or a vector field point.
+         */
+        FieldData<T> readHeader(const std::string& file_name, const std::string& units = std::string()) {
+            switch(guess_file_type(file_name)) {
+            case FileType::INIT: {
+                auto mapped_file = map_file(file_name);
+                const auto* cursor = mapped_file.first.get();
+                return read_init_header(cursor, cursor + mapped_file.second, units, true);
+            }
+            case FileType::APF: {
+                std::ifstream file(file_name, std::ios::binary);
+                try {
+                    cereal::PortableBinaryInputArchive archive(file);
+                    return read_apf_header(file, archive);
+                } catch(cereal::Exception& e) {
+                    throw std::runtime_error(e.what());
+                }
+            }
+            case FileType::APF_RAW: {
+                auto field_data = map_apf_raw_file(file_name);
+                return FieldData<T>(field_data.getHeader(),
+                                    field_data.getDimensions(),
+                                    field_data.getSize(),
+                                    std::shared_ptr<const T>(),
+                                    field_data.getEntries(),
+                                    field_data.getZEdges());
+            }
+            default:
+                throw std::runtime_error("unknown file format");
+            }
+        }
+
+        /**
+         * @brief Read consecutive entries of the field data from an APF file without reading the full field
+         * @param file_name  File name of the input file
+         * @param first      Index of the first entry to read
+         * @param count      Number of entries to read
+         * @param values     Storage for the entries read
+         *
+         * INIT files do not store the field points in order, they can only be read completely with \ref readValues.
+         */
+        void readEntries(const std::string& file_name, size_t first, size_t count, T* values) {
+            readStridedEntries(file_name, first, count, count, 1, values);
+        }
+
+        /**
+         * @brief Read equally spaced blocks of consecutive entries of the field data from an APF file
+         * @param file_name  File name of the input file
+         * @param first      Index of the first entry of the first block
+         * @param count      Number of consecutive entries in every block
+         * @param stride     Distance between the first entries of consecutive blocks
+         * @param blocks     Number of blocks to read
+         * @param values     Storage for the blocks * count entries read, one block after the other
+         *
+         * The file is opened once for all blocks, such that for example a slice of the field perpendicular to any axis can
+         * be read without reading the remaining field data. Files with raw payload are mapped into memory and only the
+         * pages holding the blocks are read.
+         */
+        void readStridedEntries(
+            const std::string& file_name, size_t first, size_t count, size_t stride, size_t blocks, T* values) {
+            auto check_range = [&](size_t entries) {
+                if(blocks > 0 && first + (blocks - 1) * stride + count > entries) {
+                    throw std::runtime_error("entries outside of the field data");
+                }
+            };
+
+            switch(guess_file_type(file_name)) {
+            case FileType::APF: {
+                std::ifstream file(file_name, std::ios::binary);
+                try {
+                    cereal::PortableBinaryInputArchive archive(file);
+                    auto field_data = read_apf_header(file, archive);
+                    check_range(field_data.getEntries());
+                    auto data_begin = file.tellg();
+                    for(size_t block = 0; block < blocks; ++block) {
+                        file.seekg(data_begin + static_cast<std::streamoff>((first + block * stride) * sizeof(T)));
+                        archive(cereal::binary_data(values + block * count, count * sizeof(T)));
+                    }
+                } catch(cereal::Exception& e) {
+                    throw std::runtime_error(e.what());
+                }
+                break;
+            }
+            case FileType::APF_RAW: {
+                auto field_data = map_apf_raw_file(file_name);
+                check_range(field_data.getEntries());
+                const auto* data = field_data.getRawData().get();
+                for(size_t block = 0; block < blocks; ++block) {
+                    std::memcpy(values + block * count, data + first + block * stride, count * sizeof(T));
+                }
+                break;
+            }
+            case FileType::INIT:
+                throw std::runtime_error("entries of INIT files cannot be read separately");
+            default:
+                throw std::runtime_error("unknown file format");
+            }
+        }
+
+        /**
+         * @brief Read all values of the field data from a file, handing them to a function instead of storing them
+         * @param file_name  File name of the input file
+         * @param units      Optional units to convert the field from after reading from file. Only used by some formats.
+         * @param store      Function called as store(index, value) for every entry of the field data
+         *
+         * The memory used does not depend on the size of the field. INIT files are parsed concurrently, such that the
+         * function is called from several threads at once, but never twice for the same index.
+         */
+        template <typename F> void readValues(const std::string& file_name, const std::string& units, F&& store) {
+            if(guess_file_type(file_name) == FileType::INIT) {
+                auto mapped_file = map_file(file_name);
+                const auto* cursor = mapped_file.first.get();
+                const auto* end = cursor + mapped_file.second;
+                auto field_data = read_init_header(cursor, end, units, false);
+                parse_init_values(cursor, end, field_data.getDimensions(), units, store);
+                return;
+            }
+
+            auto entries = readHeader(file_name).getEntries();
+            std::vector<T> values(std::min(entries, field_slice_entries));
+            for(size_t first = 0; first < entries; first += values.size()) {
+                auto count = std::min(values.size(), entries - first);
+                readEntries(file_name, first, count, values.data());
+                for(size_t i = 0; i < count; ++i) {
+                    store(first + i, values[i]);
+                }
             }
+        }
+
+    private:
+        /**
+         * @brief Read the field data from a file of the format deduced from its content
+         * @param file_name  File name (as canonical path) of the input file to be parsed
+         * @param units      Optional units to convert the field from after reading from file. Only used by some formats.
+         * @return           Field data object read from file
+         */
+        FieldData<T> read_file(const std::string& file_name, const std::string& units) {
+            ALLPIX_PROFILE_ZONE_NAMED("FieldParser::readFile", file_name);
 
             // Deduce the file format
             auto file_type = guess_file_type(file_name);
-            LOG(DEBUG) << "Assuming file type \"" << (file_type == FileType::APF ? "APF" : "INIT") << "\"";
+            LOG(DEBUG) << "Assuming file type \""
+                       << (file_type == FileType::APF ? "APF" : (file_type == FileType::APF_RAW ? "APF (raw)" : "INIT"))
+                       << "\"";
 
             switch(file_type) {
             case FileType::INIT:
@@ -206,12 +617,128 @@ namespace allpix {
                     LOG(DEBUG) << "Units will be ignored, APF file content is interpreted in internal units.";
                 }
                 return parse_apf_file(file_name);
+            case FileType::APF_RAW:
+                if(!units.empty()) {
+                    LOG(DEBUG) << "Units will be ignored, APF file content is interpreted in internal units.";
+                }
+                return map_apf_raw_file(file_name);
             default:
                 throw std::runtime_error("unknown file format");
             }
         }
 
-    private:
+        /**
+         * @brief Name of the shared memory segment holding the field data of a file
+         * @param file_name  File name of the input file
+         * @param units      Units the field is converted from
+         * @return           Segment name derived from the hash of the file content, the units and the field quantity
+         */
+        std::string shared_memory_name(const std::string& file_name, const std::string& units) const {
+            auto mapped_file = map_file(file_name);
+            auto hash = std::hash<std::string_view>()(std::string_view(mapped_file.first.get(), mapped_file.second));
+            auto combine = [&hash](size_t value) { hash ^= value + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2); };
+            combine(mapped_file.second);
+            combine(std::hash<std::string>()(units));
+            combine(N_);
+            combine(sizeof(T));
+
+            std::stringstream name;
+            name << "/allpix_field_" << std::hex << hash;
+            return name.str();
+        }
+
+        /**
+         * @brief Read the field data from the shared memory of another process, or from file publishing it for others
+         * @param file_name  File name (as canonical path) of the input file to be parsed
+         * @param units      Optional units to convert the field from after reading from file. Only used by some formats.
+         * @return           Field data object mapped from shared memory, or read from file if it cannot be shared
+         *
+         * Files with raw payload are mapped directly, their pages are shared through the file system cache. Segments are
+         * only used if they are owned by the user of this process and have been written completely.
+         */
+        FieldData<T> read_shared(const std::string& file_name, const std::string& units) {
+            if(guess_file_type(file_name) == FileType::APF_RAW) {
+                return read_file(file_name, units);
+            }
+
+            auto name = shared_memory_name(file_name, units);
+            int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+            if(fd >= 0) {
+                struct stat segment_stat {};
+                if(::fstat(fd, &segment_stat) != 0 || segment_stat.st_uid != ::geteuid()) {
+                    ::close(fd);
+                    LOG(WARNING) << "Shared memory segment " << name << " is owned by another user, reading field data";
+                    return read_file(file_name, units);
+                }
+                try {
+                    auto field_data = parse_apf_raw(map_descriptor(fd));
+                    LOG(INFO) << "Mapped field data from shared memory segment " << name;
+                    return field_data;
+                } catch(std::runtime_error& e) {
+                    LOG(WARNING) << "Shared memory segment " << name << " cannot be used (" << e.what()
+                                 << "), reading field data";
+                    return read_file(file_name, units);
+                }
+            }
+
+            auto field_data = read_file(file_name, units);
+            try {
+                publish_shared(name, field_data);
+                LOG(INFO) << "Published field data in shared memory segment " << name;
+                // Use the shared copy, such that the memory of the field read from file is released
+                fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+                if(fd < 0) {
+                    throw std::runtime_error("segment removed by another process");
+                }
+                return parse_apf_raw(map_descriptor(fd));
+            } catch(std::runtime_error& e) {
+                LOG(WARNING) << "Field data cannot be published in shared memory (" << e.what() << ")";
+            }
+            return field_data;
+        }
+
+        /**
+         * @brief Write field data to a new shared memory segment in the layout of APF files with raw payload
+         * @param name       Name of the segment
+         * @param field_data Field data object to publish
+         *
+         * The magic bytes are written last, such that other processes only use the segment once it is complete. A segment
+         * created concurrently by another process is left untouched.
+         */
+        void publish_shared(const std::string& name, const FieldData<T>& field_data) const {
+            int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+            if(fd < 0) {
+                throw std::runtime_error(errno == EEXIST ? "segment created by another process"
+                                                         : "could not create segment");
+            }
+
+            auto header = make_apf_raw_header(field_data, N_);
+            auto length = static_cast<size_t>(header.payload_offset + header.payload_entries * sizeof(T));
+            void* mapping = MAP_FAILED;
+            if(::ftruncate(fd, static_cast<off_t>(length)) == 0) {
+                mapping = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            ::close(fd);
+            if(mapping == MAP_FAILED) {
+                ::shm_unlink(name.c_str());
+                throw std::runtime_error("could not map segment into memory");
+            }
+
+            auto* memory = static_cast<char*>(mapping);
+            const auto& header_string = field_data.getHeader();
+            const auto& z_edges = field_data.getZEdges();
+            std::memcpy(memory + sizeof(header), header_string.data(), header_string.size());
+            std::memcpy(memory + sizeof(header) + header_string.size(), z_edges.data(), z_edges.size() * sizeof(T));
+            std::memcpy(memory + header.payload_offset, field_data.getRawData().get(), header.payload_entries * sizeof(T));
+
+            // Mark the segment as complete by its magic bytes
+            std::memcpy(memory + sizeof(header.magic), reinterpret_cast<const char*>(&header) + sizeof(header.magic),
+                        sizeof(header) - sizeof(header.magic));
+            std::atomic_thread_fence(std::memory_order_release);
+            std::memcpy(memory, header.magic, sizeof(header.magic));
+            ::munmap(mapping, length);
+        }
+
         /**
          * @brief Check if the file is a binary file
          * @param path The path to the file to be checked check
@@ -230,17 +757,179 @@ namespace allpix {
             return false;
         }
 
+        /**
+         * @brief Check if the file starts with the magic bytes of APF files with raw payload
+         * @param path The path to the file to be checked check
+         * @return True if the magic bytes are found, false otherwise
+         */
+        bool file_is_apf_raw(const std::string& path) const {
+            std::ifstream file(path, std::ios::binary);
+            char magic[sizeof(apf_raw_magic)] = {};
+            file.read(magic, sizeof(magic));
+            return file.good() && std::memcmp(magic, apf_raw_magic, sizeof(magic)) == 0;
+        }
+
         /**
          * @brief Function to guess the type of a field data file
          * @param path Path to the file to be tested
          * @return Type of the file
          *
-         * This function checks if the file contains binary data to interpret it as APF formator INIT format otherwise.
+         * This function checks if the file contains binary data to interpret it as APF formator INIT format otherwise. APF
+         * files with raw payload are identified by their magic bytes.
          */
         FileType guess_file_type(const std::string& path) const {
+            if(file_is_apf_raw(path)) {
+                return FileType::APF_RAW;
+            }
             return (file_is_binary(path) ? FileType::APF : FileType::INIT);
         }
 
+        /**
+         * @brief Map a file read-only into memory
+         * @param file_name  File name of the file to be mapped
+         * @return           Mapped memory, which unmaps the file once released, and the length of the file
+         */
+        static std::pair<std::shared_ptr<const char>, size_t> map_file(const std::string& file_name) {
+            int fd = ::open(file_name.c_str(), O_RDONLY);
+            if(fd < 0) {
+                throw std::runtime_error("could not open file");
+            }
+            return map_descriptor(fd);
+        }
+
+        /**
+         * @brief Map an open file or shared memory segment read-only into memory and close its descriptor
+         * @param fd         Descriptor of the file, opened for reading
+         * @return           Mapped memory, which unmaps the file once released, and the length of the file
+         */
+        static std::pair<std::shared_ptr<const char>, size_t> map_descriptor(int fd) {
+            struct stat file_stat {};
+            if(::fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+                ::close(fd);
+                throw std::runtime_error("invalid data or unexpected end of file");
+            }
+            auto length = static_cast<size_t>(file_stat.st_size);
+            void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+            // The mapping stays valid after closing the file descriptor
+            ::close(fd);
+            if(mapping == MAP_FAILED) {
+                throw std::runtime_error("could not map file into memory");
+            }
+            return {std::shared_ptr<const char>(static_cast<const char*>(mapping),
+                                                 [length](const char* ptr) { ::munmap(const_cast<char*>(ptr), length); }),
+                    length};
+        }
+
+        /**
+         * @brief Function to map FieldData from an APF file with raw payload read-only into memory. No data is copied, the
+         * pages are shared with all other processes mapping the same file. As for all APF files, the values are given in
+         * framework-internal base units.
+         * @param file_name  File name (as canonical path) of the input file to be mapped
+         */
+        FieldData<T> map_apf_raw_file(const std::string& file_name) { return parse_apf_raw(map_file(file_name)); }
+
+        /**
+         * @brief Function to interpret memory holding the layout of APF files with raw payload as FieldData, without
+         * copying the field data
+         * @param mapped_file Mapped memory of the file or shared memory segment and its length
+         */
+        FieldData<T> parse_apf_raw(const std::pair<std::shared_ptr<const char>, size_t>& mapped_file) {
+            static_assert(std::is_same<T, double>::value, "APF files with raw payload only store double precision values");
+
+            const auto& [memory, length] = mapped_file;
+            if(length < sizeof(APFRawHeader)) {
+                throw std::runtime_error("invalid data or unexpected end of file");
+            }
+
+            // Check the header, files of the previous layout version end before the number of bin edges in z
+            APFRawHeader header{};
+            std::memcpy(&header, memory.get(), std::min(sizeof(header), length));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(std::memcmp(header.magic, apf_raw_magic, sizeof(header.magic)) != 0) {
+                throw std::runtime_error("invalid data or incomplete file");
+            }
+            if(header.byte_order != apf_raw_byte_order) {
+                throw std::runtime_error("file written with different byte order");
+            }
+            if(header.version != APF_RAW_LAYOUT_VERSION && header.version != 2) {
+                throw std::runtime_error("unknown format version " + std::to_string(header.version));
+            }
+            auto header_size = sizeof(header);
+            if(header.version == 2) {
+                header_size = offsetof(APFRawHeader, z_edges);
+                header.z_edges = 0;
+            }
+            if(header.components != N_) {
+                throw std::runtime_error("invalid field quantity");
+            }
+            auto edges_offset = header_size + header.header_length;
+            if(header.payload_entries != header.dimensions[0] * header.dimensions[1] * header.dimensions[2] * N_ ||
+               (header.z_edges != 0 && header.z_edges != header.dimensions[2] + 1) ||
+               header.payload_offset % alignof(T) != 0 ||
+               edges_offset + header.z_edges * sizeof(T) > header.payload_offset ||
+               header.payload_offset + header.payload_entries * sizeof(T) > length) {
+                throw std::runtime_error("invalid data");
+            }
+
+            std::string header_string(memory.get() + header_size, header.header_length);
+            std::vector<T> z_edges(header.z_edges);
+            std::memcpy(z_edges.data(), memory.get() + edges_offset, z_edges.size() * sizeof(T));
+            std::shared_ptr<const T> data(memory, reinterpret_cast<const T*>(memory.get() + header.payload_offset));
+            LOG(DEBUG) << "Mapped " << header.payload_entries << " field entries from file into memory";
+
+            FieldData<T> field_data(header_string,
+                                    {{header.dimensions[0], header.dimensions[1], header.dimensions[2]}},
+                                    {{header.size[0], header.size[1], header.size[2]}},
+                                    data,
+                                    header.payload_entries,
+                                    std::move(z_edges));
+
+            return field_data;
+        }
+
+        /**
+         * @brief Read the description of the field from an APF file, leaving the stream at the beginning of the field data
+         * @param file     Stream of the input file
+         * @param archive  Archive reading from the stream, which has read the byte order marker
+         * @return         Field data object without data, holding the header, the binning and the number of entries
+         *
+         * The members of the field data are read individually in the order in which cereal serializes them, such that the
+         * field data itself can be read in parts afterwards. The field data is the first shared pointer of the archive.
+         */
+        FieldData<T> read_apf_header(std::ifstream& file, cereal::PortableBinaryInputArchive& archive) {
+            std::uint32_t version = 0;
+            archive(version);
+            if(version != 1 && version != 2) {
+                throw std::runtime_error("unknown format version " + std::to_string(version));
+            }
+
+            std::string header;
+            std::array<size_t, 3> dimensions{};
+            std::array<T, 3> size{};
+            std::uint32_t id = 0;
+            cereal::size_type entries = 0;
+            archive(header, dimensions, size, id);
+            if(id != (cereal::detail::msb_32bit | 1)) {
+                throw std::runtime_error("invalid data");
+            }
+            archive(cereal::make_size_tag(entries));
+
+            // The bin edges in z follow the field data
+            std::vector<T> z_edges;
+            if(version >= 2) {
+                auto payload = file.tellg();
+                file.seekg(payload + static_cast<std::streamoff>(entries * sizeof(T)));
+                archive(z_edges);
+                file.seekg(payload);
+            }
+
+            if(!file.good() || entries != dimensions[0] * dimensions[1] * dimensions[2] * N_ ||
+               (!z_edges.empty() && z_edges.size() != dimensions[2] + 1)) {
+                throw std::runtime_error("invalid data");
+            }
+            return FieldData<T>(header, dimensions, size, std::shared_ptr<const T>(), entries, std::move(z_edges));
+        }
+
         /**
          * @brief Function to deserialize FieldData from an APF file, using the cereal library. This does not convert any
          * units, i.e. all values stored in APF files are given framework-internal base units. This includes the field data
@@ -259,9 +948,10 @@ namespace allpix {
                 throw std::runtime_error(e.what());
             }
 
-            // Check that we have the right number of vector entries
+            // Check that we have the right number of vector entries and bin edges
             auto dimensions = field_data.getDimensions();
-            if(field_data.getData()->size() != dimensions[0] * dimensions[1] * dimensions[2] * N_) {
+            if(field_data.getEntries() != dimensions[0] * dimensions[1] * dimensions[2] * N_ ||
+               (!field_data.getZEdges().empty() && field_data.getZEdges().size() != dimensions[2] + 1)) {
                 throw std::runtime_error("invalid data");
             }
 
@@ -292,86 +982,294 @@ namespace allpix {
         }
 
         /**
-         * @brief Function to read FieldData from INIT-formatted ASCII files. Values are interpreted in the units provided by
-         * the argument and converted to the framework-internal base units. The size of the field given in the file is always
-         * interpreted as micrometers.
-         * @param file_name  File name (as canonical path) of the input file to be parsed
-         * @param units      Units to convert the values of the field data from
+         * @brief Check if a character separates tokens of INIT files, following the whitespace of formatted stream input
+         * @param c Character to check
+         * @return True if the character is whitespace
          */
-        FieldData<T> parse_init_file(const std::string& file_name, const std::string& units) {
-            // Load file
-            std::ifstream file(file_name);
-            std::string header;
-            std::getline(file, header);
-            LOG(TRACE) << "Header of file " << file_name << " is " << std::endl << header;
+        static bool is_init_space(char c) {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+        }
+
+        /**
+         * @brief Extract the next whitespace-separated token from a buffer
+         * @param cursor Position to start from, moved behind the token
+         * @param end    End of the buffer
+         * @return Token, empty if the end of the buffer has been reached
+         */
+        static std::string_view next_init_token(const char*& cursor, const char* end) {
+            while(cursor != end && is_init_space(*cursor)) {
+                ++cursor;
+            }
+            const auto* begin = cursor;
+            while(cursor != end && !is_init_space(*cursor)) {
+                ++cursor;
+            }
+            return {begin, static_cast<size_t>(cursor - begin)};
+        }
+
+        /**
+         * @brief Convert a complete token of an INIT file to a number
+         * @param token Token to convert
+         * @param value Number read from the token
+         * @return True if the full token could be converted, false otherwise
+         *
+         * Floating point numbers are converted with std::from_chars if the standard library supports it, and with strtod
+         * otherwise. Values underflowing the range of the type are accepted as by formatted stream input.
+         */
+        template <typename V> static bool parse_init_number(std::string_view token, V& value) {
+            const auto* first = token.data();
+            const auto* last = first + token.size();
+            if(first != last && *first == '+') {
+                ++first;
+            }
+            if constexpr(std::is_floating_point<V>::value) {
+#if defined(__cpp_lib_to_chars)
+                auto result = std::from_chars(first, last, value);
+                if(result.ec != std::errc::result_out_of_range) {
+                    return result.ec == std::errc() && result.ptr == last;
+                }
+#endif
+                std::string copy(first, last);
+                char* stop = nullptr;
+                value = static_cast<V>(std::strtod(copy.c_str(), &stop));
+                return !copy.empty() && stop == copy.c_str() + copy.size() && std::isfinite(value);
+            } else {
+                auto result = std::from_chars(first, last, value);
+                return result.ec == std::errc() && result.ptr == last;
+            }
+        }
+
+        /**
+         * @brief Read the header of an INIT file
+         * @param cursor         Beginning of the mapped file, moved to the beginning of the field data
+         * @param end            End of the mapped file
+         * @param units          Units to convert the values of the field data from
+         * @param check_quantity Compare the number of values of the first field point to the quantity of the field
+         * @return               Field data object without data, holding the header, the binning and the number of entries
+         */
+        FieldData<T> read_init_header(const char*& cursor, const char* end, const std::string& units, bool check_quantity) {
+            // Read the header line
+            const auto* line_end = std::find(cursor, end, '\n');
+            std::string header(cursor, line_end);
+            cursor = (line_end == end ? end : line_end + 1);
+            LOG(TRACE) << "Header of file is " << std::endl << header;
 
             // Read the header
-            std::string tmp;
+            auto skip_tokens = [&](size_t count) {
+                for(size_t i = 0; i < count; ++i) {
+                    next_init_token(cursor, end);
+                }
+            };
             // WARNING the usage of this field as storage for the field units differs from the original INIT format!
-            file >> tmp;
-            check_unit_match(allpix::trim(tmp), units);
-            file >> tmp;               // ignore cluster length
-            file >> tmp >> tmp >> tmp; // ignore the incident pion direction
-            file >> tmp >> tmp >> tmp; // ignore the magnetic field (specify separately)
+            auto file_units = next_init_token(cursor, end);
+            check_unit_match(std::string(file_units), units);
+            skip_tokens(1); // ignore cluster length
+            skip_tokens(3); // ignore the incident pion direction
+            skip_tokens(3); // ignore the magnetic field (specify separately)
             double thickness = NAN, xpixsz = NAN, ypixsz = NAN;
-            file >> thickness >> xpixsz >> ypixsz;
+            bool valid = parse_init_number(next_init_token(cursor, end), thickness);
+            valid &= parse_init_number(next_init_token(cursor, end), xpixsz);
+            valid &= parse_init_number(next_init_token(cursor, end), ypixsz);
             thickness = Units::get(thickness, "um");
             xpixsz = Units::get(xpixsz, "um");
             ypixsz = Units::get(ypixsz, "um");
-            file >> tmp >> tmp >> tmp >> tmp; // ignore temperature, flux, rhe (?) and new_drde (?)
+            skip_tokens(4); // ignore temperature, flux, rhe (?) and new_drde (?)
             size_t xsize = 0, ysize = 0, zsize = 0;
-            file >> xsize >> ysize >> zsize;
-            file >> tmp;
+            valid &= parse_init_number(next_init_token(cursor, end), xsize);
+            valid &= parse_init_number(next_init_token(cursor, end), ysize);
+            valid &= parse_init_number(next_init_token(cursor, end), zsize);
+            valid &= !next_init_token(cursor, end).empty();
 
-            if(file.fail()) {
+            if(!valid) {
                 throw std::runtime_error("invalid data or unexpected end of file");
             }
-            auto field = std::make_shared<std::vector<double>>();
-            auto vertices = xsize * ysize * zsize;
-            field->resize(vertices * N_);
 
-            // Loop through all the field data
-            for(size_t i = 0; i < vertices; ++i) {
-                if(vertices >= 100 && i % (vertices / 100) == 0) {
-                    LOG_PROGRESS(INFO, "read_init") << "Reading field data: " << (100 * i / vertices) << "%";
+            // The first line of field data holds the indices and the values of one field point
+            if(check_quantity) {
+                const auto* position = cursor;
+                while(position != end && *position != '\n') {
+                    ++position;
                 }
-
-                if(file.eof()) {
-                    throw std::runtime_error("unexpected end of file");
+                const auto* line_begin = (position == end ? end : position + 1);
+                line_end = std::find(line_begin, end, '\n');
+                size_t tokens = 0;
+                while(!next_init_token(line_begin, line_end).empty()) {
+                    ++tokens;
                 }
+                if((tokens == 4 || tokens == 6) && tokens != 3 + N_) {
+                    throw std::runtime_error("field quantity does not match the field data");
+                }
+            }
 
-                // Get index of field
-                size_t xind = 0, yind = 0, zind = 0;
-                file >> xind >> yind >> zind;
+            auto entries = xsize * ysize * zsize * N_;
+            return FieldData<T>(header,
+                                std::array<size_t, 3>{{xsize, ysize, zsize}},
+                                std::array<T, 3>{{xpixsz, ypixsz, thickness}},
+                                std::shared_ptr<const T>(),
+                                entries);
+        }
 
-                if(file.fail() || xind > xsize || yind > ysize || zind > zsize) {
-                    throw std::runtime_error("invalid data");
-                }
-                xind--;
-                yind--;
-                zind--;
+        /**
+         * @brief Parse the field data of an INIT file. Values are interpreted in the units provided by the argument and
+         * converted to the framework-internal base units.
+         * @param cursor     Beginning of the field data in the mapped file
+         * @param end        End of the mapped file
+         * @param dimensions Number of field points in every dimension
+         * @param units      Units to convert the values of the field data from
+         * @param store      Function called as store(index, value) for every entry of the field data
+         *
+         * The field data is split into chunks at token boundaries, which are parsed concurrently. The tokens of every chunk
+         * are counted first, such that each chunk parses the field points starting within it independently of the line
+         * structure of the file.
+         */
+        template <typename F>
+        void parse_init_values(const char* cursor,
+                               const char* end,
+                               const std::array<size_t, 3>& dimensions,
+                               const std::string& units,
+                               F& store) {
+            auto [xsize, ysize, zsize] = dimensions;
+            auto vertices = xsize * ysize * zsize;
 
-                // Loop through components of field
-                for(size_t j = 0; j < N_; ++j) {
-                    double input = NAN;
-                    file >> input;
+            // Split the field data into chunks of at least one megabyte, starting at token boundaries
+            auto record_length = 3 + N_;
+            auto payload = static_cast<size_t>(end - cursor);
+            auto chunks = std::clamp<size_t>(payload >> 20, 1, std::max(1u, std::thread::hardware_concurrency()));
+            std::vector<const char*> chunk_begin(chunks + 1, end);
+            for(size_t chunk = 0; chunk < chunks; ++chunk) {
+                const auto* begin = cursor + payload * chunk / chunks;
+                while(chunk > 0 && begin != end && !is_init_space(*(begin - 1))) {
+                    ++begin;
+                }
+                chunk_begin[chunk] = (chunk > 0 ? std::max(begin, chunk_begin[chunk - 1]) : begin);
+            }
 
-                    // Set the field at a position
-                    (*field)[xind * ysize * zsize * N_ + yind * zsize * N_ + zind * N_ + j] = Units::get(input, units);
+            // Run a function for all chunks concurrently, exceptions are rethrown once all chunks have finished
+            auto for_all_chunks = [&](auto&& function, bool progress) {
+                std::vector<std::future<void>> results;
+                results.reserve(chunks);
+                for(size_t chunk = 0; chunk < chunks; ++chunk) {
+                    results.push_back(std::async(std::launch::async, function, chunk));
+                }
+                std::exception_ptr exception;
+                for(size_t chunk = 0; chunk < chunks; ++chunk) {
+                    try {
+                        results[chunk].get();
+                    } catch(...) {
+                        exception = std::current_exception();
+                    }
+                    if(progress) {
+                        LOG_PROGRESS(INFO, "read_init") << "Reading field data: " << (100 * (chunk + 1) / chunks) << "%";
+                    }
+                }
+                if(exception) {
+                    std::rethrow_exception(exception);
                 }
+            };
+
+            // Count the tokens of every chunk to find the first field point starting in each of them
+            std::vector<size_t> chunk_tokens(chunks + 1, 0);
+            for_all_chunks(
+                [&](size_t chunk) {
+                    const auto* position = chunk_begin[chunk];
+                    size_t tokens = 0;
+                    while(!next_init_token(position, chunk_begin[chunk + 1]).empty()) {
+                        ++tokens;
+                    }
+                    chunk_tokens[chunk + 1] = tokens;
+                },
+                false);
+            std::partial_sum(chunk_tokens.begin(), chunk_tokens.end(), chunk_tokens.begin());
+            if(chunk_tokens.back() < vertices * record_length) {
+                throw std::runtime_error("unexpected end of file");
             }
+
+            // Parse the field points, the last point of a chunk may extend into the following one
+            auto factor = Units::get(units);
+            for_all_chunks(
+                [&](size_t chunk) {
+                    auto first = (chunk_tokens[chunk] + record_length - 1) / record_length;
+                    auto last = std::min((chunk_tokens[chunk + 1] + record_length - 1) / record_length, vertices);
+                    const auto* position = chunk_begin[chunk];
+                    for(auto skip = chunk_tokens[chunk]; skip < std::min(first, last) * record_length; ++skip) {
+                        next_init_token(position, end);
+                    }
+
+                    for(auto record = first; record < last; ++record) {
+                        // Get index of field
+                        size_t xind = 0, yind = 0, zind = 0;
+                        if(!parse_init_number(next_init_token(position, end), xind) ||
+                           !parse_init_number(next_init_token(position, end), yind) ||
+                           !parse_init_number(next_init_token(position, end), zind) || xind == 0 || yind == 0 ||
+                           zind == 0 || xind > xsize || yind > ysize || zind > zsize) {
+                            throw std::runtime_error("invalid data");
+                        }
+                        xind--;
+                        yind--;
+                        zind--;
+
+                        // Loop through components of field
+                        for(size_t j = 0; j < N_; ++j) {
+                            double input = NAN;
+                            if(!parse_init_number(next_init_token(position, end), input)) {
+                                throw std::runtime_error("invalid data");
+                            }
+
+                            // Set the field at a position, converting the units as Units::get does
+                            auto value = static_cast<Units::UnitType>(input) * factor;
+                            if(value > static_cast<Units::UnitType>(std::numeric_limits<double>::max()) ||
+                               value < static_cast<Units::UnitType>(std::numeric_limits<double>::lowest())) {
+                                throw std::overflow_error("unit conversion overflows the type");
+                            }
+                            store(xind * ysize * zsize * N_ + yind * zsize * N_ + zind * N_ + j, static_cast<T>(value));
+                        }
+                    }
+                },
+                true);
             LOG_PROGRESS(INFO, "read_init") << "Reading field data: finished.";
+        }
 
-            FieldData<T> field_data(
-                header, std::array<size_t, 3>{{xsize, ysize, zsize}}, std::array<T, 3>{{xpixsz, ypixsz, thickness}}, field);
+        /**
+         * @brief Function to read FieldData from INIT-formatted ASCII files. Values are interpreted in the units provided by
+         * the argument and converted to the framework-internal base units. The size of the field given in the file is always
+         * interpreted as micrometers.
+         * @param file_name  File name (as canonical path) of the input file to be parsed
+         * @param units      Units to convert the values of the field data from
+         *
+         * The file is mapped into memory and the field data is parsed concurrently.
+         */
+        FieldData<T> parse_init_file(const std::string& file_name, const std::string& units) {
+            auto mapped_file = map_file(file_name);
+            const auto* cursor = mapped_file.first.get();
+            const auto* end = cursor + mapped_file.second;
+            LOG(TRACE) << "Reading INIT file " << file_name;
 
-            // Store the parsed field data for further reference:
-            field_map_[file_name] = field_data;
-            return field_data;
+            auto header = read_init_header(cursor, end, units, false);
+            auto field = std::make_shared<std::vector<double>>(header.getEntries());
+            auto store = [&field](size_t index, T value) { (*field)[index] = value; };
+            parse_init_values(cursor, end, header.getDimensions(), units, store);
+
+            return FieldData<T>(header.getHeader(), header.getDimensions(), header.getSize(), field);
         }
 
         size_t N_;
-        std::map<std::string, FieldData<T>> field_map_;
+
+        /**
+         * @brief Cache entry of a file, either being read or holding the field data as long as it is in use elsewhere
+         */
+        struct CacheEntry {
+            std::shared_future<FieldData<T>> pending;
+            std::string header;
+            std::array<size_t, 3> dimensions{};
+            std::array<T, 3> size{};
+            std::vector<T> z_edges;
+            std::weak_ptr<const T> data;
+            size_t entries{};
+        };
+
+        // Field data of all files read or being read, shared between threads
+        std::mutex mutex_;
+        std::map<std::string, CacheEntry> field_map_;
     };
 
     /**
@@ -404,58 +1302,278 @@ namespace allpix {
                        const std::string& file_name,
                        const FileType& file_type,
                        const std::string& units = std::string()) {
-            auto dimensions = field_data.getDimensions();
-            if(field_data.getData()->size() != N_ * dimensions[0] * dimensions[1] * dimensions[2]) {
-                throw std::runtime_error("invalid field dimensions");
-            }
+            const auto* data = field_data.getRawData().get();
+            writeFileStreaming(field_data, file_name, file_type, units, [data](size_t first, size_t count, T* values) {
+                std::copy(data + first, data + first + count, values);
+            });
+        }
+
+        /**
+         * @brief Write a field to a file, reading the field data in slices of bounded size while writing
+         * @param field_data Field data object describing the field, the field data itself is not used
+         * @param file_name  File name (as canonical path) of the output file to be created
+         * @param file_type  Type of file (file format) to be produced
+         * @param units      Optional units to convert the field into before writing. Only used by some formats.
+         * @param read_slice Function called as read_slice(first, count, values) to provide consecutive entries of the field
+         */
+        template <typename F>
+        void writeFileStreaming(const FieldData<T>& field_data,
+                                const std::string& file_name,
+                                const FileType& file_type,
+                                const std::string& units,
+                                F&& read_slice) {
+            check_file(field_data, file_type, units);
 
             switch(file_type) {
             case FileType::INIT:
-                if(units.empty()) {
-                    LOG(WARNING) << "No field units provided, writing field data in internal units.";
-                }
-                write_init_file(field_data, file_name, units);
+                write_init_file(field_data, file_name, units, read_slice);
                 break;
             case FileType::APF:
-                if(!units.empty()) {
-                    LOG(WARNING) << "Units will be ignored, APF file content is written in internal units.";
+                write_apf_file(field_data, file_name, read_slice);
+                break;
+            case FileType::APF_RAW:
+                write_apf_raw_file(field_data, file_name, read_slice);
+                break;
+            default:
+                throw std::runtime_error("unknown file format");
+            }
+        }
+
+        /**
+         * @brief Write a field to a binary file, storing the field data directly into the file mapped into memory
+         * @param field_data Field data object describing the field, the field data itself is not used
+         * @param file_name  File name (as canonical path) of the output file to be created
+         * @param file_type  Type of file (file format) to be produced, only APF formats are supported
+         * @param fill       Function called as fill(store), calling store(index, value) for the entries of the field
+         *
+         * Entries which are not stored are zero. The store function can be called concurrently for different entries, which
+         * allows to write files from field data which is not available in order, such as the field points of INIT files.
+         */
+        template <typename F>
+        void writeFileMapped(const FieldData<T>& field_data,
+                             const std::string& file_name,
+                             const FileType& file_type,
+                             F&& fill) {
+            check_file(field_data, file_type, std::string());
+
+            // Write everything but the field data
+            std::streamoff payload_offset = 0;
+            auto payload_length = static_cast<std::streamoff>(field_data.getEntries() * sizeof(T));
+            std::ofstream file(file_name, std::ios::binary);
+            switch(file_type) {
+            case FileType::APF:
+                try {
+                    cereal::PortableBinaryOutputArchive archive(file);
+                    write_apf_prefix(archive, field_data);
+                    payload_offset = file.tellp();
+                    file.seekp(payload_offset + payload_length);
+                    write_apf_suffix(archive, field_data);
+                } catch(cereal::Exception& e) {
+                    throw std::runtime_error(e.what());
                 }
-                write_apf_file(field_data, file_name);
                 break;
+            case FileType::APF_RAW:
+                payload_offset = static_cast<std::streamoff>(write_apf_raw_prefix(file, field_data));
+                break;
+            case FileType::INIT:
+                throw std::runtime_error("INIT files cannot be written in place");
             default:
                 throw std::runtime_error("unknown file format");
             }
+            file.close();
+            if(!file) {
+                throw std::runtime_error("could not write file");
+            }
+
+            // Map the file into memory, extended to its full length, and store the field data
+            int fd = ::open(file_name.c_str(), O_RDWR);
+            if(fd < 0) {
+                throw std::runtime_error("could not open file");
+            }
+            auto file_length = payload_offset + payload_length;
+            struct stat file_stat {};
+            if(::fstat(fd, &file_stat) != 0 ||
+               (file_stat.st_size < file_length && ::ftruncate(fd, static_cast<off_t>(file_length)) != 0)) {
+                ::close(fd);
+                throw std::runtime_error("could not write file");
+            }
+            auto length = static_cast<size_t>(std::max<std::streamoff>(file_stat.st_size, file_length));
+            void* mapping = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if(mapping == MAP_FAILED) {
+                throw std::runtime_error("could not map file into memory");
+            }
+            std::shared_ptr<char> memory(static_cast<char*>(mapping), [length](char* ptr) { ::munmap(ptr, length); });
+
+            auto* payload = memory.get() + payload_offset;
+            fill([payload](size_t index, T value) { std::memcpy(payload + index * sizeof(T), &value, sizeof(T)); });
+            if(::msync(mapping, length, MS_SYNC) != 0) {
+                throw std::runtime_error("could not write file");
+            }
         }
 
     private:
         /**
-         * @brief Function to serialize FieldData into an APF file, using the cereal library. This does not convert any
-         * units, i.e. all values stored in APF files are given framework-internal base units. This includes the field data
-         * itself as well as the field size.
+         * @brief Check if a field can be written to a file of the given format
+         * @param field_data Field data object to store
+         * @param file_type  Type of file (file format) to be produced
+         * @param units      Units to convert the field into before writing
+         */
+        void check_file(const FieldData<T>& field_data, const FileType& file_type, const std::string& units) const {
+            auto dimensions = field_data.getDimensions();
+            if(field_data.getEntries() != N_ * dimensions[0] * dimensions[1] * dimensions[2]) {
+                throw std::runtime_error("invalid field dimensions");
+            }
+            if(!field_data.getZEdges().empty() && field_data.getZEdges().size() != dimensions[2] + 1) {
+                throw std::runtime_error("invalid number of bin edges in z");
+            }
+
+            if(file_type == FileType::INIT) {
+                if(!field_data.getZEdges().empty()) {
+                    throw std::runtime_error("INIT files cannot store fields with non-uniform binning in z");
+                }
+                if(units.empty()) {
+                    LOG(WARNING) << "No field units provided, writing field data in internal units.";
+                }
+            } else if(!units.empty()) {
+                LOG(WARNING) << "Units will be ignored, APF file content is written in internal units.";
+            }
+        }
+
+        /**
+         * @brief Read the field data in slices and hand every slice to a function
+         * @param entries    Number of entries of the field data
+         * @param read_slice Function called as read_slice(first, count, values) to provide consecutive entries of the field
+         * @param write      Function called as write(values, count) for every slice
+         *
+         * The slices always hold complete field points.
+         */
+        template <typename F, typename W> void for_all_slices(size_t entries, F& read_slice, W&& write) const {
+            std::vector<T> values(std::min(entries, field_slice_entries / N_ * N_));
+            for(size_t first = 0; first < entries; first += values.size()) {
+                auto count = std::min(values.size(), entries - first);
+                read_slice(first, count, values.data());
+                write(first, count, values.data());
+                LOG_PROGRESS(INFO, "write_field") << "Writing field data: " << (100 * (first + count) / entries) << "%";
+            }
+            LOG_PROGRESS(INFO, "write_field") << "Writing field data: finished.";
+        }
+
+        /**
+         * @brief Serialize the members of FieldData preceding the field data, in the same way as the cereal library does
+         * @param archive    Archive to write to
+         * @param field_data Field data object to store
+         */
+        void write_apf_prefix(cereal::PortableBinaryOutputArchive& archive, const FieldData<T>& field_data) const {
+            std::uint32_t version = APF_MIME_TYPE_VERSION;
+            archive(version);
+            archive(field_data.getHeader(), field_data.getDimensions(), field_data.getSize());
+
+            // Identifier of the first shared pointer followed by the size of the vector it points to
+            std::uint32_t id = cereal::detail::msb_32bit | 1;
+            archive(id);
+            archive(cereal::make_size_tag(static_cast<cereal::size_type>(field_data.getEntries())));
+        }
+
+        /**
+         * @brief Serialize the members of FieldData following the field data, in the same way as the cereal library does
+         * @param archive    Archive to write to
          * @param field_data Field data object to store
+         */
+        void write_apf_suffix(cereal::PortableBinaryOutputArchive& archive, const FieldData<T>& field_data) const {
+            archive(field_data.getZEdges());
+        }
+
+        /**
+         * @brief Function to serialize FieldData into an APF file, in the format of the cereal library. This does not
+         * convert any units, i.e. all values stored in APF files are given framework-internal base units. This includes the
+         * field data itself as well as the field size.
+         * @param field_data Field data object describing the field
          * @param file_name  File name (as canonical path) of the output file to be created
+         * @param read_slice Function providing consecutive entries of the field
+         *
+         * The members of the field data are written individually, such that the field data can be written in slices.
          */
-        void write_apf_file(const FieldData<T>& field_data, const std::string& file_name) {
+        template <typename F>
+        void write_apf_file(const FieldData<T>& field_data, const std::string& file_name, F& read_slice) {
             std::ofstream file(file_name, std::ios::binary);
 
-            // Write the file with cereal:
             try {
                 cereal::PortableBinaryOutputArchive archive(file);
-                archive(field_data);
+                write_apf_prefix(archive, field_data);
+                for_all_slices(field_data.getEntries(), read_slice, [&archive](size_t, size_t count, const T* values) {
+                    archive(cereal::binary_data(values, count * sizeof(T)));
+                });
+                write_apf_suffix(archive, field_data);
             } catch(cereal::Exception& e) {
                 throw std::runtime_error(e.what());
             }
+            if(!file.good()) {
+                throw std::runtime_error("could not write file");
+            }
+        }
+
+        /**
+         * @brief Write the header of an APF file with raw payload, including the padding up to the payload
+         * @param file       Stream of the output file
+         * @param field_data Field data object describing the field
+         * @return           Offset of the payload in the file
+         */
+        size_t write_apf_raw_prefix(std::ofstream& file, const FieldData<T>& field_data) const {
+            auto header_string = field_data.getHeader();
+            const auto& z_edges = field_data.getZEdges();
+            auto header = make_apf_raw_header(field_data, N_);
+            auto edges_end = sizeof(header) + header.header_length + header.z_edges * sizeof(T);
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(header_string.data(), static_cast<std::streamsize>(header_string.size()));
+            file.write(reinterpret_cast<const char*>(z_edges.data()),
+                       static_cast<std::streamsize>(z_edges.size() * sizeof(T)));
+
+            // Pad up to the aligned payload
+            std::vector<char> padding(header.payload_offset - edges_end, '\0');
+            file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+            return header.payload_offset;
+        }
+
+        /**
+         * @brief Function to write FieldData into an APF file with raw payload which can be mapped into memory. This does
+         * not convert any units, i.e. all values stored in APF files are given framework-internal base units. The values
+         * are stored with the native byte order of the machine.
+         * @param field_data Field data object describing the field
+         * @param file_name  File name (as canonical path) of the output file to be created
+         * @param read_slice Function providing consecutive entries of the field
+         */
+        template <typename F>
+        void write_apf_raw_file(const FieldData<T>& field_data, const std::string& file_name, F& read_slice) {
+            static_assert(std::is_same<T, double>::value, "APF files with raw payload only store double precision values");
+
+            std::ofstream file(file_name, std::ios::binary);
+            write_apf_raw_prefix(file, field_data);
+            for_all_slices(field_data.getEntries(), read_slice, [&file](size_t, size_t count, const T* values) {
+                file.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(count * sizeof(T)));
+            });
+            if(!file.good()) {
+                throw std::runtime_error("could not write file");
+            }
         }
 
         /**
          * @brief Function to write FieldData objects out to INIT-formatted ASCII files. Values are converted from the
          * framework-internal base units in which the data is stored in FieldData into the units provided by the units
          * parameter. The size of the field is always converted to micrometers.
-         * @param field_data Field data object to store
+         * @param field_data Field data object describing the field
          * @param file_name  File name (as canonical path) of the output file to be created
          * @param units      Units to convert the values of the field data to.
+         * @param read_slice Function providing consecutive entries of the field
+         *
+         * Every slice of the field data is split into blocks of field points which are formatted concurrently.
          */
-        void write_init_file(const FieldData<T>& field_data, const std::string& file_name, const std::string& units) {
+        template <typename F>
+        void write_init_file(const FieldData<T>& field_data,
+                             const std::string& file_name,
+                             const std::string& units,
+                             F& read_slice) {
             std::ofstream file(file_name);
 
             LOG(TRACE) << "Writing INIT file \"" << file_name << "\"";
@@ -475,32 +1593,40 @@ namespace allpix {
             file << dimensions[0] << " " << dimensions[1] << " " << dimensions[2] << " "; // Field grid dimensions (x, y, z)
             file << "0.0" << std::endl;                                                   // Unused
 
-            // Write the data block:
-            auto data = field_data.getData();
-            auto max_points = data->size() / N_;
-
-            for(size_t xind = 0; xind < dimensions[0]; ++xind) {
-                for(size_t yind = 0; yind < dimensions[1]; ++yind) {
-                    for(size_t zind = 0; zind < dimensions[2]; ++zind) {
-                        // Write field point index
-                        file << xind + 1 << " " << yind + 1 << " " << zind + 1;
-
-                        // Vector or scalar field:
-                        for(size_t j = 0; j < N_; j++) {
-                            file << " "
-                                 << Units::convert(data->at(xind * dimensions[1] * dimensions[2] * N_ +
-                                                            yind * dimensions[2] * N_ + zind * N_ + j),
-                                                   units);
-                        }
-                        // End this line
-                        file << std::endl;
-                    }
+            // Write the data block, formatting blocks of field points of every slice concurrently
+            auto blocks = std::max(1u, std::thread::hardware_concurrency());
+            for_all_slices(field_data.getEntries(), read_slice, [&](size_t first, size_t count, const T* values) {
+                auto points = count / N_;
+                std::vector<std::future<std::string>> results;
+                results.reserve(blocks);
+                for(size_t block = 0; block < blocks; ++block) {
+                    results.push_back(std::async(std::launch::async, [&, block]() {
+                        std::ostringstream output;
+                        for(auto point = points * block / blocks; point < points * (block + 1) / blocks; ++point) {
+                            // Write field point index
+                            auto index = first / N_ + point;
+                            auto zind = index % dimensions[2];
+                            auto yind = (index / dimensions[2]) % dimensions[1];
+                            auto xind = index / dimensions[2] / dimensions[1];
+                            output << xind + 1 << " " << yind + 1 << " " << zind + 1;
 
-                    auto curr_point = xind * dimensions[1] * dimensions[2] + yind * dimensions[2];
-                    LOG_PROGRESS(INFO, "write_init") << "Writing field data: " << (100 * curr_point / max_points) << "%";
+                            // Vector or scalar field:
+                            for(size_t j = 0; j < N_; j++) {
+                                output << " " << Units::convert(values[point * N_ + j], units);
+                            }
+                            // End this line
+                            output << '\n';
+                        }
+                        return output.str();
+                    }));
+                }
+                for(auto& result : results) {
+                    file << result.get();
                 }
+            });
+            if(!file.good()) {
+                throw std::runtime_error("could not write file");
             }
-            LOG_PROGRESS(INFO, "write_init") << "Writing field data: finished.";
         }
 
         size_t N_;
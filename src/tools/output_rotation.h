@@ -0,0 +1,131 @@
+/**
+ * @file
+ * @brief Splitting of output files into chunks of limited size, listed in a manifest
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_OUTPUT_ROTATION_H
+#define ALLPIX_OUTPUT_ROTATION_H
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace allpix {
+
+    /**
+     * @brief Output file holding a consecutive range of events
+     */
+    struct OutputChunk {
+        std::string file_name;
+        std::uint64_t first_event{};
+        std::uint64_t last_event{};
+        std::uint64_t events{};
+    };
+
+    /**
+     * @brief Bookkeeping of the chunks an output is split into
+     *
+     * A new chunk is started once the current one holds the maximum number of events or has reached the maximum size. A
+     * chunk is only completed between events, such that every event is stored entirely in one chunk. A limit of zero
+     * disables the respective condition.
+     */
+    class OutputRotation {
+    public:
+        /**
+         * @brief Construct the rotation with its limits
+         * @param max_events Maximum number of events per chunk
+         * @param max_bytes Size of a chunk in bytes after which no further events are added
+         */
+        explicit OutputRotation(std::uint64_t max_events = 0, std::uint64_t max_bytes = 0)
+            : max_events_(max_events), max_bytes_(max_bytes) {}
+
+        /**
+         * @brief Check if the output is split into chunks
+         * @return True if any limit is set
+         */
+        bool enabled() const { return max_events_ > 0 || max_bytes_ > 0; }
+
+        /**
+         * @brief Name of the file of a chunk, obtained by appending the chunk number to the name without extension
+         * @param file_name Name of the output file as configured
+         * @param chunk Number of the chunk, starting from one
+         * @return Name of the chunk file without extension
+         */
+        static std::string chunk_name(const std::string& file_name, size_t chunk) {
+            std::stringstream name;
+            name << std::filesystem::path(file_name).replace_extension().string() << "_" << std::setfill('0')
+                 << std::setw(5) << chunk;
+            return name.str();
+        }
+
+        /**
+         * @brief Start a new chunk
+         * @param file_name Path of the file of the chunk
+         */
+        void open(const std::string& file_name) { chunks_.push_back({file_name, 0, 0, 0}); }
+
+        /**
+         * @brief Check if the current chunk has reached a limit and a new chunk has to be started before the next event
+         * @param bytes Current size of the chunk file
+         * @return True if the chunk is full
+         */
+        bool full(std::uint64_t bytes) const {
+            if(chunks_.empty() || chunks_.back().events == 0) {
+                return false;
+            }
+            return (max_events_ > 0 && chunks_.back().events >= max_events_) || (max_bytes_ > 0 && bytes >= max_bytes_);
+        }
+
+        /**
+         * @brief Add an event to the current chunk
+         * @param event Number of the event
+         */
+        void add_event(std::uint64_t event) {
+            auto& chunk = chunks_.back();
+            if(chunk.events == 0) {
+                chunk.first_event = event;
+            }
+            chunk.last_event = event;
+            chunk.events++;
+        }
+
+        /**
+         * @brief Return all chunks started so far
+         * @return List of chunks
+         */
+        const std::vector<OutputChunk>& chunks() const { return chunks_; }
+
+        /**
+         * @brief Write the list of chunks with the range and number of their events as text file
+         * @param file_name Path of the manifest
+         * @throws std::runtime_error If the manifest cannot be written
+         */
+        void write_manifest(const std::string& file_name) const {
+            std::ofstream file(file_name);
+            file << "# file first_event last_event events" << std::endl;
+            for(const auto& chunk : chunks_) {
+                file << std::filesystem::path(chunk.file_name).filename().string() << " " << chunk.first_event << " "
+                     << chunk.last_event << " " << chunk.events << std::endl;
+            }
+            if(!file.good()) {
+                throw std::runtime_error("cannot write manifest " + file_name);
+            }
+        }
+
+    private:
+        std::uint64_t max_events_;
+        std::uint64_t max_bytes_;
+        std::vector<OutputChunk> chunks_;
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_OUTPUT_ROTATION_H */
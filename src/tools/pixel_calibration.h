@@ -0,0 +1,106 @@
+/**
+ * @file
+ * @brief Utility to provide calibration quantities with individual values for every pixel of a detector
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_PIXEL_CALIBRATION_H
+#define ALLPIX_PIXEL_CALIBRATION_H
+
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <Math/DisplacementVector2D.h>
+
+#include "tools/field_parser.h"
+
+namespace allpix {
+
+    /**
+     * @brief Calibration quantity with one value per pixel, such as thresholds, gains or noise levels
+     *
+     * The values are read from scalar field files in any format supported by the \ref FieldParser. These files have one bin
+     * per pixel column in x, one per pixel row in y and a single bin in z. The values are kept in the contiguous storage of
+     * the field data, the value of a pixel is therefore obtained with a single array load. Maps are read-only after loading
+     * and can be shared between threads. Loading the same file again, e.g. for several detectors, reuses the data already
+     * in memory.
+     */
+    class PixelCalibrationMap {
+    public:
+        using PixelIndex = ROOT::Math::DisplacementVector2D<ROOT::Math::Cartesian2D<unsigned int>>;
+
+        /**
+         * @brief Construct an empty map without any values
+         */
+        PixelCalibrationMap() = default;
+
+        /**
+         * @brief Construct a map from field data
+         * @param field_data Field data with one bin per pixel
+         * @param pixels Number of pixels of the detector in x and y
+         * @throws std::invalid_argument If the binning of the field data does not match the pixel matrix
+         */
+        PixelCalibrationMap(FieldData<double> field_data, const PixelIndex& pixels) : field_data_(std::move(field_data)) {
+            auto dimensions = field_data_.getDimensions();
+            if(dimensions[0] != pixels.x() || dimensions[1] != pixels.y() || dimensions[2] != 1) {
+                throw std::invalid_argument("calibration map with " + std::to_string(dimensions[0]) + "x" +
+                                            std::to_string(dimensions[1]) + "x" + std::to_string(dimensions[2]) +
+                                            " bins does not match the pixel matrix of " + std::to_string(pixels.x()) + "x" +
+                                            std::to_string(pixels.y()) + " pixels");
+            }
+            values_ = field_data_.getRawData().get();
+            rows_ = dimensions[1];
+        }
+
+        /**
+         * @brief Load a map from a file
+         * @param file_name Canonical path of the file
+         * @param pixels Number of pixels of the detector in x and y
+         * @param units Units of the values, only used by file formats which are not stored in internal units
+         * @return Calibration map
+         * @throws std::invalid_argument If the binning of the file does not match the pixel matrix
+         * @throws std::runtime_error If the file cannot be parsed
+         */
+        static PixelCalibrationMap
+        load(const std::string& file_name, const PixelIndex& pixels, const std::string& units = std::string()) {
+            static FieldParser<double> parser(FieldQuantity::SCALAR);
+            static std::mutex parser_mutex;
+
+            std::lock_guard<std::mutex> lock(parser_mutex);
+            return {parser.getByFileName(file_name, units), pixels};
+        }
+
+        /**
+         * @brief Return if the map contains values
+         * @return True if no values have been loaded, false otherwise
+         */
+        bool empty() const { return values_ == nullptr; }
+
+        /**
+         * @brief Get the value of a pixel
+         * @param index Index of the pixel, required to be within the pixel matrix
+         * @return Calibration value of the pixel
+         */
+        double get(const PixelIndex& index) const { return values_[index.x() * rows_ + index.y()]; }
+
+        /**
+         * @brief Get the value of a pixel or a fallback value for empty maps
+         * @param index Index of the pixel, required to be within the pixel matrix
+         * @param fallback Value returned if the map is empty
+         * @return Calibration value of the pixel or the fallback value
+         */
+        double get(const PixelIndex& index, double fallback) const { return empty() ? fallback : get(index); }
+
+    private:
+        FieldData<double> field_data_;
+        const double* values_{nullptr};
+        size_t rows_{};
+    };
+} // namespace allpix
+
+#endif /* ALLPIX_PIXEL_CALIBRATION_H */
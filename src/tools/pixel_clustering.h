@@ -0,0 +1,135 @@
+/**
+ * @file
+ * @brief Utility to group pixels into clusters of neighbouring pixels in linear time
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_PIXEL_CLUSTERING_H
+#define ALLPIX_PIXEL_CLUSTERING_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace allpix {
+
+    /**
+     * @brief Clusters of pixels, stored as the positions of the pixels in the list of clustered pixels
+     *
+     * The positions of the pixels of all clusters are stored in a single array, grouped by cluster. The offsets hold the
+     * start of every cluster in this array, followed by the total number of pixels.
+     */
+    struct PixelClusters {
+        std::vector<size_t> pixels;
+        std::vector<size_t> offsets{0};
+
+        /**
+         * @brief Return the number of clusters
+         * @return Number of clusters
+         */
+        size_t size() const { return offsets.size() - 1; }
+
+        /**
+         * @brief Get the pixels of a cluster
+         * @param cluster Index of the cluster
+         * @return Pointers to the first and past the last position of the pixels of the cluster
+         */
+        std::pair<const size_t*, const size_t*> get(size_t cluster) const {
+            return {pixels.data() + offsets[cluster], pixels.data() + offsets[cluster + 1]};
+        }
+    };
+
+    /**
+     * @brief Group pixels into clusters of pixels touching each other, including diagonally
+     * @param indices Indices of the pixels, providing the column and row as x() and y()
+     * @return Clusters of the pixels
+     *
+     * The pixels are entered into a hash table of their indices and every pixel is joined with all neighbours which are
+     * present in the table using a union-find structure, which takes linear time in the number of pixels. Clusters are
+     * ordered by their first pixel and the pixels of every cluster are ordered as in the input, which reproduces the result
+     * of growing the clusters from the first unassigned pixel. Pixels with the same index belong to the same cluster.
+     */
+    template <typename Index> PixelClusters cluster_pixels(const std::vector<Index>& indices) {
+        auto key = [](uint64_t x, uint64_t y) { return (x << 32) | (y & 0xFFFFFFFF); };
+
+        // The root of every set is its first pixel, such that the clusters keep the order of the pixels
+        std::vector<size_t> parent(indices.size());
+        std::iota(parent.begin(), parent.end(), 0);
+        auto find = [&](size_t pixel) {
+            while(parent[pixel] != pixel) {
+                parent[pixel] = parent[parent[pixel]];
+                pixel = parent[pixel];
+            }
+            return pixel;
+        };
+        auto unite = [&](size_t lhs, size_t rhs) {
+            lhs = find(lhs);
+            rhs = find(rhs);
+            if(lhs < rhs) {
+                parent[rhs] = lhs;
+            } else if(rhs < lhs) {
+                parent[lhs] = rhs;
+            }
+        };
+
+        std::unordered_map<uint64_t, size_t> grid;
+        grid.reserve(indices.size());
+        for(size_t i = 0; i < indices.size(); ++i) {
+            auto inserted = grid.emplace(key(indices[i].x(), indices[i].y()), i);
+            if(!inserted.second) {
+                unite(i, inserted.first->second);
+            }
+        }
+
+        // Half of the neighbours is sufficient to find every pair of touching pixels once
+        constexpr std::array<std::pair<int64_t, int64_t>, 4> neighbours = {{{1, -1}, {1, 0}, {1, 1}, {0, 1}}};
+        for(size_t i = 0; i < indices.size(); ++i) {
+            auto x = static_cast<int64_t>(indices[i].x());
+            auto y = static_cast<int64_t>(indices[i].y());
+            for(const auto& neighbour : neighbours) {
+                if(y + neighbour.second < 0) {
+                    continue;
+                }
+                auto found = grid.find(key(static_cast<uint64_t>(x + neighbour.first),
+                                           static_cast<uint64_t>(y + neighbour.second)));
+                if(found != grid.end()) {
+                    unite(i, found->second);
+                }
+            }
+        }
+
+        // Number the clusters by their first pixel and count their pixels
+        std::vector<size_t> cluster_of(indices.size());
+        std::vector<size_t> counts;
+        for(size_t i = 0; i < indices.size(); ++i) {
+            auto root = find(i);
+            if(root == i) {
+                cluster_of[i] = counts.size();
+                counts.push_back(0);
+            } else {
+                cluster_of[i] = cluster_of[root];
+            }
+            ++counts[cluster_of[i]];
+        }
+
+        // Sort the pixels by cluster, keeping their order within the clusters
+        PixelClusters clusters;
+        clusters.offsets.resize(counts.size() + 1);
+        std::partial_sum(counts.begin(), counts.end(), clusters.offsets.begin() + 1);
+        clusters.pixels.resize(indices.size());
+        std::vector<size_t> fill(clusters.offsets.begin(), clusters.offsets.end() - 1);
+        for(size_t i = 0; i < indices.size(); ++i) {
+            clusters.pixels[fill[cluster_of[i]]++] = i;
+        }
+        return clusters;
+    }
+} // namespace allpix
+
+#endif /* ALLPIX_PIXEL_CLUSTERING_H */
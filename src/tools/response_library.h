@@ -0,0 +1,215 @@
+/**
+ * @file
+ * @brief Binary storage of the charge collection response of a pixel cell for the fast simulation of the charge transfer
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_RESPONSE_LIBRARY_H
+#define ALLPIX_RESPONSE_LIBRARY_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace allpix {
+
+    /**
+     * @brief Response of a pixel cell to charge carriers deposited at a given in-pixel position and depth
+     *
+     * The pixel cell is divided into bins in the in-pixel position and the depth, separately for electrons and holes. For
+     * every bin, the library holds the fraction of the deposited charge carriers collected at each pixel of the
+     * neighbourhood of the pixel containing the deposit as well as the mean and spread of the arrival time of the collected
+     * carriers. The in-pixel position is given relative to the pixel center and the depth relative to the sensor center.
+     */
+    struct ResponseLibrary {
+        /**
+         * @brief Statistics of a single bin of the library
+         */
+        struct Bin {
+            // Number of deposited charge carriers the response has been computed from, zero if the bin has not been filled
+            double deposited;
+            double time_mean;
+            double time_sigma;
+        };
+
+        // Number of bins in the in-pixel position in x and y and in the depth
+        std::array<std::uint32_t, 3> bins{};
+        // Number of neighbouring pixels in each direction taken into account
+        std::uint32_t radius{};
+        std::array<double, 2> pixel_size{};
+        double thickness{};
+
+        // Statistics of all bins and the collected fractions of all neighbours of every bin
+        std::vector<Bin> entries;
+        std::vector<double> fractions;
+
+        /**
+         * @brief Return the number of pixels in the neighbourhood including the central pixel
+         * @return Number of neighbours of every bin
+         */
+        size_t neighbours() const { return (2 * radius + 1) * (2 * radius + 1); }
+
+        /**
+         * @brief Return the number of bins for a single carrier type
+         * @return Number of bins in position and depth
+         */
+        size_t size() const { return static_cast<size_t>(bins[0]) * bins[1] * bins[2]; }
+
+        /**
+         * @brief Return the index of a bin in the entries
+         * @param hole Index of the carrier type, zero for electrons and one for holes
+         * @param x Bin of the in-pixel position in x
+         * @param y Bin of the in-pixel position in y
+         * @param z Bin of the depth
+         * @return Index of the bin
+         */
+        size_t index(size_t hole, size_t x, size_t y, size_t z) const {
+            return ((hole * bins[2] + z) * bins[1] + y) * bins[0] + x;
+        }
+
+        /**
+         * @brief Return the index of the bin containing a position, positions outside the pixel cell are moved to its border
+         * @param hole Index of the carrier type, zero for electrons and one for holes
+         * @param x In-pixel position in x relative to the pixel center
+         * @param y In-pixel position in y relative to the pixel center
+         * @param z Depth relative to the sensor center
+         * @return Index of the bin
+         */
+        size_t locate(size_t hole, double x, double y, double z) const {
+            auto coordinate = [](double value, double size, std::uint32_t count) {
+                auto bin = static_cast<long>(std::floor((value / size + 0.5) * count));
+                return static_cast<size_t>(std::clamp(bin, 0L, static_cast<long>(count) - 1));
+            };
+            return index(hole,
+                         coordinate(x, pixel_size[0], bins[0]),
+                         coordinate(y, pixel_size[1], bins[1]),
+                         coordinate(z, thickness, bins[2]));
+        }
+
+        /**
+         * @brief Return the index of a neighbour in the fractions
+         * @param bin Index of the bin
+         * @param dx Offset of the neighbour to the pixel with the deposit in x, between -radius and radius
+         * @param dy Offset of the neighbour to the pixel with the deposit in y, between -radius and radius
+         * @return Index of the collected fraction
+         */
+        size_t neighbour(size_t bin, int dx, int dy) const {
+            auto width = static_cast<int>(2 * radius + 1);
+            auto offset = (dy + static_cast<int>(radius)) * width + dx + static_cast<int>(radius);
+            return bin * neighbours() + static_cast<size_t>(offset);
+        }
+    };
+
+    /**
+     * @brief Layout of response library files
+     *
+     * A library starts with the magic string and the version, followed by the binning, the radius of the neighbourhood, the
+     * pixel size and the sensor thickness. The bins and the collected fractions are stored as the plain memory layout of
+     * \ref ResponseLibrary::Bin and doubles, each preceded by their number. Libraries are written in the byte order of the
+     * machine, they can only be read on machines with the same byte order.
+     */
+    namespace response_library {
+        constexpr std::array<char, 8> magic = {'A', 'P', 'R', 'S', 'P', 'L', 'I', 'B'};
+        constexpr std::uint32_t version = 1;
+
+        static_assert(std::is_trivially_copyable<ResponseLibrary::Bin>::value && sizeof(ResponseLibrary::Bin) == 24,
+                      "unexpected layout of bin records");
+
+        namespace detail {
+            template <typename T> void write_value(std::ofstream& file, const T& value) {
+                file.write(reinterpret_cast<const char*>(&value), sizeof(T)); // NOLINT
+            }
+            template <typename T> void write_records(std::ofstream& file, const std::vector<T>& records) {
+                write_value(file, static_cast<std::uint64_t>(records.size()));
+                file.write(reinterpret_cast<const char*>(records.data()), // NOLINT
+                           static_cast<std::streamsize>(records.size() * sizeof(T)));
+            }
+            template <typename T> T read_value(std::ifstream& file) {
+                T value{};
+                file.read(reinterpret_cast<char*>(&value), sizeof(T)); // NOLINT
+                return value;
+            }
+            template <typename T> std::vector<T> read_records(std::ifstream& file, size_t expected) {
+                auto count = read_value<std::uint64_t>(file);
+                if(!file.good() || count != expected) {
+                    file.setstate(std::ios::failbit);
+                    return {};
+                }
+                std::vector<T> records(count);
+                file.read(reinterpret_cast<char*>(records.data()), // NOLINT
+                          static_cast<std::streamsize>(records.size() * sizeof(T)));
+                return records;
+            }
+        } // namespace detail
+
+        /**
+         * @brief Write a response library to a file
+         * @param file_name Path of the file, an existing file is overwritten
+         * @param library Library to store
+         * @throws std::runtime_error If the library cannot be written
+         */
+        inline void write(const std::string& file_name, const ResponseLibrary& library) {
+            std::ofstream file(file_name, std::ios::binary);
+            if(!file.good()) {
+                throw std::runtime_error("cannot create response library " + file_name);
+            }
+            file.write(magic.data(), magic.size());
+            detail::write_value(file, version);
+            detail::write_value(file, library.bins);
+            detail::write_value(file, library.radius);
+            detail::write_value(file, library.pixel_size);
+            detail::write_value(file, library.thickness);
+            detail::write_records(file, library.entries);
+            detail::write_records(file, library.fractions);
+            file.close();
+            if(file.fail()) {
+                throw std::runtime_error("writing the response library " + file_name + " failed");
+            }
+        }
+
+        /**
+         * @brief Read a response library from a file
+         * @param file_name Path of the file
+         * @return Library stored in the file
+         * @throws std::runtime_error If the file cannot be read or is not a valid response library
+         */
+        inline ResponseLibrary read(const std::string& file_name) {
+            std::ifstream file(file_name, std::ios::binary);
+            if(!file.good()) {
+                throw std::runtime_error("cannot open response library " + file_name);
+            }
+
+            std::array<char, 8> file_magic{};
+            file.read(file_magic.data(), file_magic.size());
+            if(!file.good() || file_magic != magic) {
+                throw std::runtime_error(file_name + " is not a response library");
+            }
+            if(detail::read_value<std::uint32_t>(file) != version) {
+                throw std::runtime_error("response library " + file_name + " has an unsupported version");
+            }
+
+            ResponseLibrary library;
+            library.bins = detail::read_value<decltype(library.bins)>(file);
+            library.radius = detail::read_value<decltype(library.radius)>(file);
+            library.pixel_size = detail::read_value<decltype(library.pixel_size)>(file);
+            library.thickness = detail::read_value<decltype(library.thickness)>(file);
+            library.entries = detail::read_records<ResponseLibrary::Bin>(file, 2 * library.size());
+            library.fractions = detail::read_records<double>(file, library.entries.size() * library.neighbours());
+            if(!file.good()) {
+                throw std::runtime_error("response library " + file_name + " is not complete, it might be truncated");
+            }
+            return library;
+        }
+    } // namespace response_library
+} // namespace allpix
+
+#endif /* ALLPIX_RESPONSE_LIBRARY_H */
@@ -10,7 +10,9 @@
 #ifndef ALLPIX_RUNGE_KUTTA_H
 #define ALLPIX_RUNGE_KUTTA_H
 
+#include <array>
 #include <functional>
+#include <utility>
 
 #include <Eigen/Core>
 #include <Eigen/Geometry>
@@ -199,6 +201,208 @@ namespace allpix {
     }
     // clang-format on
 
+    // clang-format off
+    namespace static_tableau {
+        /**
+         * @brief Kutta's third order method
+         * @warning Without error function
+         */
+        struct RK3 {
+            static constexpr int stages = 3;
+            static constexpr std::array<std::array<double, 3>, 5> values{{
+                {{0, 0, 0}},
+                {{1.0/2, 0, 0}},
+                {{-1, 2, 0}},
+                {{1.0/6, 2.0/3, 1.0/6}},
+                {{0, 0, 0}}}};
+        };
+        /**
+         * @brief Classic original Runge-Kutta method
+         * @warning Without error function
+         */
+        struct RK4 {
+            static constexpr int stages = 4;
+            static constexpr std::array<std::array<double, 4>, 6> values{{
+                {{0, 0, 0, 0}},
+                {{1.0/2, 0, 0, 0}},
+                {{0, 1.0/2, 0, 0}},
+                {{0, 0, 1, 0}},
+                {{1.0/6, 1.0/3, 1.0/3, 1.0/6}},
+                {{0, 0, 0, 0}}}};
+        };
+        /**
+         * @brief Runge-Kutta-Fehlberg method
+         */
+        struct RK5 {
+            static constexpr int stages = 6;
+            static constexpr std::array<std::array<double, 6>, 8> values{{
+                {{0, 0, 0, 0, 0, 0}},
+                {{1.0/4, 0, 0, 0, 0, 0}},
+                {{3.0/32, 9.0/32, 0, 0, 0, 0}},
+                {{1932.0/2197, -7200.0/2197, 7296.0/2197, 0, 0, 0}},
+                {{439.0/216, -8, 3680.0/513, -845.0/4104, 0, 0}},
+                {{-8.0/27, 2, -3544.0/2565, 1859.0/4104, -11.0/40, 0}},
+                {{16.0/135, 0, 6656.0/12825, 28561.0/56430, -9.0/50, 2.0/55}},
+                {{25.0/216, 0, 1408.0/2565, 2197.0/4104, -1.0/5, 0}}}};
+        };
+    } // namespace static_tableau
+    // clang-format on
+
+    /**
+     * @brief Class to perform Runge-Kutta integration with a tableau and step function known at compile time
+     *
+     * Provides the same interface as \ref RungeKutta, but takes the tableau as one of the types in
+     * \ref allpix::static_tableau and the step function as template parameter. This allows the compiler to inline the step
+     * function and to fully unroll the stages, skipping all terms with a vanishing coefficient.
+     */
+    template <typename T, typename Tableau, typename Function, int D = 3> class StaticRungeKutta {
+        static constexpr std::size_t S = Tableau::stages;
+
+    public:
+        using Step = typename RungeKutta<T, static_cast<int>(S), D>::Step;
+
+        /**
+         * @brief Construct a Runge-Kutta integrator
+         * @param function Step function to perform integration
+         * @param step_size Time step of the integration
+         * @param initial_y Start values of the vector to perform integration on
+         * @param initial_t Initial time at the start of the integration
+         */
+        StaticRungeKutta(Function function, T step_size, Eigen::Matrix<T, D, 1> initial_y, T initial_t = 0)
+            : function_(std::move(function)), h_(std::move(step_size)), y_(std::move(initial_y)), t_(std::move(initial_t)) {
+            error_.setZero();
+        }
+
+        /**
+         * @brief Changes the time step
+         * @param step_size New time step of the integration
+         */
+        void setTimeStep(T step_size) { h_ = std::move(step_size); }
+        /**
+         * @brief Return the time step
+         * @return Current time step of the integration
+         */
+        T getTimeStep() { return h_; }
+
+        /**
+         * @brief Changes the current value during integration
+         * @note Can be used to add additional processes during the integration
+         */
+        void setValue(Eigen::Matrix<T, D, 1> y) { y_ = std::move(y); }
+
+        /**
+         * @brief Get the value to integrate
+         * @return Current value
+         */
+        Eigen::Matrix<T, D, 1> getValue() { return y_; }
+        /**
+         * @brief Get the total integration error
+         * @return Total integrated error
+         */
+        Eigen::Matrix<T, D, 1> getError() { return error_; }
+        /**
+         * @brief Get the time during integration
+         * @return Current time
+         */
+        T getTime() { return t_; }
+
+        /**
+         * @brief Execute a single time step of the integration
+         * @return Combination of the current value and the error in this single step
+         */
+        Step step() {
+            // Initialize values
+            Step step;
+            Eigen::Matrix<T, D, 1> ys;
+            Eigen::Matrix<T, D, 1> yse;
+            ys.setZero();
+            yse.setZero();
+
+            // Compute all stages
+            std::array<Eigen::Matrix<T, D, 1>, S> k;
+            compute_stages(k, ys, yse, std::make_index_sequence<S>{});
+
+            // Update values with new step
+            y_ += ys;
+            t_ += h_;
+            error_ += ys - yse;
+
+            // Return step information
+            step.value = ys;
+            step.error = ys - yse;
+            return step;
+        }
+
+        /**
+         * @brief Execute multiple time steps of the integration
+         * @param amount Number of steps to combine
+         * @return Combination of the current value and the total error in all the steps
+         */
+        Step step(int amount) {
+            Step result;
+            result.value.setZero();
+            result.error.setZero();
+            for(int i = 0; i < amount; ++i) {
+                Step single = step();
+                result.value += single.value;
+                result.error += single.error;
+            }
+            return result;
+        }
+
+    private:
+        /**
+         * @brief Add the contribution of a previous stage if its coefficient does not vanish
+         */
+        template <std::size_t R, std::size_t J>
+        void add_term(Eigen::Matrix<T, D, 1>& value, T& time, const std::array<Eigen::Matrix<T, D, 1>, S>& k) {
+            if constexpr(Tableau::values[R][J] != 0) {
+                value += h_ * Tableau::values[R][J] * k[J];
+                time += h_ * Tableau::values[R][J];
+            }
+        }
+
+        /**
+         * @brief Compute a single stage and add it to the value and the error estimate
+         */
+        template <std::size_t I, std::size_t... J>
+        void compute_stage(std::array<Eigen::Matrix<T, D, 1>, S>& k,
+                           Eigen::Matrix<T, D, 1>& ys,
+                           Eigen::Matrix<T, D, 1>& yse,
+                           std::index_sequence<J...>) {
+            Eigen::Matrix<T, D, 1> yt = y_;
+            T tt = t_;
+            (add_term<I, J>(yt, tt, k), ...);
+            k[I] = function_(tt, yt);
+
+            T unused_time{};
+            add_term<S, I>(ys, unused_time, k);
+            add_term<S + 1, I>(yse, unused_time, k);
+        }
+
+        /**
+         * @brief Compute all stages in order
+         */
+        template <std::size_t... I>
+        void compute_stages(std::array<Eigen::Matrix<T, D, 1>, S>& k,
+                            Eigen::Matrix<T, D, 1>& ys,
+                            Eigen::Matrix<T, D, 1>& yse,
+                            std::index_sequence<I...>) {
+            (compute_stage<I>(k, ys, yse, std::make_index_sequence<I>{}), ...);
+        }
+
+        Function function_;
+        // Step size
+        T h_;
+
+        // Vector to integrate
+        Eigen::Matrix<T, D, 1> y_;
+        // Total error vector
+        Eigen::Matrix<T, D, 1> error_;
+        // Current time
+        T t_;
+    };
+
     /**
      * @brief Utility function to create RungeKutta class using template deduction
      * @param tableau One of the possible Runge-Kutta tableaus (see \ref allpix::tableau)
@@ -209,6 +413,22 @@ namespace allpix {
     RungeKutta<T, S, D> make_runge_kutta(const Eigen::Matrix<T, S + 2, S>& tableau, Args&&... args) {
         return RungeKutta<T, S, D>(tableau, std::forward<Args>(args)...);
     }
+
+    /**
+     * @brief Utility function to create StaticRungeKutta class using template deduction
+     * @param tableau One of the possible compile-time Runge-Kutta tableaus (see \ref allpix::static_tableau)
+     * @param function Step function to perform integration
+     * @param step_size Time step of the integration
+     * @param initial_y Start values of the vector to perform integration on
+     * @param initial_t Initial time at the start of the integration
+     * @return Instantiation of \ref StaticRungeKutta class with the forwarded arguments
+     */
+    template <typename Tableau, typename Function, typename T, int D, int S = Tableau::stages>
+    StaticRungeKutta<T, Tableau, Function, D>
+    make_runge_kutta(Tableau, Function function, T step_size, Eigen::Matrix<T, D, 1> initial_y, T initial_t = 0) {
+        return StaticRungeKutta<T, Tableau, Function, D>(
+            std::move(function), std::move(step_size), std::move(initial_y), std::move(initial_t));
+    }
 } // namespace allpix
 
 #endif /* ALLPIX_RUNGE_KUTTA_H */
@@ -0,0 +1,307 @@
+/**
+ * @file
+ * @brief Histograms booked on their first fill with sparse storage of large binnings, converted to ROOT objects on writing
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#ifndef ALLPIX_SPARSE_HISTOGRAM_H
+#define ALLPIX_SPARSE_HISTOGRAM_H
+
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <TDirectory.h>
+#include <TH1D.h>
+#include <TH2D.h>
+#include <TProfile.h>
+#include <TProfile2D.h>
+
+#include "core/module/ThreadPool.hpp"
+
+namespace allpix {
+    /**
+     * @brief Histogram or profile with fixed binning in one or two dimensions, filled in parallel without booking the ROOT
+     * object
+     *
+     * Every thread accumulates the sums of its bins in its own storage, which is only allocated by the first fill of the
+     * thread. Binnings with more bins than the sparse threshold are stored in a hash table holding only the filled bins,
+     * smaller ones in a flat array. The ROOT histogram is only booked when merging the threads before writing, such that
+     * large maps which are mostly empty never hold a dense copy per thread.
+     *
+     * For histograms the third argument of Fill() is the weight, for profiles it is the value to average with unit weight.
+     * The statistics of the merged object are computed from the bin centres.
+     */
+    template <typename T> class ThreadedSparseHistogram {
+        static_assert(std::is_same<T, TH1D>::value || std::is_same<T, TH2D>::value || std::is_same<T, TProfile>::value ||
+                          std::is_same<T, TProfile2D>::value,
+                      "sparse histograms are only available as TH1D, TH2D, TProfile or TProfile2D");
+        static constexpr bool is_2d = std::is_base_of<TH2, T>::value;
+        static constexpr bool is_profile = std::is_same<T, TProfile>::value || std::is_same<T, TProfile2D>::value;
+
+    public:
+        /**
+         * @brief Construct a one-dimensional histogram or profile
+         * @param name Name of the histogram
+         * @param title Title of the histogram including the axis titles
+         * @param nbinsx Number of bins in x
+         * @param xlow Lower edge of the first bin in x
+         * @param xup Upper edge of the last bin in x
+         * @param vlow Lower limit of the values accepted by a profile, no limit if equal to the upper limit
+         * @param vup Upper limit of the values accepted by a profile
+         * @param sparse_threshold Number of bins above which only the filled bins are stored
+         */
+        ThreadedSparseHistogram(std::string name,
+                                std::string title,
+                                int nbinsx,
+                                double xlow,
+                                double xup,
+                                double vlow,
+                                double vup,
+                                size_t sparse_threshold)
+            : ThreadedSparseHistogram(
+                  std::move(name), std::move(title), nbinsx, xlow, xup, 0, 0., 0., vlow, vup, sparse_threshold) {}
+
+        /**
+         * @brief Construct a two-dimensional histogram or profile
+         * @param name Name of the histogram
+         * @param title Title of the histogram including the axis titles
+         * @param nbinsx Number of bins in x
+         * @param xlow Lower edge of the first bin in x
+         * @param xup Upper edge of the last bin in x
+         * @param nbinsy Number of bins in y
+         * @param ylow Lower edge of the first bin in y
+         * @param yup Upper edge of the last bin in y
+         * @param vlow Lower limit of the values accepted by a profile, no limit if equal to the upper limit
+         * @param vup Upper limit of the values accepted by a profile
+         * @param sparse_threshold Number of bins above which only the filled bins are stored
+         */
+        ThreadedSparseHistogram(std::string name,
+                                std::string title,
+                                int nbinsx,
+                                double xlow,
+                                double xup,
+                                int nbinsy,
+                                double ylow,
+                                double yup,
+                                double vlow,
+                                double vup,
+                                size_t sparse_threshold)
+            : name_(std::move(name)), title_(std::move(title)), nbinsx_(nbinsx), xlow_(xlow), xup_(xup),
+              nbinsy_(is_2d ? nbinsy : 0), ylow_(ylow), yup_(yup), vlow_(vlow), vup_(vup),
+              ncells_(static_cast<size_t>(nbinsx + 2) * static_cast<size_t>(is_2d ? nbinsy + 2 : 1)),
+              sparse_(static_cast<size_t>(nbinsx) * static_cast<size_t>(is_2d ? nbinsy : 1) > sparse_threshold),
+              storage_(ThreadPool::threadCount()) {}
+
+        /**
+         * @brief Fill a histogram or profile
+         * @param x Position in x
+         * @param y Position in y for two-dimensional histograms, otherwise the weight or value
+         * @param v Weight or value for two-dimensional histograms, ignored otherwise
+         */
+        void Fill(double x, double y = 1., double v = 1.) { // NOLINT
+            auto value = is_2d ? v : y;
+            if(is_profile && vlow_ != vup_ && (value < vlow_ || value > vup_)) {
+                return;
+            }
+
+            auto& storage = local();
+            auto cell = find_bin(x, nbinsx_, xlow_, xup_);
+            if(is_2d) {
+                cell += static_cast<size_t>(nbinsx_ + 2) * find_bin(y, nbinsy_, ylow_, yup_);
+            }
+            auto& bin = sparse_ ? storage.sparse[cell] : storage.dense[cell];
+            if(is_profile) {
+                bin.sumw += 1.;
+                bin.sumw2 += 1.;
+                bin.sumwv += value;
+                bin.sumwv2 += value * value;
+            } else {
+                bin.sumw += value;
+                bin.sumw2 += value * value;
+            }
+            ++storage.entries;
+        }
+
+        /**
+         * @brief Merge the bins of all threads into the final ROOT object
+         *
+         * The object is booked outside of any directory and can be written to the current directory.
+         */
+        std::shared_ptr<T> Merge() { // NOLINT
+            if(merged_ != nullptr) {
+                return merged_;
+            }
+
+            // Sum the bins of all threads
+            std::unordered_map<size_t, Bin> bins;
+            double entries = 0;
+            for(auto& storage : storage_) {
+                if(storage == nullptr) {
+                    continue;
+                }
+                entries += storage->entries;
+                auto add = [&](size_t cell, const Bin& bin) {
+                    auto& sum = bins[cell];
+                    sum.sumw += bin.sumw;
+                    sum.sumw2 += bin.sumw2;
+                    sum.sumwv += bin.sumwv;
+                    sum.sumwv2 += bin.sumwv2;
+                };
+                for(const auto& [cell, bin] : storage->sparse) {
+                    add(cell, bin);
+                }
+                for(size_t cell = 0; cell < storage->dense.size(); ++cell) {
+                    if(storage->dense[cell].sumw2 != 0) {
+                        add(cell, storage->dense[cell]);
+                    }
+                }
+                storage.reset();
+            }
+
+            // Book the ROOT object and set the sums of its bins
+            merged_ = book();
+            bool weighted = false;
+            for(const auto& [cell, bin] : bins) {
+                weighted |= (bin.sumw2 != bin.sumw);
+            }
+            if(!is_profile && weighted) {
+                merged_->Sumw2();
+            }
+            for(const auto& [cell, bin] : bins) {
+                auto index = static_cast<int>(cell);
+                if constexpr(is_profile) {
+                    merged_->SetBinEntries(index, bin.sumw);
+                    merged_->SetBinContent(index, bin.sumwv);
+                    (*merged_->GetSumw2())[index] = bin.sumwv2;
+                    if(merged_->GetBinSumw2()->fN > 0) {
+                        (*merged_->GetBinSumw2())[index] = bin.sumw2;
+                    }
+                } else {
+                    merged_->SetBinContent(index, bin.sumw);
+                    if(weighted) {
+                        (*merged_->GetSumw2())[index] = bin.sumw2;
+                    }
+                }
+            }
+            merged_->ResetStats();
+            merged_->SetEntries(entries);
+            return merged_;
+        }
+
+        /**
+         * @brief Merge the threads and write the ROOT object to the current directory
+         */
+        void Write() { this->Merge()->Write(); } // NOLINT
+
+    private:
+        /**
+         * @brief Sums of the fills of a single bin
+         *
+         * For histograms only the sum of weights and their squares are used, for profiles also the sum of the values and
+         * their squares.
+         */
+        struct Bin {
+            double sumw{};
+            double sumw2{};
+            double sumwv{};
+            double sumwv2{};
+        };
+
+        /**
+         * @brief Bins filled by a single thread
+         */
+        struct Storage {
+            std::vector<Bin> dense;
+            std::unordered_map<size_t, Bin> sparse;
+            double entries{};
+        };
+
+        /**
+         * @brief Get the storage of the current thread, allocating it on the first fill
+         */
+        Storage& local() {
+            auto& storage = storage_[ThreadPool::threadNum()];
+            if(storage == nullptr) {
+                storage = std::make_unique<Storage>();
+                if(!sparse_) {
+                    storage->dense.resize(ncells_);
+                }
+            }
+            return *storage;
+        }
+
+        /**
+         * @brief Find the bin of a coordinate along an axis with fixed binning, including the underflow and overflow bin
+         */
+        static size_t find_bin(double x, int nbins, double low, double up) {
+            if(x < low) {
+                return 0;
+            }
+            if(!(x < up)) {
+                return static_cast<size_t>(nbins) + 1;
+            }
+            return 1 + static_cast<size_t>(nbins * (x - low) / (up - low));
+        }
+
+        /**
+         * @brief Book the ROOT object without attaching it to the current directory
+         */
+        std::shared_ptr<T> book() const {
+            TDirectory::TContext context(nullptr);
+            if constexpr(std::is_same<T, TProfile2D>::value) {
+                return std::make_shared<T>(
+                    name_.c_str(), title_.c_str(), nbinsx_, xlow_, xup_, nbinsy_, ylow_, yup_, vlow_, vup_);
+            } else if constexpr(std::is_same<T, TProfile>::value) {
+                return std::make_shared<T>(name_.c_str(), title_.c_str(), nbinsx_, xlow_, xup_, vlow_, vup_);
+            } else if constexpr(is_2d) {
+                return std::make_shared<T>(name_.c_str(), title_.c_str(), nbinsx_, xlow_, xup_, nbinsy_, ylow_, yup_);
+            } else {
+                return std::make_shared<T>(name_.c_str(), title_.c_str(), nbinsx_, xlow_, xup_);
+            }
+        }
+
+        std::string name_;
+        std::string title_;
+        int nbinsx_;
+        double xlow_, xup_;
+        int nbinsy_;
+        double ylow_, yup_;
+        double vlow_, vup_;
+        size_t ncells_;
+        bool sparse_;
+
+        std::vector<std::unique_ptr<Storage>> storage_;
+        std::shared_ptr<T> merged_;
+    };
+
+    /**
+     * @brief Helper method to instantiate new objects of the type ThreadedSparseHistogram
+     * @param sparse_threshold Number of bins above which only the filled bins are stored
+     * @param args Name, title and binning of the histogram, followed by the range of accepted values for profiles
+     * @return Unique pointer to newly created object
+     *
+     * Profiles without a range of accepted values and histograms are created with an empty range.
+     */
+    template <typename T, class... ARGS>
+    std::unique_ptr<ThreadedSparseHistogram<T>> CreateSparseHistogram(size_t sparse_threshold, ARGS&&... args) {
+        constexpr auto nargs = sizeof...(ARGS);
+        if constexpr(nargs == 5 || nargs == 8) {
+            return std::make_unique<ThreadedSparseHistogram<T>>(std::forward<ARGS>(args)..., 0., 0., sparse_threshold);
+        } else {
+            return std::make_unique<ThreadedSparseHistogram<T>>(std::forward<ARGS>(args)..., sparse_threshold);
+        }
+    }
+
+    template <class T> using SparseHistogram = std::unique_ptr<ThreadedSparseHistogram<T>>;
+} // namespace allpix
+
+#endif /* ALLPIX_SPARSE_HISTOGRAM_H */
@@ -0,0 +1,538 @@
+/**
+ * @file
+ * @brief Merging of the data files written by the ROOTObjectWriter module in separate runs, ordered by event number
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <Math/Point3D.h>
+#include <Math/Rotation3D.h>
+#include <TBranch.h>
+#include <TClass.h>
+#include <TDirectory.h>
+#include <TFile.h>
+#include <TKey.h>
+#include <TObjArray.h>
+#include <TROOT.h>
+#include <TTree.h>
+
+#include "core/utils/log.h"
+#include "objects/Object.hpp"
+#include "tools/event_index.h"
+
+using namespace allpix;
+
+namespace {
+    /**
+     * @brief Data file to merge with its trees, the metadata stored next to them and its event index if available
+     */
+    struct Input {
+        std::string file_name;
+        std::unique_ptr<TFile> file;
+        std::map<std::string, TTree*> trees;
+        std::map<std::string, std::string> metadata;
+        Long64_t entries{};
+        bool indexed{};
+        EventIndex index;
+    };
+
+    /**
+     * @brief Entry of an input file written to the merged file
+     */
+    struct Entry {
+        uint64_t event;
+        size_t input;
+        size_t position;
+        Long64_t entry;
+    };
+
+    /**
+     * @brief Settings of a branch of the merged file, taken from the first input file holding the branch
+     */
+    struct BranchSettings {
+        std::string class_name;
+        int compression;
+        int basket_size;
+    };
+
+    // Directories of the data files holding the configuration and the detector setup instead of events
+    const std::set<std::string> metadata_directories = {"config", "detectors", "models"};
+
+    /**
+     * @brief Read all values of a metadata directory as text, keyed by their path in the file
+     *
+     * Values of types without textual representation are represented by their class name only.
+     */
+    void read_metadata(TDirectory* directory, const std::string& path, std::map<std::string, std::string>& metadata) {
+        for(auto* object : *directory->GetListOfKeys()) {
+            auto* key = static_cast<TKey*>(object);
+            auto name = path + "/" + key->GetName();
+            std::string class_name = key->GetClassName();
+
+            std::stringstream value;
+            if(class_name == "TDirectoryFile") {
+                read_metadata(directory->GetDirectory(key->GetName()), name, metadata);
+                continue;
+            } else if(class_name == "string") {
+                std::unique_ptr<std::string> text(
+                    static_cast<std::string*>(key->ReadObjectAny(TClass::GetClass<std::string>())));
+                value << *text;
+            } else if(class_name.find("PositionVector3D") != std::string::npos) {
+                std::unique_ptr<ROOT::Math::XYZPoint> point(
+                    static_cast<ROOT::Math::XYZPoint*>(key->ReadObjectAny(TClass::GetClass<ROOT::Math::XYZPoint>())));
+                value << point->x() << " " << point->y() << " " << point->z();
+            } else if(class_name == "ROOT::Math::Rotation3D") {
+                std::unique_ptr<ROOT::Math::Rotation3D> rotation(static_cast<ROOT::Math::Rotation3D*>(
+                    key->ReadObjectAny(TClass::GetClass<ROOT::Math::Rotation3D>())));
+                std::vector<double> components(9);
+                rotation->GetComponents(components.begin(), components.end());
+                for(auto component : components) {
+                    value << component << " ";
+                }
+            } else {
+                value << class_name;
+            }
+            metadata[name] = value.str();
+        }
+    }
+
+    /**
+     * @brief Copy a metadata directory to the merged file, except for the given values
+     */
+    void copy_metadata(TDirectory* source,
+                       TDirectory* target,
+                       const std::string& path,
+                       const std::set<std::string>& skipped) {
+        for(auto* object : *source->GetListOfKeys()) {
+            auto* key = static_cast<TKey*>(object);
+            auto name = path + "/" + key->GetName();
+            if(skipped.find(name) != skipped.end() || target->GetListOfKeys()->FindObject(key->GetName()) != nullptr) {
+                continue;
+            }
+
+            if(std::string(key->GetClassName()) == "TDirectoryFile") {
+                copy_metadata(source->GetDirectory(key->GetName()), target->mkdir(key->GetName()), name, skipped);
+                continue;
+            }
+            auto* value_class = TClass::GetClass(key->GetClassName());
+            auto* value = key->ReadObjectAny(value_class);
+            target->WriteObjectAny(value, value_class, key->GetName());
+            value_class->Destructor(value);
+        }
+    }
+
+    /**
+     * @brief Check whether a metadata value is a configuration key allowed to differ between the input files
+     * @param path Path of the value in the file
+     * @param ignored Keys given as section name and key separated by a dot
+     *
+     * Sections of module instances match both by their unique name and by the name of the module.
+     */
+    bool is_ignored(const std::string& path, const std::set<std::string>& ignored) {
+        auto section_end = path.rfind('/');
+        if(path.compare(0, 7, "config/") != 0 || section_end < 7) {
+            return false;
+        }
+        auto section = path.substr(7, section_end - 7);
+        auto key = path.substr(section_end + 1);
+        auto module = section.substr(0, section.find(':'));
+        return ignored.find(section + "." + key) != ignored.end() || ignored.find(module + "." + key) != ignored.end();
+    }
+
+    /**
+     * @brief Open an input file and read its trees, its metadata and its event index
+     */
+    Input open_input(const std::string& file_name) {
+        Input input;
+        input.file_name = file_name;
+        input.file = std::unique_ptr<TFile>(TFile::Open(file_name.c_str(), "READ"));
+        if(input.file == nullptr || input.file->IsZombie()) {
+            throw std::runtime_error("cannot open input file " + file_name);
+        }
+
+        for(auto* object : *input.file->GetListOfKeys()) {
+            auto* key = static_cast<TKey*>(object);
+            std::string name = key->GetName();
+            std::string class_name = key->GetClassName();
+            if(class_name == "TTree" && input.trees.find(name) == input.trees.end()) {
+                TTree* tree = nullptr;
+                input.file->GetObject(name.c_str(), tree);
+                input.trees[name] = tree;
+                input.entries = std::max(input.entries, tree->GetEntries());
+            } else if(class_name == "TDirectoryFile" && metadata_directories.find(name) != metadata_directories.end()) {
+                read_metadata(input.file->GetDirectory(name.c_str()), name, input.metadata);
+            }
+        }
+        if(input.metadata.empty()) {
+            throw std::runtime_error("input file " + file_name + " holds no configuration, it has not been written by " +
+                                     "the ROOTObjectWriter module");
+        }
+
+        auto index_file_name = std::filesystem::path(file_name).replace_extension("apidx").string();
+        if(std::filesystem::exists(index_file_name)) {
+            input.index = event_index::read(index_file_name);
+            input.indexed = true;
+            for(auto entry : input.index.entries) {
+                if(static_cast<Long64_t>(entry) >= input.entries) {
+                    throw std::runtime_error("event index " + index_file_name + " does not match the data file, entry " +
+                                             std::to_string(entry) + " is not stored");
+                }
+            }
+        }
+
+        LOG(INFO) << "Opened input file " << file_name << " with " << input.entries << " events in "
+                  << input.trees.size() << " trees" << (input.indexed ? " and its event index" : "");
+        return input;
+    }
+
+    /**
+     * @brief Compare the metadata of all input files and return the values to leave out of the merged file
+     * @throws std::runtime_error If a value which is not ignored differs
+     */
+    std::set<std::string> compare_metadata(const std::vector<Input>& inputs, const std::set<std::string>& ignored) {
+        std::set<std::string> differing;
+        std::stringstream errors;
+        const auto& reference = inputs.front();
+        for(auto input = std::next(inputs.begin()); input != inputs.end(); ++input) {
+            std::set<std::string> paths;
+            for(const auto& value : reference.metadata) {
+                paths.insert(value.first);
+            }
+            for(const auto& value : input->metadata) {
+                paths.insert(value.first);
+            }
+
+            for(const auto& path : paths) {
+                auto reference_value = reference.metadata.find(path);
+                auto value = input->metadata.find(path);
+                if(reference_value != reference.metadata.end() && value != input->metadata.end() &&
+                   reference_value->second == value->second) {
+                    continue;
+                }
+                differing.insert(path);
+                if(!is_ignored(path, ignored)) {
+                    errors << std::endl
+                           << path << ": \""
+                           << (reference_value != reference.metadata.end() ? reference_value->second : "<missing>")
+                           << "\" in " << reference.file_name << ", \""
+                           << (value != input->metadata.end() ? value->second : "<missing>") << "\" in "
+                           << input->file_name;
+                }
+            }
+        }
+
+        if(!errors.str().empty()) {
+            throw std::runtime_error("configuration of the input files does not match:" + errors.str());
+        }
+        for(const auto& path : differing) {
+            LOG(DEBUG) << "Leaving out " << path << " which differs between the input files";
+        }
+        return differing;
+    }
+
+    /**
+     * @brief Order the entries of all inputs by their event number
+     *
+     * Without event index of every input, the files are ordered by their partition if all of them have one, and given order
+     * otherwise. Their entries are concatenated without checking the event numbers.
+     */
+    std::vector<Entry> order_entries(std::vector<Input>& inputs) {
+        std::vector<Entry> entries;
+        auto all_indexed = std::all_of(inputs.begin(), inputs.end(), [](const Input& input) { return input.indexed; });
+        if(all_indexed) {
+            for(size_t i = 0; i < inputs.size(); ++i) {
+                const auto& index = inputs[i].index;
+                for(size_t position = 0; position < index.events.size(); ++position) {
+                    entries.push_back(
+                        {index.events[position], i, position, static_cast<Long64_t>(index.entries[position])});
+                }
+            }
+            std::stable_sort(
+                entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) { return lhs.event < rhs.event; });
+            for(size_t i = 1; i < entries.size(); ++i) {
+                if(entries[i].event == entries[i - 1].event) {
+                    throw std::runtime_error("event " + std::to_string(entries[i].event) + " is stored in both " +
+                                             inputs[entries[i - 1].input].file_name + " and " +
+                                             inputs[entries[i].input].file_name);
+                }
+            }
+            LOG(STATUS) << "Ordering " << entries.size() << " events by their number from the event indices";
+            return entries;
+        }
+
+        if(std::any_of(inputs.begin(), inputs.end(), [](const Input& input) { return input.indexed; })) {
+            LOG(WARNING) << "Not all input files have an event index, ignoring the existing indices";
+        }
+        auto has_partition = [](const Input& input) {
+            return input.metadata.find("config/Allpix/partition") != input.metadata.end();
+        };
+        if(std::all_of(inputs.begin(), inputs.end(), has_partition)) {
+            auto partition = [](const Input& input) { return std::stoull(input.metadata.at("config/Allpix/partition")); };
+            std::stable_sort(inputs.begin(), inputs.end(), [&](const auto& lhs, const auto& rhs) {
+                return partition(lhs) < partition(rhs);
+            });
+            for(size_t i = 1; i < inputs.size(); ++i) {
+                if(partition(inputs[i]) == partition(inputs[i - 1])) {
+                    throw std::runtime_error("input files " + inputs[i - 1].file_name + " and " + inputs[i].file_name +
+                                             " hold the same partition");
+                }
+            }
+            LOG(STATUS) << "Ordering input files by their partition";
+        } else {
+            LOG(STATUS) << "Concatenating input files in the given order";
+        }
+
+        uint64_t event = 0;
+        for(size_t i = 0; i < inputs.size(); ++i) {
+            for(Long64_t entry = 0; entry < inputs[i].entries; ++entry) {
+                entries.push_back({++event, i, static_cast<size_t>(entry), entry});
+            }
+        }
+        return entries;
+    }
+} // namespace
+
+int main(int argc, const char* argv[]) {
+
+    int return_code = 0;
+    try {
+        // Add cout as the default logging stream
+        Log::addStream(std::cout);
+
+        // If no arguments are provided, print the help:
+        bool print_help = false;
+        if(argc == 1) {
+            print_help = true;
+            return_code = 1;
+        }
+
+        // Parse arguments
+        std::string output_file_name;
+        std::vector<std::string> input_file_names;
+        std::set<std::string> ignored = {"Allpix.partition", "Allpix.output_directory", "Allpix.log_file"};
+        unsigned int threads = 1;
+        bool force = false;
+        for(int i = 1; i < argc; i++) {
+            if(strcmp(argv[i], "-h") == 0) {
+                print_help = true;
+            } else if(strcmp(argv[i], "-v") == 0 && (i + 1 < argc)) {
+                try {
+                    LogLevel log_level = Log::getLevelFromString(std::string(argv[++i]));
+                    Log::setReportingLevel(log_level);
+                } catch(std::invalid_argument& e) {
+                    LOG(ERROR) << "Invalid verbosity level \"" << std::string(argv[i]) << "\", ignoring overwrite";
+                }
+            } else if(strcmp(argv[i], "-o") == 0 && (i + 1 < argc)) {
+                output_file_name = std::string(argv[++i]);
+            } else if(strcmp(argv[i], "-j") == 0 && (i + 1 < argc)) {
+                threads = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } else if(strcmp(argv[i], "-x") == 0 && (i + 1 < argc)) {
+                ignored.insert(std::string(argv[++i]));
+            } else if(strcmp(argv[i], "-f") == 0) {
+                force = true;
+            } else if(argv[i][0] != '-') {
+                input_file_names.emplace_back(argv[i]);
+            } else {
+                LOG(ERROR) << "Unrecognized command line argument \"" << argv[i] << "\"";
+                print_help = true;
+                return_code = 1;
+            }
+        }
+        if(!print_help && (output_file_name.empty() || input_file_names.empty())) {
+            LOG(ERROR) << "No output file or no input files given";
+            print_help = true;
+            return_code = 1;
+        }
+
+        // Print help if requested or no arguments given
+        if(print_help) {
+            std::cout << "Allpix Squared Data File Merging Tool" << std::endl;
+            std::cout << std::endl;
+            std::cout << "Usage: allpix_merge -o <file> [<options>] <input files>" << std::endl;
+            std::cout << std::endl;
+            std::cout << "Merges the data files written by the ROOTObjectWriter module in separate runs of the same"
+                      << std::endl;
+            std::cout << "configuration, ordering the events by their number if every file has an event index." << std::endl;
+            std::cout << std::endl;
+            std::cout << "Options:" << std::endl;
+            std::cout << "  -o <file>     merged output file, mandatory" << std::endl;
+            std::cout << "  -f            overwrite an existing output file" << std::endl;
+            std::cout << "  -j <threads>  number of threads to decompress and compress the branches with" << std::endl;
+            std::cout << "  -x <key>      configuration key allowed to differ, given as <section>.<key>" << std::endl;
+            std::cout << "  -v <level>    verbosity level, overwriting the global level" << std::endl;
+            std::cout << "  -h            print this help text" << std::endl;
+            std::cout << std::endl;
+            std::cout << "For more help, please see <https://cern.ch/allpix-squared>" << std::endl;
+            return return_code;
+        }
+
+        if(std::filesystem::exists(output_file_name) && !force) {
+            throw std::runtime_error("output file " + output_file_name + " exists, use -f to overwrite it");
+        }
+        for(const auto& input_file_name : input_file_names) {
+            if(std::filesystem::exists(output_file_name) &&
+               std::filesystem::equivalent(input_file_name, output_file_name)) {
+                throw std::runtime_error("output file " + output_file_name + " is also given as input file");
+            }
+        }
+
+        // The branches of every tree are read and written by parallel tasks of ROOT
+        if(threads > 1) {
+            ROOT::EnableImplicitMT(threads);
+            LOG(STATUS) << "Decompressing and compressing branches with " << threads << " threads";
+        }
+
+        // Open all input files and check that they were simulated with the same configuration
+        std::vector<Input> inputs;
+        for(const auto& input_file_name : input_file_names) {
+            inputs.push_back(open_input(input_file_name));
+        }
+        auto differing = compare_metadata(inputs, ignored);
+        auto entries = order_entries(inputs);
+
+        // Collect the trees and branches of all inputs
+        std::map<std::string, std::map<std::string, BranchSettings>> tree_branches;
+        std::map<std::string, Long64_t> tree_auto_flush;
+        for(const auto& input : inputs) {
+            for(const auto& tree : input.trees) {
+                tree_auto_flush.emplace(tree.first, tree.second->GetAutoFlush());
+                auto& branches = tree_branches[tree.first];
+                TObjArray* list = tree.second->GetListOfBranches();
+                for(int i = 0; i < list->GetEntries(); ++i) {
+                    auto* branch = static_cast<TBranch*>(list->At(i));
+                    BranchSettings settings{
+                        branch->GetClassName(), branch->GetCompressionSettings(), branch->GetBasketSize()};
+                    auto iter = branches.emplace(branch->GetName(), settings).first;
+                    if(iter->second.class_name != settings.class_name) {
+                        throw std::runtime_error("branch " + tree.first + "/" + iter->first + " holds " +
+                                                 iter->second.class_name + " in " + inputs.front().file_name + " but " +
+                                                 settings.class_name + " in " + input.file_name);
+                    }
+                }
+            }
+        }
+
+        // Create the output file with the trees and branches of all inputs
+        auto output_file = std::make_unique<TFile>(
+            output_file_name.c_str(), "RECREATE", "", inputs.front().file->GetCompressionSettings());
+        if(output_file->IsZombie()) {
+            throw std::runtime_error("cannot create output file " + output_file_name);
+        }
+        std::map<std::string, TTree*> output_trees;
+        std::map<std::pair<std::string, std::string>, std::vector<Object*>*> objects;
+        for(const auto& tree : tree_branches) {
+            output_file->cd();
+            auto* output_tree = new TTree(tree.first.c_str(), (std::string("Tree of ") + tree.first).c_str());
+            output_tree->SetAutoFlush(tree_auto_flush.at(tree.first));
+            output_trees.emplace(tree.first, output_tree);
+            for(const auto& branch : tree.second) {
+                auto& branch_objects = objects[std::make_pair(tree.first, branch.first)];
+                branch_objects = new std::vector<Object*>();
+                auto* output_branch = output_tree->Bronch(
+                    branch.first.c_str(), branch.second.class_name.c_str(), &branch_objects, branch.second.basket_size);
+                output_branch->SetCompressionSettings(branch.second.compression);
+            }
+        }
+
+        // Bind the branches of all inputs to the objects of the output branches
+        for(auto& input : inputs) {
+            for(auto& tree : input.trees) {
+                TObjArray* list = tree.second->GetListOfBranches();
+                for(int i = 0; i < list->GetEntries(); ++i) {
+                    auto* branch = static_cast<TBranch*>(list->At(i));
+                    branch->SetAddress(&objects.at(std::make_pair(tree.first, std::string(branch->GetName()))));
+                }
+            }
+        }
+
+        auto clear_objects = [&objects]() {
+            for(auto& branch_objects : objects) {
+                for(auto* object : *branch_objects.second) {
+                    delete object;
+                }
+                branch_objects.second->clear();
+            }
+        };
+
+        // Copy the entries in order, trees missing in an input get empty entries
+        for(size_t i = 0; i < entries.size(); ++i) {
+            const auto& entry = entries[i];
+            clear_objects();
+            for(auto& tree : inputs[entry.input].trees) {
+                tree.second->GetEntry(entry.entry);
+            }
+
+            output_file->cd();
+            for(auto& tree : output_trees) {
+                tree.second->Fill();
+            }
+            LOG_PROGRESS(STATUS, "MERGE") << "Merged " << (i + 1) << " of " << entries.size() << " events";
+        }
+        clear_objects();
+
+        // Copy the metadata of the first input, which matches all others except for the values left out
+        for(const auto& name : metadata_directories) {
+            auto* source = inputs.front().file->GetDirectory(name.c_str());
+            if(source != nullptr) {
+                copy_metadata(source, output_file->mkdir(name.c_str()), name, differing);
+            }
+        }
+
+        output_file->Write();
+        LOG(STATUS) << "Wrote " << entries.size() << " events from " << inputs.size() << " input files to "
+                    << output_trees.size() << " trees in file:" << std::endl
+                    << output_file_name;
+        output_file->Close();
+        for(auto& branch_objects : objects) {
+            delete branch_objects.second;
+        }
+
+        // Write the index of the merged file if the events were ordered by the indices of the inputs
+        if(std::all_of(inputs.begin(), inputs.end(), [](const Input& input) { return input.indexed; })) {
+            EventIndex index;
+            std::map<std::string, size_t> columns;
+            for(const auto& tree : output_trees) {
+                columns.emplace(tree.first, index.trees.size());
+                index.trees.push_back(tree.first);
+            }
+            index.counts.resize(entries.size() * index.trees.size());
+            for(size_t i = 0; i < entries.size(); ++i) {
+                const auto& entry = entries[i];
+                const auto& input_index = inputs[entry.input].index;
+                index.events.push_back(entry.event);
+                index.entries.push_back(i);
+                for(size_t tree = 0; tree < input_index.trees.size(); ++tree) {
+                    auto column = columns.find(input_index.trees[tree]);
+                    if(column != columns.end()) {
+                        index.counts[i * index.trees.size() + column->second] = input_index.count(entry.position, tree);
+                    }
+                }
+            }
+
+            auto index_file_name = std::filesystem::path(output_file_name).replace_extension("apidx").string();
+            event_index::write(index_file_name, index);
+            LOG(STATUS) << "Wrote index of " << index.events.size() << " events to file:" << std::endl << index_file_name;
+        }
+    } catch(std::exception& e) {
+        LOG(FATAL) << "Fatal internal error" << std::endl << e.what() << std::endl << "Cannot continue.";
+        return_code = 127;
+    }
+
+    return return_code;
+}
@@ -3,6 +3,7 @@
  * @brief Small converter for field data INIT <-> APF
  */
 
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <vector>
@@ -13,19 +14,41 @@
 
 using namespace allpix;
 
-template <typename T> static void print_info(allpix::FieldData<T> field_data, size_t n, std::string units) {
+template <typename T>
+static void print_info(allpix::FieldParser<T>& field_parser, const std::string& file_name, size_t n, std::string units) {
+    // Only the header is read, the field data is not loaded into memory
+    auto field_data = field_parser.readHeader(file_name);
+
     std::cout << "Header:     \"" << field_data.getHeader() << "\"" << std::endl;
     std::cout << "Field size: " << Units::display(field_data.getSize()[0], "um") << " x "
               << Units::display(field_data.getSize()[1], "um") << " x " << Units::display(field_data.getSize()[2], "um")
               << std::endl;
     std::cout << "Dimensions: " << field_data.getDimensions()[0] << " x " << field_data.getDimensions()[1] << " x "
               << field_data.getDimensions()[2] << " cells" << std::endl;
-    std::cout << "Field vector with " << field_data.getData()->size() << " entries" << std::endl;
+    if(!field_data.getZEdges().empty()) {
+        std::cout << "Z binning:  non-uniform, bin edges";
+        for(auto edge : field_data.getZEdges()) {
+            std::cout << " " << Units::display(edge, "um");
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "Field vector with " << field_data.getEntries() << " entries" << std::endl;
 
     if(n > 0) {
         std::cout << "First " << n << " entries of field data:" << std::endl;
-        for(size_t i = 0; i < field_data.getData()->size() && i < n; i++) {
-            std::cout << Units::display(field_data.getData()->at(i), units) << " ";
+        std::vector<T> values(std::min(n, field_data.getEntries()));
+        if(field_parser.getFileType(file_name) == FileType::INIT) {
+            // Field points of INIT files are not ordered, the full file needs to be parsed
+            field_parser.readValues(file_name, "", [&values](size_t index, T value) {
+                if(index < values.size()) {
+                    values[index] = value;
+                }
+            });
+        } else {
+            field_parser.readEntries(file_name, 0, values.size(), values.data());
+        }
+        for(auto value : values) {
+            std::cout << Units::display(value, units) << " ";
         }
         std::cout << std::endl;
     }
@@ -93,12 +116,10 @@ int main(int argc, const char* argv[]) {
             std::cout << "FILE:       " << file_input << std::endl;
             try {
                 FieldParser<double> field_parser(FieldQuantity::VECTOR);
-                auto field_data = field_parser.getByFileName(file_input);
-                print_info(field_data, n, units);
+                print_info(field_parser, file_input, n, units);
             } catch(std::runtime_error& e) {
                 FieldParser<double> field_parser(FieldQuantity::SCALAR);
-                auto field_data = field_parser.getByFileName(file_input);
-                print_info(field_data, n, units);
+                print_info(field_parser, file_input, n, units);
             }
         }
 
@@ -53,7 +53,10 @@ int main(int argc, const char* argv[]) {
             } else if(strcmp(argv[i], "--to") == 0 && (i + 1 < argc)) {
                 std::string format = std::string(argv[++i]);
                 std::transform(format.begin(), format.end(), format.begin(), ::tolower);
-                format_to = (format == "init" ? FileType::INIT : format == "apf" ? FileType::APF : FileType::UNKNOWN);
+                format_to = (format == "init"      ? FileType::INIT
+                             : format == "apf"     ? FileType::APF
+                             : format == "apf_raw" ? FileType::APF_RAW
+                                                   : FileType::UNKNOWN);
             } else if(strcmp(argv[i], "--input") == 0 && (i + 1 < argc)) {
                 file_input = std::string(argv[++i]);
             } else if(strcmp(argv[i], "--output") == 0 && (i + 1 < argc)) {
@@ -76,7 +79,7 @@ int main(int argc, const char* argv[]) {
             std::cout << "Usage: field_converter <parameters>" << std::endl;
             std::cout << std::endl;
             std::cout << "Parameters (all mandatory):" << std::endl;
-            std::cout << "  --to <format>    file format of the output file" << std::endl;
+            std::cout << "  --to <format>    file format of the output file, either init, apf or apf_raw" << std::endl;
             std::cout << "  --input <file>   input field file" << std::endl;
             std::cout << "  --output <file>  output field file" << std::endl;
             std::cout << "  --units <units>  units the field is provided in" << std::endl << std::endl;
@@ -90,11 +93,28 @@ int main(int argc, const char* argv[]) {
         FieldQuantity quantity = (scalar ? FieldQuantity::SCALAR : FieldQuantity::VECTOR);
 
         FieldParser<double> field_parser(quantity);
-        LOG(STATUS) << "Reading input file from " << file_input;
-        auto field_data = field_parser.getByFileName(file_input, units);
         FieldWriter<double> field_writer(quantity);
+        auto output_units = (format_to == FileType::INIT ? units : "");
+        LOG(STATUS) << "Reading input file from " << file_input;
+        auto input_type = field_parser.getFileType(file_input);
+        auto header = field_parser.readHeader(file_input, units);
+
         LOG(STATUS) << "Writing output file to " << file_output;
-        field_writer.writeFile(field_data, file_output, format_to, (format_to == FileType::INIT ? units : ""));
+        if(input_type != FileType::INIT) {
+            // Binary files are read in slices while the output file is written
+            field_writer.writeFileStreaming(
+                header, file_output, format_to, output_units, [&](size_t first, size_t count, double* values) {
+                    field_parser.readEntries(file_input, first, count, values);
+                });
+        } else if(format_to != FileType::INIT) {
+            // The field points of INIT files are parsed concurrently and stored directly in the mapped output file
+            field_writer.writeFileMapped(header, file_output, format_to, [&](auto&& store) {
+                field_parser.readValues(file_input, units, store);
+            });
+        } else {
+            auto field_data = field_parser.getByFileName(file_input, units);
+            field_writer.writeFile(field_data, file_output, format_to, output_units);
+        }
     } catch(std::exception& e) {
         LOG(FATAL) << "Fatal internal error" << std::endl << e.what() << std::endl << "Cannot continue.";
         return_code = 127;
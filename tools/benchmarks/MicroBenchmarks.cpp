@@ -0,0 +1,314 @@
+/**
+ * @file
+ * @brief Microbenchmarks of the performance critical functions of the core framework and the physics models
+ *
+ * @copyright Copyright (c) 2021 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Math/Point3D.h>
+#include <Math/Rotation3D.h>
+#include <Math/Vector3D.h>
+#include <benchmark/benchmark.h>
+
+#include "core/config/ConfigReader.hpp"
+#include "core/config/Configuration.hpp"
+#include "core/geometry/Detector.hpp"
+#include "core/geometry/MonolithicPixelDetectorModel.hpp"
+#include "core/messenger/Messenger.hpp"
+#include "core/module/Event.hpp"
+#include "core/module/Module.hpp"
+#include "core/utils/distributions.h"
+#include "core/utils/prng.h"
+#include "objects/PixelHit.hpp"
+#include "objects/Pulse.hpp"
+#include "physics/Mobility.hpp"
+#include "physics/Recombination.hpp"
+#include "tools/runge_kutta.h"
+#include "tools/units.h"
+
+using namespace allpix;
+
+namespace {
+    /**
+     * @brief Create a detector with a small monolithic model to attach fields to
+     * @return Detector at the origin
+     */
+    std::shared_ptr<Detector> create_detector() {
+        std::stringstream model_config;
+        model_config << "type = \"monolithic\"" << std::endl
+                     << "number_of_pixels = 64 64" << std::endl
+                     << "pixel_size = 55um 55um" << std::endl
+                     << "sensor_thickness = 300um" << std::endl;
+        auto model = std::make_shared<MonolithicPixelDetectorModel>("benchmark", ConfigReader(model_config));
+        return std::make_shared<Detector>("benchmark", model, ROOT::Math::XYZPoint(), ROOT::Math::Rotation3D());
+    }
+
+    /**
+     * @brief Positions spread over the sensor of the detector at which fields are looked up
+     * @param detector Detector to generate the positions for
+     * @param count Number of positions
+     * @return Pseudo-random positions in the local frame
+     */
+    std::vector<ROOT::Math::XYZPoint> create_positions(const Detector& detector, size_t count) {
+        auto model = detector.getModel();
+        auto center = model->getSensorCenter();
+        auto size = model->getSensorSize();
+
+        RandomNumberGenerator random_generator;
+        random_generator.seed(0);
+        allpix::uniform_real_distribution<double> uniform(-0.5, 0.5);
+        std::vector<ROOT::Math::XYZPoint> positions;
+        positions.reserve(count);
+        for(size_t i = 0; i < count; ++i) {
+            positions.emplace_back(center.x() + uniform(random_generator) * size.x(),
+                                   center.y() + uniform(random_generator) * size.y(),
+                                   center.z() + uniform(random_generator) * size.z());
+        }
+        return positions;
+    }
+
+    /**
+     * @brief Look up the electric field from a grid with 50x50x100 bins per pixel
+     * @param state Benchmark state, the argument selects nearest (0) or linear (1) interpolation and double (0) or single
+     * (1) precision
+     */
+    void electric_field_grid(benchmark::State& state) {
+        auto detector = create_detector();
+        std::array<size_t, 3> dimensions{{50, 50, 100}};
+        auto entries = dimensions[0] * dimensions[1] * dimensions[2] * 3;
+        auto field = std::make_shared<std::vector<double>>(entries);
+        for(size_t i = 0; i < entries; ++i) {
+            (*field)[i] = static_cast<double>(i % 997) * 1e-3;
+        }
+        auto thickness = detector->getModel()->getSensorSize().z();
+        detector->setElectricFieldGrid(std::shared_ptr<const double>(field, field->data()),
+                                       entries,
+                                       dimensions,
+                                       std::array<double, 2>{{1, 1}},
+                                       std::array<double, 2>{{0, 0}},
+                                       std::make_pair(-thickness / 2, thickness / 2),
+                                       state.range(0) == 0 ? FieldInterpolation::NEAREST : FieldInterpolation::LINEAR,
+                                       state.range(1) == 0 ? FieldPrecision::DOUBLE : FieldPrecision::SINGLE);
+
+        auto positions = create_positions(*detector, 4096);
+        size_t index = 0;
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(detector->getElectricField(positions[index++ % positions.size()]));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(electric_field_grid)->ArgNames({"linear", "single"})->Args({0, 0})->Args({1, 0})->Args({0, 1})->Args({1, 1});
+
+    /**
+     * @brief Look up the electric field from a linear function
+     * @param state Benchmark state
+     */
+    void electric_field_function(benchmark::State& state) {
+        auto detector = create_detector();
+        auto thickness = detector->getModel()->getSensorSize().z();
+        detector->setElectricFieldFunction(
+            [](const ROOT::Math::XYZPoint& pos) { return ROOT::Math::XYZVector(0, 0, 1e-3 + 1e-2 * pos.z()); },
+            std::make_pair(-thickness / 2, thickness / 2),
+            FieldType::LINEAR);
+
+        auto positions = create_positions(*detector, 4096);
+        size_t index = 0;
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(detector->getElectricField(positions[index++ % positions.size()]));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(electric_field_function);
+
+    // Names of the mobility models benchmarked
+    const std::vector<std::string> mobility_models = {
+        "jacoboni", "canali", "hamburg", "hamburg_highfield", "masetti", "masetti_canali", "arora"};
+
+    /**
+     * @brief Evaluate a mobility model for electrons over a range of field magnitudes
+     * @param state Benchmark state, the argument selects the model from the list of models
+     */
+    void mobility(benchmark::State& state) {
+        const auto& model = mobility_models.at(static_cast<size_t>(state.range(0)));
+        state.SetLabel(model);
+        Mobility mobility(model, 293.15, true);
+
+        double efield_mag = 0;
+        double doping = 1e12;
+        for(auto _ : state) {
+            efield_mag = (efield_mag > 1e-2 ? 0 : efield_mag + 1e-6);
+            benchmark::DoNotOptimize(mobility(CarrierType::ELECTRON, efield_mag, doping));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(mobility)->DenseRange(0, 6);
+
+    // Names of the recombination models benchmarked
+    const std::vector<std::string> recombination_models = {"srh", "auger", "combined"};
+
+    /**
+     * @brief Evaluate a recombination model for electrons
+     * @param state Benchmark state, the argument selects the model from the list of models
+     */
+    void recombination(benchmark::State& state) {
+        const auto& model = recombination_models.at(static_cast<size_t>(state.range(0)));
+        state.SetLabel(model);
+        Recombination recombination(model, true);
+
+        double survival = 0;
+        for(auto _ : state) {
+            survival = (survival > 1 ? 0 : survival + 1e-3);
+            benchmark::DoNotOptimize(recombination(CarrierType::ELECTRON, 1e12, survival, 1e-3));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(recombination)->DenseRange(0, 2);
+
+    /**
+     * @brief Consume the survival time of an electron drawn once instead of evaluating the survival every step
+     * @param state Benchmark state, the argument selects the model from the list of models
+     */
+    void recombination_survival_time(benchmark::State& state) {
+        const auto& model = recombination_models.at(static_cast<size_t>(state.range(0)));
+        state.SetLabel(model);
+        Recombination recombination(model, true);
+
+        double survival_time = std::numeric_limits<double>::max();
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(recombination.consume(CarrierType::ELECTRON, 1e12, survival_time, 1e-3));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(recombination_survival_time)->DenseRange(0, 2);
+
+    /**
+     * @brief Execute single steps of the Runge-Kutta integrator with the RK5 tableau used for the propagation
+     * @param state Benchmark state
+     */
+    void runge_kutta_step(benchmark::State& state) {
+        auto velocity = [](double, const Eigen::Vector3d& pos) -> Eigen::Vector3d {
+            return Eigen::Vector3d(-1e-3 * pos.y(), 1e-3 * pos.x(), -1e-2 * (pos.z() - 0.15));
+        };
+        auto runge_kutta = make_runge_kutta(static_tableau::RK5(), velocity, 0.01, Eigen::Vector3d(0.01, 0.02, 0.));
+        for(auto _ : state) {
+            runge_kutta.step();
+        }
+        benchmark::DoNotOptimize(runge_kutta.getValue());
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(runge_kutta_step);
+
+    /**
+     * @brief Draw normally distributed numbers as for the diffusion of every step
+     * @param state Benchmark state, the argument selects the Mersenne twister (0) or Philox (1) engine
+     */
+    void normal_distribution(benchmark::State& state) {
+        auto engine = (state.range(0) == 0 ? RandomNumberGenerator::Engine::MERSENNE_TWISTER
+                                            : RandomNumberGenerator::Engine::PHILOX);
+        RandomNumberGenerator random_generator(engine);
+        random_generator.seed(0);
+        allpix::normal_distribution<double> gauss(0, 1);
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(gauss(random_generator));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(normal_distribution)->ArgName("philox")->Arg(0)->Arg(1);
+
+    /**
+     * @brief Add the induced charge of single steps to a pulse
+     * @param state Benchmark state
+     */
+    void pulse_add_charge(benchmark::State& state) {
+        Pulse pulse(0.01, 25);
+        double time = 0;
+        for(auto _ : state) {
+            time = (time > 25 ? 0 : time + 0.003);
+            pulse.addCharge(1, time);
+        }
+        benchmark::DoNotOptimize(pulse.getCharge());
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(pulse_add_charge);
+
+    /**
+     * @brief Convert a value to display units as done when filling histograms
+     * @param state Benchmark state, the argument selects the string-based conversion (0) or the unit constant (1)
+     */
+    void unit_conversion(benchmark::State& state) {
+        double time = 0;
+        for(auto _ : state) {
+            time = (time > 25 ? 0 : time + 0.003);
+            if(state.range(0) == 0) {
+                benchmark::DoNotOptimize(static_cast<double>(Units::convert(time, "ns")));
+            } else {
+                benchmark::DoNotOptimize(time / units::ns);
+            }
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(unit_conversion)->ArgName("constant")->Arg(0)->Arg(1);
+
+    /**
+     * @brief Minimal module used as sender and receiver of messages
+     */
+    class BenchmarkModule : public Module {
+    public:
+        explicit BenchmarkModule(Configuration& config) : Module(config) {}
+    };
+
+    /**
+     * @brief Dispatch a message to a bound receiver and fetch it again within a new event
+     * @param state Benchmark state
+     */
+    void messenger_dispatch(benchmark::State& state) {
+        Messenger messenger;
+        Configuration config("BenchmarkModule");
+        config.set<std::string>("input", "");
+        config.set<std::string>("output", "");
+        BenchmarkModule sender(config);
+        BenchmarkModule receiver(config);
+        messenger.bindMulti<PixelHitMessage>(&receiver, MsgFlags::NONE);
+        messenger.compileRoutes();
+
+        auto hits = std::vector<PixelHit>(16);
+        uint64_t event_number = 0;
+        for(auto _ : state) {
+            Event event(messenger, ++event_number, event_number);
+            messenger.dispatchMessage(&sender, std::make_shared<PixelHitMessage>(hits), &event);
+            benchmark::DoNotOptimize(messenger.fetchMultiMessage<PixelHitMessage>(&receiver, &event));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(messenger_dispatch);
+} // namespace
+
+/**
+ * @brief Main function running the benchmarks
+ *
+ * The units are registered before any benchmark, since the models and the detector model convert their parameters on
+ * construction. All options of Google Benchmark are supported, e.g. --benchmark_out=<file> --benchmark_out_format=json to
+ * store the results for comparison between releases.
+ */
+int main(int argc, char* argv[]) {
+    register_units();
+
+    benchmark::Initialize(&argc, argv);
+    if(benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file
+ * @brief Benchmark of the Runge-Kutta integrators with runtime and compile-time tableaus
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include <Eigen/Core>
+
+#include "tools/runge_kutta.h"
+
+using namespace allpix;
+
+namespace {
+    /**
+     * @brief Integrate a number of steps and return the time per step in nanoseconds
+     * @param runge_kutta Integrator to benchmark
+     * @param steps Number of steps to execute
+     * @param result Reference to store the final value in, to compare integrators and to avoid optimizing out the steps
+     */
+    template <typename Integrator>
+    double run_benchmark(Integrator& runge_kutta, unsigned long steps, Eigen::Vector3d& result) {
+        auto start = std::chrono::steady_clock::now();
+        for(unsigned long i = 0; i < steps; ++i) {
+            runge_kutta.step();
+        }
+        auto end = std::chrono::steady_clock::now();
+        result = runge_kutta.getValue();
+        return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(steps);
+    }
+} // namespace
+
+/**
+ * @brief Main function running the benchmark
+ */
+int main(int argc, const char* argv[]) {
+    unsigned long steps = 10000000;
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-h") == 0) {
+            std::cout << "Allpix Squared Runge-Kutta benchmark" << std::endl;
+            std::cout << "Usage: rungekutta_benchmark [-n <steps>]" << std::endl;
+            std::cout << "\t -n <steps>  number of integration steps per measurement (default 10000000)" << std::endl;
+            return 0;
+        } else if(strcmp(argv[i], "-n") == 0 && (i + 1 < argc)) {
+            steps = std::stoul(argv[++i]);
+        } else {
+            std::cerr << "Unrecognized command line argument \"" << argv[i] << "\"" << std::endl;
+            return 1;
+        }
+    }
+
+    // Velocity of a drifting charge carrier in a linear field with small rotational component
+    auto velocity = [](double, const Eigen::Vector3d& pos) -> Eigen::Vector3d {
+        return Eigen::Vector3d(-1e-3 * pos.y(), 1e-3 * pos.x(), -1e-2 * (pos.z() - 0.15));
+    };
+    std::function<Eigen::Vector3d(double, const Eigen::Vector3d&)> velocity_function = velocity;
+    Eigen::Vector3d start(0.01, 0.02, 0.);
+
+    auto runtime_rk = make_runge_kutta(tableau::RK5, velocity_function, 0.01, start);
+    auto static_rk = make_runge_kutta(static_tableau::RK5(), velocity, 0.01, start);
+
+    Eigen::Vector3d runtime_result, static_result;
+    auto runtime_time = run_benchmark(runtime_rk, steps, runtime_result);
+    auto static_time = run_benchmark(static_rk, steps, static_result);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Runtime tableau RK5:      " << runtime_time << " ns/step" << std::endl;
+    std::cout << "Compile-time tableau RK5: " << static_time << " ns/step" << std::endl;
+    std::cout << "Difference of final values: " << std::scientific << (runtime_result - static_result).norm() << std::endl;
+    return 0;
+}
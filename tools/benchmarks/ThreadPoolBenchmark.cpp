@@ -0,0 +1,121 @@
+/**
+ * @file
+ * @brief Scaling benchmark of the thread pool used to process events concurrently
+ *
+ * @copyright Copyright (c) 2020 CERN and the Allpix Squared authors.
+ * This software is distributed under the terms of the MIT License, copied verbatim in the file "LICENSE.md".
+ * In applying this license, CERN does not waive the privileges and immunities granted to it by virtue of its status as an
+ * Intergovernmental Organization or submit itself to any jurisdiction.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "core/module/ThreadPool.hpp"
+#include "core/utils/log.h"
+
+using namespace allpix;
+
+namespace {
+    /**
+     * @brief Execute a fixed amount of floating point work which cannot be optimized away
+     * @param work Number of iterations to run
+     */
+    double spin(unsigned int work) {
+        volatile double value = 1.;
+        for(unsigned int i = 0; i < work; ++i) {
+            value = std::sqrt(value + static_cast<double>(i));
+        }
+        return value;
+    }
+
+    /**
+     * @brief Run a number of tasks through a newly created pool and measure the throughput
+     * @param threads Number of worker threads
+     * @param tasks Number of tasks to submit
+     * @param work Amount of work per task
+     * @param sequential If every second task should be resubmitted in order, emulating a module requiring a sequence
+     * @return Number of tasks processed per second
+     */
+    double run_benchmark(unsigned int threads, uint64_t tasks, unsigned int work, bool sequential) {
+        // Use the same queue and buffer sizes as the module manager does
+        ThreadPool pool(threads, threads * 128, threads * 512);
+
+        auto start = std::chrono::steady_clock::now();
+        std::function<void(uint64_t)> task_function;
+        task_function = [&](uint64_t number) {
+            spin(work);
+            if(sequential && number % 2 == 0 && number != pool.minimumUncompleted()) {
+                // Park the task in the buffer until all previous tasks are completed
+                pool.post(number, task_function, number);
+                return;
+            }
+            pool.markComplete(number);
+        };
+        for(uint64_t number = 0; number < tasks; ++number) {
+            pool.post(task_function, number);
+            pool.checkException();
+        }
+        pool.wait();
+        pool.checkException();
+        auto end = std::chrono::steady_clock::now();
+
+        return static_cast<double>(tasks) / std::chrono::duration<double>(end - start).count();
+    }
+} // namespace
+
+/**
+ * @brief Main function running the benchmark
+ */
+int main(int argc, const char* argv[]) {
+    Log::addStream(std::cout);
+
+    // Parse arguments
+    unsigned int max_threads = 128;
+    uint64_t tasks = 200000;
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-h") == 0) {
+            std::cout << "Allpix Squared thread pool scaling benchmark" << std::endl;
+            std::cout << "Usage: threadpool_benchmark [-t <max_threads>] [-n <tasks>]" << std::endl;
+            std::cout << "\t -t <max_threads>  maximum number of worker threads to benchmark (default 128)" << std::endl;
+            std::cout << "\t -n <tasks>        number of tasks submitted per measurement (default 200000)" << std::endl;
+            return 0;
+        } else if(strcmp(argv[i], "-t") == 0 && (i + 1 < argc)) {
+            max_threads = static_cast<unsigned int>(std::stoul(argv[++i]));
+        } else if(strcmp(argv[i], "-n") == 0 && (i + 1 < argc)) {
+            tasks = std::stoull(argv[++i]);
+        } else {
+            LOG(ERROR) << "Unrecognized command line argument \"" << argv[i] << "\"";
+            return 1;
+        }
+    }
+
+    std::vector<unsigned int> thread_counts;
+    for(unsigned int threads = 1; threads <= max_threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+
+    // Thread numbers are never reused, register all workers that are going to be created
+    unsigned int total_threads = 0;
+    for(auto threads : thread_counts) {
+        total_threads += 3 * threads;
+    }
+    ThreadPool::registerThreadCount(total_threads);
+
+    std::cout << std::setw(8) << "threads" << std::setw(16) << "empty [1/s]" << std::setw(16) << "work [1/s]"
+              << std::setw(16) << "sequence [1/s]" << std::endl;
+    for(auto threads : thread_counts) {
+        auto empty = run_benchmark(threads, tasks, 0, false);
+        auto work = run_benchmark(threads, tasks, 1000, false);
+        auto sequence = run_benchmark(threads, tasks, 1000, true);
+        std::cout << std::setw(8) << threads << std::fixed << std::setprecision(0) << std::setw(16) << empty
+                  << std::setw(16) << work << std::setw(16) << sequence << std::endl;
+    }
+
+    return 0;
+}
@@ -1,14 +1,18 @@
 #include <algorithm>
+#include <array>
 #include <cfloat>
 #include <chrono>
 #include <climits>
+#include <cmath>
 #include <csignal>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <numeric>
 #include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <Math/Vector3D.h>
 #include <TTree.h>
@@ -174,13 +178,35 @@ int main(int argc, char** argv) {
 
         // Region, observable and binning of output field
         auto regions = config.getArray<std::string>("region", {"bulk"});
-        auto observable = config.get<std::string>("observable", "ElectricField");
+        auto observables = config.getArray<std::string>("observable", {"ElectricField"});
+        if(observables.empty()) {
+            throw allpix::InvalidValueError(config, "observable", "at least one observable required");
+        }
 
         const auto radius_step = config.get<double>("radius_step", 0.5);
         const auto max_radius = config.get<double>("max_radius", 50);
         const auto volume_cut = config.get<double>("volume_cut", 10e-9);
-        const auto units = config.get<std::string>("observable_units", "V/cm");
-        const auto vector_field = config.get<bool>("vector_field", (observable == "ElectricField"));
+        const auto reuse_elements = config.get<bool>("reuse_elements", true);
+
+        // Units and field quantity of every observable, a single value applies to all observables
+        auto units = config.getArray<std::string>("observable_units", {"V/cm"});
+        std::vector<bool> default_vector_field;
+        for(const auto& observable : observables) {
+            default_vector_field.push_back(observable == "ElectricField");
+        }
+        auto vector_field = config.getArray<bool>("vector_field", default_vector_field);
+        if(units.size() == 1) {
+            units.resize(observables.size(), units.front());
+        }
+        if(vector_field.size() == 1) {
+            vector_field.resize(observables.size(), vector_field.front());
+        }
+        if(units.size() != observables.size()) {
+            throw allpix::InvalidValueError(config, "observable_units", "expecting one value or one value per observable");
+        }
+        if(vector_field.size() != observables.size()) {
+            throw allpix::InvalidValueError(config, "vector_field", "expecting one value or one value per observable");
+        }
 
         XYZVectorUInt divisions;
         const auto dimension = config.get<size_t>("dimension", 3);
@@ -199,59 +225,53 @@ int main(int argc, char** argv) {
             throw allpix::InvalidValueError(config, "xyz", "three entries required");
         }
 
+        // Data files interpolated on the same grid, the default is the data file matching the grid file
+        auto data_files = config.getArray<std::string>("data_files", {file_prefix + ".dat"});
+        if(data_files.empty()) {
+            throw allpix::InvalidValueError(config, "data_files", "at least one data file required");
+        }
+
         auto start = std::chrono::system_clock::now();
 
         std::string grid_file = file_prefix + ".grd";
         std::vector<Point> points = parser->getMesh(grid_file, regions);
 
-        std::string data_file = file_prefix + ".dat";
-        std::vector<Point> field = parser->getField(data_file, observable, regions);
-
-        if(points.size() != field.size()) {
-            throw std::runtime_error("Field and grid file do not match, found " + std::to_string(points.size()) + " and " +
-                                     std::to_string(field.size()) + " data points, respectively.");
-        }
-
-        auto points_temp = points;
-        auto field_temp = field;
-        if(rot.at(0) == "-y" || rot.at(0) == "y") {
-            for(size_t i = 0; i < points.size(); ++i) {
-                points_temp[i].x = points[i].y;
-                field_temp[i].x = field[i].y;
+        // Swap the coordinates of mesh points or field vectors as requested:
+        auto swap_coordinates = [&rot](std::vector<Point>& values) {
+            auto values_temp = values;
+            if(rot.at(0) == "-y" || rot.at(0) == "y") {
+                for(size_t i = 0; i < values.size(); ++i) {
+                    values_temp[i].x = values[i].y;
+                }
             }
-        }
-        if(rot.at(0) == "-z" || rot.at(0) == "z") {
-            for(size_t i = 0; i < points.size(); ++i) {
-                points_temp[i].x = points[i].z;
-                field_temp[i].x = field[i].z;
+            if(rot.at(0) == "-z" || rot.at(0) == "z") {
+                for(size_t i = 0; i < values.size(); ++i) {
+                    values_temp[i].x = values[i].z;
+                }
             }
-        }
-        if(rot.at(1) == "-x" || rot.at(1) == "x") {
-            for(size_t i = 0; i < points.size(); ++i) {
-                points_temp[i].y = points[i].x;
-                field_temp[i].y = field[i].x;
+            if(rot.at(1) == "-x" || rot.at(1) == "x") {
+                for(size_t i = 0; i < values.size(); ++i) {
+                    values_temp[i].y = values[i].x;
+                }
             }
-        }
-        if(rot.at(1) == "-z" || rot.at(1) == "z") {
-            for(size_t i = 0; i < points.size(); ++i) {
-                points_temp[i].y = points[i].z;
-                field_temp[i].y = field[i].z;
+            if(rot.at(1) == "-z" || rot.at(1) == "z") {
+                for(size_t i = 0; i < values.size(); ++i) {
+                    values_temp[i].y = values[i].z;
+                }
             }
-        }
-        if(rot.at(2) == "-x" || rot.at(2) == "x") {
-            for(size_t i = 0; i < points.size(); ++i) {
-                points_temp[i].z = points[i].x;
-                field_temp[i].z = field[i].x;
+            if(rot.at(2) == "-x" || rot.at(2) == "x") {
+                for(size_t i = 0; i < values.size(); ++i) {
+                    values_temp[i].z = values[i].x;
+                }
             }
-        }
-        if(rot.at(2) == "-y" || rot.at(2) == "y") {
-            for(size_t i = 0; i < points.size(); ++i) {
-                points_temp[i].z = points[i].y;
-                field_temp[i].z = field[i].y;
+            if(rot.at(2) == "-y" || rot.at(2) == "y") {
+                for(size_t i = 0; i < values.size(); ++i) {
+                    values_temp[i].z = values[i].y;
+                }
             }
-        }
-        points = points_temp;
-        field = field_temp;
+            values = std::move(values_temp);
+        };
+        swap_coordinates(points);
 
         // Find minimum and maximum from mesh coordinates
         double minx = DBL_MAX, miny = DBL_MAX, minz = DBL_MAX;
@@ -276,10 +296,47 @@ int main(int argc, char** argv) {
             }
         }
 
-        // Creating a new mesh points cloud with a regular pitch
+        // Bin edges in z, either with a regular pitch or from segments of regular pitch along the thickness
+        std::vector<double> z_edges{minz};
+        const bool graded_z = config.has("z_segments");
+        if(graded_z) {
+            if(file_type == FileType::INIT) {
+                throw allpix::InvalidValueError(
+                    config, "z_segments", "non-uniform binning in z can only be stored in APF files");
+            }
+            auto segments = config.getMatrix<double>("z_segments");
+            for(const auto& segment : segments) {
+                if(segment.size() != 2 || segment[0] <= 0 || segment[1] < 1 || std::floor(segment[1]) != segment[1]) {
+                    throw allpix::InvalidValueError(
+                        config, "z_segments", "expecting a positive thickness and number of bins in each row");
+                }
+                auto first = z_edges.back();
+                auto bins = static_cast<unsigned int>(segment[1]);
+                for(unsigned int k = 1; k <= bins; ++k) {
+                    z_edges.push_back(first + segment[0] * k / bins);
+                }
+            }
+            if(std::fabs(z_edges.back() - maxz) > 1e-6 * (maxz - minz)) {
+                throw allpix::InvalidValueError(config,
+                                                "z_segments",
+                                                "segments cover " + std::to_string(z_edges.back() - minz) +
+                                                    " while the mesh extends over " + std::to_string(maxz - minz));
+            }
+            z_edges.back() = maxz;
+            divisions.SetZ(static_cast<unsigned int>(z_edges.size() - 1));
+        } else {
+            for(unsigned int k = 1; k <= divisions.z(); ++k) {
+                z_edges.push_back(minz + (maxz - minz) * k / divisions.z());
+            }
+        }
+
+        // Creating a new mesh points cloud with a regular pitch in x and y
         const double xstep = (maxx - minx) / static_cast<double>(divisions.x());
         const double ystep = (maxy - miny) / static_cast<double>(divisions.y());
-        const double zstep = (maxz - minz) / static_cast<double>(divisions.z());
+        double zstep = maxz - minz;
+        for(size_t k = 0; k + 1 < z_edges.size(); ++k) {
+            zstep = std::min(zstep, z_edges[k + 1] - z_edges[k]);
+        }
         const double cell_volume = xstep * ystep * zstep;
 
         // Using the minimal cell dimension as initial search radius for the point cloud:
@@ -293,30 +350,32 @@ int main(int argc, char** argv) {
 
         const auto mesh_points_total = divisions.x() * divisions.y() * divisions.z();
         LOG(STATUS) << "Mesh dimensions: " << maxx - minx << " x " << maxy - miny << " x " << maxz - minz << std::endl
-                    << "New mesh element dimension: " << xstep << " x " << ystep << " x " << zstep << std::endl
+                    << "New mesh element dimension: " << xstep << " x " << ystep << " x " << zstep
+                    << (graded_z ? " (smallest in z)" : "") << std::endl
                     << "Volume: " << cell_volume << std::endl
                     << "New mesh grid points: " << static_cast<ROOT::Math::XYZVector>(divisions) << " (" << mesh_points_total
                     << " total)";
 
+        std::array<bool, 3> invert{};
         if(rot.at(0).find('-') != std::string::npos) {
             LOG(WARNING) << "Inverting coordinate X. This might change the right-handness of the coordinate system!";
-            for(size_t i = 0; i < points.size(); ++i) {
-                points[i].x = maxx - (points[i].x - minx);
-                field[i].x = -field[i].x;
+            invert[0] = true;
+            for(auto& point : points) {
+                point.x = maxx - (point.x - minx);
             }
         }
         if(rot.at(1).find('-') != std::string::npos) {
             LOG(WARNING) << "Inverting coordinate Y. This might change the right-handness of the coordinate system!";
-            for(size_t i = 0; i < points.size(); ++i) {
-                points[i].y = maxy - (points[i].y - miny);
-                field[i].y = -field[i].y;
+            invert[1] = true;
+            for(auto& point : points) {
+                point.y = maxy - (point.y - miny);
             }
         }
         if(rot.at(2).find('-') != std::string::npos) {
             LOG(WARNING) << "Inverting coordinate Z. This might change the right-handness of the coordinate system!";
-            for(size_t i = 0; i < points.size(); ++i) {
-                points[i].z = maxz - (points[i].z - minz);
-                field[i].z = -field[i].z;
+            invert[2] = true;
+            for(auto& point : points) {
+                point.z = maxz - (point.z - minz);
             }
         }
 
@@ -326,33 +385,56 @@ int main(int argc, char** argv) {
 
         auto end = std::chrono::system_clock::now();
         auto elapsed_seconds = std::chrono::duration_cast<std::chrono::seconds>(end - start).count();
-        LOG(INFO) << "Reading the files took " << elapsed_seconds << " seconds.";
+        LOG(INFO) << "Reading the grid file took " << elapsed_seconds << " seconds.";
 
         // Initializing the Octree with points from mesh cloud.
         unibn::Octree<Point> octree;
         octree.initialize(points);
 
+        // Mesh element enclosing a point of the new mesh, with the barycentric weights of its mesh points. Since the element
+        // only depends on the grid, it is determined once and used to interpolate all data files.
+        struct GridElement {
+            std::array<unsigned int, 4> indices;
+            std::array<double, 4> weights;
+        };
+
         unsigned int mesh_points_done = 0;
         auto mesh_section = [&](double x, double y) {
             allpix::Log::setReportingLevel(log_level);
 
-            // New mesh slice
-            std::vector<Point> new_mesh;
+            // Elements of the new mesh slice
+            std::vector<GridElement> new_mesh;
+
+            // Consecutive points of a column are close to each other, the element and the search radius found for the
+            // previous point are tried first
+            std::vector<unsigned int> last_element;
+            double last_radius = initial_radius;
 
-            double z = minz + zstep / 2.0;
             for(unsigned int k = 0; k < divisions.z(); ++k) {
-                // New mesh vertex and field
-                Point q(dimension == 2 ? -1 : x, y, z), e;
+                // New mesh vertex at the center of the bin and its element
+                double z = (z_edges[k] + z_edges[k + 1]) / 2.0;
+                Point q(dimension == 2 ? -1 : x, y, z);
+                GridElement element{};
                 bool valid = false;
 
+                if(reuse_elements && !last_element.empty()) {
+                    Combination cached(&points, nullptr, q, volume_cut);
+                    valid = cached(last_element.begin(), last_element.end());
+                    if(valid) {
+                        LOG(DEBUG) << "Reusing mesh element of previous point";
+                        element.weights = cached.weights();
+                    }
+                }
+
                 size_t prev_neighbours = 0;
-                double radius = initial_radius;
+                double radius = (reuse_elements ? std::max(initial_radius, last_radius - radius_step) : initial_radius);
 
-                while(radius < max_radius) {
+                while(!valid && radius < max_radius) {
                     LOG(DEBUG) << "Search radius: " << radius;
-                    // Calling octree neighbours search and sorting the results list with the closest neighbours first
+                    // Calling octree neighbours search, which also returns the distances of the neighbours
                     std::vector<unsigned int> results;
-                    octree.radiusNeighbors<unibn::L2Distance<Point>>(q, radius, results);
+                    std::vector<double> distances;
+                    octree.radiusNeighbors<unibn::L2Distance<Point>>(q, radius, results, distances);
                     LOG(DEBUG) << "Number of vertices found: " << results.size();
 
                     // If after a radius step no new neighbours are found, go to the next radius step
@@ -372,20 +454,26 @@ int main(int argc, char** argv) {
 
                     // Sort by lowest distance first, this drastically reduces the number of permutations required to find a
                     // valid mesh element and also ensures that this is the one with the smallest volume.
-                    std::sort(results.begin(), results.end(), [&](unsigned int a, unsigned int b) {
-                        return unibn::L2Distance<Point>::compute(points[a], q) <
-                               unibn::L2Distance<Point>::compute(points[b], q);
-                    });
+                    std::vector<size_t> order(results.size());
+                    std::iota(order.begin(), order.end(), 0);
+                    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return distances[a] < distances[b]; });
+                    std::vector<unsigned int> sorted_results;
+                    sorted_results.reserve(results.size());
+                    for(auto index : order) {
+                        sorted_results.push_back(results[index]);
+                    }
 
                     // Finding tetrahedrons by checking all combinations of N elements, starting with closest to reference
                     // point
-                    auto res = for_each_combination(results.begin(),
-                                                    results.begin() + (dimension == 3 ? 4 : 3),
-                                                    results.end(),
-                                                    Combination(&points, &field, q, volume_cut));
+                    auto res = for_each_combination(sorted_results.begin(),
+                                                    sorted_results.begin() + (dimension == 3 ? 4 : 3),
+                                                    sorted_results.end(),
+                                                    Combination(&points, nullptr, q, volume_cut));
                     valid = res.valid();
                     if(valid) {
-                        e = res.result();
+                        element.weights = res.weights();
+                        last_element = res.indices();
+                        last_radius = radius;
                         break;
                     }
 
@@ -399,8 +487,8 @@ int main(int argc, char** argv) {
                         "more mesh points in the search");
                 }
 
-                new_mesh.push_back(e);
-                z += zstep;
+                std::copy(last_element.begin(), last_element.end(), element.indices.begin());
+                new_mesh.push_back(element);
             }
 
             mesh_points_done += divisions.z();
@@ -414,7 +502,8 @@ int main(int argc, char** argv) {
         auto num_threads = config.get<unsigned int>("workers", std::max(std::thread::hardware_concurrency(), 1u));
         ThreadPool::registerThreadCount(num_threads);
         LOG(STATUS) << "Starting regular grid interpolation with " << num_threads << " threads.";
-        std::vector<Point> e_field_new_mesh;
+        std::vector<GridElement> new_mesh_elements;
+        new_mesh_elements.reserve(mesh_points_total);
 
         // clang-format off
         auto init_function = [log_level = allpix::Log::getReportingLevel(), log_format = allpix::Log::getFormat()]() {
@@ -425,7 +514,7 @@ int main(int argc, char** argv) {
         };
 
         ThreadPool pool(num_threads, num_threads * 1024, init_function);
-        std::vector<std::shared_future<std::vector<Point>>> mesh_futures;
+        std::vector<std::shared_future<std::vector<GridElement>>> mesh_futures;
         // Set starting point
         double x = minx + xstep / 2.0;
         // Loop over x coordinate, add tasks for each coordinate to the queue
@@ -441,7 +530,7 @@ int main(int argc, char** argv) {
         // Merge the result vectors:
         for(auto& mesh_future : mesh_futures) {
             auto mesh_slice = mesh_future.get();
-            e_field_new_mesh.insert(e_field_new_mesh.end(), mesh_slice.begin(), mesh_slice.end());
+            new_mesh_elements.insert(new_mesh_elements.end(), mesh_slice.begin(), mesh_slice.end());
         }
         pool.destroy();
 
@@ -449,40 +538,94 @@ int main(int argc, char** argv) {
         elapsed_seconds = std::chrono::duration_cast<std::chrono::seconds>(end - start).count();
         LOG(INFO) << "New mesh created in " << elapsed_seconds << " seconds.";
 
-        // Prepare header and auxiliary information:
-        std::string header =
-            "Allpix Squared " + std::string(ALLPIX_PROJECT_VERSION) + " TCAD Mesh Converter, observable: " + observable;
+        // Prepare auxiliary information:
         std::array<double, 3> size{{allpix::Units::get(maxx - minx, "um"),
                                     allpix::Units::get(maxy - miny, "um"),
                                     allpix::Units::get(maxz - minz, "um")}};
         std::array<size_t, 3> gridsize{
             {static_cast<size_t>(divisions.x()), static_cast<size_t>(divisions.y()), static_cast<size_t>(divisions.z())}};
+        std::vector<double> field_z_edges;
+        if(graded_z) {
+            for(auto edge : z_edges) {
+                field_z_edges.push_back(allpix::Units::get(edge - minz, "um"));
+            }
+        }
+
+        // Interpolate every data file using the mesh elements of the new mesh:
+        for(const auto& data_file : data_files) {
+            // All observables are read from the data file in a single pass
+            auto fields = parser->getFields(data_file, observables, regions);
+            parser->clearFields();
+
+            std::vector<std::vector<Point>> observable_fields;
+            std::vector<std::shared_ptr<std::vector<double>>> observable_data;
+            for(size_t o = 0; o < observables.size(); ++o) {
+                auto& field = fields.at(observables[o]);
+                if(points.size() != field.size()) {
+                    throw std::runtime_error("Field and grid file do not match, found " + std::to_string(points.size()) +
+                                             " and " + std::to_string(field.size()) + " data points, respectively.");
+                }
+
+                swap_coordinates(field);
+                for(auto& value : field) {
+                    value.x = (invert[0] ? -value.x : value.x);
+                    value.y = (invert[1] ? -value.y : value.y);
+                    value.z = (invert[2] ? -value.z : value.z);
+                }
+                observable_fields.push_back(std::move(field));
+
+                auto data = std::make_shared<std::vector<double>>();
+                data->reserve(new_mesh_elements.size() * (vector_field[o] ? 3 : 1));
+                observable_data.push_back(std::move(data));
+            }
+
+            // Prepare data, interpolating all observables from the mesh element of every point:
+            LOG(INFO) << "Preparing data for storage...";
+            for(const auto& element : new_mesh_elements) {
+                for(size_t o = 0; o < observables.size(); ++o) {
+                    const auto& field = observable_fields[o];
+                    Point point;
+                    for(size_t n = 0; n < element.indices.size(); ++n) {
+                        const auto& value = field[element.indices[n]];
+                        point.x += element.weights[n] * value.x;
+                        point.y += element.weights[n] * value.y;
+                        point.z += element.weights[n] * value.z;
+                    }
 
-        FieldQuantity quantity = (vector_field ? FieldQuantity::VECTOR : FieldQuantity::SCALAR);
-        // Prepare data:
-        LOG(INFO) << "Preparing data for storage...";
-        auto data = std::make_shared<std::vector<double>>();
-        for(unsigned int i = 0; i < divisions.x(); ++i) {
-            for(unsigned int j = 0; j < divisions.y(); ++j) {
-                for(unsigned int k = 0; k < divisions.z(); ++k) {
-                    auto& point = e_field_new_mesh[i * divisions.y() * divisions.z() + j * divisions.z() + k];
                     // We need to convert to framework-internal units:
-                    data->push_back(allpix::Units::get(point.x, units));
+                    auto& data = *observable_data[o];
+                    data.push_back(allpix::Units::get(point.x, units[o]));
                     // For a vector field, we push three values:
-                    if(quantity == FieldQuantity::VECTOR) {
-                        data->push_back(allpix::Units::get(point.y, units));
-                        data->push_back(allpix::Units::get(point.z, units));
+                    if(vector_field[o]) {
+                        data.push_back(allpix::Units::get(point.y, units[o]));
+                        data.push_back(allpix::Units::get(point.z, units[o]));
                     }
                 }
             }
-        }
 
-        allpix::FieldData<double> field_data(header, gridsize, size, data);
-        std::string init_file_name = init_file_prefix + "_" + observable + (file_type == FileType::INIT ? ".init" : ".apf");
+            // Several data files are distinguished by their file names
+            std::string data_file_prefix;
+            if(data_files.size() > 1) {
+                data_file_prefix = data_file.substr(data_file.find_last_of('/') + 1);
+                data_file_prefix = "_" + data_file_prefix.substr(0, data_file_prefix.find_last_of('.'));
+            }
+
+            // Write one file per observable
+            for(size_t o = 0; o < observables.size(); ++o) {
+                std::string header = "Allpix Squared " + std::string(ALLPIX_PROJECT_VERSION) +
+                                     " TCAD Mesh Converter, observable: " + observables[o];
+                FieldQuantity quantity = (vector_field[o] ? FieldQuantity::VECTOR : FieldQuantity::SCALAR);
+                allpix::FieldWriter<double> field_writer(quantity);
 
-        allpix::FieldWriter<double> field_writer(quantity);
-        field_writer.writeFile(field_data, init_file_name, file_type, (file_type == FileType::INIT ? units : ""));
-        LOG(STATUS) << "New mesh written to file \"" << init_file_name << "\"";
+                allpix::FieldData<double> field_data(header, gridsize, size, observable_data[o], field_z_edges);
+                std::string init_file_name = init_file_prefix + data_file_prefix + "_" + observables[o] +
+                                             (file_type == FileType::INIT ? ".init" : ".apf");
+
+                field_writer.writeFile(
+                    field_data, init_file_name, file_type, (file_type == FileType::INIT ? units[o] : ""));
+                LOG(STATUS) << "New mesh written to file \"" << init_file_name << "\"";
+            }
+        }
 
         end = std::chrono::system_clock::now();
         elapsed_seconds = std::chrono::duration_cast<std::chrono::seconds>(end - start).count();
@@ -90,6 +90,14 @@ Point MeshElement::getObservable(Point& qp) const {
     return new_observable;
 }
 
+std::array<double, 4> MeshElement::getWeights(Point& qp) const {
+    std::array<double, 4> weights{};
+    for(size_t index = 0; index < dimension_ + 1; index++) {
+        weights[index] = get_sub_volume(index, qp) / volume_;
+    }
+    return weights;
+}
+
 std::string MeshElement::print(Point& qp) const {
     std::stringstream stream;
     for(size_t index = 0; index < dimension_ + 1; index++) {
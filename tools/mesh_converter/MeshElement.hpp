@@ -61,6 +61,13 @@ namespace mesh_converter {
          */
         Point getObservable(Point& qp) const;
 
+        /**
+         * @brief Barycentric weights of the nodes, such that the observable is the weighted sum of the node values
+         * @param qp Point where the interpolation is being done
+         * @return Weights of the nodes, the weight of unused nodes of lower-dimensional elements is zero
+         */
+        std::array<double, 4> getWeights(Point& qp) const;
+
         /**
          * @brief Print tetrahedron information for debugging
          * @return String describing the mesh element
@@ -98,17 +105,20 @@ namespace mesh_converter {
         const std::vector<Point>* field_;
         Point reference_;
         Point result_;
+        std::array<double, 4> weights_{};
         bool valid_{};
         double cut_;
 
         std::array<Point, 4> grid_elements;
         std::array<Point, 4> field_elements;
+        std::array<unsigned int, 4> indices_{};
+        size_t size_{};
 
     public:
         /**
          * @brief constructor for functor
          * @param  points     Pointer to mesh point vector
-         * @param  field      Pointer to field vector
+         * @param  field      Pointer to field vector, only the weights of the element are calculated if not provided
          * @param  q          Reference point to interpolate at
          * @param  volume_cut Volume cut to be used
          */
@@ -130,16 +140,21 @@ namespace mesh_converter {
             size_t dimensions = static_cast<size_t>(end - begin) - 1;
             size_t idx = 0;
             for(; begin < end; begin++) {
+                indices_[idx] = *begin;
                 grid_elements[idx] = (*grid_)[*begin];
-                field_elements[idx++] = (*field_)[*begin];
+                field_elements[idx++] = (field_ != nullptr ? (*field_)[*begin] : Point());
             }
+            size_ = idx;
 
             LOG(TRACE) << "Constructing element with dim " << dimensions << " at " << reference_;
             MeshElement element(dimensions, grid_elements, field_elements);
             valid_ = element.validElement(cut_, reference_);
             if(valid_) {
                 LOG(DEBUG) << element.print(reference_);
-                result_ = element.getObservable(reference_);
+                weights_ = element.getWeights(reference_);
+                if(field_ != nullptr) {
+                    result_ = element.getObservable(reference_);
+                }
             }
 
             return valid_; // Don't break out of the loop if element is invalid
@@ -157,6 +172,20 @@ namespace mesh_converter {
          * @return Interpolated result from valid mesh element
          */
         Point result() const { return result_; }
+
+        /**
+         * @brief Member to retrieve the barycentric weights of the mesh points of a valid mesh element
+         * @return Weights of the mesh points in the order of \ref indices
+         */
+        std::array<double, 4> weights() const { return weights_; }
+
+        /**
+         * @brief Member to retrieve the mesh points of the last element constructed
+         * @return Indices of the mesh points forming the element
+         */
+        std::vector<unsigned int> indices() const {
+            return std::vector<unsigned int>(indices_.begin(), indices_.begin() + static_cast<std::ptrdiff_t>(size_));
+        }
     };
 
 } // namespace mesh_converter
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iomanip>
 
 #include "MeshParser.hpp"
@@ -49,13 +50,33 @@ std::vector<Point> MeshParser::getMesh(const std::string& file, const std::vecto
 
 std::vector<Point>
 MeshParser::getField(const std::string& file, const std::string& observable, const std::vector<std::string>& regions) {
+    return getFields(file, {observable}, regions).at(observable);
+}
+
+std::map<std::string, std::vector<Point>> MeshParser::getFields(const std::string& file,
+                                                                const std::vector<std::string>& observables,
+                                                                const std::vector<std::string>& regions) {
 
-    // Populate field map once:
-    if(field_map_[file].empty()) {
+    // Populate field map once per file, reading all observables not yet cached in one pass:
+    auto& field_map = field_map_[file];
+    std::vector<std::string> missing;
+    for(const auto& observable : observables) {
+        auto cached = std::any_of(field_map.begin(), field_map.end(), [&](const auto& region) {
+            return region.second.find(observable) != region.second.end();
+        });
+        if(!cached) {
+            missing.push_back(observable);
+        }
+    }
+    if(!missing.empty()) {
         LOG(STATUS) << "Reading field from file \"" << file << "\"";
-        field_map_[file] = read_fields(file);
+        for(auto& [region, fields] : read_fields(file, missing)) {
+            for(auto& [observable, field] : fields) {
+                field_map[region][observable] = std::move(field);
+            }
+        }
         LOG(INFO) << "Field sizes for all regions and observables:";
-        for(auto& reg : field_map_[file]) {
+        for(auto& reg : field_map) {
             LOG(INFO) << " " << reg.first << ":";
             for(auto& fld : reg.second) {
                 LOG(INFO) << "\t" << std::left << std::setw(25) << fld.first << " " << fld.second.size();
@@ -65,22 +86,23 @@ MeshParser::getField(const std::string& file, const std::string& observable, con
         LOG(STATUS) << "Using cached field from file \"" << file << "\"";
     }
 
-    // Append all field regions to the field vector:
-    std::vector<Point> field;
-    for(const auto& region : regions) {
-        if(field_map_[file].find(region) != field_map_[file].end() &&
-           field_map_[file][region].find(observable) != field_map_[file][region].end()) {
-            field.insert(
-                field.end(), field_map_[file][region][observable].begin(), field_map_[file][region][observable].end());
-        } else {
-            throw std::runtime_error("No matching region with observable \"" + observable + "\" found in field file");
+    // Append all field regions to the field vector of every observable:
+    std::map<std::string, std::vector<Point>> fields;
+    for(const auto& observable : observables) {
+        auto& field = fields[observable];
+        for(const auto& region : regions) {
+            if(field_map.find(region) != field_map.end() && field_map[region].find(observable) != field_map[region].end()) {
+                field.insert(field.end(), field_map[region][observable].begin(), field_map[region][observable].end());
+            } else {
+                throw std::runtime_error("No matching region with observable \"" + observable + "\" found in field file");
+            }
         }
-    }
 
-    if(field.empty()) {
-        throw std::runtime_error("Empty observable data");
+        if(field.empty()) {
+            throw std::runtime_error("Empty observable data");
+        }
+        LOG(DEBUG) << "Field of " << observable << " with " << field.size() << " points";
     }
-    LOG(DEBUG) << "Field with " << field.size() << " points";
 
-    return field;
+    return fields;
 }
@@ -7,6 +7,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace mesh_converter {
@@ -29,6 +30,22 @@ namespace mesh_converter {
         std::vector<Point>
         getField(const std::string& file, const std::string& observable, const std::vector<std::string>& regions);
 
+        /**
+         * @brief Get the fields of several observables, reading all of them from the file in a single pass
+         * @param  file        Path of the field file
+         * @param  observables Observables to read
+         * @param  regions     Regions whose fields are appended in the given order
+         * @return             Map with the field of every observable
+         */
+        std::map<std::string, std::vector<Point>> getFields(const std::string& file,
+                                                            const std::vector<std::string>& observables,
+                                                            const std::vector<std::string>& regions);
+
+        /**
+         * @brief Release the cached fields of all files, which are not required anymore once they have been retrieved
+         */
+        void clearFields() { field_map_.clear(); }
+
     protected:
         /**
          * @brief Default constructor
@@ -44,15 +61,16 @@ namespace mesh_converter {
 
         /**
          * @brief Method to read fields from the given file
-         * @param  file_name Canonical path pof the input file
-         * @return           Map with all fields for the different regions
+         * @param  file_name   Canonical path pof the input file
+         * @param  observables Observables to read, all other observables in the file are skipped
+         * @return             Map with the fields of the observables for the different regions
          */
-        virtual FieldMap read_fields(const std::string& file_name) = 0;
+        virtual FieldMap read_fields(const std::string& file_name, const std::vector<std::string>& observables) = 0;
 
     private:
         // Cache of parsed meshes for all regions
         std::map<std::string, MeshMap> mesh_map_;
-        // Cache of parsed fields for all regions
+        // Cache of parsed fields for all regions and observables read, by file
         std::map<std::string, FieldMap> field_map_;
     };
 
@@ -1,9 +1,12 @@
+#include <algorithm>
 #include <cmath>
 #include <csignal>
 #include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 #include "TCanvas.h"
 #include "TFile.h"
@@ -63,6 +66,7 @@ int main(int argc, char** argv) {
         bool flag_cut = false;
         size_t slice_cut = 0;
         bool log_scale = false;
+        unsigned int threads = std::max(std::thread::hardware_concurrency(), 1u);
         allpix::LogLevel log_level = allpix::LogLevel::INFO;
 
         for(int i = 1; i < argc; i++) {
@@ -90,6 +94,8 @@ int main(int argc, char** argv) {
                 flag_cut = true;
             } else if(strcmp(argv[i], "-l") == 0) {
                 log_scale = true;
+            } else if(strcmp(argv[i], "-j") == 0 && (i + 1 < argc)) {
+                threads = static_cast<unsigned int>(std::max(std::atoi(argv[++i]), 1));
             } else {
                 std::cout << "Unrecognized command line argument or missing value\"" << argv[i] << std::endl;
                 print_help = true;
@@ -112,6 +118,7 @@ int main(int argc, char** argv) {
             std::cout << "Optional parameters:" << std::endl;
             std::cout << "\t -c <cut>               projection height index (default is mesh_pitch / 2)" << std::endl;
             std::cout << "\t -h                     display this help text" << std::endl;
+            std::cout << "\t -j <threads>           number of threads filling the plots (default is all cores)" << std::endl;
             std::cout << "\t -l                     plot with logarithmic scale if set" << std::endl;
             std::cout << "\t -o <output_file_name>  name of the file to output (default is efield.png)" << std::endl;
             std::cout << "\t -p <plane>             plane to be ploted. xy, yz or zx (default is yz)" << std::endl;
@@ -134,8 +141,9 @@ int main(int argc, char** argv) {
         // FIXME this should be done in a more elegant way
         FieldQuantity quantity = (scalar_field ? FieldQuantity::SCALAR : FieldQuantity::VECTOR);
 
+        // Only read the description of the field, the slice to plot is read separately
         FieldParser<double> field_parser(quantity);
-        auto field_data = field_parser.getByFileName(file_name, units);
+        auto field_data = field_parser.readHeader(file_name, units);
         size_t xdiv = field_data.getDimensions()[0], ydiv = field_data.getDimensions()[1],
                zdiv = field_data.getDimensions()[2];
 
@@ -186,6 +194,96 @@ int main(int argc, char** argv) {
             axis_titles = "z [bins];x [bins]";
         }
 
+        if(stop_x > xdiv || stop_y > ydiv || stop_z > zdiv) {
+            throw std::invalid_argument("slice index " + std::to_string(slice_cut) + " outside of the field");
+        }
+
+        // Read the slice only, the field points are stored with z running fastest
+        auto components = static_cast<size_t>(quantity);
+        size_t slice_x = stop_x - start_x, slice_y = stop_y - start_y, slice_z = stop_z - start_z;
+        std::vector<double> slice(slice_x * slice_y * slice_z * components);
+        auto local_index = [&](size_t x, size_t y, size_t z) {
+            return ((x - start_x) * slice_y + (y - start_y)) * slice_z + (z - start_z);
+        };
+        if(field_parser.getFileType(file_name) == FileType::INIT) {
+            // The field points of INIT files are not ordered, all values are parsed but only the slice is stored
+            LOG(INFO) << "Parsing full INIT file to extract slice";
+            field_parser.readValues(file_name, units, [&](size_t index, double value) {
+                auto point = index / components;
+                auto x = point / (ydiv * zdiv), y = (point / zdiv) % ydiv, z = point % zdiv;
+                if(x >= start_x && x < stop_x && y >= start_y && y < stop_y && z >= start_z && z < stop_z) {
+                    slice[local_index(x, y, z) * components + index % components] = value;
+                }
+            });
+        } else {
+            // Read the slice from APF files as equally spaced blocks of consecutive entries
+            size_t first = 0, count = 0, stride = 0, blocks = 0;
+            if(plane == "xy") {
+                first = slice_cut * components;
+                count = components;
+                stride = zdiv * components;
+                blocks = xdiv * ydiv;
+            } else if(plane == "yz") {
+                first = slice_cut * ydiv * zdiv * components;
+                count = ydiv * zdiv * components;
+                stride = count;
+                blocks = 1;
+            } else {
+                first = slice_cut * zdiv * components;
+                count = zdiv * components;
+                stride = ydiv * zdiv * components;
+                blocks = xdiv;
+            }
+            field_parser.readStridedEntries(file_name, first, count, stride, blocks, slice.data());
+        }
+        LOG(INFO) << "Read " << slice.size() << " field entries of the slice";
+
+        // Compute the bin contents of the plots on multiple threads, every bin is filled exactly once
+        auto bins = static_cast<size_t>(x_bin) * static_cast<size_t>(y_bin);
+        std::vector<double> norm_bins(bins), x_bins(bins), y_bins(bins), z_bins(bins);
+        auto fill_bins = [&](size_t begin, size_t end) {
+            for(size_t point = begin; point < end; point++) {
+                auto x = start_x + point / (slice_y * slice_z);
+                auto y = start_y + (point / slice_z) % slice_y;
+                auto z = start_z + point % slice_z;
+
+                // Select the indices for plotting:
+                size_t plot_x = 0, plot_y = 0;
+                if(plane == "xy") {
+                    plot_x = x;
+                    plot_y = y;
+                } else if(plane == "yz") {
+                    plot_x = y;
+                    plot_y = z;
+                } else {
+                    plot_x = z;
+                    plot_y = x;
+                }
+                auto bin = plot_y * static_cast<size_t>(x_bin) + plot_x;
+                const auto* value = &slice[point * components];
+
+                if(quantity == FieldQuantity::VECTOR) {
+                    // Fill field maps for the individual vector components as well as the magnitude
+                    norm_bins[bin] = sqrt(pow(value[0], 2) + pow(value[1], 2) + pow(value[2], 2));
+                    x_bins[bin] = value[0];
+                    y_bins[bin] = value[1];
+                    z_bins[bin] = value[2];
+                } else {
+                    // Fill one map with the scalar quantity
+                    norm_bins[bin] = value[0];
+                }
+            }
+        };
+        std::vector<std::thread> workers;
+        auto points = slice_x * slice_y * slice_z;
+        auto chunk = (points + threads - 1) / threads;
+        for(size_t begin = 0; begin < points; begin += chunk) {
+            workers.emplace_back(fill_bins, begin, std::min(begin + chunk, points));
+        }
+        for(auto& worker : workers) {
+            worker.join();
+        }
+
         // Create and fill histogram
         auto* efield_map = new TH2D(Form("%s", observable.c_str()),
                                     Form("%s;%s", observable.c_str(), axis_titles.c_str()),
@@ -227,38 +325,14 @@ int main(int argc, char** argv) {
             output_name_log = "_log";
         }
 
-        int plot_x = 0, plot_y = 0;
-        auto data = field_data.getData();
-        for(size_t x = start_x; x < stop_x; x++) {
-            for(size_t y = start_y; y < stop_y; y++) {
-                for(size_t z = start_z; z < stop_z; z++) {
-                    // Select the indices for plotting:
-                    if(plane == "xy") {
-                        plot_x = static_cast<int>(x);
-                        plot_y = static_cast<int>(y);
-                    } else if(plane == "yz") {
-                        plot_x = static_cast<int>(y);
-                        plot_y = static_cast<int>(z);
-                    } else {
-                        plot_x = static_cast<int>(z);
-                        plot_y = static_cast<int>(x);
-                    }
-
-                    if(quantity == FieldQuantity::VECTOR) {
-                        // Fill field maps for the individual vector components as well as the magnitude
-                        auto base = x * ydiv * zdiv * 3 + y * zdiv * 3 + z * 3;
-                        efield_map->Fill(
-                            plot_x,
-                            plot_y,
-                            sqrt(pow(data->at(base + 0), 2) + pow(data->at(base + 1), 2) + pow(data->at(base + 2), 2)));
-                        exfield_map->Fill(plot_x, plot_y, data->at(base + 0));
-                        eyfield_map->Fill(plot_x, plot_y, data->at(base + 1));
-                        ezfield_map->Fill(plot_x, plot_y, data->at(base + 2));
-
-                    } else {
-                        // Fill one map with the scalar quantity
-                        efield_map->Fill(plot_x, plot_y, data->at(x * ydiv * zdiv + y * zdiv + z));
-                    }
+        for(int plot_y = 0; plot_y < y_bin; plot_y++) {
+            for(int plot_x = 0; plot_x < x_bin; plot_x++) {
+                auto bin = static_cast<size_t>(plot_y) * static_cast<size_t>(x_bin) + static_cast<size_t>(plot_x);
+                efield_map->Fill(plot_x, plot_y, norm_bins[bin]);
+                if(quantity == FieldQuantity::VECTOR) {
+                    exfield_map->Fill(plot_x, plot_y, x_bins[bin]);
+                    eyfield_map->Fill(plot_x, plot_y, y_bins[bin]);
+                    ezfield_map->Fill(plot_x, plot_y, z_bins[bin]);
                 }
             }
         }
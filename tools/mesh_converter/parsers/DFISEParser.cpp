@@ -1,32 +1,152 @@
 #include "DFISEParser.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cctype>
 #include <cstdlib>
 #include <exception>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
-#include <regex>
 #include <set>
 #include <string>
+#include <string_view>
 #include "TFile.h"
 #include "TTree.h"
 
 #include "core/utils/log.h"
 #include "core/utils/text.h"
+#include "tools/buffered_line_reader.h"
 
 using namespace mesh_converter;
+using allpix::LineTokenizer;
+
+namespace {
+    /**
+     * @brief Get the next token of a line separated by whitespace
+     * @param line Remainder of the line, the token is removed from it
+     * @return View of the token, empty if the line has no further tokens
+     */
+    std::string_view next_token(std::string_view& line) {
+        constexpr std::string_view whitespace = " \t\r";
+        auto begin = line.find_first_not_of(whitespace);
+        if(begin == std::string_view::npos) {
+            line = {};
+            return {};
+        }
+        auto end = line.find_first_of(whitespace, begin);
+        auto token = line.substr(begin, end - begin);
+        line = (end == std::string_view::npos ? std::string_view() : line.substr(end));
+        return token;
+    }
 
-MeshMap DFISEParser::read_meshes(const std::string& file_name) {
-    std::ifstream file(file_name);
-    if(!file) {
-        throw std::runtime_error("file cannot be accessed");
+    /**
+     * @brief Convert the next token of a line to a number
+     * @param line Remainder of the line, the token is removed from it
+     * @param value Value of the token
+     * @return True if a token was available, false otherwise
+     */
+    template <typename T> bool next_value(std::string_view& line, T& value) {
+        auto token = next_token(line);
+        if(token.empty()) {
+            return false;
+        }
+        value = LineTokenizer::parse<T>(token);
+        return true;
+    }
+
+    /**
+     * @brief Parse a line opening a section, either as "<name> {" or as "<name> (<data>) {"
+     * @param line Trimmed line
+     * @param name Name of the section
+     * @param data Data given for the section, empty for sections without data
+     * @return True if the line opens a section, false otherwise
+     */
+    bool parse_section(std::string_view line, std::string_view& name, std::string_view& data) {
+        size_t name_end = 0;
+        while(name_end < line.size() && std::isalpha(static_cast<unsigned char>(line[name_end])) != 0) {
+            ++name_end;
+        }
+        if(name_end == 0) {
+            return false;
+        }
+        name = line.substr(0, name_end);
+        auto rest = LineTokenizer::trim(line.substr(name_end));
+        if(rest == "{") {
+            data = {};
+            return true;
+        }
+        if(rest.empty() || rest.front() != '(') {
+            return false;
+        }
+        auto close = rest.find(')');
+        if(close == std::string_view::npos || LineTokenizer::trim(rest.substr(close + 1)) != "{") {
+            return false;
+        }
+        data = rest.substr(1, close - 1);
+        return !data.empty() && data.find_first_of(" \t") == std::string_view::npos;
+    }
+
+    /**
+     * @brief Parse a line with a key and a value separated by an equal sign
+     * @param line Trimmed line
+     * @param key Key of the line
+     * @param value Trimmed value of the line
+     * @return True if the line holds a key consisting of letters and a value, false otherwise
+     */
+    bool parse_key_value(std::string_view line, std::string_view& key, std::string_view& value) {
+        auto separator = line.find('=');
+        key = LineTokenizer::trim(line.substr(0, separator));
+        value = LineTokenizer::trim(line.substr(separator + 1));
+        if(key.empty() || value.empty()) {
+            return false;
+        }
+        return std::all_of(key.begin(), key.end(), [](char c) { return std::isalpha(static_cast<unsigned char>(c)) != 0; });
+    }
+
+    /**
+     * @brief Parse the validity of a dataset, only accepting datasets valid for a single region as "[ "<region>" ]"
+     * @param value Trimmed value of the validity
+     * @param region Name of the region
+     * @return True if the dataset is valid for a single region, false otherwise
+     */
+    bool parse_validity(std::string_view value, std::string_view& region) {
+        if(value.size() < 2 || value.front() != '[' || value.back() != ']') {
+            return false;
+        }
+        auto quoted = LineTokenizer::trim(value.substr(1, value.size() - 2));
+        if(quoted.size() < 3 || quoted.front() != '"' || quoted.back() != '"') {
+            return false;
+        }
+        region = quoted.substr(1, quoted.size() - 2);
+        return std::all_of(region.begin(), region.end(), [](char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) != 0 || c == '_' || c == '-' || c == '.';
+        });
     }
 
-    // Get the total number of lines to parse and reset file to the start:
-    auto num_lines = std::count(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>(), '\n');
-    file.clear();
-    file.seekg(0, std::ios::beg);
-    LOG(DEBUG) << "Grid file contains " << num_lines << " lines to parse";
+    /**
+     * @brief Open a file for reading line by line
+     * @param file_name Path of the file
+     * @param file File stream to open
+     * @return Size of the file in bytes, used to report the progress
+     */
+    uint64_t open_file(const std::string& file_name, std::ifstream& file) {
+        file.open(file_name, std::ios::binary);
+        if(!file) {
+            throw std::runtime_error("file cannot be accessed");
+        }
+        return std::filesystem::file_size(file_name);
+    }
+} // namespace
+
+/**
+ * The file is read in blocks and parsed in place, only the vertices and the connectivity of the mesh are kept in memory.
+ */
+MeshMap DFISEParser::read_meshes(const std::string& file_name) {
+    std::ifstream file;
+    auto file_size = open_file(file_name, file);
+    allpix::BufferedLineReader reader(file);
+    LOG(DEBUG) << "Grid file contains " << file_size << " bytes to parse";
 
     DFSection main_section = DFSection::HEADER;
     DFSection sub_section = DFSection::NONE;
@@ -45,29 +165,31 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
     long unsigned int data_count = 0;
     bool in_data_block = false;
     long long num_lines_parsed = 0;
-    while(!file.eof()) {
-        std::string line;
-        std::getline(file, line);
+    std::string_view line;
+    bool more_lines = true;
+    while(more_lines) {
+        more_lines = reader.getline(line);
 
         // Log the parsing progress:
-        if(num_lines > 0 && num_lines_parsed % 1000 == 0) {
-            LOG_PROGRESS(INFO, "gridlines") << "Parsing grid file: " << (100 * num_lines_parsed / num_lines) << "%";
+        if(file_size > 0 && num_lines_parsed % 1000 == 0) {
+            LOG_PROGRESS(INFO, "gridlines") << "Parsing grid file: " << (100 * reader.tell() / file_size) << "%";
         }
         num_lines_parsed++;
 
-        line = allpix::trim(line);
+        line = LineTokenizer::trim(line);
         if(line.empty()) {
             continue;
         }
 
         // Check if line with begin of section
-        if(line.find('{') != std::string::npos) {
-            // Search for new simple headers
-            auto base_regex = std::regex("([a-zA-Z]+) \\{");
-            std::smatch base_match;
-            if(std::regex_match(line, base_match, base_regex) && base_match.ready()) {
-                auto header_string = base_match[1].str();
+        if(line.find('{') != std::string_view::npos) {
+            std::string_view header_string, header_data;
+            if(!parse_section(line, header_string, header_data)) {
+                continue;
+            }
 
+            // Search for new simple headers
+            if(header_data.empty()) {
                 if(header_string == "Info") {
                     main_section = DFSection::INFO;
                 } else if(header_string == "Data") {
@@ -82,30 +204,30 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
             }
 
             // Search for headers with data
-            base_regex = std::regex("([a-zA-Z]+) \\((\\S+)\\) \\{");
-            if(std::regex_match(line, base_match, base_regex) && base_match.ready()) {
-                auto header_string = base_match[1].str();
-                auto header_data = base_match[2].str();
-
+            else {
                 if(header_string == "Region") {
                     main_section = DFSection::REGION;
-                    region = header_data.substr(1, header_data.size() - 2);
+                    region = std::string(header_data.substr(1, header_data.size() - 2));
                 } else if(header_string == "Vertices") {
                     main_section = DFSection::VERTICES;
-                    data_count = std::stoul(header_data);
+                    data_count = LineTokenizer::parse<long unsigned int>(header_data);
+                    vertices.reserve(data_count);
                 } else if(header_string == "Edges") {
                     main_section = DFSection::EDGES;
-                    data_count = std::stoul(header_data);
+                    data_count = LineTokenizer::parse<long unsigned int>(header_data);
+                    edges.reserve(data_count);
                 } else if(header_string == "Faces") {
                     main_section = DFSection::FACES;
-                    data_count = std::stoul(header_data);
+                    data_count = LineTokenizer::parse<long unsigned int>(header_data);
+                    faces.reserve(data_count);
                 } else if(header_string == "Elements") {
                     if(main_section == DFSection::REGION) {
                         sub_section = DFSection::ELEMENTS;
                     } else {
                         main_section = DFSection::ELEMENTS;
+                        elements.reserve(LineTokenizer::parse<long unsigned int>(header_data));
                     }
-                    data_count = std::stoul(header_data);
+                    data_count = LineTokenizer::parse<long unsigned int>(header_data);
                 } else {
                     if(main_section != DFSection::NONE) {
                         sub_section = DFSection::IGNORED;
@@ -119,7 +241,7 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
         }
 
         // Look for close of section
-        if(line.find('}') != std::string::npos) {
+        if(line.find('}') != std::string_view::npos) {
             switch(main_section) {
             case DFSection::VERTICES:
                 if(vertices.size() != data_count) {
@@ -160,28 +282,24 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
         }
 
         // Look for key data pairs
-        if(line.find('=') != std::string::npos) {
-            auto base_regex = std::regex("([a-zA-Z]+)\\s+=\\s+([\\S ]+)");
-            std::smatch base_match;
-            if(std::regex_match(line, base_match, base_regex) && base_match.ready()) {
-                auto key = base_match[1].str();
-                auto value = allpix::trim(base_match[2].str());
-
+        if(line.find('=') != std::string_view::npos) {
+            std::string_view key, value;
+            if(parse_key_value(line, key, value)) {
                 // Filter correct electric field type
-                if(main_section == DFSection::INFO) {
-                    if(key == "dimension" && (std::stoul(value) != 3 && std::stoul(value) != 2)) {
+                if(main_section == DFSection::INFO && key == "dimension") {
+                    auto value_dimension = LineTokenizer::parse<long unsigned int>(value);
+                    if(value_dimension == 3 || value_dimension == 2) {
+                        dimension = value_dimension;
+                    } else {
                         main_section = DFSection::IGNORED;
                     }
-                    if(key == "dimension" && (std::stoul(value) == 3 || std::stoul(value) == 2)) {
-                        dimension = std::stoul(value);
-                    }
                 }
             }
             continue;
         }
 
         // Handle data
-        std::stringstream sstr(line);
+        auto sstr = line;
         switch(main_section) {
         case DFSection::HEADER:
             if(line != "DF-ISE text") {
@@ -195,7 +313,7 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
                 point.x = -1.0;
                 point.y = -1.0;
                 point.z = -1.0;
-                while(sstr >> point.x >> point.y >> point.z) {
+                while(next_value(sstr, point.x) && next_value(sstr, point.y) && next_value(sstr, point.z)) {
                     vertices.push_back(point);
                 }
             }
@@ -203,7 +321,7 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
                 point.x = -1.0;
                 point.y = -1.0;
                 point.z = -1.0;
-                while(sstr >> point.y >> point.z) {
+                while(next_value(sstr, point.y) && next_value(sstr, point.z)) {
                     vertices.push_back(point);
                 }
             }
@@ -211,7 +329,7 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
         case DFSection::EDGES: {
             // Read edges
             std::pair<long unsigned int, long unsigned int> edge;
-            while(sstr >> edge.first >> edge.second) {
+            while(next_value(sstr, edge.first) && next_value(sstr, edge.second)) {
                 if(edge.first >= vertices.size() || edge.second >= vertices.size()) {
                     throw std::runtime_error("vertex index is higher than number of vertices");
                 }
@@ -221,11 +339,11 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
         case DFSection::FACES: {
             // Get vertex indices for every face
             size_t n = 0;
-            sstr >> n;
+            next_value(sstr, n);
             std::vector<long unsigned int> face;
             for(size_t i = 0; i < n; ++i) {
                 long edge_idx = 0;
-                sstr >> edge_idx;
+                next_value(sstr, edge_idx);
 
                 bool swap = false;
                 if(edge_idx < 0) {
@@ -264,7 +382,7 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
         } break;
         case DFSection::ELEMENTS: {
             int k = 0;
-            sstr >> k;
+            next_value(sstr, k);
             std::vector<long unsigned int> element;
 
             size_t size = 0;
@@ -299,7 +417,7 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
 
             for(size_t i = 0; i < size; ++i) {
                 long element_idx = 0;
-                sstr >> element_idx;
+                next_value(sstr, element_idx);
 
                 bool reverse = false;
                 if(element_idx < 0) {
@@ -338,7 +456,7 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
                 continue;
             }
             long unsigned int elem_idx = 0;
-            while(sstr >> elem_idx) {
+            while(next_value(sstr, elem_idx)) {
                 if(elem_idx >= elements.size()) {
                     throw std::runtime_error("element index is higher than number of elements");
                 }
@@ -374,17 +492,15 @@ MeshMap DFISEParser::read_meshes(const std::string& file_name) {
     return ret_map;
 }
 
-FieldMap DFISEParser::read_fields(const std::string& file_name) {
-    std::ifstream file(file_name);
-    if(!file) {
-        throw std::runtime_error("file cannot be accessed");
-    }
-
-    // Get the total number of lines to parse and reset file to the start:
-    auto num_lines = std::count(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>(), '\n');
-    file.clear();
-    file.seekg(0, std::ios::beg);
-    LOG(DEBUG) << "Field data file contains " << num_lines << " lines to parse";
+/**
+ * Datasets of other observables are skipped while reading, such that only the values of the requested observables are kept
+ * in memory.
+ */
+FieldMap DFISEParser::read_fields(const std::string& file_name, const std::vector<std::string>& selected_observables) {
+    std::ifstream file;
+    auto file_size = open_file(file_name, file);
+    allpix::BufferedLineReader reader(file);
+    LOG(DEBUG) << "Field data file contains " << file_size << " bytes to parse";
 
     DFSection main_section = DFSection::HEADER;
     DFSection sub_section = DFSection::NONE;
@@ -399,14 +515,15 @@ FieldMap DFISEParser::read_fields(const std::string& file_name) {
     long unsigned int data_count = 0;
     bool in_data_block = false;
     long long num_lines_parsed = 0;
-    while(!file.eof()) {
-        std::string line;
-        std::getline(file, line);
-        line = allpix::trim(line);
+    std::string_view line;
+    bool more_lines = true;
+    while(more_lines) {
+        more_lines = reader.getline(line);
+        line = LineTokenizer::trim(line);
 
         // Log the parsing progress:
-        if(num_lines > 0 && num_lines_parsed % 1000 == 0) {
-            LOG_PROGRESS(INFO, "fieldlines") << "Parsing field data file: " << (100 * num_lines_parsed / num_lines) << "%";
+        if(file_size > 0 && num_lines_parsed % 1000 == 0) {
+            LOG_PROGRESS(INFO, "fieldlines") << "Parsing field data file: " << (100 * reader.tell() / file_size) << "%";
         }
         num_lines_parsed++;
 
@@ -415,12 +532,14 @@ FieldMap DFISEParser::read_fields(const std::string& file_name) {
         }
 
         // Check if line with begin of section
-        if(line.find('{') != std::string::npos) {
+        if(line.find('{') != std::string_view::npos) {
+            std::string_view header_string, header_data;
+            if(!parse_section(line, header_string, header_data)) {
+                continue;
+            }
+
             // Search for new simple headers
-            auto base_regex = std::regex("([a-zA-Z]+) \\{");
-            std::smatch base_match;
-            if(std::regex_match(line, base_match, base_regex) && base_match.ready()) {
-                auto header_string = base_match[1].str();
+            if(header_data.empty()) {
                 LOG(TRACE) << "Opening section " << header_string;
 
                 if(header_string == "Info") {
@@ -437,16 +556,15 @@ FieldMap DFISEParser::read_fields(const std::string& file_name) {
             }
 
             // Search for headers with data
-            base_regex = std::regex("([a-zA-Z]+) \\((\\S+)\\) \\{");
-            if(std::regex_match(line, base_match, base_regex) && base_match.ready()) {
-                auto header_string = base_match[1].str();
-                auto header_data = base_match[2].str();
-
+            else {
                 if(header_string == "Dataset") {
-                    std::string data_type = header_data.substr(1, header_data.size() - 2);
+                    auto data_type = header_data.substr(1, header_data.size() - 2);
                     LOG(DEBUG) << "Opening dataset of type " << data_type;
 
-                    if(data_type == "ElectricField") {
+                    if(std::find(selected_observables.begin(), selected_observables.end(), data_type) ==
+                       selected_observables.end()) {
+                        main_section = DFSection::IGNORED;
+                    } else if(data_type == "ElectricField") {
                         main_section = DFSection::ELECTRIC_FIELD;
                     } else if(data_type == "ElectrostaticPotential") {
                         main_section = DFSection::ELECTROSTATIC_POTENTIAL;
@@ -462,7 +580,10 @@ FieldMap DFISEParser::read_fields(const std::string& file_name) {
                 } else if(header_string == "Values") {
                     LOG(DEBUG) << "Opening value section with " << header_data << " entries";
                     sub_section = DFSection::VALUES;
-                    data_count = std::stoul(header_data);
+                    data_count = LineTokenizer::parse<long unsigned int>(header_data);
+                    if(main_section != DFSection::IGNORED) {
+                        region_electric_field_num.reserve(data_count);
+                    }
                 } else {
                     if(main_section != DFSection::NONE) {
                         sub_section = DFSection::IGNORED;
@@ -476,19 +597,14 @@ FieldMap DFISEParser::read_fields(const std::string& file_name) {
         }
 
         // Look for key data pairs
-        if(line.find('=') != std::string::npos) {
-            auto base_regex = std::regex("([a-zA-Z]+)\\s+=\\s+([\\S ]+)");
-            std::smatch base_match;
-            if(std::regex_match(line, base_match, base_regex) && base_match.ready()) {
-                auto key = base_match[1].str();
-                auto value = allpix::trim(base_match[2].str());
-
-                // Regular expression for matching validity region:
-                base_regex = std::regex("\\[\\s+\"([-\\w\\.]+)\"\\s+\\]");
+        if(line.find('=') != std::string_view::npos) {
+            std::string_view key, value;
+            if(parse_key_value(line, key, value)) {
                 if(key == "validity") {
                     // Ignore any electric field valid for multiple regions
-                    if(std::regex_match(value, base_match, base_regex) && base_match.ready()) {
-                        region = base_match[1].str();
+                    std::string_view validity_region;
+                    if(parse_validity(value, validity_region)) {
+                        region = std::string(validity_region);
                     } else {
                         LOG(INFO) << "Could not determine validity region for string \"" << value << "\", ignoring.";
                         main_section = DFSection::IGNORED;
@@ -506,11 +622,13 @@ FieldMap DFISEParser::read_fields(const std::string& file_name) {
                     if(key == "type" && value != "vector") {
                         main_section = DFSection::IGNORED;
                     }
-                    if(key == "dimension" && (std::stoul(value) == 3 || std::stoul(value) == 2)) {
-                        dimension = std::stoul(value);
-                    }
-                    if(key == "dimension" && (std::stoul(value) != 3 && std::stoul(value) != 2)) {
-                        main_section = DFSection::IGNORED;
+                    if(key == "dimension") {
+                        auto value_dimension = LineTokenizer::parse<long unsigned int>(value);
+                        if(value_dimension == 3 || value_dimension == 2) {
+                            dimension = value_dimension;
+                        } else {
+                            main_section = DFSection::IGNORED;
+                        }
                     }
                 }
 
@@ -520,11 +638,12 @@ FieldMap DFISEParser::read_fields(const std::string& file_name) {
                     if(key == "type" && value != "scalar") {
                         main_section = DFSection::IGNORED;
                     }
-                    if(key == "dimension" && std::stoul(value) == 1) {
-                        dimension = std::stoul(value);
-                    }
-                    if(key == "dimension" && std::stoul(value) != 1) {
-                        main_section = DFSection::IGNORED;
+                    if(key == "dimension") {
+                        if(LineTokenizer::parse<long unsigned int>(value) == 1) {
+                            dimension = 1;
+                        } else {
+                            main_section = DFSection::IGNORED;
+                        }
                     }
                 }
                 // Filter correct electric field type
@@ -533,11 +652,12 @@ FieldMap DFISEParser::read_fields(const std::string& file_name) {
                     if(key == "type" && value != "scalar") {
                         main_section = DFSection::IGNORED;
                     }
-                    if(key == "dimension" && std::stoul(value) == 1) {
-                        dimension = std::stoul(value);
-                    }
-                    if(key == "dimension" && std::stoul(value) != 1) {
-                        main_section = DFSection::IGNORED;
+                    if(key == "dimension") {
+                        if(LineTokenizer::parse<long unsigned int>(value) == 1) {
+                            dimension = 1;
+                        } else {
+                            main_section = DFSection::IGNORED;
+                        }
                     }
                 }
 
@@ -547,11 +667,12 @@ FieldMap DFISEParser::read_fields(const std::string& file_name) {
                     if(key == "type" && value != "scalar") {
                         main_section = DFSection::IGNORED;
                     }
-                    if(key == "dimension" && std::stoul(value) == 1) {
-                        dimension = std::stoul(value);
-                    }
-                    if(key == "dimension" && std::stoul(value) != 1) {
-                        main_section = DFSection::IGNORED;
+                    if(key == "dimension") {
+                        if(LineTokenizer::parse<long unsigned int>(value) == 1) {
+                            dimension = 1;
+                        } else {
+                            main_section = DFSection::IGNORED;
+                        }
                     }
                 }
 
@@ -561,11 +682,12 @@ FieldMap DFISEParser::read_fields(const std::string& file_name) {
                     if(key == "type" && value != "scalar") {
                         main_section = DFSection::IGNORED;
                     }
-                    if(key == "dimension" && std::stoul(value) == 1) {
-                        dimension = std::stoul(value);
-                    }
-                    if(key == "dimension" && std::stoul(value) != 1) {
-                        main_section = DFSection::IGNORED;
+                    if(key == "dimension") {
+                        if(LineTokenizer::parse<long unsigned int>(value) == 1) {
+                            dimension = 1;
+                        } else {
+                            main_section = DFSection::IGNORED;
+                        }
                     }
                 }
             }
@@ -573,7 +695,7 @@ FieldMap DFISEParser::read_fields(const std::string& file_name) {
         }
 
         // Look for close of section
-        if(line.find('}') != std::string::npos) {
+        if(line.find('}') != std::string_view::npos) {
 
             if(main_section == DFSection::ELECTROSTATIC_POTENTIAL && sub_section == DFSection::VALUES) {
                 if(data_count != region_electric_field_num.size()) {
@@ -671,9 +793,9 @@ FieldMap DFISEParser::read_fields(const std::string& file_name) {
             main_section == DFSection::DOPING_CONCENTRATION || main_section == DFSection::DONOR_CONCENTRATION ||
             main_section == DFSection::ACCEPTOR_CONCENTRATION) &&
            sub_section == DFSection::VALUES) {
-            std::stringstream sstr(line);
+            auto sstr = line;
             double num = NAN;
-            while(sstr >> num) {
+            while(next_value(sstr, num)) {
                 region_electric_field_num.push_back(num);
             }
         }
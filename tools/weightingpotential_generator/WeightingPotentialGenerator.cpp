@@ -65,6 +65,8 @@ int main(int argc, char** argv) {
                 print_help = true;
             } else if(strcmp(argv[i], "--init") == 0) {
                 file_type = allpix::FileType::INIT;
+            } else if(strcmp(argv[i], "--raw") == 0) {
+                file_type = allpix::FileType::APF_RAW;
             } else if(strcmp(argv[i], "--binning") == 0 && (i + 1 < argc)) {
                 binning = allpix::from_string<XYZVectorInt>(std::string(argv[++i]));
             } else if(strcmp(argv[i], "--matrix") == 0 && (i + 1 < argc)) {
@@ -107,6 +109,8 @@ int main(int argc, char** argv) {
             std::cout
                 << "\t --init                  Switch to enable writing the potential in the INIT format instead of APF"
                 << std::endl;
+            std::cout << "\t --raw                   Switch to enable writing APF files with a raw payload which can be mapped"
+                      << std::endl;
             std::cout << "\t -v <level>              verbosity level (default reporiting level is INFO)" << std::endl;
             std::cout << "\t -h                      print this help text" << std::endl;
 
@@ -153,8 +157,18 @@ int main(int argc, char** argv) {
         auto num_threads = std::max(std::thread::hardware_concurrency(), 1u);
         ThreadPool::registerThreadCount(num_threads);
         LOG(STATUS) << "Starting weighting potential generation with " << num_threads << " threads.";
-        auto weighting_potential = std::make_shared<std::vector<double>>();
+        auto weighting_potential = std::make_shared<std::vector<double>>(binning.x() * binning.y() * binning.z());
+
+        // Potential is evaluated at the bin centers, which are placed symmetrically around the pixel center
+        auto bin_center = [&](size_t index, size_t bins, double extent) {
+            return extent / static_cast<double>(bins) * (static_cast<double>(index) + 0.5) - extent / 2;
+        };
+        auto field_index = [&](size_t index_x, size_t index_y, size_t index_z) {
+            return (index_x * binning.y() + index_y) * binning.z() + index_z;
+        };
 
+        // The pad potential is symmetric in x and y, every task calculates a slice in x for half of the y range and fills
+        // the mirrored slices in x and y as well. The tasks write to disjoint slices of the field.
         auto generate_section = [&](size_t index_x) {
             allpix::Log::setReportingLevel(log_level);
 
@@ -189,17 +203,21 @@ int main(int argc, char** argv) {
                 return (1 / (2 * M_PI) * (f(pos.x(), pos.y(), local_z) - sum));
             };
 
-            std::vector<double> slice;
-            for(size_t index_y = 1; index_y <= binning.y(); index_y++) {
-                for(size_t index_z = 1; index_z <= binning.z(); index_z++) {
-                    auto pos = ROOT::Math::XYZPoint(
-                        fieldsize.x() / static_cast<double>(binning.x()) * static_cast<double>(index_x) - fieldsize.x() / 2,
-                        fieldsize.y() / static_cast<double>(binning.y()) * static_cast<double>(index_y) - fieldsize.y() / 2,
-                        fieldsize.z() / static_cast<double>(binning.z()) * static_cast<double>(index_z) - fieldsize.z() / 2);
-                    slice.push_back(potential(pos));
+            auto& field = *weighting_potential;
+            auto mirror_x = binning.x() - 1 - index_x;
+            for(size_t index_y = 0; index_y < (binning.y() + 1) / 2; index_y++) {
+                auto mirror_y = binning.y() - 1 - index_y;
+                for(size_t index_z = 0; index_z < binning.z(); index_z++) {
+                    auto pos = ROOT::Math::XYZPoint(bin_center(index_x, binning.x(), fieldsize.x()),
+                                                    bin_center(index_y, binning.y(), fieldsize.y()),
+                                                    bin_center(index_z, binning.z(), fieldsize.z()));
+                    auto value = potential(pos);
+                    field[field_index(index_x, index_y, index_z)] = value;
+                    field[field_index(mirror_x, index_y, index_z)] = value;
+                    field[field_index(index_x, mirror_y, index_z)] = value;
+                    field[field_index(mirror_x, mirror_y, index_z)] = value;
                 }
             }
-            return slice;
         };
 
         // clang-format off
@@ -211,18 +229,17 @@ int main(int argc, char** argv) {
         };
 
         ThreadPool pool(num_threads, num_threads * 1024, init_function);
-        std::vector<std::shared_future<std::vector<double>>> wp_futures;
+        std::vector<std::shared_future<void>> wp_futures;
 
-        // Loop over x coordinate, add tasks for each coordinate to the queue
-        for(size_t x = 1; x <= binning.x(); x++) {
+        // Loop over the first half of the x coordinates, add tasks for each coordinate to the queue
+        for(size_t x = 0; x < (binning.x() + 1) / 2; x++) {
             wp_futures.push_back(pool.submit(generate_section, x));
         }
 
-        // Merge the result vectors:
+        // Wait for all slices to be calculated:
         unsigned int slices_done = 0;
         for(auto& wp_future : wp_futures) {
-            auto slice = wp_future.get();
-            weighting_potential->insert(weighting_potential->end(), slice.begin(), slice.end());
+            wp_future.get();
             LOG_PROGRESS(INFO, "generation") << "Generating potential: " << (100 * slices_done / wp_futures.size()) << "%";
             slices_done++;
         }